@@ -490,8 +490,15 @@ namespace
             / "schemas"
             / "project.xsd";
 
-        // Load the project from disk.
+        // Load the project from disk. Objects are created using the thread count given
+        // on the command line, since the project's configurations are not known yet.
         ProjectFileReader reader;
+        if (g_cl.m_threads.is_set())
+        {
+            ParamArray params;
+            params.insert("rendering_threads", g_cl.m_threads.value());
+            reader.set_thread_count(get_rendering_thread_count(params));
+        }
         return
             reader.read(
                 project_filepath.c_str(),
@@ -132,6 +132,99 @@ namespace
         return c_array_to_py_array(data.get(), tile->get_pixel_format(), tile->get_size());
     }
 
+    const char* python_buffer_format(PixelFormat format)
+    {
+        // Unlike the array module, the buffer protocol can describe half floats.
+        return format == PixelFormatHalf ? "e" : python_array_code(format);
+    }
+
+    //
+    // Buffer protocol support for tiles.
+    //
+    // Tiles export their pixels as a read-only (height, width, channel count) array, so that
+    // memoryview(tile) or numpy.asarray(tile) view the pixels without copying them. The view
+    // holds a reference to the tile, which keeps the pixels alive for as long as it exists.
+    //
+
+    int tile_get_buffer(PyObject* self, Py_buffer* view, int flags)
+    {
+        Tile* tile =
+            static_cast<Tile*>(
+                bpy::converter::get_lvalue_from_python(self, bpy::converter::registered<Tile>::converters));
+
+        if (tile == nullptr)
+        {
+            PyErr_SetString(PyExc_BufferError, "Failed to retrieve tile from Python object.");
+            view->obj = nullptr;
+            return -1;
+        }
+
+        if ((flags & PyBUF_F_CONTIGUOUS) == PyBUF_F_CONTIGUOUS)
+        {
+            PyErr_SetString(PyExc_BufferError, "Tile pixels are not Fortran-contiguous.");
+            view->obj = nullptr;
+            return -1;
+        }
+
+        // Fill a flat, read-only byte buffer; this fails if a writable buffer was requested.
+        if (PyBuffer_FillInfo(view, self, tile->get_storage(), tile->get_size(), 1, flags) != 0)
+            return -1;
+
+        // Describe the typed pixel array if the consumer understands formats.
+        if ((flags & PyBUF_FORMAT) == PyBUF_FORMAT)
+        {
+            const Py_ssize_t channel_size = static_cast<Py_ssize_t>(Pixel::size(tile->get_pixel_format()));
+            const Py_ssize_t channel_count = static_cast<Py_ssize_t>(tile->get_channel_count());
+            const Py_ssize_t width = static_cast<Py_ssize_t>(tile->get_width());
+
+            view->format = const_cast<char*>(python_buffer_format(tile->get_pixel_format()));
+            view->itemsize = channel_size;
+
+            if ((flags & PyBUF_ND) == PyBUF_ND)
+            {
+                // Shape and strides are stored in the buffer's internal field and freed on release.
+                Py_ssize_t* dims = new Py_ssize_t[6];
+                dims[0] = static_cast<Py_ssize_t>(tile->get_height());
+                dims[1] = width;
+                dims[2] = channel_count;
+                dims[3] = width * channel_count * channel_size;
+                dims[4] = channel_count * channel_size;
+                dims[5] = channel_size;
+
+                view->ndim = 3;
+                view->shape = dims;
+                view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? dims + 3 : nullptr;
+                view->internal = dims;
+            }
+        }
+
+        return 0;
+    }
+
+    void tile_release_buffer(PyObject*, Py_buffer* view)
+    {
+        delete[] static_cast<Py_ssize_t*>(view->internal);
+    }
+
+    void enable_tile_buffer_protocol(const bpy::object& tile_class)
+    {
+        static PyBufferProcs buffer_procs;
+        buffer_procs.bf_getbuffer = tile_get_buffer;
+        buffer_procs.bf_releasebuffer = tile_release_buffer;
+
+        PyTypeObject* type = reinterpret_cast<PyTypeObject*>(tile_class.ptr());
+        type->tp_as_buffer = &buffer_procs;
+#if PY_MAJOR_VERSION == 2
+        type->tp_flags |= Py_TPFLAGS_HAVE_NEWBUFFER;
+#endif
+        PyType_Modified(type);
+    }
+
+    bpy::object tile_get_pixels(const bpy::object& self)
+    {
+        return bpy::object(bpy::handle<>(PyMemoryView_FromObject(self.ptr())));
+    }
+
     std::string image_stack_get_name(const ImageStack* image_stack, const size_t index)
     {
         return image_stack->get_name(index);
@@ -167,16 +260,20 @@ void bind_image()
         .def("get_tile_width", &CanvasProperties::get_tile_width)
         .def("get_tile_height", &CanvasProperties::get_tile_height);
 
-    bpy::class_<Tile, boost::noncopyable>("Tile", bpy::init<size_t, size_t, size_t, PixelFormat>())
-        .def("__copy__", copy_tile, bpy::return_value_policy<bpy::manage_new_object>())
-        .def("__deepcopy__", deepcopy_tile, bpy::return_value_policy<bpy::manage_new_object>())
-        .def("get_pixel_format", &Tile::get_pixel_format)
-        .def("get_width", &Tile::get_width)
-        .def("get_height", &Tile::get_height)
-        .def("get_channel_count", &Tile::get_channel_count)
-        .def("get_pixel_count", &Tile::get_pixel_count)
-        .def("get_size", &Tile::get_size)
-        .def("get_storage", tile_get_storage);
+    bpy::object tile_class =
+        bpy::class_<Tile, boost::noncopyable>("Tile", bpy::init<size_t, size_t, size_t, PixelFormat>())
+            .def("__copy__", copy_tile, bpy::return_value_policy<bpy::manage_new_object>())
+            .def("__deepcopy__", deepcopy_tile, bpy::return_value_policy<bpy::manage_new_object>())
+            .def("get_pixel_format", &Tile::get_pixel_format)
+            .def("get_width", &Tile::get_width)
+            .def("get_height", &Tile::get_height)
+            .def("get_channel_count", &Tile::get_channel_count)
+            .def("get_pixel_count", &Tile::get_pixel_count)
+            .def("get_size", &Tile::get_size)
+            .def("get_storage", tile_get_storage)
+            .def("get_pixels", tile_get_pixels);
+
+    enable_tile_buffer_protocol(tile_class);
 
     const Tile& (Image::*image_get_tile)(const size_t, const size_t) const = &Image::tile;
 
@@ -184,7 +281,7 @@ void bind_image()
         .def("__copy__", copy_image, bpy::return_value_policy<bpy::manage_new_object>())
         .def("__deepcopy__", copy_image, bpy::return_value_policy<bpy::manage_new_object>())
         .def("properties", &Image::properties, bpy::return_value_policy<bpy::reference_existing_object>())
-        .def("tile", image_get_tile, bpy::return_value_policy<bpy::reference_existing_object>());
+        .def("tile", image_get_tile, bpy::return_internal_reference<>());
 
     const Image& (ImageStack::*image_stack_get_image)(const size_t) const = &ImageStack::get_image;
 
@@ -192,5 +289,5 @@ void bind_image()
         .def("empty", &ImageStack::empty)
         .def("size", &ImageStack::size)
         .def("get_name", image_stack_get_name)
-        .def("get_image", image_stack_get_image, bpy::return_value_policy<bpy::reference_existing_object>());
+        .def("get_image", image_stack_get_image, bpy::return_internal_reference<>());
 }
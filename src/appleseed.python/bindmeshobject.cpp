@@ -30,18 +30,23 @@
 // appleseed.python headers.
 #include "bindentitycontainers.h"
 #include "dict2dict.h"
+#include "gillocks.h"
 
 // appleseed.renderer headers.
 #include "renderer/api/object.h"
 
 // appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
 #include "foundation/platform/python.h"
 #include "foundation/utility/murmurhash.h"
 #include "foundation/utility/searchpaths.h"
 
 // Standard headers.
 #include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <string>
+#include <vector>
 
 namespace bpy = boost::python;
 using namespace foundation;
@@ -68,6 +73,355 @@ namespace
         object->get_triangle(index) = triangle;
     }
 
+    //
+    // Bulk setters.
+    //
+    // These accept any object implementing the buffer protocol (NumPy arrays, array.array,
+    // memoryviews, etc.) and copy its contents into the mesh in a single C++ loop, without
+    // any per-element Python call. Buffers must be C-contiguous and use a native scalar
+    // format; their shape is ignored, only the number of elements matters.
+    //
+
+    // Acquire a read-only, C-contiguous view of a Python buffer for the lifetime of this object.
+    class BufferView
+      : public NonCopyable
+    {
+      public:
+        BufferView(const bpy::object& obj, const char* name)
+          : m_name(name)
+        {
+            if (PyObject_GetBuffer(obj.ptr(), &m_view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) != 0)
+                bpy::throw_error_already_set();
+        }
+
+        ~BufferView()
+        {
+            PyBuffer_Release(&m_view);
+        }
+
+        const char* get_name() const
+        {
+            return m_name;
+        }
+
+        const void* get_data() const
+        {
+            return m_view.buf;
+        }
+
+        size_t get_item_size() const
+        {
+            return static_cast<size_t>(m_view.itemsize);
+        }
+
+        size_t get_item_count() const
+        {
+            return static_cast<size_t>(m_view.len / m_view.itemsize);
+        }
+
+        // Return the struct-style format character of the buffer's items, or 0 if the
+        // format is not a single scalar in native byte order.
+        char get_format() const
+        {
+            const char* format = m_view.format != nullptr ? m_view.format : "B";
+
+            if (*format == '@' || *format == '=')
+                ++format;
+
+            return format[0] != '\0' && format[1] == '\0' ? format[0] : 0;
+        }
+
+      private:
+        const char*     m_name;
+        Py_buffer       m_view;
+    };
+
+    void raise_format_error(const BufferView& view, const char* expected)
+    {
+        const std::string message =
+            std::string("Unsupported buffer format for ") + view.get_name() + ", expected " + expected + ".";
+        PyErr_SetString(PyExc_TypeError, message.c_str());
+        bpy::throw_error_already_set();
+    }
+
+    void check_item_count(const BufferView& view, const size_t multiple)
+    {
+        if (view.get_item_count() % multiple != 0)
+        {
+            const std::string message =
+                std::string("The number of elements in ") + view.get_name() +
+                " must be a multiple of " + std::to_string(multiple) + ".";
+            PyErr_SetString(PyExc_ValueError, message.c_str());
+            bpy::throw_error_already_set();
+        }
+    }
+
+    // Invoke visitor(values, count) with the buffer's items reinterpreted as floating-point numbers.
+    template <typename Visitor>
+    void visit_float_buffer(const BufferView& view, Visitor& visitor)
+    {
+        const char format = view.get_format();
+
+        if (format == 'f' && view.get_item_size() == sizeof(float))
+            visitor(static_cast<const float*>(view.get_data()), view.get_item_count());
+        else if (format == 'd' && view.get_item_size() == sizeof(double))
+            visitor(static_cast<const double*>(view.get_data()), view.get_item_count());
+        else raise_format_error(view, "32-bit or 64-bit floats");
+    }
+
+    // Invoke visitor(values, count) with the buffer's items reinterpreted as signed or unsigned integers.
+    template <typename Visitor>
+    void visit_integer_buffer(const BufferView& view, Visitor& visitor)
+    {
+        const void* data = view.get_data();
+        const size_t count = view.get_item_count();
+
+        switch (view.get_format())
+        {
+          case 'b': case 'h': case 'i': case 'l': case 'q': case 'n':
+            switch (view.get_item_size())
+            {
+              case 1: visitor(static_cast<const std::int8_t*>(data), count); return;
+              case 2: visitor(static_cast<const std::int16_t*>(data), count); return;
+              case 4: visitor(static_cast<const std::int32_t*>(data), count); return;
+              case 8: visitor(static_cast<const std::int64_t*>(data), count); return;
+            }
+            break;
+
+          case 'B': case 'H': case 'I': case 'L': case 'Q': case 'N':
+            switch (view.get_item_size())
+            {
+              case 1: visitor(static_cast<const std::uint8_t*>(data), count); return;
+              case 2: visitor(static_cast<const std::uint16_t*>(data), count); return;
+              case 4: visitor(static_cast<const std::uint32_t*>(data), count); return;
+              case 8: visitor(static_cast<const std::uint64_t*>(data), count); return;
+            }
+            break;
+        }
+
+        raise_format_error(view, "integers");
+    }
+
+    struct PushVertices
+    {
+        MeshObject* m_object;
+
+        template <typename T>
+        void operator()(const T* values, const size_t count)
+        {
+            // Unlock Python's global interpreter lock (GIL) while we copy the buffer.
+            ScopedGILUnlock unlock;
+
+            m_object->clear_vertices();
+            m_object->reserve_vertices(count / 3);
+
+            for (size_t i = 0; i < count; i += 3)
+            {
+                m_object->push_vertex(
+                    GVector3(
+                        static_cast<GScalar>(values[i + 0]),
+                        static_cast<GScalar>(values[i + 1]),
+                        static_cast<GScalar>(values[i + 2])));
+            }
+        }
+    };
+
+    struct PushVertexNormals
+    {
+        MeshObject* m_object;
+
+        template <typename T>
+        void operator()(const T* values, const size_t count)
+        {
+            ScopedGILUnlock unlock;
+
+            m_object->clear_vertex_normals();
+            m_object->reserve_vertex_normals(count / 3);
+
+            for (size_t i = 0; i < count; i += 3)
+            {
+                m_object->push_vertex_normal(
+                    GVector3(
+                        static_cast<GScalar>(values[i + 0]),
+                        static_cast<GScalar>(values[i + 1]),
+                        static_cast<GScalar>(values[i + 2])));
+            }
+        }
+    };
+
+    struct PushTexCoords
+    {
+        MeshObject* m_object;
+
+        template <typename T>
+        void operator()(const T* values, const size_t count)
+        {
+            ScopedGILUnlock unlock;
+
+            m_object->clear_tex_coords();
+            m_object->reserve_tex_coords(count / 2);
+
+            for (size_t i = 0; i < count; i += 2)
+            {
+                m_object->push_tex_coords(
+                    GVector2(
+                        static_cast<GScalar>(values[i + 0]),
+                        static_cast<GScalar>(values[i + 1])));
+            }
+        }
+    };
+
+    // Copy an index buffer into a vector of 32-bit indices, rejecting negative indices.
+    struct ReadIndices
+    {
+        std::vector<std::uint32_t>* m_indices;
+        bool                        m_negative;
+        bool                        m_overflow;
+
+        template <typename T>
+        void operator()(const T* values, const size_t count)
+        {
+            ScopedGILUnlock unlock;
+
+            m_indices->resize(count);
+            m_negative = false;
+            m_overflow = false;
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (values[i] < T(0))
+                    m_negative = true;
+                else if (static_cast<std::uint64_t>(values[i]) > std::numeric_limits<std::uint32_t>::max())
+                    m_overflow = true;
+
+                (*m_indices)[i] = static_cast<std::uint32_t>(values[i]);
+            }
+        }
+    };
+
+    void read_indices(
+        const bpy::object&          obj,
+        const char*                 name,
+        std::vector<std::uint32_t>& indices)
+    {
+        const BufferView view(obj, name);
+
+        ReadIndices visitor = { &indices, false, false };
+        visit_integer_buffer(view, visitor);
+
+        if (visitor.m_negative)
+        {
+            const std::string message = std::string("Negative index found in ") + name + ".";
+            PyErr_SetString(PyExc_ValueError, message.c_str());
+            bpy::throw_error_already_set();
+        }
+
+        if (visitor.m_overflow)
+        {
+            const std::string message = std::string("Index exceeding 32 bits found in ") + name + ".";
+            PyErr_SetString(PyExc_OverflowError, message.c_str());
+            bpy::throw_error_already_set();
+        }
+    }
+
+    void read_optional_indices(
+        const bpy::object&          obj,
+        const char*                 name,
+        const size_t                expected_count,
+        std::vector<std::uint32_t>& indices)
+    {
+        if (obj.is_none())
+            return;
+
+        read_indices(obj, name, indices);
+
+        if (indices.size() != expected_count)
+        {
+            const std::string message =
+                std::string("Expected ") + std::to_string(expected_count) + " elements in " + name +
+                ", got " + std::to_string(indices.size()) + ".";
+            PyErr_SetString(PyExc_ValueError, message.c_str());
+            bpy::throw_error_already_set();
+        }
+    }
+
+    void set_vertices(MeshObject* object, const bpy::object& vertices)
+    {
+        const BufferView view(vertices, "vertices");
+        check_item_count(view, 3);
+
+        PushVertices visitor = { object };
+        visit_float_buffer(view, visitor);
+    }
+
+    void set_vertex_normals(MeshObject* object, const bpy::object& normals)
+    {
+        const BufferView view(normals, "normals");
+        check_item_count(view, 3);
+
+        PushVertexNormals visitor = { object };
+        visit_float_buffer(view, visitor);
+    }
+
+    void set_tex_coords(MeshObject* object, const bpy::object& tex_coords)
+    {
+        const BufferView view(tex_coords, "tex_coords");
+        check_item_count(view, 2);
+
+        PushTexCoords visitor = { object };
+        visit_float_buffer(view, visitor);
+    }
+
+    void set_triangles(
+        MeshObject*                 object,
+        const bpy::object&          vertex_indices,
+        const bpy::object&          normal_indices,
+        const bpy::object&          tex_coord_indices,
+        const bpy::object&          material_indices)
+    {
+        std::vector<std::uint32_t> v, n, a, pa;
+
+        read_indices(vertex_indices, "vertex_indices", v);
+
+        if (v.size() % 3 != 0)
+        {
+            PyErr_SetString(PyExc_ValueError, "The number of elements in vertex_indices must be a multiple of 3.");
+            bpy::throw_error_already_set();
+        }
+
+        const size_t triangle_count = v.size() / 3;
+
+        read_optional_indices(normal_indices, "normal_indices", v.size(), n);
+        read_optional_indices(tex_coord_indices, "tex_coord_indices", v.size(), a);
+        read_optional_indices(material_indices, "material_indices", triangle_count, pa);
+
+        ScopedGILUnlock unlock;
+
+        object->clear_triangles();
+        object->reserve_triangles(triangle_count);
+
+        for (size_t i = 0; i < triangle_count; ++i)
+        {
+            Triangle triangle(v[i * 3 + 0], v[i * 3 + 1], v[i * 3 + 2], pa.empty() ? 0 : pa[i]);
+
+            if (!n.empty())
+            {
+                triangle.m_n0 = n[i * 3 + 0];
+                triangle.m_n1 = n[i * 3 + 1];
+                triangle.m_n2 = n[i * 3 + 2];
+            }
+
+            if (!a.empty())
+            {
+                triangle.m_a0 = a[i * 3 + 0];
+                triangle.m_a1 = a[i * 3 + 1];
+                triangle.m_a2 = a[i * 3 + 2];
+            }
+
+            object->push_triangle(triangle);
+        }
+    }
+
     bpy::list read_mesh_objects(
         const bpy::list&      search_paths,
         const std::string&    base_object_name,
@@ -155,13 +509,15 @@ void bind_mesh_object()
 
         .def("reserve_vertices", &MeshObject::reserve_vertices)
         .def("push_vertex", &MeshObject::push_vertex)
+        .def("set_vertices", set_vertices)
         .def("get_vertex_count", &MeshObject::get_vertex_count)
         .def("get_vertex", &MeshObject::get_vertex, bpy::return_value_policy<bpy::reference_existing_object>())
 
         .def("reserve_vertex_normals", &MeshObject::reserve_vertex_normals)
         .def("push_vertex_normal", &MeshObject::push_vertex_normal)
+        .def("set_vertex_normals", set_vertex_normals)
         .def("get_vertex_normal_count", &MeshObject::get_vertex_normal_count)
-        .def("get_vertex_normal", &MeshObject::get_vertex_normal, bpy::return_value_policy<bpy::reference_existing_object>())
+        .def("get_vertex_normal", &MeshObject::get_vertex_normal)
 
         .def("reserve_vertex_tangents", &MeshObject::reserve_vertex_tangents)
         .def("push_vertex_tangent", &MeshObject::push_vertex_tangent)
@@ -170,6 +526,7 @@ void bind_mesh_object()
 
         .def("reserve_tex_coords", &MeshObject::reserve_tex_coords)
         .def("push_tex_coords", &MeshObject::push_tex_coords)
+        .def("set_tex_coords", set_tex_coords)
         .def("get_tex_coords_count", &MeshObject::get_tex_coords_count)
         .def("get_tex_coords", &MeshObject::get_tex_coords)
 
@@ -178,6 +535,13 @@ void bind_mesh_object()
         .def("get_triangle_count", &MeshObject::get_triangle_count)
         .def("get_triangle", get_triangle, bpy::return_value_policy<bpy::reference_existing_object>())
         .def("set_triangle", set_triangle)
+        .def(
+            "set_triangles",
+            set_triangles,
+            (bpy::arg("vertex_indices"),
+             bpy::arg("normal_indices") = bpy::object(),
+             bpy::arg("tex_coord_indices") = bpy::object(),
+             bpy::arg("material_indices") = bpy::object()))
 
         .def("set_motion_segment_count", &MeshObject::set_motion_segment_count)
         .def("get_motion_segment_count", &MeshObject::get_motion_segment_count)
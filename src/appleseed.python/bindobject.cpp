@@ -119,6 +119,11 @@ namespace
                 bpy::dict());
     }
 
+    void obj_inst_set_transform(ObjectInstance* obj, const UnalignedTransformd& transform)
+    {
+        obj->set_transform(transform.as_foundation_transform());
+    }
+
     UnalignedTransformd obj_inst_get_transform(const ObjectInstance* obj)
     {
         return UnalignedTransformd(obj->get_transform());
@@ -167,6 +172,7 @@ void bind_object()
         .def("__init__", bpy::make_constructor(create_obj_instance_with_back_mat))
         .def("get_object_name", &obj_inst_get_obj_name)
         .def("find_object", &ObjectInstance::find_object, bpy::return_value_policy<bpy::reference_existing_object>())
+        .def("set_transform", &obj_inst_set_transform)
         .def("get_transform", &obj_inst_get_transform)
         .def("bbox", &ObjectInstance::compute_parent_bbox)
         .def("get_front_material_mappings", &obj_inst_get_front_material_mappings)
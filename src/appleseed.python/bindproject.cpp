@@ -355,7 +355,9 @@ void bind_project()
     bpy::class_<ProjectFileReader>("ProjectFileReader")
         .def("read", &project_file_reader_read_default_opts)
         .def("read", &project_file_reader_read_with_opts)
-        .def("load_builtin", &project_file_reader_load_builtin);
+        .def("load_builtin", &project_file_reader_load_builtin)
+        .def("set_thread_count", &ProjectFileReader::set_thread_count)
+        .def("get_thread_count", &ProjectFileReader::get_thread_count);
 
     bpy::enum_<ProjectFileWriter::Options>("ProjectFileWriterOptions")
         .value("Defaults", ProjectFileWriter::Defaults)
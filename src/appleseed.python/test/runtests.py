@@ -29,6 +29,7 @@
 import unittest
 
 from testbasis import *
+from testbuffers import *
 from testdict2dict import *
 from testentitymap import *
 from testentityvector import *
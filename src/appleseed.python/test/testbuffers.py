@@ -0,0 +1,108 @@
+
+#
+# This source file is part of appleseed.
+# Visit https://appleseedhq.net/ for additional information and resources.
+#
+# This software is released under the MIT license.
+#
+# Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+#
+
+import array
+import unittest
+
+import appleseed as asr
+
+
+class TestMeshObjectBuffers(unittest.TestCase):
+    """
+    Bulk mesh construction from buffer-protocol objects.
+    """
+
+    def setUp(self):
+        self.mesh = asr.MeshObject("mesh", {})
+
+    def test_set_vertices(self):
+        self.mesh.set_vertices(array.array('f', [0.0, 1.0, 2.0, 3.0, 4.0, 5.0]))
+
+        self.assertEqual(self.mesh.get_vertex_count(), 2)
+        self.assertEqual(self.mesh.get_vertex(1)[2], 5.0)
+
+    def test_set_vertices_replaces_existing_vertices(self):
+        self.mesh.set_vertices(array.array('d', [0.0, 1.0, 2.0]))
+        self.mesh.set_vertices(array.array('d', [3.0, 4.0, 5.0]))
+
+        self.assertEqual(self.mesh.get_vertex_count(), 1)
+        self.assertEqual(self.mesh.get_vertex(0)[0], 3.0)
+
+    def test_set_tex_coords(self):
+        self.mesh.set_tex_coords(array.array('f', [0.5, 0.25]))
+
+        self.assertEqual(self.mesh.get_tex_coords_count(), 1)
+        self.assertEqual(self.mesh.get_tex_coords(0)[1], 0.25)
+
+    def test_set_triangles(self):
+        self.mesh.set_triangles(
+            array.array('i', [0, 1, 2, 2, 1, 3]),
+            material_indices=array.array('H', [0, 1]))
+
+        self.assertEqual(self.mesh.get_triangle_count(), 2)
+        self.assertEqual(self.mesh.get_triangle(1).m_v2, 3)
+        self.assertEqual(self.mesh.get_triangle(1).m_pa, 1)
+
+    def test_set_vertices_with_incomplete_vertex_raises(self):
+        with self.assertRaises(ValueError):
+            self.mesh.set_vertices(array.array('f', [0.0, 1.0]))
+
+    def test_set_vertices_with_integer_buffer_raises(self):
+        with self.assertRaises(TypeError):
+            self.mesh.set_vertices(array.array('i', [0, 1, 2]))
+
+    def test_set_triangles_with_negative_index_raises(self):
+        with self.assertRaises(ValueError):
+            self.mesh.set_triangles(array.array('i', [0, -1, 2]))
+
+    def test_set_triangles_with_index_exceeding_32_bits_raises(self):
+        with self.assertRaises(OverflowError):
+            self.mesh.set_triangles(array.array('q', [0, 1, 2 ** 32]))
+
+
+class TestTileBuffer(unittest.TestCase):
+    """
+    Zero-copy access to tile pixels.
+    """
+
+    def test_pixels_view_has_tile_shape(self):
+        tile = asr.Tile(4, 2, 3, asr.PixelFormat.Float)
+        pixels = tile.get_pixels()
+
+        self.assertEqual(pixels.format, 'f')
+        self.assertEqual(pixels.shape, (2, 4, 3))
+        self.assertTrue(pixels.readonly)
+
+    def test_pixels_view_keeps_tile_alive(self):
+        pixels = memoryview(asr.Tile(2, 2, 1, asr.PixelFormat.UInt8))
+
+        self.assertEqual(len(pixels.tobytes()), 4)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -341,6 +341,10 @@ class MaterialAssignmentEditorWindow::AssignMaterialsAction
                 : m_object_instance.assign_material(i->m_slot_name.c_str(), i->m_side, i->m_material_name.c_str());
         }
 
+        project.get_scene_edit_journal().record(
+            m_object_instance,
+            SceneEditJournal::MaterialBindingEdit);
+
         m_object_instance_item.update_style();
     }
 
@@ -364,7 +368,11 @@ void MaterialAssignmentEditorWindow::assign_materials(const SlotValueCollection&
 
     if (old_front_mappings != m_object_instance.get_front_material_mappings() ||
         old_back_mappings != m_object_instance.get_back_material_mappings())
-        m_editor_context.m_project_builder.slot_notify_project_modification();
+    {
+        m_editor_context.m_project_builder.notify_scene_edit(
+            m_object_instance,
+            SceneEditJournal::MaterialBindingEdit);
+    }
 }
 
 void MaterialAssignmentEditorWindow::slot_change_back_material_mode(int index)
@@ -544,7 +544,9 @@ void ObjectInstanceItem::do_assign_material(
     if (sides & ObjectInstance::BackSide)
         m_entity->assign_material(slot_name, ObjectInstance::BackSide, material_name);
 
-    m_editor_context.m_project_builder.slot_notify_project_modification();
+    m_editor_context.m_project_builder.notify_scene_edit(
+        *m_entity,
+        SceneEditJournal::MaterialBindingEdit);
 
     update_style();
 }
@@ -559,7 +561,9 @@ void ObjectInstanceItem::do_unassign_material(
     if (sides & ObjectInstance::BackSide)
         m_entity->unassign_material(slot_name, ObjectInstance::BackSide);
 
-    m_editor_context.m_project_builder.slot_notify_project_modification();
+    m_editor_context.m_project_builder.notify_scene_edit(
+        *m_entity,
+        SceneEditJournal::MaterialBindingEdit);
 
     update_style();
 }
@@ -81,8 +81,20 @@ Frame* ProjectBuilder::edit_frame(
     return m_project.get_frame();
 }
 
+void ProjectBuilder::notify_scene_edit(
+    Entity&                         entity,
+    const SceneEditJournal::EditType type) const
+{
+    m_project.get_scene_edit_journal().record(entity, type);
+
+    emit signal_project_modified();
+}
+
 void ProjectBuilder::slot_notify_project_modification() const
 {
+    // Edits notified this way cannot be applied in place by the renderer.
+    m_project.get_scene_edit_journal().record_structure_edit();
+
     emit signal_project_modified();
 }
 
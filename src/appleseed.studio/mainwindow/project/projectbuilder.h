@@ -99,6 +99,11 @@ class ProjectBuilder
     renderer::Frame* edit_frame(
         const foundation::Dictionary&       values) const;
 
+    // Notify an edit that the renderer may apply in place while rendering.
+    void notify_scene_edit(
+        renderer::Entity&                   entity,
+        const renderer::SceneEditJournal::EditType type) const;
+
   signals:
     void signal_project_modified() const;
     void signal_frame_modified() const;
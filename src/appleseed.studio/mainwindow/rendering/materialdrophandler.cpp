@@ -34,6 +34,7 @@
 
 // appleseed.renderer headers.
 #include "renderer/kernel/rendering/scenepicker.h"
+#include "renderer/modeling/scene/sceneeditjournal.h"
 
 // Qt headers.
 #include <QMenu>
@@ -100,6 +101,10 @@ namespace
             {
                 m_instance.assign_material(slot.m_name.c_str(), slot.m_side, m_material_name.c_str());
             }
+
+            project.get_scene_edit_journal().record(
+                m_instance,
+                renderer::SceneEditJournal::MaterialBindingEdit);
         }
 
       private:
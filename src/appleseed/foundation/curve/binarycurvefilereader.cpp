@@ -82,12 +82,17 @@ void BinaryCurveFileReader::read(ICurveBuilder& builder)
         reader.reset(new LZ4CompressedReaderAdapter(file));
         break;
 
+      // LZ4-compressed, with per-object motion segments.
+      case 3:
+        reader.reset(new LZ4CompressedReaderAdapter(file));
+        break;
+
       // Unknown format.
       default:
         throw ExceptionIOError("unknown binarycurve format version");
     }
 
-    read_curves(*reader.get(), builder);
+    read_curves(*reader.get(), version, builder);
 }
 
 void BinaryCurveFileReader::read_and_check_signature(BufferedFile& file)
@@ -101,7 +106,10 @@ void BinaryCurveFileReader::read_and_check_signature(BufferedFile& file)
         throw ExceptionIOError("invalid binarycurve format signature");
 }
 
-void BinaryCurveFileReader::read_curves(ReaderAdapter& reader, ICurveBuilder& builder)
+void BinaryCurveFileReader::read_curves(
+    ReaderAdapter&          reader,
+    const std::uint16_t     version,
+    ICurveBuilder&          builder)
 {
     try
     {
@@ -124,12 +132,18 @@ void BinaryCurveFileReader::read_curves(ReaderAdapter& reader, ICurveBuilder& bu
             if (curve_basis < 1 || curve_basis > 4)
                 throw ExceptionIOError();
 
+            // Read the motion segment count (version 3 and later).
+            std::uint32_t motion_segment_count = 0;
+            if (version >= 3)
+                checked_read(reader, motion_segment_count);
+
             builder.begin_curve_object(static_cast<CurveBasis>(curve_basis), curve_count);
+            builder.set_motion_segment_count(motion_segment_count);
 
             for (std::uint32_t i = 0; i < curve_count; ++i)
             {
                 builder.begin_curve();
-                read_curve(reader, builder);
+                read_curve(reader, motion_segment_count, builder);
                 builder.end_curve();
             }
 
@@ -143,7 +157,10 @@ void BinaryCurveFileReader::read_curves(ReaderAdapter& reader, ICurveBuilder& bu
     }
 }
 
-void BinaryCurveFileReader::read_curve(ReaderAdapter &reader, ICurveBuilder &builder)
+void BinaryCurveFileReader::read_curve(
+    ReaderAdapter&          reader,
+    const std::uint32_t     motion_segment_count,
+    ICurveBuilder&          builder)
 {
     std::uint32_t vertex_count;
     checked_read(reader, vertex_count);
@@ -155,6 +172,16 @@ void BinaryCurveFileReader::read_curve(ReaderAdapter &reader, ICurveBuilder &bui
         builder.push_vertex(v);
     }
 
+    for (std::uint32_t m = 0; m < motion_segment_count; ++m)
+    {
+        for (std::uint32_t i = 0; i < vertex_count; ++i)
+        {
+            Vector3f v;
+            checked_read(reader, v);
+            builder.push_vertex_pose(m, v);
+        }
+    }
+
     for (std::uint32_t i = 0; i < vertex_count; ++i)
     {
         float v;
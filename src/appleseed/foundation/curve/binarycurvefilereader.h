@@ -32,6 +32,7 @@
 #include "foundation/curve/icurvefilereader.h"
 
 // Standard headers.
+#include <cstdint>
 #include <string>
 
 // Forward declarations.
@@ -60,8 +61,8 @@ class BinaryCurveFileReader
     const std::string m_filename;
 
     static void read_and_check_signature(BufferedFile& file);
-    void read_curves(ReaderAdapter& reader, ICurveBuilder& builder);
-    void read_curve(ReaderAdapter& reader, ICurveBuilder& builder);
+    void read_curves(ReaderAdapter& reader, const std::uint16_t version, ICurveBuilder& builder);
+    void read_curve(ReaderAdapter& reader, const std::uint32_t motion_segment_count, ICurveBuilder& builder);
 };
 
 }   // namespace foundation
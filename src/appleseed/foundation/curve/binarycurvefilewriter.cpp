@@ -35,6 +35,7 @@
 #include "foundation/math/vector.h"
 
 // Standard headers.
+#include <cstddef>
 #include <cstring>
 
 namespace foundation
@@ -77,7 +78,7 @@ void BinaryCurveFileWriter::write_signature()
 
 void BinaryCurveFileWriter::write_version()
 {
-    const std::uint16_t Version = 2;
+    const std::uint16_t Version = 3;
     checked_write(m_file, Version);
 }
 
@@ -85,6 +86,7 @@ void BinaryCurveFileWriter::write_curves(const ICurveWalker& walker)
 {
     write_basis(walker);
     write_curve_count(walker);
+    write_motion_segment_count(walker);
 
     std::uint32_t vertex_count = 0;
 
@@ -104,6 +106,12 @@ void BinaryCurveFileWriter::write_curve_count(const ICurveWalker& walker)
     checked_write(m_writer, curve_count);
 }
 
+void BinaryCurveFileWriter::write_motion_segment_count(const ICurveWalker& walker)
+{
+    const std::uint32_t motion_segment_count = static_cast<std::uint32_t>(walker.get_motion_segment_count());
+    checked_write(m_writer, motion_segment_count);
+}
+
 void BinaryCurveFileWriter::write_curve(const ICurveWalker& walker, const std::uint32_t curve_id, std::uint32_t& vertex_count)
 {
     const std::uint32_t count = static_cast<std::uint32_t>(walker.get_vertex_count(curve_id));
@@ -112,6 +120,13 @@ void BinaryCurveFileWriter::write_curve(const ICurveWalker& walker, const std::u
     for (std::uint32_t i = 0; i < count; ++i)
         checked_write(m_writer, walker.get_vertex(i + vertex_count));
 
+    const size_t motion_segment_count = walker.get_motion_segment_count();
+    for (size_t m = 0; m < motion_segment_count; ++m)
+    {
+        for (std::uint32_t i = 0; i < count; ++i)
+            checked_write(m_writer, walker.get_vertex_pose(i + vertex_count, m));
+    }
+
     for (std::uint32_t i = 0; i < count; ++i)
         checked_write(m_writer, walker.get_vertex_width(i + vertex_count));
 
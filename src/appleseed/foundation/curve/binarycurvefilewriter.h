@@ -67,6 +67,7 @@ class BinaryCurveFileWriter
     void write_curves(const ICurveWalker& walker);
     void write_curve_count(const ICurveWalker& walker);
     void write_basis(const ICurveWalker& walker);
+    void write_motion_segment_count(const ICurveWalker& walker);
     void write_curve(const ICurveWalker& walker, const std::uint32_t curve_id, std::uint32_t& vertex_count);
 };
 
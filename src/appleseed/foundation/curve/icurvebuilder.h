@@ -72,6 +72,12 @@ class APPLESEED_DLLSYMBOL ICurveBuilder
     // Append an opacity value to the vertex of a curve.
     virtual void push_vertex_opacity(const float o) = 0;
 
+    // Set the number of motion segments of the curve object (0 for no motion).
+    virtual void set_motion_segment_count(const size_t count) = 0;
+
+    // Append the position of the vertex of a curve for a given motion segment.
+    virtual void push_vertex_pose(const size_t motion_segment_index, const Vector3f& v) = 0;
+
     // End the definition of a curve.
     virtual void end_curve() = 0;
 
@@ -74,6 +74,12 @@ class APPLESEED_DLLSYMBOL ICurveWalker
 
     // Return vertex color on curve.
     virtual Color3f get_vertex_color(const size_t i) const = 0;
+
+    // Return the number of motion segments (0 for no motion).
+    virtual size_t get_motion_segment_count() const = 0;
+
+    // Return vertex location on curve for a given motion segment.
+    virtual Vector3f get_vertex_pose(const size_t i, const size_t motion_segment_index) const = 0;
 };
 
 }   // namespace foundation
@@ -0,0 +1,258 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/math/scalar.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace foundation
+{
+
+//
+// Alias table for O(1) sampling of discrete distributions.
+//
+// The interface mirrors the one of foundation::CDF so that both can be used
+// interchangeably. Contrary to CDF::sample(), AliasTable::sample() is not a
+// monotonic function of x: neighboring sample values may select unrelated items,
+// so CDF should be preferred when the stratification of x must carry over to the
+// selected items. Since a single uniform sample both selects a bucket and decides
+// between the bucket's item and its alias, x should have a precision well above
+// log2(size()) bits.
+//
+// Reference:
+//
+//   A Linear Algorithm For Generating Random Numbers With a Given Distribution
+//   Michael D. Vose, IEEE Transactions on Software Engineering, 1991.
+//
+
+template <typename Item, typename Weight>
+class AliasTable
+{
+  public:
+    typedef std::pair<Item, Weight> ItemWeightPair;
+
+    // Constructor.
+    AliasTable();
+
+    // Return the number of items in the table.
+    size_t size() const;
+
+    // Return true if the table is empty.
+    bool empty() const;
+
+    // Return true if the table has at least one item with a positive weight.
+    bool valid() const;
+
+    // Return the sum of the weight of all inserted items.
+    Weight weight() const;
+
+    // Remove all items from the table.
+    void clear();
+
+    // Allocate memory for a given number of items.
+    void reserve(const size_t count);
+
+    // Insert an item with a given non-negative weight.
+    void insert(const Item& item, const Weight weight);
+
+    // Access the i'th item.
+    const ItemWeightPair& operator[](const size_t i) const;
+
+    // Prepare the table for sampling.
+    // This method must be called once and only once before sample() is called.
+    void prepare();
+
+    // Sample the table. x is in [0,1).
+    const ItemWeightPair& sample(const Weight x) const;
+
+  private:
+    struct Bucket
+    {
+        double          m_threshold;    // probability of picking the bucket's own item
+        size_t          m_alias;        // item picked otherwise
+    };
+
+    typedef std::vector<ItemWeightPair> ItemVector;
+    typedef std::vector<Bucket> BucketVector;
+
+    ItemVector          m_items;
+    Weight              m_weight_sum;
+    BucketVector        m_buckets;
+};
+
+
+//
+// AliasTable class implementation.
+//
+
+template <typename Item, typename Weight>
+inline AliasTable<Item, Weight>::AliasTable()
+  : m_weight_sum(0.0)
+{
+}
+
+template <typename Item, typename Weight>
+inline size_t AliasTable<Item, Weight>::size() const
+{
+    return m_items.size();
+}
+
+template <typename Item, typename Weight>
+inline bool AliasTable<Item, Weight>::empty() const
+{
+    return m_items.empty();
+}
+
+template <typename Item, typename Weight>
+inline bool AliasTable<Item, Weight>::valid() const
+{
+    return m_weight_sum > Weight(0.0);
+}
+
+template <typename Item, typename Weight>
+inline Weight AliasTable<Item, Weight>::weight() const
+{
+    return m_weight_sum;
+}
+
+template <typename Item, typename Weight>
+inline void AliasTable<Item, Weight>::clear()
+{
+    m_items.clear();
+    m_weight_sum = Weight(0.0);
+    m_buckets.clear();
+}
+
+template <typename Item, typename Weight>
+inline void AliasTable<Item, Weight>::reserve(const size_t count)
+{
+    m_items.reserve(count);
+}
+
+template <typename Item, typename Weight>
+inline void AliasTable<Item, Weight>::insert(const Item& item, const Weight weight)
+{
+    assert(weight >= Weight(0.0));
+    m_items.push_back(std::make_pair(item, weight));
+    m_weight_sum += weight;
+}
+
+template <typename Item, typename Weight>
+inline const typename AliasTable<Item, Weight>::ItemWeightPair& AliasTable<Item, Weight>::operator[](const size_t i) const
+{
+    assert(i < m_items.size());
+    return m_items[i];
+}
+
+template <typename Item, typename Weight>
+void AliasTable<Item, Weight>::prepare()
+{
+    assert(valid());
+    assert(m_buckets.empty());
+
+    const size_t item_count = m_items.size();
+
+    // Normalize weights so that they add up to 1.0.
+    const Weight rcp_weight_sum = Weight(1.0) / m_weight_sum;
+    for (size_t i = 0; i < item_count; ++i)
+        m_items[i].second *= rcp_weight_sum;
+
+    // Scale probabilities so that they average to 1.0 and split items into
+    // underfull and overfull ones. Double precision keeps the accumulated
+    // error far below the weight of the smallest item.
+    std::vector<double> scaled(item_count);
+    std::vector<size_t> small, large;
+    small.reserve(item_count);
+    large.reserve(item_count);
+
+    for (size_t i = 0; i < item_count; ++i)
+    {
+        scaled[i] = static_cast<double>(m_items[i].second) * item_count;
+        (scaled[i] < 1.0 ? small : large).push_back(i);
+    }
+
+    // Fill each underfull bucket with the excess of an overfull item.
+    m_buckets.resize(item_count);
+
+    while (!small.empty() && !large.empty())
+    {
+        const size_t s = small.back();
+        small.pop_back();
+
+        const size_t l = large.back();
+        large.pop_back();
+
+        m_buckets[s].m_threshold = scaled[s];
+        m_buckets[s].m_alias = l;
+
+        scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+        (scaled[l] < 1.0 ? small : large).push_back(l);
+    }
+
+    // Remaining items fill their bucket up to numerical errors.
+    for (size_t i = 0, e = large.size(); i < e; ++i)
+    {
+        m_buckets[large[i]].m_threshold = 1.0;
+        m_buckets[large[i]].m_alias = large[i];
+    }
+
+    for (size_t i = 0, e = small.size(); i < e; ++i)
+    {
+        assert(m_items[small[i]].second > Weight(0.0));
+        m_buckets[small[i]].m_threshold = 1.0;
+        m_buckets[small[i]].m_alias = small[i];
+    }
+}
+
+template <typename Item, typename Weight>
+inline const std::pair<Item, Weight>& AliasTable<Item, Weight>::sample(const Weight x) const
+{
+    assert(valid());
+    assert(!m_buckets.empty());
+    assert(x >= Weight(0.0));
+    assert(x < Weight(1.0));
+
+    const size_t item_count = m_items.size();
+    const double scaled_x = static_cast<double>(x) * item_count;
+    const size_t i = std::min(truncate<size_t>(scaled_x), item_count - 1);
+
+    const Bucket& bucket = m_buckets[i];
+    const size_t j = scaled_x - i < bucket.m_threshold ? i : bucket.m_alias;
+
+    return m_items[j];
+}
+
+}   // namespace foundation
@@ -90,6 +90,8 @@ class BezierCurveBase
         const ValueType     opacity[N + 1],
         const ColorType     color[N + 1]);
     BezierCurveBase(const BezierCurveBase& curve, const MatrixType& xfm);
+    BezierCurveBase(const BezierCurveBase& curve, const VectorType ctrl_pts[N + 1]);
+    BezierCurveBase(const BezierCurveBase& curve0, const BezierCurveBase& curve1, const ValueType t);
 
     size_t get_control_point_count() const;
     const VectorType& get_control_point(const size_t index) const;
@@ -144,6 +146,8 @@ class BezierCurve1
         const ValueType     opacity[2],
         const ColorType     color[2]);
     BezierCurve1(const BezierCurve1& curve, const MatrixType& xfm);
+    BezierCurve1(const BezierCurve1& curve, const VectorType ctrl_pts[2]);
+    BezierCurve1(const BezierCurve1& curve0, const BezierCurve1& curve1, const ValueType t);
 
     VectorType evaluate_point(const ValueType t) const;
     ValueType evaluate_width(const ValueType t) const;
@@ -184,6 +188,8 @@ class BezierCurve2
         const ValueType     opacity[3],
         const ColorType     color[3]);
     BezierCurve2(const BezierCurve2& curve, const MatrixType& xfm);
+    BezierCurve2(const BezierCurve2& curve, const VectorType ctrl_pts[3]);
+    BezierCurve2(const BezierCurve2& curve0, const BezierCurve2& curve1, const ValueType t);
 
     VectorType evaluate_point(const ValueType t) const;
     ValueType evaluate_width(const ValueType t) const;
@@ -224,6 +230,8 @@ class BezierCurve3
         const ValueType     opacity[4],
         const ColorType     color[4]);
     BezierCurve3(const BezierCurve3& curve, const MatrixType& xfm);
+    BezierCurve3(const BezierCurve3& curve, const VectorType ctrl_pts[4]);
+    BezierCurve3(const BezierCurve3& curve0, const BezierCurve3& curve1, const ValueType t);
 
     VectorType evaluate_point(const ValueType t) const;
     ValueType evaluate_width(const ValueType t) const;
@@ -281,6 +289,31 @@ class BezierCurveIntersector
         const ValueType         epsilon = ValueType(0.05),
         const size_t            max_depth = 5);
 
+    // Compute the intersection between a ray and a curve moving linearly from
+    // curve0 to curve1, at a given time in [0, 1] between the two poses.
+    static bool intersect(
+        const BezierCurveType&  curve0,
+        const BezierCurveType&  curve1,
+        const ValueType         time,
+        const RayType&          ray,
+        const MatrixType&       xfm,
+        ValueType&              u,
+        ValueType&              v,
+        ValueType&              t,
+        const ValueType         epsilon = ValueType(0.05),
+        const size_t            max_depth = 5);
+
+    // Return whether a ray intersects a curve moving linearly from curve0 to
+    // curve1, at a given time in [0, 1] between the two poses.
+    static bool intersect(
+        const BezierCurveType&  curve0,
+        const BezierCurveType&  curve1,
+        const ValueType         time,
+        const RayType&          ray,
+        const MatrixType&       xfm,
+        const ValueType         epsilon = ValueType(0.05),
+        const size_t            max_depth = 5);
+
   private:
     // Dot product function that only considers the x and y components of the vectors.
     static ValueType dotxy(const VectorType& lhs, const VectorType& rhs)
@@ -359,6 +392,35 @@ BezierCurveBase<T, N>::BezierCurveBase(
     }
 }
 
+template <typename T, size_t N>
+BezierCurveBase<T, N>::BezierCurveBase(
+    const BezierCurveBase&  curve,
+    const VectorType        ctrl_pts[N + 1])
+{
+    for (size_t i = 0; i < N + 1; ++i)
+    {
+        m_ctrl_pts[i] = ctrl_pts[i];
+        m_width[i] = curve.m_width[i];
+        m_opacity[i] = curve.m_opacity[i];
+        m_color[i] = curve.m_color[i];
+    }
+}
+
+template <typename T, size_t N>
+BezierCurveBase<T, N>::BezierCurveBase(
+    const BezierCurveBase&  curve0,
+    const BezierCurveBase&  curve1,
+    const ValueType         t)
+{
+    for (size_t i = 0; i < N + 1; ++i)
+    {
+        m_ctrl_pts[i] = lerp(curve0.m_ctrl_pts[i], curve1.m_ctrl_pts[i], t);
+        m_width[i] = lerp(curve0.m_width[i], curve1.m_width[i], t);
+        m_opacity[i] = lerp(curve0.m_opacity[i], curve1.m_opacity[i], t);
+        m_color[i] = lerp(curve0.m_color[i], curve1.m_color[i], t);
+    }
+}
+
 template <typename T, size_t N>
 inline size_t BezierCurveBase<T, N>::get_control_point_count() const
 {
@@ -490,6 +552,23 @@ inline BezierCurve1<T>::BezierCurve1(
 {
 }
 
+template <typename T>
+inline BezierCurve1<T>::BezierCurve1(
+    const BezierCurve1&     curve,
+    const VectorType        ctrl_pts[2])
+  : Base(curve, ctrl_pts)
+{
+}
+
+template <typename T>
+inline BezierCurve1<T>::BezierCurve1(
+    const BezierCurve1&     curve0,
+    const BezierCurve1&     curve1,
+    const ValueType         t)
+  : Base(curve0, curve1, t)
+{
+}
+
 template <typename T>
 inline typename BezierCurve1<T>::VectorType BezierCurve1<T>::evaluate_point(const ValueType t) const
 {
@@ -614,6 +693,23 @@ inline BezierCurve2<T>::BezierCurve2(
 {
 }
 
+template <typename T>
+inline BezierCurve2<T>::BezierCurve2(
+    const BezierCurve2&     curve,
+    const VectorType        ctrl_pts[3])
+  : Base(curve, ctrl_pts)
+{
+}
+
+template <typename T>
+inline BezierCurve2<T>::BezierCurve2(
+    const BezierCurve2&     curve0,
+    const BezierCurve2&     curve1,
+    const ValueType         t)
+  : Base(curve0, curve1, t)
+{
+}
+
 template <typename T>
 inline typename BezierCurve2<T>::VectorType BezierCurve2<T>::evaluate_point(const ValueType t) const
 {
@@ -763,6 +859,23 @@ inline BezierCurve3<T>::BezierCurve3(
 {
 }
 
+template <typename T>
+inline BezierCurve3<T>::BezierCurve3(
+    const BezierCurve3&     curve,
+    const VectorType        ctrl_pts[4])
+  : Base(curve, ctrl_pts)
+{
+}
+
+template <typename T>
+inline BezierCurve3<T>::BezierCurve3(
+    const BezierCurve3&     curve0,
+    const BezierCurve3&     curve1,
+    const ValueType         t)
+  : Base(curve0, curve1, t)
+{
+}
+
 template <typename T>
 inline typename BezierCurve3<T>::VectorType BezierCurve3<T>::evaluate_point(const ValueType t) const
 {
@@ -1111,6 +1224,48 @@ bool BezierCurveIntersector<BezierCurveType>::intersect(
             false);
 }
 
+template <typename BezierCurveType>
+inline bool BezierCurveIntersector<BezierCurveType>::intersect(
+    const BezierCurveType&  curve0,
+    const BezierCurveType&  curve1,
+    const ValueType         time,
+    const RayType&          ray,
+    const MatrixType&       xfm,
+    ValueType&              u,
+    ValueType&              v,
+    ValueType&              t,
+    const ValueType         epsilon,
+    const size_t            max_depth)
+{
+    return
+        intersect(
+            BezierCurveType(curve0, curve1, time),
+            ray,
+            xfm,
+            u, v, t,
+            epsilon,
+            max_depth);
+}
+
+template <typename BezierCurveType>
+inline bool BezierCurveIntersector<BezierCurveType>::intersect(
+    const BezierCurveType&  curve0,
+    const BezierCurveType&  curve1,
+    const ValueType         time,
+    const RayType&          ray,
+    const MatrixType&       xfm,
+    const ValueType         epsilon,
+    const size_t            max_depth)
+{
+    return
+        intersect(
+            BezierCurveType(curve0, curve1, time),
+            ray,
+            xfm,
+            epsilon,
+            max_depth);
+}
+
 template <typename BezierCurveType>
 bool BezierCurveIntersector<BezierCurveType>::converge(
     const size_t            depth,
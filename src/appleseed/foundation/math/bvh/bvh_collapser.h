@@ -0,0 +1,209 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/aabb.h"
+#include "foundation/utility/stopwatch.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+
+namespace foundation {
+namespace bvh {
+
+//
+// Collapse a binary BVH into a wide BVH.
+//
+// Each wide node is formed by repeatedly opening the interior node of largest surface
+// area among the candidate children, starting with the two children of a binary node,
+// until Width children are gathered or only leaves remain. The leaves of the binary
+// tree are referenced (not copied) by the wide tree, so the binary tree must outlive
+// the wide tree and must not be modified.
+//
+// If the root of the binary tree is a leaf, the wide tree is left empty.
+//
+// Reference:
+//
+//   Getting Rid of Packets: Efficient SIMD Single-Ray Traversal using Multi-branching BVHs
+//   Ingo Wald, Carsten Benthin, Solomon Boulos
+//   http://www.sci.utah.edu/~wald/Publications/2008/WideBVH/widebvh.pdf
+//
+
+template <typename Tree, typename WideNodeVector>
+class Collapser
+  : public NonCopyable
+{
+  public:
+    typedef typename Tree::NodeType NodeType;
+    typedef typename WideNodeVector::value_type WideNodeType;
+    typedef typename WideNodeType::AABBType AABBType;
+
+    // Constructor.
+    Collapser();
+
+    // Collapse a binary tree into a wide tree.
+    template <typename Timer>
+    void collapse(
+        const Tree&             tree,
+        WideNodeVector&         wide_nodes);
+
+    // Return the collapsing time.
+    double get_collapse_time() const;
+
+  private:
+    struct Candidate
+    {
+        AABBType    m_bbox;
+        size_t      m_node_index;
+    };
+
+    double m_collapse_time;
+
+    void collapse_recurse(
+        const Tree&             tree,
+        WideNodeVector&         wide_nodes,
+        const size_t            wide_node_index,
+        const size_t            node_index);
+};
+
+
+//
+// Collapser class implementation.
+//
+
+template <typename Tree, typename WideNodeVector>
+Collapser<Tree, WideNodeVector>::Collapser()
+  : m_collapse_time(0.0)
+{
+}
+
+template <typename Tree, typename WideNodeVector>
+template <typename Timer>
+void Collapser<Tree, WideNodeVector>::collapse(
+    const Tree&                 tree,
+    WideNodeVector&             wide_nodes)
+{
+    // Start stopwatch.
+    Stopwatch<Timer> stopwatch;
+    stopwatch.start();
+
+    wide_nodes.clear();
+
+    if (!tree.m_nodes.empty() && tree.m_nodes[0].is_interior())
+    {
+        // A binary tree with n leaves has n - 1 interior nodes, and a wide tree
+        // has at least (n - 1) / (Width - 1) interior nodes.
+        wide_nodes.reserve(tree.m_nodes.size() / (WideNodeType::Width - 1) + 1);
+
+        wide_nodes.push_back(WideNodeType());
+        collapse_recurse(tree, wide_nodes, 0, 0);
+    }
+
+    // Measure and save collapsing time.
+    stopwatch.measure();
+    m_collapse_time = stopwatch.get_seconds();
+}
+
+template <typename Tree, typename WideNodeVector>
+inline double Collapser<Tree, WideNodeVector>::get_collapse_time() const
+{
+    return m_collapse_time;
+}
+
+template <typename Tree, typename WideNodeVector>
+void Collapser<Tree, WideNodeVector>::collapse_recurse(
+    const Tree&                 tree,
+    WideNodeVector&             wide_nodes,
+    const size_t                wide_node_index,
+    const size_t                node_index)
+{
+    const NodeType& node = tree.m_nodes[node_index];
+    assert(node.is_interior());
+
+    // Start with the two children of the binary node.
+    Candidate candidates[WideNodeType::Width];
+    candidates[0].m_bbox = AABBType(node.get_left_bbox());
+    candidates[0].m_node_index = node.get_child_node_index();
+    candidates[1].m_bbox = AABBType(node.get_right_bbox());
+    candidates[1].m_node_index = node.get_child_node_index() + 1;
+    size_t candidate_count = 2;
+
+    // Open the interior candidate of largest surface area until the wide node is full.
+    while (candidate_count < WideNodeType::Width)
+    {
+        size_t best_candidate = ~size_t(0);
+        typename AABBType::ValueType best_area(-1.0);
+
+        for (size_t i = 0; i < candidate_count; ++i)
+        {
+            if (tree.m_nodes[candidates[i].m_node_index].is_interior())
+            {
+                const typename AABBType::ValueType area = half_surface_area(candidates[i].m_bbox);
+
+                if (best_area < area)
+                {
+                    best_area = area;
+                    best_candidate = i;
+                }
+            }
+        }
+
+        if (best_candidate == ~size_t(0))
+            break;
+
+        const NodeType& opened_node = tree.m_nodes[candidates[best_candidate].m_node_index];
+        candidates[candidate_count].m_bbox = AABBType(opened_node.get_right_bbox());
+        candidates[candidate_count].m_node_index = opened_node.get_child_node_index() + 1;
+        candidates[best_candidate].m_bbox = AABBType(opened_node.get_left_bbox());
+        candidates[best_candidate].m_node_index = opened_node.get_child_node_index();
+        ++candidate_count;
+    }
+
+    // Create the children of the wide node, then recurse into interior children.
+    for (size_t i = 0; i < candidate_count; ++i)
+    {
+        const size_t child_node_index = candidates[i].m_node_index;
+
+        if (tree.m_nodes[child_node_index].is_leaf())
+            wide_nodes[wide_node_index].add_child(candidates[i].m_bbox, child_node_index, true);
+        else
+        {
+            const size_t child_wide_node_index = wide_nodes.size();
+            wide_nodes.push_back(WideNodeType());
+            wide_nodes[wide_node_index].add_child(candidates[i].m_bbox, child_wide_node_index, false);
+            collapse_recurse(tree, wide_nodes, child_wide_node_index, child_node_index);
+        }
+    }
+}
+
+}   // namespace bvh
+}   // namespace foundation
@@ -0,0 +1,440 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/bvh/bvh_intersector.h"
+#include "foundation/math/bvh/bvh_statistics.h"
+#include "foundation/math/intersection/rayaabb.h"
+#include "foundation/math/ray.h"
+#include "foundation/math/scalar.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace foundation {
+namespace bvh {
+
+//
+// BVH packet intersector.
+//
+// Traverses a BVH with a packet of coherent rays (e.g. camera rays going through
+// neighboring image points) so that every node is fetched once for the whole packet
+// instead of once per ray. Each node is first tested against a conservative frustum
+// bounding the packet, which culls it for all rays at once. If the node survives,
+// the rays are tested one by one starting from the first ray still active at this
+// node, and the node is entered as soon as one of them hits it.
+//
+// The Visitor class must conform to the following prototype:
+//
+//      class Visitor
+//        : public foundation::NonCopyable
+//      {
+//        public:
+//          // Visit a leaf with the 'ray_count' rays whose indices in the packet are
+//          // given by 'ray_indices'. 'distances' holds, for every ray of the packet,
+//          // the distance to the closest hit so far and should be updated accordingly.
+//          void visit(
+//              const NodeType&             node,
+//              const RayType*              rays,
+//              const RayInfoType*          ray_infos,
+//              const size_t*               ray_indices,
+//              const size_t                ray_count,
+//              ValueType*                  distances
+//      #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+//              , TraversalStatistics&      stats
+//      #endif
+//              );
+//      };
+//
+// Only the static (no motion) case is supported.
+//
+
+template <
+    typename Tree,
+    typename Visitor,
+    typename Ray,
+    size_t PacketSize,
+    size_t StackSize = 64
+>
+class PacketIntersector
+  : public NonCopyable
+{
+  public:
+    typedef typename Tree::NodeType NodeType;
+    typedef typename NodeType::AABBType AABBType;
+    typedef typename AABBType::ValueType ValueType;
+    typedef Ray RayType;
+    typedef RayInfo<ValueType, 3> RayInfoType;
+
+    static_assert(AABBType::Dimension == 3, "foundation::bvh::PacketIntersector only supports 3D trees");
+
+    // Intersect a packet of at most PacketSize rays with a given BVH without motion.
+    void intersect_no_motion(
+        const Tree&             tree,
+        const RayType*          rays,
+        const RayInfoType*      ray_infos,
+        const size_t            ray_count,
+        Visitor&                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , TraversalStatistics&  stats
+#endif
+        ) const;
+
+  private:
+    // Conservative bounds of the rays of a packet. Only valid when all rays
+    // have finite reciprocal directions with the same signs.
+    struct Frustum
+    {
+        bool            m_valid;
+        std::uint32_t   m_sgn_dir[3];
+        ValueType       m_org_min[3];
+        ValueType       m_org_max[3];
+        ValueType       m_rcp_dir_min[3];
+        ValueType       m_rcp_dir_max[3];
+        ValueType       m_tmin;                 // smallest ray tmin
+        ValueType       m_tmax;                 // largest ray tmax
+    };
+
+    struct StackEntry
+    {
+        const NodeType* m_node;
+        AABBType        m_bbox;                 // bounding box of the node, unused for the root node
+        size_t          m_first_ray;            // index of the first ray of the packet hitting the node
+    };
+
+    static void compute_frustum(
+        const RayType*          rays,
+        const RayInfoType*      ray_infos,
+        const size_t            ray_count,
+        Frustum&                frustum);
+
+    // Return false if the bounding box is missed by all the rays of the frustum.
+    static bool intersect_frustum(
+        const Frustum&          frustum,
+        const AABBType&         bbox);
+
+    // Return the index of the first ray in [first_ray, ray_count) that hits the
+    // bounding box, or ray_count if there is none.
+    static size_t find_first_hit(
+        const RayType*          rays,
+        const RayInfoType*      ray_infos,
+        const ValueType*        distances,
+        const size_t            ray_count,
+        const AABBType&         bbox,
+        const size_t            first_ray,
+        ValueType&              tmin);
+};
+
+
+//
+// PacketIntersector class implementation.
+//
+
+template <
+    typename Tree,
+    typename Visitor,
+    typename Ray,
+    size_t PacketSize,
+    size_t StackSize
+>
+void PacketIntersector<Tree, Visitor, Ray, PacketSize, StackSize>::compute_frustum(
+    const RayType*              rays,
+    const RayInfoType*          ray_infos,
+    const size_t                ray_count,
+    Frustum&                    frustum)
+{
+    frustum.m_valid = true;
+    frustum.m_tmin = rays[0].m_tmin;
+    frustum.m_tmax = rays[0].m_tmax;
+
+    for (size_t d = 0; d < 3; ++d)
+    {
+        frustum.m_sgn_dir[d] = ray_infos[0].m_sgn_dir[d];
+        frustum.m_org_min[d] = frustum.m_org_max[d] = rays[0].m_org[d];
+        frustum.m_rcp_dir_min[d] = frustum.m_rcp_dir_max[d] = ray_infos[0].m_rcp_dir[d];
+    }
+
+    for (size_t i = 0; i < ray_count; ++i)
+    {
+        frustum.m_tmin = std::min(frustum.m_tmin, rays[i].m_tmin);
+        frustum.m_tmax = std::max(frustum.m_tmax, rays[i].m_tmax);
+
+        for (size_t d = 0; d < 3; ++d)
+        {
+            const ValueType rcp_dir = ray_infos[i].m_rcp_dir[d];
+
+            if (ray_infos[i].m_sgn_dir[d] != frustum.m_sgn_dir[d] || !std::isfinite(rcp_dir))
+            {
+                frustum.m_valid = false;
+                return;
+            }
+
+            frustum.m_org_min[d] = std::min(frustum.m_org_min[d], rays[i].m_org[d]);
+            frustum.m_org_max[d] = std::max(frustum.m_org_max[d], rays[i].m_org[d]);
+            frustum.m_rcp_dir_min[d] = std::min(frustum.m_rcp_dir_min[d], rcp_dir);
+            frustum.m_rcp_dir_max[d] = std::max(frustum.m_rcp_dir_max[d], rcp_dir);
+        }
+    }
+}
+
+template <
+    typename Tree,
+    typename Visitor,
+    typename Ray,
+    size_t PacketSize,
+    size_t StackSize
+>
+inline bool PacketIntersector<Tree, Visitor, Ray, PacketSize, StackSize>::intersect_frustum(
+    const Frustum&              frustum,
+    const AABBType&             bbox)
+{
+    // Interval arithmetic: bound the distances to the slabs of the bounding box over
+    // all the origins and reciprocal directions of the packet. Since rounding is
+    // monotonic, the bounds also hold for the distances computed ray by ray.
+    ValueType enter_min = frustum.m_tmin;
+    ValueType exit_max = frustum.m_tmax;
+
+    for (size_t d = 0; d < 3; ++d)
+    {
+        const ValueType near_plane = bbox[1 - frustum.m_sgn_dir[d]][d];
+        const ValueType far_plane = bbox[frustum.m_sgn_dir[d]][d];
+
+        const ValueType n0 = (near_plane - frustum.m_org_max[d]) * frustum.m_rcp_dir_min[d];
+        const ValueType n1 = (near_plane - frustum.m_org_max[d]) * frustum.m_rcp_dir_max[d];
+        const ValueType n2 = (near_plane - frustum.m_org_min[d]) * frustum.m_rcp_dir_min[d];
+        const ValueType n3 = (near_plane - frustum.m_org_min[d]) * frustum.m_rcp_dir_max[d];
+
+        const ValueType f0 = (far_plane - frustum.m_org_max[d]) * frustum.m_rcp_dir_min[d];
+        const ValueType f1 = (far_plane - frustum.m_org_max[d]) * frustum.m_rcp_dir_max[d];
+        const ValueType f2 = (far_plane - frustum.m_org_min[d]) * frustum.m_rcp_dir_min[d];
+        const ValueType f3 = (far_plane - frustum.m_org_min[d]) * frustum.m_rcp_dir_max[d];
+
+        enter_min = std::max(enter_min, std::min(std::min(n0, n1), std::min(n2, n3)));
+        exit_max = std::min(exit_max, std::max(std::max(f0, f1), std::max(f2, f3)));
+    }
+
+    // The comparisons are false for NaNs, in which case the bounding box is not culled.
+    return !(enter_min > exit_max || exit_max < frustum.m_tmin || enter_min >= frustum.m_tmax);
+}
+
+template <
+    typename Tree,
+    typename Visitor,
+    typename Ray,
+    size_t PacketSize,
+    size_t StackSize
+>
+inline size_t PacketIntersector<Tree, Visitor, Ray, PacketSize, StackSize>::find_first_hit(
+    const RayType*              rays,
+    const RayInfoType*          ray_infos,
+    const ValueType*            distances,
+    const size_t                ray_count,
+    const AABBType&             bbox,
+    const size_t                first_ray,
+    ValueType&                  tmin)
+{
+    for (size_t i = first_ray; i < ray_count; ++i)
+    {
+        if (foundation::intersect(rays[i], ray_infos[i], bbox, tmin) && tmin < distances[i])
+            return i;
+    }
+
+    return ray_count;
+}
+
+#if defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 7)))
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+template <
+    typename Tree,
+    typename Visitor,
+    typename Ray,
+    size_t PacketSize,
+    size_t StackSize
+>
+void PacketIntersector<Tree, Visitor, Ray, PacketSize, StackSize>::intersect_no_motion(
+    const Tree&                 tree,
+    const RayType*              rays,
+    const RayInfoType*          ray_infos,
+    const size_t                ray_count,
+    Visitor&                    visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , TraversalStatistics&      stats
+#endif
+    ) const
+{
+    // Make sure the tree was built.
+    assert(!tree.m_nodes.empty());
+
+    assert(ray_count <= PacketSize);
+
+    if (ray_count == 0)
+        return;
+
+    // Bound the packet.
+    Frustum frustum;
+    compute_frustum(rays, ray_infos, ray_count, frustum);
+
+    // Distance to the closest hit so far, for every ray.
+    ValueType distances[PacketSize];
+    for (size_t i = 0; i < ray_count; ++i)
+        distances[i] = rays[i].m_tmax;
+
+    // Node stack.
+    StackEntry stack[StackSize];
+    StackEntry* stack_ptr = stack;
+
+    // Current node.
+    StackEntry entry;
+    entry.m_node = &tree.m_nodes[0];
+    entry.m_first_ray = 0;
+
+    // Initialize traversal statistics.
+    FOUNDATION_BVH_TRAVERSAL_STATS(++stats.m_traversal_count);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t visited_nodes = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t visited_leaves = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t intersected_bboxes = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t discarded_nodes = 0);
+
+    // Traverse the tree and intersect leaf nodes.
+    while (true)
+    {
+        // Fetch the node.
+        FOUNDATION_BVH_TRAVERSAL_STATS(++visited_nodes);
+        const NodeType* node_ptr = entry.m_node;
+
+        if (node_ptr->is_interior())
+        {
+            FOUNDATION_BVH_TRAVERSAL_STATS(intersected_bboxes += 2);
+
+            const AABBType bboxes[2] = { node_ptr->get_left_bbox(), node_ptr->get_right_bbox() };
+            size_t first_ray[2];
+            ValueType tmin[2];
+
+            for (size_t c = 0; c < 2; ++c)
+            {
+                first_ray[c] =
+                    frustum.m_valid && !intersect_frustum(frustum, bboxes[c])
+                        ? ray_count
+                        : find_first_hit(rays, ray_infos, distances, ray_count, bboxes[c], entry.m_first_ray, tmin[c]);
+            }
+
+            const bool hit_left = first_ray[0] < ray_count;
+            const bool hit_right = first_ray[1] < ray_count;
+            const NodeType* child_ptr = &tree.m_nodes[node_ptr->get_child_node_index()];
+
+            if (hit_left && hit_right)
+            {
+                // Push the far child node to the stack, continue with the near child node.
+                const size_t near_index = tmin[0] <= tmin[1] ? 0 : 1;
+                const size_t far_index = 1 - near_index;
+                stack_ptr->m_node = child_ptr + far_index;
+                stack_ptr->m_bbox = bboxes[far_index];
+                stack_ptr->m_first_ray = first_ray[far_index];
+                ++stack_ptr;
+                entry.m_node = child_ptr + near_index;
+                entry.m_bbox = bboxes[near_index];
+                entry.m_first_ray = first_ray[near_index];
+                continue;
+            }
+
+            if (hit_left || hit_right)
+            {
+                // Continue with the left or right child node.
+                FOUNDATION_BVH_TRAVERSAL_STATS(++discarded_nodes);
+                const size_t index = hit_left ? 0 : 1;
+                entry.m_node = child_ptr + index;
+                entry.m_bbox = bboxes[index];
+                entry.m_first_ray = first_ray[index];
+                continue;
+            }
+
+            FOUNDATION_BVH_TRAVERSAL_STATS(discarded_nodes += 2);
+        }
+        else
+        {
+            // Gather the rays that hit the leaf. The first one is known to hit it,
+            // and all rays are considered to hit the root node.
+            const bool is_root = node_ptr == &tree.m_nodes[0];
+            size_t ray_indices[PacketSize];
+            size_t active_ray_count = 0;
+            ray_indices[active_ray_count++] = entry.m_first_ray;
+
+            for (size_t i = entry.m_first_ray + 1; i < ray_count; ++i)
+            {
+                ValueType tmin;
+                if (is_root ||
+                    (foundation::intersect(rays[i], ray_infos[i], entry.m_bbox, tmin) && tmin < distances[i]))
+                    ray_indices[active_ray_count++] = i;
+            }
+
+            // Visit the leaf.
+            FOUNDATION_BVH_TRAVERSAL_STATS(++visited_leaves);
+            visitor.visit(
+                *node_ptr,
+                rays,
+                ray_infos,
+                ray_indices,
+                active_ray_count,
+                distances
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , stats
+#endif
+                );
+        }
+
+        // Terminate traversal if the node stack is empty.
+        if (stack_ptr == stack)
+            break;
+
+        // Pop the top node from the stack.
+        entry = *--stack_ptr;
+    }
+
+    // Store traversal statistics.
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_visited_nodes.insert(visited_nodes));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_visited_leaves.insert(visited_leaves));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_bboxes.insert(intersected_bboxes));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_discarded_nodes.insert(discarded_nodes));
+}
+
+#if defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 7)))
+#pragma GCC diagnostic pop
+#endif
+
+}   // namespace bvh
+}   // namespace foundation
@@ -0,0 +1,422 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/utility/job/ijob.h"
+#include "foundation/utility/job/jobqueue.h"
+#include "foundation/utility/stopwatch.h"
+
+// Boost headers.
+#include "boost/atomic/atomic.hpp"
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace foundation {
+namespace bvh {
+
+//
+// BVH builder building independent subtrees concurrently.
+//
+// The top of the tree is built by the calling thread until sets of items become
+// small enough. The subtrees below are then built in parallel by the worker threads
+// servicing the job queue and by the calling thread itself. The resulting tree is
+// identical to the one built by foundation::bvh::Builder, up to the order of nodes.
+//
+// The calling thread never waits for a job that hasn't started, hence build() may
+// be called from a job of the same job queue, or with a job queue that isn't being
+// serviced at all (in which case the tree is built entirely by the calling thread).
+//
+// The Partitioner class must conform to the prototype of foundation::bvh::Builder.
+// In addition, partition() must support concurrent calls on disjoint sets of items
+// when each set contains at most half of all items.
+//
+
+template <typename Tree, typename Partitioner>
+class ParallelBuilder
+  : public NonCopyable
+{
+  public:
+    // Constructor.
+    ParallelBuilder();
+
+    // Build a tree.
+    template <typename Timer>
+    void build(
+        Tree&           tree,
+        Partitioner&    partitioner,
+        const size_t    size,
+        const size_t    items_per_leaf_hint,
+        JobQueue&       job_queue);
+
+    // Return the construction time.
+    double get_build_time() const;
+
+    // Return the number of subtrees built in parallel.
+    size_t get_subtree_count() const;
+
+  private:
+    typedef typename Tree::NodeVectorType NodeVectorType;
+    typedef typename Tree::NodeType NodeType;
+    typedef typename NodeType::AABBType AABBType;
+
+    // Subtrees smaller than this are not worth a task of their own.
+    static const size_t MinSubtreeSize = 4096;
+
+    // Number of subtrees per job queue lane, for load balancing.
+    static const size_t SubtreesPerLane = 8;
+
+    struct Subtree
+    {
+        size_t          m_node_index;       // index in the tree of the root node of the subtree
+        size_t          m_begin;
+        size_t          m_end;
+        AABBType        m_bbox;
+        NodeVectorType  m_nodes;            // nodes of the subtree, root node first
+
+        Subtree(
+            const size_t    node_index,
+            const size_t    begin,
+            const size_t    end,
+            const AABBType& bbox,
+            const typename NodeVectorType::allocator_type& allocator)
+          : m_node_index(node_index)
+          , m_begin(begin)
+          , m_end(end)
+          , m_bbox(bbox)
+          , m_nodes(allocator)
+        {
+        }
+    };
+
+    typedef std::vector<Subtree> SubtreeVector;
+
+    // State shared between the calling thread and the jobs. Jobs may outlive build()
+    // if they start late, hence they only touch the partitioner while subtrees remain.
+    struct SharedState
+    {
+        Partitioner&                m_partitioner;
+        SubtreeVector               m_subtrees;
+        boost::atomic<size_t>       m_next_subtree;
+        boost::mutex                m_mutex;
+        boost::condition_variable   m_all_subtrees_built;
+        size_t                      m_built_subtree_count;
+
+        explicit SharedState(Partitioner& partitioner)
+          : m_partitioner(partitioner)
+          , m_next_subtree(0)
+          , m_built_subtree_count(0)
+        {
+        }
+    };
+
+    class SubtreeJob
+      : public IJob
+    {
+      public:
+        explicit SubtreeJob(const std::shared_ptr<SharedState>& state)
+          : m_state(state)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            build_subtrees(*m_state);
+        }
+
+      private:
+        const std::shared_ptr<SharedState> m_state;
+    };
+
+    double m_build_time;
+    size_t m_subtree_count;
+
+    // Build subtrees until none are left.
+    static void build_subtrees(SharedState& state);
+
+    // Recursively subdivide the tree. Sets of at most max_subtree_size items are
+    // stored into 'subtrees' instead of being subdivided, unless 'subtrees' is null.
+    static void subdivide_recurse(
+        NodeVectorType& nodes,
+        Partitioner&    partitioner,
+        const size_t    node_index,
+        const size_t    begin,
+        const size_t    end,
+        const AABBType& bbox,
+        const size_t    max_subtree_size,
+        SubtreeVector*  subtrees);
+
+    // Move the nodes of a subtree into the tree.
+    static void insert_subtree(
+        NodeVectorType& nodes,
+        const Subtree&  subtree);
+};
+
+
+//
+// ParallelBuilder class implementation.
+//
+
+template <typename Tree, typename Partitioner>
+ParallelBuilder<Tree, Partitioner>::ParallelBuilder()
+  : m_build_time(0.0)
+  , m_subtree_count(0)
+{
+}
+
+template <typename Tree, typename Partitioner>
+template <typename Timer>
+void ParallelBuilder<Tree, Partitioner>::build(
+    Tree&               tree,
+    Partitioner&        partitioner,
+    const size_t        size,
+    const size_t        items_per_leaf_hint,
+    JobQueue&           job_queue)
+{
+    // Start stopwatch.
+    Stopwatch<Timer> stopwatch;
+    stopwatch.start();
+
+    // Clear the tree.
+    tree.m_nodes.clear();
+
+    // Reserve memory for the nodes.
+    const size_t leaf_count_guess = size / items_per_leaf_hint;
+    const size_t node_count_guess = leaf_count_guess > 0 ? 2 * leaf_count_guess - 1 : 0;
+    tree.m_nodes.reserve(node_count_guess);
+
+    // Create the root node of the tree.
+    tree.m_nodes.push_back(NodeType());
+
+    // Compute the bounding box of the tree.
+    const AABBType root_bbox(partitioner.compute_bbox(0, size));
+
+    // Only build subtrees in parallel if there is enough work for several threads.
+    const size_t lane_count = job_queue.get_lane_count();
+    const bool parallel = lane_count > 1 && size >= 2 * MinSubtreeSize;
+    const size_t max_subtree_size =
+        parallel ? std::max(size / (lane_count * SubtreesPerLane), MinSubtreeSize) : size;
+    assert(!parallel || max_subtree_size <= size / 2);
+
+    // Build the top of the tree.
+    const std::shared_ptr<SharedState> state(new SharedState(partitioner));
+    subdivide_recurse(
+        tree.m_nodes,
+        partitioner,
+        0,              // node index
+        0,              // begin
+        size,           // end
+        root_bbox,
+        max_subtree_size,
+        parallel ? &state->m_subtrees : nullptr);
+
+    m_subtree_count = state->m_subtrees.size();
+
+    if (m_subtree_count > 0)
+    {
+        // Let worker threads help building the subtrees.
+        const size_t job_count = std::min(lane_count, m_subtree_count) - 1;
+        for (size_t i = 0; i < job_count; ++i)
+            job_queue.schedule(new SubtreeJob(state));
+
+        // Build subtrees on the calling thread as well.
+        build_subtrees(*state);
+
+        // Wait until subtrees picked up by other threads are built.
+        boost::mutex::scoped_lock lock(state->m_mutex);
+        while (state->m_built_subtree_count < m_subtree_count)
+            state->m_all_subtrees_built.wait(lock);
+    }
+
+    // Move the subtrees into the tree.
+    for (size_t i = 0; i < m_subtree_count; ++i)
+        insert_subtree(tree.m_nodes, state->m_subtrees[i]);
+
+    // Measure and save construction time.
+    stopwatch.measure();
+    m_build_time = stopwatch.get_seconds();
+}
+
+template <typename Tree, typename Partitioner>
+inline double ParallelBuilder<Tree, Partitioner>::get_build_time() const
+{
+    return m_build_time;
+}
+
+template <typename Tree, typename Partitioner>
+inline size_t ParallelBuilder<Tree, Partitioner>::get_subtree_count() const
+{
+    return m_subtree_count;
+}
+
+template <typename Tree, typename Partitioner>
+void ParallelBuilder<Tree, Partitioner>::build_subtrees(SharedState& state)
+{
+    const size_t subtree_count = state.m_subtrees.size();
+
+    while (true)
+    {
+        const size_t subtree_index = state.m_next_subtree++;
+        if (subtree_index >= subtree_count)
+            break;
+
+        Subtree& subtree = state.m_subtrees[subtree_index];
+
+        subtree.m_nodes.push_back(NodeType());
+        subdivide_recurse(
+            subtree.m_nodes,
+            state.m_partitioner,
+            0,
+            subtree.m_begin,
+            subtree.m_end,
+            subtree.m_bbox,
+            subtree.m_end - subtree.m_begin,
+            nullptr);
+
+        boost::mutex::scoped_lock lock(state.m_mutex);
+        if (++state.m_built_subtree_count == subtree_count)
+            state.m_all_subtrees_built.notify_all();
+    }
+}
+
+template <typename Tree, typename Partitioner>
+void ParallelBuilder<Tree, Partitioner>::subdivide_recurse(
+    NodeVectorType&     nodes,
+    Partitioner&        partitioner,
+    const size_t        node_index,
+    const size_t        begin,
+    const size_t        end,
+    const AABBType&     bbox,
+    const size_t        max_subtree_size,
+    SubtreeVector*      subtrees)
+{
+    assert(node_index < nodes.size());
+
+    // Defer the construction of small enough subtrees.
+    if (subtrees && end - begin <= max_subtree_size)
+    {
+        subtrees->push_back(Subtree(node_index, begin, end, bbox, nodes.get_allocator()));
+        return;
+    }
+
+    // Try to partition the set of items.
+    size_t pivot = end;
+    if (end - begin > 1)
+    {
+        pivot = partitioner.partition(begin, end, typename Partitioner::AABBType(bbox));
+        assert(pivot > begin);
+        assert(pivot <= end);
+    }
+
+    if (pivot == end)
+    {
+        // Turn the current node into a leaf node.
+        NodeType& node = nodes[node_index];
+        node.make_leaf();
+        node.set_item_index(begin);
+        node.set_item_count(end - begin);
+    }
+    else
+    {
+        // Compute the bounding box of the child nodes.
+        const AABBType left_bbox(partitioner.compute_bbox(begin, pivot));
+        const AABBType right_bbox(partitioner.compute_bbox(pivot, end));
+
+        // Compute the indices of the child nodes.
+        const size_t left_node_index = nodes.size();
+        const size_t right_node_index = left_node_index + 1;
+
+        // Turn the current node into an interior node.
+        NodeType& node = nodes[node_index];
+        node.make_interior();
+        node.set_left_bbox(left_bbox);
+        node.set_right_bbox(right_bbox);
+        node.set_child_node_index(left_node_index);
+
+        // Create the child nodes.
+        nodes.push_back(NodeType());
+        nodes.push_back(NodeType());
+
+        // Recurse into the left subtree.
+        subdivide_recurse(
+            nodes,
+            partitioner,
+            left_node_index,
+            begin,
+            pivot,
+            left_bbox,
+            max_subtree_size,
+            subtrees);
+
+        // Recurse into the right subtree.
+        subdivide_recurse(
+            nodes,
+            partitioner,
+            right_node_index,
+            pivot,
+            end,
+            right_bbox,
+            max_subtree_size,
+            subtrees);
+    }
+}
+
+template <typename Tree, typename Partitioner>
+void ParallelBuilder<Tree, Partitioner>::insert_subtree(
+    NodeVectorType&     nodes,
+    const Subtree&      subtree)
+{
+    // The root node of the subtree replaces the placeholder node in the tree,
+    // the other nodes are appended to the tree.
+    const size_t offset = nodes.size() - 1;
+
+    for (size_t i = 0, e = subtree.m_nodes.size(); i < e; ++i)
+    {
+        NodeType node = subtree.m_nodes[i];
+
+        if (node.is_interior())
+            node.set_child_node_index(offset + node.get_child_node_index());
+
+        if (i == 0)
+            nodes[subtree.m_node_index] = node;
+        else nodes.push_back(node);
+    }
+}
+
+}   // namespace bvh
+}   // namespace foundation
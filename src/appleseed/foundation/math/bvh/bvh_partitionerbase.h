@@ -46,6 +46,9 @@ namespace bvh {
 //
 // A base class for BVH partitioners.
 //
+// Disjoint sets of items may be sorted concurrently as long as each set contains
+// at most half of all items (see foundation::bvh::ParallelBuilder).
+//
 
 template <typename AABBVector>
 class PartitionerBase
@@ -0,0 +1,416 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/aabb.h"
+#include "foundation/utility/job/ijob.h"
+#include "foundation/utility/job/jobqueue.h"
+#include "foundation/utility/stopwatch.h"
+
+// Boost headers.
+#include "boost/atomic/atomic.hpp"
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace foundation {
+namespace bvh {
+
+//
+// Recompute the bounding boxes of a BVH bottom-up while keeping its topology,
+// typically after the items of the tree have moved.
+//
+// The bounding box of a leaf is returned by a functor with the prototype
+//
+//   AABBType operator()(const NodeType& leaf) const;
+//
+// which must support concurrent calls. The top of the tree is split into subtrees
+// that are refit in parallel by the worker threads servicing the job queue and by
+// the calling thread itself, as in foundation::bvh::ParallelBuilder. The nodes above
+// the subtrees are then refit by the calling thread.
+//
+// Only trees with a single bounding box per child node (no motion bounding boxes)
+// can be refit.
+//
+
+template <typename Tree>
+class Refitter
+  : public NonCopyable
+{
+  public:
+    typedef typename Tree::NodeType NodeType;
+    typedef typename NodeType::AABBType AABBType;
+    typedef typename AABBType::ValueType ValueType;
+
+    // Constructor.
+    Refitter();
+
+    // Refit a tree and return the bounding box of its root node.
+    template <typename Timer, typename LeafBBoxFunc>
+    AABBType refit(
+        Tree&               tree,
+        const LeafBBoxFunc& leaf_bbox_func,
+        JobQueue&           job_queue);
+
+    // Return the refitting time.
+    double get_refit_time() const;
+
+    // Return the number of subtrees refit in parallel.
+    size_t get_subtree_count() const;
+
+    // Compute the surface area heuristic cost of a tree, relative to the surface area
+    // of its root node. Comparing the cost of a tree before and after refitting tells
+    // how much its quality has degraded.
+    static ValueType compute_sah_cost(
+        const Tree&         tree,
+        const AABBType&     root_bbox,
+        const ValueType     interior_node_traversal_cost,
+        const ValueType     item_intersection_cost);
+
+  private:
+    typedef typename Tree::NodeVectorType NodeVectorType;
+
+    // Trees smaller than this are refit by the calling thread only.
+    static const size_t MinParallelNodeCount = 8192;
+
+    // Number of subtrees per job queue lane, for load balancing.
+    static const size_t SubtreesPerLane = 8;
+
+    // State shared between the calling thread and the jobs.
+    template <typename LeafBBoxFunc>
+    struct SharedState
+    {
+        NodeVectorType&             m_nodes;
+        const LeafBBoxFunc&         m_leaf_bbox_func;
+        std::vector<size_t>         m_subtree_roots;
+        std::vector<AABBType>       m_subtree_bboxes;
+        boost::atomic<size_t>       m_next_subtree;
+        boost::mutex                m_mutex;
+        boost::condition_variable   m_all_subtrees_refit;
+        size_t                      m_refit_subtree_count;
+
+        SharedState(
+            NodeVectorType&         nodes,
+            const LeafBBoxFunc&     leaf_bbox_func)
+          : m_nodes(nodes)
+          , m_leaf_bbox_func(leaf_bbox_func)
+          , m_next_subtree(0)
+          , m_refit_subtree_count(0)
+        {
+        }
+    };
+
+    // Jobs only hold a reference to the state since refit() waits for all subtrees,
+    // including those picked up by jobs, and jobs that start late find no work left.
+    template <typename LeafBBoxFunc>
+    class SubtreeJob
+      : public IJob
+    {
+      public:
+        explicit SubtreeJob(const std::shared_ptr<SharedState<LeafBBoxFunc>>& state)
+          : m_state(state)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            refit_subtrees(*m_state);
+        }
+
+      private:
+        const std::shared_ptr<SharedState<LeafBBoxFunc>> m_state;
+    };
+
+    double m_refit_time;
+    size_t m_subtree_count;
+
+    // Refit subtrees until none are left.
+    template <typename LeafBBoxFunc>
+    static void refit_subtrees(SharedState<LeafBBoxFunc>& state);
+
+    // Recursively refit a subtree and return the bounding box of its root node.
+    template <typename LeafBBoxFunc>
+    static AABBType refit_recurse(
+        NodeVectorType&     nodes,
+        const LeafBBoxFunc& leaf_bbox_func,
+        const size_t        node_index);
+
+    static ValueType compute_sah_cost_recurse(
+        const Tree&         tree,
+        const size_t        node_index,
+        const ValueType     interior_node_traversal_cost,
+        const ValueType     item_intersection_cost);
+};
+
+
+//
+// Refitter class implementation.
+//
+
+template <typename Tree>
+Refitter<Tree>::Refitter()
+  : m_refit_time(0.0)
+  , m_subtree_count(0)
+{
+}
+
+template <typename Tree>
+template <typename Timer, typename LeafBBoxFunc>
+typename Refitter<Tree>::AABBType Refitter<Tree>::refit(
+    Tree&                   tree,
+    const LeafBBoxFunc&     leaf_bbox_func,
+    JobQueue&               job_queue)
+{
+    assert(!tree.m_nodes.empty());
+    assert(tree.m_node_bboxes.empty());
+
+    // Start stopwatch.
+    Stopwatch<Timer> stopwatch;
+    stopwatch.start();
+
+    const std::shared_ptr<SharedState<LeafBBoxFunc>> state(
+        new SharedState<LeafBBoxFunc>(tree.m_nodes, leaf_bbox_func));
+
+    // Only refit subtrees in parallel if there is enough work for several threads.
+    const size_t lane_count = job_queue.get_lane_count();
+    const bool parallel = lane_count > 1 && tree.m_nodes.size() >= MinParallelNodeCount;
+    const size_t max_subtree_count = parallel ? lane_count * SubtreesPerLane : 1;
+
+    // Open the top of the tree level by level until there are enough subtrees.
+    // The interior nodes that were opened are stored in breadth-first order.
+    std::vector<size_t> top_nodes;
+    state->m_subtree_roots.push_back(0);
+    while (state->m_subtree_roots.size() < max_subtree_count)
+    {
+        std::vector<size_t> next_roots;
+
+        for (size_t i = 0, e = state->m_subtree_roots.size(); i < e; ++i)
+        {
+            const size_t node_index = state->m_subtree_roots[i];
+            const NodeType& node = tree.m_nodes[node_index];
+
+            if (node.is_interior())
+            {
+                top_nodes.push_back(node_index);
+                next_roots.push_back(node.get_child_node_index());
+                next_roots.push_back(node.get_child_node_index() + 1);
+            }
+            else next_roots.push_back(node_index);
+        }
+
+        if (next_roots.size() == state->m_subtree_roots.size())
+            break;
+
+        state->m_subtree_roots.swap(next_roots);
+    }
+
+    m_subtree_count = state->m_subtree_roots.size();
+    state->m_subtree_bboxes.resize(m_subtree_count);
+
+    // Let worker threads help refitting the subtrees.
+    const size_t job_count = std::min(lane_count, m_subtree_count) - 1;
+    for (size_t i = 0; parallel && i < job_count; ++i)
+        job_queue.schedule(new SubtreeJob<LeafBBoxFunc>(state));
+
+    // Refit subtrees on the calling thread as well.
+    refit_subtrees(*state);
+
+    // Wait until subtrees picked up by other threads are refit.
+    {
+        boost::mutex::scoped_lock lock(state->m_mutex);
+        while (state->m_refit_subtree_count < m_subtree_count)
+            state->m_all_subtrees_refit.wait(lock);
+    }
+
+    // Refit the top of the tree, children first.
+    std::map<size_t, AABBType> node_bboxes;
+    for (size_t i = 0; i < m_subtree_count; ++i)
+        node_bboxes[state->m_subtree_roots[i]] = state->m_subtree_bboxes[i];
+    for (size_t i = top_nodes.size(); i > 0; --i)
+    {
+        const size_t node_index = top_nodes[i - 1];
+        NodeType& node = tree.m_nodes[node_index];
+
+        const AABBType& left_bbox = node_bboxes[node.get_child_node_index()];
+        const AABBType& right_bbox = node_bboxes[node.get_child_node_index() + 1];
+
+        node.set_left_bbox(left_bbox);
+        node.set_right_bbox(right_bbox);
+
+        AABBType bbox(left_bbox);
+        bbox.insert(right_bbox);
+        node_bboxes[node_index] = bbox;
+    }
+
+    // Measure and save refitting time.
+    stopwatch.measure();
+    m_refit_time = stopwatch.get_seconds();
+
+    return node_bboxes[0];
+}
+
+template <typename Tree>
+inline double Refitter<Tree>::get_refit_time() const
+{
+    return m_refit_time;
+}
+
+template <typename Tree>
+inline size_t Refitter<Tree>::get_subtree_count() const
+{
+    return m_subtree_count;
+}
+
+template <typename Tree>
+typename Refitter<Tree>::ValueType Refitter<Tree>::compute_sah_cost(
+    const Tree&             tree,
+    const AABBType&         root_bbox,
+    const ValueType         interior_node_traversal_cost,
+    const ValueType         item_intersection_cost)
+{
+    assert(!tree.m_nodes.empty());
+
+    const NodeType& root = tree.m_nodes[0];
+
+    if (root.is_leaf())
+        return static_cast<ValueType>(root.get_item_count()) * item_intersection_cost;
+
+    const ValueType root_area = half_surface_area(root_bbox);
+
+    if (root_area <= ValueType(0.0))
+        return interior_node_traversal_cost;
+
+    return
+          interior_node_traversal_cost
+        + compute_sah_cost_recurse(tree, 0, interior_node_traversal_cost, item_intersection_cost) / root_area;
+}
+
+template <typename Tree>
+template <typename LeafBBoxFunc>
+void Refitter<Tree>::refit_subtrees(SharedState<LeafBBoxFunc>& state)
+{
+    const size_t subtree_count = state.m_subtree_roots.size();
+
+    while (true)
+    {
+        const size_t subtree_index = state.m_next_subtree++;
+        if (subtree_index >= subtree_count)
+            break;
+
+        state.m_subtree_bboxes[subtree_index] =
+            refit_recurse(
+                state.m_nodes,
+                state.m_leaf_bbox_func,
+                state.m_subtree_roots[subtree_index]);
+
+        boost::mutex::scoped_lock lock(state.m_mutex);
+        if (++state.m_refit_subtree_count == subtree_count)
+            state.m_all_subtrees_refit.notify_all();
+    }
+}
+
+template <typename Tree>
+template <typename LeafBBoxFunc>
+typename Refitter<Tree>::AABBType Refitter<Tree>::refit_recurse(
+    NodeVectorType&         nodes,
+    const LeafBBoxFunc&     leaf_bbox_func,
+    const size_t            node_index)
+{
+    NodeType& node = nodes[node_index];
+
+    if (node.is_leaf())
+        return leaf_bbox_func(static_cast<const NodeType&>(node));
+
+    assert(node.get_left_bbox_count() <= 1);
+    assert(node.get_right_bbox_count() <= 1);
+
+    const AABBType left_bbox = refit_recurse(nodes, leaf_bbox_func, node.get_child_node_index());
+    const AABBType right_bbox = refit_recurse(nodes, leaf_bbox_func, node.get_child_node_index() + 1);
+
+    node.set_left_bbox(left_bbox);
+    node.set_right_bbox(right_bbox);
+
+    AABBType bbox(left_bbox);
+    bbox.insert(right_bbox);
+
+    return bbox;
+}
+
+template <typename Tree>
+typename Refitter<Tree>::ValueType Refitter<Tree>::compute_sah_cost_recurse(
+    const Tree&             tree,
+    const size_t            node_index,
+    const ValueType         interior_node_traversal_cost,
+    const ValueType         item_intersection_cost)
+{
+    const NodeType& node = tree.m_nodes[node_index];
+    assert(node.is_interior());
+
+    ValueType cost(0.0);
+
+    for (size_t i = 0; i < 2; ++i)
+    {
+        const size_t child_node_index = node.get_child_node_index() + i;
+        const NodeType& child_node = tree.m_nodes[child_node_index];
+        const ValueType child_area =
+            half_surface_area(i == 0 ? node.get_left_bbox() : node.get_right_bbox());
+
+        if (child_node.is_leaf())
+        {
+            cost +=
+                child_area
+                * static_cast<ValueType>(child_node.get_item_count())
+                * item_intersection_cost;
+        }
+        else
+        {
+            cost +=
+                  child_area * interior_node_traversal_cost
+                + compute_sah_cost_recurse(
+                      tree,
+                      child_node_index,
+                      interior_node_traversal_cost,
+                      item_intersection_cost);
+        }
+    }
+
+    return cost;
+}
+
+}   // namespace bvh
+}   // namespace foundation
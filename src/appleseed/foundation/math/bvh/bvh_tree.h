@@ -62,15 +62,30 @@ class Tree
     template <typename Tree, typename Partitioner>
     friend class Builder;
 
+    template <typename Tree, typename Partitioner>
+    friend class ParallelBuilder;
+
     template <typename Tree, typename Partitioner>
     friend class SpatialBuilder;
 
+    template <typename Tree>
+    friend class Refitter;
+
     template <typename Tree>
     friend class TreeStatistics;
 
     template <typename Tree, typename Visitor, typename Ray, size_t StackSize, size_t N>
     friend class Intersector;
 
+    template <typename Tree, typename WideNodeVector>
+    friend class Collapser;
+
+    template <typename Tree, typename Visitor, typename Ray, size_t PacketSize, size_t StackSize>
+    friend class PacketIntersector;
+
+    template <typename Tree, typename WideNodeVector, typename Visitor, typename Ray, size_t StackSize>
+    friend class WideIntersector;
+
     typedef typename NodeType::AABBType AABBType;
     typedef std::vector<AABBType> AABBVector;
 
@@ -0,0 +1,423 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/bvh/bvh_intersector.h"
+#include "foundation/math/bvh/bvh_statistics.h"
+#include "foundation/math/ray.h"
+#ifdef APPLESEED_USE_SSE
+#include "foundation/platform/sse.h"
+#endif
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace foundation {
+namespace bvh {
+
+//
+// Wide BVH intersector.
+//
+// Traverses a wide BVH built by foundation::bvh::Collapser. All the children of a wide
+// node are tested against the ray at once (4 at a time with SSE, 8 at a time with AVX),
+// hit children are visited in front-to-back order, and the leaves are the leaf nodes of
+// the binary tree, so the Visitor class is the same as for foundation::bvh::Intersector.
+//
+// Only the static (no motion) case is supported.
+//
+
+template <
+    typename Tree,
+    typename WideNodeVector,
+    typename Visitor,
+    typename Ray,
+    size_t StackSize = 64
+>
+class WideIntersector
+  : public NonCopyable
+{
+  public:
+    typedef typename Tree::NodeType NodeType;
+    typedef typename WideNodeVector::value_type WideNodeType;
+    typedef typename WideNodeType::ValueType ValueType;
+    typedef Ray RayType;
+    typedef RayInfo<ValueType, 3> RayInfoType;
+
+    static_assert(WideNodeType::Dimension == 3, "foundation::bvh::WideIntersector only supports 3D trees");
+
+    // Intersect a ray with a given wide BVH without motion.
+    void intersect_no_motion(
+        const Tree&             tree,
+        const WideNodeVector&   wide_nodes,
+        const RayType&          ray,
+        const RayInfoType&      ray_info,
+        Visitor&                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , TraversalStatistics&  stats
+#endif
+        ) const;
+
+  private:
+    static const size_t Width = WideNodeType::Width;
+
+    struct StackEntry
+    {
+        std::uint32_t   m_index;
+        std::uint32_t   m_leaf;
+        float           m_tnear;
+    };
+
+    struct SinglePrecisionRay
+    {
+        float           m_org[3];
+        float           m_rcp_dir[3];
+        size_t          m_near[3];
+        size_t          m_far[3];
+        float           m_tmin;
+    };
+
+    // Convert a distance to single precision, rounding up and leaving some slack
+    // to compensate for the rounding errors of the single precision ray/box test.
+    static float widen_tmax(const ValueType tmax);
+
+    // Test the children of a wide node against the ray. Return the hit mask
+    // and store the entry distances of the hit children into 'tnear'.
+    static size_t intersect_children(
+        const WideNodeType&         node,
+        const SinglePrecisionRay&   ray,
+        const float                 tmax,
+        float                       tnear[]);
+};
+
+
+//
+// WideIntersector class implementation.
+//
+
+template <
+    typename Tree,
+    typename WideNodeVector,
+    typename Visitor,
+    typename Ray,
+    size_t StackSize
+>
+inline float WideIntersector<Tree, WideNodeVector, Visitor, Ray, StackSize>::widen_tmax(const ValueType tmax)
+{
+    const ValueType MaxFloat = static_cast<ValueType>(std::numeric_limits<float>::max());
+
+    return
+        tmax < MaxFloat
+            ? static_cast<float>(tmax) * (1.0f + 1.0e-6f)
+            : std::numeric_limits<float>::infinity();
+}
+
+template <
+    typename Tree,
+    typename WideNodeVector,
+    typename Visitor,
+    typename Ray,
+    size_t StackSize
+>
+inline size_t WideIntersector<Tree, WideNodeVector, Visitor, Ray, StackSize>::intersect_children(
+    const WideNodeType&         node,
+    const SinglePrecisionRay&   ray,
+    const float                 tmax,
+    float                       tnear[])
+{
+    size_t hits = 0;
+
+#if defined APPLESEED_USE_AVX
+
+    if (Width % 8 == 0)
+    {
+        const __m256 org_x = _mm256_set1_ps(ray.m_org[0]);
+        const __m256 org_y = _mm256_set1_ps(ray.m_org[1]);
+        const __m256 org_z = _mm256_set1_ps(ray.m_org[2]);
+        const __m256 rcp_dir_x = _mm256_set1_ps(ray.m_rcp_dir[0]);
+        const __m256 rcp_dir_y = _mm256_set1_ps(ray.m_rcp_dir[1]);
+        const __m256 rcp_dir_z = _mm256_set1_ps(ray.m_rcp_dir[2]);
+        const __m256 ray_tmin = _mm256_set1_ps(ray.m_tmin);
+        const __m256 ray_tmax = _mm256_set1_ps(tmax);
+
+        for (size_t i = 0; i < Width; i += 8)
+        {
+            const __m256 xl1 = _mm256_mul_ps(rcp_dir_x, _mm256_sub_ps(_mm256_loadu_ps(node.m_bbox_data[ray.m_near[0]] + i), org_x));
+            const __m256 xl2 = _mm256_mul_ps(rcp_dir_x, _mm256_sub_ps(_mm256_loadu_ps(node.m_bbox_data[ray.m_far[0]] + i), org_x));
+            const __m256 yl1 = _mm256_mul_ps(rcp_dir_y, _mm256_sub_ps(_mm256_loadu_ps(node.m_bbox_data[ray.m_near[1]] + i), org_y));
+            const __m256 yl2 = _mm256_mul_ps(rcp_dir_y, _mm256_sub_ps(_mm256_loadu_ps(node.m_bbox_data[ray.m_far[1]] + i), org_y));
+            const __m256 zl1 = _mm256_mul_ps(rcp_dir_z, _mm256_sub_ps(_mm256_loadu_ps(node.m_bbox_data[ray.m_near[2]] + i), org_z));
+            const __m256 zl2 = _mm256_mul_ps(rcp_dir_z, _mm256_sub_ps(_mm256_loadu_ps(node.m_bbox_data[ray.m_far[2]] + i), org_z));
+
+            // NaNs (0 * inf) are discarded by the ordering of the min/max operands.
+            const __m256 tmin = _mm256_max_ps(zl1, _mm256_max_ps(yl1, _mm256_max_ps(xl1, ray_tmin)));
+            const __m256 tmax8 = _mm256_min_ps(zl2, _mm256_min_ps(yl2, _mm256_min_ps(xl2, ray_tmax)));
+
+            _mm256_storeu_ps(tnear + i, tmin);
+            hits |= static_cast<size_t>(_mm256_movemask_ps(_mm256_cmp_ps(tmin, tmax8, _CMP_LE_OQ))) << i;
+        }
+
+        return hits;
+    }
+
+#endif
+
+#if defined APPLESEED_USE_SSE
+
+    if (Width % 4 == 0)
+    {
+        const __m128 org_x = _mm_set1_ps(ray.m_org[0]);
+        const __m128 org_y = _mm_set1_ps(ray.m_org[1]);
+        const __m128 org_z = _mm_set1_ps(ray.m_org[2]);
+        const __m128 rcp_dir_x = _mm_set1_ps(ray.m_rcp_dir[0]);
+        const __m128 rcp_dir_y = _mm_set1_ps(ray.m_rcp_dir[1]);
+        const __m128 rcp_dir_z = _mm_set1_ps(ray.m_rcp_dir[2]);
+        const __m128 ray_tmin = _mm_set1_ps(ray.m_tmin);
+        const __m128 ray_tmax = _mm_set1_ps(tmax);
+
+        for (size_t i = 0; i < Width; i += 4)
+        {
+            const __m128 xl1 = _mm_mul_ps(rcp_dir_x, _mm_sub_ps(_mm_loadu_ps(node.m_bbox_data[ray.m_near[0]] + i), org_x));
+            const __m128 xl2 = _mm_mul_ps(rcp_dir_x, _mm_sub_ps(_mm_loadu_ps(node.m_bbox_data[ray.m_far[0]] + i), org_x));
+            const __m128 yl1 = _mm_mul_ps(rcp_dir_y, _mm_sub_ps(_mm_loadu_ps(node.m_bbox_data[ray.m_near[1]] + i), org_y));
+            const __m128 yl2 = _mm_mul_ps(rcp_dir_y, _mm_sub_ps(_mm_loadu_ps(node.m_bbox_data[ray.m_far[1]] + i), org_y));
+            const __m128 zl1 = _mm_mul_ps(rcp_dir_z, _mm_sub_ps(_mm_loadu_ps(node.m_bbox_data[ray.m_near[2]] + i), org_z));
+            const __m128 zl2 = _mm_mul_ps(rcp_dir_z, _mm_sub_ps(_mm_loadu_ps(node.m_bbox_data[ray.m_far[2]] + i), org_z));
+
+            // NaNs (0 * inf) are discarded by the ordering of the min/max operands.
+            const __m128 tmin = _mm_max_ps(zl1, _mm_max_ps(yl1, _mm_max_ps(xl1, ray_tmin)));
+            const __m128 tmax4 = _mm_min_ps(zl2, _mm_min_ps(yl2, _mm_min_ps(xl2, ray_tmax)));
+
+            _mm_storeu_ps(tnear + i, tmin);
+            hits |= static_cast<size_t>(_mm_movemask_ps(_mm_cmple_ps(tmin, tmax4))) << i;
+        }
+
+        return hits;
+    }
+
+#endif
+
+    for (size_t i = 0; i < Width; ++i)
+    {
+        float tmin = ray.m_tmin;
+        float tmax1 = tmax;
+
+        for (size_t d = 0; d < 3; ++d)
+        {
+            const float t1 = (node.m_bbox_data[ray.m_near[d]][i] - ray.m_org[d]) * ray.m_rcp_dir[d];
+            const float t2 = (node.m_bbox_data[ray.m_far[d]][i] - ray.m_org[d]) * ray.m_rcp_dir[d];
+
+            // The comparisons are false for NaNs (0 * inf), which are thus discarded.
+            if (tmin < t1)
+                tmin = t1;
+            if (tmax1 > t2)
+                tmax1 = t2;
+        }
+
+        tnear[i] = tmin;
+
+        if (tmin <= tmax1)
+            hits |= size_t(1) << i;
+    }
+
+    return hits;
+}
+
+#if defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 7)))
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+template <
+    typename Tree,
+    typename WideNodeVector,
+    typename Visitor,
+    typename Ray,
+    size_t StackSize
+>
+void WideIntersector<Tree, WideNodeVector, Visitor, Ray, StackSize>::intersect_no_motion(
+    const Tree&                 tree,
+    const WideNodeVector&       wide_nodes,
+    const RayType&              ray,
+    const RayInfoType&          ray_info,
+    Visitor&                    visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , TraversalStatistics&      stats
+#endif
+    ) const
+{
+    // Make sure the tree was built.
+    assert(!tree.m_nodes.empty());
+
+    // Prepare the single precision version of the ray.
+    SinglePrecisionRay sp_ray;
+    for (size_t d = 0; d < 3; ++d)
+    {
+        sp_ray.m_org[d] = static_cast<float>(ray.m_org[d]);
+        sp_ray.m_rcp_dir[d] = static_cast<float>(ray_info.m_rcp_dir[d]);
+        sp_ray.m_near[d] = 2 * d + 1 - ray_info.m_sgn_dir[d];
+        sp_ray.m_far[d] = 2 * d + ray_info.m_sgn_dir[d];
+    }
+    sp_ray.m_tmin = static_cast<float>(ray.m_tmin);
+    if (sp_ray.m_tmin > 0.0f)
+        sp_ray.m_tmin *= 1.0f - 1.0e-6f;
+
+    // Node stack. Each wide node pushes at most Width - 1 entries.
+    StackEntry stack[StackSize * (Width - 1) + 1];
+    StackEntry* stack_ptr = stack;
+
+    // Current node. A tree whose root is a leaf has no wide node.
+    size_t node_index = 0;
+    bool node_is_leaf = wide_nodes.empty();
+
+    // Initialize traversal statistics.
+    FOUNDATION_BVH_TRAVERSAL_STATS(++stats.m_traversal_count);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t visited_nodes = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t visited_leaves = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t intersected_bboxes = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t discarded_nodes = 0);
+
+    // Traverse the tree and intersect leaf nodes.
+    ValueType ray_tmax = ray.m_tmax;
+    float sp_ray_tmax = widen_tmax(ray_tmax);
+    while (true)
+    {
+        // Fetch the node.
+        FOUNDATION_BVH_TRAVERSAL_STATS(++visited_nodes);
+
+        if (!node_is_leaf)
+        {
+            const WideNodeType& node = wide_nodes[node_index];
+            const size_t child_count = node.get_child_count();
+            FOUNDATION_BVH_TRAVERSAL_STATS(intersected_bboxes += child_count);
+
+            float tnear[Width];
+            const size_t hits = intersect_children(node, sp_ray, sp_ray_tmax, tnear);
+
+            // Gather the hit children, sorted by increasing entry distance.
+            size_t hit_children[Width];
+            size_t hit_count = 0;
+            for (size_t i = 0; i < child_count; ++i)
+            {
+                if (hits & (size_t(1) << i))
+                {
+                    size_t j = hit_count++;
+                    while (j > 0 && tnear[hit_children[j - 1]] > tnear[i])
+                    {
+                        hit_children[j] = hit_children[j - 1];
+                        --j;
+                    }
+                    hit_children[j] = i;
+                }
+            }
+
+            FOUNDATION_BVH_TRAVERSAL_STATS(discarded_nodes += child_count - hit_count);
+
+            if (hit_count > 0)
+            {
+                // Push the far child nodes to the stack, continue with the nearest child node.
+                for (size_t i = hit_count - 1; i > 0; --i)
+                {
+                    const size_t child = hit_children[i];
+                    stack_ptr->m_index = static_cast<std::uint32_t>(node.get_child_index(child));
+                    stack_ptr->m_leaf = node.is_leaf_child(child) ? 1 : 0;
+                    stack_ptr->m_tnear = tnear[child];
+                    ++stack_ptr;
+                }
+
+                node_index = node.get_child_index(hit_children[0]);
+                node_is_leaf = node.is_leaf_child(hit_children[0]);
+                continue;
+            }
+        }
+        else
+        {
+            // Visit the leaf.
+            FOUNDATION_BVH_TRAVERSAL_STATS(++visited_leaves);
+            ValueType distance;
+#ifndef NDEBUG
+            distance = ValueType(-1.0);
+#endif
+            const bool proceed =
+                visitor.visit(
+                    tree.m_nodes[node_index],
+                    ray,
+                    ray_info,
+                    distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                    , stats
+#endif
+                    );
+            assert(!proceed || distance >= ValueType(0.0));
+
+            // Terminate traversal if the visitor decided so.
+            if (!proceed)
+                break;
+
+            // Keep track of the distance to the closest intersection.
+            if (ray_tmax > distance)
+            {
+                ray_tmax = distance;
+                sp_ray_tmax = widen_tmax(ray_tmax);
+            }
+        }
+
+        // Pop the next node from the stack, skipping nodes beyond the closest intersection.
+        while (stack_ptr > stack && (stack_ptr - 1)->m_tnear > sp_ray_tmax)
+        {
+            FOUNDATION_BVH_TRAVERSAL_STATS(++discarded_nodes);
+            --stack_ptr;
+        }
+
+        // Terminate traversal if the node stack is empty.
+        if (stack_ptr == stack)
+            break;
+
+        --stack_ptr;
+        node_index = stack_ptr->m_index;
+        node_is_leaf = stack_ptr->m_leaf != 0;
+    }
+
+    // Store traversal statistics.
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_visited_nodes.insert(visited_nodes));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_visited_leaves.insert(visited_leaves));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_bboxes.insert(intersected_bboxes));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_discarded_nodes.insert(discarded_nodes));
+}
+
+#if defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 7)))
+#pragma GCC diagnostic pop
+#endif
+
+}   // namespace bvh
+}   // namespace foundation
@@ -0,0 +1,207 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/platform/compiler.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace foundation {
+namespace bvh {
+
+//
+// Interior node of a wide (4-ary or 8-ary) BVH.
+//
+// A wide node stores the bounding boxes of up to Width child nodes in structure-of-arrays
+// form, in single precision, so that all of them can be tested against a ray at once with
+// SSE or AVX instructions. Bounding boxes are rounded outward when converted to single
+// precision and slightly enlarged to account for the limited precision of the ray/box test.
+//
+// A child of a wide node is either another wide node or a leaf node of the binary tree the
+// wide tree was collapsed from (see foundation::bvh::Collapser). Leaves are not duplicated.
+//
+
+template <typename AABB, size_t W>
+class APPLESEED_ALIGN(64) WideNode
+{
+  public:
+    typedef AABB AABBType;
+    typedef typename AABBType::ValueType ValueType;
+
+    static const size_t Width = W;
+    static const size_t Dimension = AABBType::Dimension;
+
+    // Constructor, creates a node without children.
+    WideNode();
+
+    // Return the number of children of the node.
+    size_t get_child_count() const;
+
+    // Append a child node. 'index' is the index of a wide node if 'leaf' is false,
+    // or the index of a leaf node of the binary tree if 'leaf' is true.
+    void add_child(
+        const AABBType&     bbox,
+        const size_t        index,
+        const bool          leaf);
+
+    // Retrieve the (single precision) bounding box of a given child.
+    AABBType get_child_bbox(const size_t child) const;
+
+    // Return whether a given child is a leaf node of the binary tree.
+    bool is_leaf_child(const size_t child) const;
+
+    // Return the index of a given child.
+    size_t get_child_index(const size_t child) const;
+
+  private:
+    template <typename Tree, typename WideNodeVector, typename Visitor, typename Ray, size_t StackSize>
+    friend class WideIntersector;
+
+    // Bounding boxes of the children, m_bbox_data[2 * d + 0] is the lower bound along
+    // dimension d, m_bbox_data[2 * d + 1] the upper bound. Unused slots hold empty boxes.
+    APPLESEED_SIMD4_ALIGN float     m_bbox_data[2 * Dimension][Width];
+
+    std::uint32_t                   m_child_index[Width];
+    std::uint32_t                   m_leaf_mask;
+    std::uint32_t                   m_child_count;
+
+    static float round_down(const ValueType x);
+    static float round_up(const ValueType x);
+};
+
+
+//
+// WideNode class implementation.
+//
+
+template <typename AABB, size_t W>
+WideNode<AABB, W>::WideNode()
+  : m_leaf_mask(0)
+  , m_child_count(0)
+{
+    for (size_t d = 0; d < Dimension; ++d)
+    {
+        for (size_t i = 0; i < Width; ++i)
+        {
+            m_bbox_data[2 * d + 0][i] = std::numeric_limits<float>::max();
+            m_bbox_data[2 * d + 1][i] = -std::numeric_limits<float>::max();
+        }
+    }
+
+    for (size_t i = 0; i < Width; ++i)
+        m_child_index[i] = 0;
+}
+
+template <typename AABB, size_t W>
+inline size_t WideNode<AABB, W>::get_child_count() const
+{
+    return static_cast<size_t>(m_child_count);
+}
+
+template <typename AABB, size_t W>
+void WideNode<AABB, W>::add_child(
+    const AABBType&     bbox,
+    const size_t        index,
+    const bool          leaf)
+{
+    assert(m_child_count < Width);
+    assert(index <= 0xFFFFFFFFu);
+
+    const size_t child = m_child_count++;
+
+    for (size_t d = 0; d < Dimension; ++d)
+    {
+        // Enlarge the box by a tiny fraction of its magnitude to absorb the rounding
+        // errors of the single precision ray/box test (in particular on the ray origin).
+        const ValueType magnitude = std::max(std::abs(bbox.min[d]), std::abs(bbox.max[d]));
+        const ValueType eps = magnitude * ValueType(1.0e-6);
+
+        m_bbox_data[2 * d + 0][child] = round_down(bbox.min[d] - eps);
+        m_bbox_data[2 * d + 1][child] = round_up(bbox.max[d] + eps);
+    }
+
+    m_child_index[child] = static_cast<std::uint32_t>(index);
+
+    if (leaf)
+        m_leaf_mask |= 1UL << child;
+}
+
+template <typename AABB, size_t W>
+AABB WideNode<AABB, W>::get_child_bbox(const size_t child) const
+{
+    assert(child < m_child_count);
+
+    AABBType bbox;
+
+    for (size_t d = 0; d < Dimension; ++d)
+    {
+        bbox.min[d] = static_cast<ValueType>(m_bbox_data[2 * d + 0][child]);
+        bbox.max[d] = static_cast<ValueType>(m_bbox_data[2 * d + 1][child]);
+    }
+
+    return bbox;
+}
+
+template <typename AABB, size_t W>
+inline bool WideNode<AABB, W>::is_leaf_child(const size_t child) const
+{
+    assert(child < m_child_count);
+    return (m_leaf_mask & (1UL << child)) != 0;
+}
+
+template <typename AABB, size_t W>
+inline size_t WideNode<AABB, W>::get_child_index(const size_t child) const
+{
+    assert(child < m_child_count);
+    return static_cast<size_t>(m_child_index[child]);
+}
+
+template <typename AABB, size_t W>
+inline float WideNode<AABB, W>::round_down(const ValueType x)
+{
+    const float f = static_cast<float>(x);
+    return static_cast<ValueType>(f) > x ? std::nextafter(f, -std::numeric_limits<float>::max()) : f;
+}
+
+template <typename AABB, size_t W>
+inline float WideNode<AABB, W>::round_up(const ValueType x)
+{
+    const float f = static_cast<float>(x);
+    return static_cast<ValueType>(f) < x ? std::nextafter(f, std::numeric_limits<float>::max()) : f;
+}
+
+}   // namespace bvh
+}   // namespace foundation
@@ -37,13 +37,21 @@
 #include "foundation/math/permutation.h"
 #include "foundation/math/split.h"
 #include "foundation/math/vector.h"
+#include "foundation/utility/job/ijob.h"
+#include "foundation/utility/job/jobqueue.h"
 #include "foundation/utility/stopwatch.h"
 
+// Boost headers.
+#include "boost/atomic/atomic.hpp"
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
+
 // Standard headers.
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstring>
+#include <memory>
 #include <vector>
 
 namespace foundation {
@@ -75,6 +83,16 @@ class Builder
     void build_move_points(
         std::vector<VectorType>&    points);
 
+    // Like build_move_points() but independent subtrees are built concurrently by
+    // the worker threads servicing the job queue and by the calling thread. The
+    // resulting tree is identical to the one built by build_move_points(). The
+    // calling thread never waits for a job that hasn't started, hence the job
+    // queue doesn't need to be serviced.
+    template <typename Timer>
+    void build_move_points(
+        std::vector<VectorType>&    points,
+        JobQueue&                   job_queue);
+
     // Return the construction time.
     double get_build_time() const;
 
@@ -83,6 +101,59 @@ class Builder
     typedef AABB<T, N> BboxType;
     typedef Split<T> SplitType;
 
+    // Subtrees smaller than this are not worth a task of their own.
+    static const size_t MinSubtreeSize = 16384;
+
+    // Number of subtrees per job queue lane, for load balancing.
+    static const size_t SubtreesPerLane = 8;
+
+    struct Subtree
+    {
+        size_t                      m_node_index;
+        size_t                      m_first_child_index;
+        size_t                      m_begin;
+        size_t                      m_end;
+    };
+
+    typedef std::vector<Subtree> SubtreeVector;
+
+    // State shared between the calling thread and the jobs. Jobs may outlive the
+    // build if they start late, hence they only touch the builder while subtrees remain.
+    struct SharedState
+    {
+        const Builder&              m_builder;
+        SubtreeVector               m_subtrees;
+        boost::atomic<size_t>       m_next_subtree;
+        boost::mutex                m_mutex;
+        boost::condition_variable   m_all_subtrees_built;
+        size_t                      m_built_subtree_count;
+
+        explicit SharedState(const Builder& builder)
+          : m_builder(builder)
+          , m_next_subtree(0)
+          , m_built_subtree_count(0)
+        {
+        }
+    };
+
+    class SubtreeJob
+      : public IJob
+    {
+      public:
+        explicit SubtreeJob(const std::shared_ptr<SharedState>& state)
+          : m_state(state)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            build_subtrees(*m_state);
+        }
+
+      private:
+        const std::shared_ptr<SharedState> m_state;
+    };
+
     struct PartitionPredicate
     {
         typedef std::vector<VectorType> PointVector;
@@ -101,10 +172,28 @@ class Builder
     TreeType&   m_tree;
     double      m_build_time;
 
+    // Move the points into the tree and allocate its nodes.
+    void prepare(std::vector<VectorType>& points);
+
+    // Reorder the points according to the tree.
+    void reorder_points();
+
+    // Build subtrees until none are left.
+    static void build_subtrees(SharedState& state);
+
+    // Recursively partition a set of points. Since every leaf holds exactly one
+    // point (except in an empty tree), a subtree of n points always occupies
+    // 2n - 1 nodes: the descendants of the node at 'parent_node_index' are stored
+    // contiguously starting at 'first_child_index'. Sets of at most max_subtree_size
+    // points are stored into 'subtrees' instead of being partitioned, unless
+    // 'subtrees' is null.
     void partition(
         const size_t                parent_node_index,
+        const size_t                first_child_index,
         const size_t                begin,
-        const size_t                end) const;
+        const size_t                end,
+        const size_t                max_subtree_size = 0,
+        SubtreeVector*              subtrees = nullptr) const;
 
     BboxType compute_bbox(
         const size_t                begin,
@@ -153,34 +242,59 @@ void Builder<T, N>::build_move_points(
     Stopwatch<Timer> stopwatch;
     stopwatch.start();
 
-    const size_t count = points.size();
+    prepare(points);
 
-    if (count > 0)
-    {
-        m_tree.m_points.swap(points);
+    partition(0, 1, 0, m_tree.m_points.size());
 
-        m_tree.m_indices.resize(count);
+    reorder_points();
 
-        for (size_t i = 0; i < count; ++i)
-            m_tree.m_indices[i] = i;
-    }
+    stopwatch.measure();
+    m_build_time = stopwatch.get_seconds();
+}
 
-    m_tree.m_nodes.reserve(count * 2 + 1);
-    m_tree.m_nodes.push_back(NodeType());
+template <typename T, size_t N>
+template <typename Timer>
+void Builder<T, N>::build_move_points(
+    std::vector<VectorType>&    points,
+    JobQueue&                   job_queue)
+{
+    Stopwatch<Timer> stopwatch;
+    stopwatch.start();
 
-    partition(0, 0, count);
+    prepare(points);
 
-    if (count > 0)
-    {
-        std::vector<VectorType> temp(count);
+    const size_t count = m_tree.m_points.size();
 
-        small_item_reorder(
-            &m_tree.m_points[0],
-            &temp[0],
-            &m_tree.m_indices[0],
-            count);
+    // Only build subtrees in parallel if there is enough work for several threads.
+    const size_t lane_count = job_queue.get_lane_count();
+    const bool parallel = lane_count > 1 && count >= 2 * MinSubtreeSize;
+    const size_t max_subtree_size =
+        parallel ? std::max(count / (lane_count * SubtreesPerLane), MinSubtreeSize) : count;
+
+    // Build the top of the tree.
+    const std::shared_ptr<SharedState> state(new SharedState(*this));
+    partition(0, 1, 0, count, max_subtree_size, parallel ? &state->m_subtrees : nullptr);
+
+    const size_t subtree_count = state->m_subtrees.size();
+
+    if (subtree_count > 0)
+    {
+        // Let worker threads help building the subtrees.
+        const size_t job_count = std::min(lane_count, subtree_count) - 1;
+        for (size_t i = 0; i < job_count; ++i)
+            job_queue.schedule(new SubtreeJob(state));
+
+        // Build subtrees on the calling thread as well.
+        build_subtrees(*state);
+
+        // Wait until subtrees picked up by other threads are built.
+        boost::mutex::scoped_lock lock(state->m_mutex);
+        while (state->m_built_subtree_count < subtree_count)
+            state->m_all_subtrees_built.wait(lock);
     }
 
+    reorder_points();
+
     stopwatch.measure();
     m_build_time = stopwatch.get_seconds();
 }
@@ -208,14 +322,85 @@ inline bool Builder<T, N>::PartitionPredicate::operator()(
     return m_points[index][m_split.m_dimension] < m_split.m_abscissa;
 }
 
+template <typename T, size_t N>
+void Builder<T, N>::prepare(std::vector<VectorType>& points)
+{
+    const size_t count = points.size();
+
+    if (count > 0)
+    {
+        m_tree.m_points.swap(points);
+
+        m_tree.m_indices.resize(count);
+
+        for (size_t i = 0; i < count; ++i)
+            m_tree.m_indices[i] = i;
+    }
+
+    m_tree.m_nodes.clear();
+    m_tree.m_nodes.resize(count > 0 ? 2 * count - 1 : 1);
+}
+
+template <typename T, size_t N>
+void Builder<T, N>::reorder_points()
+{
+    const size_t count = m_tree.m_points.size();
+
+    if (count > 0)
+    {
+        std::vector<VectorType> temp(count);
+
+        small_item_reorder(
+            &m_tree.m_points[0],
+            &temp[0],
+            &m_tree.m_indices[0],
+            count);
+    }
+}
+
+template <typename T, size_t N>
+void Builder<T, N>::build_subtrees(SharedState& state)
+{
+    const size_t subtree_count = state.m_subtrees.size();
+
+    while (true)
+    {
+        const size_t subtree_index = state.m_next_subtree++;
+        if (subtree_index >= subtree_count)
+            break;
+
+        const Subtree& subtree = state.m_subtrees[subtree_index];
+        state.m_builder.partition(
+            subtree.m_node_index,
+            subtree.m_first_child_index,
+            subtree.m_begin,
+            subtree.m_end);
+
+        boost::mutex::scoped_lock lock(state.m_mutex);
+        if (++state.m_built_subtree_count == subtree_count)
+            state.m_all_subtrees_built.notify_all();
+    }
+}
+
 template <typename T, size_t N>
 void Builder<T, N>::partition(
     const size_t                parent_node_index,
+    const size_t                first_child_index,
     const size_t                begin,
-    const size_t                end) const
+    const size_t                end,
+    const size_t                max_subtree_size,
+    SubtreeVector*              subtrees) const
 {
     const size_t count = end - begin;
 
+    // Defer the construction of small enough subtrees.
+    if (subtrees && count <= max_subtree_size)
+    {
+        const Subtree subtree = { parent_node_index, first_child_index, begin, end };
+        subtrees->push_back(subtree);
+        return;
+    }
+
     if (count <= 1)
     {
         NodeType& parent_node = m_tree.m_nodes[parent_node_index];
@@ -245,11 +430,9 @@ void Builder<T, N>::partition(
         if (pivot == begin || pivot == end)
             pivot = (begin + end) / 2;
 
-        const size_t left_node_index = m_tree.m_nodes.size();
+        const size_t left_node_index = first_child_index;
         const size_t right_node_index = left_node_index + 1;
-
-        m_tree.m_nodes.push_back(NodeType());
-        m_tree.m_nodes.push_back(NodeType());
+        assert(right_node_index < m_tree.m_nodes.size());
 
         NodeType& parent_node = m_tree.m_nodes[parent_node_index];
         parent_node.make_interior();
@@ -259,8 +442,12 @@ void Builder<T, N>::partition(
         parent_node.set_point_index(begin);
         parent_node.set_point_count(count);
 
-        partition(left_node_index, begin, pivot);
-        partition(right_node_index, pivot, end);
+        // The descendants of the left child node come first.
+        const size_t left_descendants_index = right_node_index + 1;
+        const size_t right_descendants_index = left_descendants_index + 2 * (pivot - begin) - 2;
+
+        partition(left_node_index, left_descendants_index, begin, pivot, max_subtree_size, subtrees);
+        partition(right_node_index, right_descendants_index, pivot, end, max_subtree_size, subtrees);
     }
 }
 
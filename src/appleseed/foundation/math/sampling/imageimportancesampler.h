@@ -35,6 +35,7 @@
 #include "foundation/image/color.h"
 #include "foundation/image/colorspace.h"
 #include "foundation/image/image.h"
+#include "foundation/math/aliastable.h"
 #include "foundation/math/cdf.h"
 #include "foundation/math/scalar.h"
 #include "foundation/math/vector.h"
@@ -61,8 +62,17 @@ namespace foundation
 //           Importance&    importance);
 //   };
 //
+// Rows and pixels are selected using a Distribution, either foundation::CDF
+// (binary search per draw, monotonic in the input samples) or foundation::AliasTable
+// (constant time per draw, but neighboring input samples no longer map to
+// neighboring pixels).
+//
 
-template <typename Payload, typename Importance>
+template <
+    typename Payload,
+    typename Importance,
+    template <typename, typename> class Distribution = CDF
+>
 class ImageImportanceSampler
   : public NonCopyable
 {
@@ -83,6 +93,19 @@ class ImageImportanceSampler
         ImageSampler&       sampler,
         IAbortSwitch*       abort_switch = nullptr);
 
+    // Resample rows [begin_row, end_row) of the image and rebuild their CDFs.
+    // Disjoint ranges of rows may be rebuilt concurrently. Once all rows are
+    // rebuilt, rebuild_rows_cdf() must be called before the sampler is used.
+    template <typename ImageSampler>
+    void rebuild_rows(
+        ImageSampler&       sampler,
+        const size_t        begin_row,
+        const size_t        end_row,
+        IAbortSwitch*       abort_switch = nullptr);
+
+    // Rebuild the CDF used to select rows.
+    void rebuild_rows_cdf();
+
     // Sample the image and return the coordinates of the chosen pixel
     // and its probability density.
     void sample(
@@ -105,16 +128,21 @@ class ImageImportanceSampler
         const size_t        x,
         const size_t        y) const;
 
+    // Return the payload of a given pixel.
+    const Payload& get_payload(
+        const size_t        x,
+        const size_t        y) const;
+
   private:
-    typedef CDF<size_t, Importance> RowCDF;
-    typedef CDF<Payload, Importance> ColCDF;
+    typedef Distribution<size_t, Importance> RowDistribution;
+    typedef Distribution<Payload, Importance> ColDistribution;
 
     const size_t            m_width;
     const size_t            m_height;
     const Importance        m_rcp_pixel_count;
 
-    ColCDF*                 m_cols_cdf;
-    RowCDF                  m_rows_cdf;
+    ColDistribution*                 m_cols_cdf;
+    RowDistribution                  m_rows_cdf;
 };
 
 
@@ -140,39 +168,51 @@ class ImageSampler
 // ImageImportanceSampler class implementation.
 //
 
-template <typename Payload, typename Importance>
-ImageImportanceSampler<Payload, Importance>::ImageImportanceSampler(
+template <typename Payload, typename Importance, template <typename, typename> class Distribution>
+ImageImportanceSampler<Payload, Importance, Distribution>::ImageImportanceSampler(
     const size_t            width,
     const size_t            height)
   : m_width(width)
   , m_height(height)
   , m_rcp_pixel_count(Importance(1.0) / (width * height))
 {
-    m_cols_cdf = new ColCDF[m_height];
+    m_cols_cdf = new ColDistribution[m_height];
 }
 
-template <typename Payload, typename Importance>
-ImageImportanceSampler<Payload, Importance>::~ImageImportanceSampler()
+template <typename Payload, typename Importance, template <typename, typename> class Distribution>
+ImageImportanceSampler<Payload, Importance, Distribution>::~ImageImportanceSampler()
 {
     delete[] m_cols_cdf;
 }
 
-template <typename Payload, typename Importance>
+template <typename Payload, typename Importance, template <typename, typename> class Distribution>
 template <typename ImageSampler>
-void ImageImportanceSampler<Payload, Importance>::rebuild(
+void ImageImportanceSampler<Payload, Importance, Distribution>::rebuild(
     ImageSampler&           sampler,
     IAbortSwitch*           abort_switch)
 {
-    m_rows_cdf.clear();
-    m_rows_cdf.reserve(m_height);
+    rebuild_rows(sampler, 0, m_height, abort_switch);
 
-    for (size_t y = 0, ye = m_height; y < ye; ++y)
+    if (is_aborted(abort_switch))
+        m_rows_cdf.clear();
+    else rebuild_rows_cdf();
+}
+
+template <typename Payload, typename Importance, template <typename, typename> class Distribution>
+template <typename ImageSampler>
+void ImageImportanceSampler<Payload, Importance, Distribution>::rebuild_rows(
+    ImageSampler&           sampler,
+    const size_t            begin_row,
+    const size_t            end_row,
+    IAbortSwitch*           abort_switch)
+{
+    assert(begin_row <= end_row);
+    assert(end_row <= m_height);
+
+    for (size_t y = begin_row; y < end_row; ++y)
     {
         if (is_aborted(abort_switch))
-        {
-            m_rows_cdf.clear();
             break;
-        }
 
         m_cols_cdf[y].clear();
         m_cols_cdf[y].reserve(m_width);
@@ -189,16 +229,24 @@ void ImageImportanceSampler<Payload, Importance>::rebuild(
 
         if (m_cols_cdf[y].valid())
             m_cols_cdf[y].prepare();
+    }
+}
+
+template <typename Payload, typename Importance, template <typename, typename> class Distribution>
+void ImageImportanceSampler<Payload, Importance, Distribution>::rebuild_rows_cdf()
+{
+    m_rows_cdf.clear();
+    m_rows_cdf.reserve(m_height);
 
+    for (size_t y = 0, ye = m_height; y < ye; ++y)
         m_rows_cdf.insert(y, m_cols_cdf[y].weight());
-    }
 
     if (m_rows_cdf.valid())
         m_rows_cdf.prepare();
 }
 
-template <typename Payload, typename Importance>
-inline void ImageImportanceSampler<Payload, Importance>::sample(
+template <typename Payload, typename Importance, template <typename, typename> class Distribution>
+inline void ImageImportanceSampler<Payload, Importance, Distribution>::sample(
     const Vector2Type&      s,
     size_t&                 x,
     size_t&                 y,
@@ -207,12 +255,12 @@ inline void ImageImportanceSampler<Payload, Importance>::sample(
     if (m_rows_cdf.valid())
     {
         // Select a row.
-        const typename RowCDF::ItemWeightPair& row = m_rows_cdf.sample(s[1]);
+        const typename RowDistribution::ItemWeightPair& row = m_rows_cdf.sample(s[1]);
         assert(row.second != Importance(0.0));
         y = row.first;
 
         // Select a column within this row.
-        const typename ColCDF::ItemWeightPair& col = m_cols_cdf[y].sample(s[0]);
+        const typename ColDistribution::ItemWeightPair& col = m_cols_cdf[y].sample(s[0]);
         assert(col.second != Importance(0.0));
         x = &col - &m_cols_cdf[y][0];
 
@@ -230,8 +278,8 @@ inline void ImageImportanceSampler<Payload, Importance>::sample(
     assert(probability > Importance(0.0));
 }
 
-template <typename Payload, typename Importance>
-inline void ImageImportanceSampler<Payload, Importance>::sample(
+template <typename Payload, typename Importance, template <typename, typename> class Distribution>
+inline void ImageImportanceSampler<Payload, Importance, Distribution>::sample(
     const Vector2Type&      s,
     size_t&                 x,
     size_t&                 y,
@@ -241,12 +289,12 @@ inline void ImageImportanceSampler<Payload, Importance>::sample(
     if (m_rows_cdf.valid())
     {
         // Select a row.
-        const typename RowCDF::ItemWeightPair& row = m_rows_cdf.sample(s[1]);
+        const typename RowDistribution::ItemWeightPair& row = m_rows_cdf.sample(s[1]);
         assert(row.second != Importance(0.0));
         y = row.first;
 
         // Select a column within this row.
-        const typename ColCDF::ItemWeightPair& col = m_cols_cdf[y].sample(s[0]);
+        const typename ColDistribution::ItemWeightPair& col = m_cols_cdf[y].sample(s[0]);
         assert(col.second != Importance(0.0));
         x = &col - &m_cols_cdf[y][0];
 
@@ -266,8 +314,8 @@ inline void ImageImportanceSampler<Payload, Importance>::sample(
     assert(probability > Importance(0.0));
 }
 
-template <typename Payload, typename Importance>
-inline Importance ImageImportanceSampler<Payload, Importance>::get_pdf(
+template <typename Payload, typename Importance, template <typename, typename> class Distribution>
+inline Importance ImageImportanceSampler<Payload, Importance, Distribution>::get_pdf(
     const size_t            x,
     const size_t            y) const
 {
@@ -275,8 +323,8 @@ inline Importance ImageImportanceSampler<Payload, Importance>::get_pdf(
     {
         if (m_cols_cdf[y].valid())
         {
-            const typename RowCDF::ItemWeightPair& row = m_rows_cdf[y];
-            const typename ColCDF::ItemWeightPair& col = m_cols_cdf[y][x];
+            const typename RowDistribution::ItemWeightPair& row = m_rows_cdf[y];
+            const typename ColDistribution::ItemWeightPair& col = m_cols_cdf[y][x];
             return row.second * col.second;
         }
         else
@@ -290,6 +338,17 @@ inline Importance ImageImportanceSampler<Payload, Importance>::get_pdf(
     }
 }
 
+template <typename Payload, typename Importance, template <typename, typename> class Distribution>
+inline const Payload& ImageImportanceSampler<Payload, Importance, Distribution>::get_payload(
+    const size_t            x,
+    const size_t            y) const
+{
+    assert(x < m_width);
+    assert(y < m_height);
+
+    return m_cols_cdf[y][x].first;
+}
+
 
 //
 // ImageSampler class implementation.
@@ -0,0 +1,394 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/compiler.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace foundation
+{
+
+//
+// A sparse 3D grid of voxels.
+//
+// The grid is partitioned into bricks of BrickSize^3 voxels. Bricks are only
+// allocated when one of their voxels is written to; voxels of unallocated bricks
+// read as zero. The lookup methods follow the conventions of VoxelGrid3.
+//
+// Pointers returned by the non-const voxel() method are invalidated when a new
+// brick gets allocated.
+//
+
+template <typename ValueType, typename CoordType>
+class SparseVoxelGrid3
+  : public NonCopyable
+{
+  public:
+    // Types.
+    typedef Vector<CoordType, 3> PointType;
+
+    // Number of voxels along each side of a brick.
+    static const size_t BrickSize = 8;
+
+    // Constructor.
+    SparseVoxelGrid3(
+        const size_t        nx,
+        const size_t        ny,
+        const size_t        nz,
+        const size_t        channel_count);
+
+    // Get the grid properties.
+    size_t get_xres() const;
+    size_t get_yres() const;
+    size_t get_zres() const;
+    size_t get_channel_count() const;
+
+    // Get the number of bricks along each dimension.
+    size_t get_brick_xres() const;
+    size_t get_brick_yres() const;
+    size_t get_brick_zres() const;
+
+    // Return true if a given brick is allocated.
+    bool has_brick(
+        const size_t        bx,
+        const size_t        by,
+        const size_t        bz) const;
+
+    // Return the number of allocated bricks.
+    size_t get_allocated_brick_count() const;
+
+    // Return the size in bytes of the voxel storage.
+    size_t get_memory_size() const;
+
+    // Direct access to a given voxel. The non-const version allocates the
+    // enclosing brick if necessary; the const version returns zeros for
+    // voxels of unallocated bricks.
+    ValueType* voxel(
+        const size_t        x,
+        const size_t        y,
+        const size_t        z);
+    const ValueType* voxel(
+        const size_t        x,
+        const size_t        y,
+        const size_t        z) const;
+
+    // Perform an unfiltered lookup of the voxel grid.
+    // 'point' must be expressed in the unit cube [0,1]^3.
+    void nearest_lookup(
+        const PointType&    point,
+        ValueType*          values) const;
+
+    // Perform a trilinearly interpolated lookup of the voxel grid.
+    // 'point' must be expressed in the unit cube [0,1]^3.
+    void linear_lookup(
+        const PointType&    point,
+        ValueType*          values) const;
+
+  private:
+    static const std::uint32_t EmptyBrick = ~std::uint32_t(0);
+    static const size_t BrickVoxelCount = BrickSize * BrickSize * BrickSize;
+
+    const size_t                m_nx;
+    const size_t                m_ny;
+    const size_t                m_nz;
+    const CoordType             m_scalar_nx;
+    const CoordType             m_scalar_ny;
+    const CoordType             m_scalar_nz;
+    const CoordType             m_max_x;
+    const CoordType             m_max_y;
+    const CoordType             m_max_z;
+    const size_t                m_channel_count;
+    const size_t                m_brick_nx;
+    const size_t                m_brick_ny;
+    const size_t                m_brick_nz;
+    const size_t                m_brick_value_count;
+    std::vector<std::uint32_t>  m_brick_indices;        // index of each brick in m_values, or EmptyBrick
+    std::vector<ValueType>      m_values;               // allocated bricks, stored contiguously
+    std::vector<ValueType>      m_empty_voxel;          // values of the voxels of unallocated bricks
+
+    size_t brick_index(
+        const size_t        x,
+        const size_t        y,
+        const size_t        z) const;
+
+    size_t voxel_offset(
+        const size_t        x,
+        const size_t        y,
+        const size_t        z) const;
+};
+
+
+//
+// SparseVoxelGrid3 class implementation.
+//
+
+template <typename ValueType, typename CoordType>
+SparseVoxelGrid3<ValueType, CoordType>::SparseVoxelGrid3(
+    const size_t            nx,
+    const size_t            ny,
+    const size_t            nz,
+    const size_t            channel_count)
+  : m_nx(nx)
+  , m_ny(ny)
+  , m_nz(nz)
+  , m_scalar_nx(static_cast<CoordType>(nx))
+  , m_scalar_ny(static_cast<CoordType>(ny))
+  , m_scalar_nz(static_cast<CoordType>(nz))
+  , m_max_x(static_cast<CoordType>(nx - 1))
+  , m_max_y(static_cast<CoordType>(ny - 1))
+  , m_max_z(static_cast<CoordType>(nz - 1))
+  , m_channel_count(channel_count)
+  , m_brick_nx((nx + BrickSize - 1) / BrickSize)
+  , m_brick_ny((ny + BrickSize - 1) / BrickSize)
+  , m_brick_nz((nz + BrickSize - 1) / BrickSize)
+  , m_brick_value_count(BrickVoxelCount * channel_count)
+  , m_brick_indices(m_brick_nx * m_brick_ny * m_brick_nz, static_cast<std::uint32_t>(EmptyBrick))
+  , m_empty_voxel(channel_count, ValueType(0.0))
+{
+    assert(m_nx > 0);
+    assert(m_ny > 0);
+    assert(m_nz > 0);
+    assert(m_channel_count > 0);
+}
+
+template <typename ValueType, typename CoordType>
+APPLESEED_FORCE_INLINE size_t SparseVoxelGrid3<ValueType, CoordType>::get_xres() const
+{
+    return m_nx;
+}
+
+template <typename ValueType, typename CoordType>
+APPLESEED_FORCE_INLINE size_t SparseVoxelGrid3<ValueType, CoordType>::get_yres() const
+{
+    return m_ny;
+}
+
+template <typename ValueType, typename CoordType>
+APPLESEED_FORCE_INLINE size_t SparseVoxelGrid3<ValueType, CoordType>::get_zres() const
+{
+    return m_nz;
+}
+
+template <typename ValueType, typename CoordType>
+APPLESEED_FORCE_INLINE size_t SparseVoxelGrid3<ValueType, CoordType>::get_channel_count() const
+{
+    return m_channel_count;
+}
+
+template <typename ValueType, typename CoordType>
+APPLESEED_FORCE_INLINE size_t SparseVoxelGrid3<ValueType, CoordType>::get_brick_xres() const
+{
+    return m_brick_nx;
+}
+
+template <typename ValueType, typename CoordType>
+APPLESEED_FORCE_INLINE size_t SparseVoxelGrid3<ValueType, CoordType>::get_brick_yres() const
+{
+    return m_brick_ny;
+}
+
+template <typename ValueType, typename CoordType>
+APPLESEED_FORCE_INLINE size_t SparseVoxelGrid3<ValueType, CoordType>::get_brick_zres() const
+{
+    return m_brick_nz;
+}
+
+template <typename ValueType, typename CoordType>
+inline bool SparseVoxelGrid3<ValueType, CoordType>::has_brick(
+    const size_t            bx,
+    const size_t            by,
+    const size_t            bz) const
+{
+    assert(bx < m_brick_nx);
+    assert(by < m_brick_ny);
+    assert(bz < m_brick_nz);
+    return m_brick_indices[(bz * m_brick_ny + by) * m_brick_nx + bx] != EmptyBrick;
+}
+
+template <typename ValueType, typename CoordType>
+inline size_t SparseVoxelGrid3<ValueType, CoordType>::get_allocated_brick_count() const
+{
+    return m_values.size() / m_brick_value_count;
+}
+
+template <typename ValueType, typename CoordType>
+inline size_t SparseVoxelGrid3<ValueType, CoordType>::get_memory_size() const
+{
+    return
+        m_brick_indices.capacity() * sizeof(std::uint32_t) +
+        m_values.capacity() * sizeof(ValueType);
+}
+
+template <typename ValueType, typename CoordType>
+APPLESEED_FORCE_INLINE size_t SparseVoxelGrid3<ValueType, CoordType>::brick_index(
+    const size_t            x,
+    const size_t            y,
+    const size_t            z) const
+{
+    assert(x < m_nx);
+    assert(y < m_ny);
+    assert(z < m_nz);
+    return ((z / BrickSize) * m_brick_ny + y / BrickSize) * m_brick_nx + x / BrickSize;
+}
+
+template <typename ValueType, typename CoordType>
+APPLESEED_FORCE_INLINE size_t SparseVoxelGrid3<ValueType, CoordType>::voxel_offset(
+    const size_t            x,
+    const size_t            y,
+    const size_t            z) const
+{
+    const size_t lx = x % BrickSize;
+    const size_t ly = y % BrickSize;
+    const size_t lz = z % BrickSize;
+    return ((lz * BrickSize + ly) * BrickSize + lx) * m_channel_count;
+}
+
+template <typename ValueType, typename CoordType>
+ValueType* SparseVoxelGrid3<ValueType, CoordType>::voxel(
+    const size_t            x,
+    const size_t            y,
+    const size_t            z)
+{
+    std::uint32_t& index = m_brick_indices[brick_index(x, y, z)];
+
+    if (index == EmptyBrick)
+    {
+        index = static_cast<std::uint32_t>(get_allocated_brick_count());
+        m_values.resize(m_values.size() + m_brick_value_count, ValueType(0.0));
+    }
+
+    return &m_values[index * m_brick_value_count + voxel_offset(x, y, z)];
+}
+
+template <typename ValueType, typename CoordType>
+APPLESEED_FORCE_INLINE const ValueType* SparseVoxelGrid3<ValueType, CoordType>::voxel(
+    const size_t            x,
+    const size_t            y,
+    const size_t            z) const
+{
+    const std::uint32_t index = m_brick_indices[brick_index(x, y, z)];
+
+    return
+        index == EmptyBrick
+            ? &m_empty_voxel[0]
+            : &m_values[index * m_brick_value_count + voxel_offset(x, y, z)];
+}
+
+template <typename ValueType, typename CoordType>
+void SparseVoxelGrid3<ValueType, CoordType>::nearest_lookup(
+    const PointType&                point,
+    ValueType* APPLESEED_RESTRICT   values) const
+{
+    // Compute the coordinates of the voxel containing the lookup point.
+    const CoordType x = clamp(point.x * m_scalar_nx, CoordType(0.0), m_max_x);
+    const CoordType y = clamp(point.y * m_scalar_ny, CoordType(0.0), m_max_y);
+    const CoordType z = clamp(point.z * m_scalar_nz, CoordType(0.0), m_max_z);
+    const size_t ix = truncate<size_t>(x);
+    const size_t iy = truncate<size_t>(y);
+    const size_t iz = truncate<size_t>(z);
+
+    // Return the values of that voxel.
+    const ValueType* APPLESEED_RESTRICT source = voxel(ix, iy, iz);
+    for (size_t i = 0; i < m_channel_count; ++i)
+        *values++ = *source++;
+}
+
+template <typename ValueType, typename CoordType>
+void SparseVoxelGrid3<ValueType, CoordType>::linear_lookup(
+    const PointType&                point,
+    ValueType* APPLESEED_RESTRICT   values) const
+{
+    // Compute the coordinates of the voxel containing the lookup point.
+    const CoordType x = saturate(point.x) * m_max_x;
+    const CoordType y = saturate(point.y) * m_max_y;
+    const CoordType z = saturate(point.z) * m_max_z;
+    const size_t ix = truncate<size_t>(x);
+    const size_t iy = truncate<size_t>(y);
+    const size_t iz = truncate<size_t>(z);
+
+    // Compute interpolation weights.
+    const ValueType x1 = static_cast<ValueType>(x - ix);
+    const ValueType y1 = static_cast<ValueType>(y - iy);
+    const ValueType z1 = static_cast<ValueType>(z - iz);
+    const ValueType x0 = ValueType(1.0) - x1;
+    const ValueType y0 = ValueType(1.0) - y1;
+    const ValueType z0 = ValueType(1.0) - z1;
+    const ValueType y0z0 = y0 * z0;
+    const ValueType y1z0 = y1 * z0;
+    const ValueType y0z1 = y0 * z1;
+    const ValueType y1z1 = y1 * z1;
+    const ValueType w000 = x0 * y0z0;
+    const ValueType w100 = x1 * y0z0;
+    const ValueType w010 = x0 * y1z0;
+    const ValueType w110 = x1 * y1z0;
+    const ValueType w001 = x0 * y0z1;
+    const ValueType w101 = x1 * y0z1;
+    const ValueType w011 = x0 * y1z1;
+    const ValueType w111 = x1 * y1z1;
+
+    // Neighboring voxels may belong to different bricks: fetch them individually.
+    const size_t jx = ix == m_nx - 1 ? ix : ix + 1;
+    const size_t jy = iy == m_ny - 1 ? iy : iy + 1;
+    const size_t jz = iz == m_nz - 1 ? iz : iz + 1;
+    const ValueType* APPLESEED_RESTRICT src000 = voxel(ix, iy, iz);
+    const ValueType* APPLESEED_RESTRICT src100 = voxel(jx, iy, iz);
+    const ValueType* APPLESEED_RESTRICT src010 = voxel(ix, jy, iz);
+    const ValueType* APPLESEED_RESTRICT src110 = voxel(jx, jy, iz);
+    const ValueType* APPLESEED_RESTRICT src001 = voxel(ix, iy, jz);
+    const ValueType* APPLESEED_RESTRICT src101 = voxel(jx, iy, jz);
+    const ValueType* APPLESEED_RESTRICT src011 = voxel(ix, jy, jz);
+    const ValueType* APPLESEED_RESTRICT src111 = voxel(jx, jy, jz);
+
+    // Blend.
+    for (size_t i = 0; i < m_channel_count; ++i)
+    {
+       *values++ =
+           *src000++ * w000 +
+           *src100++ * w100 +
+           *src010++ * w010 +
+           *src110++ * w110 +
+           *src001++ * w001 +
+           *src101++ * w101 +
+           *src011++ * w011 +
+           *src111++ * w111;
+    }
+}
+
+}   // namespace foundation
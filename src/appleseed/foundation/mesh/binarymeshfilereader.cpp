@@ -34,11 +34,14 @@
 #include "foundation/core/exceptions/exceptionioerror.h"
 #include "foundation/math/vector.h"
 #include "foundation/mesh/imeshbuilder.h"
+#include "foundation/platform/memorymappedfile.h"
 #include "foundation/utility/bufferedfile.h"
 #include "foundation/utility/memory.h"
 
+// LZ4 headers.
+#include <lz4.h>
+
 // Standard headers.
-#include <cstdint>
 #include <cstring>
 #include <memory>
 
@@ -101,6 +104,19 @@ void BinaryMeshFileReader::read(IMeshBuilder& builder)
         }
         break;
 
+      // Memory-mapped, block-compressed, single-precision geometry.
+      case 5:
+        {
+            file.close();
+
+            MemoryMappedFile mapped_file(m_filename.c_str());
+            if (!mapped_file.is_open())
+                throw ExceptionIOError();
+
+            read_mapped_meshes(mapped_file, builder);
+        }
+        break;
+
       // Unknown format.
       default:
         throw ExceptionIOError("unknown binarymesh format version");
@@ -264,4 +280,221 @@ void BinaryMeshFileReader::read_face(ReaderAdapter& reader, IMeshBuilder& builde
     builder.end_face();
 }
 
+namespace
+{
+    // Face layouts.
+    const std::uint8_t FaceLayoutTriangles = 0;
+    const std::uint8_t FaceLayoutPolygons = 1;
+
+    // Block encodings.
+    const std::uint32_t BlockEncodingRaw = 0;
+    const std::uint32_t BlockEncodingLZ4 = 1;
+
+    // Alignment of block payloads in the file.
+    const size_t BlockAlignment = 16;
+
+    // Bounds-checked sequential access to a memory-mapped file.
+    class MappedFileCursor
+    {
+      public:
+        explicit MappedFileCursor(const MemoryMappedFile& file)
+          : m_data(file.get_data())
+          , m_size(file.get_size())
+          , m_offset(0)
+        {
+        }
+
+        bool at_end() const
+        {
+            return m_offset == m_size;
+        }
+
+        const std::uint8_t* consume(const size_t size)
+        {
+            if (size > m_size - m_offset)
+                throw ExceptionIOError();
+
+            const std::uint8_t* p = m_data + m_offset;
+            m_offset += size;
+            return p;
+        }
+
+        template <typename T>
+        T read()
+        {
+            T value;
+            std::memcpy(&value, consume(sizeof(T)), sizeof(T));
+            return value;
+        }
+
+        std::string read_string()
+        {
+            const std::uint16_t length = read<std::uint16_t>();
+            return std::string(reinterpret_cast<const char*>(consume(length)), length);
+        }
+
+        void align(const size_t alignment)
+        {
+            consume((alignment - m_offset % alignment) % alignment);
+        }
+
+      private:
+        const std::uint8_t* m_data;
+        const size_t        m_size;
+        size_t              m_offset;
+    };
+
+    // Return a pointer to the decoded payload of the next block, and its size.
+    // Uncompressed payloads point directly into the mapped file, compressed ones
+    // are decoded into a scratch buffer.
+    const std::uint8_t* read_block(
+        MappedFileCursor&           cursor,
+        std::vector<std::uint8_t>&  scratch,
+        size_t&                     size)
+    {
+        const std::uint32_t encoding = cursor.read<std::uint32_t>();
+        cursor.read<std::uint32_t>();
+        const std::uint64_t stored_size = cursor.read<std::uint64_t>();
+        const std::uint64_t decoded_size = cursor.read<std::uint64_t>();
+
+        cursor.align(BlockAlignment);
+
+        const std::uint8_t* payload = cursor.consume(static_cast<size_t>(stored_size));
+        size = static_cast<size_t>(decoded_size);
+
+        switch (encoding)
+        {
+          case BlockEncodingRaw:
+            if (stored_size != decoded_size)
+                throw ExceptionIOError("invalid binarymesh block size");
+            return payload;
+
+          case BlockEncodingLZ4:
+            {
+                if (stored_size > LZ4_MAX_INPUT_SIZE || decoded_size > LZ4_MAX_INPUT_SIZE)
+                    throw ExceptionIOError("invalid binarymesh block size");
+
+                ensure_minimum_size(scratch, size);
+
+                const int result =
+                    LZ4_decompress_safe(
+                        reinterpret_cast<const char*>(payload),
+                        reinterpret_cast<char*>(scratch.data()),
+                        static_cast<int>(stored_size),
+                        static_cast<int>(decoded_size));
+
+                if (result < 0 || static_cast<std::uint64_t>(result) != decoded_size)
+                    throw ExceptionIOError("corrupted binarymesh block");
+
+                return scratch.data();
+            }
+
+          default:
+            throw ExceptionIOError("unknown binarymesh block encoding");
+        }
+    }
+
+    template <typename T>
+    const T* read_array_block(
+        MappedFileCursor&           cursor,
+        std::vector<std::uint8_t>&  scratch,
+        const size_t                count)
+    {
+        size_t size;
+        const std::uint8_t* data = read_block(cursor, scratch, size);
+
+        if (size != count * sizeof(T))
+            throw ExceptionIOError("invalid binarymesh block size");
+
+        return reinterpret_cast<const T*>(data);
+    }
+}
+
+void BinaryMeshFileReader::read_mapped_meshes(const MemoryMappedFile& file, IMeshBuilder& builder)
+{
+    MappedFileCursor cursor(file);
+
+    // Skip the signature and the format version.
+    cursor.consume(10 + sizeof(std::uint16_t));
+
+    while (!cursor.at_end())
+    {
+        const std::string mesh_name = cursor.read_string();
+
+        builder.begin_mesh(mesh_name.c_str());
+
+        const std::uint16_t material_slot_count = cursor.read<std::uint16_t>();
+        for (std::uint16_t i = 0; i < material_slot_count; ++i)
+            builder.push_material_slot(cursor.read_string().c_str());
+
+        const std::uint32_t vertex_count = cursor.read<std::uint32_t>();
+        const std::uint32_t vertex_normal_count = cursor.read<std::uint32_t>();
+        const std::uint32_t tex_coords_count = cursor.read<std::uint32_t>();
+        const std::uint8_t face_layout = cursor.read<std::uint8_t>();
+        const std::uint32_t face_count = cursor.read<std::uint32_t>();
+
+        builder.push_vertex_array(
+            read_array_block<Vector3f>(cursor, m_block, vertex_count),
+            vertex_count);
+
+        builder.push_vertex_normal_array(
+            read_array_block<Vector3f>(cursor, m_block, vertex_normal_count),
+            vertex_normal_count);
+
+        builder.push_tex_coords_array(
+            read_array_block<Vector2f>(cursor, m_block, tex_coords_count),
+            tex_coords_count);
+
+        if (face_layout == FaceLayoutTriangles)
+        {
+            builder.push_triangle_array(
+                read_array_block<std::uint32_t>(cursor, m_block, face_count * size_t(10)),
+                face_count);
+        }
+        else if (face_layout == FaceLayoutPolygons)
+        {
+            size_t size;
+            const std::uint8_t* data = read_block(cursor, m_block, size);
+            read_polygons(data, size, builder);
+        }
+        else throw ExceptionIOError("unknown binarymesh face layout");
+
+        builder.end_mesh();
+    }
+}
+
+void BinaryMeshFileReader::read_polygons(const std::uint8_t* data, const size_t size, IMeshBuilder& builder)
+{
+    const std::uint32_t* indices = reinterpret_cast<const std::uint32_t*>(data);
+    const size_t index_count = size / sizeof(std::uint32_t);
+
+    size_t i = 0;
+
+    while (i < index_count)
+    {
+        const size_t count = indices[i++];
+
+        if (count < 3 || count * 3 + 1 > index_count - i)
+            throw ExceptionIOError("invalid binarymesh polygon");
+
+        ensure_minimum_size(m_vertices, count);
+        ensure_minimum_size(m_vertex_normals, count);
+        ensure_minimum_size(m_tex_coords, count);
+
+        for (size_t j = 0; j < count; ++j)
+        {
+            m_vertices[j] = indices[i++];
+            m_vertex_normals[j] = indices[i++];
+            m_tex_coords[j] = indices[i++];
+        }
+
+        builder.begin_face(count);
+        builder.set_face_vertices(&m_vertices[0]);
+        builder.set_face_vertex_normals(&m_vertex_normals[0]);
+        builder.set_face_vertex_tex_coords(&m_tex_coords[0]);
+        builder.set_face_material(indices[i++]);
+        builder.end_face();
+    }
+}
+
 }   // namespace foundation
@@ -35,12 +35,14 @@
 
 // Standard headers.
 #include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
 // Forward declarations.
 namespace foundation    { class BufferedFile; }
 namespace foundation    { class IMeshBuilder; }
+namespace foundation    { class MemoryMappedFile; }
 namespace foundation    { class ReaderAdapter; }
 
 namespace foundation
@@ -49,6 +51,11 @@ namespace foundation
 //
 // Read for a simple binary mesh file format.
 //
+// Files in version 5 of the format (see foundation::BinaryMeshFileWriter) are memory-mapped
+// and their vertex, vertex normal, texture coordinate and triangle arrays are handed to
+// the mesh builder in one call each; uncompressed arrays are passed straight from the
+// mapped file. Older versions are read element by element.
+//
 
 class BinaryMeshFileReader
   : public IMeshFileReader
@@ -61,10 +68,11 @@ class BinaryMeshFileReader
     void read(IMeshBuilder& builder) override;
 
   private:
-    const std::string       m_filename;
-    std::vector<size_t>     m_vertices;
-    std::vector<size_t>     m_vertex_normals;
-    std::vector<size_t>     m_tex_coords;
+    const std::string           m_filename;
+    std::vector<size_t>         m_vertices;
+    std::vector<size_t>         m_vertex_normals;
+    std::vector<size_t>         m_tex_coords;
+    std::vector<std::uint8_t>   m_block;
 
     static void read_and_check_signature(BufferedFile& file);
 
@@ -77,6 +85,9 @@ class BinaryMeshFileReader
     void read_material_slots(ReaderAdapter& reader, IMeshBuilder& builder);
     void read_faces(ReaderAdapter& reader, IMeshBuilder& builder);
     void read_face(ReaderAdapter& reader, IMeshBuilder& builder);
+
+    void read_mapped_meshes(const MemoryMappedFile& file, IMeshBuilder& builder);
+    void read_polygons(const std::uint8_t* data, const size_t size, IMeshBuilder& builder);
 };
 
 }   // namespace foundation
@@ -35,8 +35,10 @@
 #include "foundation/math/vector.h"
 #include "foundation/mesh/imeshwalker.h"
 
+// LZ4 headers.
+#include <lz4.h>
+
 // Standard headers.
-#include <cstdint>
 #include <cstring>
 
 namespace foundation
@@ -49,12 +51,44 @@ namespace foundation
 namespace
 {
     // Version of the BinaryMesh file format being written by this code.
-    const std::uint16_t Version = 4;
+    const std::uint16_t Version = 5;
+
+    // Face layouts.
+    const std::uint8_t FaceLayoutTriangles = 0;
+    const std::uint8_t FaceLayoutPolygons = 1;
+
+    // Block encodings.
+    const std::uint32_t BlockEncodingRaw = 0;
+    const std::uint32_t BlockEncodingLZ4 = 1;
+
+    // Alignment of block payloads in the file.
+    const size_t BlockAlignment = 16;
+
+    template <typename T>
+    void append(std::vector<std::uint8_t>& block, const T& value)
+    {
+        const size_t size = block.size();
+        block.resize(size + sizeof(T));
+        std::memcpy(&block[size], &value, sizeof(T));
+    }
+
+    bool has_only_triangles(const IMeshWalker& walker)
+    {
+        for (size_t i = 0, e = walker.get_face_count(); i < e; ++i)
+        {
+            if (walker.get_face_vertex_count(i) != 3)
+                return false;
+        }
+
+        return true;
+    }
 }
 
-BinaryMeshFileWriter::BinaryMeshFileWriter(const std::string& filename)
+BinaryMeshFileWriter::BinaryMeshFileWriter(
+    const std::string&  filename,
+    const int           options)
   : m_filename(filename)
-  , m_writer(m_file, 256 * 1024)
+  , m_options(options)
 {
 }
 
@@ -92,78 +126,147 @@ void BinaryMeshFileWriter::write_string(const char* s)
 {
     const std::uint16_t length = static_cast<std::uint16_t>(strlen(s));
 
-    checked_write(m_writer, length);
-    checked_write(m_writer, s, length);
+    checked_write(m_file, length);
+    checked_write(m_file, s, length);
 }
 
 void BinaryMeshFileWriter::write_mesh(const IMeshWalker& walker)
 {
+    const bool triangles = has_only_triangles(walker);
+
     write_string(walker.get_name());
+    write_material_slots(walker);
+
+    checked_write(m_file, static_cast<std::uint32_t>(walker.get_vertex_count()));
+    checked_write(m_file, static_cast<std::uint32_t>(walker.get_vertex_normal_count()));
+    checked_write(m_file, static_cast<std::uint32_t>(walker.get_tex_coords_count()));
+    checked_write(m_file, triangles ? FaceLayoutTriangles : FaceLayoutPolygons);
+    checked_write(m_file, static_cast<std::uint32_t>(walker.get_face_count()));
+
     write_vertices(walker);
     write_vertex_normals(walker);
     write_texture_coordinates(walker);
-    write_material_slots(walker);
-    write_faces(walker);
+    write_faces(walker, triangles);
+}
+
+void BinaryMeshFileWriter::write_material_slots(const IMeshWalker& walker)
+{
+    const std::uint16_t count = static_cast<std::uint16_t>(walker.get_material_slot_count());
+    checked_write(m_file, count);
+
+    for (std::uint16_t i = 0; i < count; ++i)
+        write_string(walker.get_material_slot(i));
 }
 
 void BinaryMeshFileWriter::write_vertices(const IMeshWalker& walker)
 {
-    const std::uint32_t count = static_cast<std::uint32_t>(walker.get_vertex_count());
-    checked_write(m_writer, count);
+    m_block.clear();
+
+    for (size_t i = 0, e = walker.get_vertex_count(); i < e; ++i)
+        append(m_block, Vector3f(walker.get_vertex(i)));
 
-    for (std::uint32_t i = 0; i < count; ++i)
-        checked_write(m_writer, Vector3f(walker.get_vertex(i)));
+    write_block();
 }
 
 void BinaryMeshFileWriter::write_vertex_normals(const IMeshWalker& walker)
 {
-    const std::uint32_t count = static_cast<std::uint32_t>(walker.get_vertex_normal_count());
-    checked_write(m_writer, count);
+    m_block.clear();
 
-    for (std::uint32_t i = 0; i < count; ++i)
-        checked_write(m_writer, Vector3f(walker.get_vertex_normal(i)));
+    for (size_t i = 0, e = walker.get_vertex_normal_count(); i < e; ++i)
+        append(m_block, Vector3f(walker.get_vertex_normal(i)));
+
+    write_block();
 }
 
 void BinaryMeshFileWriter::write_texture_coordinates(const IMeshWalker& walker)
 {
-    const std::uint32_t count = static_cast<std::uint32_t>(walker.get_tex_coords_count());
-    checked_write(m_writer, count);
+    m_block.clear();
+
+    for (size_t i = 0, e = walker.get_tex_coords_count(); i < e; ++i)
+        append(m_block, Vector2f(walker.get_tex_coords(i)));
 
-    for (std::uint32_t i = 0; i < count; ++i)
-        checked_write(m_writer, Vector2f(walker.get_tex_coords(i)));
+    write_block();
 }
 
-void BinaryMeshFileWriter::write_material_slots(const IMeshWalker& walker)
+void BinaryMeshFileWriter::write_faces(const IMeshWalker& walker, const bool triangles)
 {
-    const std::uint16_t count = static_cast<std::uint16_t>(walker.get_material_slot_count());
-    checked_write(m_writer, count);
+    m_block.clear();
 
-    for (std::uint16_t i = 0; i < count; ++i)
-        write_string(walker.get_material_slot(i));
-}
+    for (size_t i = 0, e = walker.get_face_count(); i < e; ++i)
+    {
+        const size_t vertex_count = walker.get_face_vertex_count(i);
 
-void BinaryMeshFileWriter::write_faces(const IMeshWalker& walker)
-{
-    const std::uint32_t count = static_cast<std::uint32_t>(walker.get_face_count());
-    checked_write(m_writer, count);
+        if (triangles)
+        {
+            // Same layout as renderer::Triangle.
+            for (size_t j = 0; j < 3; ++j)
+                append(m_block, static_cast<std::uint32_t>(walker.get_face_vertex(i, j)));
+            for (size_t j = 0; j < 3; ++j)
+                append(m_block, static_cast<std::uint32_t>(walker.get_face_vertex_normal(i, j)));
+            for (size_t j = 0; j < 3; ++j)
+                append(m_block, static_cast<std::uint32_t>(walker.get_face_tex_coords(i, j)));
+        }
+        else
+        {
+            append(m_block, static_cast<std::uint32_t>(vertex_count));
+
+            for (size_t j = 0; j < vertex_count; ++j)
+            {
+                append(m_block, static_cast<std::uint32_t>(walker.get_face_vertex(i, j)));
+                append(m_block, static_cast<std::uint32_t>(walker.get_face_vertex_normal(i, j)));
+                append(m_block, static_cast<std::uint32_t>(walker.get_face_tex_coords(i, j)));
+            }
+        }
 
-    for (std::uint32_t i = 0; i < count; ++i)
-        write_face(walker, i);
+        append(m_block, static_cast<std::uint32_t>(walker.get_face_material(i)));
+    }
+
+    write_block();
 }
 
-void BinaryMeshFileWriter::write_face(const IMeshWalker& walker, const size_t face_index)
+void BinaryMeshFileWriter::write_block()
 {
-    const std::uint16_t count = static_cast<std::uint16_t>(walker.get_face_vertex_count(face_index));
-    checked_write(m_writer, count);
+    const std::uint64_t size = m_block.size();
 
-    for (std::uint16_t i = 0; i < count; ++i)
+    std::uint32_t encoding = BlockEncodingRaw;
+    const std::uint8_t* payload = m_block.data();
+    std::uint64_t stored_size = size;
+
+    // Compress the block if that makes it smaller.
+    if (!(m_options & OmitBlockCompression) && size > 0 && size <= LZ4_MAX_INPUT_SIZE)
     {
-        checked_write(m_writer, static_cast<std::uint32_t>(walker.get_face_vertex(face_index, i)));
-        checked_write(m_writer, static_cast<std::uint32_t>(walker.get_face_vertex_normal(face_index, i)));
-        checked_write(m_writer, static_cast<std::uint32_t>(walker.get_face_tex_coords(face_index, i)));
+        m_compressed_block.resize(
+            static_cast<size_t>(LZ4_compressBound(static_cast<int>(size))));
+
+        const int compressed_size =
+            LZ4_compress_default(
+                reinterpret_cast<const char*>(m_block.data()),
+                reinterpret_cast<char*>(m_compressed_block.data()),
+                static_cast<int>(size),
+                static_cast<int>(m_compressed_block.size()));
+
+        if (compressed_size > 0 && static_cast<std::uint64_t>(compressed_size) < size)
+        {
+            encoding = BlockEncodingLZ4;
+            payload = m_compressed_block.data();
+            stored_size = static_cast<std::uint64_t>(compressed_size);
+        }
     }
 
-    checked_write(m_writer, static_cast<std::uint16_t>(walker.get_face_material(face_index)));
+    // Write the block header.
+    checked_write(m_file, encoding);
+    checked_write(m_file, std::uint32_t(0));
+    checked_write(m_file, stored_size);
+    checked_write(m_file, size);
+
+    // Align the payload.
+    static const std::uint8_t Padding[BlockAlignment] = { 0 };
+    const size_t offset = static_cast<size_t>(m_file.tell());
+    const size_t padding = (BlockAlignment - offset % BlockAlignment) % BlockAlignment;
+    checked_write(m_file, Padding, padding);
+
+    // Write the payload.
+    checked_write(m_file, payload, static_cast<size_t>(stored_size));
 }
 
 }   // namespace foundation
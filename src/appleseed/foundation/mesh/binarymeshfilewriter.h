@@ -36,7 +36,9 @@
 
 // Standard headers.
 #include <cstddef>
+#include <cstdint>
 #include <string>
+#include <vector>
 
 // Forward declarations.
 namespace foundation    { class IMeshWalker; }
@@ -47,33 +49,70 @@ namespace foundation
 //
 // Writer for a simple binary mesh file format.
 //
+// Files are written in version 5 of the format. After the "BINARYMESH" signature and
+// the 16-bit format version, a file is a sequence of meshes, each laid out as follows:
+//
+//   name                       16-bit length followed by characters
+//   material slots             16-bit count followed by names
+//   vertex count               32-bit
+//   vertex normal count        32-bit
+//   texture coordinate count   32-bit
+//   face layout                8-bit, 0 for triangles, 1 for polygons
+//   face count                 32-bit
+//   vertex block               3 x 32-bit floats per vertex
+//   vertex normal block        3 x 32-bit floats per normal
+//   texture coordinate block   2 x 32-bit floats per texture coordinate
+//   face block                 see below
+//
+// Triangle meshes store each face as ten 32-bit indices (three vertices, three vertex
+// normals, three texture coordinates and a material), which matches the layout of
+// in-memory triangle meshes. Meshes with polygonal faces store, for each face, a vertex
+// count, one (vertex, vertex normal, texture coordinate) index triple per vertex and a
+// material, all as 32-bit integers.
+//
+// Each block starts with a header (32-bit encoding: 0 for raw data, 1 for LZ4; 32-bit
+// padding; 64-bit stored size; 64-bit decoded size), followed by zero padding up to the
+// next 16-byte boundary, then by the payload. Uncompressed blocks can therefore be used
+// in place when the file is memory-mapped. Blocks are LZ4-compressed only when this makes
+// them smaller, unless compression is disabled altogether.
+//
 
 class BinaryMeshFileWriter
   : public IMeshFileWriter
 {
   public:
+    enum Options
+    {
+        Defaults                = 0,            // none of the flags below
+        OmitBlockCompression    = 1UL << 0      // store all blocks uncompressed
+    };
+
     // Constructor.
-    explicit BinaryMeshFileWriter(const std::string& filename);
+    explicit BinaryMeshFileWriter(
+        const std::string&          filename,
+        const int                   options = Defaults);
 
     // Write a mesh.
     void write(const IMeshWalker& walker) override;
 
   private:
-    const std::string           m_filename;
-    BufferedFile                m_file;
-    LZ4CompressedWriterAdapter  m_writer;
+    const std::string               m_filename;
+    const int                       m_options;
+    BufferedFile                    m_file;
+    std::vector<std::uint8_t>       m_block;
+    std::vector<std::uint8_t>       m_compressed_block;
 
     void write_signature();
     void write_version();
 
     void write_string(const char* s);
     void write_mesh(const IMeshWalker& walker);
+    void write_material_slots(const IMeshWalker& walker);
     void write_vertices(const IMeshWalker& walker);
     void write_vertex_normals(const IMeshWalker& walker);
     void write_texture_coordinates(const IMeshWalker& walker);
-    void write_material_slots(const IMeshWalker& walker);
-    void write_faces(const IMeshWalker& walker);
-    void write_face(const IMeshWalker& walker, const size_t face_index);
+    void write_faces(const IMeshWalker& walker, const bool triangles);
+    void write_block();
 };
 
 }   // namespace foundation
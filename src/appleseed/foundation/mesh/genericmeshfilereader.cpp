@@ -40,6 +40,7 @@
 #include "boost/filesystem/path.hpp"
 
 // Standard headers.
+#include <cstddef>
 #include <string>
 
 namespace bf = boost::filesystem;
@@ -51,6 +52,7 @@ struct GenericMeshFileReader::Impl
 {
     std::string  m_filename;
     int          m_obj_options;
+    size_t       m_obj_thread_count;
 };
 
 GenericMeshFileReader::GenericMeshFileReader(const char* filename)
@@ -58,6 +60,7 @@ GenericMeshFileReader::GenericMeshFileReader(const char* filename)
 {
     impl->m_filename = filename;
     impl->m_obj_options = OBJMeshFileReader::Default;
+    impl->m_obj_thread_count = 1;
 }
 
 GenericMeshFileReader::~GenericMeshFileReader()
@@ -75,6 +78,16 @@ void GenericMeshFileReader::set_obj_options(const int obj_options)
     impl->m_obj_options = obj_options;
 }
 
+size_t GenericMeshFileReader::get_obj_thread_count() const
+{
+    return impl->m_obj_thread_count;
+}
+
+void GenericMeshFileReader::set_obj_thread_count(const size_t obj_thread_count)
+{
+    impl->m_obj_thread_count = obj_thread_count;
+}
+
 void GenericMeshFileReader::read(IMeshBuilder& builder)
 {
     const bf::path filepath(impl->m_filename);
@@ -82,7 +95,7 @@ void GenericMeshFileReader::read(IMeshBuilder& builder)
 
     if (extension == ".obj")
     {
-        OBJMeshFileReader reader(impl->m_filename, impl->m_obj_options);
+        OBJMeshFileReader reader(impl->m_filename, impl->m_obj_options, impl->m_obj_thread_count);
         reader.read(builder);
     }
     else if (extension == ".binarymesh")
@@ -35,6 +35,9 @@
 // appleseed.main headers.
 #include "main/dllsymbol.h"
 
+// Standard headers.
+#include <cstddef>
+
 // Forward declarations.
 namespace foundation    { class IMeshBuilder; }
 
@@ -59,6 +62,10 @@ class APPLESEED_DLLSYMBOL GenericMeshFileReader
     int get_obj_options() const;
     void set_obj_options(const int obj_options);
 
+    // Get/set the number of threads used by the Wavefront OBJ mesh file reader for parallel parsing.
+    size_t get_obj_thread_count() const;
+    void set_obj_thread_count(const size_t obj_thread_count);
+
     // Read a mesh.
     void read(IMeshBuilder& builder) override;
 
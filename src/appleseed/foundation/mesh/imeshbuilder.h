@@ -38,6 +38,7 @@
 
 // Standard headers.
 #include <cstddef>
+#include <cstdint>
 
 namespace foundation
 {
@@ -91,6 +92,75 @@ class APPLESEED_DLLSYMBOL IMeshBuilder
 
     // End the definition of the mesh.
     virtual void end_mesh() = 0;
+
+    //
+    // Bulk insertion.
+    //
+    // Readers of array-based formats use these methods to append whole arrays at once.
+    // The default implementations forward each element to the methods above; builders
+    // may override them to copy the arrays directly into their own storage.
+    //
+
+    // Append an array of vertices to the mesh.
+    virtual void push_vertex_array(const Vector3f vertices[], const size_t count);
+
+    // Append an array of vertex normals to the mesh. The normals are NOT necessarily unit-length.
+    virtual void push_vertex_normal_array(const Vector3f vertex_normals[], const size_t count);
+
+    // Append an array of texture coordinates to the mesh.
+    virtual void push_tex_coords_array(const Vector2f tex_coords[], const size_t count);
+
+    // Append an array of triangles to the mesh. Each triangle is defined by ten consecutive
+    // indices: three vertices, three vertex normals, three texture coordinates and a material.
+    // Missing vertex normals and texture coordinates are set to ~std::uint32_t(0).
+    virtual void push_triangle_array(const std::uint32_t triangles[], const size_t count);
 };
 
+
+//
+// IMeshBuilder class implementation.
+//
+
+inline void IMeshBuilder::push_vertex_array(const Vector3f vertices[], const size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        push_vertex(Vector3d(vertices[i]));
+}
+
+inline void IMeshBuilder::push_vertex_normal_array(const Vector3f vertex_normals[], const size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        push_vertex_normal(Vector3d(vertex_normals[i]));
+}
+
+inline void IMeshBuilder::push_tex_coords_array(const Vector2f tex_coords[], const size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        push_tex_coords(Vector2d(tex_coords[i]));
+}
+
+inline void IMeshBuilder::push_triangle_array(const std::uint32_t triangles[], const size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        const std::uint32_t* triangle = triangles + i * 10;
+
+        size_t vertices[3], vertex_normals[3], tex_coords[3];
+
+        for (size_t j = 0; j < 3; ++j)
+        {
+            vertices[j] = triangle[j];
+            vertex_normals[j] = triangle[3 + j];
+            tex_coords[j] = triangle[6 + j];
+        }
+
+        begin_face(3);
+        set_face_vertices(vertices);
+        set_face_vertex_normals(vertex_normals);
+        set_face_vertex_tex_coords(tex_coords);
+        set_face_material(triangle[9]);
+        end_face();
+    }
+}
+
 }   // namespace foundation
@@ -31,15 +31,33 @@
 #include "objmeshfilereader.h"
 
 // appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
 #include "foundation/core/exceptions/exceptionioerror.h"
 #include "foundation/math/vector.h"
 #include "foundation/mesh/imeshbuilder.h"
 #include "foundation/mesh/objmeshfilelexer.h"
+#include "foundation/platform/memorymappedfile.h"
+#include "foundation/utility/job/ijob.h"
+#include "foundation/utility/job/jobmanager.h"
+#include "foundation/utility/job/jobqueue.h"
+#include "foundation/utility/log/logger.h"
 #include "foundation/utility/memory.h"
+#include "foundation/utility/string.h"
+
+// Boost headers.
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
 
 // Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
 #include <cstring>
+#include <exception>
 #include <map>
+#include <memory>
 #include <utility>
 #include <vector>
 
@@ -53,47 +71,284 @@ namespace foundation
 namespace
 {
     const size_t Undefined = ~size_t(0);
-}
 
-struct OBJMeshFileReader::Impl
-{
-    const int                         m_options;
-    IMeshBuilder&                     m_builder;
-    OBJMeshFileLexer                  m_lexer;
+    //
+    // Turns the statements of an OBJ file into calls to a mesh builder.
+    //
+    // Both the streaming and the parallel parsers feed their statements through this
+    // class, in file order, so that they produce exactly the same meshes.
+    //
+
+    struct MeshAssembler
+    {
+        const int                         m_options;
+        IMeshBuilder&                     m_builder;
+
+        // Current state.
+        bool                              m_inside_mesh_def;              // currently inside a mesh definition?
+        std::string                       m_current_mesh_name;            // name of the current mesh
+        std::map<std::string, size_t>     m_material_slots;               // material slots for the current mesh
+        size_t                            m_current_material_slot_index;  // index of the current material slot
+
+        // Features defined in the file.
+        std::vector<Vector3d>             m_vertices;
+        std::vector<Vector2d>             m_tex_coords;
+        std::vector<Vector3d>             m_normals;
+
+        // Mappings between internal indices and mesh indices.
+        std::vector<size_t>               m_vertex_index_mapping;
+        std::vector<size_t>               m_tex_coord_index_mapping;
+        std::vector<size_t>               m_normal_index_mapping;
+
+        // Temporary vectors for collecting indices while parsing face statements.
+        std::vector<size_t>               m_face_vertex_indices;
+        std::vector<size_t>               m_face_tex_coord_indices;
+        std::vector<size_t>               m_face_normal_indices;
+
+        // Constructor.
+        MeshAssembler(
+            const int           options,
+            IMeshBuilder&       builder)
+          : m_options(options)
+          , m_builder(builder)
+          , m_inside_mesh_def(false)
+          , m_current_material_slot_index(0)
+        {
+        }
+
+        // Convert 1-based indices (including negative indices) to 0-based indices.
+        static size_t fix_index(
+            const long          index,
+            const size_t        count,
+            const size_t        line)
+        {
+            if (index > 0)
+            {
+                const size_t i = static_cast<size_t>(index);
+                if (i > count)
+                    throw OBJMeshFileReader::ExceptionParseError(line);
+                return i - 1;
+            }
+            else if (index < 0)
+            {
+                const size_t i = static_cast<size_t>(-index);
+                if (i > count)
+                    throw OBJMeshFileReader::ExceptionParseError(line);
+                return count - i;
+            }
+            else
+            {
+                throw OBJMeshFileReader::ExceptionParseError(line);
+            }
+        }
+
+        // Return true if a face with these numbers of indices is well-formed.
+        static bool is_well_formed_face(
+            const size_t        vertex_index_count,
+            const size_t        tex_coord_index_count,
+            const size_t        normal_index_count)
+        {
+            return
+                    vertex_index_count >= 3
+                && (tex_coord_index_count == 0 || tex_coord_index_count == vertex_index_count)
+                && (normal_index_count == 0 || normal_index_count == vertex_index_count);
+        }
+
+        void begin_face()
+        {
+            clear_keep_memory(m_face_vertex_indices);
+            clear_keep_memory(m_face_tex_coord_indices);
+            clear_keep_memory(m_face_normal_indices);
+        }
+
+        void end_face(const size_t line)
+        {
+            // Check whether the face is well-formed.
+            const bool well_formed =
+                is_well_formed_face(
+                    m_face_vertex_indices.size(),
+                    m_face_tex_coord_indices.size(),
+                    m_face_normal_indices.size());
+
+            if (well_formed)
+            {
+                // The face is well-formed, insert it into the mesh.
+                insert_face_into_mesh();
+            }
+            else
+            {
+                // The face is ill-formed, ignore it or abort parsing.
+                if (m_options & OBJMeshFileReader::StopOnInvalidFaceDef)
+                    throw OBJMeshFileReader::ExceptionInvalidFaceDef(line);
+            }
+        }
+
+        void insert_face_into_mesh()
+        {
+            // Begin a mesh definition if we're not already inside one.
+            ensure_mesh_def();
+
+            // Insert the features into the mesh, updating index mappings as necessary.
+            insert_vertices_into_mesh();
+            insert_vertex_normals_into_mesh();
+            insert_tex_coords_into_mesh();
+
+            // Translate feature indices from internal space to mesh space.
+            translate_indices(m_face_vertex_indices, m_vertex_index_mapping);
+            translate_indices(m_face_normal_indices, m_normal_index_mapping);
+            translate_indices(m_face_tex_coord_indices, m_tex_coord_index_mapping);
+
+            const size_t n = m_face_vertex_indices.size();
+
+            // Begin defining a new face.
+            m_builder.begin_face(n);
+
+            // Set face vertices.
+            m_builder.set_face_vertices(&m_face_vertex_indices.front());
+
+            // Set face vertex normals (if any).
+            if (m_face_normal_indices.size() == n)
+                m_builder.set_face_vertex_normals(&m_face_normal_indices.front());
+
+            // Set face vertex texture coordinates (if any).
+            if (m_face_tex_coord_indices.size() == n)
+                m_builder.set_face_vertex_tex_coords(&m_face_tex_coord_indices.front());
+
+            // Set face material.
+            m_builder.set_face_material(m_current_material_slot_index);
+
+            // End defining the face.
+            m_builder.end_face();
+        }
+
+        void insert_vertices_into_mesh()
+        {
+            const size_t face_vertex_index_count = m_face_vertex_indices.size();
+
+            for (size_t i = 0; i < face_vertex_index_count; ++i)
+            {
+                const size_t vertex_index = m_face_vertex_indices[i];
+                ensure_minimum_size(m_vertex_index_mapping, vertex_index + 1, Undefined);
+                if (m_vertex_index_mapping[vertex_index] == Undefined)
+                    m_vertex_index_mapping[vertex_index] = m_builder.push_vertex(m_vertices[vertex_index]);
+            }
+        }
+
+        void insert_vertex_normals_into_mesh()
+        {
+            const size_t face_normal_index_count = m_face_normal_indices.size();
+
+            for (size_t i = 0; i < face_normal_index_count; ++i)
+            {
+                const size_t normal_index = m_face_normal_indices[i];
+                ensure_minimum_size(m_normal_index_mapping, normal_index + 1, Undefined);
+                if (m_normal_index_mapping[normal_index] == Undefined)
+                    m_normal_index_mapping[normal_index] = m_builder.push_vertex_normal(m_normals[normal_index]);
+            }
+        }
+
+        void insert_tex_coords_into_mesh()
+        {
+            const size_t face_tex_coord_index_count = m_face_tex_coord_indices.size();
+
+            for (size_t i = 0; i < face_tex_coord_index_count; ++i)
+            {
+                const size_t tex_coord_index = m_face_tex_coord_indices[i];
+                ensure_minimum_size(m_tex_coord_index_mapping, tex_coord_index + 1, Undefined);
+                if (m_tex_coord_index_mapping[tex_coord_index] == Undefined)
+                    m_tex_coord_index_mapping[tex_coord_index] = m_builder.push_tex_coords(m_tex_coords[tex_coord_index]);
+            }
+        }
+
+        static void translate_indices(
+            std::vector<size_t>&         indices,
+            const std::vector<size_t>&   mapping)
+        {
+            const size_t count = indices.size();
+
+            for (size_t i = 0; i < count; ++i)
+                indices[i] = mapping[indices[i]];
+        }
+
+        void begin_object_or_group(const std::string& upcoming_mesh_name)
+        {
+            // Start a new mesh only if the name of the object or group actually changes.
+            if (upcoming_mesh_name != m_current_mesh_name)
+            {
+                // End the current mesh.
+                if (m_inside_mesh_def)
+                {
+                    m_builder.end_mesh();
+                    m_inside_mesh_def = false;
+                }
+
+                clear_keep_memory(m_vertex_index_mapping);
+                clear_keep_memory(m_tex_coord_index_mapping);
+                clear_keep_memory(m_normal_index_mapping);
+
+                m_current_mesh_name = upcoming_mesh_name;
+            }
+        }
+
+        void use_material(const std::string& material_slot_name)
+        {
+            // Begin a mesh definition if we're not already inside one.
+            ensure_mesh_def();
+
+            // Check whether this material slot has already been defined for this mesh.
+            const std::map<std::string, size_t>::const_iterator& it =
+                m_material_slots.find(material_slot_name);
+
+            if (it != m_material_slots.end())
+            {
+                // It has: just make it the active material slot.
+                m_current_material_slot_index = it->second;
+            }
+            else
+            {
+                // It hasn't: insert it into the mesh and make it the active material slot.
+                m_current_material_slot_index = m_builder.push_material_slot(material_slot_name.c_str());
+                m_material_slots.insert(std::make_pair(material_slot_name, m_current_material_slot_index));
+            }
+        }
 
-    // Current state.
-    bool                              m_inside_mesh_def;              // currently inside a mesh definition?
-    std::string                       m_current_mesh_name;            // name of the current mesh
-    std::map<std::string, size_t>     m_material_slots;               // material slots for the current mesh
-    size_t                            m_current_material_slot_index;  // index of the current material slot
+        void ensure_mesh_def()
+        {
+            if (!m_inside_mesh_def)
+            {
+                // Begin the definition of the new mesh.
+                m_builder.begin_mesh(m_current_mesh_name.c_str());
+                m_inside_mesh_def = true;
 
-    // Features defined in the file.
-    std::vector<Vector3d>             m_vertices;
-    std::vector<Vector2d>             m_tex_coords;
-    std::vector<Vector3d>             m_normals;
+                // Clear material slot definitions.
+                m_material_slots.clear();
+                m_current_material_slot_index = 0;
+            }
+        }
 
-    // Mappings between internal indices and mesh indices.
-    std::vector<size_t>               m_vertex_index_mapping;
-    std::vector<size_t>               m_tex_coord_index_mapping;
-    std::vector<size_t>               m_normal_index_mapping;
+        void end()
+        {
+            // End the definition of the last object.
+            if (m_inside_mesh_def)
+                m_builder.end_mesh();
+        }
+    };
+}
 
-    // Temporary vectors for collecting indices while parsing face statements.
-    std::vector<size_t>               m_face_vertex_indices;
-    std::vector<size_t>               m_face_tex_coord_indices;
-    std::vector<size_t>               m_face_normal_indices;
+struct OBJMeshFileReader::Impl
+{
+    OBJMeshFileLexer                  m_lexer;
+    MeshAssembler                     m_assembler;
 
     // Constructor.
     Impl(
         const int           options,
         IMeshBuilder&       builder)
-      : m_options(options)
-      , m_builder(builder)
-      , m_lexer(
+      : m_lexer(
             (options & FavorSpeedOverPrecision)
                 ? OBJMeshFileLexer::Fast
                 : OBJMeshFileLexer::Precise)
-      , m_inside_mesh_def(false)
-      , m_current_material_slot_index(0)
+      , m_assembler(options, builder)
     {
     }
 
@@ -186,15 +441,12 @@ struct OBJMeshFileReader::Impl
         }
 
         // End the definition of the last object.
-        if (m_inside_mesh_def)
-            m_builder.end_mesh();
+        m_assembler.end();
     }
 
     void parse_f_statement()
     {
-        clear_keep_memory(m_face_vertex_indices);
-        clear_keep_memory(m_face_tex_coord_indices);
-        clear_keep_memory(m_face_normal_indices);
+        m_assembler.begin_face();
 
         while (true)
         {
@@ -210,8 +462,8 @@ struct OBJMeshFileReader::Impl
 
             {
                 const long n = m_lexer.accept_long();
-                const size_t v = fix_index(n, m_vertices.size());
-                m_face_vertex_indices.push_back(v);
+                const size_t v = fix_index(n, m_assembler.m_vertices.size());
+                m_assembler.m_face_vertex_indices.push_back(v);
             }
 
             //
@@ -243,8 +495,8 @@ struct OBJMeshFileReader::Impl
                 else
                 {
                     const long n = m_lexer.accept_long();
-                    const size_t vt = fix_index(n, m_tex_coords.size());
-                    m_face_tex_coord_indices.push_back(vt);
+                    const size_t vt = fix_index(n, m_assembler.m_tex_coords.size());
+                    m_assembler.m_face_tex_coord_indices.push_back(vt);
                 }
             }
 
@@ -276,166 +528,25 @@ struct OBJMeshFileReader::Impl
                 else
                 {
                     const long n = m_lexer.accept_long();
-                    const size_t vn = fix_index(n, m_normals.size());
-                    m_face_normal_indices.push_back(vn);
+                    const size_t vn = fix_index(n, m_assembler.m_normals.size());
+                    m_assembler.m_face_normal_indices.push_back(vn);
                 }
             }
         }
 
-        // Check whether the face is well-formed.
-        const size_t vc = m_face_vertex_indices.size();
-        const size_t tc = m_face_tex_coord_indices.size();
-        const size_t nc = m_face_normal_indices.size();
-        const bool well_formed =
-                vc >= 3
-            && (tc == 0 || tc == vc)
-            && (nc == 0 || nc == vc);
-
-        if (well_formed)
-        {
-            // The face is well-formed, insert it into the mesh.
-            insert_face_into_mesh();
-        }
-        else
-        {
-            // The face is ill-formed, ignore it or abort parsing.
-            if (m_options & StopOnInvalidFaceDef)
-                throw ExceptionInvalidFaceDef(m_lexer.get_line_number());
-        }
+        m_assembler.end_face(m_lexer.get_line_number());
     }
 
     // Convert 1-based indices (including negative indices) to 0-based indices.
     size_t fix_index(const long index, const size_t count)
     {
-        if (index > 0)
-        {
-            const size_t i = static_cast<size_t>(index);
-            if (i > count)
-                parse_error();
-            return i - 1;
-        }
-        else if (index < 0)
-        {
-            const size_t i = static_cast<size_t>(-index);
-            if (i > count)
-                parse_error();
-            return count - i;
-        }
-        else
-        {
-            parse_error();
-            return 0;       // keep the compiler happy
-        }
-    }
-
-    void insert_face_into_mesh()
-    {
-        // Begin a mesh definition if we're not already inside one.
-        ensure_mesh_def();
-
-        // Insert the features into the mesh, updating index mappings as necessary.
-        insert_vertices_into_mesh();
-        insert_vertex_normals_into_mesh();
-        insert_tex_coords_into_mesh();
-
-        // Translate feature indices from internal space to mesh space.
-        translate_indices(m_face_vertex_indices, m_vertex_index_mapping);
-        translate_indices(m_face_normal_indices, m_normal_index_mapping);
-        translate_indices(m_face_tex_coord_indices, m_tex_coord_index_mapping);
-
-        const size_t n = m_face_vertex_indices.size();
-
-        // Begin defining a new face.
-        m_builder.begin_face(n);
-
-        // Set face vertices.
-        m_builder.set_face_vertices(&m_face_vertex_indices.front());
-
-        // Set face vertex normals (if any).
-        if (m_face_normal_indices.size() == n)
-            m_builder.set_face_vertex_normals(&m_face_normal_indices.front());
-
-        // Set face vertex texture coordinates (if any).
-        if (m_face_tex_coord_indices.size() == n)
-            m_builder.set_face_vertex_tex_coords(&m_face_tex_coord_indices.front());
-
-        // Set face material.
-        m_builder.set_face_material(m_current_material_slot_index);
-
-        // End defining the face.
-        m_builder.end_face();
-    }
-
-    void insert_vertices_into_mesh()
-    {
-        const size_t face_vertex_index_count = m_face_vertex_indices.size();
-
-        for (size_t i = 0; i < face_vertex_index_count; ++i)
-        {
-            const size_t vertex_index = m_face_vertex_indices[i];
-            ensure_minimum_size(m_vertex_index_mapping, vertex_index + 1, Undefined);
-            if (m_vertex_index_mapping[vertex_index] == Undefined)
-                m_vertex_index_mapping[vertex_index] = m_builder.push_vertex(m_vertices[vertex_index]);
-        }
-    }
-
-    void insert_vertex_normals_into_mesh()
-    {
-        const size_t face_normal_index_count = m_face_normal_indices.size();
-
-        for (size_t i = 0; i < face_normal_index_count; ++i)
-        {
-            const size_t normal_index = m_face_normal_indices[i];
-            ensure_minimum_size(m_normal_index_mapping, normal_index + 1, Undefined);
-            if (m_normal_index_mapping[normal_index] == Undefined)
-                m_normal_index_mapping[normal_index] = m_builder.push_vertex_normal(m_normals[normal_index]);
-        }
-    }
-
-    void insert_tex_coords_into_mesh()
-    {
-        const size_t face_tex_coord_index_count = m_face_tex_coord_indices.size();
-
-        for (size_t i = 0; i < face_tex_coord_index_count; ++i)
-        {
-            const size_t tex_coord_index = m_face_tex_coord_indices[i];
-            ensure_minimum_size(m_tex_coord_index_mapping, tex_coord_index + 1, Undefined);
-            if (m_tex_coord_index_mapping[tex_coord_index] == Undefined)
-                m_tex_coord_index_mapping[tex_coord_index] = m_builder.push_tex_coords(m_tex_coords[tex_coord_index]);
-        }
-    }
-
-    static void translate_indices(
-        std::vector<size_t>&         indices,
-        const std::vector<size_t>&   mapping)
-    {
-        const size_t count = indices.size();
-
-        for (size_t i = 0; i < count; ++i)
-            indices[i] = mapping[indices[i]];
+        return MeshAssembler::fix_index(index, count, m_lexer.get_line_number());
     }
 
     void parse_o_g_statement()
     {
         // Retrieve the name of the upcoming mesh.
-        const std::string upcoming_mesh_name = parse_compound_identifier();
-
-        // Start a new mesh only if the name of the object or group actually changes.
-        if (upcoming_mesh_name != m_current_mesh_name)
-        {
-            // End the current mesh.
-            if (m_inside_mesh_def)
-            {
-                m_builder.end_mesh();
-                m_inside_mesh_def = false;
-            }
-
-            clear_keep_memory(m_vertex_index_mapping);
-            clear_keep_memory(m_tex_coord_index_mapping);
-            clear_keep_memory(m_normal_index_mapping);
-
-            m_current_mesh_name = upcoming_mesh_name;
-        }
+        m_assembler.begin_object_or_group(parse_compound_identifier());
     }
 
     std::string parse_compound_identifier()
@@ -479,7 +590,7 @@ struct OBJMeshFileReader::Impl
         if (!m_lexer.is_eol())
             m_lexer.accept_double();
 
-        m_vertices.push_back(v);
+        m_assembler.m_vertices.push_back(v);
     }
 
     void parse_vt_statement()
@@ -497,7 +608,7 @@ struct OBJMeshFileReader::Impl
         if (!m_lexer.is_eol())
             m_lexer.accept_double();
 
-        m_tex_coords.push_back(v);
+        m_assembler.m_tex_coords.push_back(v);
     }
 
     void parse_vn_statement()
@@ -513,59 +624,872 @@ struct OBJMeshFileReader::Impl
         m_lexer.eat_blanks();
         n.z = m_lexer.accept_double();
 
-        m_normals.push_back(n);
+        m_assembler.m_normals.push_back(n);
     }
 
     void parse_usemtl_statement()
     {
-        // Begin a mesh definition if we're not already inside one.
-        ensure_mesh_def();
-
         // Retrieve the name of the material slot.
-        const std::string material_slot_name = parse_compound_identifier();
+        m_assembler.use_material(parse_compound_identifier());
+    }
+};
+
+namespace
+{
+    //
+    // Parallel parsing.
+    //
+    // The memory-mapped file is split into line-aligned chunks. A first pass counts the lines,
+    // vertices, texture coordinates and vertex normals of every chunk, which gives each chunk
+    // the line number and feature counts it starts with. A second pass parses all chunks
+    // concurrently, resolving face indices exactly as the streaming parser would. Parsed chunks
+    // are fed to a MeshAssembler in file order as soon as they are ready, and only a bounded
+    // number of chunks is parsed ahead of the assembler, which bounds memory usage.
+    //
+
+    const size_t MinChunkSize = 64 * 1024;      // in bytes
+    const size_t MaxChunkSize = 1024 * 1024;    // in bytes
+    const size_t ChunksPerThread = 8;
+
+    struct Chunk
+    {
+        // Layout of the face descriptors.
+        static const std::uint32_t FaceVertexCountMask = (1UL << 30) - 1;
+        static const std::uint32_t FaceHasTexCoords = 1UL << 30;
+        static const std::uint32_t FaceHasNormals = 1UL << 31;
+
+        struct Event
+        {
+            enum Type
+            {
+                ObjectOrGroup,
+                UseMaterial
+            };
+
+            Type                        m_type;
+            size_t                      m_face_index;       // number of faces of the chunk preceding this statement
+            std::string                 m_name;
+        };
+
+        const char*                     m_begin;
+        const char*                     m_end;
+
+        // Contents of the chunk, as counted by the first pass.
+        size_t                          m_line_count;
+        size_t                          m_vertex_count;
+        size_t                          m_tex_coord_count;
+        size_t                          m_normal_count;
+
+        // Position of the chunk in the file.
+        size_t                          m_first_line;
+        size_t                          m_first_vertex;
+        size_t                          m_first_tex_coord;
+        size_t                          m_first_normal;
+
+        // Contents of the chunk, as parsed by the second pass.
+        std::vector<Vector3d>           m_vertices;
+        std::vector<Vector2d>           m_tex_coords;
+        std::vector<Vector3d>           m_normals;
+        std::vector<std::uint32_t>      m_faces;            // one descriptor per well-formed face
+        std::vector<size_t>             m_face_indices;     // vertex, then texture coordinate, then normal indices of each face
+        std::vector<Event>              m_events;
+        std::exception_ptr              m_parse_error;      // error that ended the parsing of the chunk, if any
+        std::exception_ptr              m_error;            // unexpected error raised while processing the chunk, if any
+    };
+
+    //
+    // A parser for the lines of a chunk, with the same behavior as OBJMeshFileLexer
+    // and OBJMeshFileReader::Impl.
+    //
+
+    class ChunkParser
+    {
+      public:
+        ChunkParser(
+            const int           options,
+            const bool          is_space[256])
+          : m_options(options)
+          , m_is_space(is_space)
+          , m_line_size(0)
+          , m_line_index(0)
+          , m_line_number(0)
+        {
+        }
+
+        void count(Chunk& chunk) const
+        {
+            chunk.m_line_count = 0;
+            chunk.m_vertex_count = 0;
+            chunk.m_tex_coord_count = 0;
+            chunk.m_normal_count = 0;
+
+            const char* ptr = chunk.m_begin;
+
+            while (ptr < chunk.m_end)
+            {
+                const char* line_end = find_line_end(ptr, chunk.m_end);
+
+                ++chunk.m_line_count;
+
+                // Isolate the keyword.
+                while (ptr < line_end && is_space(*ptr))
+                    ++ptr;
+                const char* keyword = ptr;
+                while (ptr < line_end && !is_space(*ptr))
+                    ++ptr;
+                const size_t keyword_length = ptr - keyword;
+
+                if (keyword_length == 1 && keyword[0] == 'v')
+                    ++chunk.m_vertex_count;
+                else if (keyword_length == 2 && keyword[0] == 'v')
+                {
+                    if (keyword[1] == 't')
+                        ++chunk.m_tex_coord_count;
+                    else if (keyword[1] == 'n')
+                        ++chunk.m_normal_count;
+                }
+
+                ptr = next_line(line_end, chunk.m_end);
+            }
+        }
+
+        void parse(Chunk& chunk)
+        {
+            chunk.m_vertices.reserve(chunk.m_vertex_count);
+            chunk.m_tex_coords.reserve(chunk.m_tex_coord_count);
+            chunk.m_normals.reserve(chunk.m_normal_count);
+
+            m_line_number = chunk.m_first_line;
+
+            const char* ptr = chunk.m_begin;
+
+            try
+            {
+                while (ptr < chunk.m_end)
+                {
+                    const char* line_end = find_line_end(ptr, chunk.m_end);
+
+                    // Copy the line so that numbers are parsed from a zero-terminated string.
+                    m_line.assign(ptr, line_end);
+                    m_line.push_back(0);
+                    m_line_size = line_end - ptr;
+                    m_line_index = 0;
+
+                    parse_line(chunk);
+
+                    ++m_line_number;
+                    ptr = next_line(line_end, chunk.m_end);
+                }
+            }
+            catch (const OBJMeshFileReader::ExceptionParseError&)
+            {
+                chunk.m_parse_error = std::current_exception();
+            }
+        }
+
+      private:
+        const int                       m_options;
+        const bool*                     m_is_space;
+        std::vector<char>               m_line;
+        size_t                          m_line_size;
+        size_t                          m_line_index;
+        size_t                          m_line_number;
 
-        // Check whether this material slot has already been defined for this mesh.
-        const std::map<std::string, size_t>::const_iterator& it =
-            m_material_slots.find(material_slot_name);
+        // Temporary vectors for collecting indices while parsing face statements.
+        std::vector<size_t>             m_face_vertex_indices;
+        std::vector<size_t>             m_face_tex_coord_indices;
+        std::vector<size_t>             m_face_normal_indices;
 
-        if (it != m_material_slots.end())
+        static const char* find_line_end(const char* ptr, const char* end)
         {
-            // It has: just make it the active material slot.
-            m_current_material_slot_index = it->second;
+            const void* line_end = std::memchr(ptr, '\n', end - ptr);
+            return line_end != nullptr ? static_cast<const char*>(line_end) : end;
         }
-        else
+
+        static const char* next_line(const char* line_end, const char* end)
+        {
+            return line_end < end ? line_end + 1 : end;
+        }
+
+        bool is_space(const unsigned char c) const
+        {
+            return m_is_space[c];
+        }
+
+        unsigned char get_char() const
+        {
+            return m_line_index == m_line_size ? '\n' : m_line[m_line_index];
+        }
+
+        void next_char()
+        {
+            if (m_line_index < m_line_size)
+                ++m_line_index;
+        }
+
+        bool is_eol() const
+        {
+            return m_line_index == m_line_size;
+        }
+
+        void parse_error() const
         {
-            // It hasn't: insert it into the mesh and make it the active material slot.
-            m_current_material_slot_index = m_builder.push_material_slot(material_slot_name.c_str());
-            m_material_slots.insert(std::make_pair(material_slot_name, m_current_material_slot_index));
+            throw OBJMeshFileReader::ExceptionParseError(m_line_number);
+        }
+
+        // Eat blank characters and comments.
+        void eat_blanks()
+        {
+            while (!is_eol())
+            {
+                const unsigned char c = m_line[m_line_index];
+
+                if (c == '#')
+                {
+                    m_line_index = m_line_size;
+                    break;
+                }
+
+                if (!is_space(c))
+                    break;
+
+                ++m_line_index;
+            }
         }
+
+        // Accept a string of non-blank characters, or generate a parse error.
+        void accept_string(const char** begin, size_t* length)
+        {
+            if (is_space(get_char()))
+                parse_error();
+
+            const size_t string_begin = m_line_index;
+
+            while (!is_space(get_char()))
+                ++m_line_index;
+
+            *begin = &m_line[string_begin];
+            *length = m_line_index - string_begin;
+        }
+
+        long accept_long()
+        {
+            const char* base_ptr = &m_line[0];
+            const char* end_ptr;
+            const long value =
+                fast_strtol_base10(
+                    base_ptr + m_line_index,
+                    &end_ptr);
+
+            m_line_index = end_ptr - base_ptr;
+
+            return value;
+        }
+
+        double accept_double()
+        {
+            char* base_ptr = &m_line[0];
+            char* end_ptr;
+            const double value =
+                (m_options & OBJMeshFileReader::FavorSpeedOverPrecision)
+                    ? fast_strtod(
+                        base_ptr + m_line_index,
+                        &end_ptr)
+                    : std::strtod(
+                        base_ptr + m_line_index,
+                        &end_ptr);
+
+            m_line_index = end_ptr - base_ptr;
+
+            return value;
+        }
+
+        size_t fix_index(const long index, const size_t count) const
+        {
+            return MeshAssembler::fix_index(index, count, m_line_number);
+        }
+
+        void parse_line(Chunk& chunk)
+        {
+            eat_blanks();
+
+            // Skip empty lines.
+            if (is_eol())
+                return;
+
+            const char* keyword;
+            size_t keyword_length;
+
+            accept_string(&keyword, &keyword_length);
+
+            if (keyword_length == 1)
+            {
+                switch (keyword[0])
+                {
+                  case 'f':
+                    parse_f_statement(chunk);
+                    break;
+
+                  case 'g':
+                  case 'o':
+                    parse_o_g_statement(chunk);
+                    break;
+
+                  case 'v':
+                    parse_v_statement(chunk);
+                    break;
+
+                  default:
+                    // Ignore unknown or unhandled statements.
+                    return;
+                }
+            }
+            else if (keyword_length == 2)
+            {
+                switch (keyword[0] * 256 + keyword[1])
+                {
+                  case 'v' * 256 + 'n':
+                    parse_vn_statement(chunk);
+                    break;
+
+                  case 'v' * 256 + 't':
+                    parse_vt_statement(chunk);
+                    break;
+
+                  default:
+                    // Ignore unknown or unhandled statements.
+                    return;
+                }
+            }
+            else if (strncmp(keyword, "usemtl", keyword_length) == 0)
+            {
+                parse_usemtl_statement(chunk);
+            }
+            else
+            {
+                // Ignore unknown or unhandled statements.
+                return;
+            }
+
+            eat_blanks();
+
+            if (!is_eol())
+                parse_error();
+        }
+
+        void parse_f_statement(Chunk& chunk)
+        {
+            clear_keep_memory(m_face_vertex_indices);
+            clear_keep_memory(m_face_tex_coord_indices);
+            clear_keep_memory(m_face_normal_indices);
+
+            while (true)
+            {
+                eat_blanks();
+
+                if (is_eol())
+                    break;
+
+                // Accept n.
+                {
+                    const long n = accept_long();
+                    m_face_vertex_indices.push_back(
+                        fix_index(n, chunk.m_first_vertex + chunk.m_vertices.size()));
+                }
+
+                // Recognized n, accept (epsilon), /.
+                {
+                    const unsigned char c = get_char();
+                    if (is_space(c))
+                        continue;
+                    else if (c == '/')
+                        next_char();
+                    else parse_error();
+                }
+
+                // Recognized n/, accept /, n.
+                {
+                    const unsigned char c = get_char();
+                    if (c == '/')
+                    {
+                        next_char();
+                        goto skip;
+                    }
+                    else
+                    {
+                        const long n = accept_long();
+                        m_face_tex_coord_indices.push_back(
+                            fix_index(n, chunk.m_first_tex_coord + chunk.m_tex_coords.size()));
+                    }
+                }
+
+                // Recognized n/n, accept (epsilon), /.
+                {
+                    const unsigned char c = get_char();
+                    if (is_space(c))
+                        continue;
+                    else if (c == '/')
+                        next_char();
+                    else parse_error();
+                }
+
+              skip:
+
+                // Recognized n//, n/n/, accept (epsilon), n.
+                {
+                    const unsigned char c = get_char();
+                    if (is_space(c))
+                        continue;
+                    else
+                    {
+                        const long n = accept_long();
+                        m_face_normal_indices.push_back(
+                            fix_index(n, chunk.m_first_normal + chunk.m_normals.size()));
+                    }
+                }
+            }
+
+            const size_t vc = m_face_vertex_indices.size();
+            const size_t tc = m_face_tex_coord_indices.size();
+            const size_t nc = m_face_normal_indices.size();
+
+            if (MeshAssembler::is_well_formed_face(vc, tc, nc))
+            {
+                assert(vc <= Chunk::FaceVertexCountMask);
+
+                std::uint32_t face = static_cast<std::uint32_t>(vc);
+                if (tc > 0)
+                    face |= Chunk::FaceHasTexCoords;
+                if (nc > 0)
+                    face |= Chunk::FaceHasNormals;
+
+                chunk.m_faces.push_back(face);
+                chunk.m_face_indices.insert(chunk.m_face_indices.end(), m_face_vertex_indices.begin(), m_face_vertex_indices.end());
+                chunk.m_face_indices.insert(chunk.m_face_indices.end(), m_face_tex_coord_indices.begin(), m_face_tex_coord_indices.end());
+                chunk.m_face_indices.insert(chunk.m_face_indices.end(), m_face_normal_indices.begin(), m_face_normal_indices.end());
+            }
+            else if (m_options & OBJMeshFileReader::StopOnInvalidFaceDef)
+                throw OBJMeshFileReader::ExceptionInvalidFaceDef(m_line_number);
+        }
+
+        void parse_o_g_statement(Chunk& chunk)
+        {
+            push_event(chunk, Chunk::Event::ObjectOrGroup);
+        }
+
+        void parse_usemtl_statement(Chunk& chunk)
+        {
+            push_event(chunk, Chunk::Event::UseMaterial);
+        }
+
+        void push_event(Chunk& chunk, const Chunk::Event::Type type)
+        {
+            chunk.m_events.emplace_back();
+
+            Chunk::Event& event = chunk.m_events.back();
+            event.m_type = type;
+            event.m_face_index = chunk.m_faces.size();
+            event.m_name = parse_compound_identifier();
+        }
+
+        std::string parse_compound_identifier()
+        {
+            std::string identifier;
+
+            eat_blanks();
+
+            while (!is_eol())
+            {
+                const char* token;
+                size_t token_length;
+
+                accept_string(&token, &token_length);
+                eat_blanks();
+
+                if (!identifier.empty())
+                    identifier += ' ';
+
+                identifier.append(token, token_length);
+            }
+
+            return identifier;
+        }
+
+        void parse_v_statement(Chunk& chunk)
+        {
+            Vector3d v;
+
+            eat_blanks();
+            v.x = accept_double();
+
+            eat_blanks();
+            v.y = accept_double();
+
+            eat_blanks();
+            v.z = accept_double();
+
+            eat_blanks();
+
+            if (!is_eol())
+                accept_double();
+
+            chunk.m_vertices.push_back(v);
+        }
+
+        void parse_vt_statement(Chunk& chunk)
+        {
+            Vector2d v;
+
+            eat_blanks();
+            v.x = accept_double();
+
+            eat_blanks();
+            v.y = accept_double();
+
+            eat_blanks();
+
+            if (!is_eol())
+                accept_double();
+
+            chunk.m_tex_coords.push_back(v);
+        }
+
+        void parse_vn_statement(Chunk& chunk)
+        {
+            Vector3d n;
+
+            eat_blanks();
+            n.x = accept_double();
+
+            eat_blanks();
+            n.y = accept_double();
+
+            eat_blanks();
+            n.z = accept_double();
+
+            chunk.m_normals.push_back(n);
+        }
+    };
+
+    //
+    // Completion flags of a set of chunks.
+    //
+
+    class ChunkCompletion
+      : public NonCopyable
+    {
+      public:
+        explicit ChunkCompletion(const size_t chunk_count)
+          : m_done(chunk_count, false)
+        {
+        }
+
+        void signal(const size_t chunk_index)
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            m_done[chunk_index] = true;
+            m_condition.notify_all();
+        }
+
+        void wait(const size_t chunk_index)
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            while (!m_done[chunk_index])
+                m_condition.wait(lock);
+        }
+
+      private:
+        boost::mutex                    m_mutex;
+        boost::condition_variable       m_condition;
+        std::vector<bool>               m_done;
+    };
+
+    //
+    // A job that runs a function on a chunk and signals its completion.
+    //
+
+    template <typename Function>
+    class ChunkJob
+      : public IJob
+    {
+      public:
+        ChunkJob(
+            Chunk&                      chunk,
+            const size_t                chunk_index,
+            const Function&             function,
+            ChunkCompletion&            completion)
+          : m_chunk(chunk)
+          , m_chunk_index(chunk_index)
+          , m_function(function)
+          , m_completion(completion)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            try
+            {
+                m_function(m_chunk);
+            }
+            catch (...)
+            {
+                m_chunk.m_error = std::current_exception();
+            }
+
+            m_completion.signal(m_chunk_index);
+        }
+
+      private:
+        Chunk&                          m_chunk;
+        const size_t                    m_chunk_index;
+        const Function&                 m_function;
+        ChunkCompletion&                m_completion;
+    };
+
+    //
+    // Run a function on every chunk and feed the chunks to a consumer in file order, as soon
+    // as they are processed. At most window_size chunks are processed ahead of the consumer,
+    // which bounds the amount of memory used by processed chunks. The function is run on the
+    // calling thread if thread_count is 1.
+    //
+
+    template <typename Function, typename Consumer>
+    void process_chunks(
+        std::vector<Chunk>&     chunks,
+        const size_t            thread_count,
+        const size_t            window_size,
+        const Function&         function,
+        const Consumer&         consumer)
+    {
+        const size_t chunk_count = chunks.size();
+
+        if (thread_count <= 1 || chunk_count <= 1)
+        {
+            for (Chunk& chunk : chunks)
+            {
+                function(chunk);
+
+                if (chunk.m_error)
+                    std::rethrow_exception(chunk.m_error);
+
+                consumer(chunk);
+            }
+
+            return;
+        }
+
+        ChunkCompletion completion(chunk_count);
+        JobQueue job_queue;
+
+        size_t scheduled_count = 0;
+        auto schedule_chunks = [&](const size_t end)
+        {
+            for (; scheduled_count < std::min(end, chunk_count); ++scheduled_count)
+            {
+                job_queue.schedule(
+                    new ChunkJob<Function>(
+                        chunks[scheduled_count],
+                        scheduled_count,
+                        function,
+                        completion));
+            }
+        };
+
+        schedule_chunks(window_size);
+
+        Logger logger;
+        JobManager job_manager(
+            logger,
+            job_queue,
+            std::min(thread_count, chunk_count),
+            JobManager::KeepRunningOnEmptyQueue);
+        job_manager.start();
+
+        try
+        {
+            for (size_t i = 0; i < chunk_count; ++i)
+            {
+                completion.wait(i);
+                schedule_chunks(i + 1 + window_size);
+
+                if (chunks[i].m_error)
+                    std::rethrow_exception(chunks[i].m_error);
+
+                consumer(chunks[i]);
+            }
+        }
+        catch (...)
+        {
+            // Don't leave worker threads running on chunks that are about to be destroyed.
+            job_queue.clear_scheduled_jobs();
+            job_queue.wait_until_completion();
+            throw;
+        }
+    }
+
+    template <typename T>
+    void append_and_release(std::vector<T>& dest, std::vector<T>& source)
+    {
+        dest.insert(dest.end(), source.begin(), source.end());
+        clear_release_memory(source);
     }
 
-    void ensure_mesh_def()
+    void parse_in_parallel(
+        const std::string&      filename,
+        const int               options,
+        const size_t            thread_count,
+        MeshAssembler&          assembler)
     {
-        if (!m_inside_mesh_def)
+        // Map the input file.
+        const MemoryMappedFile file(filename.c_str());
+        if (!file.is_open())
+            throw ExceptionIOError();
+
+        const char* data = reinterpret_cast<const char*>(file.get_data());
+        const size_t size = file.get_size();
+
+        // Split the file into line-aligned chunks.
+        const size_t chunk_count =
+            std::max<size_t>(
+                std::min(
+                    size / MinChunkSize,
+                    std::max(size / MaxChunkSize, thread_count * ChunksPerThread)),
+                1);
+        std::vector<Chunk> chunks(chunk_count);
+        const char* chunk_begin = data;
+        for (size_t i = 0; i < chunk_count; ++i)
         {
-            // Begin the definition of the new mesh.
-            m_builder.begin_mesh(m_current_mesh_name.c_str());
-            m_inside_mesh_def = true;
+            const char* chunk_end = data + size;
 
-            // Clear material slot definitions.
-            m_material_slots.clear();
-            m_current_material_slot_index = 0;
+            if (i + 1 < chunk_count)
+            {
+                const char* split = std::max(chunk_begin, data + (i + 1) * (size / chunk_count));
+                const void* newline = std::memchr(split, '\n', data + size - split);
+                if (newline != nullptr)
+                    chunk_end = static_cast<const char*>(newline) + 1;
+            }
+
+            chunks[i].m_begin = chunk_begin;
+            chunks[i].m_end = chunk_end;
+            chunk_begin = chunk_end;
         }
+
+        // Precompute the value of std::isspace(c) for all c.
+        bool is_space[256];
+        for (int i = 0; i < 256; ++i)
+            is_space[i] = std::isspace(i) != 0;
+
+        // Count lines and features in all chunks, and compute the position of each chunk in the file.
+        size_t line = 1, vertex = 0, tex_coord = 0, normal = 0;
+        process_chunks(
+            chunks,
+            thread_count,
+            chunk_count,
+            [&](Chunk& chunk) { ChunkParser(options, is_space).count(chunk); },
+            [&](Chunk& chunk)
+            {
+                chunk.m_first_line = line;
+                chunk.m_first_vertex = vertex;
+                chunk.m_first_tex_coord = tex_coord;
+                chunk.m_first_normal = normal;
+
+                line += chunk.m_line_count;
+                vertex += chunk.m_vertex_count;
+                tex_coord += chunk.m_tex_coord_count;
+                normal += chunk.m_normal_count;
+            });
+
+        assembler.m_vertices.reserve(vertex);
+        assembler.m_tex_coords.reserve(tex_coord);
+        assembler.m_normals.reserve(normal);
+
+        // Parse all chunks and feed them to the mesh assembler in file order.
+        process_chunks(
+            chunks,
+            thread_count,
+            thread_count * 2,
+            [&](Chunk& chunk) { ChunkParser(options, is_space).parse(chunk); },
+            [&](Chunk& chunk)
+            {
+                append_and_release(assembler.m_vertices, chunk.m_vertices);
+                append_and_release(assembler.m_tex_coords, chunk.m_tex_coords);
+                append_and_release(assembler.m_normals, chunk.m_normals);
+
+                const size_t face_count = chunk.m_faces.size();
+                const size_t event_count = chunk.m_events.size();
+                const size_t* indices = chunk.m_face_indices.data();
+                size_t event_index = 0;
+
+                for (size_t i = 0; i <= face_count; ++i)
+                {
+                    // Replay the statements that precede this face.
+                    for (; event_index < event_count && chunk.m_events[event_index].m_face_index == i; ++event_index)
+                    {
+                        const Chunk::Event& event = chunk.m_events[event_index];
+
+                        if (event.m_type == Chunk::Event::ObjectOrGroup)
+                            assembler.begin_object_or_group(event.m_name);
+                        else assembler.use_material(event.m_name);
+                    }
+
+                    if (i == face_count)
+                        break;
+
+                    const std::uint32_t face = chunk.m_faces[i];
+                    const size_t n = face & Chunk::FaceVertexCountMask;
+
+                    assembler.begin_face();
+
+                    assembler.m_face_vertex_indices.assign(indices, indices + n);
+                    indices += n;
+
+                    if (face & Chunk::FaceHasTexCoords)
+                    {
+                        assembler.m_face_tex_coord_indices.assign(indices, indices + n);
+                        indices += n;
+                    }
+
+                    if (face & Chunk::FaceHasNormals)
+                    {
+                        assembler.m_face_normal_indices.assign(indices, indices + n);
+                        indices += n;
+                    }
+
+                    assembler.insert_face_into_mesh();
+                }
+
+                if (chunk.m_parse_error)
+                    std::rethrow_exception(chunk.m_parse_error);
+
+                clear_release_memory(chunk.m_faces);
+                clear_release_memory(chunk.m_face_indices);
+                clear_release_memory(chunk.m_events);
+            });
+
+        // End the definition of the last object.
+        assembler.end();
     }
-};
+}
 
 OBJMeshFileReader::OBJMeshFileReader(
     const std::string&   filename,
-    const int            options)
+    const int            options,
+    const size_t         thread_count)
   : m_filename(filename)
   , m_options(options)
+  , m_thread_count(std::max<size_t>(thread_count, 1))
 {
 }
 
 void OBJMeshFileReader::read(IMeshBuilder& builder)
 {
+    if (m_options & ParallelParsing)
+    {
+        MeshAssembler assembler(m_options, builder);
+        parse_in_parallel(m_filename, m_options, m_thread_count, assembler);
+        return;
+    }
+
     Impl impl(m_options, builder);
 
     // Open the input file.
@@ -82,13 +82,15 @@ class OBJMeshFileReader
     {
         Default                 = 0,            // none of the flags below
         FavorSpeedOverPrecision = 1UL << 0,     // use approximate algorithm for parsing floating-point values
-        StopOnInvalidFaceDef    = 1UL << 1      // stop parsing on invalid face definitions
+        StopOnInvalidFaceDef    = 1UL << 1,     // stop parsing on invalid face definitions
+        ParallelParsing         = 1UL << 2      // memory-map the file and parse it on multiple threads
     };
 
-    // Constructor.
+    // Constructor. thread_count is the number of threads used by parallel parsing.
     OBJMeshFileReader(
         const std::string&  filename,
-        const int           options = Default);
+        const int           options = Default,
+        const size_t        thread_count = 1);
 
     // Read a mesh.
     void read(IMeshBuilder& builder) override;
@@ -98,6 +100,7 @@ class OBJMeshFileReader
 
     const std::string       m_filename;
     const int               m_options;
+    const size_t            m_thread_count;
 };
 
 }   // namespace foundation
@@ -29,6 +29,8 @@
 // appleseed.foundation headers.
 #include "foundation/image/genericimagefilereader.h"
 #include "foundation/image/image.h"
+#include "foundation/math/aliastable.h"
+#include "foundation/math/cdf.h"
 #include "foundation/math/rng/distribution.h"
 #include "foundation/math/rng/xorshift32.h"
 #include "foundation/math/sampling/imageimportancesampler.h"
@@ -43,9 +45,10 @@ using namespace foundation;
 
 BENCHMARK_SUITE(Foundation_Math_Sampling_ImageImportanceSampler)
 {
+    template <template <typename, typename> class Distribution>
     struct Fixture
     {
-        typedef ImageImportanceSampler<ImageSampler::Payload, float> ImportanceSamplerType;
+        typedef ImageImportanceSampler<ImageSampler::Payload, float, Distribution> ImportanceSamplerType;
 
         std::unique_ptr<ImportanceSamplerType>   m_importance_sampler;
         Xorshift32                               m_rng;
@@ -69,7 +72,19 @@ BENCHMARK_SUITE(Foundation_Math_Sampling_ImageImportanceSampler)
         }
     };
 
-    BENCHMARK_CASE_F(Sample, Fixture)
+    BENCHMARK_CASE_F(Sample, Fixture<CDF>)
+    {
+        const Vector2f s = rand_vector2<Vector2f>(m_rng);
+
+        Vector2u texel_coords;
+        float texel_prob;
+        m_importance_sampler->sample(s, texel_coords.x, texel_coords.y, texel_prob);
+
+        m_texel_coords_sum += texel_coords;
+        m_texel_prob_sum += texel_prob;
+    }
+
+    BENCHMARK_CASE_F(Sample_AliasTable, Fixture<AliasTable>)
     {
         const Vector2f s = rand_vector2<Vector2f>(m_rng);
 
@@ -47,6 +47,22 @@ BENCHMARK_SUITE(Foundation_Utility_Job)
         }
     };
 
+    struct ShortJob
+      : public IJob
+    {
+        volatile size_t m_result;
+
+        void execute(const size_t thread_index) override
+        {
+            size_t x = thread_index;
+
+            for (size_t i = 0; i < 1000; ++i)
+                x = x * 1664525 + 1013904223;
+
+            m_result = x;
+        }
+    };
+
     template <size_t ThreadCount>
     struct Fixture
     {
@@ -60,10 +76,11 @@ BENCHMARK_SUITE(Foundation_Utility_Job)
             m_job_manager.start();
         }
 
+        template <typename Job>
         void payload()
         {
             const size_t JobCount = 256;
-            EmptyJob jobs[JobCount];
+            Job jobs[JobCount];
 
             for (size_t i = 0; i < JobCount; ++i)
                 m_job_queue.schedule(&jobs[i], false);
@@ -72,13 +89,83 @@ BENCHMARK_SUITE(Foundation_Utility_Job)
         }
     };
 
-    BENCHMARK_CASE_F(SingleThreadedJobExecution, Fixture<1>)
+    BENCHMARK_CASE_F(EmptyJobExecution_1Threads, Fixture<1>)
+    {
+        payload<EmptyJob>();
+    }
+
+    BENCHMARK_CASE_F(EmptyJobExecution_2Threads, Fixture<2>)
+    {
+        payload<EmptyJob>();
+    }
+
+    BENCHMARK_CASE_F(EmptyJobExecution_4Threads, Fixture<4>)
+    {
+        payload<EmptyJob>();
+    }
+
+    BENCHMARK_CASE_F(EmptyJobExecution_8Threads, Fixture<8>)
+    {
+        payload<EmptyJob>();
+    }
+
+    BENCHMARK_CASE_F(EmptyJobExecution_16Threads, Fixture<16>)
+    {
+        payload<EmptyJob>();
+    }
+
+    BENCHMARK_CASE_F(EmptyJobExecution_32Threads, Fixture<32>)
+    {
+        payload<EmptyJob>();
+    }
+
+    BENCHMARK_CASE_F(EmptyJobExecution_64Threads, Fixture<64>)
+    {
+        payload<EmptyJob>();
+    }
+
+    BENCHMARK_CASE_F(EmptyJobExecution_128Threads, Fixture<128>)
+    {
+        payload<EmptyJob>();
+    }
+
+    BENCHMARK_CASE_F(ShortJobExecution_1Threads, Fixture<1>)
+    {
+        payload<ShortJob>();
+    }
+
+    BENCHMARK_CASE_F(ShortJobExecution_2Threads, Fixture<2>)
+    {
+        payload<ShortJob>();
+    }
+
+    BENCHMARK_CASE_F(ShortJobExecution_4Threads, Fixture<4>)
+    {
+        payload<ShortJob>();
+    }
+
+    BENCHMARK_CASE_F(ShortJobExecution_8Threads, Fixture<8>)
+    {
+        payload<ShortJob>();
+    }
+
+    BENCHMARK_CASE_F(ShortJobExecution_16Threads, Fixture<16>)
+    {
+        payload<ShortJob>();
+    }
+
+    BENCHMARK_CASE_F(ShortJobExecution_32Threads, Fixture<32>)
+    {
+        payload<ShortJob>();
+    }
+
+    BENCHMARK_CASE_F(ShortJobExecution_64Threads, Fixture<64>)
     {
-        payload();
+        payload<ShortJob>();
     }
 
-    BENCHMARK_CASE_F(DoubleThreadedJobExecution, Fixture<2>)
+    BENCHMARK_CASE_F(ShortJobExecution_128Threads, Fixture<128>)
     {
-        payload();
+        payload<ShortJob>();
     }
 }
@@ -716,6 +716,41 @@ TEST_SUITE(Foundation_Math_BezierCurveIntersector)
         EXPECT_FEQ(20.0f, t);
     }
 
+    TEST_CASE(Intersect_GivenMovingBezier1CurveAtMidTime_ReturnsCorrectHitDistance)
+    {
+        const Vector3f ControlPoints0[] = { Vector3f(-0.5f, -0.5f, 0.0f), Vector3f(0.5f, 0.5f, 0.0f) };
+        const Vector3f ControlPoints1[] = { Vector3f(-0.5f, -0.5f, 2.0f), Vector3f(0.5f, 0.5f, 2.0f) };
+        const BezierCurve1f Curve0(ControlPoints0, 0.06f, 1.0f, Color3f(0.2f, 0.0f, 0.7f));
+        const BezierCurve1f Curve1(Curve0, ControlPoints1);
+
+        const Ray3f ray(Vector3f(0.0f, 0.0f, -3.0f), Vector3f(0.0f, 0.0f, 1.0f));
+
+        Matrix4f xfm_matrix;
+        make_curve_projection_transform(xfm_matrix, ray);
+
+        float u, v, t = std::numeric_limits<float>::max();
+        const bool hit = BezierCurveIntersector<BezierCurve1f>::intersect(Curve0, Curve1, 0.5f, ray, xfm_matrix, u, v, t);
+
+        ASSERT_TRUE(hit);
+        EXPECT_FEQ(4.0f, t);
+    }
+
+    TEST_CASE(Intersect_GivenMovingBezier1CurveAwayFromRayAtGivenTime_ReturnsNoHit)
+    {
+        const Vector3f ControlPoints0[] = { Vector3f(-0.5f, -0.5f, 0.0f), Vector3f(0.5f, 0.5f, 0.0f) };
+        const Vector3f ControlPoints1[] = { Vector3f(1.5f, -0.5f, 0.0f), Vector3f(2.5f, 0.5f, 0.0f) };
+        const BezierCurve1f Curve0(ControlPoints0, 0.06f, 1.0f, Color3f(0.2f, 0.0f, 0.7f));
+        const BezierCurve1f Curve1(Curve0, ControlPoints1);
+
+        const Ray3f ray(Vector3f(0.0f, 0.0f, -3.0f), Vector3f(0.0f, 0.0f, 1.0f));
+
+        Matrix4f xfm_matrix;
+        make_curve_projection_transform(xfm_matrix, ray);
+
+        EXPECT_TRUE(BezierCurveIntersector<BezierCurve1f>::intersect(Curve0, Curve1, 0.0f, ray, xfm_matrix));
+        EXPECT_FALSE(BezierCurveIntersector<BezierCurve1f>::intersect(Curve0, Curve1, 0.75f, ray, xfm_matrix));
+    }
+
 
     //
     // Check barycentric coordinates of ray-curve intersections.
@@ -0,0 +1,377 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.foundation headers.
+#include "foundation/math/vector.h"
+#include "foundation/mesh/binarymeshfilereader.h"
+#include "foundation/mesh/binarymeshfilewriter.h"
+#include "foundation/mesh/imeshwalker.h"
+#include "foundation/mesh/meshbuilderbase.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace foundation;
+
+TEST_SUITE(Foundation_Mesh_BinaryMeshFile)
+{
+    struct Face
+    {
+        std::vector<size_t>     m_vertices;
+        std::vector<size_t>     m_vertex_normals;
+        std::vector<size_t>     m_tex_coords;
+        size_t                  m_material;
+    };
+
+    struct Mesh
+    {
+        std::string                 m_name;
+        std::vector<Vector3d>       m_vertices;
+        std::vector<Vector3d>       m_vertex_normals;
+        std::vector<Vector2d>       m_tex_coords;
+        std::vector<std::string>    m_material_slots;
+        std::vector<Face>           m_faces;
+    };
+
+    struct MeshBuilder
+      : public MeshBuilderBase
+    {
+        std::vector<Mesh>   m_meshes;
+        size_t              m_triangle_array_count;
+
+        MeshBuilder()
+          : m_triangle_array_count(0)
+        {
+        }
+
+        void begin_mesh(const char* name) override
+        {
+            m_meshes.emplace_back();
+            m_meshes.back().m_name = name;
+        }
+
+        size_t push_vertex(const Vector3d& v) override
+        {
+            m_meshes.back().m_vertices.push_back(v);
+            return m_meshes.back().m_vertices.size() - 1;
+        }
+
+        size_t push_vertex_normal(const Vector3d& v) override
+        {
+            m_meshes.back().m_vertex_normals.push_back(v);
+            return m_meshes.back().m_vertex_normals.size() - 1;
+        }
+
+        size_t push_tex_coords(const Vector2d& v) override
+        {
+            m_meshes.back().m_tex_coords.push_back(v);
+            return m_meshes.back().m_tex_coords.size() - 1;
+        }
+
+        size_t push_material_slot(const char* name) override
+        {
+            m_meshes.back().m_material_slots.push_back(name);
+            return m_meshes.back().m_material_slots.size() - 1;
+        }
+
+        void begin_face(const size_t vertex_count) override
+        {
+            m_meshes.back().m_faces.emplace_back();
+
+            Face& face = m_meshes.back().m_faces.back();
+            face.m_vertices.resize(vertex_count);
+            face.m_vertex_normals.resize(vertex_count);
+            face.m_tex_coords.resize(vertex_count);
+        }
+
+        void set_face_vertices(const size_t vertices[]) override
+        {
+            Face& face = m_meshes.back().m_faces.back();
+            face.m_vertices.assign(vertices, vertices + face.m_vertices.size());
+        }
+
+        void set_face_vertex_normals(const size_t vertex_normals[]) override
+        {
+            Face& face = m_meshes.back().m_faces.back();
+            face.m_vertex_normals.assign(vertex_normals, vertex_normals + face.m_vertex_normals.size());
+        }
+
+        void set_face_vertex_tex_coords(const size_t tex_coords[]) override
+        {
+            Face& face = m_meshes.back().m_faces.back();
+            face.m_tex_coords.assign(tex_coords, tex_coords + face.m_tex_coords.size());
+        }
+
+        void set_face_material(const size_t material) override
+        {
+            m_meshes.back().m_faces.back().m_material = material;
+        }
+
+        void push_triangle_array(const std::uint32_t triangles[], const size_t count) override
+        {
+            ++m_triangle_array_count;
+            MeshBuilderBase::push_triangle_array(triangles, count);
+        }
+    };
+
+    struct MeshWalker
+      : public IMeshWalker
+    {
+        const Mesh& m_mesh;
+
+        explicit MeshWalker(const Mesh& mesh)
+          : m_mesh(mesh)
+        {
+        }
+
+        const char* get_name() const override
+        {
+            return m_mesh.m_name.c_str();
+        }
+
+        size_t get_vertex_count() const override
+        {
+            return m_mesh.m_vertices.size();
+        }
+
+        Vector3d get_vertex(const size_t i) const override
+        {
+            return m_mesh.m_vertices[i];
+        }
+
+        size_t get_vertex_normal_count() const override
+        {
+            return m_mesh.m_vertex_normals.size();
+        }
+
+        Vector3d get_vertex_normal(const size_t i) const override
+        {
+            return m_mesh.m_vertex_normals[i];
+        }
+
+        size_t get_tex_coords_count() const override
+        {
+            return m_mesh.m_tex_coords.size();
+        }
+
+        Vector2d get_tex_coords(const size_t i) const override
+        {
+            return m_mesh.m_tex_coords[i];
+        }
+
+        size_t get_material_slot_count() const override
+        {
+            return m_mesh.m_material_slots.size();
+        }
+
+        const char* get_material_slot(const size_t i) const override
+        {
+            return m_mesh.m_material_slots[i].c_str();
+        }
+
+        size_t get_face_count() const override
+        {
+            return m_mesh.m_faces.size();
+        }
+
+        size_t get_face_vertex_count(const size_t face_index) const override
+        {
+            return m_mesh.m_faces[face_index].m_vertices.size();
+        }
+
+        size_t get_face_vertex(const size_t face_index, const size_t vertex_index) const override
+        {
+            return m_mesh.m_faces[face_index].m_vertices[vertex_index];
+        }
+
+        size_t get_face_vertex_normal(const size_t face_index, const size_t vertex_index) const override
+        {
+            return m_mesh.m_faces[face_index].m_vertex_normals[vertex_index];
+        }
+
+        size_t get_face_tex_coords(const size_t face_index, const size_t vertex_index) const override
+        {
+            return m_mesh.m_faces[face_index].m_tex_coords[vertex_index];
+        }
+
+        size_t get_face_material(const size_t face_index) const override
+        {
+            return m_mesh.m_faces[face_index].m_material;
+        }
+    };
+
+    // A grid of quads, optionally split into triangles.
+    Mesh make_grid_mesh(const char* name, const size_t resolution, const bool triangulate)
+    {
+        Mesh mesh;
+        mesh.m_name = name;
+        mesh.m_material_slots.push_back("front");
+        mesh.m_material_slots.push_back("back");
+        mesh.m_vertex_normals.emplace_back(0.0, 1.0, 0.0);
+
+        for (size_t y = 0; y <= resolution; ++y)
+        {
+            for (size_t x = 0; x <= resolution; ++x)
+            {
+                const double u = static_cast<double>(x) / resolution;
+                const double v = static_cast<double>(y) / resolution;
+                mesh.m_vertices.emplace_back(u, 0.0, v);
+                mesh.m_tex_coords.emplace_back(u, v);
+            }
+        }
+
+        for (size_t y = 0; y < resolution; ++y)
+        {
+            for (size_t x = 0; x < resolution; ++x)
+            {
+                const size_t v0 = y * (resolution + 1) + x;
+                const size_t v1 = v0 + 1;
+                const size_t v2 = v1 + resolution + 1;
+                const size_t v3 = v0 + resolution + 1;
+                const size_t material = (x + y) % 2;
+
+                if (triangulate)
+                {
+                    const Face f0 = { { v0, v1, v2 }, { 0, 0, 0 }, { v0, v1, v2 }, material };
+                    const Face f1 = { { v2, v3, v0 }, { 0, 0, 0 }, { v2, v3, v0 }, material };
+                    mesh.m_faces.push_back(f0);
+                    mesh.m_faces.push_back(f1);
+                }
+                else
+                {
+                    const Face f = { { v0, v1, v2, v3 }, { 0, 0, 0, 0 }, { v0, v1, v2, v3 }, material };
+                    mesh.m_faces.push_back(f);
+                }
+            }
+        }
+
+        return mesh;
+    }
+
+    template <typename T>
+    bool feq_sequences(const std::vector<T>& lhs, const std::vector<T>& rhs)
+    {
+        if (lhs.size() != rhs.size())
+            return false;
+
+        for (size_t i = 0; i < lhs.size(); ++i)
+        {
+            if (!feq(lhs[i], rhs[i], 1.0e-6))
+                return false;
+        }
+
+        return true;
+    }
+
+    bool operator==(const Face& lhs, const Face& rhs)
+    {
+        return
+            lhs.m_vertices == rhs.m_vertices &&
+            lhs.m_vertex_normals == rhs.m_vertex_normals &&
+            lhs.m_tex_coords == rhs.m_tex_coords &&
+            lhs.m_material == rhs.m_material;
+    }
+
+    bool are_equal(const Mesh& lhs, const Mesh& rhs)
+    {
+        return
+            lhs.m_name == rhs.m_name &&
+            lhs.m_material_slots == rhs.m_material_slots &&
+            feq_sequences(lhs.m_vertices, rhs.m_vertices) &&
+            feq_sequences(lhs.m_vertex_normals, rhs.m_vertex_normals) &&
+            feq_sequences(lhs.m_tex_coords, rhs.m_tex_coords) &&
+            lhs.m_faces == rhs.m_faces;
+    }
+
+    void write_and_read_back(
+        const char*         filename,
+        const int           options,
+        const Mesh&         mesh,
+        MeshBuilder&        builder)
+    {
+        {
+            BinaryMeshFileWriter writer(filename, options);
+            writer.write(MeshWalker(mesh));
+        }
+
+        BinaryMeshFileReader reader(filename);
+        reader.read(builder);
+    }
+
+    TEST_CASE(WriteAndRead_UncompressedTriangleMesh_ReturnsSameMeshThroughTriangleArray)
+    {
+        const Mesh mesh = make_grid_mesh("grid", 4, true);
+
+        MeshBuilder builder;
+        write_and_read_back(
+            "unit tests/outputs/test_binarymeshfile_uncompressed_triangles.binarymesh",
+            BinaryMeshFileWriter::OmitBlockCompression,
+            mesh,
+            builder);
+
+        ASSERT_EQ(1, builder.m_meshes.size());
+        EXPECT_TRUE(are_equal(mesh, builder.m_meshes[0]));
+        EXPECT_EQ(1, builder.m_triangle_array_count);
+    }
+
+    TEST_CASE(WriteAndRead_CompressedTriangleMesh_ReturnsSameMeshThroughTriangleArray)
+    {
+        const Mesh mesh = make_grid_mesh("grid", 32, true);
+
+        MeshBuilder builder;
+        write_and_read_back(
+            "unit tests/outputs/test_binarymeshfile_compressed_triangles.binarymesh",
+            BinaryMeshFileWriter::Defaults,
+            mesh,
+            builder);
+
+        ASSERT_EQ(1, builder.m_meshes.size());
+        EXPECT_TRUE(are_equal(mesh, builder.m_meshes[0]));
+        EXPECT_EQ(1, builder.m_triangle_array_count);
+    }
+
+    TEST_CASE(WriteAndRead_PolygonMesh_ReturnsSameMesh)
+    {
+        const Mesh mesh = make_grid_mesh("grid", 8, false);
+
+        MeshBuilder builder;
+        write_and_read_back(
+            "unit tests/outputs/test_binarymeshfile_polygons.binarymesh",
+            BinaryMeshFileWriter::Defaults,
+            mesh,
+            builder);
+
+        ASSERT_EQ(1, builder.m_meshes.size());
+        EXPECT_TRUE(are_equal(mesh, builder.m_meshes[0]));
+        EXPECT_EQ(0, builder.m_triangle_array_count);
+    }
+}
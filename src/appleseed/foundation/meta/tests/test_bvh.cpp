@@ -30,14 +30,22 @@
 // appleseed.foundation headers.
 #include "foundation/math/aabb.h"
 #include "foundation/math/bvh.h"
+#include "foundation/math/intersection/rayaabb.h"
 #include "foundation/math/ray.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/math/sampling/mappings.h"
 #include "foundation/math/vector.h"
+#include "foundation/platform/defaulttimers.h"
 #include "foundation/utility/alignedvector.h"
 #include "foundation/utility/iostreamop.h"
+#include "foundation/utility/job.h"
+#include "foundation/utility/log.h"
 #include "foundation/utility/test.h"
 
 // Standard headers.
 #include <cstddef>
+#include <limits>
 #include <vector>
 
 using namespace foundation;
@@ -59,6 +67,26 @@ TEST_SUITE(Foundation_Math_BVH_Node)
         EXPECT_EQ(RightBBox, node.get_right_bbox());
     }
 
+    TEST_CASE(TestStorageAndRetrievalOfWideNodeChildren)
+    {
+        static const AABB3d BBox(Vector3d(1.0, 2.0, 3.0), Vector3d(4.0, 5.0, 6.0));
+
+        bvh::WideNode<AABB3d, 4> node;
+        node.add_child(BBox, 12, false);
+        node.add_child(BBox, 34, true);
+
+        EXPECT_EQ(2, node.get_child_count());
+        EXPECT_FALSE(node.is_leaf_child(0));
+        EXPECT_TRUE(node.is_leaf_child(1));
+        EXPECT_EQ(12, node.get_child_index(0));
+        EXPECT_EQ(34, node.get_child_index(1));
+
+        // Single precision bounding boxes are conservative.
+        const AABB3d child_bbox = node.get_child_bbox(1);
+        EXPECT_TRUE(child_bbox.contains(BBox.min));
+        EXPECT_TRUE(child_bbox.contains(BBox.max));
+    }
+
     TEST_CASE(TestStorageAndRetrievalOf3DBoundingBoxes)
     {
         static const AABB3d LeftBBox(Vector3d(1.0, 2.0, 3.0), Vector3d(4.0, 5.0, 6.0));
@@ -149,3 +177,721 @@ TEST_SUITE(Foundation_Math_BVH_Intersector_2D)
         > intersector;
     }
 }
+
+TEST_SUITE(Foundation_Math_BVH_WideIntersector)
+{
+    typedef bvh::Node<AABB3d> NodeType;
+    typedef bvh::Tree<AlignedVector<NodeType>> Tree;
+    typedef std::vector<AABB3d> AABBVector;
+
+    // Find the closest item bounding box hit by the ray.
+    struct ClosestHitVisitor
+    {
+        const AABBVector&           m_bboxes;
+        const std::vector<size_t>&  m_ordering;
+        size_t                      m_hit_item;
+        double                      m_hit_distance;
+        size_t                      m_visited_leaves;
+
+        ClosestHitVisitor(
+            const AABBVector&           bboxes,
+            const std::vector<size_t>&  ordering)
+          : m_bboxes(bboxes)
+          , m_ordering(ordering)
+          , m_hit_item(~size_t(0))
+          , m_hit_distance(std::numeric_limits<double>::max())
+          , m_visited_leaves(0)
+        {
+        }
+
+        bool visit(
+            const NodeType&             node,
+            const Ray3d&                ray,
+            const RayInfo3d&            ray_info,
+            double&                     distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , bvh::TraversalStatistics& stats
+#endif
+            )
+        {
+            ++m_visited_leaves;
+
+            const size_t begin = node.get_item_index();
+            const size_t end = begin + node.get_item_count();
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                const size_t item = m_ordering[i];
+
+                double tmin;
+                if (intersect(ray, ray_info, m_bboxes[item], tmin) && tmin < m_hit_distance)
+                {
+                    m_hit_item = item;
+                    m_hit_distance = tmin;
+                }
+            }
+
+            distance = m_hit_distance;
+            return true;
+        }
+    };
+
+    struct Fixture
+    {
+        AABBVector                              m_bboxes;
+        Tree                                    m_tree;
+        std::vector<size_t>                     m_ordering;
+        AlignedVector<bvh::WideNode<AABB3d, 4>> m_wide_nodes4;
+        AlignedVector<bvh::WideNode<AABB3d, 8>> m_wide_nodes8;
+
+        Fixture()
+        {
+            MersenneTwister rng;
+
+            for (size_t i = 0; i < 500; ++i)
+            {
+                Vector3d center;
+                center[0] = rand_double1(rng, -100.0, 100.0);
+                center[1] = rand_double1(rng, -100.0, 100.0);
+                center[2] = rand_double1(rng, -100.0, 100.0);
+
+                const Vector3d extent(rand_double1(rng, 0.1, 5.0));
+                m_bboxes.emplace_back(center - extent, center + extent);
+            }
+
+            typedef bvh::SAHPartitioner<AABBVector> Partitioner;
+            Partitioner partitioner(m_bboxes, 2);
+
+            bvh::Builder<Tree, Partitioner> builder;
+            builder.build<DefaultWallclockTimer>(m_tree, partitioner, m_bboxes.size(), 2);
+            m_ordering = partitioner.get_item_ordering();
+
+            bvh::Collapser<Tree, AlignedVector<bvh::WideNode<AABB3d, 4>>> collapser4;
+            collapser4.collapse<DefaultWallclockTimer>(m_tree, m_wide_nodes4);
+
+            bvh::Collapser<Tree, AlignedVector<bvh::WideNode<AABB3d, 8>>> collapser8;
+            collapser8.collapse<DefaultWallclockTimer>(m_tree, m_wide_nodes8);
+        }
+
+        // Return the number of rays for which wide and binary traversals disagree.
+        template <typename WideNodeVector>
+        size_t compare_with_binary_traversal(const WideNodeVector& wide_nodes)
+        {
+            MersenneTwister rng;
+            size_t mismatch_count = 0;
+
+            for (size_t i = 0; i < 1000; ++i)
+            {
+                Vector2d s;
+                s[0] = rand_double2(rng);
+                s[1] = rand_double2(rng);
+
+                Vector3d org;
+                org[0] = rand_double1(rng, -150.0, 150.0);
+                org[1] = rand_double1(rng, -150.0, 150.0);
+                org[2] = rand_double1(rng, -150.0, 150.0);
+
+                const Ray3d ray(org, sample_sphere_uniform(s));
+                const RayInfo3d ray_info(ray);
+
+                ClosestHitVisitor binary_visitor(m_bboxes, m_ordering);
+                bvh::Intersector<Tree, ClosestHitVisitor, Ray3d> binary_intersector;
+                binary_intersector.intersect_no_motion(m_tree, ray, ray_info, binary_visitor);
+
+                ClosestHitVisitor wide_visitor(m_bboxes, m_ordering);
+                bvh::WideIntersector<Tree, WideNodeVector, ClosestHitVisitor, Ray3d> wide_intersector;
+                wide_intersector.intersect_no_motion(m_tree, wide_nodes, ray, ray_info, wide_visitor);
+
+                if (binary_visitor.m_hit_item != wide_visitor.m_hit_item ||
+                    binary_visitor.m_hit_distance != wide_visitor.m_hit_distance)
+                    ++mismatch_count;
+            }
+
+            return mismatch_count;
+        }
+    };
+
+    TEST_CASE_F(FourWideTraversal_MatchesBinaryTraversal, Fixture)
+    {
+        EXPECT_FALSE(m_wide_nodes4.empty());
+
+        EXPECT_EQ(0, compare_with_binary_traversal(m_wide_nodes4));
+    }
+
+    TEST_CASE_F(EightWideTraversal_MatchesBinaryTraversal, Fixture)
+    {
+        EXPECT_FALSE(m_wide_nodes8.empty());
+        EXPECT_LT(m_wide_nodes4.size(), m_wide_nodes8.size());
+
+        EXPECT_EQ(0, compare_with_binary_traversal(m_wide_nodes8));
+    }
+
+    TEST_CASE(SingleLeafTree_IsVisited)
+    {
+        AABBVector bboxes;
+        bboxes.emplace_back(Vector3d(-1.0), Vector3d(1.0));
+
+        typedef bvh::SAHPartitioner<AABBVector> Partitioner;
+        Partitioner partitioner(bboxes);
+
+        Tree tree;
+        bvh::Builder<Tree, Partitioner> builder;
+        builder.build<DefaultWallclockTimer>(tree, partitioner, bboxes.size(), 1);
+
+        AlignedVector<bvh::WideNode<AABB3d, 4>> wide_nodes;
+        bvh::Collapser<Tree, AlignedVector<bvh::WideNode<AABB3d, 4>>> collapser;
+        collapser.collapse<DefaultWallclockTimer>(tree, wide_nodes);
+
+        EXPECT_TRUE(wide_nodes.empty());
+
+        const Ray3d ray(Vector3d(0.0, 0.0, -5.0), Vector3d(0.0, 0.0, 1.0));
+        ClosestHitVisitor visitor(bboxes, partitioner.get_item_ordering());
+        bvh::WideIntersector<Tree, AlignedVector<bvh::WideNode<AABB3d, 4>>, ClosestHitVisitor, Ray3d> intersector;
+        intersector.intersect_no_motion(tree, wide_nodes, ray, RayInfo3d(ray), visitor);
+
+        EXPECT_EQ(0, visitor.m_hit_item);
+        EXPECT_FEQ(4.0, visitor.m_hit_distance);
+    }
+}
+
+TEST_SUITE(Foundation_Math_BVH_PacketIntersector)
+{
+    typedef bvh::Node<AABB3d> NodeType;
+    typedef bvh::Tree<AlignedVector<NodeType>> Tree;
+    typedef std::vector<AABB3d> AABBVector;
+
+    const size_t PacketSize = 16;
+
+    // Find the closest item bounding box hit by a single ray.
+    struct ClosestHitVisitor
+    {
+        const AABBVector&           m_bboxes;
+        const std::vector<size_t>&  m_ordering;
+        size_t                      m_hit_item;
+        double                      m_hit_distance;
+
+        ClosestHitVisitor(
+            const AABBVector&           bboxes,
+            const std::vector<size_t>&  ordering)
+          : m_bboxes(bboxes)
+          , m_ordering(ordering)
+          , m_hit_item(~size_t(0))
+          , m_hit_distance(std::numeric_limits<double>::max())
+        {
+        }
+
+        bool visit(
+            const NodeType&             node,
+            const Ray3d&                ray,
+            const RayInfo3d&            ray_info,
+            double&                     distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , bvh::TraversalStatistics& stats
+#endif
+            )
+        {
+            for (size_t i = node.get_item_index(), e = i + node.get_item_count(); i < e; ++i)
+            {
+                const size_t item = m_ordering[i];
+
+                double tmin;
+                if (intersect(ray, ray_info, m_bboxes[item], tmin) && tmin < m_hit_distance)
+                {
+                    m_hit_item = item;
+                    m_hit_distance = tmin;
+                }
+            }
+
+            distance = m_hit_distance;
+            return true;
+        }
+    };
+
+    // Find the closest item bounding box hit by every ray of a packet.
+    struct ClosestHitPacketVisitor
+    {
+        const AABBVector&           m_bboxes;
+        const std::vector<size_t>&  m_ordering;
+        size_t                      m_hit_items[PacketSize];
+        double                      m_hit_distances[PacketSize];
+
+        ClosestHitPacketVisitor(
+            const AABBVector&           bboxes,
+            const std::vector<size_t>&  ordering)
+          : m_bboxes(bboxes)
+          , m_ordering(ordering)
+        {
+            for (size_t i = 0; i < PacketSize; ++i)
+            {
+                m_hit_items[i] = ~size_t(0);
+                m_hit_distances[i] = std::numeric_limits<double>::max();
+            }
+        }
+
+        void visit(
+            const NodeType&             node,
+            const Ray3d*                rays,
+            const RayInfo3d*            ray_infos,
+            const size_t*               ray_indices,
+            const size_t                ray_count,
+            double*                     distances
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , bvh::TraversalStatistics& stats
+#endif
+            )
+        {
+            for (size_t i = node.get_item_index(), e = i + node.get_item_count(); i < e; ++i)
+            {
+                const size_t item = m_ordering[i];
+
+                for (size_t j = 0; j < ray_count; ++j)
+                {
+                    const size_t r = ray_indices[j];
+
+                    double tmin;
+                    if (intersect(rays[r], ray_infos[r], m_bboxes[item], tmin) && tmin < m_hit_distances[r])
+                    {
+                        m_hit_items[r] = item;
+                        m_hit_distances[r] = tmin;
+                    }
+                }
+            }
+
+            for (size_t j = 0; j < ray_count; ++j)
+                distances[ray_indices[j]] = m_hit_distances[ray_indices[j]];
+        }
+    };
+
+    struct Fixture
+    {
+        AABBVector                              m_bboxes;
+        Tree                                    m_tree;
+        std::vector<size_t>                     m_ordering;
+
+        Fixture()
+        {
+            MersenneTwister rng;
+
+            for (size_t i = 0; i < 500; ++i)
+            {
+                Vector3d center;
+                center[0] = rand_double1(rng, -100.0, 100.0);
+                center[1] = rand_double1(rng, -100.0, 100.0);
+                center[2] = rand_double1(rng, -100.0, 100.0);
+
+                const Vector3d extent(rand_double1(rng, 0.1, 5.0));
+                m_bboxes.emplace_back(center - extent, center + extent);
+            }
+
+            typedef bvh::SAHPartitioner<AABBVector> Partitioner;
+            Partitioner partitioner(m_bboxes, 2);
+
+            bvh::Builder<Tree, Partitioner> builder;
+            builder.build<DefaultWallclockTimer>(m_tree, partitioner, m_bboxes.size(), 2);
+            m_ordering = partitioner.get_item_ordering();
+        }
+
+        // Return the number of rays for which packet and single ray traversals disagree.
+        // The rays of a packet share the same origin and their directions are spread
+        // around a random direction by up to 'spread' on each axis.
+        size_t compare_with_single_ray_traversal(const double spread)
+        {
+            MersenneTwister rng;
+            size_t mismatch_count = 0;
+
+            for (size_t p = 0; p < 100; ++p)
+            {
+                Vector3d org;
+                org[0] = rand_double1(rng, -150.0, 150.0);
+                org[1] = rand_double1(rng, -150.0, 150.0);
+                org[2] = rand_double1(rng, -150.0, 150.0);
+
+                Vector2d s;
+                s[0] = rand_double2(rng);
+                s[1] = rand_double2(rng);
+                const Vector3d center_dir = sample_sphere_uniform(s);
+
+                Ray3d rays[PacketSize];
+                RayInfo3d ray_infos[PacketSize];
+
+                for (size_t i = 0; i < PacketSize; ++i)
+                {
+                    Vector3d dir;
+                    dir[0] = center_dir[0] + rand_double1(rng, -spread, spread);
+                    dir[1] = center_dir[1] + rand_double1(rng, -spread, spread);
+                    dir[2] = center_dir[2] + rand_double1(rng, -spread, spread);
+
+                    rays[i] = Ray3d(org, normalize(dir));
+                    ray_infos[i] = RayInfo3d(rays[i]);
+                }
+
+                ClosestHitPacketVisitor packet_visitor(m_bboxes, m_ordering);
+                bvh::PacketIntersector<Tree, ClosestHitPacketVisitor, Ray3d, PacketSize> packet_intersector;
+                packet_intersector.intersect_no_motion(m_tree, rays, ray_infos, PacketSize, packet_visitor);
+
+                for (size_t i = 0; i < PacketSize; ++i)
+                {
+                    ClosestHitVisitor visitor(m_bboxes, m_ordering);
+                    bvh::Intersector<Tree, ClosestHitVisitor, Ray3d> intersector;
+                    intersector.intersect_no_motion(m_tree, rays[i], ray_infos[i], visitor);
+
+                    if (visitor.m_hit_item != packet_visitor.m_hit_items[i] ||
+                        visitor.m_hit_distance != packet_visitor.m_hit_distances[i])
+                        ++mismatch_count;
+                }
+            }
+
+            return mismatch_count;
+        }
+    };
+
+    TEST_CASE_F(CoherentPacketTraversal_MatchesSingleRayTraversal, Fixture)
+    {
+        EXPECT_EQ(0, compare_with_single_ray_traversal(0.05));
+    }
+
+    TEST_CASE_F(IncoherentPacketTraversal_MatchesSingleRayTraversal, Fixture)
+    {
+        EXPECT_EQ(0, compare_with_single_ray_traversal(2.0));
+    }
+
+    TEST_CASE(SingleLeafTree_IsVisitedByAllRays)
+    {
+        AABBVector bboxes;
+        bboxes.emplace_back(Vector3d(-1.0), Vector3d(1.0));
+
+        typedef bvh::SAHPartitioner<AABBVector> Partitioner;
+        Partitioner partitioner(bboxes);
+
+        Tree tree;
+        bvh::Builder<Tree, Partitioner> builder;
+        builder.build<DefaultWallclockTimer>(tree, partitioner, bboxes.size(), 1);
+
+        const Ray3d rays[2] =
+        {
+            Ray3d(Vector3d(0.0, 0.0, -5.0), Vector3d(0.0, 0.0, 1.0)),
+            Ray3d(Vector3d(0.0, 0.0, 5.0), Vector3d(0.0, 0.0, -1.0))
+        };
+        const RayInfo3d ray_infos[2] = { RayInfo3d(rays[0]), RayInfo3d(rays[1]) };
+
+        ClosestHitPacketVisitor visitor(bboxes, partitioner.get_item_ordering());
+        bvh::PacketIntersector<Tree, ClosestHitPacketVisitor, Ray3d, PacketSize> intersector;
+        intersector.intersect_no_motion(tree, rays, ray_infos, 2, visitor);
+
+        EXPECT_EQ(0, visitor.m_hit_items[0]);
+        EXPECT_FEQ(4.0, visitor.m_hit_distances[0]);
+        EXPECT_EQ(0, visitor.m_hit_items[1]);
+        EXPECT_FEQ(4.0, visitor.m_hit_distances[1]);
+    }
+}
+
+TEST_SUITE(Foundation_Math_BVH_ParallelBuilder)
+{
+    typedef bvh::Node<AABB3d> NodeType;
+    typedef std::vector<AABB3d> AABBVector;
+    typedef bvh::SAHPartitioner<AABBVector> Partitioner;
+
+    struct TestTree
+      : public bvh::Tree<AlignedVector<NodeType>>
+    {
+        const NodeVectorType& get_nodes() const
+        {
+            return m_nodes;
+        }
+    };
+
+    AABBVector make_random_bboxes(const size_t count)
+    {
+        MersenneTwister rng;
+        AABBVector bboxes;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            Vector3d center;
+            center[0] = rand_double1(rng, -100.0, 100.0);
+            center[1] = rand_double1(rng, -100.0, 100.0);
+            center[2] = rand_double1(rng, -100.0, 100.0);
+
+            const Vector3d extent(rand_double1(rng, 0.01, 1.0));
+            bboxes.emplace_back(center - extent, center + extent);
+        }
+
+        return bboxes;
+    }
+
+    // Return true if two subtrees have the same topology, bounding boxes and leaves.
+    bool are_equal_subtrees(
+        const TestTree&     lhs_tree,
+        const size_t        lhs_index,
+        const TestTree&     rhs_tree,
+        const size_t        rhs_index)
+    {
+        const NodeType& lhs = lhs_tree.get_nodes()[lhs_index];
+        const NodeType& rhs = rhs_tree.get_nodes()[rhs_index];
+
+        if (lhs.is_leaf() != rhs.is_leaf())
+            return false;
+
+        if (lhs.is_leaf())
+        {
+            return
+                lhs.get_item_index() == rhs.get_item_index() &&
+                lhs.get_item_count() == rhs.get_item_count();
+        }
+
+        return
+            lhs.get_left_bbox() == rhs.get_left_bbox() &&
+            lhs.get_right_bbox() == rhs.get_right_bbox() &&
+            are_equal_subtrees(lhs_tree, lhs.get_child_node_index(), rhs_tree, rhs.get_child_node_index()) &&
+            are_equal_subtrees(lhs_tree, lhs.get_child_node_index() + 1, rhs_tree, rhs.get_child_node_index() + 1);
+    }
+
+    struct Fixture
+    {
+        AABBVector              m_bboxes;
+        TestTree                m_reference_tree;
+        std::vector<size_t>     m_reference_ordering;
+
+        Fixture()
+          : m_bboxes(make_random_bboxes(50000))
+        {
+            Partitioner partitioner(m_bboxes, 4);
+            bvh::Builder<TestTree, Partitioner> builder;
+            builder.build<DefaultWallclockTimer>(m_reference_tree, partitioner, m_bboxes.size(), 4);
+            m_reference_ordering = partitioner.get_item_ordering();
+        }
+    };
+
+    TEST_CASE_F(BuildWithWorkerThreads_MatchesSerialBuild, Fixture)
+    {
+        Logger logger;
+        JobQueue job_queue;
+        JobManager job_manager(logger, job_queue, 4, JobManager::KeepRunningOnEmptyQueue);
+        job_manager.start();
+
+        TestTree tree;
+        Partitioner partitioner(m_bboxes, 4);
+        bvh::ParallelBuilder<TestTree, Partitioner> builder;
+        builder.build<DefaultWallclockTimer>(tree, partitioner, m_bboxes.size(), 4, job_queue);
+        job_queue.wait_until_completion();
+
+        EXPECT_GT(1, builder.get_subtree_count());
+        EXPECT_EQ(m_reference_tree.get_nodes().size(), tree.get_nodes().size());
+        EXPECT_EQ(m_reference_ordering, partitioner.get_item_ordering());
+        EXPECT_TRUE(are_equal_subtrees(m_reference_tree, 0, tree, 0));
+    }
+
+    TEST_CASE_F(BuildWithUnservicedJobQueue_MatchesSerialBuild, Fixture)
+    {
+        JobQueue job_queue;
+        job_queue.reserve_lanes(4);
+
+        TestTree tree;
+        Partitioner partitioner(m_bboxes, 4);
+        bvh::ParallelBuilder<TestTree, Partitioner> builder;
+        builder.build<DefaultWallclockTimer>(tree, partitioner, m_bboxes.size(), 4, job_queue);
+
+        EXPECT_GT(1, builder.get_subtree_count());
+        EXPECT_EQ(m_reference_ordering, partitioner.get_item_ordering());
+        EXPECT_TRUE(are_equal_subtrees(m_reference_tree, 0, tree, 0));
+    }
+
+    TEST_CASE(BuildSmallTree_DoesNotCreateSubtrees)
+    {
+        const AABBVector bboxes = make_random_bboxes(100);
+
+        JobQueue job_queue;
+        job_queue.reserve_lanes(4);
+
+        TestTree tree;
+        Partitioner partitioner(bboxes, 4);
+        bvh::ParallelBuilder<TestTree, Partitioner> builder;
+        builder.build<DefaultWallclockTimer>(tree, partitioner, bboxes.size(), 4, job_queue);
+
+        EXPECT_EQ(0, builder.get_subtree_count());
+        EXPECT_FALSE(job_queue.has_scheduled_jobs());
+    }
+}
+
+TEST_SUITE(Foundation_Math_BVH_Refitter)
+{
+    typedef bvh::Node<AABB3d> NodeType;
+    typedef std::vector<AABB3d> AABBVector;
+    typedef bvh::SAHPartitioner<AABBVector> Partitioner;
+
+    struct TestTree
+      : public bvh::Tree<AlignedVector<NodeType>>
+    {
+        const NodeVectorType& get_nodes() const
+        {
+            return m_nodes;
+        }
+    };
+
+    typedef bvh::Refitter<TestTree> Refitter;
+
+    struct LeafBBoxFunc
+    {
+        const AABBVector&           m_bboxes;
+        const std::vector<size_t>&  m_ordering;
+
+        LeafBBoxFunc(
+            const AABBVector&           bboxes,
+            const std::vector<size_t>&  ordering)
+          : m_bboxes(bboxes)
+          , m_ordering(ordering)
+        {
+        }
+
+        AABB3d operator()(const NodeType& leaf) const
+        {
+            AABB3d bbox;
+            bbox.invalidate();
+
+            for (size_t i = 0, e = leaf.get_item_count(); i < e; ++i)
+                bbox.insert(m_bboxes[m_ordering[leaf.get_item_index() + i]]);
+
+            return bbox;
+        }
+    };
+
+    AABBVector make_random_bboxes(MersenneTwister& rng, const size_t count, const double range)
+    {
+        AABBVector bboxes;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            Vector3d center;
+            center[0] = rand_double1(rng, -range, range);
+            center[1] = rand_double1(rng, -range, range);
+            center[2] = rand_double1(rng, -range, range);
+
+            const Vector3d extent(rand_double1(rng, 0.01, 1.0));
+            bboxes.emplace_back(center - extent, center + extent);
+        }
+
+        return bboxes;
+    }
+
+    // Return the bounding box of a subtree if the bounding boxes of its nodes
+    // are exactly those of their items, an invalid bounding box otherwise.
+    AABB3d check_subtree(
+        const TestTree&     tree,
+        const LeafBBoxFunc& leaf_bbox_func,
+        const size_t        node_index)
+    {
+        const NodeType& node = tree.get_nodes()[node_index];
+
+        if (node.is_leaf())
+            return leaf_bbox_func(node);
+
+        const AABB3d left_bbox = check_subtree(tree, leaf_bbox_func, node.get_child_node_index());
+        const AABB3d right_bbox = check_subtree(tree, leaf_bbox_func, node.get_child_node_index() + 1);
+
+        if (!left_bbox.is_valid() || left_bbox != node.get_left_bbox() ||
+            !right_bbox.is_valid() || right_bbox != node.get_right_bbox())
+            return AABB3d::invalid();
+
+        AABB3d bbox(left_bbox);
+        bbox.insert(right_bbox);
+
+        return bbox;
+    }
+
+    struct Fixture
+    {
+        MersenneTwister         m_rng;
+        AABBVector              m_bboxes;
+        TestTree                m_tree;
+        std::vector<size_t>     m_ordering;
+
+        Fixture()
+          : m_bboxes(make_random_bboxes(m_rng, 50000, 100.0))
+        {
+            Partitioner partitioner(m_bboxes, 4);
+            bvh::Builder<TestTree, Partitioner> builder;
+            builder.build<DefaultWallclockTimer>(m_tree, partitioner, m_bboxes.size(), 4);
+            m_ordering = partitioner.get_item_ordering();
+        }
+
+        // Move every item by a small random offset.
+        void jitter_items()
+        {
+            for (size_t i = 0; i < m_bboxes.size(); ++i)
+            {
+                Vector3d offset;
+                offset[0] = rand_double1(m_rng, -0.5, 0.5);
+                offset[1] = rand_double1(m_rng, -0.5, 0.5);
+                offset[2] = rand_double1(m_rng, -0.5, 0.5);
+
+                m_bboxes[i].translate(offset);
+            }
+        }
+    };
+
+    TEST_CASE_F(RefitWithWorkerThreads_MatchesMovedItems, Fixture)
+    {
+        jitter_items();
+
+        Logger logger;
+        JobQueue job_queue;
+        JobManager job_manager(logger, job_queue, 4, JobManager::KeepRunningOnEmptyQueue);
+        job_manager.start();
+
+        const LeafBBoxFunc leaf_bbox_func(m_bboxes, m_ordering);
+        Refitter refitter;
+        const AABB3d root_bbox =
+            refitter.refit<DefaultWallclockTimer>(m_tree, leaf_bbox_func, job_queue);
+        job_queue.wait_until_completion();
+
+        EXPECT_GT(1, refitter.get_subtree_count());
+        EXPECT_EQ(root_bbox, check_subtree(m_tree, leaf_bbox_func, 0));
+    }
+
+    TEST_CASE_F(RefitWithUnservicedJobQueue_MatchesMovedItems, Fixture)
+    {
+        jitter_items();
+
+        JobQueue job_queue;
+        job_queue.reserve_lanes(4);
+
+        const LeafBBoxFunc leaf_bbox_func(m_bboxes, m_ordering);
+        Refitter refitter;
+        const AABB3d root_bbox =
+            refitter.refit<DefaultWallclockTimer>(m_tree, leaf_bbox_func, job_queue);
+
+        EXPECT_EQ(root_bbox, check_subtree(m_tree, leaf_bbox_func, 0));
+    }
+
+    TEST_CASE_F(RefitWithoutMovedItems_PreservesSAHCost, Fixture)
+    {
+        const LeafBBoxFunc leaf_bbox_func(m_bboxes, m_ordering);
+        const AABB3d built_root_bbox = check_subtree(m_tree, leaf_bbox_func, 0);
+        const double built_cost = Refitter::compute_sah_cost(m_tree, built_root_bbox, 1.0, 1.0);
+
+        JobQueue job_queue;
+        Refitter refitter;
+        const AABB3d root_bbox =
+            refitter.refit<DefaultWallclockTimer>(m_tree, leaf_bbox_func, job_queue);
+
+        EXPECT_EQ(built_root_bbox, root_bbox);
+        EXPECT_FEQ(built_cost, Refitter::compute_sah_cost(m_tree, root_bbox, 1.0, 1.0));
+    }
+
+    TEST_CASE_F(RefitAfterScatteringItems_IncreasesSAHCost, Fixture)
+    {
+        const LeafBBoxFunc leaf_bbox_func(m_bboxes, m_ordering);
+        const double built_cost =
+            Refitter::compute_sah_cost(m_tree, check_subtree(m_tree, leaf_bbox_func, 0), 1.0, 1.0);
+
+        // Shuffle the items over the same volume, destroying the spatial coherence of the leaves.
+        m_bboxes = make_random_bboxes(m_rng, m_bboxes.size(), 100.0);
+
+        JobQueue job_queue;
+        Refitter refitter;
+        const AABB3d root_bbox =
+            refitter.refit<DefaultWallclockTimer>(m_tree, leaf_bbox_func, job_queue);
+
+        EXPECT_GT(2.0 * built_cost, Refitter::compute_sah_cost(m_tree, root_bbox, 1.0, 1.0));
+    }
+}
@@ -188,6 +188,21 @@ TEST_SUITE(Foundation_Utility_Cache_LRUCache)
         cache.get(9);   // flushes 6, cache contains 9
         ASSERT_EQ(9000, element_swapper.m_memory_size);
     }
+
+    TEST_CASE(Find_ReturnsElementsInCacheWithoutLoadingMissingOnes)
+    {
+        KeyHasher key_hasher;
+        ElementSwapperTrackingSize element_swapper;
+        LRUCache<Key, KeyHasher, Element, ElementSwapperTrackingSize> cache(key_hasher, element_swapper);
+
+        cache.get(1);
+
+        EXPECT_TRUE(cache.find(1) != nullptr);
+        EXPECT_TRUE(cache.find(2) == nullptr);
+        EXPECT_EQ(1000, element_swapper.m_memory_size);
+        EXPECT_EQ(1, cache.get_hit_count());
+        EXPECT_EQ(1, cache.get_miss_count());
+    }
 }
 
 TEST_SUITE(Foundation_Utility_Cache_DualStageCache)
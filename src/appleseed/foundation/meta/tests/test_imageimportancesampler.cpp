@@ -34,6 +34,7 @@
 #include "foundation/image/genericimagefilereader.h"
 #include "foundation/image/genericimagefilewriter.h"
 #include "foundation/image/image.h"
+#include "foundation/math/aliastable.h"
 #include "foundation/math/qmc.h"
 #include "foundation/math/sampling/imageimportancesampler.h"
 #include "foundation/math/vector.h"
@@ -85,6 +86,51 @@ TEST_SUITE(Foundation_Math_Sampling_ImageImportanceSampler)
         EXPECT_EQ(prob_xy, pdf);
     }
 
+    TEST_CASE(GetPDF_GivenAliasTableDistribution_ReturnsSameProbabilityAsSample)
+    {
+        const size_t Width = 5;
+        const size_t Height = 5;
+
+        ImageImportanceSampler<HorizontalGradientSampler::Payload, float, AliasTable> importance_sampler(Width, Height);
+        HorizontalGradientSampler sampler(Width);
+        importance_sampler.rebuild(sampler);
+
+        for (size_t i = 0; i < 16; ++i)
+        {
+            const size_t Bases[1] = { 2 };
+            const Vector2f s = hammersley_sequence<float, 2>(Bases, 16, i);
+
+            size_t x, y;
+            float prob_xy;
+            importance_sampler.sample(s, x, y, prob_xy);
+
+            EXPECT_NEQ(0, x);   // the first column has zero importance
+            EXPECT_EQ(prob_xy, importance_sampler.get_pdf(x, y));
+        }
+    }
+
+    TEST_CASE(RebuildRows_GivenDisjointRanges_MatchesRebuild)
+    {
+        const size_t Width = 5;
+        const size_t Height = 6;
+
+        HorizontalGradientSampler sampler(Width);
+
+        ImageImportanceSampler<HorizontalGradientSampler::Payload, float> expected(Width, Height);
+        expected.rebuild(sampler);
+
+        ImageImportanceSampler<HorizontalGradientSampler::Payload, float> importance_sampler(Width, Height);
+        importance_sampler.rebuild_rows(sampler, 4, Height);
+        importance_sampler.rebuild_rows(sampler, 0, 4);
+        importance_sampler.rebuild_rows_cdf();
+
+        for (size_t y = 0; y < Height; ++y)
+        {
+            for (size_t x = 0; x < Width; ++x)
+                EXPECT_EQ(expected.get_pdf(x, y), importance_sampler.get_pdf(x, y));
+        }
+    }
+
     void generate_image(
         const char*     input_filename,
         const char*     output_image,
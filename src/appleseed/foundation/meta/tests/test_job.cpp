@@ -294,6 +294,53 @@ TEST_SUITE(Foundation_Utility_Job_JobQueue)
 
         EXPECT_EQ(0, destruction_count);
     }
+
+    TEST_CASE(AcquireScheduledJobPrefersJobsFromOwnLane)
+    {
+        IJob* job0 = new EmptyJob();
+        IJob* job1 = new EmptyJob();
+
+        JobQueue job_queue;
+        job_queue.reserve_lanes(2);
+        job_queue.schedule(job0, true, 0);
+        job_queue.schedule(job1, true, 1);
+
+        const JobQueue::RunningJobInfo running_job_info =
+            job_queue.acquire_scheduled_job(1);
+
+        EXPECT_EQ(job1, running_job_info.first.m_job);
+        EXPECT_EQ(0, job_queue.get_stolen_job_count());
+
+        job_queue.retire_running_job(running_job_info);
+    }
+
+    TEST_CASE(AcquireScheduledJobStealsFromOtherLanes)
+    {
+        IJob* job = new EmptyJob();
+
+        JobQueue job_queue;
+        job_queue.reserve_lanes(2);
+        job_queue.schedule(job, true, 0);
+
+        const JobQueue::RunningJobInfo running_job_info =
+            job_queue.acquire_scheduled_job(1);
+
+        EXPECT_EQ(job, running_job_info.first.m_job);
+        EXPECT_EQ(1, job_queue.get_stolen_job_count());
+        EXPECT_EQ(1, job_queue.get_running_job_count());
+
+        job_queue.retire_running_job(running_job_info);
+    }
+
+    TEST_CASE(ReserveLanesPreservesScheduledJobs)
+    {
+        JobQueue job_queue;
+        job_queue.schedule(new EmptyJob());
+        job_queue.reserve_lanes(4);
+
+        EXPECT_EQ(4, job_queue.get_lane_count());
+        EXPECT_EQ(1, job_queue.get_scheduled_job_count());
+    }
 }
 
 TEST_SUITE(Foundation_Utility_Job_JobManager)
@@ -373,6 +420,25 @@ TEST_SUITE(Foundation_Utility_Job_JobManager)
 
         EXPECT_EQ(1, execution_count);
     }
+
+    TEST_CASE(JobManagerWithManyThreadsExecutesAllJobs)
+    {
+        const size_t JobCount = 1000;
+        volatile std::uint32_t execution_count = 0;
+
+        Logger logger;
+        JobQueue job_queue;
+        JobManager job_manager(logger, job_queue, 8);
+
+        for (size_t i = 0; i < JobCount; ++i)
+            job_queue.schedule(new JobNotifyingAboutExecution(&execution_count));
+
+        job_manager.start();
+        job_queue.wait_until_completion();
+
+        EXPECT_EQ(JobCount, execution_count);
+        EXPECT_EQ(8, job_queue.get_lane_count());
+    }
 }
 
 TEST_SUITE(Foundation_Utility_Job_WorkerThread)
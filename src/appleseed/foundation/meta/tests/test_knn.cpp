@@ -37,6 +37,8 @@
 #include "foundation/math/vector.h"
 #include "foundation/platform/timers.h"
 #include "foundation/utility/iostreamop.h"
+#include "foundation/utility/job.h"
+#include "foundation/utility/log.h"
 #include "foundation/utility/test.h"
 
 // Standard headers.
@@ -142,6 +144,90 @@ TEST_SUITE(Foundation_Math_Knn_Builder)
         knn::Builder3d builder(tree);
         builder.build<DefaultWallclockTimer>(points, PointCount);
     }
+
+    std::vector<Vector3d> make_random_points(const size_t count)
+    {
+        MersenneTwister rng;
+
+        std::vector<Vector3d> points(count);
+        for (size_t i = 0; i < count; ++i)
+            points[i] = rand_vector1<Vector3d>(rng);
+
+        return points;
+    }
+
+    typedef std::vector<knn::Tree3d::NodeType> NodeVector;
+
+    bool are_equal_nodes(const NodeVector& lhs, const NodeVector& rhs)
+    {
+        if (lhs.size() != rhs.size())
+            return false;
+
+        for (size_t i = 0; i < lhs.size(); ++i)
+        {
+            const knn::Tree3d::NodeType& lhs_node = lhs[i];
+            const knn::Tree3d::NodeType& rhs_node = rhs[i];
+
+            if (lhs_node.is_leaf() != rhs_node.is_leaf() ||
+                lhs_node.get_point_index() != rhs_node.get_point_index() ||
+                lhs_node.get_point_count() != rhs_node.get_point_count())
+                return false;
+
+            if (lhs_node.is_interior() &&
+                (lhs_node.get_child_node_index() != rhs_node.get_child_node_index() ||
+                 lhs_node.get_split_dim() != rhs_node.get_split_dim() ||
+                 lhs_node.get_split_abs() != rhs_node.get_split_abs()))
+                return false;
+        }
+
+        return true;
+    }
+
+    struct Fixture
+    {
+        const std::vector<Vector3d>     m_points;
+        knn::Tree3d                     m_reference_tree;
+
+        Fixture()
+          : m_points(make_random_points(100000))
+        {
+            knn::Builder3d builder(m_reference_tree);
+            builder.build<DefaultWallclockTimer>(&m_points[0], m_points.size());
+        }
+    };
+
+    TEST_CASE_F(BuildMovePoints_GivenWorkerThreads_MatchesSerialBuild, Fixture)
+    {
+        Logger logger;
+        JobQueue job_queue;
+        JobManager job_manager(logger, job_queue, 4, JobManager::KeepRunningOnEmptyQueue);
+        job_manager.start();
+
+        std::vector<Vector3d> points(m_points);
+        knn::Tree3d tree;
+        knn::Builder3d builder(tree);
+        builder.build_move_points<DefaultWallclockTimer>(points, job_queue);
+        job_queue.wait_until_completion();
+
+        EXPECT_EQ(m_reference_tree.m_points, tree.m_points);
+        EXPECT_EQ(m_reference_tree.m_indices, tree.m_indices);
+        EXPECT_TRUE(are_equal_nodes(m_reference_tree.m_nodes, tree.m_nodes));
+    }
+
+    TEST_CASE_F(BuildMovePoints_GivenUnservicedJobQueue_MatchesSerialBuild, Fixture)
+    {
+        JobQueue job_queue;
+        job_queue.reserve_lanes(4);
+
+        std::vector<Vector3d> points(m_points);
+        knn::Tree3d tree;
+        knn::Builder3d builder(tree);
+        builder.build_move_points<DefaultWallclockTimer>(points, job_queue);
+
+        EXPECT_EQ(m_reference_tree.m_points, tree.m_points);
+        EXPECT_EQ(m_reference_tree.m_indices, tree.m_indices);
+        EXPECT_TRUE(are_equal_nodes(m_reference_tree.m_nodes, tree.m_nodes));
+    }
 }
 
 TEST_SUITE(Foundation_Math_Knn_Answer)
@@ -67,6 +67,29 @@ namespace
     };
 }
 
+TEST_SUITE(Foundation_Utility_Lazy_Lazy)
+{
+    TEST_CASE(IsCreated_GivenObjectNeverAccessed_ReturnsFalse)
+    {
+        std::unique_ptr<ObjectFactory> factory(new SimpleObjectFactory(42));
+        Lazy<Object> object(std::move(factory));
+
+        EXPECT_FALSE(object.is_created());
+    }
+
+    TEST_CASE(IsCreated_GivenObjectAccessedOnce_ReturnsTrue)
+    {
+        std::unique_ptr<ObjectFactory> factory(new SimpleObjectFactory(42));
+        Lazy<Object> object(std::move(factory));
+
+        {
+            Access<Object> access(&object);
+        }
+
+        EXPECT_TRUE(object.is_created());
+    }
+}
+
 TEST_SUITE(Foundation_Utility_Lazy_Access)
 {
     TEST_CASE(Get_GivenAccessBoundToNonNullObject_ReturnsNonNullPointer)
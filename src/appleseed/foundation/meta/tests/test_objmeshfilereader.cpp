@@ -37,6 +37,8 @@
 
 // Standard headers.
 #include <cstddef>
+#include <cstdio>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -140,6 +142,254 @@ TEST_SUITE(Foundation_Mesh_OBJMeshFileReader)
         EXPECT_EQ(1, mesh.m_faces.size());
     }
 
+    // Record all calls made to the builder, to compare the output of different parsers.
+    struct RecordingMeshBuilder
+      : public MeshBuilderBase
+    {
+        std::stringstream        m_calls;
+
+        RecordingMeshBuilder()
+        {
+            m_calls.precision(17);
+        }
+
+        void begin_mesh(const char* name) override
+        {
+            m_calls << "begin_mesh " << name << "\n";
+        }
+
+        size_t push_vertex(const Vector3d& v) override
+        {
+            m_calls << "push_vertex " << v.x << " " << v.y << " " << v.z << "\n";
+            return m_vertex_count++;
+        }
+
+        size_t push_vertex_normal(const Vector3d& v) override
+        {
+            m_calls << "push_vertex_normal " << v.x << " " << v.y << " " << v.z << "\n";
+            return m_vertex_normal_count++;
+        }
+
+        size_t push_tex_coords(const Vector2d& v) override
+        {
+            m_calls << "push_tex_coords " << v.x << " " << v.y << "\n";
+            return m_tex_coords_count++;
+        }
+
+        size_t push_material_slot(const char* name) override
+        {
+            m_calls << "push_material_slot " << name << "\n";
+            return m_material_slot_count++;
+        }
+
+        void begin_face(const size_t vertex_count) override
+        {
+            m_calls << "begin_face " << vertex_count;
+            m_face_vertex_count = vertex_count;
+        }
+
+        void set_face_vertices(const size_t vertices[]) override
+        {
+            record_indices(" v", vertices);
+        }
+
+        void set_face_vertex_normals(const size_t vertex_normals[]) override
+        {
+            record_indices(" n", vertex_normals);
+        }
+
+        void set_face_vertex_tex_coords(const size_t tex_coords[]) override
+        {
+            record_indices(" t", tex_coords);
+        }
+
+        void set_face_material(const size_t material) override
+        {
+            m_calls << " m " << material;
+        }
+
+        void end_face() override
+        {
+            m_calls << "\n";
+        }
+
+        void end_mesh() override
+        {
+            m_calls << "end_mesh\n";
+            m_vertex_count = m_vertex_normal_count = m_tex_coords_count = m_material_slot_count = 0;
+        }
+
+      private:
+        size_t m_vertex_count = 0;
+        size_t m_vertex_normal_count = 0;
+        size_t m_tex_coords_count = 0;
+        size_t m_material_slot_count = 0;
+        size_t m_face_vertex_count = 0;
+
+        void record_indices(const char* prefix, const size_t indices[])
+        {
+            m_calls << prefix;
+            for (size_t i = 0; i < m_face_vertex_count; ++i)
+                m_calls << " " << indices[i];
+        }
+    };
+
+    // Read a file and return the calls made to the builder, followed by the parse error, if any.
+    std::string read_and_record(const char* filename, const int options, const size_t thread_count = 4)
+    {
+        RecordingMeshBuilder builder;
+
+        try
+        {
+            OBJMeshFileReader reader(filename, options, thread_count);
+            reader.read(builder);
+        }
+        catch (const OBJMeshFileReader::ExceptionInvalidFaceDef& e)
+        {
+            builder.m_calls << "invalid face at line " << e.m_line << "\n";
+        }
+        catch (const OBJMeshFileReader::ExceptionParseError& e)
+        {
+            builder.m_calls << "parse error at line " << e.m_line << "\n";
+        }
+
+        return builder.m_calls.str();
+    }
+
+    // Write a file large enough to be split into several chunks by the parallel parser.
+    void write_large_mesh_file(const char* filename, const char* trailer)
+    {
+        FILE* f = fopen(filename, "wt");
+        assert(f);
+
+        const size_t GroupCount = 8;
+        const size_t Resolution = 40;
+        const size_t VertexCount = (Resolution + 1) * (Resolution + 1);
+
+        fprintf(f, "# Grids with mixed face definitions.\n\n");
+
+        for (size_t g = 0; g < GroupCount; ++g)
+        {
+            fprintf(f, "o grid %u\n", static_cast<unsigned int>(g / 2));
+            fprintf(f, "usemtl material_%u\n", static_cast<unsigned int>(g % 3));
+
+            for (size_t y = 0; y <= Resolution; ++y)
+            {
+                for (size_t x = 0; x <= Resolution; ++x)
+                {
+                    const double u = static_cast<double>(x) / Resolution;
+                    const double v = static_cast<double>(y) / Resolution;
+                    fprintf(f, "v %.9f %.9f %.9f\n", u + g, 0.125 * u * v, v);
+                    fprintf(f, "vt %.9f %.9f\n", u, v);
+                }
+            }
+
+            fprintf(f, "vn 0 1 0   # shared normal\n\n");
+
+            for (size_t y = 0; y < Resolution; ++y)
+            {
+                for (size_t x = 0; x < Resolution; ++x)
+                {
+                    const long v0 = static_cast<long>(y * (Resolution + 1) + x);
+                    const long v1 = v0 + 1;
+                    const long v2 = v1 + static_cast<long>(Resolution) + 1;
+                    const long v3 = v0 + static_cast<long>(Resolution) + 1;
+
+                    if (x == Resolution / 2 && y % 8 == 0)
+                        fprintf(f, "usemtl material_%u\n", static_cast<unsigned int>((g + y) % 3));
+
+                    if (g % 2 == 0)
+                    {
+                        // Absolute indices.
+                        const long base = static_cast<long>(g * VertexCount) + 1;
+                        fprintf(
+                            f, "f %ld/%ld/%ld %ld/%ld/%ld %ld/%ld/%ld %ld/%ld/%ld\n",
+                            base + v0, base + v0, static_cast<long>(g) + 1,
+                            base + v1, base + v1, static_cast<long>(g) + 1,
+                            base + v2, base + v2, static_cast<long>(g) + 1,
+                            base + v3, base + v3, static_cast<long>(g) + 1);
+                    }
+                    else
+                    {
+                        // Relative indices.
+                        const long count = static_cast<long>(VertexCount);
+                        fprintf(
+                            f, "f %ld//-1 %ld//-1 %ld//-1\nf %ld %ld %ld\n",
+                            v0 - count, v1 - count, v2 - count,
+                            v2 - count, v3 - count, v0 - count);
+                    }
+                }
+            }
+
+            // An ill-formed face, ignored unless StopOnInvalidFaceDef is set.
+            fprintf(f, "f 1 2\n");
+        }
+
+        fputs(trailer, f);
+
+        fclose(f);
+    }
+
+    TEST_CASE(ParallelParsing_GivenCubeMeshFile_MatchesStreamingParser)
+    {
+        const char* Filename = "unit tests/inputs/test_objmeshfilereader_cube.obj";
+
+        const std::string expected = read_and_record(Filename, OBJMeshFileReader::Default);
+        const std::string result = read_and_record(Filename, OBJMeshFileReader::ParallelParsing);
+
+        EXPECT_EQ(expected, result);
+    }
+
+    TEST_CASE(ParallelParsing_GivenLargeMeshFile_MatchesStreamingParser)
+    {
+        const char* Filename = "unit tests/outputs/test_objmeshfilereader_large.obj";
+        write_large_mesh_file(Filename, "");
+
+        const std::string expected =
+            read_and_record(Filename, OBJMeshFileReader::FavorSpeedOverPrecision);
+        const std::string result =
+            read_and_record(Filename, OBJMeshFileReader::FavorSpeedOverPrecision | OBJMeshFileReader::ParallelParsing);
+
+        EXPECT_EQ(expected, result);
+    }
+
+    TEST_CASE(ParallelParsing_GivenLargeMeshFileAndSingleThread_MatchesStreamingParser)
+    {
+        const char* Filename = "unit tests/outputs/test_objmeshfilereader_large.obj";
+        write_large_mesh_file(Filename, "");
+
+        const std::string expected =
+            read_and_record(Filename, OBJMeshFileReader::FavorSpeedOverPrecision);
+        const std::string result =
+            read_and_record(Filename, OBJMeshFileReader::FavorSpeedOverPrecision | OBJMeshFileReader::ParallelParsing, 1);
+
+        EXPECT_EQ(expected, result);
+    }
+
+    TEST_CASE(ParallelParsing_GivenInvalidFaceAndStopOnInvalidFaceDef_MatchesStreamingParser)
+    {
+        const char* Filename = "unit tests/outputs/test_objmeshfilereader_large.obj";
+        write_large_mesh_file(Filename, "");
+
+        const std::string expected =
+            read_and_record(Filename, OBJMeshFileReader::StopOnInvalidFaceDef);
+        const std::string result =
+            read_and_record(Filename, OBJMeshFileReader::StopOnInvalidFaceDef | OBJMeshFileReader::ParallelParsing);
+
+        EXPECT_EQ(expected, result);
+    }
+
+    TEST_CASE(ParallelParsing_GivenOutOfRangeIndexAtEndOfFile_MatchesStreamingParser)
+    {
+        const char* Filename = "unit tests/outputs/test_objmeshfilereader_large_invalid.obj";
+        write_large_mesh_file(Filename, "o last\nf 1 2 3\nf 1 2 100000\nf 1 2 3");
+
+        const std::string expected = read_and_record(Filename, OBJMeshFileReader::Default);
+        const std::string result = read_and_record(Filename, OBJMeshFileReader::ParallelParsing);
+
+        EXPECT_EQ(expected, result);
+    }
+
 #if 0
 
     TEST_CASE(OBJFileToCPPFile)
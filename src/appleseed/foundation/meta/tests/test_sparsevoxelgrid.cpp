@@ -0,0 +1,146 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+// appleseed.foundation headers.
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/math/sparsevoxelgrid.h"
+#include "foundation/math/vector.h"
+#include "foundation/math/voxelgrid.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+
+using namespace foundation;
+
+TEST_SUITE(Foundation_Math_SparseVoxelGrid3)
+{
+    TEST_CASE(Constructor_AllocatesNoBrick)
+    {
+        const SparseVoxelGrid3<float, double> grid(20, 10, 5, 2);
+
+        EXPECT_EQ(3, grid.get_brick_xres());
+        EXPECT_EQ(2, grid.get_brick_yres());
+        EXPECT_EQ(1, grid.get_brick_zres());
+        EXPECT_EQ(0, grid.get_allocated_brick_count());
+    }
+
+    TEST_CASE(Voxel_GivenUnallocatedBrick_ReturnsZeros)
+    {
+        const SparseVoxelGrid3<float, double> grid(20, 10, 5, 2);
+
+        const float* values = grid.voxel(13, 4, 2);
+
+        EXPECT_EQ(0.0f, values[0]);
+        EXPECT_EQ(0.0f, values[1]);
+    }
+
+    TEST_CASE(Voxel_GivenWrite_AllocatesEnclosingBrickOnly)
+    {
+        SparseVoxelGrid3<float, double> grid(20, 10, 5, 2);
+
+        grid.voxel(13, 4, 2)[1] = 42.0f;
+
+        EXPECT_EQ(1, grid.get_allocated_brick_count());
+        EXPECT_TRUE(grid.has_brick(1, 0, 0));
+        EXPECT_FALSE(grid.has_brick(0, 0, 0));
+        EXPECT_EQ(0.0f, grid.voxel(13, 4, 2)[0]);
+        EXPECT_EQ(42.0f, grid.voxel(13, 4, 2)[1]);
+        EXPECT_EQ(0.0f, grid.voxel(12, 4, 2)[1]);
+    }
+
+    struct Fixture
+    {
+        static const size_t Resolution = 19;
+
+        VoxelGrid3<float, double>       m_dense_grid;
+        SparseVoxelGrid3<float, double> m_sparse_grid;
+
+        Fixture()
+          : m_dense_grid(Resolution, Resolution, Resolution, 1)
+          , m_sparse_grid(Resolution, Resolution, Resolution, 1)
+        {
+            MersenneTwister rng;
+
+            // Only fill a corner of the grid, straddling several bricks.
+            for (size_t z = 0; z < 10; ++z)
+            {
+                for (size_t y = 0; y < 10; ++y)
+                {
+                    for (size_t x = 0; x < 10; ++x)
+                    {
+                        const float value = rand_float1(rng);
+                        m_dense_grid.voxel(x, y, z)[0] = value;
+                        m_sparse_grid.voxel(x, y, z)[0] = value;
+                    }
+                }
+            }
+        }
+    };
+
+    TEST_CASE_F(NearestLookup_MatchesDenseGrid, Fixture)
+    {
+        MersenneTwister rng;
+
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            const Vector3d point(rand_double1(rng), rand_double1(rng), rand_double1(rng));
+
+            float expected, value;
+            m_dense_grid.nearest_lookup(point, &expected);
+            m_sparse_grid.nearest_lookup(point, &value);
+
+            EXPECT_EQ(expected, value);
+        }
+    }
+
+    TEST_CASE_F(LinearLookup_MatchesDenseGrid, Fixture)
+    {
+        MersenneTwister rng;
+
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            const Vector3d point(rand_double1(rng), rand_double1(rng), rand_double1(rng));
+
+            float expected, value;
+            m_dense_grid.linear_lookup(point, &expected);
+            m_sparse_grid.linear_lookup(point, &value);
+
+            EXPECT_FEQ(expected, value);
+        }
+    }
+
+    TEST_CASE_F(GetMemorySize_IsSmallerThanDenseGrid, Fixture)
+    {
+        EXPECT_EQ(8, m_sparse_grid.get_allocated_brick_count());
+        EXPECT_LT(Resolution * Resolution * Resolution * sizeof(float), m_sparse_grid.get_memory_size());
+    }
+}
@@ -102,6 +102,9 @@ void JobManager::start()
     // Create worker threads if they don't already exist.
     if (impl->m_worker_threads.empty())
     {
+        // Give each worker thread its own lane in the job queue.
+        impl->m_job_queue.reserve_lanes(impl->m_thread_count);
+
         for (size_t i = 0; i < impl->m_thread_count; ++i)
         {
             impl->m_worker_threads.push_back(
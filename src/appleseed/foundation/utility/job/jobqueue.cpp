@@ -33,15 +33,17 @@
 // appleseed.foundation headers.
 #include "foundation/platform/thread.h"
 #include "foundation/utility/foreach.h"
-#include "foundation/utility/iterators.h"
 #include "foundation/utility/job/abortswitch.h"
 #include "foundation/utility/job/ijob.h"
 
 // Boost headers.
+#include "boost/atomic/atomic.hpp"
 #include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
 
 // Standard headers.
 #include <cassert>
+#include <deque>
 
 namespace foundation
 {
@@ -52,20 +54,148 @@ namespace foundation
 
 struct JobQueue::Impl
 {
+    typedef std::deque<JobInfo> JobDeque;
+
+    struct Lane
+    {
+        boost::mutex                m_mutex;
+        JobDeque                    m_jobs;
+
+        // Keep lanes on separate cache lines to avoid false sharing between worker threads.
+        char                        m_padding[64];
+    };
+
     mutable boost::mutex            m_mutex;
-    boost::condition_variable_any   m_event;
-    JobList                         m_scheduled_jobs;
-    JobList                         m_running_jobs;
+    boost::condition_variable_any   m_job_event;
+    boost::condition_variable_any   m_completion_event;
+
+    // Lanes are never moved nor deleted before the queue is destructed,
+    // so they can be accessed without locking once m_lane_count covers them.
+    Lane*                           m_lanes[MaxLaneCount];
+    boost::atomic<size_t>           m_lane_count;
+    boost::atomic<size_t>           m_next_lane;
+
+    boost::atomic<size_t>           m_scheduled_job_count;
+    boost::atomic<size_t>           m_running_job_count;
+    boost::atomic<size_t>           m_stolen_job_count;
+    boost::atomic<size_t>           m_idle_worker_count;
+    boost::atomic<size_t>           m_completion_waiter_count;
+
+    Impl()
+      : m_lane_count(1)
+      , m_next_lane(0)
+      , m_scheduled_job_count(0)
+      , m_running_job_count(0)
+      , m_stolen_job_count(0)
+      , m_idle_worker_count(0)
+      , m_completion_waiter_count(0)
+    {
+        m_lanes[0] = new Lane();
+    }
 
-    static void delete_jobs(JobList& list)
+    ~Impl()
     {
-        for (each<JobList> i = list; i; ++i)
+        const size_t lane_count = m_lane_count;
+
+        for (size_t i = 0; i < lane_count; ++i)
+            delete m_lanes[i];
+    }
+
+    static size_t delete_jobs(JobDeque& jobs)
+    {
+        const size_t job_count = jobs.size();
+
+        for (each<JobDeque> i = jobs; i; ++i)
         {
             if (i->m_owned)
                 delete i->m_job;
         }
 
-        list.clear();
+        jobs.clear();
+
+        return job_count;
+    }
+
+    size_t delete_scheduled_jobs()
+    {
+        const size_t lane_count = m_lane_count;
+        size_t deleted_job_count = 0;
+
+        for (size_t i = 0; i < lane_count; ++i)
+        {
+            Lane& lane = *m_lanes[i];
+            boost::mutex::scoped_lock lock(lane.m_mutex);
+            deleted_job_count += delete_jobs(lane.m_jobs);
+        }
+
+        m_scheduled_job_count -= deleted_job_count;
+
+        return deleted_job_count;
+    }
+
+    size_t select_lane(const size_t locality_hint)
+    {
+        const size_t lane_count = m_lane_count;
+
+        return
+            locality_hint == NoLocality
+                ? m_next_lane.fetch_add(1, boost::memory_order_relaxed) % lane_count
+                : locality_hint % lane_count;
+    }
+
+    RunningJobInfo take_scheduled_job(const size_t lane_index)
+    {
+        const size_t lane_count = m_lane_count;
+        const size_t own_lane_index = lane_index % lane_count;
+
+        // Take the oldest job from our own lane, to preserve scheduling order.
+        {
+            Lane& lane = *m_lanes[own_lane_index];
+            boost::mutex::scoped_lock lock(lane.m_mutex);
+
+            if (!lane.m_jobs.empty())
+            {
+                const JobInfo job_info = lane.m_jobs.front();
+                lane.m_jobs.pop_front();
+                return make_running(job_info, own_lane_index);
+            }
+        }
+
+        // Steal the youngest job from another lane.
+        for (size_t i = 1; i < lane_count; ++i)
+        {
+            const size_t victim_lane_index = (own_lane_index + i) % lane_count;
+            Lane& lane = *m_lanes[victim_lane_index];
+            boost::mutex::scoped_lock lock(lane.m_mutex);
+
+            if (!lane.m_jobs.empty())
+            {
+                const JobInfo job_info = lane.m_jobs.back();
+                lane.m_jobs.pop_back();
+                ++m_stolen_job_count;
+                return make_running(job_info, victim_lane_index);
+            }
+        }
+
+        return RunningJobInfo(JobInfo(nullptr, false), own_lane_index);
+    }
+
+    RunningJobInfo make_running(const JobInfo& job_info, const size_t lane_index)
+    {
+        // Increment the running job count first so that the total job count never drops to zero in between.
+        ++m_running_job_count;
+        --m_scheduled_job_count;
+
+        return RunningJobInfo(job_info, lane_index);
+    }
+
+    void notify_completion_waiters()
+    {
+        if (m_completion_waiter_count > 0)
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            m_completion_event.notify_all();
+        }
     }
 };
 
@@ -79,142 +209,176 @@ JobQueue::~JobQueue()
     // We assume that worker threads are not running, so we don't lock.
 
     // At this point, no job must be running.
-    assert(impl->m_running_jobs.empty());
+    assert(impl->m_running_job_count == 0);
 
     // Delete all scheduled jobs that the queue owns.
-    Impl::delete_jobs(impl->m_scheduled_jobs);
+    impl->delete_scheduled_jobs();
 
     delete impl;
 }
 
 void JobQueue::clear_scheduled_jobs()
 {
-    boost::mutex::scoped_lock lock(impl->m_mutex);
+    impl->delete_scheduled_jobs();
 
-    impl->delete_jobs(impl->m_scheduled_jobs);
-
-    // Notify worker threads that all scheduled jobs are gone.
-    impl->m_event.notify_all();
+    // Notify worker threads and waiters that all scheduled jobs are gone.
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+    impl->m_job_event.notify_all();
+    impl->m_completion_event.notify_all();
 }
 
 bool JobQueue::has_scheduled_jobs() const
 {
-    boost::mutex::scoped_lock lock(impl->m_mutex);
-
-    return !impl->m_scheduled_jobs.empty();
+    return impl->m_scheduled_job_count > 0;
 }
 
 bool JobQueue::has_running_jobs() const
 {
-    boost::mutex::scoped_lock lock(impl->m_mutex);
-
-    return !impl->m_running_jobs.empty();
+    return impl->m_running_job_count > 0;
 }
 
 bool JobQueue::has_scheduled_or_running_jobs() const
 {
-    boost::mutex::scoped_lock lock(impl->m_mutex);
-
-    return !impl->m_scheduled_jobs.empty() || !impl->m_running_jobs.empty();
+    return get_total_job_count() > 0;
 }
 
 size_t JobQueue::get_scheduled_job_count() const
 {
-    boost::mutex::scoped_lock lock(impl->m_mutex);
-
-    return impl->m_scheduled_jobs.size();
+    return impl->m_scheduled_job_count;
 }
 
 size_t JobQueue::get_running_job_count() const
 {
-    boost::mutex::scoped_lock lock(impl->m_mutex);
-
-    return impl->m_running_jobs.size();
+    return impl->m_running_job_count;
 }
 
 size_t JobQueue::get_total_job_count() const
+{
+    // Read the scheduled job count first: jobs become running before they stop being scheduled,
+    // so a job that is no longer counted as scheduled is already counted as running.
+    const size_t scheduled_job_count = impl->m_scheduled_job_count.load(boost::memory_order_acquire);
+    const size_t running_job_count = impl->m_running_job_count.load(boost::memory_order_acquire);
+    return scheduled_job_count + running_job_count;
+}
+
+size_t JobQueue::get_lane_count() const
+{
+    return impl->m_lane_count;
+}
+
+void JobQueue::reserve_lanes(const size_t lane_count)
 {
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
-    return impl->m_scheduled_jobs.size() + impl->m_running_jobs.size();
+    const size_t target_lane_count = lane_count < MaxLaneCount ? lane_count : MaxLaneCount;
+
+    // Publish each new lane only once it is fully constructed.
+    for (size_t i = impl->m_lane_count; i < target_lane_count; ++i)
+    {
+        impl->m_lanes[i] = new Impl::Lane();
+        impl->m_lane_count = i + 1;
+    }
 }
 
-void JobQueue::schedule(IJob* job, const bool transfer_ownership)
+size_t JobQueue::get_stolen_job_count() const
+{
+    return impl->m_stolen_job_count;
+}
+
+void JobQueue::schedule(
+    IJob*           job,
+    const bool      transfer_ownership,
+    const size_t    locality_hint)
 {
     assert(job);
 
-    boost::mutex::scoped_lock lock(impl->m_mutex);
+    // Account for the job before it becomes visible to worker threads.
+    ++impl->m_scheduled_job_count;
 
-    impl->m_scheduled_jobs.push_back(JobInfo(job, transfer_ownership));
+    Impl::Lane& lane = *impl->m_lanes[impl->select_lane(locality_hint)];
 
-    // Notify worker threads that a new scheduled job is available.
-    impl->m_event.notify_all();
+    {
+        boost::mutex::scoped_lock lock(lane.m_mutex);
+        lane.m_jobs.push_back(JobInfo(job, transfer_ownership));
+    }
+
+    // Notify an idle worker thread that a new scheduled job is available.
+    if (impl->m_idle_worker_count > 0)
+    {
+        boost::mutex::scoped_lock lock(impl->m_mutex);
+        impl->m_job_event.notify_one();
+    }
 }
 
 void JobQueue::wait_until_completion()
 {
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
-    // Wait until there is no more scheduled or running jobs.
-    while (!impl->m_scheduled_jobs.empty() || !impl->m_running_jobs.empty())
-        impl->m_event.wait(lock);
-}
+    ++impl->m_completion_waiter_count;
 
-JobQueue::RunningJobInfo JobQueue::acquire_scheduled_job()
-{
-    boost::mutex::scoped_lock lock(impl->m_mutex);
+    // Wait until there is no more scheduled or running jobs.
+    while (has_scheduled_or_running_jobs())
+        impl->m_completion_event.wait(lock);
 
-    return acquire_scheduled_job_no_lock();
+    --impl->m_completion_waiter_count;
 }
 
-JobQueue::RunningJobInfo JobQueue::acquire_scheduled_job_no_lock()
+JobQueue::RunningJobInfo JobQueue::acquire_scheduled_job(const size_t lane_index)
 {
     // Bail out if there is no scheduled job.
-    if (impl->m_scheduled_jobs.empty())
-        return RunningJobInfo(JobInfo(nullptr, false), impl->m_running_jobs.end());
-
-    // Move the next scheduled job to the end of the queue of running jobs.
-    const JobInfo job_info = impl->m_scheduled_jobs.front();
-    impl->m_scheduled_jobs.pop_front();
-    impl->m_running_jobs.push_back(job_info);
-
-    // Notify worker threads that a job has moved from the scheduled to the running state.
-    impl->m_event.notify_all();
+    if (impl->m_scheduled_job_count == 0)
+        return RunningJobInfo(JobInfo(nullptr, false), lane_index);
 
-    return RunningJobInfo(job_info, pred(impl->m_running_jobs.end()));
+    return impl->take_scheduled_job(lane_index);
 }
 
-JobQueue::RunningJobInfo JobQueue::wait_for_scheduled_job(AbortSwitch& abort_switch)
+JobQueue::RunningJobInfo JobQueue::wait_for_scheduled_job(
+    AbortSwitch&    abort_switch,
+    const size_t    lane_index)
 {
-    boost::mutex::scoped_lock lock(impl->m_mutex);
+    while (!abort_switch.is_aborted())
+    {
+        if (impl->m_scheduled_job_count > 0)
+        {
+            const RunningJobInfo running_job_info = impl->take_scheduled_job(lane_index);
 
-    // Wait for a scheduled job to be available.
-    while (!abort_switch.is_aborted() && impl->m_scheduled_jobs.empty())    // order matters
-        impl->m_event.wait(lock);
+            if (running_job_info.first.m_job)
+                return running_job_info;
 
-    return acquire_scheduled_job_no_lock();
+            // A job is in the process of being scheduled or acquired by another thread.
+            boost::this_thread::yield();
+            continue;
+        }
+
+        // Wait for a scheduled job to be available.
+        boost::mutex::scoped_lock lock(impl->m_mutex);
+        ++impl->m_idle_worker_count;
+        while (!abort_switch.is_aborted() && impl->m_scheduled_job_count == 0)    // order matters
+            impl->m_job_event.wait(lock);
+        --impl->m_idle_worker_count;
+    }
+
+    return RunningJobInfo(JobInfo(nullptr, false), lane_index);
 }
 
 void JobQueue::retire_running_job(const RunningJobInfo& running_job_info)
 {
-    boost::mutex::scoped_lock lock(impl->m_mutex);
-
-    // Remove the job from the running list.
-    impl->m_running_jobs.erase(running_job_info.second);
-
     // Delete the job.
     if (running_job_info.first.m_owned)
         delete running_job_info.first.m_job;
 
-    // Notify worker threads that a scheduled job was retired.
-    impl->m_event.notify_all();
+    --impl->m_running_job_count;
+
+    // Notify waiters that a running job was retired.
+    impl->notify_completion_waiters();
 }
 
 void JobQueue::signal_event()
 {
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
-    impl->m_event.notify_all();
+    impl->m_job_event.notify_all();
+    impl->m_completion_event.notify_all();
 }
 
 }   // namespace foundation
@@ -31,7 +31,6 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
-#include "foundation/utility/poolallocator.h"
 #include "foundation/utility/test.h"
 
 // appleseed.main headers.
@@ -39,7 +38,6 @@
 
 // Standard headers.
 #include <cstddef>
-#include <list>
 #include <utility>
 
 // Forward declarations.
@@ -52,6 +50,8 @@ DECLARE_TEST_CASE(Foundation_Utility_Job_JobQueue, AcquireScheduledJobWorksOnNon
 DECLARE_TEST_CASE(Foundation_Utility_Job_JobQueue, RetiringRunningJobWorks);
 DECLARE_TEST_CASE(Foundation_Utility_Job_JobQueue, RunningJobOwnedByQueueIsDestructedWhenRetired);
 DECLARE_TEST_CASE(Foundation_Utility_Job_JobQueue, RunningJobNotOwnedByQueueIsNotDestructedWhenRetired);
+DECLARE_TEST_CASE(Foundation_Utility_Job_JobQueue, AcquireScheduledJobPrefersJobsFromOwnLane);
+DECLARE_TEST_CASE(Foundation_Utility_Job_JobQueue, AcquireScheduledJobStealsFromOtherLanes);
 
 namespace foundation
 {
@@ -66,12 +66,24 @@ namespace foundation
 //   - scheduled: the job was inserted into the job queue, but hasn't yet been executed
 //   - running: the job is currently being executed
 //
+// Scheduled jobs are distributed over a number of lanes, typically one per worker
+// thread. Each lane is protected by its own lock. A worker thread first takes jobs
+// from its own lane, in scheduling order, and steals jobs from the back of other
+// lanes when its own lane is empty. Job counters are atomic, so that querying the
+// state of the queue never contends with job acquisition.
+//
 
 class APPLESEED_DLLSYMBOL JobQueue
   : public NonCopyable
 {
   public:
-    // Constructor.
+    // Locality hint value meaning that the job may be executed by any worker thread.
+    static const size_t NoLocality = ~size_t(0);
+
+    // Maximum number of lanes; worker threads beyond this number share lanes.
+    static const size_t MaxLaneCount = 256;
+
+    // Constructor. The queue initially has a single lane.
     JobQueue();
 
     // Destructor. All scheduled jobs are deleted. Not thread-safe.
@@ -98,9 +110,25 @@ class APPLESEED_DLLSYMBOL JobQueue
     // Return the number of scheduled and running jobs in the job queue.
     size_t get_total_job_count() const;
 
+    // Return the number of lanes of the job queue.
+    size_t get_lane_count() const;
+
+    // Make sure the job queue has at least lane_count lanes. Existing lanes and
+    // their scheduled jobs are preserved. Called by JobManager::start().
+    void reserve_lanes(const size_t lane_count);
+
+    // Return the number of jobs that were stolen by a worker thread from another lane.
+    size_t get_stolen_job_count() const;
+
     // Schedule a job for execution. Ownership of the job is transfered
     // to the job queue if and only if transfer_ownership is true.
-    void schedule(IJob* job, const bool transfer_ownership = true);
+    // If locality_hint is set to the index of a worker thread, the job is
+    // placed into the lane of this worker thread (other worker threads may
+    // still steal it); otherwise lanes are filled in a round-robin fashion.
+    void schedule(
+        IJob*           job,
+        const bool      transfer_ownership = true,
+        const size_t    locality_hint = NoLocality);
 
     // Wait until all scheduled and running jobs are completed.
     void wait_until_completion();
@@ -116,6 +144,8 @@ class APPLESEED_DLLSYMBOL JobQueue
     GRANT_ACCESS_TO_TEST_CASE(Foundation_Utility_Job_JobQueue, RetiringRunningJobWorks);
     GRANT_ACCESS_TO_TEST_CASE(Foundation_Utility_Job_JobQueue, RunningJobOwnedByQueueIsDestructedWhenRetired);
     GRANT_ACCESS_TO_TEST_CASE(Foundation_Utility_Job_JobQueue, RunningJobNotOwnedByQueueIsNotDestructedWhenRetired);
+    GRANT_ACCESS_TO_TEST_CASE(Foundation_Utility_Job_JobQueue, AcquireScheduledJobPrefersJobsFromOwnLane);
+    GRANT_ACCESS_TO_TEST_CASE(Foundation_Utility_Job_JobQueue, AcquireScheduledJobStealsFromOtherLanes);
 
     struct JobInfo
     {
@@ -129,18 +159,17 @@ class APPLESEED_DLLSYMBOL JobQueue
         }
     };
 
-    typedef std::list<JobInfo, PoolAllocator<JobInfo, 64>> JobList;
-
-    typedef std::pair<JobInfo, JobList::iterator> RunningJobInfo;
+    // A running job and the index of the lane it was acquired from.
+    typedef std::pair<JobInfo, size_t> RunningJobInfo;
 
     // Acquire a scheduled job and change its state from 'scheduled' to 'running'.
-    RunningJobInfo acquire_scheduled_job();
-
-    // Acquire a scheduled job without any locking.
-    RunningJobInfo acquire_scheduled_job_no_lock();
+    // Jobs are taken from the given lane first, then stolen from other lanes.
+    RunningJobInfo acquire_scheduled_job(const size_t lane_index = 0);
 
     // Wait for a scheduled job to be available.
-    RunningJobInfo wait_for_scheduled_job(AbortSwitch& abort_switch);
+    RunningJobInfo wait_for_scheduled_job(
+        AbortSwitch&    abort_switch,
+        const size_t    lane_index);
 
     // Retire a running job. The job is deleted if it is owned by the queue.
     void retire_running_job(const RunningJobInfo& running_job_info);
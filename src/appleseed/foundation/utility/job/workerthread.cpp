@@ -168,9 +168,9 @@ void WorkerThread::run()
                 m_pause_event.wait(lock);
         }
 
-        // Acquire a job.
+        // Acquire a job, preferably from the lane of this worker thread.
         const JobQueue::RunningJobInfo running_job_info =
-            m_job_queue.wait_for_scheduled_job(m_abort_switch);
+            m_job_queue.wait_for_scheduled_job(m_abort_switch, m_index);
 
         // Handle the case where the job queue is empty.
         if (running_job_info.first.m_job == nullptr)
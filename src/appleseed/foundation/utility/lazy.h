@@ -98,10 +98,13 @@ class Lazy
     // Return the source object associated with that lazy object, if any.
     ObjectType* get_source_object() const;
 
+    // Return true if the object was created, i.e. if it was accessed at least once.
+    bool is_created() const;
+
   private:
     template <typename> friend class Access;
 
-    boost::mutex    m_mutex;
+    mutable boost::mutex m_mutex;
     int             m_reference_count;
 
     FactoryType*    m_factory;
@@ -386,6 +389,13 @@ inline typename Lazy<Object>::ObjectType* Lazy<Object>::get_source_object() cons
     return m_source_object;
 }
 
+template <typename Object>
+inline bool Lazy<Object>::is_created() const
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_object != nullptr;
+}
+
 
 //
 // Access class implementation.
@@ -41,6 +41,7 @@
 #include "renderer/modeling/scene/objectinstancetraits.h"
 #include "renderer/modeling/scene/proceduralassembly.h"
 #include "renderer/modeling/scene/scene.h"
+#include "renderer/modeling/scene/sceneeditjournal.h"
 #include "renderer/modeling/scene/textureinstance.h"
 #include "renderer/modeling/scene/textureinstancetraits.h"
 #include "renderer/modeling/scene/visibilityflags.h"
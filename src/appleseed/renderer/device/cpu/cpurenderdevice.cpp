@@ -213,6 +213,11 @@ bool CPURenderDevice::build_or_update_scene()
     return true;
 }
 
+bool CPURenderDevice::update_light_samplers()
+{
+    return m_components->update_light_samplers();
+}
+
 bool CPURenderDevice::load_checkpoint(Frame& frame, const size_t pass_count)
 {
     return
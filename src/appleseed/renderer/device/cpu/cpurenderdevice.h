@@ -68,6 +68,8 @@ class CPURenderDevice
 
     bool build_or_update_scene() override;
 
+    bool update_light_samplers() override;
+
     bool load_checkpoint(Frame& frame, const size_t pass_count) override;
 
     IRendererController* get_frame_renderer_controller() override;
@@ -65,6 +65,10 @@ class IRenderDevice
     // Build or update ray tracing acceleration structures.
     virtual bool build_or_update_scene() = 0;
 
+    // Update light samplers after light emitters have moved. Return false if they
+    // cannot be updated in place, in which case rendering must be reinitialized.
+    virtual bool update_light_samplers() = 0;
+
     // Load checkpoint.
     virtual bool load_checkpoint(Frame& frame, const size_t pass_count) = 0;
 
@@ -0,0 +1,286 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+// Interface header.
+#include "anyhitcontext.h"
+
+// appleseed.renderer headers.
+#include "renderer/kernel/intersection/trianglekey.h"
+#include "renderer/modeling/scene/assemblyinstance.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/hash.h"
+#include "foundation/math/scalar.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstdint>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+//
+// AlphaCache class implementation.
+//
+
+namespace
+{
+    const size_t InitialAlphaCacheCapacity = 64;    // must be a power of two
+}
+
+AlphaCache::AlphaCache()
+  : m_entries(InitialAlphaCacheCapacity)
+  , m_size(0)
+  , m_stamp(1)
+{
+    for (Entry& entry : m_entries)
+        entry.m_stamp = 0;
+}
+
+void AlphaCache::clear()
+{
+    m_size = 0;
+
+    if (++m_stamp == 0)
+    {
+        // The stamp wrapped around: invalidate all entries explicitly.
+        for (Entry& entry : m_entries)
+            entry.m_stamp = 0;
+        m_stamp = 1;
+    }
+}
+
+bool AlphaCache::lookup(const Key& key, float& opacity) const
+{
+    const size_t mask = m_entries.size() - 1;
+
+    for (size_t i = hash(key) & mask; m_entries[i].m_stamp == m_stamp; i = (i + 1) & mask)
+    {
+        if (m_entries[i].m_key == key)
+        {
+            opacity = m_entries[i].m_opacity;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void AlphaCache::insert(const Key& key, const float opacity)
+{
+    // Keep the load factor below 1/2.
+    if (2 * (m_size + 1) > m_entries.size())
+        grow();
+
+    const size_t mask = m_entries.size() - 1;
+
+    size_t i = hash(key) & mask;
+    while (m_entries[i].m_stamp == m_stamp)
+    {
+        assert(!(m_entries[i].m_key == key));
+        i = (i + 1) & mask;
+    }
+
+    Entry& entry = m_entries[i];
+    entry.m_stamp = m_stamp;
+    entry.m_opacity = opacity;
+    entry.m_key = key;
+
+    ++m_size;
+}
+
+size_t AlphaCache::hash(const Key& key)
+{
+    return
+        static_cast<size_t>(
+            mix_uint64(
+                static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(key.m_assembly_instance_transform_seq)),
+                static_cast<std::uint64_t>(key.m_object_instance_index),
+                static_cast<std::uint64_t>(key.m_primitive_index),
+                static_cast<std::uint64_t>(key.m_primitive_type)));
+}
+
+void AlphaCache::grow()
+{
+    std::vector<Entry> old_entries(2 * m_entries.size());
+    m_entries.swap(old_entries);
+
+    for (Entry& entry : m_entries)
+        entry.m_stamp = 0;
+
+    const size_t mask = m_entries.size() - 1;
+
+    for (const Entry& old_entry : old_entries)
+    {
+        if (old_entry.m_stamp != m_stamp)
+            continue;
+
+        size_t i = hash(old_entry.m_key) & mask;
+        while (m_entries[i].m_stamp == m_stamp)
+            i = (i + 1) & mask;
+
+        m_entries[i] = old_entry;
+    }
+}
+
+
+//
+// AnyHitContext class implementation.
+//
+
+AnyHitContext::AnyHitContext(
+    const Scene&                        scene,
+    TextureCache&                       texture_cache,
+    const ShadingRay&                   ray,
+    IAnyHitFilter&                      filter,
+    AlphaCache&                         alpha_cache,
+    const float                         transmission_threshold)
+  : m_scene(scene)
+  , m_texture_cache(texture_cache)
+  , m_ray(ray)
+  , m_filter(filter)
+  , m_alpha_cache(alpha_cache)
+  , m_transmission_threshold(transmission_threshold)
+  , m_transmission(1.0f)
+  , m_assembly_instance(nullptr)
+  , m_assembly_instance_transform(nullptr)
+  , m_assembly_instance_transform_seq(nullptr)
+{
+    m_alpha_cache.clear();
+}
+
+bool AnyHitContext::on_triangle_hit(
+    const TriangleKey&                  triangle_key,
+    const TriangleType&                 triangle,
+    const double                        t,
+    const double                        u,
+    const double                        v)
+{
+    const AlphaCache::Key key =
+    {
+        m_assembly_instance_transform_seq,
+        triangle_key.get_object_instance_index(),
+        triangle_key.get_triangle_index(),
+        ShadingPoint::PrimitiveTriangle
+    };
+
+    // This triangle was already accounted for.
+    float opacity;
+    if (m_alpha_cache.lookup(key, opacity))
+        return true;
+
+    begin_hit(
+        ShadingPoint::PrimitiveTriangle,
+        triangle_key.get_object_instance_index(),
+        triangle_key.get_triangle_index(),
+        t, u, v);
+    m_shading_point.m_triangle_support_plane.initialize(triangle);
+
+    return end_hit(key);
+}
+
+bool AnyHitContext::on_curve_hit(
+    const size_t                        object_instance_index,
+    const size_t                        curve_index,
+    const ShadingPoint::PrimitiveType   primitive_type,
+    const double                        t,
+    const double                        u,
+    const double                        v)
+{
+    const AlphaCache::Key key =
+    {
+        m_assembly_instance_transform_seq,
+        object_instance_index,
+        curve_index,
+        primitive_type
+    };
+
+    // This curve was already accounted for.
+    float opacity;
+    if (m_alpha_cache.lookup(key, opacity))
+        return true;
+
+    begin_hit(
+        primitive_type,
+        object_instance_index,
+        curve_index,
+        t, u, v);
+
+    return end_hit(key);
+}
+
+void AnyHitContext::begin_hit(
+    const ShadingPoint::PrimitiveType   primitive_type,
+    const size_t                        object_instance_index,
+    const size_t                        primitive_index,
+    const double                        t,
+    const double                        u,
+    const double                        v)
+{
+    assert(m_assembly_instance != nullptr);
+
+    // Context.
+    m_shading_point.clear();
+    m_shading_point.m_texture_cache = &m_texture_cache;
+    m_shading_point.m_scene = &m_scene;
+    m_shading_point.m_ray = m_ray;
+    m_shading_point.m_ray.m_tmax = t;
+
+    // Primary intersection results.
+    m_shading_point.m_primitive_type = primitive_type;
+    m_shading_point.m_bary[0] = static_cast<float>(u);
+    m_shading_point.m_bary[1] = static_cast<float>(v);
+    m_shading_point.m_assembly_instance = m_assembly_instance;
+    m_shading_point.m_assembly_instance_transform = *m_assembly_instance_transform;
+    m_shading_point.m_assembly_instance_transform_seq = m_assembly_instance_transform_seq;
+    m_shading_point.m_object_instance_index = object_instance_index;
+    m_shading_point.m_primitive_index = primitive_index;
+}
+
+bool AnyHitContext::end_hit(const AlphaCache::Key& key)
+{
+    const float opacity = saturate(m_filter.evaluate_opacity(m_shading_point));
+    m_alpha_cache.insert(key, opacity);
+
+    // Stop at the first fully opaque occluder.
+    if (opacity >= 1.0f)
+    {
+        m_transmission = 0.0f;
+        return false;
+    }
+
+    // Stop once we hit full opacity.
+    m_transmission *= 1.0f - opacity;
+    return m_transmission >= m_transmission_threshold;
+}
+
+}   // namespace renderer
@@ -0,0 +1,236 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#pragma once
+
+// appleseed.renderer headers.
+#include "renderer/kernel/intersection/intersectionsettings.h"
+#include "renderer/kernel/shading/shadingpoint.h"
+#include "renderer/kernel/shading/shadingray.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/transform.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Forward declarations.
+namespace renderer  { class AssemblyInstance; }
+namespace renderer  { class Scene; }
+namespace renderer  { class TextureCache; }
+namespace renderer  { class TransformSequence; }
+namespace renderer  { class TriangleKey; }
+
+namespace renderer
+{
+
+//
+// Interface of the objects that evaluate the opacity of the surfaces crossed
+// by shadow rays traced with Intersector::trace_transmission().
+//
+
+class IAnyHitFilter
+  : public foundation::NonCopyable
+{
+  public:
+    // Destructor.
+    virtual ~IAnyHitFilter() {}
+
+    // Return the opacity, in [0, 1], of the surface at a given shading point.
+    virtual float evaluate_opacity(const ShadingPoint& shading_point) = 0;
+};
+
+
+//
+// A per-thread cache of the opacity of the primitives crossed by a shadow ray.
+//
+// A primitive may be reached more than once by the same ray, for instance when it
+// is referenced by several leaves of a tree built with spatial splits. The cache
+// guarantees that the opacity of each primitive is evaluated and accounted for
+// only once per ray. Starting a new ray invalidates all entries in constant time.
+//
+
+class AlphaCache
+  : public foundation::NonCopyable
+{
+  public:
+    struct Key
+    {
+        // An assembly instance may appear several times in the assembly tree, with different
+        // transforms (nested instancing). Each occurrence has its own transform sequence.
+        const TransformSequence*    m_assembly_instance_transform_seq;
+        size_t                      m_object_instance_index;
+        size_t                      m_primitive_index;
+        size_t                      m_primitive_type;
+
+        bool operator==(const Key& rhs) const;
+    };
+
+    // Constructor.
+    AlphaCache();
+
+    // Forget all the primitives crossed by the previous ray.
+    void clear();
+
+    // Return true and the opacity of a primitive if it was already crossed by the current ray.
+    bool lookup(const Key& key, float& opacity) const;
+
+    // Record the opacity of a primitive crossed by the current ray.
+    void insert(const Key& key, const float opacity);
+
+  private:
+    struct Entry
+    {
+        std::uint32_t           m_stamp;
+        float                   m_opacity;
+        Key                     m_key;
+    };
+
+    std::vector<Entry>          m_entries;
+    size_t                      m_size;
+    std::uint32_t               m_stamp;
+
+    static size_t hash(const Key& key);
+
+    void grow();
+};
+
+
+//
+// The state of a shadow ray during any-hit traversal.
+//
+// The leaf visitors of probe rays report every intersection to the context,
+// which accumulates the transmission of the crossed surfaces and tells them
+// when the ray is blocked, i.e. when its transmission falls below a threshold.
+//
+
+class AnyHitContext
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    AnyHitContext(
+        const Scene&                    scene,
+        TextureCache&                   texture_cache,
+        const ShadingRay&               ray,
+        IAnyHitFilter&                  filter,
+        AlphaCache&                     alpha_cache,
+        const float                     transmission_threshold);
+
+    // Set the assembly instance whose child trees are about to be traversed.
+    void set_assembly_instance(
+        const AssemblyInstance*         assembly_instance,
+        const foundation::Transformd&   assembly_instance_transform,
+        const TransformSequence*        assembly_instance_transform_seq);
+
+    // Account for a triangle hit. Return false if the ray is blocked.
+    bool on_triangle_hit(
+        const TriangleKey&              triangle_key,
+        const TriangleType&             triangle,
+        const double                    t,
+        const double                    u,
+        const double                    v);
+
+    // Account for a curve hit. Return false if the ray is blocked.
+    bool on_curve_hit(
+        const size_t                    object_instance_index,
+        const size_t                    curve_index,
+        const ShadingPoint::PrimitiveType primitive_type,
+        const double                    t,
+        const double                    u,
+        const double                    v);
+
+    // Return the accumulated transmission.
+    float get_transmission() const;
+
+  private:
+    const Scene&                        m_scene;
+    TextureCache&                       m_texture_cache;
+    const ShadingRay&                   m_ray;
+    IAnyHitFilter&                      m_filter;
+    AlphaCache&                         m_alpha_cache;
+    const float                         m_transmission_threshold;
+    float                               m_transmission;
+    const AssemblyInstance*             m_assembly_instance;
+    const foundation::Transformd*       m_assembly_instance_transform;
+    const TransformSequence*            m_assembly_instance_transform_seq;
+    ShadingPoint                        m_shading_point;
+
+    // Initialize the scratch shading point for a given hit.
+    void begin_hit(
+        const ShadingPoint::PrimitiveType   primitive_type,
+        const size_t                        object_instance_index,
+        const size_t                        primitive_index,
+        const double                        t,
+        const double                        u,
+        const double                        v);
+
+    // Evaluate the opacity at the scratch shading point and update the transmission.
+    bool end_hit(const AlphaCache::Key& key);
+};
+
+
+//
+// AlphaCache class implementation.
+//
+
+inline bool AlphaCache::Key::operator==(const Key& rhs) const
+{
+    return
+        m_assembly_instance_transform_seq == rhs.m_assembly_instance_transform_seq &&
+        m_object_instance_index == rhs.m_object_instance_index &&
+        m_primitive_index == rhs.m_primitive_index &&
+        m_primitive_type == rhs.m_primitive_type;
+}
+
+
+//
+// AnyHitContext class implementation.
+//
+
+inline void AnyHitContext::set_assembly_instance(
+    const AssemblyInstance*             assembly_instance,
+    const foundation::Transformd&       assembly_instance_transform,
+    const TransformSequence*            assembly_instance_transform_seq)
+{
+    m_assembly_instance = assembly_instance;
+    m_assembly_instance_transform = &assembly_instance_transform;
+    m_assembly_instance_transform_seq = assembly_instance_transform_seq;
+}
+
+inline float AnyHitContext::get_transmission() const
+{
+    return m_transmission;
+}
+
+}   // namespace renderer
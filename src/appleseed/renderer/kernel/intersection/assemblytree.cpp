@@ -46,7 +46,6 @@
 #include "renderer/utility/bbox.h"
 
 // appleseed.foundation headers.
-#include "foundation/math/beziercurve.h"
 #include "foundation/math/permutation.h"
 #include "foundation/math/ray.h"
 #include "foundation/math/transform.h"
@@ -55,6 +54,7 @@
 #include "foundation/platform/timers.h"
 #include "foundation/utility/alignedallocator.h"
 #include "foundation/utility/foreach.h"
+#include "foundation/utility/job.h"
 #include "foundation/utility/lazy.h"
 #include "foundation/utility/siphash.h"
 #include "foundation/utility/statistics.h"
@@ -80,6 +80,7 @@ namespace renderer
 AssemblyTree::AssemblyTree(const Scene& scene)
   : TreeType(AlignedAllocator<void>(System::get_l1_data_cache_line_size()))
   , m_scene(scene)
+  , m_thread_count(System::get_logical_cpu_core_count())
 #ifdef APPLESEED_WITH_EMBREE
   , m_use_embree(false)
   , m_dirty(false)
@@ -98,6 +99,12 @@ void AssemblyTree::update()
     update_tree_hierarchy();
 }
 
+void AssemblyTree::set_thread_count(const size_t thread_count)
+{
+    assert(thread_count > 0);
+    m_thread_count = thread_count;
+}
+
 size_t AssemblyTree::get_memory_size() const
 {
     return
@@ -253,6 +260,9 @@ void AssemblyTree::update_tree_hierarchy()
     // Delete child trees of assemblies that no longer exist.
     delete_unused_child_trees(assemblies);
 
+    // Assemblies whose triangle tree may be refit instead of rebuilt.
+    AssemblyVector refit_assemblies;
+
     // Create or rebuild the child trees of each assembly.
     for (const_each<AssemblyVector> i = assemblies; i; ++i)
     {
@@ -278,7 +288,16 @@ void AssemblyTree::update_tree_hierarchy()
                 continue;
             }
 
-            // The child trees of this assembly are out-of-date: delete them.
+            // The child trees of this assembly are out-of-date. If its object instances
+            // are unchanged, only vertices may have moved: try refitting its triangle tree.
+            if (can_refit_triangle_tree(assembly))
+            {
+                refit_assemblies.push_back(&assembly);
+                m_assembly_versions[assembly.get_uid()] = current_version_id;
+                continue;
+            }
+
+            // Delete the out-of-date child trees.
             delete_child_trees(assembly.get_uid());
         }
 
@@ -289,6 +308,9 @@ void AssemblyTree::update_tree_hierarchy()
         m_assembly_versions[assembly.get_uid()] = current_version_id;
     }
 
+    // Refit triangle trees, or rebuild them if they cannot be refit.
+    refit_triangle_trees(refit_assemblies);
+
     // Update child trees.
     update_triangle_trees();
 
@@ -367,6 +389,15 @@ namespace
 
         return hash;
     }
+
+    // Triangle trees are shared by assemblies with the same geometry and build parameters.
+    std::uint64_t hash_triangle_tree_key(const Assembly& assembly)
+    {
+        return
+            siphash24(
+                hash_assembly_geometry(assembly, MeshObjectFactory().get_model()),
+                TriangleTree::hash_build_parameters(assembly));
+    }
 }
 
 void AssemblyTree::create_child_trees(const Assembly& assembly)
@@ -393,7 +424,7 @@ void AssemblyTree::create_child_trees(const Assembly& assembly)
 
 void AssemblyTree::create_triangle_tree(const Assembly& assembly)
 {
-    const std::uint64_t hash = hash_assembly_geometry(assembly, MeshObjectFactory().get_model());
+    const std::uint64_t hash = hash_triangle_tree_key(assembly);
     Lazy<TriangleTree>* tree = m_triangle_tree_repository.acquire(hash);
 
     if (tree == nullptr)
@@ -410,7 +441,8 @@ void AssemblyTree::create_triangle_tree(const Assembly& assembly)
                     m_scene,
                     assembly.get_uid(),
                     assembly_bbox,
-                    assembly)));
+                    assembly,
+                    m_job_queue)));
 
         tree = new Lazy<TriangleTree>(std::move(triangle_tree_factory));
         m_triangle_tree_repository.insert(hash, tree);
@@ -527,23 +559,173 @@ void AssemblyTree::delete_curve_tree(const UniqueID assembly_id)
 
 namespace
 {
+    // A job that builds a tree if necessary, then updates its non-geometry aspects.
     template <typename TreeType>
-    struct UpdateTrees
+    class UpdateTreeJob
+      : public IJob
     {
-        void operator()(Lazy<TreeType>& tree, const size_t ref_count)
+      public:
+        UpdateTreeJob(Lazy<TreeType>& tree, const size_t ref_count)
+          : m_tree(tree)
+          , m_ref_count(ref_count)
+        {
+        }
+
+        void execute(const size_t thread_index) override
         {
-            Access<TreeType> update(&tree);
+            Access<TreeType> update(&m_tree);
 
-            const bool enable_intersection_filters = ref_count == 1;
+            const bool enable_intersection_filters = m_ref_count == 1;
             update->update_non_geometry(enable_intersection_filters);
         }
+
+      private:
+        Lazy<TreeType>&     m_tree;
+        const size_t        m_ref_count;
+    };
+
+    // A job that refits a triangle tree to the current vertices of its triangles.
+    class RefitTriangleTreeJob
+      : public IJob
+    {
+      public:
+        RefitTriangleTreeJob(
+            Lazy<TriangleTree>&     tree,
+            const GAABB3&           bbox,
+            std::uint8_t&           success)
+          : m_tree(tree)
+          , m_bbox(bbox)
+          , m_success(success)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            Access<TriangleTree> refit(&m_tree);
+            m_success = refit->refit(m_bbox) ? 1 : 0;
+        }
+
+      private:
+        Lazy<TriangleTree>&         m_tree;
+        const GAABB3                m_bbox;
+        std::uint8_t&               m_success;
+    };
+
+    template <typename TreeType>
+    struct ScheduleTreeUpdates
+    {
+        JobQueue& m_job_queue;
+
+        explicit ScheduleTreeUpdates(JobQueue& job_queue)
+          : m_job_queue(job_queue)
+        {
+        }
+
+        void operator()(Lazy<TreeType>& tree, const size_t ref_count)
+        {
+            m_job_queue.schedule(new UpdateTreeJob<TreeType>(tree, ref_count));
+        }
     };
 }
 
 void AssemblyTree::update_triangle_trees()
 {
-    UpdateTrees<TriangleTree> update_trees;
-    m_triangle_tree_repository.for_each(update_trees);
+    // Independent trees are built concurrently. Worker threads that run out of trees
+    // help building the subtrees of large trees (see TriangleTree::build_bvh()).
+    ScheduleTreeUpdates<TriangleTree> schedule_tree_updates(m_job_queue);
+    m_triangle_tree_repository.for_each(schedule_tree_updates);
+
+    if (!m_job_queue.has_scheduled_jobs())
+        return;
+
+    JobManager job_manager(
+        global_logger(),
+        m_job_queue,
+        m_thread_count,
+        JobManager::KeepRunningOnEmptyQueue);
+    job_manager.start();
+    m_job_queue.wait_until_completion();
+}
+
+bool AssemblyTree::can_refit_triangle_tree(const Assembly& assembly) const
+{
+#ifdef APPLESEED_WITH_EMBREE
+    if (use_embree() || m_dirty)
+        return false;
+#endif
+
+    const TriangleTreeContainer::const_iterator it = m_triangle_trees.find(assembly.get_uid());
+    if (it == m_triangle_trees.end())
+        return false;
+
+    // The tree must hold the same object instances with the same transforms, must have
+    // been built with the same acceleration structure parameters (algorithm, wide BVH,
+    // time intervals, SAH costs), and must not be shared with other assemblies.
+    return
+        m_triangle_tree_repository.get_key(it->second) == hash_triangle_tree_key(assembly) &&
+        m_triangle_tree_repository.get_ref_count(it->second) == 1;
+}
+
+void AssemblyTree::refit_triangle_trees(const AssemblyVector& assemblies)
+{
+    if (assemblies.empty())
+        return;
+
+    // Independent trees are refit concurrently. Worker threads that run out of trees
+    // help refitting the subtrees of large trees (see TriangleTree::refit()).
+    std::vector<std::uint8_t> success(assemblies.size(), 0);
+    for (size_t i = 0, e = assemblies.size(); i < e; ++i)
+    {
+        const Assembly& assembly = *assemblies[i];
+        Lazy<TriangleTree>& tree = *m_triangle_trees[assembly.get_uid()];
+
+        // Trees that were never accessed are not built yet: don't build them just to refit
+        // them, let them be lazily built from the current vertices instead.
+        if (!tree.is_created())
+            continue;
+
+        // Compute the assembly space bounding box of the assembly.
+        const GAABB3 assembly_bbox =
+            compute_parent_bbox<GAABB3>(
+                assembly.object_instances().begin(),
+                assembly.object_instances().end());
+
+        m_job_queue.schedule(
+            new RefitTriangleTreeJob(
+                tree,
+                assembly_bbox,
+                success[i]));
+    }
+
+    if (m_job_queue.has_scheduled_jobs())
+    {
+        JobManager job_manager(
+            global_logger(),
+            m_job_queue,
+            m_thread_count,
+            JobManager::KeepRunningOnEmptyQueue);
+        job_manager.start();
+        m_job_queue.wait_until_completion();
+    }
+
+    for (size_t i = 0, e = assemblies.size(); i < e; ++i)
+    {
+        const Assembly& assembly = *assemblies[i];
+
+        if (success[i])
+        {
+            // Curve trees are not refit: rebuild them.
+            delete_curve_tree(assembly.get_uid());
+            if (has_object_instances_of_type(assembly, CurveObjectFactory().get_model()))
+                create_curve_tree(assembly);
+        }
+        else
+        {
+            // Lazily build new child trees.
+            delete_child_trees(assembly.get_uid());
+            create_child_trees(assembly);
+        }
+    }
 }
 
 
@@ -621,220 +803,451 @@ bool AssemblyLeafVisitor::visit(
 
     for (size_t i = 0; i < assembly_instance_count; ++i)
     {
-        // Retrieve the assembly instance.
-        const AssemblyTree::Item& item = items[i];
-        const AssemblyInstance& assembly_instance = *item.m_assembly_instance;
-
-        // Skip this assembly instance if it isn't visible for this ray.
-        if (!(assembly_instance.get_vis_flags() & ray.m_flags))
-            continue;
-
-        FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(1));
+        visit_item(
+            items[i],
+            ray
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , stats
+#endif
+            );
+    }
 
-        // Evaluate the transformation of the assembly instance.
-        const TransformSequence* assembly_instance_transform_seq =
-            &item.m_transform_sequence;
-        Transformd scratch;
-        const Transformd& assembly_instance_transform =
-            assembly_instance_transform_seq->evaluate(ray.m_time.m_absolute, scratch);
+    // Continue traversal.
+    distance = m_shading_point.m_ray.m_tmax;
+    return true;
+}
 
-        // Transform the ray to assembly instance space.
-        ShadingPoint asm_inst_shading_point;
-        compute_assembly_instance_ray(
-            assembly_instance,
-            assembly_instance_transform,
-            m_parent_shading_point,
-            ray,
-            asm_inst_shading_point.m_ray);
-        const RayInfo3d asm_inst_ray_info(asm_inst_shading_point.m_ray);
+void AssemblyLeafVisitor::visit_item(
+    const AssemblyTree::Item&           item,
+    const ShadingRay&                   ray
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , bvh::TraversalStatistics&         stats
+#endif
+    )
+{
+    // Retrieve the assembly instance.
+    const AssemblyInstance& assembly_instance = *item.m_assembly_instance;
+
+    // Skip this assembly instance if it isn't visible for this ray.
+    if (!(assembly_instance.get_vis_flags() & ray.m_flags))
+        return;
+
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(1));
+
+    // Evaluate the transformation of the assembly instance.
+    const TransformSequence* assembly_instance_transform_seq =
+        &item.m_transform_sequence;
+    Transformd scratch;
+    const Transformd& assembly_instance_transform =
+        assembly_instance_transform_seq->evaluate(ray.m_time.m_absolute, scratch);
+
+    // Transform the ray to assembly instance space.
+    ShadingPoint asm_inst_shading_point;
+    compute_assembly_instance_ray(
+        assembly_instance,
+        assembly_instance_transform,
+        m_parent_shading_point,
+        ray,
+        asm_inst_shading_point.m_ray);
+    const RayInfo3d asm_inst_ray_info(asm_inst_shading_point.m_ray);
 
 #ifdef APPLESEED_WITH_EMBREE
 
-        if (m_tree.use_embree())
-        {
-            const EmbreeScene& embree_scene =
-                *m_embree_scene_cache.access(
-                    item.m_assembly_uid,
-                    m_tree.m_embree_scenes);
+    if (m_tree.use_embree())
+    {
+        const EmbreeScene& embree_scene =
+            *m_embree_scene_cache.access(
+                item.m_assembly_uid,
+                m_tree.m_embree_scenes);
 
-            embree_scene.intersect(asm_inst_shading_point);
-        }
-        else
+        embree_scene.intersect(asm_inst_shading_point);
+    }
+    else
 
 #endif
+    {
+        // Retrieve the triangle tree of this assembly.
+        const TriangleTree* triangle_tree =
+            m_triangle_tree_cache.access(
+                item.m_assembly_uid,
+                m_tree.m_triangle_trees);
+
+        if (triangle_tree)
         {
-            // Retrieve the triangle tree of this assembly.
-            const TriangleTree* triangle_tree =
-                m_triangle_tree_cache.access(
-                    item.m_assembly_uid,
-                    m_tree.m_triangle_trees);
+            // Select the subtree of the time interval of the ray.
+            triangle_tree = &triangle_tree->get_time_interval_tree(asm_inst_shading_point.m_ray.m_time.m_normalized);
 
-            if (triangle_tree)
+            // Check the intersection between the ray and the triangle tree.
+            TriangleTreeIntersector intersector;
+            TriangleLeafVisitor visitor(*triangle_tree, asm_inst_shading_point);
+            if (triangle_tree->use_wide_bvh())
             {
-                // Check the intersection between the ray and the triangle tree.
-                TriangleTreeIntersector intersector;
-                TriangleLeafVisitor visitor(*triangle_tree, asm_inst_shading_point);
-                if (triangle_tree->get_moving_triangle_count() > 0)
-                {
-                    intersector.intersect_motion(
-                        *triangle_tree,
-                        asm_inst_shading_point.m_ray,
-                        asm_inst_ray_info,
-                        asm_inst_shading_point.m_ray.m_time.m_normalized,
-                        visitor
+                TriangleTreeWideIntersector wide_intersector;
+                wide_intersector.intersect_no_motion(
+                    *triangle_tree,
+                    triangle_tree->get_wide_nodes(),
+                    asm_inst_shading_point.m_ray,
+                    asm_inst_ray_info,
+                    visitor
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
-                        , m_triangle_tree_stats
+                    , m_triangle_tree_stats
 #endif
-                        );
-                }
-                else
-                {
-                    intersector.intersect_no_motion(
-                        *triangle_tree,
-                        asm_inst_shading_point.m_ray,
-                        asm_inst_ray_info,
-                        visitor
+                    );
+            }
+            else if (triangle_tree->get_moving_triangle_count() > 0)
+            {
+                intersector.intersect_motion(
+                    *triangle_tree,
+                    asm_inst_shading_point.m_ray,
+                    asm_inst_ray_info,
+                    asm_inst_shading_point.m_ray.m_time.m_normalized,
+                    visitor
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
-                        , m_triangle_tree_stats
+                    , m_triangle_tree_stats
 #endif
-                        );
-                }
-                visitor.read_hit_triangle_data();
+                    );
+            }
+            else
+            {
+                intersector.intersect_no_motion(
+                    *triangle_tree,
+                    asm_inst_shading_point.m_ray,
+                    asm_inst_ray_info,
+                    visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                    , m_triangle_tree_stats
+#endif
+                    );
             }
+            visitor.read_hit_triangle_data();
         }
+    }
 
-        // Retrieve the curve tree of this assembly.
-        const CurveTree* curve_tree =
-            m_curve_tree_cache.access(
-                item.m_assembly_uid,
-                m_tree.m_curve_trees);
+    // Retrieve the curve tree of this assembly.
+    const CurveTree* curve_tree =
+        m_curve_tree_cache.access(
+            item.m_assembly_uid,
+            m_tree.m_curve_trees);
 
-        if (curve_tree)
-        {
-            // Check the intersection between the ray and the curve tree.
-            const GRay3 ray(asm_inst_shading_point.m_ray);
-            const GRayInfo3 ray_info(asm_inst_ray_info);
-            CurveMatrixType xfm_matrix;
-            make_curve_projection_transform(xfm_matrix, ray);
-            CurveLeafVisitor visitor(*curve_tree, xfm_matrix, asm_inst_shading_point);
-            CurveTreeIntersector intersector;
-            intersector.intersect_no_motion(
-                *curve_tree,
-                ray,
-                ray_info,
-                visitor
+    if (curve_tree)
+    {
+        // Check the intersection between the ray and the curve tree.
+        const GRay3 ray(asm_inst_shading_point.m_ray);
+        const GRayInfo3 ray_info(asm_inst_ray_info);
+        CurveLeafVisitor visitor(*curve_tree, asm_inst_shading_point);
+        CurveTreeIntersector intersector;
+        intersector.intersect_no_motion(
+            *curve_tree,
+            ray,
+            ray_info,
+            visitor
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
-                , m_curve_tree_stats
+            , m_curve_tree_stats
 #endif
-                );
+            );
+    }
+
+    // Keep track of the closest hit.
+    keep_closest_hit(
+        m_shading_point,
+        asm_inst_shading_point,
+        item,
+        assembly_instance_transform,
+        assembly_instance_transform_seq);
+
+    // Check the intersection between the ray and procedural objects.
+    const IndexedObjectInstanceArray& procedural_object_instances =
+        item.m_assembly->get_render_data().m_procedural_object_instances;
+
+    for (size_t j = 0, e = procedural_object_instances.size(); j < e; ++j)
+    {
+        // Retrieve the object instance.
+        const IndexedObjectInstance& object_instance_index_pair = procedural_object_instances[j];
+        const ObjectInstance* object_instance = object_instance_index_pair.first;
+
+        // Skip this object instance if it isn't visible for this ray.
+        if (!(object_instance->get_vis_flags() & ray.m_flags))
+            continue;
+
+        // todo: transform ray differentials.
+        const Transformd& object_instance_transform = object_instance->get_transform();
+
+        // Transform the ray direction from world space to object instance space.
+        ShadingRay obj_inst_ray;
+        obj_inst_ray.m_dir =
+            object_instance_transform.vector_to_local(
+                assembly_instance_transform.vector_to_local(ray.m_dir));
+
+        // Compute the ray origin in object space.
+        if (m_parent_shading_point &&
+            m_parent_shading_point->get_primitive_type() == ShadingPoint::PrimitiveType::PrimitiveProceduralSurface &&
+            m_parent_shading_point->get_assembly_instance().get_uid() == assembly_instance.get_uid() &&
+            m_parent_shading_point->get_object_instance().get_uid() == object_instance->get_uid())
+        {
+            // The caller provided the previous intersection, and we are about
+            // to intersect the object instance that contains the previous
+            // intersection. Use the properly offset intersection point as the
+            // origin of the child ray.
+            obj_inst_ray.m_org = m_parent_shading_point->get_offset_point(obj_inst_ray.m_dir);
+        }
+        else
+        {
+            // The caller didn't provide the previous intersection, or we are
+            // about to intersect an object instance that does not contain
+            // the previous intersection: simply transform the ray origin to
+            // object space.
+            obj_inst_ray.m_org =
+                object_instance_transform.point_to_local(
+                    assembly_instance_transform.point_to_local(ray.m_org));
         }
 
+        obj_inst_ray.m_has_differentials = false;
+        obj_inst_ray.m_tmin = asm_inst_shading_point.m_ray.m_tmin;
+        obj_inst_ray.m_tmax = asm_inst_shading_point.m_ray.m_tmax;
+        obj_inst_ray.m_time = asm_inst_shading_point.m_ray.m_time;
+        obj_inst_ray.m_flags = asm_inst_shading_point.m_ray.m_flags;
+        obj_inst_ray.m_depth = asm_inst_shading_point.m_ray.m_depth;
+        obj_inst_ray.m_medium_count = asm_inst_shading_point.m_ray.m_medium_count;
+
+        // Ask the procedural object to intersect itself against the ray.
+        const ProceduralObject& object = static_cast<const ProceduralObject&>(object_instance->get_object());
+        ProceduralObject::IntersectionResult result;
+        object.intersect(obj_inst_ray, result);
+
         // Keep track of the closest hit.
-        if (asm_inst_shading_point.hit_surface() && asm_inst_shading_point.m_ray.m_tmax < m_shading_point.m_ray.m_tmax)
+        // todo: result is not in the same space as the shading point ray.
+        if (result.m_hit && result.m_distance < m_shading_point.m_ray.m_tmax)
         {
-            m_shading_point.m_ray.m_tmax = asm_inst_shading_point.m_ray.m_tmax;
-            m_shading_point.m_primitive_type = asm_inst_shading_point.m_primitive_type;
-            m_shading_point.m_bary = asm_inst_shading_point.m_bary;
+            m_shading_point.m_ray.m_tmax = result.m_distance;
+            m_shading_point.m_primitive_type = ShadingPoint::PrimitiveProceduralSurface;
+            m_shading_point.m_bary = result.m_uv;
             m_shading_point.m_assembly_instance = item.m_assembly_instance;
             m_shading_point.m_assembly_instance_transform = assembly_instance_transform;
             m_shading_point.m_assembly_instance_transform_seq = assembly_instance_transform_seq;
-            m_shading_point.m_object_instance_index = asm_inst_shading_point.m_object_instance_index;
-            m_shading_point.m_primitive_index = asm_inst_shading_point.m_primitive_index;
-            m_shading_point.m_triangle_support_plane = asm_inst_shading_point.m_triangle_support_plane;
+            m_shading_point.m_object_instance_index = object_instance_index_pair.second;
+            m_shading_point.m_primitive_index = 0;
+            m_shading_point.m_primitive_pa = result.m_material_slot;
+            m_shading_point.m_geometric_normal = 
+                normalize(
+                    assembly_instance_transform.normal_to_parent(
+                        object_instance_transform.normal_to_parent(
+                            result.m_geometric_normal)));
+            m_shading_point.m_original_shading_normal =
+                normalize(
+                    assembly_instance_transform.normal_to_parent(
+                        object_instance_transform.normal_to_parent(
+                            result.m_shading_normal)));
+            m_shading_point.m_uv = result.m_uv;
+            // HasGeometricNormal and HasOriginalShadingNormal shading point members aren't set
+            // so that the shading point can compute the hit side by itself.
         }
+    }
+}
 
-        // Check the intersection between the ray and procedural objects.
-        const IndexedObjectInstanceArray& procedural_object_instances =
-            item.m_assembly->get_render_data().m_procedural_object_instances;
+void AssemblyLeafVisitor::keep_closest_hit(
+    ShadingPoint&                       shading_point,
+    const ShadingPoint&                 asm_inst_shading_point,
+    const AssemblyTree::Item&           item,
+    const Transformd&                   assembly_instance_transform,
+    const TransformSequence*            assembly_instance_transform_seq)
+{
+    if (asm_inst_shading_point.hit_surface() && asm_inst_shading_point.m_ray.m_tmax < shading_point.m_ray.m_tmax)
+    {
+        shading_point.m_ray.m_tmax = asm_inst_shading_point.m_ray.m_tmax;
+        shading_point.m_primitive_type = asm_inst_shading_point.m_primitive_type;
+        shading_point.m_bary = asm_inst_shading_point.m_bary;
+        shading_point.m_assembly_instance = item.m_assembly_instance;
+        shading_point.m_assembly_instance_transform = assembly_instance_transform;
+        shading_point.m_assembly_instance_transform_seq = assembly_instance_transform_seq;
+        shading_point.m_object_instance_index = asm_inst_shading_point.m_object_instance_index;
+        shading_point.m_primitive_index = asm_inst_shading_point.m_primitive_index;
+        shading_point.m_triangle_support_plane = asm_inst_shading_point.m_triangle_support_plane;
+    }
+}
 
-        for (size_t j = 0, e = procedural_object_instances.size(); j < e; ++j)
-        {
-            // Retrieve the object instance.
-            const IndexedObjectInstance& object_instance_index_pair = procedural_object_instances[j];
-            const ObjectInstance* object_instance = object_instance_index_pair.first;
 
-            // Skip this object instance if it isn't visible for this ray.
-            if (!(object_instance->get_vis_flags() & ray.m_flags))
-                continue;
+//
+// AssemblyLeafPacketVisitor class implementation.
+//
 
-            // todo: transform ray differentials.
-            const Transformd& object_instance_transform = object_instance->get_transform();
+void AssemblyLeafPacketVisitor::visit(
+    const AssemblyTree::NodeType&       node,
+    const ShadingRay*                   rays,
+    const ShadingRay::RayInfoType*      ray_infos,
+    const size_t*                       ray_indices,
+    const size_t                        ray_count,
+    double*                             distances
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , bvh::TraversalStatistics&         stats
+#endif
+    )
+{
+    // Retrieve the assembly instances for this leaf.
+    const size_t assembly_instance_index = node.get_item_index();
+    const size_t assembly_instance_count = node.get_item_count();
+    const AssemblyTree::Item* items =
+        assembly_instance_count <= AssemblyTree::NodeType::MaxUserDataSize / sizeof(AssemblyTree::Item)
+            ? &node.get_user_data<AssemblyTree::Item>()     // items are stored in the leaf node
+            : &m_tree.m_items[assembly_instance_index];     // items are stored in the tree
 
-            // Transform the ray direction from world space to object instance space.
-            ShadingRay obj_inst_ray;
-            obj_inst_ray.m_dir =
-                object_instance_transform.vector_to_local(
-                    assembly_instance_transform.vector_to_local(ray.m_dir));
+    for (size_t i = 0; i < assembly_instance_count; ++i)
+    {
+        visit_item(
+            items[i],
+            ray_indices,
+            ray_count
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , stats
+#endif
+            );
+    }
 
-            // Compute the ray origin in object space.
-            if (m_parent_shading_point &&
-                m_parent_shading_point->get_primitive_type() == ShadingPoint::PrimitiveType::PrimitiveProceduralSurface &&
-                m_parent_shading_point->get_assembly_instance().get_uid() == assembly_instance.get_uid() &&
-                m_parent_shading_point->get_object_instance().get_uid() == object_instance->get_uid())
-            {
-                // The caller provided the previous intersection, and we are about
-                // to intersect the object instance that contains the previous
-                // intersection. Use the properly offset intersection point as the
-                // origin of the child ray.
-                obj_inst_ray.m_org = m_parent_shading_point->get_offset_point(obj_inst_ray.m_dir);
-            }
-            else
-            {
-                // The caller didn't provide the previous intersection, or we are
-                // about to intersect an object instance that does not contain
-                // the previous intersection: simply transform the ray origin to
-                // object space.
-                obj_inst_ray.m_org =
-                    object_instance_transform.point_to_local(
-                        assembly_instance_transform.point_to_local(ray.m_org));
-            }
+    // Continue traversal.
+    for (size_t i = 0; i < ray_count; ++i)
+        distances[ray_indices[i]] = m_shading_points[ray_indices[i]].m_ray.m_tmax;
+}
 
-            obj_inst_ray.m_has_differentials = false;
-            obj_inst_ray.m_tmin = asm_inst_shading_point.m_ray.m_tmin;
-            obj_inst_ray.m_tmax = asm_inst_shading_point.m_ray.m_tmax;
-            obj_inst_ray.m_time = asm_inst_shading_point.m_ray.m_time;
-            obj_inst_ray.m_flags = asm_inst_shading_point.m_ray.m_flags;
-            obj_inst_ray.m_depth = asm_inst_shading_point.m_ray.m_depth;
-            obj_inst_ray.m_medium_count = asm_inst_shading_point.m_ray.m_medium_count;
+bool AssemblyLeafPacketVisitor::can_trace_packet(
+    const AssemblyTree::Item&           item,
+    const TriangleTree*                 triangle_tree) const
+{
+#ifdef APPLESEED_WITH_EMBREE
+    if (m_tree.use_embree())
+        return false;
+#endif
 
-            // Ask the procedural object to intersect itself against the ray.
-            const ProceduralObject& object = static_cast<const ProceduralObject&>(object_instance->get_object());
-            ProceduralObject::IntersectionResult result;
-            object.intersect(obj_inst_ray, result);
+    // Only triangle trees without moving triangles support packet traversal.
+    if (triangle_tree == nullptr ||
+        triangle_tree->get_moving_triangle_count() > 0 ||
+        triangle_tree->get_time_interval_count() > 0)
+        return false;
 
-            // Keep track of the closest hit.
-            // todo: result is not in the same space as the shading point ray.
-            if (result.m_hit && result.m_distance < m_shading_point.m_ray.m_tmax)
-            {
-                m_shading_point.m_ray.m_tmax = result.m_distance;
-                m_shading_point.m_primitive_type = ShadingPoint::PrimitiveProceduralSurface;
-                m_shading_point.m_bary = result.m_uv;
-                m_shading_point.m_assembly_instance = item.m_assembly_instance;
-                m_shading_point.m_assembly_instance_transform = assembly_instance_transform;
-                m_shading_point.m_assembly_instance_transform_seq = assembly_instance_transform_seq;
-                m_shading_point.m_object_instance_index = object_instance_index_pair.second;
-                m_shading_point.m_primitive_index = 0;
-                m_shading_point.m_primitive_pa = result.m_material_slot;
-                m_shading_point.m_geometric_normal = 
-                    normalize(
-                        assembly_instance_transform.normal_to_parent(
-                            object_instance_transform.normal_to_parent(
-                                result.m_geometric_normal)));
-                m_shading_point.m_original_shading_normal =
-                    normalize(
-                        assembly_instance_transform.normal_to_parent(
-                            object_instance_transform.normal_to_parent(
-                                result.m_shading_normal)));
-                m_shading_point.m_uv = result.m_uv;
-                // HasGeometricNormal and HasOriginalShadingNormal shading point members aren't set
-                // so that the shading point can compute the hit side by itself.
-            }
+    // Curves and procedural objects are intersected one ray at a time.
+    if (m_curve_tree_cache.access(item.m_assembly_uid, m_tree.m_curve_trees) != nullptr)
+        return false;
+    if (!item.m_assembly->get_render_data().m_procedural_object_instances.empty())
+        return false;
+
+    return true;
+}
+
+void AssemblyLeafPacketVisitor::visit_item(
+    const AssemblyTree::Item&           item,
+    const size_t*                       ray_indices,
+    const size_t                        ray_count
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , bvh::TraversalStatistics&         stats
+#endif
+    )
+{
+    // Retrieve the triangle tree of this assembly.
+    const TriangleTree* triangle_tree =
+        m_triangle_tree_cache.access(
+            item.m_assembly_uid,
+            m_tree.m_triangle_trees);
+
+    if (!can_trace_packet(item, triangle_tree))
+    {
+        // Fall back to intersecting the rays one by one. The shading point rays
+        // carry the distance to the closest hit found so far.
+        for (size_t i = 0; i < ray_count; ++i)
+        {
+            ShadingPoint& shading_point = m_shading_points[ray_indices[i]];
+            AssemblyLeafVisitor visitor(
+                shading_point,
+                m_tree,
+                m_triangle_tree_cache,
+                m_curve_tree_cache,
+#ifdef APPLESEED_WITH_EMBREE
+                m_embree_scene_cache,
+#endif
+                nullptr
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , m_triangle_tree_stats
+                , m_curve_tree_stats
+#endif
+                );
+            visitor.visit_item(
+                item,
+                shading_point.m_ray
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , stats
+#endif
+                );
         }
+
+        return;
     }
 
-    // Continue traversal.
-    distance = m_shading_point.m_ray.m_tmax;
-    return true;
+    // Retrieve the assembly instance.
+    const AssemblyInstance& assembly_instance = *item.m_assembly_instance;
+    const TransformSequence* assembly_instance_transform_seq = &item.m_transform_sequence;
+
+    // Transform the rays for which this assembly instance is visible to assembly instance space.
+    ShadingPoint asm_inst_shading_points[RayPacketSize];
+    Ray3d asm_inst_rays[RayPacketSize];
+    RayInfo3d asm_inst_ray_infos[RayPacketSize];
+    Transformd scratch[RayPacketSize];
+    const Transformd* assembly_instance_transforms[RayPacketSize];
+    size_t packet_ray_indices[RayPacketSize];
+    size_t asm_inst_ray_count = 0;
+
+    for (size_t i = 0; i < ray_count; ++i)
+    {
+        const size_t ray_index = ray_indices[i];
+        const ShadingRay& ray = m_shading_points[ray_index].m_ray;
+
+        // Skip this assembly instance if it isn't visible for this ray.
+        if (!(assembly_instance.get_vis_flags() & ray.m_flags))
+            continue;
+
+        FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(1));
+
+        // Evaluate the transformation of the assembly instance.
+        const size_t j = asm_inst_ray_count++;
+        assembly_instance_transforms[j] =
+            &assembly_instance_transform_seq->evaluate(ray.m_time.m_absolute, scratch[j]);
+
+        // Transform the ray to assembly instance space.
+        compute_assembly_instance_ray(
+            assembly_instance,
+            *assembly_instance_transforms[j],
+            nullptr,
+            ray,
+            asm_inst_shading_points[j].m_ray);
+        asm_inst_rays[j] = asm_inst_shading_points[j].m_ray;
+        asm_inst_ray_infos[j] = RayInfo3d(asm_inst_rays[j]);
+        packet_ray_indices[j] = ray_index;
+    }
+
+    if (asm_inst_ray_count == 0)
+        return;
+
+    // Check the intersection between the rays and the triangle tree.
+    TriangleTreePacketIntersector intersector;
+    TriangleLeafPacketVisitor visitor(*triangle_tree, asm_inst_shading_points);
+    intersector.intersect_no_motion(
+        *triangle_tree,
+        asm_inst_rays,
+        asm_inst_ray_infos,
+        asm_inst_ray_count,
+        visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , m_triangle_tree_stats
+#endif
+        );
+    visitor.read_hit_triangle_data(asm_inst_ray_count);
+
+    // Keep track of the closest hits.
+    for (size_t j = 0; j < asm_inst_ray_count; ++j)
+    {
+        AssemblyLeafVisitor::keep_closest_hit(
+            m_shading_points[packet_ray_indices[j]],
+            asm_inst_shading_points[j],
+            item,
+            *assembly_instance_transforms[j],
+            assembly_instance_transform_seq);
+    }
 }
 
 
@@ -886,10 +1299,21 @@ bool AssemblyLeafProbeVisitor::visit(
             asm_inst_ray);
         const RayInfo3d asm_inst_ray_info(asm_inst_ray);
 
+        if (m_any_hit_context)
+        {
+            m_any_hit_context->set_assembly_instance(
+                item.m_assembly_instance,
+                assembly_instance_transform,
+                &item.m_transform_sequence);
+        }
+
 #ifdef APPLESEED_WITH_EMBREE
 
         if (m_tree.use_embree())
         {
+            // Embree scenes don't support any-hit traversal.
+            assert(m_any_hit_context == nullptr);
+
             const EmbreeScene& embree_scene =
                 *m_embree_scene_cache.access(
                     item.m_assembly_uid,
@@ -913,10 +1337,31 @@ bool AssemblyLeafProbeVisitor::visit(
 
             if (triangle_tree)
             {
+                // Select the subtree of the time interval of the ray.
+                triangle_tree = &triangle_tree->get_time_interval_tree(asm_inst_ray.m_time.m_normalized);
+
                 // Check the intersection between the ray and the triangle tree.
                 TriangleTreeProbeIntersector intersector;
-                TriangleLeafProbeVisitor visitor(*triangle_tree, asm_inst_ray.m_time.m_normalized, asm_inst_ray.m_flags);
-                if (triangle_tree->get_moving_triangle_count() > 0)
+                TriangleLeafProbeVisitor visitor(
+                    *triangle_tree,
+                    asm_inst_ray.m_time.m_normalized,
+                    asm_inst_ray.m_flags,
+                    m_any_hit_context);
+                if (triangle_tree->use_wide_bvh())
+                {
+                    TriangleTreeWideProbeIntersector wide_intersector;
+                    wide_intersector.intersect_no_motion(
+                        *triangle_tree,
+                        triangle_tree->get_wide_nodes(),
+                        asm_inst_ray,
+                        asm_inst_ray_info,
+                        visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                        , m_triangle_tree_stats
+#endif
+                        );
+                }
+                else if (triangle_tree->get_moving_triangle_count() > 0)
                 {
                     intersector.intersect_motion(
                         *triangle_tree,
@@ -962,9 +1407,7 @@ bool AssemblyLeafProbeVisitor::visit(
             // Check intersection between ray and curve tree.
             const GRay3 ray(asm_inst_ray);
             const GRayInfo3 ray_info(asm_inst_ray_info);
-            CurveMatrixType xfm_matrix;
-            make_curve_projection_transform(xfm_matrix, ray);
-            CurveLeafProbeVisitor visitor(*curve_tree, xfm_matrix);
+            CurveLeafProbeVisitor visitor(*curve_tree, asm_inst_ray.m_time.m_normalized, m_any_hit_context);
             CurveTreeProbeIntersector intersector;
             intersector.intersect_no_motion(
                 *curve_tree,
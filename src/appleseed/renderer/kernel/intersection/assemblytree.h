@@ -46,7 +46,9 @@
 #include "foundation/core/concepts/noncopyable.h"
 #include "foundation/math/aabb.h"
 #include "foundation/math/bvh.h"
+#include "foundation/math/transform.h"
 #include "foundation/utility/alignedvector.h"
+#include "foundation/utility/job/jobqueue.h"
 #include "foundation/utility/uid.h"
 #include "foundation/utility/version.h"
 
@@ -57,6 +59,7 @@
 
 // Forward declarations.
 namespace foundation    { class Statistics; }
+namespace renderer      { class AnyHitContext; }
 namespace renderer      { class AssemblyInstance; }
 namespace renderer      { class Scene; }
 namespace renderer      { class ShadingPoint; }
@@ -85,6 +88,9 @@ class AssemblyTree
     // Update the assembly tree and all the child trees.
     void update();
 
+    // Set the number of threads used to build and refit child trees.
+    void set_thread_count(const size_t thread_count);
+
     // Return the size (in bytes) of this object in memory.
     size_t get_memory_size() const;
 
@@ -97,6 +103,7 @@ class AssemblyTree
 
   private:
     friend class AssemblyLeafVisitor;
+    friend class AssemblyLeafPacketVisitor;
     friend class AssemblyLeafProbeVisitor;
     friend class Intersector;
 
@@ -129,6 +136,8 @@ class AssemblyTree
     const Scene&                    m_scene;
     ItemVector                      m_items;
     AssemblyVersionMap              m_assembly_versions;
+    foundation::JobQueue            m_job_queue;        // outlives child trees, which refer to it
+    size_t                          m_thread_count;
 
     TreeRepository<TriangleTree>    m_triangle_tree_repository;
     TriangleTreeContainer           m_triangle_trees;
@@ -172,6 +181,8 @@ class AssemblyTree
     void delete_triangle_tree(const foundation::UniqueID assembly_id);
     void delete_curve_tree(const foundation::UniqueID assembly_id);
 
+    bool can_refit_triangle_tree(const Assembly& assembly) const;
+    void refit_triangle_trees(const AssemblyVector& assemblies);
     void update_triangle_trees();
 };
 
@@ -212,6 +223,8 @@ class AssemblyLeafVisitor
         );
 
   private:
+    friend class AssemblyLeafPacketVisitor;
+
     ShadingPoint&                                   m_shading_point;
     const AssemblyTree&                             m_tree;
     TriangleTreeAccessCache&                        m_triangle_tree_cache;
@@ -224,6 +237,92 @@ class AssemblyLeafVisitor
     foundation::bvh::TraversalStatistics&           m_triangle_tree_stats;
     foundation::bvh::TraversalStatistics&           m_curve_tree_stats;
 #endif
+
+    // Intersect the ray with a single assembly instance.
+    void visit_item(
+        const AssemblyTree::Item&                   item,
+        const ShadingRay&                           ray
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics&     stats
+#endif
+        );
+
+    // Update a shading point if the intersection with an assembly instance is closer.
+    static void keep_closest_hit(
+        ShadingPoint&                               shading_point,
+        const ShadingPoint&                         asm_inst_shading_point,
+        const AssemblyTree::Item&                   item,
+        const foundation::Transformd&               assembly_instance_transform,
+        const TransformSequence*                    assembly_instance_transform_seq);
+};
+
+
+//
+// Assembly leaf visitor for packets of rays, used during packet intersection.
+//
+// Assembly instances made of static triangles only are intersected with all the
+// rays of the packet at once; the other ones are intersected one ray at a time.
+//
+
+class AssemblyLeafPacketVisitor
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor. 'shading_points' holds one shading point per ray of the packet.
+    AssemblyLeafPacketVisitor(
+        ShadingPoint*                               shading_points,
+        const AssemblyTree&                         tree,
+        TriangleTreeAccessCache&                    triangle_tree_cache,
+        CurveTreeAccessCache&                       curve_tree_cache
+#ifdef APPLESEED_WITH_EMBREE
+        , EmbreeSceneAccessCache&                   embree_scene_cache
+#endif
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics&     triangle_tree_stats
+        , foundation::bvh::TraversalStatistics&     curve_tree_stats
+#endif
+        );
+
+    // Visit a leaf.
+    void visit(
+        const AssemblyTree::NodeType&               node,
+        const ShadingRay*                           rays,
+        const ShadingRay::RayInfoType*              ray_infos,
+        const size_t*                               ray_indices,
+        const size_t                                ray_count,
+        double*                                     distances
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics&     stats
+#endif
+        );
+
+  private:
+    ShadingPoint*                                   m_shading_points;
+    const AssemblyTree&                             m_tree;
+    TriangleTreeAccessCache&                        m_triangle_tree_cache;
+    CurveTreeAccessCache&                           m_curve_tree_cache;
+#ifdef APPLESEED_WITH_EMBREE
+    EmbreeSceneAccessCache&                         m_embree_scene_cache;
+#endif
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    foundation::bvh::TraversalStatistics&           m_triangle_tree_stats;
+    foundation::bvh::TraversalStatistics&           m_curve_tree_stats;
+#endif
+
+    // Return whether the rays can be traced as a packet through an assembly instance.
+    bool can_trace_packet(
+        const AssemblyTree::Item&                   item,
+        const TriangleTree*                         triangle_tree) const;
+
+    // Intersect the rays with a single assembly instance.
+    void visit_item(
+        const AssemblyTree::Item&                   item,
+        const size_t*                               ray_indices,
+        const size_t                                ray_count
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics&     stats
+#endif
+        );
 };
 
 
@@ -231,6 +330,10 @@ class AssemblyLeafVisitor
 // Assembly leaf visitor for probe rays, only return boolean answers
 // (whether an intersection was found or not).
 //
+// When an any-hit context is provided, intersections with triangles and curves
+// are reported to it instead of terminating traversal (see AnyHitContext).
+// Procedural objects are always considered opaque.
+//
 
 class AssemblyLeafProbeVisitor
   : public ProbeVisitorBase
@@ -244,7 +347,8 @@ class AssemblyLeafProbeVisitor
 #ifdef APPLESEED_WITH_EMBREE
         EmbreeSceneAccessCache&                     embree_scene_cache,
 #endif
-        const ShadingPoint*                         parent_shading_point
+        const ShadingPoint*                         parent_shading_point,
+        AnyHitContext*                              any_hit_context
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
         , foundation::bvh::TraversalStatistics&     triangle_tree_stats
         , foundation::bvh::TraversalStatistics&     curve_tree_stats
@@ -270,6 +374,7 @@ class AssemblyLeafProbeVisitor
     EmbreeSceneAccessCache&                         m_embree_scene_cache;
 #endif
     const ShadingPoint*                             m_parent_shading_point;
+    AnyHitContext*                                  m_any_hit_context;
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
     foundation::bvh::TraversalStatistics&           m_triangle_tree_stats;
     foundation::bvh::TraversalStatistics&           m_curve_tree_stats;
@@ -293,6 +398,13 @@ typedef foundation::bvh::Intersector<
     ShadingRay
 > AssemblyTreeProbeIntersector;
 
+typedef foundation::bvh::PacketIntersector<
+    AssemblyTree,
+    AssemblyLeafPacketVisitor,
+    ShadingRay,
+    RayPacketSize
+> AssemblyTreePacketIntersector;
+
 
 //
 // AssemblyLeafVisitor class implementation.
@@ -328,6 +440,38 @@ inline AssemblyLeafVisitor::AssemblyLeafVisitor(
 }
 
 
+//
+// AssemblyLeafPacketVisitor class implementation.
+//
+
+inline AssemblyLeafPacketVisitor::AssemblyLeafPacketVisitor(
+    ShadingPoint*                                   shading_points,
+    const AssemblyTree&                             tree,
+    TriangleTreeAccessCache&                        triangle_tree_cache,
+    CurveTreeAccessCache&                           curve_tree_cache
+#ifdef APPLESEED_WITH_EMBREE
+    , EmbreeSceneAccessCache&                       embree_scene_cache
+#endif
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , foundation::bvh::TraversalStatistics&         triangle_tree_stats
+    , foundation::bvh::TraversalStatistics&         curve_tree_stats
+#endif
+    )
+  : m_shading_points(shading_points)
+  , m_tree(tree)
+  , m_triangle_tree_cache(triangle_tree_cache)
+  , m_curve_tree_cache(curve_tree_cache)
+#ifdef APPLESEED_WITH_EMBREE
+  , m_embree_scene_cache(embree_scene_cache)
+#endif
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+  , m_triangle_tree_stats(triangle_tree_stats)
+  , m_curve_tree_stats(curve_tree_stats)
+#endif
+{
+}
+
+
 //
 // AssemblyLeafProbeVisitor class implementation.
 //
@@ -339,7 +483,8 @@ inline AssemblyLeafProbeVisitor::AssemblyLeafProbeVisitor(
 #ifdef APPLESEED_WITH_EMBREE
     EmbreeSceneAccessCache&                         embree_scene_cache,
 #endif
-    const ShadingPoint*                             parent_shading_point
+    const ShadingPoint*                             parent_shading_point,
+    AnyHitContext*                                  any_hit_context
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
     , foundation::bvh::TraversalStatistics&         triangle_tree_stats
     , foundation::bvh::TraversalStatistics&         curve_tree_stats
@@ -352,6 +497,7 @@ inline AssemblyLeafProbeVisitor::AssemblyLeafProbeVisitor(
   , m_embree_scene_cache(embree_scene_cache)
 #endif
   , m_parent_shading_point(parent_shading_point)
+  , m_any_hit_context(any_hit_context)
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
   , m_triangle_tree_stats(triangle_tree_stats)
   , m_curve_tree_stats(curve_tree_stats)
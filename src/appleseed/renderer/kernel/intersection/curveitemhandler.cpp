@@ -0,0 +1,189 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+// Interface header.
+#include "curveitemhandler.h"
+
+// Standard headers.
+#include <cassert>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+namespace
+{
+    // Number of times curves are halved when clipped against a slab.
+    const size_t CurveClipDepth = 3;
+
+    template <typename CurveType>
+    GAABB3 compute_piece_bbox(const CurveType& curve, const GScalar half_width)
+    {
+        GAABB3 bbox = curve.compute_bbox();
+        bbox.grow(GVector3(half_width));
+        return bbox;
+    }
+
+    template <typename CurveType>
+    void clip_curve(
+        const CurveType&    curve,
+        const GScalar       half_width,
+        const size_t        dimension,
+        const GScalar       slab_min,
+        const GScalar       slab_max,
+        const size_t        depth,
+        GAABB3&             clipped_bbox)
+    {
+        GAABB3 bbox = compute_piece_bbox(curve, half_width);
+
+        if (bbox.max[dimension] < slab_min || bbox.min[dimension] > slab_max)
+            return;
+
+        if (depth == 0 || (bbox.min[dimension] >= slab_min && bbox.max[dimension] <= slab_max))
+        {
+            if (bbox.min[dimension] < slab_min)
+                bbox.min[dimension] = slab_min;
+
+            if (bbox.max[dimension] > slab_max)
+                bbox.max[dimension] = slab_max;
+
+            clipped_bbox.insert(bbox);
+            return;
+        }
+
+        CurveType c1, c2;
+        curve.split(c1, c2);
+
+        clip_curve(c1, half_width, dimension, slab_min, slab_max, depth - 1, clipped_bbox);
+        clip_curve(c2, half_width, dimension, slab_min, slab_max, depth - 1, clipped_bbox);
+    }
+
+    template <typename CurveType>
+    bool intersect_curve(
+        const CurveType&    curve,
+        const GScalar       half_width,
+        const GAABB3&       bbox,
+        const size_t        depth)
+    {
+        const GAABB3 piece_bbox = compute_piece_bbox(curve, half_width);
+
+        if (!GAABB3::overlap(bbox, piece_bbox))
+            return false;
+
+        if (depth == 0)
+            return true;
+
+        CurveType c1, c2;
+        curve.split(c1, c2);
+
+        return
+            intersect_curve(c1, half_width, bbox, depth - 1) ||
+            intersect_curve(c2, half_width, bbox, depth - 1);
+    }
+}
+
+CurveItemHandler::CurveItemHandler(
+    const std::vector<Curve1Type>&      curves1,
+    const std::vector<Curve3Type>&      curves3,
+    const std::vector<CurveKey>&        curve_keys)
+  : m_curves1(curves1)
+  , m_curves3(curves3)
+  , m_curve_keys(curve_keys)
+{
+}
+
+GScalar CurveItemHandler::get_bbox_grow_eps() const
+{
+    return GScalar(1.0e-6);
+}
+
+GAABB3 CurveItemHandler::clip(
+    const size_t                        item_index,
+    const size_t                        dimension,
+    const GScalar                       slab_min,
+    const GScalar                       slab_max) const
+{
+    const CurveKey& key = m_curve_keys[item_index];
+
+    GAABB3 bbox;
+    bbox.invalidate();
+
+    // The control polygon of a curve may extend past the curve itself: if none of the
+    // pieces overlap the slab, fall back to the bounding box of the whole curve.
+    if (key.get_curve_degree() == 1)
+    {
+        const Curve1Type& curve = m_curves1[key.get_curve_index_tree()];
+        const GScalar half_width = GScalar(0.5) * curve.compute_max_width();
+        clip_curve(curve, half_width, dimension, slab_min, slab_max, CurveClipDepth, bbox);
+        if (!bbox.is_valid())
+            bbox = compute_piece_bbox(curve, half_width);
+    }
+    else
+    {
+        assert(key.get_curve_degree() == 3);
+        const Curve3Type& curve = m_curves3[key.get_curve_index_tree()];
+        const GScalar half_width = GScalar(0.5) * curve.compute_max_width();
+        clip_curve(curve, half_width, dimension, slab_min, slab_max, CurveClipDepth, bbox);
+        if (!bbox.is_valid())
+            bbox = compute_piece_bbox(curve, half_width);
+    }
+
+    if (bbox.min[dimension] < slab_min)
+        bbox.min[dimension] = slab_min;
+
+    if (bbox.max[dimension] > slab_max)
+        bbox.max[dimension] = slab_max;
+
+    return bbox;
+}
+
+bool CurveItemHandler::intersect(
+    const size_t                        item_index,
+    const GAABB3&                       bbox) const
+{
+    const CurveKey& key = m_curve_keys[item_index];
+
+    if (key.get_curve_degree() == 1)
+    {
+        const Curve1Type& curve = m_curves1[key.get_curve_index_tree()];
+        const GScalar half_width = GScalar(0.5) * curve.compute_max_width();
+        return intersect_curve(curve, half_width, bbox, CurveClipDepth);
+    }
+    else
+    {
+        assert(key.get_curve_degree() == 3);
+        const Curve3Type& curve = m_curves3[key.get_curve_index_tree()];
+        const GScalar half_width = GScalar(0.5) * curve.compute_max_width();
+        return intersect_curve(curve, half_width, bbox, CurveClipDepth);
+    }
+}
+
+}   // namespace renderer
@@ -0,0 +1,79 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#pragma once
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/intersection/curvekey.h"
+#include "renderer/kernel/intersection/intersectionsettings.h"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+namespace renderer
+{
+
+//
+// Item handler for the construction of curve trees with spatial splits.
+//
+// Curves are clipped by recursively subdividing them and keeping the pieces
+// that overlap the slab, so that long diagonal segments are only referenced
+// by the nodes they actually pass through.
+//
+
+class CurveItemHandler
+{
+  public:
+    CurveItemHandler(
+        const std::vector<Curve1Type>&          curves1,
+        const std::vector<Curve3Type>&          curves3,
+        const std::vector<CurveKey>&            curve_keys);
+
+    GScalar get_bbox_grow_eps() const;
+
+    GAABB3 clip(
+        const size_t                            item_index,
+        const size_t                            dimension,
+        const GScalar                           slab_min,
+        const GScalar                           slab_max) const;
+
+    bool intersect(
+        const size_t                            item_index,
+        const GAABB3&                           bbox) const;
+
+  private:
+    const std::vector<Curve1Type>&              m_curves1;
+    const std::vector<Curve3Type>&              m_curves3;
+    const std::vector<CurveKey>&                m_curve_keys;
+};
+
+}   // namespace renderer
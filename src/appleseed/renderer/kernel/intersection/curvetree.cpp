@@ -31,6 +31,7 @@
 
 // appleseed.renderer headers.
 #include "renderer/global/globallogger.h"
+#include "renderer/kernel/intersection/curveitemhandler.h"
 #include "renderer/modeling/object/curveobject.h"
 #include "renderer/modeling/object/object.h"
 #include "renderer/modeling/scene/assembly.h"
@@ -40,10 +41,8 @@
 #include "renderer/utility/paramarray.h"
 
 // appleseed.foundation headers.
-#include "foundation/core/exceptions/exceptionnotimplemented.h"
 #include "foundation/math/beziercurve.h"
 #include "foundation/math/permutation.h"
-#include "foundation/math/transform.h"
 #include "foundation/platform/defaulttimers.h"
 #include "foundation/platform/system.h"
 #include "foundation/utility/alignedallocator.h"
@@ -64,6 +63,285 @@ using namespace foundation;
 namespace renderer
 {
 
+//
+// CurveObjectTree class implementation.
+//
+
+CurveObjectTree::CurveObjectTree(
+    const CurveObject&      object,
+    const double            time,
+    const bool              use_spatial_splits)
+  : TreeType(AlignedAllocator<void>(System::get_l1_data_cache_line_size()))
+  , m_curve_count(object.get_curve1_count() + object.get_curve3_count())
+  , m_motion_segment_count(object.get_motion_segment_count())
+{
+    // Collect the curves of the object.
+    std::vector<Curve1Type> curves1;
+    std::vector<Curve3Type> curves3;
+    std::vector<CurveKey> curve_keys;
+    std::vector<GAABB3> curve_bboxes;
+    collect_curves(object, time, curves1, curves3, curve_keys, curve_bboxes);
+
+    if (use_spatial_splits)
+    {
+        // Create the partitioner.
+        typedef bvh::SBVHPartitioner<CurveItemHandler, std::vector<GAABB3>> Partitioner;
+        CurveItemHandler curve_handler(curves1, curves3, curve_keys);
+        Partitioner partitioner(
+            curve_handler,
+            curve_bboxes,
+            CurveTreeDefaultMaxLeafSize,
+            CurveTreeDefaultBinCount,
+            CurveTreeDefaultInteriorNodeTraversalCost,
+            CurveTreeDefaultCurveIntersectionCost);
+
+        // Create the root leaf.
+        Partitioner::LeafType* root_leaf = partitioner.create_root_leaf();
+        const GAABB3 root_leaf_bbox = partitioner.compute_leaf_bbox(*root_leaf);
+
+        // Build the tree.
+        typedef bvh::SpatialBuilder<CurveObjectTree, Partitioner> Builder;
+        Builder builder;
+        builder.build<DefaultWallclockTimer>(
+            *this,
+            partitioner,
+            root_leaf,
+            root_leaf_bbox);
+
+        store_curves(object, partitioner.get_item_ordering(), curves1, curves3, curve_keys);
+    }
+    else
+    {
+        // Create the partitioner.
+        typedef bvh::SAHPartitioner<std::vector<GAABB3>> Partitioner;
+        Partitioner partitioner(
+            curve_bboxes,
+            CurveTreeDefaultMaxLeafSize,
+            CurveTreeDefaultInteriorNodeTraversalCost,
+            CurveTreeDefaultCurveIntersectionCost);
+
+        // Build the tree.
+        typedef bvh::Builder<CurveObjectTree, Partitioner> Builder;
+        Builder builder;
+        builder.build<DefaultWallclockTimer>(
+            *this,
+            partitioner,
+            curve_keys.size(),
+            CurveTreeDefaultMaxLeafSize);
+
+        store_curves(object, partitioner.get_item_ordering(), curves1, curves3, curve_keys);
+    }
+
+    m_bbox.invalidate();
+
+    if (m_motion_segment_count > 0)
+    {
+        // Bound the curves over the whole shutter interval.
+        if (!m_curve_keys.empty())
+        {
+            const std::vector<GAABB3> root_bboxes = compute_motion_bboxes(0);
+            for (size_t i = 0; i < root_bboxes.size(); ++i)
+                m_bbox.insert(root_bboxes[i]);
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < curve_bboxes.size(); ++i)
+            m_bbox.insert(curve_bboxes[i]);
+    }
+}
+
+void CurveObjectTree::collect_curves(
+    const CurveObject&          object,
+    const double                time,
+    std::vector<Curve1Type>&    curves1,
+    std::vector<Curve3Type>&    curves3,
+    std::vector<CurveKey>&      curve_keys,
+    std::vector<GAABB3>&        curve_bboxes) const
+{
+    const size_t curve1_count = object.get_curve1_count();
+    const size_t curve3_count = object.get_curve3_count();
+
+    curves1.reserve(curve1_count);
+    curves3.reserve(curve3_count);
+    curve_keys.reserve(curve1_count + curve3_count);
+    curve_bboxes.reserve(curve1_count + curve3_count);
+
+    // Store degree-1 curves, curve keys and curve bounding boxes.
+    for (size_t i = 0; i < curve1_count; ++i)
+    {
+        const Curve1Type curve = object.interpolate_curve1(i, time);
+        const CurveKey curve_key(
+            0,                  // object instance index, provided by the curve instance
+            i,                  // curve index in object
+            curves1.size(),     // curve index in tree
+            0,                  // for now we assume all the curves have the same material
+            1);                 // curve degree
+
+        GAABB3 curve_bbox = curve.compute_bbox();
+        curve_bbox.grow(GVector3(GScalar(0.5) * curve.compute_max_width()));
+
+        curves1.push_back(curve);
+        curve_keys.push_back(curve_key);
+        curve_bboxes.push_back(curve_bbox);
+    }
+
+    // Store degree-3 curves, curve keys and curve bounding boxes.
+    for (size_t i = 0; i < curve3_count; ++i)
+    {
+        const Curve3Type curve = object.interpolate_curve3(i, time);
+        const CurveKey curve_key(
+            0,                  // object instance index, provided by the curve instance
+            i,                  // curve index in object
+            curves3.size(),     // curve index in tree
+            0,                  // for now we assume all the curves have the same material
+            3);                 // curve degree
+
+        GAABB3 curve_bbox = curve.compute_bbox();
+        curve_bbox.grow(GVector3(GScalar(0.5) * curve.compute_max_width()));
+
+        curves3.push_back(curve);
+        curve_keys.push_back(curve_key);
+        curve_bboxes.push_back(curve_bbox);
+    }
+}
+
+void CurveObjectTree::store_curves(
+    const CurveObject&              object,
+    const std::vector<size_t>&      ordering,
+    const std::vector<Curve1Type>&  curves1,
+    const std::vector<Curve3Type>&  curves3,
+    const std::vector<CurveKey>&    curve_keys)
+{
+    const size_t pose_count = m_motion_segment_count + 1;
+
+    // With spatial splits, a curve may be referenced by more than one leaf.
+    m_curves1.reserve(curves1.size() * pose_count);
+    m_curves3.reserve(curves3.size() * pose_count);
+    m_curve_keys.resize(ordering.size());
+
+    size_t curve1_reference_count = 0;
+    size_t curve3_reference_count = 0;
+
+    for (size_t i = 0; i < m_nodes.size(); ++i)
+    {
+        if (!m_nodes[i].is_leaf())
+            continue;
+
+        const size_t item_index = m_nodes[i].get_item_index();
+        const size_t item_count = m_nodes[i].get_item_count();
+
+        // Store count and start offset in the leaf node's user data.
+        LeafUserData& user_data = m_nodes[i].get_user_data<LeafUserData>();
+        user_data.m_curve1_offset = static_cast<std::uint32_t>(curve1_reference_count);
+        user_data.m_curve1_count = 0;
+        user_data.m_curve3_offset = static_cast<std::uint32_t>(curve3_reference_count);
+        user_data.m_curve3_count = 0;
+
+        // Store the degree-1 curves of this leaf, then its degree-3 curves.
+        size_t output_index = item_index;
+        for (size_t j = 0; j < item_count; ++j)
+        {
+            const CurveKey& key = curve_keys[ordering[item_index + j]];
+            if (key.get_curve_degree() == 1)
+            {
+                CurveKey& stored_key = m_curve_keys[output_index++];
+                stored_key = key;
+                stored_key.set_curve_index_tree(curve1_reference_count++);
+                if (m_motion_segment_count > 0)
+                {
+                    const size_t curve_index = key.get_curve_index_object();
+                    m_curves1.push_back(object.get_curve1(curve_index));
+                    for (size_t k = 0; k < m_motion_segment_count; ++k)
+                        m_curves1.push_back(object.get_curve1_pose(curve_index, k));
+                }
+                else m_curves1.push_back(curves1[key.get_curve_index_tree()]);
+                ++user_data.m_curve1_count;
+            }
+        }
+        for (size_t j = 0; j < item_count; ++j)
+        {
+            const CurveKey& key = curve_keys[ordering[item_index + j]];
+            if (key.get_curve_degree() == 3)
+            {
+                CurveKey& stored_key = m_curve_keys[output_index++];
+                stored_key = key;
+                stored_key.set_curve_index_tree(curve3_reference_count++);
+                if (m_motion_segment_count > 0)
+                {
+                    const size_t curve_index = key.get_curve_index_object();
+                    m_curves3.push_back(object.get_curve3(curve_index));
+                    for (size_t k = 0; k < m_motion_segment_count; ++k)
+                        m_curves3.push_back(object.get_curve3_pose(curve_index, k));
+                }
+                else m_curves3.push_back(curves3[key.get_curve_index_tree()]);
+                ++user_data.m_curve3_count;
+            }
+        }
+
+        assert(output_index == item_index + item_count);
+    }
+}
+
+std::vector<GAABB3> CurveObjectTree::compute_motion_bboxes(const size_t node_index)
+{
+    NodeType& node = m_nodes[node_index];
+
+    if (node.is_interior())
+    {
+        const std::vector<GAABB3> left_bboxes = compute_motion_bboxes(node.get_child_node_index() + 0);
+        const std::vector<GAABB3> right_bboxes = compute_motion_bboxes(node.get_child_node_index() + 1);
+
+        node.set_left_bbox_count(left_bboxes.size());
+        node.set_left_bbox_index(m_node_bboxes.size());
+        m_node_bboxes.insert(m_node_bboxes.end(), left_bboxes.begin(), left_bboxes.end());
+
+        node.set_right_bbox_count(right_bboxes.size());
+        node.set_right_bbox_index(m_node_bboxes.size());
+        m_node_bboxes.insert(m_node_bboxes.end(), right_bboxes.begin(), right_bboxes.end());
+
+        std::vector<GAABB3> bboxes(left_bboxes);
+        for (size_t i = 0; i < bboxes.size(); ++i)
+            bboxes[i].insert(right_bboxes[i]);
+
+        return bboxes;
+    }
+    else
+    {
+        // Control points move linearly between poses, so at any time a curve lies
+        // within the interpolation of the bounding boxes of the surrounding poses.
+        const size_t pose_count = m_motion_segment_count + 1;
+        const LeafUserData& user_data = node.get_user_data<LeafUserData>();
+
+        std::vector<GAABB3> bboxes(pose_count);
+
+        for (size_t k = 0; k < pose_count; ++k)
+        {
+            GAABB3& bbox = bboxes[k];
+            bbox.invalidate();
+
+            for (size_t i = 0; i < user_data.m_curve1_count; ++i)
+            {
+                const Curve1Type& curve = m_curves1[(user_data.m_curve1_offset + i) * pose_count + k];
+                GAABB3 curve_bbox = curve.compute_bbox();
+                curve_bbox.grow(GVector3(GScalar(0.5) * curve.compute_max_width()));
+                bbox.insert(curve_bbox);
+            }
+
+            for (size_t i = 0; i < user_data.m_curve3_count; ++i)
+            {
+                const Curve3Type& curve = m_curves3[(user_data.m_curve3_offset + i) * pose_count + k];
+                GAABB3 curve_bbox = curve.compute_bbox();
+                curve_bbox.grow(GVector3(GScalar(0.5) * curve.compute_max_width()));
+                bbox.insert(curve_bbox);
+            }
+        }
+
+        return bboxes;
+    }
+}
+
+
 //
 // CurveTree class implementation.
 //
@@ -97,9 +375,7 @@ CurveTree::CurveTree(const Arguments& arguments)
 
     // Build the tree.
     Statistics statistics;
-    if (algorithm == "bvh")
-        build_bvh(params, time, statistics);
-    else throw ExceptionNotImplemented();
+    build_bvh(params, time, algorithm == "sbvh", statistics);
     statistics.insert_time("total build time", stopwatch.measure().get_seconds());
     statistics.insert_size("nodes alignment", alignment(&m_nodes[0]));
 
@@ -110,10 +386,16 @@ CurveTree::CurveTree(const Arguments& arguments)
             statistics).to_string().c_str());
 }
 
-void CurveTree::collect_curves(std::vector<GAABB3>& curve_bboxes)
+void CurveTree::collect_instances(
+    const double            time,
+    const bool              use_spatial_splits,
+    std::vector<GAABB3>&    instance_bboxes)
 {
     const ObjectInstanceContainer& object_instances = m_arguments.m_assembly.object_instances();
 
+    // Curve object trees indexed by the curve object they were built for.
+    std::map<const Object*, const CurveObjectTree*> object_trees;
+
     for (size_t i = 0; i < object_instances.size(); ++i)
     {
         // Retrieve the object instance.
@@ -127,78 +409,72 @@ void CurveTree::collect_curves(std::vector<GAABB3>& curve_bboxes)
         if (strcmp(object.get_model(), CurveObjectFactory().get_model()) != 0)
             continue;
 
-        const CurveObject& curve_object = static_cast<const CurveObject&>(object);
-
-        // Retrieve the object instance transform.
-        const Transformd::MatrixType& transform =
-            object_instance->get_transform().get_local_to_parent();
-
-        // Store degree-1 curves, curve keys and curve bounding boxes.
-        const size_t curve1_count = curve_object.get_curve1_count();
-        for (size_t j = 0; j < curve1_count; ++j)
+        // Build the tree of this curve object if it's the first time we encounter it.
+        const CurveObjectTree*& object_tree = object_trees[&object];
+        if (object_tree == nullptr)
         {
-            const Curve1Type curve(curve_object.get_curve1(j), transform);
-            const CurveKey curve_key(
-                i,                  // object instance index
-                j,                  // curve index in object
-                m_curves1.size(),   // curve index in tree
-                0,                  // for now we assume all the curves have the same material
-                1);                 // curve degree
-
-            GAABB3 curve_bbox = curve.compute_bbox();
-            curve_bbox.grow(GVector3(GScalar(0.5) * curve.compute_max_width()));
-
-            m_curves1.push_back(curve);
-            m_curve_keys.push_back(curve_key);
-            curve_bboxes.push_back(curve_bbox);
+            m_object_trees.emplace_back(
+                new CurveObjectTree(
+                    static_cast<const CurveObject&>(object),
+                    time,
+                    use_spatial_splits));
+            object_tree = m_object_trees.back().get();
         }
 
-        // Store degree-3 curves, curve keys and curve bounding boxes.
-        const size_t curve3_count = curve_object.get_curve3_count();
-        for (size_t j = 0; j < curve3_count; ++j)
-        {
-            const Curve3Type curve(curve_object.get_curve3(j), transform);
-            const CurveKey curve_key(
-                i,                  // object instance index
-                j,                  // curve index in object
-                m_curves3.size(),   // curve index in tree
-                0,                  // for now we assume all the curves have the same material
-                3);                 // curve degree
-
-            GAABB3 curve_bbox = curve.compute_bbox();
-            curve_bbox.grow(GVector3(GScalar(0.5) * curve.compute_max_width()));
-
-            m_curves3.push_back(curve);
-            m_curve_keys.push_back(curve_key);
-            curve_bboxes.push_back(curve_bbox);
-        }
+        // Skip instances of curve objects without curves.
+        if (object_tree->get_curve_count() == 0)
+            continue;
+
+        // Store the curve instance and its bounding box.
+        CurveInstance instance;
+        instance.m_object_instance_index = i;
+        instance.m_object_tree = object_tree;
+        instance.m_transform = object_instance->get_transform();
+        m_instances.push_back(instance);
+        instance_bboxes.push_back(instance.m_transform.to_parent(object_tree->get_bbox()));
     }
 }
 
 void CurveTree::build_bvh(
     const ParamArray&       params,
     const double            time,
+    const bool              use_spatial_splits,
     Statistics&             statistics)
 {
-    // Collect curves for this tree.
+    // Collect curve instances and build curve object trees.
     RENDERER_LOG_INFO(
         "collecting geometry for curve tree #" FMT_UNIQUE_ID " from assembly \"%s\"...",
         m_arguments.m_curve_tree_uid,
         m_arguments.m_assembly.get_path().c_str());
-    std::vector<GAABB3> curve_bboxes;
-    collect_curves(curve_bboxes);
+    std::vector<GAABB3> instance_bboxes;
+    collect_instances(time, use_spatial_splits, instance_bboxes);
+
+    size_t curve_count = 0;
+    size_t curve_reference_count = 0;
+    for (size_t i = 0; i < m_object_trees.size(); ++i)
+    {
+        curve_count += m_object_trees[i]->get_curve_count();
+        curve_reference_count += m_object_trees[i]->get_curve_reference_count();
+    }
+
+    size_t instanced_curve_count = 0;
+    for (size_t i = 0; i < m_instances.size(); ++i)
+        instanced_curve_count += m_instances[i].m_object_tree->get_curve_count();
 
     // Print statistics about the input geometry.
     RENDERER_LOG_INFO(
-        "building curve tree #" FMT_UNIQUE_ID " (bvh, %s %s)...",
+        "building curve tree #" FMT_UNIQUE_ID " (%s, %s %s, %s %s)...",
         m_arguments.m_curve_tree_uid,
-        pretty_uint(m_curve_keys.size()).c_str(),
-        plural(m_curve_keys.size(), "curve").c_str());
+        use_spatial_splits ? "sbvh" : "bvh",
+        pretty_uint(m_instances.size()).c_str(),
+        plural(m_instances.size(), "curve instance").c_str(),
+        pretty_uint(instanced_curve_count).c_str(),
+        plural(instanced_curve_count, "curve").c_str());
 
     // Create the partitioner.
     typedef bvh::SAHPartitioner<std::vector<GAABB3>> Partitioner;
     Partitioner partitioner(
-        curve_bboxes,
+        instance_bboxes,
         CurveTreeDefaultMaxLeafSize,
         CurveTreeDefaultInteriorNodeTraversalCost,
         CurveTreeDefaultCurveIntersectionCost);
@@ -209,95 +485,22 @@ void CurveTree::build_bvh(
     builder.build<DefaultWallclockTimer>(
         *this,
         partitioner,
-        m_curves1.size() + m_curves3.size(),
+        m_instances.size(),
         CurveTreeDefaultMaxLeafSize);
     statistics.merge(
         bvh::TreeStatistics<CurveTree>(*this, m_arguments.m_bbox));
-
-    // Reorder the curve keys based on the nodes ordering.
-    if (!m_curves1.empty() || !m_curves3.empty())
+    statistics.insert("curve objects", m_object_trees.size());
+    statistics.insert("curve instances", m_instances.size());
+    statistics.insert("unique curves", curve_count);
+    statistics.insert("stored curves", curve_reference_count);
+    statistics.insert("instanced curves", instanced_curve_count);
+
+    // Reorder the curve instances based on the nodes ordering.
+    if (!m_instances.empty())
     {
         const std::vector<size_t>& ordering = partitioner.get_item_ordering();
-        reorder_curve_keys(ordering);
-        reorder_curves(ordering);
-        reorder_curve_keys_in_leaf_nodes();
-    }
-}
-
-void CurveTree::reorder_curve_keys(const std::vector<size_t>& ordering)
-{
-    std::vector<CurveKey> temp_keys(m_curve_keys.size());
-    small_item_reorder(&m_curve_keys[0], &temp_keys[0], &ordering[0], ordering.size());
-}
-
-void CurveTree::reorder_curves(const std::vector<size_t>& ordering)
-{
-    std::vector<Curve1Type> new_curves1(m_curves1.size());
-    std::vector<Curve3Type> new_curves3(m_curves3.size());
-
-    size_t curve1_index = 0;
-    size_t curve3_index = 0;
-
-    for (size_t i = 0; i < ordering.size(); ++i)
-    {
-        const CurveKey& key = m_curve_keys[i];
-
-        if (key.get_curve_degree() == 1)
-        {
-            new_curves1[curve1_index] = m_curves1[key.get_curve_index_tree()];
-            m_curve_keys[i].set_curve_index_tree(curve1_index);
-            ++curve1_index;
-        }
-        else
-        {
-            assert(key.get_curve_degree() == 3);
-            new_curves3[curve3_index] = m_curves3[key.get_curve_index_tree()];
-            m_curve_keys[i].set_curve_index_tree(curve3_index);
-            ++curve3_index;
-        }
-    }
-
-    assert(curve1_index == m_curves1.size());
-    assert(curve3_index == m_curves3.size());
-
-    m_curves1.swap(new_curves1);
-    m_curves3.swap(new_curves3);
-}
-
-void CurveTree::reorder_curve_keys_in_leaf_nodes()
-{
-    for (size_t i = 0; i < m_nodes.size(); ++i)
-    {
-        if (!m_nodes[i].is_leaf())
-            continue;
-
-        const size_t item_index = m_nodes[i].get_item_index();
-        const size_t item_count = m_nodes[i].get_item_count();
-
-        // Collect the curve keys for this leaf node.
-        std::vector<CurveKey> curve1_keys;
-        std::vector<CurveKey> curve3_keys;
-        for (size_t j = 0; j < item_count; ++j)
-        {
-            const CurveKey& key = m_curve_keys[item_index + j];
-            if (key.get_curve_degree() == 1)
-                curve1_keys.push_back(key);
-            else curve3_keys.push_back(key);
-        }
-
-        // Store count and start offset in the leaf node's user data.
-        LeafUserData& user_data = m_nodes[i].get_user_data<LeafUserData>();
-        user_data.m_curve1_offset = curve1_keys.empty() ? 0 : static_cast<std::uint32_t>(curve1_keys[0].get_curve_index_tree());
-        user_data.m_curve1_count = static_cast<std::uint32_t>(curve1_keys.size());
-        user_data.m_curve3_offset = curve3_keys.empty() ? 0 : static_cast<std::uint32_t>(curve3_keys[0].get_curve_index_tree());
-        user_data.m_curve3_count = static_cast<std::uint32_t>(curve3_keys.size());
-
-        // Reorder the curve keys in the original list.
-        size_t output_index = item_index;
-        for (size_t j = 0; j < curve1_keys.size(); ++j)
-            m_curve_keys[output_index++] = curve1_keys[j];
-        for (size_t j = 0; j < curve3_keys.size(); ++j)
-            m_curve_keys[output_index++] = curve3_keys[j];
+        std::vector<CurveInstance> temp_instances(m_instances.size());
+        small_item_reorder(&m_instances[0], &temp_instances[0], &ordering[0], ordering.size());
     }
 }
 
@@ -30,6 +30,7 @@
 
 // appleseed.renderer headers.
 #include "renderer/global/globaltypes.h"
+#include "renderer/kernel/intersection/anyhitcontext.h"
 #include "renderer/kernel/intersection/curvekey.h"
 #include "renderer/kernel/intersection/intersectionsettings.h"
 #include "renderer/kernel/intersection/probevisitorbase.h"
@@ -39,12 +40,15 @@
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
 #include "foundation/math/bvh.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/transform.h"
 #include "foundation/utility/alignedvector.h"
 #include "foundation/utility/lazy.h"
 #include "foundation/utility/poolallocator.h"
 #include "foundation/utility/uid.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <map>
@@ -54,15 +58,105 @@
 // Forward declarations.
 namespace foundation    { class Statistics; }
 namespace renderer      { class Assembly; }
+namespace renderer      { class CurveObject; }
 namespace renderer      { class ParamArray; }
 namespace renderer      { class Scene; }
 
 namespace renderer
 {
 
+//
+// Curve object tree.
+//
+// A tree over the curves of a single curve object, built in object space.
+// It is shared by all the instances of that object within an assembly.
+//
+// When the object has motion segments, every curve is stored along with all
+// its poses, and interior nodes carry one bounding box per pose so that the
+// bounds tested by a ray only cover the time segment of that ray.
+//
+
+class CurveObjectTree
+  : public foundation::bvh::Tree<
+               foundation::AlignedVector<
+                   foundation::bvh::Node<GAABB3>
+               >
+           >
+{
+  public:
+    // Constructor, builds the tree for a given curve object. The topology of
+    // the tree is determined by the curves at the given time.
+    CurveObjectTree(
+        const CurveObject&                      object,
+        const double                            time,
+        const bool                              use_spatial_splits);
+
+    // Return the object space bounding box of the curves.
+    const GAABB3& get_bbox() const;
+
+    // Return the number of curves of the object.
+    size_t get_curve_count() const;
+
+    // Return the number of curves stored in the tree. It exceeds the number
+    // of curves of the object when spatial splits duplicated some of them.
+    size_t get_curve_reference_count() const;
+
+    // Return the number of motion segments of the curves.
+    size_t get_motion_segment_count() const;
+
+  private:
+    friend class CurveObjectLeafVisitor;
+    friend class CurveObjectLeafProbeVisitor;
+
+    struct LeafUserData
+    {
+        std::uint32_t       m_curve1_offset;
+        std::uint32_t       m_curve1_count;
+        std::uint32_t       m_curve3_offset;
+        std::uint32_t       m_curve3_count;
+    };
+
+    GAABB3                  m_bbox;
+    size_t                  m_curve_count;
+    size_t                  m_motion_segment_count;
+    std::vector<Curve1Type> m_curves1;      // motion_segment_count + 1 poses per curve
+    std::vector<Curve3Type> m_curves3;      // motion_segment_count + 1 poses per curve
+    std::vector<CurveKey>   m_curve_keys;
+
+    void collect_curves(
+        const CurveObject&                      object,
+        const double                            time,
+        std::vector<Curve1Type>&                curves1,
+        std::vector<Curve3Type>&                curves3,
+        std::vector<CurveKey>&                  curve_keys,
+        std::vector<GAABB3>&                    curve_bboxes) const;
+
+    // Store curves and curve keys in the order given by the leaves of the tree,
+    // all degree-1 curves of a leaf coming before its degree-3 curves.
+    void store_curves(
+        const CurveObject&                      object,
+        const std::vector<size_t>&              ordering,
+        const std::vector<Curve1Type>&          curves1,
+        const std::vector<Curve3Type>&          curves3,
+        const std::vector<CurveKey>&            curve_keys);
+
+    // Compute one bounding box per pose for the subtree rooted at a given node.
+    std::vector<GAABB3> compute_motion_bboxes(const size_t node_index);
+
+    // Return the pose preceding a given time and the weight of the pose following it.
+    void get_pose_interpolation(
+        const double                            time,
+        size_t&                                 pose_index,
+        GScalar&                                pose_weight) const;
+};
+
+
 //
 // Curve tree.
 //
+// A tree over the curve object instances of an assembly. Each leaf references
+// the curve object tree of an instance, which is traversed in object space.
+//
 
 class CurveTree
   : public foundation::bvh::Tree<
@@ -95,34 +189,27 @@ class CurveTree
     friend class CurveLeafVisitor;
     friend class CurveLeafProbeVisitor;
 
-    struct LeafUserData
+    struct CurveInstance
     {
-        std::uint32_t       m_curve1_offset;
-        std::uint32_t       m_curve1_count;
-        std::uint32_t       m_curve3_offset;
-        std::uint32_t       m_curve3_count;
+        size_t                                  m_object_instance_index;
+        const CurveObjectTree*                  m_object_tree;
+        foundation::Transformd                  m_transform;
     };
 
-    const Arguments         m_arguments;
-    std::vector<Curve1Type> m_curves1;
-    std::vector<Curve3Type> m_curves3;
-    std::vector<CurveKey>   m_curve_keys;
+    const Arguments                                 m_arguments;
+    std::vector<std::unique_ptr<CurveObjectTree>>   m_object_trees;
+    std::vector<CurveInstance>                      m_instances;
 
-    void collect_curves(std::vector<GAABB3>& curve_bboxes);
+    void collect_instances(
+        const double                            time,
+        const bool                              use_spatial_splits,
+        std::vector<GAABB3>&                    instance_bboxes);
 
     void build_bvh(
         const ParamArray&                       params,
         const double                            time,
+        const bool                              use_spatial_splits,
         foundation::Statistics&                 statistics);
-
-    // Reorder curve keys to match a given ordering.
-    void reorder_curve_keys(const std::vector<size_t>& ordering);
-
-    // Reorder curves to match a given ordering.
-    void reorder_curves(const std::vector<size_t>& ordering);
-
-    // Reorder curve keys in leaf nodes so that all degree-1 curve keys come before degree-3 ones.
-    void reorder_curve_keys_in_leaf_nodes();
 };
 
 
@@ -167,6 +254,103 @@ typedef foundation::AccessCacheMap<
 > CurveTreeAccessCache;
 
 
+//
+// Curve object leaf visitor, used during curve object tree intersection.
+//
+
+class CurveObjectLeafVisitor
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    CurveObjectLeafVisitor(
+        const CurveObjectTree&                  tree,
+        const CurveMatrixType&                  xfm_matrix,
+        const size_t                            object_instance_index,
+        const double                            ray_time,
+        ShadingPoint&                           shading_point);
+
+    // Visit a leaf.
+    bool visit(
+        const CurveObjectTree::NodeType&        node,
+        const GRay3&                            ray,
+        const GRayInfo3&                        ray_info,
+        GScalar&                                distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics& stats
+#endif
+        );
+
+  private:
+    const CurveObjectTree&                      m_tree;
+    const CurveMatrixType&                      m_xfm_matrix;
+    const size_t                                m_object_instance_index;
+    ShadingPoint&                               m_shading_point;
+    size_t                                      m_pose_index;
+    GScalar                                     m_pose_weight;
+};
+
+
+//
+// Curve object leaf visitor for probe rays, only return boolean answers
+// (whether an intersection was found or not).
+//
+// When an any-hit context is provided, every intersection is reported to it and
+// a hit is only recorded once the context considers the ray blocked.
+//
+
+class CurveObjectLeafProbeVisitor
+  : public ProbeVisitorBase
+{
+  public:
+    // Constructor.
+    CurveObjectLeafProbeVisitor(
+        const CurveObjectTree&                  tree,
+        const CurveMatrixType&                  xfm_matrix,
+        const size_t                            object_instance_index,
+        const double                            ray_time,
+        AnyHitContext*                          any_hit_context = nullptr);
+
+    // Visit a leaf.
+    bool visit(
+        const CurveObjectTree::NodeType&        node,
+        const GRay3&                            ray,
+        const GRayInfo3&                        ray_info,
+        GScalar&                                distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics& stats
+#endif
+        );
+
+  private:
+    const CurveObjectTree&                      m_tree;
+    const CurveMatrixType&                      m_xfm_matrix;
+    const size_t                                m_object_instance_index;
+    AnyHitContext*                              m_any_hit_context;
+    size_t                                      m_pose_index;
+    GScalar                                     m_pose_weight;
+};
+
+
+//
+// Curve object tree intersectors.
+//
+
+typedef foundation::bvh::Intersector<
+    CurveObjectTree,
+    CurveObjectLeafVisitor,
+    GRay3,
+    CurveTreeStackSize
+> CurveObjectTreeIntersector;
+
+typedef foundation::bvh::Intersector<
+    CurveObjectTree,
+    CurveObjectLeafProbeVisitor,
+    GRay3,
+    CurveTreeStackSize
+> CurveObjectTreeProbeIntersector;
+
+
 //
 // Curve leaf visitor, used during tree intersection.
 //
@@ -178,7 +362,6 @@ class CurveLeafVisitor
     // Constructor.
     CurveLeafVisitor(
         const CurveTree&                        tree,
-        const CurveMatrixType&                  xfm_matrix,
         ShadingPoint&                           shading_point);
 
     // Visit a leaf.
@@ -194,7 +377,6 @@ class CurveLeafVisitor
 
   private:
     const CurveTree&                            m_tree;
-    const CurveMatrixType&                      m_xfm_matrix;
     ShadingPoint&                               m_shading_point;
 };
 
@@ -211,7 +393,8 @@ class CurveLeafProbeVisitor
     // Constructor.
     CurveLeafProbeVisitor(
         const CurveTree&                        tree,
-        const CurveMatrixType&                  xfm_matrix);
+        const double                            ray_time,
+        AnyHitContext*                          any_hit_context = nullptr);
 
     // Visit a leaf.
     bool visit(
@@ -226,7 +409,8 @@ class CurveLeafProbeVisitor
 
   private:
     const CurveTree&                            m_tree;
-    const CurveMatrixType&                      m_xfm_matrix;
+    const double                                m_ray_time;
+    AnyHitContext*                              m_any_hit_context;
 };
 
 
@@ -250,21 +434,67 @@ typedef foundation::bvh::Intersector<
 
 
 //
-// CurveLeafVisitor class implementation.
+// CurveObjectTree class implementation.
 //
 
-inline CurveLeafVisitor::CurveLeafVisitor(
-    const CurveTree&                            tree,
+inline const GAABB3& CurveObjectTree::get_bbox() const
+{
+    return m_bbox;
+}
+
+inline size_t CurveObjectTree::get_curve_count() const
+{
+    return m_curve_count;
+}
+
+inline size_t CurveObjectTree::get_curve_reference_count() const
+{
+    return m_curve_keys.size();
+}
+
+inline size_t CurveObjectTree::get_motion_segment_count() const
+{
+    return m_motion_segment_count;
+}
+
+inline void CurveObjectTree::get_pose_interpolation(
+    const double                                time,
+    size_t&                                     pose_index,
+    GScalar&                                    pose_weight) const
+{
+    if (m_motion_segment_count == 0)
+    {
+        pose_index = 0;
+        pose_weight = GScalar(0.0);
+        return;
+    }
+
+    const double base_time = time * m_motion_segment_count;
+    pose_index = std::min(foundation::truncate<size_t>(base_time), m_motion_segment_count - 1);
+    pose_weight = static_cast<GScalar>(base_time - pose_index);
+}
+
+
+//
+// CurveObjectLeafVisitor class implementation.
+//
+
+inline CurveObjectLeafVisitor::CurveObjectLeafVisitor(
+    const CurveObjectTree&                      tree,
     const CurveMatrixType&                      xfm_matrix,
+    const size_t                                object_instance_index,
+    const double                                ray_time,
     ShadingPoint&                               shading_point)
   : m_tree(tree)
   , m_xfm_matrix(xfm_matrix)
+  , m_object_instance_index(object_instance_index)
   , m_shading_point(shading_point)
 {
+    m_tree.get_pose_interpolation(ray_time, m_pose_index, m_pose_weight);
 }
 
-inline bool CurveLeafVisitor::visit(
-    const CurveTree::NodeType&                  node,
+inline bool CurveObjectLeafVisitor::visit(
+    const CurveObjectTree::NodeType&            node,
     const GRay3&                                ray,
     const GRayInfo3&                            ray_info,
     GScalar&                                    distance
@@ -273,16 +503,24 @@ inline bool CurveLeafVisitor::visit(
 #endif
     )
 {
-    const CurveTree::LeafUserData& user_data = node.get_user_data<CurveTree::LeafUserData>();
+    const CurveObjectTree::LeafUserData& user_data = node.get_user_data<CurveObjectTree::LeafUserData>();
+
+    const size_t pose_count = m_tree.m_motion_segment_count + 1;
 
     size_t curve_index = node.get_item_index();
     size_t hit_curve_index = ~size_t(0);
-    GScalar u, v, t = ray.m_tmax;
+
+    // Only look for hits closer than the closest hit found so far.
+    GScalar u, v, t = std::min(ray.m_tmax, static_cast<GScalar>(m_shading_point.m_ray.m_tmax));
 
     for (std::uint32_t i = 0; i < user_data.m_curve1_count; ++i, ++curve_index)
     {
-        const Curve1Type& curve = m_tree.m_curves1[user_data.m_curve1_offset + i];
-        if (Curve1IntersectorType::intersect(curve, ray, m_xfm_matrix, u, v, t))
+        const Curve1Type* poses = &m_tree.m_curves1[(user_data.m_curve1_offset + i) * pose_count];
+        const bool hit =
+            pose_count == 1
+                ? Curve1IntersectorType::intersect(poses[0], ray, m_xfm_matrix, u, v, t)
+                : Curve1IntersectorType::intersect(poses[m_pose_index], poses[m_pose_index + 1], m_pose_weight, ray, m_xfm_matrix, u, v, t);
+        if (hit)
         {
             m_shading_point.m_primitive_type = ShadingPoint::PrimitiveCurve1;
             m_shading_point.m_ray.m_tmax = static_cast<double>(t);
@@ -296,8 +534,12 @@ inline bool CurveLeafVisitor::visit(
 
     for (std::uint32_t i = 0; i < user_data.m_curve3_count; ++i, ++curve_index)
     {
-        const Curve3Type& curve = m_tree.m_curves3[user_data.m_curve3_offset + i];
-        if (Curve3IntersectorType::intersect(curve, ray, m_xfm_matrix, u, v, t))
+        const Curve3Type* poses = &m_tree.m_curves3[(user_data.m_curve3_offset + i) * pose_count];
+        const bool hit =
+            pose_count == 1
+                ? Curve3IntersectorType::intersect(poses[0], ray, m_xfm_matrix, u, v, t)
+                : Curve3IntersectorType::intersect(poses[m_pose_index], poses[m_pose_index + 1], m_pose_weight, ray, m_xfm_matrix, u, v, t);
+        if (hit)
         {
             m_shading_point.m_primitive_type = ShadingPoint::PrimitiveCurve3;
             m_shading_point.m_ray.m_tmax = static_cast<double>(t);
@@ -312,7 +554,7 @@ inline bool CurveLeafVisitor::visit(
     if (hit_curve_index != ~size_t(0))
     {
         const CurveKey& curve_key = m_tree.m_curve_keys[hit_curve_index];
-        m_shading_point.m_object_instance_index = curve_key.get_object_instance_index();
+        m_shading_point.m_object_instance_index = m_object_instance_index;
         m_shading_point.m_primitive_index = curve_key.get_curve_index_object();
     }
 
@@ -323,19 +565,25 @@ inline bool CurveLeafVisitor::visit(
 
 
 //
-// CurveLeafProbeVisitor class implementation.
+// CurveObjectLeafProbeVisitor class implementation.
 //
 
-inline CurveLeafProbeVisitor::CurveLeafProbeVisitor(
-    const CurveTree&                            tree,
-    const CurveMatrixType&                      xfm_matrix)
+inline CurveObjectLeafProbeVisitor::CurveObjectLeafProbeVisitor(
+    const CurveObjectTree&                      tree,
+    const CurveMatrixType&                      xfm_matrix,
+    const size_t                                object_instance_index,
+    const double                                ray_time,
+    AnyHitContext*                              any_hit_context)
   : m_tree(tree)
   , m_xfm_matrix(xfm_matrix)
+  , m_object_instance_index(object_instance_index)
+  , m_any_hit_context(any_hit_context)
 {
+    m_tree.get_pose_interpolation(ray_time, m_pose_index, m_pose_weight);
 }
 
-inline bool CurveLeafProbeVisitor::visit(
-    const CurveTree::NodeType&                  node,
+inline bool CurveObjectLeafProbeVisitor::visit(
+    const CurveObjectTree::NodeType&            node,
     const GRay3&                                ray,
     const GRayInfo3&                            ray_info,
     GScalar&                                    distance
@@ -344,12 +592,43 @@ inline bool CurveLeafProbeVisitor::visit(
 #endif
     )
 {
-    const CurveTree::LeafUserData& user_data = node.get_user_data<CurveTree::LeafUserData>();
+    const CurveObjectTree::LeafUserData& user_data = node.get_user_data<CurveObjectTree::LeafUserData>();
 
-    for (std::uint32_t i = 0; i < user_data.m_curve1_count; ++i)
+    const size_t pose_count = m_tree.m_motion_segment_count + 1;
+
+    size_t curve_index = node.get_item_index();
+
+    for (std::uint32_t i = 0; i < user_data.m_curve1_count; ++i, ++curve_index)
     {
-        const Curve1Type& curve = m_tree.m_curves1[user_data.m_curve1_offset + i];
-        if (Curve1IntersectorType::intersect(curve, ray, m_xfm_matrix))
+        const Curve1Type* poses = &m_tree.m_curves1[(user_data.m_curve1_offset + i) * pose_count];
+
+        bool blocked;
+        if (m_any_hit_context == nullptr)
+        {
+            blocked =
+                pose_count == 1
+                    ? Curve1IntersectorType::intersect(poses[0], ray, m_xfm_matrix)
+                    : Curve1IntersectorType::intersect(poses[m_pose_index], poses[m_pose_index + 1], m_pose_weight, ray, m_xfm_matrix);
+        }
+        else
+        {
+            GScalar u, v, t = ray.m_tmax;
+            const bool hit =
+                pose_count == 1
+                    ? Curve1IntersectorType::intersect(poses[0], ray, m_xfm_matrix, u, v, t)
+                    : Curve1IntersectorType::intersect(poses[m_pose_index], poses[m_pose_index + 1], m_pose_weight, ray, m_xfm_matrix, u, v, t);
+            blocked =
+                hit &&
+                !m_any_hit_context->on_curve_hit(
+                    m_object_instance_index,
+                    m_tree.m_curve_keys[curve_index].get_curve_index_object(),
+                    ShadingPoint::PrimitiveCurve1,
+                    static_cast<double>(t),
+                    static_cast<double>(u),
+                    static_cast<double>(v));
+        }
+
+        if (blocked)
         {
             FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(i + 1));
             m_hit = true;
@@ -359,10 +638,37 @@ inline bool CurveLeafProbeVisitor::visit(
 
     FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(curve1_curve_count));
 
-    for (std::uint32_t i = 0; i < user_data.m_curve3_count; ++i)
+    for (std::uint32_t i = 0; i < user_data.m_curve3_count; ++i, ++curve_index)
     {
-        const Curve3Type& curve = m_tree.m_curves3[user_data.m_curve3_offset + i];
-        if (Curve3IntersectorType::intersect(curve, ray, m_xfm_matrix))
+        const Curve3Type* poses = &m_tree.m_curves3[(user_data.m_curve3_offset + i) * pose_count];
+
+        bool blocked;
+        if (m_any_hit_context == nullptr)
+        {
+            blocked =
+                pose_count == 1
+                    ? Curve3IntersectorType::intersect(poses[0], ray, m_xfm_matrix)
+                    : Curve3IntersectorType::intersect(poses[m_pose_index], poses[m_pose_index + 1], m_pose_weight, ray, m_xfm_matrix);
+        }
+        else
+        {
+            GScalar u, v, t = ray.m_tmax;
+            const bool hit =
+                pose_count == 1
+                    ? Curve3IntersectorType::intersect(poses[0], ray, m_xfm_matrix, u, v, t)
+                    : Curve3IntersectorType::intersect(poses[m_pose_index], poses[m_pose_index + 1], m_pose_weight, ray, m_xfm_matrix, u, v, t);
+            blocked =
+                hit &&
+                !m_any_hit_context->on_curve_hit(
+                    m_object_instance_index,
+                    m_tree.m_curve_keys[curve_index].get_curve_index_object(),
+                    ShadingPoint::PrimitiveCurve3,
+                    static_cast<double>(t),
+                    static_cast<double>(u),
+                    static_cast<double>(v));
+        }
+
+        if (blocked)
         {
             FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(i + 1));
             m_hit = true;
@@ -377,4 +683,167 @@ inline bool CurveLeafProbeVisitor::visit(
     return true;
 }
 
+
+//
+// CurveLeafVisitor class implementation.
+//
+
+inline CurveLeafVisitor::CurveLeafVisitor(
+    const CurveTree&                            tree,
+    ShadingPoint&                               shading_point)
+  : m_tree(tree)
+  , m_shading_point(shading_point)
+{
+}
+
+inline bool CurveLeafVisitor::visit(
+    const CurveTree::NodeType&                  node,
+    const GRay3&                                ray,
+    const GRayInfo3&                            ray_info,
+    GScalar&                                    distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , foundation::bvh::TraversalStatistics&     stats
+#endif
+    )
+{
+    const size_t instance_begin = node.get_item_index();
+    const size_t instance_end = instance_begin + node.get_item_count();
+
+    for (size_t i = instance_begin; i < instance_end; ++i)
+    {
+        const CurveTree::CurveInstance& instance = m_tree.m_instances[i];
+
+        // Transform the ray to object space. The direction is not renormalized
+        // so that distances along the ray remain valid in assembly space.
+        GRay3 object_ray = instance.m_transform.to_local(ray);
+        object_ray.m_tmax = std::min(ray.m_tmax, static_cast<GScalar>(m_shading_point.m_ray.m_tmax));
+        const GRayInfo3 object_ray_info(object_ray);
+
+        // Intersect the curves of the object.
+        CurveMatrixType xfm_matrix;
+        make_curve_projection_transform(xfm_matrix, object_ray);
+        const double ray_time = m_shading_point.m_ray.m_time.m_normalized;
+        CurveObjectLeafVisitor visitor(
+            *instance.m_object_tree,
+            xfm_matrix,
+            instance.m_object_instance_index,
+            ray_time,
+            m_shading_point);
+        CurveObjectTreeIntersector intersector;
+        if (instance.m_object_tree->get_motion_segment_count() > 0)
+        {
+            intersector.intersect_motion(
+                *instance.m_object_tree,
+                object_ray,
+                object_ray_info,
+                static_cast<GScalar>(ray_time),
+                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , stats
+#endif
+                );
+        }
+        else
+        {
+            intersector.intersect_no_motion(
+                *instance.m_object_tree,
+                object_ray,
+                object_ray_info,
+                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , stats
+#endif
+                );
+        }
+    }
+
+    // Continue traversal.
+    distance = static_cast<GScalar>(m_shading_point.m_ray.m_tmax);
+    return true;
+}
+
+
+//
+// CurveLeafProbeVisitor class implementation.
+//
+
+inline CurveLeafProbeVisitor::CurveLeafProbeVisitor(
+    const CurveTree&                            tree,
+    const double                                ray_time,
+    AnyHitContext*                              any_hit_context)
+  : m_tree(tree)
+  , m_ray_time(ray_time)
+  , m_any_hit_context(any_hit_context)
+{
+}
+
+inline bool CurveLeafProbeVisitor::visit(
+    const CurveTree::NodeType&                  node,
+    const GRay3&                                ray,
+    const GRayInfo3&                            ray_info,
+    GScalar&                                    distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , foundation::bvh::TraversalStatistics&     stats
+#endif
+    )
+{
+    const size_t instance_begin = node.get_item_index();
+    const size_t instance_end = instance_begin + node.get_item_count();
+
+    for (size_t i = instance_begin; i < instance_end; ++i)
+    {
+        const CurveTree::CurveInstance& instance = m_tree.m_instances[i];
+
+        // Transform the ray to object space.
+        const GRay3 object_ray = instance.m_transform.to_local(ray);
+        const GRayInfo3 object_ray_info(object_ray);
+
+        // Intersect the curves of the object.
+        CurveMatrixType xfm_matrix;
+        make_curve_projection_transform(xfm_matrix, object_ray);
+        CurveObjectLeafProbeVisitor visitor(
+            *instance.m_object_tree,
+            xfm_matrix,
+            instance.m_object_instance_index,
+            m_ray_time,
+            m_any_hit_context);
+        CurveObjectTreeProbeIntersector intersector;
+        if (instance.m_object_tree->get_motion_segment_count() > 0)
+        {
+            intersector.intersect_motion(
+                *instance.m_object_tree,
+                object_ray,
+                object_ray_info,
+                static_cast<GScalar>(m_ray_time),
+                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , stats
+#endif
+                );
+        }
+        else
+        {
+            intersector.intersect_no_motion(
+                *instance.m_object_tree,
+                object_ray,
+                object_ray_info,
+                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , stats
+#endif
+                );
+        }
+
+        if (visitor.hit())
+        {
+            m_hit = true;
+            return false;
+        }
+    }
+
+    // Continue traversal.
+    distance = ray.m_tmax;
+    return true;
+}
+
 }   // namespace renderer
@@ -147,7 +147,7 @@ namespace
         //
         // Retrieve per primitive data.
         //
-        const size_t primitives_count = tess.m_primitives.size();
+        const size_t primitives_count = tess.get_primitive_count();
 
         geometry_data.m_primitives = new std::uint32_t[primitives_count * 3];
         geometry_data.m_primitives_stride = sizeof(std::uint32_t) * 3;
@@ -155,9 +155,10 @@ namespace
 
         for (size_t i = 0; i < primitives_count; ++i)
         {
-            geometry_data.m_primitives[i * 3] = tess.m_primitives[i].m_v0;
-            geometry_data.m_primitives[i * 3 + 1] = tess.m_primitives[i].m_v1;
-            geometry_data.m_primitives[i * 3 + 2] = tess.m_primitives[i].m_v2;
+            const Triangle triangle = tess.get_primitive(i);
+            geometry_data.m_primitives[i * 3] = triangle.m_v0;
+            geometry_data.m_primitives[i * 3 + 1] = triangle.m_v1;
+            geometry_data.m_primitives[i * 3 + 2] = triangle.m_v2;
         }
     };
 
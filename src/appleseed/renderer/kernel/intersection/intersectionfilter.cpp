@@ -38,13 +38,15 @@
 #include "renderer/modeling/material/material.h"
 #include "renderer/modeling/object/meshobject.h"
 #include "renderer/modeling/object/object.h"
+#include "renderer/modeling/object/triangle.h"
 #include "renderer/modeling/scene/objectinstance.h"
 
 // appleseed.foundation headers.
-#include "foundation/utility/foreach.h"
+#include "foundation/math/vector.h"
 
 // Standard headers.
 #include <cassert>
+#include <cstddef>
 #include <memory>
 
 using namespace foundation;
@@ -58,18 +60,20 @@ namespace
     {
         const MeshObject& mesh = static_cast<const MeshObject&>(object);
         const StaticTriangleTess& tess = mesh.get_static_triangle_tess();
-        return tess.m_primitives.size();
+        return tess.get_primitive_count();
     }
 
     void copy_uv_coordinates(const StaticTriangleTess& tess, std::vector<Vector2f>& uv)
     {
-        for (const_each<StaticTriangleTess::PrimitiveArray> i = tess.m_primitives; i; ++i)
+        for (size_t i = 0, e = tess.get_primitive_count(); i < e; ++i)
         {
-            if (i->has_vertex_attributes() && tess.get_tex_coords_count() > 0)
+            const Triangle triangle = tess.get_primitive(i);
+
+            if (triangle.has_vertex_attributes() && tess.get_tex_coords_count() > 0)
             {
-                const Vector2f uv0(tess.get_tex_coords(i->m_a0));
-                const Vector2f uv1(tess.get_tex_coords(i->m_a1));
-                const Vector2f uv2(tess.get_tex_coords(i->m_a2));
+                const Vector2f uv0(tess.get_tex_coords(triangle.m_a0));
+                const Vector2f uv1(tess.get_tex_coords(triangle.m_a1));
+                const Vector2f uv2(tess.get_tex_coords(triangle.m_a2));
 
                 uv.emplace_back(uv0[0], 1.0f - uv0[1]);
                 uv.emplace_back(uv1[0], 1.0f - uv1[1]);
@@ -43,6 +43,14 @@
 namespace renderer
 {
 
+//
+// Ray packet settings.
+//
+
+// Maximum number of rays traced together by Intersector::trace_packet().
+const size_t RayPacketSize = 16;
+
+
 //
 // Assembly tree settings.
 //
@@ -80,6 +88,13 @@ const GScalar TriangleTreeDefaultTriangleIntersectionCost(1.0);
 // Number of bins used during SBVH construction.
 const size_t TriangleTreeDefaultBinCount = 256;
 
+// Maximum number of time intervals over which independent subtrees are built for moving triangles.
+const size_t TriangleTreeDefaultMaxTimeIntervals = 4;
+
+// Maximum growth of the SAH cost of a refit triangle tree, relative to its cost when it was built,
+// beyond which the tree is rebuilt instead.
+const double TriangleTreeDefaultMaxRefitSAHCostGrowth = 1.5;
+
 // Define this symbol to enable reordering the nodes of triangle trees for better
 // locality of reference. Requires a lot of temporary memory for minimal results.
 #undef RENDERER_TRIANGLE_TREE_REORDER_NODES
@@ -94,6 +109,13 @@ const size_t TriangleTreeAccessCacheWays = 2;
 // Size of the stack (in number of nodes) used during traversal.
 const size_t TriangleTreeStackSize = 64;
 
+// Branching factor of the wide BVH collapsed from static triangle trees.
+#ifdef APPLESEED_USE_AVX
+const size_t TriangleTreeWideNodeWidth = 8;
+#else
+const size_t TriangleTreeWideNodeWidth = 4;
+#endif
+
 
 //
 // Curve tree settings.
@@ -119,6 +141,9 @@ const GScalar CurveTreeDefaultInteriorNodeTraversalCost(1.0);
 // Relative cost of intersecting a curve.
 const GScalar CurveTreeDefaultCurveIntersectionCost(1.0);
 
+// Number of bins used during SBVH construction.
+const size_t CurveTreeDefaultBinCount = 64;
+
 // Size of the curve tree access cache.
 const size_t CurveTreeAccessCacheLines = 128;
 const size_t CurveTreeAccessCacheWays = 2;
@@ -188,6 +188,77 @@ bool Intersector::trace(
     return shading_point.hit_surface();
 }
 
+void Intersector::trace_packet(
+    const ShadingRay*                   rays,
+    const size_t                        ray_count,
+    ShadingPoint*                       shading_points) const
+{
+    assert(ray_count <= RayPacketSize);
+
+    // Packets of a single ray gain nothing from packet traversal.
+    if (ray_count == 1)
+    {
+        trace(rays[0], shading_points[0]);
+        return;
+    }
+
+    // Update ray casting statistics.
+    m_shading_ray_count += ray_count;
+
+    // Initialize the shading points and compute ray infos once for the entire traversal.
+    ShadingRay::RayInfoType ray_infos[RayPacketSize];
+    for (size_t i = 0; i < ray_count; ++i)
+    {
+        assert(is_normalized(rays[i].m_dir));
+        assert(shading_points[i].m_scene == nullptr);
+        assert(!shading_points[i].is_valid());
+
+        shading_points[i].m_texture_cache = &m_texture_cache;
+        shading_points[i].m_scene = &m_trace_context.get_scene();
+        shading_points[i].m_ray = rays[i];
+
+        ray_infos[i] = ShadingRay::RayInfoType(rays[i]);
+    }
+
+    // Retrieve assembly tree.
+    const AssemblyTree& assembly_tree = m_trace_context.get_assembly_tree();
+
+    // Check the intersection between the rays and the assembly tree.
+    AssemblyTreePacketIntersector intersector;
+    AssemblyLeafPacketVisitor visitor(
+        shading_points,
+        assembly_tree,
+        m_triangle_tree_cache,
+        m_curve_tree_cache
+#ifdef APPLESEED_WITH_EMBREE
+        , m_embree_scene_cache
+#endif
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , m_triangle_tree_traversal_stats
+        , m_curve_tree_traversal_stats
+#endif
+        );
+    intersector.intersect_no_motion(
+        assembly_tree,
+        rays,
+        ray_infos,
+        ray_count,
+        visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , m_assembly_tree_traversal_stats
+#endif
+        );
+
+    for (size_t i = 0; i < ray_count; ++i)
+    {
+        ShadingPoint& shading_point = shading_points[i];
+
+        const ShadingRay::Medium* medium = rays[i].get_current_medium();
+        if (!shading_point.hit_surface() && medium != nullptr && medium->get_volume() != nullptr)
+            shading_point.m_primitive_type = ShadingPoint::PrimitiveVolume;
+    }
+}
+
 bool Intersector::trace_probe(
     const ShadingRay&                   ray,
     const ShadingPoint*                 parent_shading_point) const
@@ -219,7 +290,8 @@ bool Intersector::trace_probe(
 #ifdef APPLESEED_WITH_EMBREE
         m_embree_scene_cache,
 #endif
-        parent_shading_point
+        parent_shading_point,
+        nullptr
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
         , m_triangle_tree_traversal_stats
 #endif
@@ -237,6 +309,76 @@ bool Intersector::trace_probe(
     return visitor.hit();
 }
 
+float Intersector::trace_transmission(
+    const ShadingRay&                   ray,
+    IAnyHitFilter&                      filter,
+    const float                         transmission_threshold,
+    const ShadingPoint*                 parent_shading_point) const
+{
+    assert(is_normalized(ray.m_dir));
+    assert(parent_shading_point == 0 || parent_shading_point->hit_surface());
+    assert(supports_any_hit_traversal());
+
+    // Update ray casting statistics.
+    ++m_probe_ray_count;
+
+    // Compute ray info once for the entire traversal.
+    const ShadingRay::RayInfoType ray_info(ray);
+
+    // Refine and offset the previous intersection point.
+    if (parent_shading_point &&
+        parent_shading_point->hit_surface() &&
+        !(parent_shading_point->m_members & ShadingPoint::HasRefinedPoints))
+        parent_shading_point->refine_and_offset();
+
+    // Retrieve assembly tree.
+    const AssemblyTree& assembly_tree = m_trace_context.get_assembly_tree();
+
+    // Accumulate the transmission of all surfaces crossed by the ray in a single traversal.
+    AnyHitContext any_hit_context(
+        m_trace_context.get_scene(),
+        m_texture_cache,
+        ray,
+        filter,
+        m_alpha_cache,
+        transmission_threshold);
+    AssemblyTreeProbeIntersector intersector;
+    AssemblyLeafProbeVisitor visitor(
+        assembly_tree,
+        m_triangle_tree_cache,
+        m_curve_tree_cache,
+#ifdef APPLESEED_WITH_EMBREE
+        m_embree_scene_cache,
+#endif
+        parent_shading_point,
+        &any_hit_context
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , m_triangle_tree_traversal_stats
+        , m_curve_tree_traversal_stats
+#endif
+        );
+    intersector.intersect_no_motion(
+        assembly_tree,
+        ray,
+        ray_info,
+        visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , m_assembly_tree_traversal_stats
+#endif
+        );
+
+    return visitor.hit() ? 0.0f : any_hit_context.get_transmission();
+}
+
+bool Intersector::supports_any_hit_traversal() const
+{
+#ifdef APPLESEED_WITH_EMBREE
+    return !m_trace_context.get_assembly_tree().use_embree();
+#else
+    return true;
+#endif
+}
+
 void Intersector::make_triangle_shading_point(
     ShadingPoint&                       shading_point,
     const ShadingRay&                   shading_ray,
@@ -30,6 +30,7 @@
 #pragma once
 
 // appleseed.renderer headers.
+#include "renderer/kernel/intersection/anyhitcontext.h"
 #include "renderer/kernel/intersection/curvetree.h"
 #ifdef APPLESEED_WITH_EMBREE
 #include "renderer/kernel/intersection/embreescene.h"
@@ -78,11 +79,33 @@ class Intersector
         ShadingPoint&                       shading_point,
         const ShadingPoint*                 parent_shading_point = nullptr) const;
 
+    // Trace a packet of at most RayPacketSize coherent world space rays through the scene,
+    // for instance camera rays through neighboring image points. This is equivalent to
+    // calling trace() on every ray without parent shading point, but nodes and triangles
+    // are fetched once for the whole packet.
+    void trace_packet(
+        const ShadingRay*                   rays,
+        const size_t                        ray_count,
+        ShadingPoint*                       shading_points) const;
+
     // Trace a world space probe ray through the scene.
     bool trace_probe(
         const ShadingRay&                   ray,
         const ShadingPoint*                 parent_shading_point = nullptr) const;
 
+    // Trace a world space shadow ray through the scene and return its transmission.
+    // The opacity of every crossed surface is evaluated by the given filter, in no
+    // particular order, during a single traversal of the scene. Traversal stops and
+    // zero is returned as soon as the transmission falls below the given threshold.
+    float trace_transmission(
+        const ShadingRay&                   ray,
+        IAnyHitFilter&                      filter,
+        const float                         transmission_threshold,
+        const ShadingPoint*                 parent_shading_point = nullptr) const;
+
+    // Return true if trace_transmission() can be used with the current scene.
+    bool supports_any_hit_traversal() const;
+
     // Manufacture a triangle hit "by hand".
     // There is no restriction placed on the shading point passed to this method.
     // For instance it may have been previously initialized and used.
@@ -134,6 +157,10 @@ class Intersector
 #ifdef APPLESEED_WITH_EMBREE
     mutable EmbreeSceneAccessCache                  m_embree_scene_cache;
 #endif
+
+    // Per-thread cache of the opacity of the primitives crossed by shadow rays.
+    mutable AlphaCache                              m_alpha_cache;
+
     // Intersection statistics.
     mutable std::uint64_t                           m_shading_ray_count;
     mutable std::uint64_t                           m_probe_ray_count;
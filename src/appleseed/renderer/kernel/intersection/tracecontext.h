@@ -35,6 +35,9 @@
 // appleseed.main headers.
 #include "main/dllsymbol.h"
 
+// Standard headers.
+#include <cstddef>
+
 // Forward declarations.
 namespace renderer  { class AssemblyTree; }
 namespace renderer  { class Scene; }
@@ -68,6 +71,9 @@ class APPLESEED_DLLSYMBOL TraceContext
     // Synchronize the trace context with the scene.
     void update();
 
+    // Set the number of threads used to build acceleration structures.
+    void set_thread_count(const size_t thread_count);
+
 #ifdef APPLESEED_WITH_EMBREE
     void set_use_embree(const bool value);
 #endif
@@ -32,9 +32,11 @@
 
 // appleseed.renderer headers.
 #include "renderer/global/globallogger.h"
+#include "renderer/kernel/intersection/anyhitcontext.h"
 #include "renderer/kernel/intersection/intersectionfilter.h"
 #include "renderer/kernel/intersection/triangleencoder.h"
 #include "renderer/kernel/intersection/triangleitemhandler.h"
+#include "renderer/kernel/intersection/triangletreecache.h"
 #include "renderer/kernel/intersection/trianglevertexinfo.h"
 #include "renderer/kernel/shading/shadingpoint.h"
 #include "renderer/kernel/shading/shadingray.h"
@@ -68,6 +70,7 @@
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/makevector.h"
 #include "foundation/utility/memory.h"
+#include "foundation/utility/siphash.h"
 #include "foundation/utility/statistics.h"
 #include "foundation/utility/stopwatch.h"
 #include "foundation/utility/string.h"
@@ -116,7 +119,7 @@ namespace
         size_t&                              triangle_vertex_count)
     {
         const Transformd& transform = object_instance.get_transform();
-        const size_t triangle_count = tess.m_primitives.size();
+        const size_t triangle_count = tess.get_primitive_count();
 
         if (save_memory)
         {
@@ -130,7 +133,7 @@ namespace
         for (size_t i = 0; i < triangle_count; ++i)
         {
             // Fetch the triangle.
-            const Triangle& triangle = tess.m_primitives[i];
+            const Triangle triangle = tess.get_primitive(i);
 
             // Retrieve the object space vertices of the triangle.
             const GVector3& v0_os = tess.m_vertices[triangle.m_v0];
@@ -212,7 +215,7 @@ namespace
     {
         const Transformd& transform = object_instance.get_transform();
         const size_t motion_segment_count = tess.get_motion_segment_count();
-        const size_t triangle_count = tess.m_primitives.size();
+        const size_t triangle_count = tess.get_primitive_count();
 
         if (save_memory)
         {
@@ -228,7 +231,7 @@ namespace
         for (size_t i = 0; i < triangle_count; ++i)
         {
             // Fetch the triangle.
-            const Triangle& triangle = tess.m_primitives[i];
+            const Triangle triangle = tess.get_primitive(i);
 
             // Retrieve the object space vertices of the triangle.
             const GVector3& v0_os = tess.m_vertices[triangle.m_v0];
@@ -386,45 +389,143 @@ TriangleTree::Arguments::Arguments(
     const Scene&            scene,
     const UniqueID          triangle_tree_uid,
     const GAABB3&           bbox,
-    const Assembly&         assembly)
+    const Assembly&         assembly,
+    JobQueue&               job_queue)
   : m_scene(scene)
   , m_triangle_tree_uid(triangle_tree_uid)
   , m_bbox(bbox)
   , m_assembly(assembly)
+  , m_job_queue(job_queue)
 {
 }
 
+namespace
+{
+    size_t get_max_motion_segment_count(const Assembly& assembly)
+    {
+        size_t max_motion_segment_count = 0;
+
+        for (size_t i = 0, e = assembly.object_instances().size(); i < e; ++i)
+        {
+            const ObjectInstance* object_instance = assembly.object_instances().get_by_index(i);
+            assert(object_instance);
+
+            const Object& object = object_instance->get_object();
+            if (strcmp(object.get_model(), MeshObjectFactory().get_model()) != 0)
+                continue;
+
+            const MeshObject& mesh = static_cast<const MeshObject&>(object);
+            max_motion_segment_count =
+                std::max(
+                    max_motion_segment_count,
+                    mesh.get_static_triangle_tess().get_motion_segment_count());
+        }
+
+        return max_motion_segment_count;
+    }
+}
+
 TriangleTree::TriangleTree(const Arguments& arguments)
   : TreeType(AlignedAllocator<void>(System::get_l1_data_cache_line_size()))
   , m_arguments(arguments)
+  , m_static_triangle_count(0)
+  , m_moving_triangle_count(0)
+  , m_build_sah_cost(0.0)
+  , m_use_wide_bvh(false)
+  , m_wide_nodes(AlignedAllocator<void>(System::get_l1_data_cache_line_size()))
+{
+    // Retrieve construction parameters.
+    const ParamArray& params = m_arguments.m_assembly.get_parameters().child("acceleration_structure");
+    const double time = params.get_optional<double>("time", 0.5);
+    const size_t max_time_intervals = params.get_optional<size_t>("max_time_intervals", TriangleTreeDefaultMaxTimeIntervals);
+
+    // Split the shutter interval when triangles move over more than one motion segment.
+    const size_t time_interval_count =
+        std::min(
+            get_max_motion_segment_count(m_arguments.m_assembly),
+            max_time_intervals);
+
+    if (time_interval_count > 1)
+        build_time_interval_trees(time_interval_count);
+    else build(time, true);
+}
+
+TriangleTree::TriangleTree(
+    const Arguments&        arguments,
+    const double            time_begin,
+    const double            time_end)
+  : TreeType(AlignedAllocator<void>(System::get_l1_data_cache_line_size()))
+  , m_arguments(arguments)
+  , m_static_triangle_count(0)
+  , m_moving_triangle_count(0)
+  , m_build_sah_cost(0.0)
+  , m_use_wide_bvh(false)
+  , m_wide_nodes(AlignedAllocator<void>(System::get_l1_data_cache_line_size()))
+{
+    // Subtrees are not cached since the cache only identifies whole trees.
+    build(0.5 * (time_begin + time_end), false);
+}
+
+void TriangleTree::build(
+    const double            time,
+    const bool              use_cache)
 {
     // Retrieve construction parameters.
     const MessageContext message_context(
         format("while building triangle tree for assembly \"{0}\"", m_arguments.m_assembly.get_path()));
     const ParamArray& params = m_arguments.m_assembly.get_parameters().child("acceleration_structure");
     const std::string algorithm = params.get_optional<std::string>("algorithm", "bvh", make_vector("bvh", "sbvh"), message_context);
-    const double time = params.get_optional<double>("time", 0.5);
     const bool save_memory = params.get_optional<bool>("save_temporary_memory", false);
+    const bool wide_bvh = params.get_optional<bool>("wide_bvh", true);
 
     // Start stopwatch.
     Stopwatch<DefaultWallclockTimer> stopwatch;
     stopwatch.start();
 
-    // Build the tree.
+    // Try to load the tree from the cache.
     Statistics statistics;
-    if (algorithm == "bvh")
-        build_bvh(params, time, save_memory, statistics);
-    else build_sbvh(params, time, save_memory, statistics);
-    statistics.insert_time("total build time", stopwatch.measure().get_seconds());
-    statistics.insert_size("nodes alignment", alignment(&m_nodes[0]));
+    const TriangleTreeCache cache(*this);
+    if (use_cache && cache.is_enabled() && cache.load(*this))
+    {
+        RENDERER_LOG_INFO(
+            "loaded triangle tree #" FMT_UNIQUE_ID " from cache file \"%s\".",
+            m_arguments.m_triangle_tree_uid,
+            cache.get_path().c_str());
+        statistics.insert_time("total load time", stopwatch.measure().get_seconds());
+        statistics.insert("cache file", cache.get_path());
+    }
+    else
+    {
+        // Build the tree.
+        if (algorithm == "bvh")
+            build_bvh(params, time, save_memory, statistics);
+        else build_sbvh(params, time, save_memory, statistics);
+        statistics.insert_time("total build time", stopwatch.measure().get_seconds());
+        statistics.insert_size("nodes alignment", alignment(&m_nodes[0]));
 
 #ifdef RENDERER_TRIANGLE_TREE_REORDER_NODES
-    // Optimize the tree layout in memory.
-    TreeOptimizer<NodeVectorType> tree_optimizer(m_nodes);
-    tree_optimizer.optimize_node_layout(TriangleTreeSubtreeDepth);
-    assert(m_nodes.size() == m_nodes.capacity());
+        // Optimize the tree layout in memory.
+        TreeOptimizer<NodeVectorType> tree_optimizer(m_nodes);
+        tree_optimizer.optimize_node_layout(TriangleTreeSubtreeDepth);
+        assert(m_nodes.size() == m_nodes.capacity());
 #endif
 
+        // Collapse static trees into a wide BVH.
+        if (wide_bvh && m_moving_triangle_count == 0)
+            build_wide_bvh(statistics);
+
+        // Store the tree into the cache.
+        if (use_cache && cache.is_enabled())
+            cache.save(*this);
+    }
+
+    // Remember the SAH cost of static trees to tell how much refitting degrades them.
+    if (m_moving_triangle_count == 0)
+    {
+        m_build_sah_cost = compute_sah_cost();
+        statistics.insert("sah cost", m_build_sah_cost);
+    }
+
     // Print triangle tree statistics.
     RENDERER_LOG_DEBUG("%s",
         StatisticsVector::make(
@@ -432,6 +533,29 @@ TriangleTree::TriangleTree(const Arguments& arguments)
             statistics).to_string().c_str());
 }
 
+void TriangleTree::build_time_interval_trees(const size_t time_interval_count)
+{
+    RENDERER_LOG_INFO(
+        "building triangle tree #" FMT_UNIQUE_ID " as %s %s...",
+        m_arguments.m_triangle_tree_uid,
+        pretty_uint(time_interval_count).c_str(),
+        plural(time_interval_count, "time interval subtree").c_str());
+
+    for (size_t i = 0; i < time_interval_count; ++i)
+    {
+        const double time_begin = static_cast<double>(i) / time_interval_count;
+        const double time_end = static_cast<double>(i + 1) / time_interval_count;
+
+        m_time_interval_trees.emplace_back(
+            new TriangleTree(m_arguments, time_begin, time_end));
+
+        // Subtrees hold the same triangles, except for those degenerate at the build time.
+        const TriangleTree& tree = *m_time_interval_trees.back();
+        m_static_triangle_count = std::max(m_static_triangle_count, tree.m_static_triangle_count);
+        m_moving_triangle_count = std::max(m_moving_triangle_count, tree.m_moving_triangle_count);
+    }
+}
+
 TriangleTree::~TriangleTree()
 {
     RENDERER_LOG_INFO(
@@ -443,6 +567,9 @@ TriangleTree::~TriangleTree()
 
 void TriangleTree::update_non_geometry(const bool enable_intersection_filters)
 {
+    for (size_t i = 0; i < m_time_interval_trees.size(); ++i)
+        m_time_interval_trees[i]->update_non_geometry(enable_intersection_filters);
+
     if (enable_intersection_filters &&
         m_arguments.m_assembly.get_parameters().get_optional<bool>("enable_intersection_filters", true))
         update_intersection_filters();
@@ -451,12 +578,18 @@ void TriangleTree::update_non_geometry(const bool enable_intersection_filters)
 
 size_t TriangleTree::get_memory_size() const
 {
-    return
+    size_t size =
           TreeType::get_memory_size()
         - sizeof(*static_cast<const TreeType*>(this))
         + sizeof(*this)
         + m_triangle_keys.capacity() * sizeof(TriangleKey)
-        + m_leaf_data.capacity() * sizeof(std::uint8_t);
+        + m_leaf_data.capacity() * sizeof(std::uint8_t)
+        + m_wide_nodes.capacity() * sizeof(WideNodeType);
+
+    for (size_t i = 0; i < m_time_interval_trees.size(); ++i)
+        size += m_time_interval_trees[i]->get_memory_size();
+
+    return size;
 }
 
 namespace
@@ -547,16 +680,18 @@ void TriangleTree::build_bvh(
         interior_node_traversal_cost,
         triangle_intersection_cost);
 
-    // Build the tree.
-    typedef bvh::Builder<TriangleTree, Partitioner> Builder;
+    // Build the tree, distributing large subtrees over the threads of the job queue.
+    typedef bvh::ParallelBuilder<TriangleTree, Partitioner> Builder;
     Builder builder;
     builder.build<DefaultWallclockTimer>(
         *this,
         partitioner,
         triangle_keys.size(),
-        max_leaf_size);
+        max_leaf_size,
+        m_arguments.m_job_queue);
     statistics.merge(
         bvh::TreeStatistics<TriangleTree>(*this, AABB3d(m_arguments.m_bbox)));
+    statistics.insert("parallel subtrees", builder.get_subtree_count());
 
     stopwatch.start();
 
@@ -1246,6 +1381,299 @@ namespace
     }
 }
 
+void TriangleTree::build_wide_bvh(Statistics& statistics)
+{
+    typedef bvh::Collapser<TriangleTree, WideNodeVector> Collapser;
+    Collapser collapser;
+    collapser.collapse<DefaultWallclockTimer>(*this, m_wide_nodes);
+    m_use_wide_bvh = true;
+
+    statistics.insert("wide nodes", m_wide_nodes.size());
+    statistics.insert_size("wide nodes size", m_wide_nodes.size() * sizeof(WideNodeType));
+    statistics.insert_time("collapse time", collapser.get_collapse_time());
+}
+
+namespace
+{
+    // Order triangle keys by object instance and triangle, ignoring primitive attributes.
+    class TriangleKeyOrder
+    {
+      public:
+        explicit TriangleKeyOrder(const std::vector<TriangleKey>& keys)
+          : m_keys(keys)
+        {
+        }
+
+        bool operator()(const size_t lhs, const size_t rhs) const
+        {
+            return less(m_keys[lhs], m_keys[rhs]);
+        }
+
+        static bool less(const TriangleKey& lhs, const TriangleKey& rhs)
+        {
+            return
+                lhs.get_object_instance_index() < rhs.get_object_instance_index() ||
+                (lhs.get_object_instance_index() == rhs.get_object_instance_index() &&
+                 lhs.get_triangle_index() < rhs.get_triangle_index());
+        }
+
+      private:
+        const std::vector<TriangleKey>& m_keys;
+    };
+
+    bool same_triangle(const TriangleKey& lhs, const TriangleKey& rhs)
+    {
+        return
+            lhs.get_object_instance_index() == rhs.get_object_instance_index() &&
+            lhs.get_triangle_index() == rhs.get_triangle_index();
+    }
+
+    std::vector<size_t> sort_triangle_keys(const std::vector<TriangleKey>& keys)
+    {
+        std::vector<size_t> order(keys.size());
+
+        for (size_t i = 0, e = keys.size(); i < e; ++i)
+            order[i] = i;
+
+        std::sort(order.begin(), order.end(), TriangleKeyOrder(keys));
+
+        return order;
+    }
+
+    // Map the triangle keys stored in a tree to the indices of the same triangles in a
+    // set of collected triangles. A triangle may be referenced by several leaves of the
+    // tree (spatial splits), but each collected triangle must be referenced at least once.
+    bool match_triangle_keys(
+        const std::vector<TriangleKey>&     tree_keys,
+        const std::vector<TriangleKey>&     collected_keys,
+        std::vector<size_t>&                triangle_indices)
+    {
+        const std::vector<size_t> tree_order = sort_triangle_keys(tree_keys);
+        const std::vector<size_t> collected_order = sort_triangle_keys(collected_keys);
+
+        triangle_indices.resize(tree_keys.size());
+
+        size_t next_collected = 0;
+
+        for (size_t i = 0, e = tree_order.size(); i < e; ++i)
+        {
+            const TriangleKey& key = tree_keys[tree_order[i]];
+
+            if (i > 0 && same_triangle(key, tree_keys[tree_order[i - 1]]))
+            {
+                triangle_indices[tree_order[i]] = triangle_indices[tree_order[i - 1]];
+                continue;
+            }
+
+            if (next_collected == collected_order.size() ||
+                !same_triangle(key, collected_keys[collected_order[next_collected]]))
+                return false;
+
+            triangle_indices[tree_order[i]] = collected_order[next_collected++];
+        }
+
+        return next_collected == collected_order.size();
+    }
+
+    // Compute the bounding box of the triangles of a leaf from their vertices.
+    class TriangleLeafBBoxFunc
+    {
+      public:
+        TriangleLeafBBoxFunc(
+            const std::vector<size_t>&              triangle_indices,
+            const std::vector<TriangleVertexInfo>&  triangle_vertex_infos,
+            const std::vector<GVector3>&            triangle_vertices)
+          : m_triangle_indices(triangle_indices)
+          , m_triangle_vertex_infos(triangle_vertex_infos)
+          , m_triangle_vertices(triangle_vertices)
+        {
+        }
+
+        AABB3d operator()(const TriangleTree::NodeType& leaf) const
+        {
+            const size_t item_begin = leaf.get_item_index();
+            const size_t item_count = leaf.get_item_count();
+
+            GAABB3 bbox;
+            bbox.invalidate();
+
+            for (size_t i = 0; i < item_count; ++i)
+            {
+                const size_t triangle_index = m_triangle_indices[item_begin + i];
+                const TriangleVertexInfo& vertex_info = m_triangle_vertex_infos[triangle_index];
+
+                bbox.insert(m_triangle_vertices[vertex_info.m_vertex_index + 0]);
+                bbox.insert(m_triangle_vertices[vertex_info.m_vertex_index + 1]);
+                bbox.insert(m_triangle_vertices[vertex_info.m_vertex_index + 2]);
+            }
+
+            return AABB3d(bbox);
+        }
+
+      private:
+        const std::vector<size_t>&              m_triangle_indices;
+        const std::vector<TriangleVertexInfo>&  m_triangle_vertex_infos;
+        const std::vector<GVector3>&            m_triangle_vertices;
+    };
+}
+
+std::uint64_t TriangleTree::hash_build_parameters(const Assembly& assembly)
+{
+    const ParamArray& params = assembly.get_parameters().child("acceleration_structure");
+
+    const std::string algorithm = params.get_optional<std::string>("algorithm", "bvh");
+
+    const double values[] =
+    {
+        params.get_optional<bool>("wide_bvh", true) ? 1.0 : 0.0,
+        params.get_optional<double>("time", 0.5),
+        static_cast<double>(params.get_optional<size_t>("max_time_intervals", TriangleTreeDefaultMaxTimeIntervals)),
+        static_cast<double>(params.get_optional<size_t>("max_leaf_size", TriangleTreeDefaultMaxLeafSize)),
+        static_cast<double>(params.get_optional<size_t>("bin_count", TriangleTreeDefaultBinCount)),
+        static_cast<double>(params.get_optional<GScalar>("interior_node_traversal_cost", TriangleTreeDefaultInteriorNodeTraversalCost)),
+        static_cast<double>(params.get_optional<GScalar>("triangle_intersection_cost", TriangleTreeDefaultTriangleIntersectionCost))
+    };
+
+    return
+        siphash24(
+            siphash24(algorithm.c_str(), algorithm.size()),
+            siphash24(values));
+}
+
+bool TriangleTree::refit(const GAABB3& bbox)
+{
+    // Motion bounding boxes are not refit.
+    if (!m_time_interval_trees.empty() || m_moving_triangle_count > 0)
+        return false;
+
+    // Retrieve refitting parameters.
+    const ParamArray& params = m_arguments.m_assembly.get_parameters().child("acceleration_structure");
+    if (!params.get_optional<bool>("refit", true))
+        return false;
+    const double time = params.get_optional<double>("time", 0.5);
+    const bool save_memory = params.get_optional<bool>("save_temporary_memory", false);
+    const double max_sah_cost_growth = params.get_optional<double>("max_refit_sah_cost_growth", TriangleTreeDefaultMaxRefitSAHCostGrowth);
+
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+
+    // Collect the triangles of the assembly with their current vertices.
+    RENDERER_LOG_INFO(
+        "refitting triangle tree #" FMT_UNIQUE_ID " for assembly \"%s\"...",
+        m_arguments.m_triangle_tree_uid,
+        m_arguments.m_assembly.get_path().c_str());
+    stopwatch.start();
+    const Arguments arguments(
+        m_arguments.m_scene,
+        m_arguments.m_triangle_tree_uid,
+        bbox,
+        m_arguments.m_assembly,
+        m_arguments.m_job_queue);
+    std::vector<TriangleKey> triangle_keys;
+    std::vector<TriangleVertexInfo> triangle_vertex_infos;
+    std::vector<GVector3> triangle_vertices;
+    collect_triangles<GAABB3>(
+        arguments,
+        time,
+        save_memory,
+        &triangle_keys,
+        &triangle_vertex_infos,
+        &triangle_vertices,
+        nullptr);
+    const double collection_time = stopwatch.measure().get_seconds();
+
+    // The topology of the tree is only kept if it references the same static triangles.
+    std::vector<size_t> triangle_indices;
+    if (count_static_triangles(triangle_vertex_infos) != triangle_vertex_infos.size() ||
+        !match_triangle_keys(m_triangle_keys, triangle_keys, triangle_indices))
+    {
+        RENDERER_LOG_INFO(
+            "triangles of triangle tree #" FMT_UNIQUE_ID " have changed, rebuilding it.",
+            m_arguments.m_triangle_tree_uid);
+        return false;
+    }
+
+    // Refit the tree, distributing large subtrees over the threads of the job queue.
+    typedef bvh::Refitter<TriangleTree> Refitter;
+    Refitter refitter;
+    refitter.refit<DefaultWallclockTimer>(
+        *this,
+        TriangleLeafBBoxFunc(triangle_indices, triangle_vertex_infos, triangle_vertices),
+        m_arguments.m_job_queue);
+
+    // Rebuild the tree instead if refitting degraded it too much.
+    const double sah_cost = compute_sah_cost();
+    if (sah_cost > max_sah_cost_growth * m_build_sah_cost)
+    {
+        RENDERER_LOG_INFO(
+            "sah cost of refit triangle tree #" FMT_UNIQUE_ID " grew from %.2f to %.2f, rebuilding it.",
+            m_arguments.m_triangle_tree_uid,
+            m_build_sah_cost,
+            sah_cost);
+        return false;
+    }
+
+    stopwatch.start();
+
+    // Store triangles with their current vertices into the tree.
+    Statistics statistics;
+    m_triangle_keys.clear();
+    m_leaf_data.clear();
+    store_triangles(
+        triangle_indices,
+        triangle_vertex_infos,
+        triangle_vertices,
+        triangle_keys,
+        statistics);
+
+    // Collapse the refit tree into a new wide BVH.
+    if (m_use_wide_bvh)
+        build_wide_bvh(statistics);
+
+    const double store_time = stopwatch.measure().get_seconds();
+
+    m_arguments.m_bbox = bbox;
+    m_static_triangle_count = triangle_vertex_infos.size();
+
+    statistics.insert("sah cost", sah_cost);
+    statistics.insert("parallel subtrees", refitter.get_subtree_count());
+    statistics.insert_time("collection time", collection_time);
+    statistics.insert_time("refit time", refitter.get_refit_time());
+    statistics.insert_time("store time", store_time);
+
+    // Print triangle tree statistics.
+    RENDERER_LOG_DEBUG("%s",
+        StatisticsVector::make(
+            "triangle tree #" + to_string(m_arguments.m_triangle_tree_uid) + " refit statistics",
+            statistics).to_string().c_str());
+
+    return true;
+}
+
+double TriangleTree::compute_sah_cost() const
+{
+    const ParamArray& params = m_arguments.m_assembly.get_parameters().child("acceleration_structure");
+    const GScalar interior_node_traversal_cost = params.get_optional<GScalar>("interior_node_traversal_cost", TriangleTreeDefaultInteriorNodeTraversalCost);
+    const GScalar triangle_intersection_cost = params.get_optional<GScalar>("triangle_intersection_cost", TriangleTreeDefaultTriangleIntersectionCost);
+
+    const NodeType& root = m_nodes[0];
+
+    AABB3d root_bbox;
+    root_bbox.invalidate();
+
+    if (root.is_interior())
+    {
+        root_bbox.insert(root.get_left_bbox());
+        root_bbox.insert(root.get_right_bbox());
+    }
+
+    return
+        bvh::Refitter<TriangleTree>::compute_sah_cost(
+            *this,
+            root_bbox,
+            static_cast<double>(interior_node_traversal_cost),
+            static_cast<double>(triangle_intersection_cost));
+}
+
 void TriangleTree::update_intersection_filters()
 {
     // Collect object instances.
@@ -1499,6 +1927,115 @@ void TriangleLeafVisitor::read_hit_triangle_data() const
 }
 
 
+//
+// TriangleLeafPacketVisitor class implementation.
+//
+
+void TriangleLeafPacketVisitor::visit(
+    const TriangleTree::NodeType&           node,
+    const Ray3d*                            rays,
+    const RayInfo3d*                        ray_infos,
+    const size_t*                           ray_indices,
+    const size_t                            ray_count,
+    double*                                 distances
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , bvh::TraversalStatistics&             stats
+#endif
+    )
+{
+    // Retrieve the pointer to the data of this leaf.
+    const std::uint8_t* user_data = &node.get_user_data<std::uint8_t>();
+    const std::uint32_t leaf_data_index = *reinterpret_cast<const std::uint32_t*>(user_data);
+    const std::uint8_t* leaf_data =
+        leaf_data_index == ~std::uint32_t(0)
+            ? user_data + sizeof(std::uint32_t)         // triangles are stored in the leaf node
+            : &m_tree.m_leaf_data[leaf_data_index];     // triangles are stored in the tree
+    MemoryReader reader(leaf_data);
+
+    // Sequentially intersect all triangles of the leaf with all rays.
+    for (size_t triangle_index = node.get_item_index(),
+                triangle_count = node.get_item_count();
+                triangle_count--;
+                triangle_index++)
+    {
+        FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(ray_count));
+
+        // Retrieve the triangle's visibility flags.
+        const std::uint32_t vis_flags = reader.read<std::uint32_t>();
+
+        // Retrieve the number of motion segments for this triangle.
+        const std::uint32_t motion_segment_count = reader.read<std::uint32_t>();
+
+        // Packets are only traced through trees without moving triangles.
+        assert(motion_segment_count == 0);
+
+        // Read the triangle, converting it to the right format if necessary.
+        const GTriangleType& triangle = reader.read<GTriangleType>();
+        const TriangleReader triangle_reader(triangle);
+
+        for (size_t i = 0; i < ray_count; ++i)
+        {
+            const size_t ray_index = ray_indices[i];
+            ShadingPoint& shading_point = m_shading_points[ray_index];
+
+            // Check visibility flags.
+            if (!(vis_flags & shading_point.m_ray.m_flags))
+                continue;
+
+            // Intersect the triangle.
+            double t, u, v;
+            if (triangle_reader.m_triangle.intersect(shading_point.m_ray, t, u, v))
+            {
+                // Optionally filter intersections.
+                if (m_has_intersection_filters)
+                {
+                    const TriangleKey& triangle_key = m_tree.m_triangle_keys[triangle_index];
+                    const IntersectionFilter* filter =
+                        m_tree.m_intersection_filters[triangle_key.get_object_instance_index()];
+                    if (filter && !filter->accept(triangle_key, u, v))
+                        continue;
+                }
+
+                m_hit_triangles[ray_index] = &triangle;
+                m_hit_triangle_indices[ray_index] = triangle_index;
+                shading_point.m_ray.m_tmax = t;
+                shading_point.m_bary[0] = static_cast<float>(u);
+                shading_point.m_bary[1] = static_cast<float>(v);
+            }
+        }
+    }
+
+    // Continue traversal.
+    for (size_t i = 0; i < ray_count; ++i)
+        distances[ray_indices[i]] = m_shading_points[ray_indices[i]].m_ray.m_tmax;
+}
+
+void TriangleLeafPacketVisitor::read_hit_triangle_data(const size_t ray_count) const
+{
+    assert(ray_count <= RayPacketSize);
+
+    for (size_t i = 0; i < ray_count; ++i)
+    {
+        if (m_hit_triangles[i])
+        {
+            ShadingPoint& shading_point = m_shading_points[i];
+
+            // Record a hit.
+            shading_point.m_primitive_type = ShadingPoint::PrimitiveTriangle;
+
+            // Copy the triangle key.
+            const TriangleKey& triangle_key = m_tree.m_triangle_keys[m_hit_triangle_indices[i]];
+            shading_point.m_object_instance_index = triangle_key.get_object_instance_index();
+            shading_point.m_primitive_index = triangle_key.get_triangle_index();
+
+            // Compute and store the support plane of the hit triangle.
+            const TriangleReader reader(*m_hit_triangles[i]);
+            shading_point.m_triangle_support_plane.initialize(reader.m_triangle);
+        }
+    }
+}
+
+
 //
 // TriangleLeafProbeVisitor class implementation.
 //
@@ -1523,7 +2060,10 @@ bool TriangleLeafProbeVisitor::visit(
     MemoryReader reader(leaf_data);
 
     // Sequentially intersect triangles until a hit is found.
-    for (size_t triangle_count = node.get_item_count(); triangle_count--; )
+    for (size_t triangle_index = node.get_item_index(),
+                triangle_count = node.get_item_count();
+                triangle_count--;
+                triangle_index++)
     {
         FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(1));
 
@@ -1548,7 +2088,9 @@ bool TriangleLeafProbeVisitor::visit(
             const TriangleReader triangle_reader(triangle);
 
             // Intersect the triangle.
-            if (triangle_reader.m_triangle.intersect(ray))
+            if (m_any_hit_context == nullptr
+                    ? triangle_reader.m_triangle.intersect(ray)
+                    : !accept_hit(triangle_index, triangle_reader.m_triangle, ray))
             {
                 m_hit = true;
                 return false;
@@ -1586,7 +2128,9 @@ bool TriangleLeafProbeVisitor::visit(
             const TriangleReader triangle_reader(triangle);
 
             // Intersect the triangle.
-            if (triangle_reader.m_triangle.intersect(ray))
+            if (m_any_hit_context == nullptr
+                    ? triangle_reader.m_triangle.intersect(ray)
+                    : !accept_hit(triangle_index, triangle_reader.m_triangle, ray))
             {
                 m_hit = true;
                 return false;
@@ -1602,4 +2146,27 @@ bool TriangleLeafProbeVisitor::visit(
     return true;
 }
 
+bool TriangleLeafProbeVisitor::accept_hit(
+    const size_t                            triangle_index,
+    const TriangleType&                     triangle,
+    const Ray3d&                            ray) const
+{
+    double t, u, v;
+    if (!triangle.intersect(ray, t, u, v))
+        return true;
+
+    const TriangleKey& triangle_key = m_tree.m_triangle_keys[triangle_index];
+
+    // Skip intersections rejected by the alpha masks, they are fully transparent.
+    if (m_has_intersection_filters)
+    {
+        const IntersectionFilter* filter =
+            m_tree.m_intersection_filters[triangle_key.get_object_instance_index()];
+        if (filter && !filter->accept(triangle_key, u, v))
+            return true;
+    }
+
+    return m_any_hit_context->on_triangle_hit(triangle_key, triangle, t, u, v);
+}
+
 }   // namespace renderer
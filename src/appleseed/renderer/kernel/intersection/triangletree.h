@@ -42,12 +42,14 @@
 #include "foundation/math/aabb.h"
 #include "foundation/math/bvh.h"
 #include "foundation/math/ray.h"
+#include "foundation/math/scalar.h"
 #include "foundation/utility/alignedvector.h"
 #include "foundation/utility/lazy.h"
 #include "foundation/utility/poolallocator.h"
 #include "foundation/utility/uid.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <map>
@@ -55,7 +57,9 @@
 #include <vector>
 
 // Forward declarations.
+namespace foundation    { class JobQueue; }
 namespace foundation    { class Statistics; }
+namespace renderer      { class AnyHitContext; }
 namespace renderer      { class Assembly; }
 namespace renderer      { class IntersectionFilter; }
 namespace renderer      { class ParamArray; }
@@ -71,6 +75,11 @@ typedef std::map<std::uint64_t, IntersectionFilter*> IntersectionFilterRepositor
 //
 // Triangle tree.
 //
+// When the triangles of the tree move over more than one motion segment, the shutter
+// interval is split into equal time intervals and an independent subtree is built for
+// each of them, using the bounding boxes of the triangles in the middle of the interval.
+// Rays are then traced against the subtree of the interval they belong to.
+//
 
 class TriangleTree
   : public foundation::bvh::Tree<
@@ -80,20 +89,26 @@ class TriangleTree
            >
 {
   public:
+    // Wide BVH collapsed from the binary tree, used to intersect static trees.
+    typedef foundation::bvh::WideNode<foundation::AABB3d, TriangleTreeWideNodeWidth> WideNodeType;
+    typedef foundation::AlignedVector<WideNodeType> WideNodeVector;
+
     // Construction arguments.
     struct Arguments
     {
         const Scene&                            m_scene;
         const foundation::UniqueID              m_triangle_tree_uid;
-        const GAABB3                            m_bbox;
+        GAABB3                                  m_bbox;         // updated when the tree is refit
         const Assembly&                         m_assembly;
+        foundation::JobQueue&                   m_job_queue;    // used to build the tree in parallel
 
         // Constructor.
         Arguments(
             const Scene&                        scene,
             const foundation::UniqueID          triangle_tree_uid,
             const GAABB3&                       bbox,
-            const Assembly&                     assembly);
+            const Assembly&                     assembly,
+            foundation::JobQueue&               job_queue);
     };
 
     // Constructor, builds the tree for a given assembly.
@@ -105,18 +120,41 @@ class TriangleTree
     // Update the non-geometry aspects of the tree.
     void update_non_geometry(const bool enable_intersection_filters);
 
+    // Refit the tree to the current vertices of its triangles, keeping its topology.
+    // Return false if the tree must be rebuilt instead, because the triangles of the
+    // assembly have changed, some of them are moving, or the refit tree is too slow.
+    bool refit(const GAABB3& bbox);
+
+    // Return a hash of the acceleration structure parameters of an assembly that affect
+    // how its triangle tree is built: trees built with different parameters are not refit.
+    static std::uint64_t hash_build_parameters(const Assembly& assembly);
+
     // Return the number of static and moving triangles.
     size_t get_static_triangle_count() const;
     size_t get_moving_triangle_count() const;
 
+    // Return the number of time intervals with their own subtree (0 if none).
+    size_t get_time_interval_count() const;
+
+    // Return the tree to intersect with rays at a given time in [0, 1].
+    const TriangleTree& get_time_interval_tree(const double time) const;
+
+    // Return whether the tree should be intersected using its wide BVH.
+    bool use_wide_bvh() const;
+
+    // Return the wide BVH of the tree.
+    const WideNodeVector& get_wide_nodes() const;
+
     // Return the size (in bytes) of this object in memory.
     size_t get_memory_size() const;
 
   private:
     friend class TriangleLeafVisitor;
+    friend class TriangleLeafPacketVisitor;
     friend class TriangleLeafProbeVisitor;
+    friend class TriangleTreeCache;
 
-    const Arguments                             m_arguments;
+    Arguments                                   m_arguments;
 
     size_t                                      m_static_triangle_count;
     size_t                                      m_moving_triangle_count;
@@ -124,9 +162,28 @@ class TriangleTree
     std::vector<TriangleKey>                    m_triangle_keys;
     std::vector<std::uint8_t>                   m_leaf_data;
 
+    double                                      m_build_sah_cost;   // SAH cost of static trees when built
+
+    bool                                        m_use_wide_bvh;
+    WideNodeVector                              m_wide_nodes;
+
     IntersectionFilterRepository                m_intersection_filters_repository;
     std::vector<const IntersectionFilter*>      m_intersection_filters;
 
+    std::vector<std::unique_ptr<TriangleTree>>  m_time_interval_trees;
+
+    // Constructor, builds the subtree of a given time interval.
+    TriangleTree(
+        const Arguments&                        arguments,
+        const double                            time_begin,
+        const double                            time_end);
+
+    void build(
+        const double                            time,
+        const bool                              use_cache);
+
+    void build_time_interval_trees(const size_t time_interval_count);
+
     void build_bvh(
         const ParamArray&                       params,
         const double                            time,
@@ -152,6 +209,10 @@ class TriangleTree
         const std::vector<TriangleKey>&         triangle_keys,
         foundation::Statistics&                 statistics);
 
+    void build_wide_bvh(foundation::Statistics& statistics);
+
+    double compute_sah_cost() const;
+
     void update_intersection_filters();
     void delete_intersection_filters();
 };
@@ -235,10 +296,53 @@ class TriangleLeafVisitor
 };
 
 
+//
+// Triangle leaf visitor for packets of rays, used during packet intersection of trees
+// without moving triangles. Each triangle of a leaf is read once and intersected with
+// all the rays of the packet that reach the leaf.
+//
+
+class TriangleLeafPacketVisitor
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor. 'shading_points' holds one shading point per ray of the packet.
+    TriangleLeafPacketVisitor(
+        const TriangleTree&                     tree,
+        ShadingPoint*                           shading_points);
+
+    // Visit a leaf.
+    void visit(
+        const TriangleTree::NodeType&           node,
+        const foundation::Ray3d*                rays,
+        const foundation::RayInfo3d*            ray_infos,
+        const size_t*                           ray_indices,
+        const size_t                            ray_count,
+        double*                                 distances
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics& stats
+#endif
+        );
+
+    // Read additional data about the triangles that were hit by the first 'ray_count' rays, if any.
+    void read_hit_triangle_data(const size_t ray_count) const;
+
+  private:
+    const TriangleTree&     m_tree;
+    const bool              m_has_intersection_filters;
+    ShadingPoint*           m_shading_points;
+    const GTriangleType*    m_hit_triangles[RayPacketSize];
+    size_t                  m_hit_triangle_indices[RayPacketSize];
+};
+
+
 //
 // Triangle leaf visitor for probe rays, only return boolean answers
 // (whether an intersection was found or not).
 //
+// When an any-hit context is provided, every intersection is reported to it and
+// a hit is only recorded once the context considers the ray blocked.
+//
 
 class TriangleLeafProbeVisitor
   : public ProbeVisitorBase
@@ -248,7 +352,8 @@ class TriangleLeafProbeVisitor
     TriangleLeafProbeVisitor(
         const TriangleTree&                     tree,
         const double                            ray_time,
-        const VisibilityFlags::Type             ray_flags);
+        const VisibilityFlags::Type             ray_flags,
+        AnyHitContext*                          any_hit_context = nullptr);
 
     // Visit a leaf.
     bool visit(
@@ -266,6 +371,13 @@ class TriangleLeafProbeVisitor
     const double                m_ray_time;
     const VisibilityFlags::Type m_ray_flags;
     const bool                  m_has_intersection_filters;
+    AnyHitContext*              m_any_hit_context;
+
+    // Report an intersection to the any-hit context. Return false if the ray is blocked.
+    bool accept_hit(
+        const size_t                            triangle_index,
+        const TriangleType&                     triangle,
+        const foundation::Ray3d&                ray) const;
 };
 
 
@@ -287,6 +399,30 @@ typedef foundation::bvh::Intersector<
     TriangleTreeStackSize
 > TriangleTreeProbeIntersector;
 
+typedef foundation::bvh::WideIntersector<
+    TriangleTree,
+    TriangleTree::WideNodeVector,
+    TriangleLeafVisitor,
+    foundation::Ray3d,
+    TriangleTreeStackSize
+> TriangleTreeWideIntersector;
+
+typedef foundation::bvh::WideIntersector<
+    TriangleTree,
+    TriangleTree::WideNodeVector,
+    TriangleLeafProbeVisitor,
+    foundation::Ray3d,
+    TriangleTreeStackSize
+> TriangleTreeWideProbeIntersector;
+
+typedef foundation::bvh::PacketIntersector<
+    TriangleTree,
+    TriangleLeafPacketVisitor,
+    foundation::Ray3d,
+    RayPacketSize,
+    TriangleTreeStackSize
+> TriangleTreePacketIntersector;
+
 
 //
 // TriangleTree class implementation.
@@ -302,6 +438,36 @@ inline size_t TriangleTree::get_moving_triangle_count() const
     return m_moving_triangle_count;
 }
 
+inline size_t TriangleTree::get_time_interval_count() const
+{
+    return m_time_interval_trees.size();
+}
+
+inline const TriangleTree& TriangleTree::get_time_interval_tree(const double time) const
+{
+    const size_t time_interval_count = m_time_interval_trees.size();
+
+    if (time_interval_count == 0)
+        return *this;
+
+    const size_t time_interval =
+        std::min(
+            foundation::truncate<size_t>(time * time_interval_count),
+            time_interval_count - 1);
+
+    return *m_time_interval_trees[time_interval];
+}
+
+inline bool TriangleTree::use_wide_bvh() const
+{
+    return m_use_wide_bvh;
+}
+
+inline const TriangleTree::WideNodeVector& TriangleTree::get_wide_nodes() const
+{
+    return m_wide_nodes;
+}
+
 
 //
 // TriangleLeafVisitor class implementation.
@@ -318,6 +484,22 @@ inline TriangleLeafVisitor::TriangleLeafVisitor(
 }
 
 
+//
+// TriangleLeafPacketVisitor class implementation.
+//
+
+inline TriangleLeafPacketVisitor::TriangleLeafPacketVisitor(
+    const TriangleTree&         tree,
+    ShadingPoint*               shading_points)
+  : m_tree(tree)
+  , m_has_intersection_filters(!tree.m_intersection_filters.empty())
+  , m_shading_points(shading_points)
+{
+    for (size_t i = 0; i < RayPacketSize; ++i)
+        m_hit_triangles[i] = nullptr;
+}
+
+
 //
 // TriangleLeafProbeVisitor class implementation.
 //
@@ -325,11 +507,13 @@ inline TriangleLeafVisitor::TriangleLeafVisitor(
 inline TriangleLeafProbeVisitor::TriangleLeafProbeVisitor(
     const TriangleTree&         tree,
     const double                ray_time,
-    const VisibilityFlags::Type ray_flags)
+    const VisibilityFlags::Type ray_flags,
+    AnyHitContext*              any_hit_context)
   : m_tree(tree)
   , m_ray_time(ray_time)
   , m_ray_flags(ray_flags)
   , m_has_intersection_filters(!tree.m_intersection_filters.empty())
+  , m_any_hit_context(any_hit_context)
 {
 }
 
@@ -0,0 +1,373 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "triangletreecache.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/intersection/intersectionsettings.h"
+#include "renderer/kernel/intersection/triangletree.h"
+#include "renderer/kernel/tessellation/statictessellation.h"
+#include "renderer/modeling/object/meshobject.h"
+#include "renderer/modeling/object/object.h"
+#include "renderer/modeling/object/triangle.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/objectinstance.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/transform.h"
+#include "foundation/utility/bufferedfile.h"
+#include "foundation/utility/containers/dictionary.h"
+#include "foundation/utility/foreach.h"
+#include "foundation/utility/siphash.h"
+#include "foundation/utility/string.h"
+
+// Boost headers.
+#include "boost/filesystem.hpp"
+#include "boost/system/error_code.hpp"
+
+// Standard headers.
+#include <cstddef>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+using namespace foundation;
+namespace bf = boost::filesystem;
+
+namespace renderer
+{
+
+//
+// TriangleTreeCache class implementation.
+//
+
+namespace
+{
+    // Bump this number whenever the layout of triangle trees or of their leaf data changes.
+    const std::uint32_t FormatVersion = 1;
+
+    const char Magic[8] = { 'A', 'S', 'T', 'R', 'I', 'T', 'R', 'E' };
+
+    // Alignment of the sections of a cache file, in bytes.
+    const size_t SectionAlignment = 64;
+
+    // Build options that affect the layout of the tree in memory.
+    const std::uint64_t LayoutFlags =
+#ifdef APPLESEED_USE_SSE
+        1 |
+#endif
+#ifdef RENDERER_TRIANGLE_TREE_REORDER_NODES
+        2 |
+#endif
+        0;
+
+    struct Header
+    {
+        char            m_magic[8];
+        std::uint32_t   m_version;
+        std::uint32_t   m_node_size;
+        std::uint32_t   m_wide_node_size;
+        std::uint32_t   m_triangle_key_size;
+        std::uint64_t   m_hash;
+        std::uint64_t   m_node_count;
+        std::uint64_t   m_node_bbox_count;
+        std::uint64_t   m_triangle_key_count;
+        std::uint64_t   m_leaf_data_size;
+        std::uint64_t   m_wide_node_count;
+        std::uint64_t   m_static_triangle_count;
+        std::uint64_t   m_moving_triangle_count;
+        std::uint32_t   m_use_wide_bvh;
+        std::uint32_t   m_padding;
+    };
+
+    std::uint64_t hash_string(const std::uint64_t hash, const char* s)
+    {
+        return siphash24(hash, siphash24(s, std::strlen(s)));
+    }
+
+    template <typename Vector>
+    std::uint64_t hash_vector(const std::uint64_t hash, const Vector& vec)
+    {
+        return
+            vec.empty()
+                ? siphash24(hash, 0)
+                : siphash24(hash, siphash24(&vec[0], vec.size() * sizeof(typename Vector::value_type)));
+    }
+
+    std::uint64_t hash_tessellation(std::uint64_t hash, const StaticTriangleTess& tess)
+    {
+        hash = hash_vector(hash, tess.m_vertices);
+        hash = hash_vector(hash, tess.m_primitives);
+        hash = hash_vector(hash, tess.m_compact_primitives);
+
+        const size_t motion_segment_count = tess.get_motion_segment_count();
+        hash = siphash24(hash, motion_segment_count);
+
+        if (motion_segment_count > 0)
+        {
+            const size_t vertex_count = tess.m_vertices.size();
+            std::vector<GVector3> poses(vertex_count);
+
+            for (size_t m = 0; m < motion_segment_count; ++m)
+            {
+                for (size_t v = 0; v < vertex_count; ++v)
+                    poses[v] = tess.get_vertex_pose(v, m);
+
+                hash = hash_vector(hash, poses);
+            }
+        }
+
+        return hash;
+    }
+
+    std::uint64_t compute_tree_hash(
+        const TriangleTree::Arguments&  arguments,
+        const ParamArray&               params)
+    {
+        // Format and build options.
+        std::uint64_t hash = siphash24(FormatVersion, LayoutFlags);
+        hash = siphash24(hash, sizeof(GScalar));
+        hash = siphash24(hash, TriangleTreeWideNodeWidth);
+
+        // Bounding box of the tree.
+        hash = siphash24(hash, siphash24(arguments.m_bbox));
+
+        // Construction parameters, except the ones that don't affect the tree.
+        for (const_each<StringDictionary> i = params.strings(); i; ++i)
+        {
+            if (std::strcmp(i.it().key(), "cache_directory") != 0)
+            {
+                hash = hash_string(hash, i.it().key());
+                hash = hash_string(hash, i.it().value());
+            }
+        }
+
+        // Geometry.
+        const ObjectInstanceContainer& object_instances = arguments.m_assembly.object_instances();
+        for (size_t i = 0, e = object_instances.size(); i < e; ++i)
+        {
+            const ObjectInstance* object_instance = object_instances.get_by_index(i);
+            assert(object_instance);
+
+            const Object& object = object_instance->get_object();
+            if (std::strcmp(object.get_model(), MeshObjectFactory().get_model()) != 0)
+                continue;
+
+            std::uint64_t values[3 + 16];
+            values[0] = hash;
+            values[1] = i;
+            values[2] = object_instance->get_vis_flags();
+            std::memcpy(&values[3], &object_instance->get_transform().get_local_to_parent()[0], 16 * 8);
+            hash = siphash24(&values, sizeof(values));
+
+            const MeshObject& mesh = static_cast<const MeshObject&>(object);
+            hash = hash_tessellation(hash, mesh.get_static_triangle_tess());
+        }
+
+        return hash;
+    }
+
+    std::string get_cache_directory(const TriangleTree::Arguments& arguments)
+    {
+        const std::string scene_cache_directory =
+            arguments.m_scene.get_parameters().child("acceleration_structure")
+                .get_optional<std::string>("cache_directory", "");
+
+        return
+            arguments.m_assembly.get_parameters().child("acceleration_structure")
+                .get_optional<std::string>("cache_directory", scene_cache_directory);
+    }
+
+    std::string get_cache_filename(const std::uint64_t hash)
+    {
+        std::stringstream sstr;
+        sstr << std::hex << std::setw(16) << std::setfill('0') << hash << ".bvh";
+        return sstr.str();
+    }
+
+    size_t get_padding(const BufferedFile& file)
+    {
+        const size_t position = static_cast<size_t>(file.tell());
+        return (SectionAlignment - position % SectionAlignment) % SectionAlignment;
+    }
+
+    template <typename Vector>
+    bool write_section(BufferedFile& file, const Vector& vec)
+    {
+        static const std::uint8_t Zeros[SectionAlignment] = { 0 };
+        const size_t padding = get_padding(file);
+        if (file.write(Zeros, padding) != padding)
+            return false;
+
+        const size_t size = vec.size() * sizeof(typename Vector::value_type);
+        return size == 0 || file.write(&vec[0], size) == size;
+    }
+
+    template <typename Vector>
+    bool read_section(BufferedFile& file, Vector& vec, const std::uint64_t count)
+    {
+        if (!file.seek(get_padding(file), BufferedFile::SeekFromCurrent))
+            return false;
+
+        vec.resize(static_cast<size_t>(count));
+
+        const size_t size = vec.size() * sizeof(typename Vector::value_type);
+        return size == 0 || file.read(&vec[0], size) == size;
+    }
+}
+
+TriangleTreeCache::TriangleTreeCache(const TriangleTree& tree)
+  : m_hash(0)
+{
+    const TriangleTree::Arguments& arguments = tree.m_arguments;
+
+    const std::string cache_directory = get_cache_directory(arguments);
+    if (cache_directory.empty())
+        return;
+
+    m_hash =
+        compute_tree_hash(
+            arguments,
+            arguments.m_assembly.get_parameters().child("acceleration_structure"));
+
+    m_path = (bf::path(cache_directory) / get_cache_filename(m_hash)).string();
+}
+
+bool TriangleTreeCache::load(TriangleTree& tree) const
+{
+    assert(is_enabled());
+
+    BufferedFile file;
+    if (!file.open(m_path.c_str(), BufferedFile::BinaryType, BufferedFile::ReadMode))
+        return false;
+
+    Header header;
+    if (file.read(header) != sizeof(Header) ||
+        std::memcmp(header.m_magic, Magic, sizeof(Magic)) != 0 ||
+        header.m_version != FormatVersion ||
+        header.m_node_size != sizeof(TriangleTree::NodeType) ||
+        header.m_wide_node_size != sizeof(TriangleTree::WideNodeType) ||
+        header.m_triangle_key_size != sizeof(TriangleKey) ||
+        header.m_hash != m_hash)
+    {
+        RENDERER_LOG_WARNING("ignoring invalid triangle tree cache file \"%s\".", m_path.c_str());
+        return false;
+    }
+
+    const bool success =
+        read_section(file, tree.m_nodes, header.m_node_count) &&
+        read_section(file, tree.m_node_bboxes, header.m_node_bbox_count) &&
+        read_section(file, tree.m_triangle_keys, header.m_triangle_key_count) &&
+        read_section(file, tree.m_leaf_data, header.m_leaf_data_size) &&
+        read_section(file, tree.m_wide_nodes, header.m_wide_node_count);
+
+    if (!success)
+    {
+        tree.m_nodes.clear();
+        tree.m_node_bboxes.clear();
+        tree.m_triangle_keys.clear();
+        tree.m_leaf_data.clear();
+        tree.m_wide_nodes.clear();
+
+        RENDERER_LOG_WARNING("ignoring truncated triangle tree cache file \"%s\".", m_path.c_str());
+        return false;
+    }
+
+    tree.m_static_triangle_count = static_cast<size_t>(header.m_static_triangle_count);
+    tree.m_moving_triangle_count = static_cast<size_t>(header.m_moving_triangle_count);
+    tree.m_use_wide_bvh = header.m_use_wide_bvh != 0;
+
+    return true;
+}
+
+bool TriangleTreeCache::save(const TriangleTree& tree) const
+{
+    assert(is_enabled());
+
+    // Make sure the cache directory exists.
+    const bf::path path(m_path);
+    boost::system::error_code ec;
+    bf::create_directories(path.parent_path(), ec);
+
+    // Write the tree to a temporary file, then move it in place, such that other
+    // renders never see partially written cache files.
+    const bf::path temp_path(m_path + "." + to_string(tree.m_arguments.m_triangle_tree_uid) + ".tmp");
+
+    Header header;
+    std::memcpy(header.m_magic, Magic, sizeof(Magic));
+    header.m_version = FormatVersion;
+    header.m_node_size = static_cast<std::uint32_t>(sizeof(TriangleTree::NodeType));
+    header.m_wide_node_size = static_cast<std::uint32_t>(sizeof(TriangleTree::WideNodeType));
+    header.m_triangle_key_size = static_cast<std::uint32_t>(sizeof(TriangleKey));
+    header.m_hash = m_hash;
+    header.m_node_count = tree.m_nodes.size();
+    header.m_node_bbox_count = tree.m_node_bboxes.size();
+    header.m_triangle_key_count = tree.m_triangle_keys.size();
+    header.m_leaf_data_size = tree.m_leaf_data.size();
+    header.m_wide_node_count = tree.m_wide_nodes.size();
+    header.m_static_triangle_count = tree.m_static_triangle_count;
+    header.m_moving_triangle_count = tree.m_moving_triangle_count;
+    header.m_use_wide_bvh = tree.m_use_wide_bvh ? 1 : 0;
+    header.m_padding = 0;
+
+    BufferedFile file;
+    bool success =
+        file.open(temp_path.string().c_str(), BufferedFile::BinaryType, BufferedFile::WriteMode) &&
+        file.write(header) == sizeof(Header) &&
+        write_section(file, tree.m_nodes) &&
+        write_section(file, tree.m_node_bboxes) &&
+        write_section(file, tree.m_triangle_keys) &&
+        write_section(file, tree.m_leaf_data) &&
+        write_section(file, tree.m_wide_nodes);
+
+    if (file.is_open() && !file.close())
+        success = false;
+
+    if (success)
+    {
+        bf::rename(temp_path, path, ec);
+        success = !ec;
+    }
+
+    if (!success)
+    {
+        bf::remove(temp_path, ec);
+        RENDERER_LOG_WARNING("failed to write triangle tree cache file \"%s\".", m_path.c_str());
+    }
+
+    return success;
+}
+
+}   // namespace renderer
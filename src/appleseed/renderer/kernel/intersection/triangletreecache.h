@@ -0,0 +1,103 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+
+// Standard headers.
+#include <cstdint>
+#include <string>
+
+// Forward declarations.
+namespace renderer  { class TriangleTree; }
+
+namespace renderer
+{
+
+//
+// On-disk cache of built triangle trees.
+//
+// Trees are stored in the directory given by the "cache_directory" parameter of the
+// "acceleration_structure" parameters of the assembly (or of the scene), in files
+// named after a hash of the tessellations referenced by the assembly, of the bounding
+// box of the tree and of the tree construction parameters. Sections of the files are
+// aligned such that they may be memory-mapped.
+//
+// Caching is disabled when no cache directory is specified.
+//
+
+class TriangleTreeCache
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    explicit TriangleTreeCache(const TriangleTree& tree);
+
+    // Return true if caching is enabled for this tree.
+    bool is_enabled() const;
+
+    // Return the content hash of the tree.
+    std::uint64_t get_hash() const;
+
+    // Return the path to the cache file of the tree.
+    const std::string& get_path() const;
+
+    // Load the tree from the cache. Return false if the cache file does not exist or is invalid.
+    bool load(TriangleTree& tree) const;
+
+    // Save the tree to the cache. Return true on success, false on error.
+    bool save(const TriangleTree& tree) const;
+
+  private:
+    std::uint64_t   m_hash;
+    std::string     m_path;
+};
+
+
+//
+// TriangleTreeCache class implementation.
+//
+
+inline bool TriangleTreeCache::is_enabled() const
+{
+    return !m_path.empty();
+}
+
+inline std::uint64_t TriangleTreeCache::get_hash() const
+{
+    return m_hash;
+}
+
+inline const std::string& TriangleTreeCache::get_path() const
+{
+    return m_path;
+}
+
+}   // namespace renderer
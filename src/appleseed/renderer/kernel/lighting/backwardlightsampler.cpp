@@ -42,12 +42,52 @@
 // Standard headers.
 #include <cassert>
 #include <string>
+#include <vector>
 
 using namespace foundation;
 
 namespace renderer
 {
 
+namespace
+{
+    bool same_lights(
+        const std::vector<NonPhysicalLightInfo>&    lhs,
+        const std::vector<NonPhysicalLightInfo>&    rhs)
+    {
+        if (lhs.size() != rhs.size())
+            return false;
+
+        for (size_t i = 0, e = lhs.size(); i < e; ++i)
+        {
+            if (lhs[i].m_light != rhs[i].m_light)
+                return false;
+        }
+
+        return true;
+    }
+
+    bool same_shapes(
+        const std::vector<EmittingShape>&           lhs,
+        const std::vector<EmittingShape>&           rhs)
+    {
+        if (lhs.size() != rhs.size())
+            return false;
+
+        for (size_t i = 0, e = lhs.size(); i < e; ++i)
+        {
+            if (lhs[i].get_assembly_instance() != rhs[i].get_assembly_instance() ||
+                lhs[i].get_object_instance_index() != rhs[i].get_object_instance_index() ||
+                lhs[i].get_primitive_index() != rhs[i].get_primitive_index() ||
+                lhs[i].get_material() != rhs[i].get_material())
+                return false;
+        }
+
+        return true;
+    }
+}
+
+
 //
 // BackwardLightSampler class implementation.
 //
@@ -60,7 +100,7 @@ Dictionary BackwardLightSampler::get_params_metadata()
         "algorithm",
         Dictionary()
             .insert("type", "enum")
-            .insert("values", "cdf|lighttree")
+            .insert("values", "cdf|aliastable|lighttree")
             .insert("default", "cdf")
             .insert("label", "Light Sampler")
             .insert("help", "Light sampling algoritm")
@@ -72,6 +112,11 @@ Dictionary BackwardLightSampler::get_params_metadata()
                         Dictionary()
                             .insert("label", "CDF")
                             .insert("help", "Cumulative Distribution Function"))
+                    .insert(
+                        "aliastable",
+                        Dictionary()
+                            .insert("label", "Alias Table")
+                            .insert("help", "Constant time sampling, without stratification across lights"))
                     .insert(
                         "lighttree",
                         Dictionary()
@@ -89,7 +134,12 @@ BackwardLightSampler::BackwardLightSampler(
   : LightSamplerBase(params)
 {
     // Read which sampling algorithm should be used.
-    m_use_light_tree = params.get_optional<std::string>("algorithm", "cdf") == "lighttree";
+    const std::string algorithm = params.get_optional<std::string>("algorithm", "cdf");
+    m_use_light_tree = algorithm == "lighttree";
+
+    // Emitting shapes may be drawn from an alias table instead of a CDF.
+    if (algorithm == "aliastable")
+        m_emitting_shapes_distribution = EmitterDistribution(true);
 
     RENDERER_LOG_INFO("collecting light emitters...");
 
@@ -116,7 +166,7 @@ BackwardLightSampler::BackwardLightSampler(
                 // todo: compute importance.
                 float importance = 1.0f;
                 importance *= light_info.m_light->get_uncached_importance_multiplier();
-                m_non_physical_lights_cdf.insert(light_index, importance);
+                m_non_physical_lights_distribution.insert(light_index, importance);
             }
         });
     m_non_physical_light_count = m_non_physical_lights.size();
@@ -148,8 +198,8 @@ BackwardLightSampler::BackwardLightSampler(
                 const float shape_importance = m_params.m_importance_sampling ? area : 1.0f;
                 const float shape_prob = shape_importance * importance_multiplier;
 
-                // Insert the light-emitting shape into the CDF.
-                m_emitting_shapes_cdf.insert(emitting_shape_index, shape_prob);
+                // Insert the light-emitting shape into the distribution.
+                m_emitting_shapes_distribution.insert(emitting_shape_index, shape_prob);
 
                 // Accept this shape.
                 return true;
@@ -160,8 +210,8 @@ BackwardLightSampler::BackwardLightSampler(
     build_emitting_shape_hash_table();
 
     // Prepare the non-physical lights CDF for sampling.
-    if (m_non_physical_lights_cdf.valid())
-        m_non_physical_lights_cdf.prepare();
+    if (m_non_physical_lights_distribution.valid())
+        m_non_physical_lights_distribution.prepare();
 
     if (m_use_light_tree)
     {
@@ -178,13 +228,13 @@ BackwardLightSampler::BackwardLightSampler(
     }
     else
     {
-        // Prepare the light-emitting shapes CDF for smapling.
-        if (m_emitting_shapes_cdf.valid())
-            m_emitting_shapes_cdf.prepare();
+        // Prepare the light-emitting shapes distribution for sampling.
+        if (m_emitting_shapes_distribution.valid())
+            m_emitting_shapes_distribution.prepare();
 
         // Store the shape probability densities into the emitting shapes.
         for (size_t i = 0, e = m_emitting_shapes.size(); i < e; ++i)
-            m_emitting_shapes[i].m_shape_prob = m_emitting_shapes_cdf[i].second;
+            m_emitting_shapes[i].m_shape_prob = m_emitting_shapes_distribution[i].second;
     }
 
     RENDERER_LOG_INFO(
@@ -197,6 +247,60 @@ BackwardLightSampler::BackwardLightSampler(
         plural(m_emitting_shapes.size(), "shape").c_str());
 }
 
+bool BackwardLightSampler::update(const Scene& scene)
+{
+    if (!m_use_light_tree || !m_light_tree->is_built())
+        return false;
+
+    // Collect the emitters again, keeping the current ones around.
+    NonPhysicalLightVector light_tree_lights;
+    NonPhysicalLightVector non_physical_lights;
+    collect_non_physical_lights(
+        scene.assembly_instances(),
+        TransformSequence(),
+        [&](const NonPhysicalLightInfo& light_info)
+        {
+            if ((light_info.m_light->get_flags() & Light::LightTreeCompatible) != 0)
+                light_tree_lights.push_back(light_info);
+            else non_physical_lights.push_back(light_info);
+        });
+
+    EmittingShapeVector emitting_shapes;
+    m_emitting_shapes.swap(emitting_shapes);
+    collect_emitting_shapes(
+        scene.assembly_instances(),
+        TransformSequence(),
+        [](
+            const Material* material,
+            const float     area,
+            const size_t    emitting_shape_index)
+        {
+            return material->get_uncached_edf() != nullptr;
+        });
+    m_emitting_shapes.swap(emitting_shapes);
+
+    // The light tree can only be refitted if the emitters are the same, in the same order.
+    if (!same_lights(light_tree_lights, m_light_tree_lights) ||
+        !same_lights(non_physical_lights, m_non_physical_lights) ||
+        !same_shapes(emitting_shapes, m_emitting_shapes))
+        return false;
+
+    // Emitting shapes remain associated with the same light tree nodes.
+    for (size_t i = 0, e = emitting_shapes.size(); i < e; ++i)
+        emitting_shapes[i].m_light_tree_node_index = m_emitting_shapes[i].m_light_tree_node_index;
+
+    m_light_tree_lights.swap(light_tree_lights);
+    m_non_physical_lights.swap(non_physical_lights);
+    m_emitting_shapes.swap(emitting_shapes);
+
+    // The hash table points to the emitting shapes.
+    build_emitting_shape_hash_table();
+
+    m_light_tree->refit();
+
+    return true;
+}
+
 void BackwardLightSampler::sample_lightset(
     const ShadingRay::Time&             time,
     const Vector3f&                     s,
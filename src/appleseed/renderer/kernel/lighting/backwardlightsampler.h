@@ -69,6 +69,11 @@ class BackwardLightSampler
         const Scene&                        scene,
         const ParamArray&                   params = ParamArray());
 
+    // Update the light tree after light emitters have moved, without rebuilding it.
+    // Return false if the set of emitters has changed or if emitters are not sampled
+    // using a light tree, in which case the light sampler must be recreated.
+    bool update(const Scene& scene);
+
     // Return true if the scene contains at least one non-physical light or emitting shape.
     bool has_lights() const;
 
@@ -112,7 +117,7 @@ class BackwardLightSampler
 inline bool BackwardLightSampler::has_lights() const
 {
     return
-        m_non_physical_lights_cdf.valid() ||
+        m_non_physical_lights_distribution.valid() ||
         !m_emitting_shapes.empty() ||
         !m_light_tree_lights.empty();
 }
@@ -72,7 +72,7 @@ ForwardLightSampler::ForwardLightSampler(const Scene& scene, const ParamArray& p
             // todo: compute importance.
             float importance = 1.0f;
             importance *= light_info.m_light->get_uncached_importance_multiplier();
-            m_non_physical_lights_cdf.insert(light_index, importance);
+            m_non_physical_lights_distribution.insert(light_index, importance);
         });
     m_non_physical_light_count = m_non_physical_lights.size();
 
@@ -95,7 +95,7 @@ ForwardLightSampler::ForwardLightSampler(const Scene& scene, const ParamArray& p
             const float shape_prob = shape_importance * importance_multiplier;
 
             // Insert the light-emitting shape into the CDF.
-            m_emitting_shapes_cdf.insert(emitting_shape_index, shape_prob);
+            m_emitting_shapes_distribution.insert(emitting_shape_index, shape_prob);
 
             // Accept this shape.
             return true;
@@ -105,14 +105,14 @@ ForwardLightSampler::ForwardLightSampler(const Scene& scene, const ParamArray& p
     build_emitting_shape_hash_table();
 
     // Prepare the CDFs for sampling.
-    if (m_non_physical_lights_cdf.valid())
-        m_non_physical_lights_cdf.prepare();
-    if (m_emitting_shapes_cdf.valid())
-        m_emitting_shapes_cdf.prepare();
+    if (m_non_physical_lights_distribution.valid())
+        m_non_physical_lights_distribution.prepare();
+    if (m_emitting_shapes_distribution.valid())
+        m_emitting_shapes_distribution.prepare();
 
     // Store the shape probability densities into the emitting shapes.
     for (size_t i = 0, e = m_emitting_shapes.size(); i < e; ++i)
-        m_emitting_shapes[i].set_shape_prob(m_emitting_shapes_cdf[i].second);
+        m_emitting_shapes[i].set_shape_prob(m_emitting_shapes_distribution[i].second);
 
    RENDERER_LOG_INFO(
         "found %s %s, %s emitting %s.",
@@ -127,12 +127,14 @@ void ForwardLightSampler::sample(
     const Vector3f&                     s,
     LightSample&                        light_sample) const
 {
-    assert(m_non_physical_lights_cdf.valid() || m_emitting_shapes_cdf.valid());
+    assert(m_non_physical_lights_distribution.valid() || m_emitting_shapes_distribution.valid());
 
-    if (m_non_physical_lights_cdf.valid())
+    if (m_non_physical_lights_distribution.valid())
     {
-        if (m_emitting_shapes_cdf.valid())
+        if (m_emitting_shapes_distribution.valid())
         {
+            // Emitters are always drawn from CDFs here: unlike alias tables, they
+            // only depend on the ordering of sample values, so remapping s[0] is safe.
             if (s[0] < 0.5f)
             {
                 sample_non_physical_lights(
@@ -177,9 +179,9 @@ void ForwardLightSampler::sample_non_physical_lights(
     const Vector3f&                     s,
     LightSample&                        light_sample) const
 {
-    assert(m_non_physical_lights_cdf.valid());
+    assert(m_non_physical_lights_distribution.valid());
 
-    const EmitterCDF::ItemWeightPair result = m_non_physical_lights_cdf.sample(s[0]);
+    const EmitterDistribution::ItemWeightPair result = m_non_physical_lights_distribution.sample(s[0]);
     const size_t light_index = result.first;
     const float light_prob = result.second;
 
@@ -89,7 +89,7 @@ class ForwardLightSampler
 
 inline bool ForwardLightSampler::has_lights() const
 {
-    return m_non_physical_lights_cdf.valid() || m_emitting_shapes_cdf.valid();
+    return m_non_physical_lights_distribution.valid() || m_emitting_shapes_distribution.valid();
 }
 
 }   // namespace renderer
@@ -195,11 +195,11 @@ void LightSamplerBase::collect_emitting_shapes(
             const Transformd global_transform = assembly_instance_transform * object_instance_transform;
 
             // Loop over the triangles of the mesh.
-            for (size_t triangle_index = 0, triangle_count = tess.m_primitives.size();
+            for (size_t triangle_index = 0, triangle_count = tess.get_primitive_count();
                 triangle_index < triangle_count; ++triangle_index)
             {
                 // Fetch the triangle.
-                const Triangle& triangle = tess.m_primitives[triangle_index];
+                const Triangle triangle = tess.get_primitive(triangle_index);
 
                 // Skip triangles without a material.
                 if (triangle.m_pa == Triangle::None)
@@ -259,9 +259,9 @@ void LightSamplerBase::collect_emitting_shapes(
                     triangle.m_n2 != Triangle::None)
                 {
                     // Retrieve object instance space vertex normals.
-                    const Vector3d n0_os = Vector3d(tess.m_vertex_normals[triangle.m_n0]);
-                    const Vector3d n1_os = Vector3d(tess.m_vertex_normals[triangle.m_n1]);
-                    const Vector3d n2_os = Vector3d(tess.m_vertex_normals[triangle.m_n2]);
+                    const Vector3d n0_os = Vector3d(tess.get_vertex_normal(triangle.m_n0));
+                    const Vector3d n1_os = Vector3d(tess.get_vertex_normal(triangle.m_n1));
+                    const Vector3d n2_os = Vector3d(tess.get_vertex_normal(triangle.m_n2));
 
                     // Transform vertex normals to world space.
                     n0 = normalize(global_transform.normal_to_parent(n0_os));
@@ -656,10 +656,10 @@ void LightSamplerBase::sample_emitting_shapes(
     const Vector3f&                     s,
     LightSample&                        light_sample) const
 {
-    assert(m_emitting_shapes_cdf.valid());
+    assert(m_emitting_shapes_distribution.valid());
 
     // Fetch the emitting shape.
-    const EmitterCDF::ItemWeightPair result = m_emitting_shapes_cdf.sample(s[0]);
+    const EmitterDistribution::ItemWeightPair result = m_emitting_shapes_distribution.sample(s[0]);
     const size_t emitter_index = result.first;
     const float emitter_prob = result.second;
     const EmittingShape& emitting_shape = m_emitting_shapes[emitter_index];
@@ -36,10 +36,13 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/aliastable.h"
 #include "foundation/math/cdf.h"
 
 // Standard headers.
+#include <cstddef>
 #include <functional>
+#include <utility>
 
 // Forward declarations.
 namespace foundation    { class Dictionary; }
@@ -51,6 +54,48 @@ namespace renderer      { class MaterialArray; }
 namespace renderer
 {
 
+//
+// A discrete distribution of emitters.
+//
+// Emitters are drawn from a CDF by default. An alias table can be used instead: it
+// draws emitters in constant time but does not preserve the stratification of the
+// sample value, and it needs a sample value with enough precision to select both a
+// bucket and an item inside that bucket, see foundation::AliasTable.
+//
+
+class EmitterDistribution
+{
+  public:
+    typedef std::pair<size_t, float> ItemWeightPair;
+
+    // Constructor.
+    explicit EmitterDistribution(const bool use_alias_table = false);
+
+    // Return true if emitters are drawn from an alias table.
+    bool uses_alias_table() const;
+
+    // Return true if the distribution has at least one item with a positive weight.
+    bool valid() const;
+
+    // Insert an item with a given non-negative weight.
+    void insert(const size_t item, const float weight);
+
+    // Access the i'th item.
+    const ItemWeightPair& operator[](const size_t i) const;
+
+    // Prepare the distribution for sampling.
+    void prepare();
+
+    // Sample the distribution. x is in [0,1).
+    const ItemWeightPair& sample(const float x) const;
+
+  private:
+    bool                                        m_use_alias_table;
+    foundation::CDF<size_t, float>              m_cdf;
+    foundation::AliasTable<size_t, float>       m_alias_table;
+};
+
+
 //
 // LightSamplerBase class implementation.
 //
@@ -82,7 +127,6 @@ class LightSamplerBase
 
     typedef std::vector<NonPhysicalLightInfo> NonPhysicalLightVector;
     typedef std::vector<EmittingShape> EmittingShapeVector;
-    typedef foundation::CDF<size_t, float> EmitterCDF;
 
     typedef std::function<void (const NonPhysicalLightInfo&)> LightHandlingFunction;
     typedef std::function<bool (const Material*, const float, const size_t)> ShapeHandlingFunction;
@@ -94,8 +138,8 @@ class LightSamplerBase
 
     size_t                                  m_non_physical_light_count;
 
-    EmitterCDF                              m_non_physical_lights_cdf;
-    EmitterCDF                              m_emitting_shapes_cdf;
+    EmitterDistribution                     m_non_physical_lights_distribution;
+    EmitterDistribution                     m_emitting_shapes_distribution;
 
     EmittingShapeKeyHasher                  m_shape_key_hasher;
     EmittingShapeHashTable                  m_emitting_shape_hash_table;
@@ -156,6 +200,50 @@ class LightSamplerBase
 };
 
 
+//
+// EmitterDistribution class implementation.
+//
+
+inline EmitterDistribution::EmitterDistribution(const bool use_alias_table)
+  : m_use_alias_table(use_alias_table)
+{
+}
+
+inline bool EmitterDistribution::uses_alias_table() const
+{
+    return m_use_alias_table;
+}
+
+inline bool EmitterDistribution::valid() const
+{
+    return m_use_alias_table ? m_alias_table.valid() : m_cdf.valid();
+}
+
+inline void EmitterDistribution::insert(const size_t item, const float weight)
+{
+    if (m_use_alias_table)
+        m_alias_table.insert(item, weight);
+    else m_cdf.insert(item, weight);
+}
+
+inline const EmitterDistribution::ItemWeightPair& EmitterDistribution::operator[](const size_t i) const
+{
+    return m_use_alias_table ? m_alias_table[i] : m_cdf[i];
+}
+
+inline void EmitterDistribution::prepare()
+{
+    if (m_use_alias_table)
+        m_alias_table.prepare();
+    else m_cdf.prepare();
+}
+
+inline const EmitterDistribution::ItemWeightPair& EmitterDistribution::sample(const float x) const
+{
+    return m_use_alias_table ? m_alias_table.sample(x) : m_cdf.sample(x);
+}
+
+
 //
 // LightSamplerBase class implementation.
 //
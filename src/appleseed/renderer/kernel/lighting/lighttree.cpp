@@ -44,19 +44,411 @@
 #include "foundation/math/permutation.h"
 #include "foundation/math/scalar.h"
 #include "foundation/math/vector.h"
+#include "foundation/platform/defaulttimers.h"
 #include "foundation/platform/timers.h"
+#include "foundation/utility/stopwatch.h"
+#include "foundation/utility/string.h"
 #include "foundation/utility/vpythonfile.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
 #include <limits>
+#include <vector>
 
 using namespace foundation;
 
 namespace renderer
 {
 
+namespace
+{
+    //
+    // A cone bounding the emission directions of a set of lights.
+    //
+    // Reference:
+    //
+    //   Importance Sampling of Many Lights with Adaptive Tree Splitting
+    //   Alejandro Conty Estevez, Christopher Kulla
+    //   http://www.aconty.com/pdf/many-lights-hpg2018.pdf
+    //
+
+    struct OrientationCone
+    {
+        Vector3f    m_axis;
+        float       m_theta_o;          // normals bound, in radians, negative for an empty cone
+
+        static OrientationCone empty()
+        {
+            OrientationCone cone;
+            cone.m_axis = Vector3f(0.0f, 0.0f, 1.0f);
+            cone.m_theta_o = -1.0f;
+            return cone;
+        }
+
+        static OrientationCone sphere()
+        {
+            OrientationCone cone;
+            cone.m_axis = Vector3f(0.0f, 0.0f, 1.0f);
+            cone.m_theta_o = Pi<float>();
+            return cone;
+        }
+
+        static OrientationCone direction(const Vector3f& axis)
+        {
+            OrientationCone cone;
+            cone.m_axis = axis;
+            cone.m_theta_o = 0.0f;
+            return cone;
+        }
+
+        bool is_empty() const
+        {
+            return m_theta_o < 0.0f;
+        }
+
+        // Enlarge this cone to also bound another cone.
+        void insert(const OrientationCone& rhs)
+        {
+            if (rhs.is_empty())
+                return;
+
+            if (is_empty())
+            {
+                *this = rhs;
+                return;
+            }
+
+            const float theta_d = std::acos(clamp(dot(m_axis, rhs.m_axis), -1.0f, 1.0f));
+
+            // One of the cones contains the other one.
+            if (std::min(theta_d + rhs.m_theta_o, Pi<float>()) <= m_theta_o)
+                return;
+            if (std::min(theta_d + m_theta_o, Pi<float>()) <= rhs.m_theta_o)
+            {
+                *this = rhs;
+                return;
+            }
+
+            const float theta_o = 0.5f * (m_theta_o + theta_d + rhs.m_theta_o);
+            if (theta_o >= Pi<float>())
+            {
+                *this = sphere();
+                return;
+            }
+
+            // Rotate the axis of this cone toward the axis of the other cone.
+            const Vector3f rotation_axis = cross(m_axis, rhs.m_axis);
+            const float rotation_axis_norm = norm(rotation_axis);
+            if (rotation_axis_norm == 0.0f)
+            {
+                *this = sphere();
+                return;
+            }
+
+            const Vector3f k = rotation_axis / rotation_axis_norm;
+            const float theta_r = theta_o - m_theta_o;
+            const float cos_theta_r = std::cos(theta_r);
+            const float sin_theta_r = std::sin(theta_r);
+            m_axis = normalize(m_axis * cos_theta_r + cross(k, m_axis) * sin_theta_r);
+            m_theta_o = theta_o;
+        }
+
+        // Return the orientation measure of the cone, assuming that lights emit
+        // over the whole hemisphere around each of their normals.
+        float measure() const
+        {
+            assert(!is_empty());
+
+            const float theta_e = HalfPi<float>();
+            const float theta_w = std::min(m_theta_o + theta_e, Pi<float>());
+            const float cos_theta_o = std::cos(m_theta_o);
+            const float sin_theta_o = std::sin(m_theta_o);
+
+            return
+                TwoPi<float>() * (1.0f - cos_theta_o) +
+                HalfPi<float>() * (
+                    2.0f * theta_w * sin_theta_o
+                    - std::cos(m_theta_o - 2.0f * theta_w)
+                    - 2.0f * m_theta_o * sin_theta_o
+                    + cos_theta_o);
+        }
+    };
+
+    //
+    // A light tree partitioner based on the Surface Area Orientation Heuristic
+    // (SAOH, see the reference above) evaluated over a fixed number of bins
+    // along the longest extent of the centroids of the items.
+    //
+    // Unlike the partitioners of foundation::bvh, this one doesn't need to sort
+    // the items beforehand: each level of the tree is built in linear time.
+    // Sets of items are always split until leaves hold a single item, small
+    // sets being simply split at their median.
+    //
+
+    class LightTreePartitioner
+      : public NonCopyable
+    {
+      public:
+        typedef AABB3f AABBType;
+
+        LightTreePartitioner(
+            const std::vector<AABB3f>&          bboxes,
+            const std::vector<OrientationCone>& cones,
+            const std::vector<float>&           importances)
+          : m_bboxes(bboxes)
+          , m_cones(cones)
+          , m_importances(importances)
+          , m_indices(bboxes.size())
+          , m_bin_indices(bboxes.size())
+        {
+            assert(m_cones.size() == m_bboxes.size());
+            assert(m_importances.size() == m_bboxes.size());
+
+            for (size_t i = 0, e = m_indices.size(); i < e; ++i)
+                m_indices[i] = i;
+        }
+
+        AABBType compute_bbox(
+            const size_t                        begin,
+            const size_t                        end) const
+        {
+            AABBType bbox;
+            bbox.invalidate();
+
+            for (size_t i = begin; i < end; ++i)
+                bbox.insert(m_bboxes[m_indices[i]]);
+
+            return bbox;
+        }
+
+        size_t partition(
+            const size_t                        begin,
+            const size_t                        end,
+            const AABBType&                     bbox)
+        {
+            assert(end - begin > 1);
+
+            // Compute the bounding box of the centroids.
+            AABB3f centroid_bbox;
+            centroid_bbox.invalidate();
+            for (size_t i = begin; i < end; ++i)
+                centroid_bbox.insert(m_bboxes[m_indices[i]].center());
+
+            // Items are split along the longest extent of their centroids.
+            const size_t d = max_index(centroid_bbox.extent());
+
+            // All centroids coincide: split the set of items in two halves.
+            if (centroid_bbox.extent()[d] <= 0.0f)
+                return (begin + end) / 2;
+
+            // Evaluating the heuristic is not worth it for small sets of items:
+            // split them at their median instead.
+            if (end - begin <= MaxMedianSplitSize)
+            {
+                const size_t pivot = (begin + end) / 2;
+                std::nth_element(
+                    &m_indices[0] + begin,
+                    &m_indices[0] + pivot,
+                    &m_indices[0] + end,
+                    [&](const size_t lhs, const size_t rhs)
+                    {
+                        return m_bboxes[lhs].center(d) < m_bboxes[rhs].center(d);
+                    });
+                return pivot;
+            }
+
+            // Accumulate bounding boxes, importances and mean emission directions in bins.
+            Bin bins[BinCount];
+            for (size_t i = begin; i < end; ++i)
+            {
+                const size_t index = m_indices[i];
+                const size_t bin_index = compute_bin(centroid_bbox, d, index);
+                m_bin_indices[i] = static_cast<std::uint8_t>(bin_index);
+
+                Bin& bin = bins[bin_index];
+                bin.m_bbox.insert(m_bboxes[index]);
+                bin.m_axis_sum += m_cones[index].m_axis;
+                bin.m_importance += m_importances[index];
+                ++bin.m_count;
+            }
+
+            // Bound the emission directions of each bin with a cone centered on the
+            // mean direction. This is cheaper than merging the cones of all items.
+            Vector3f bin_axes[BinCount];
+            float bin_min_cos[BinCount];
+            float bin_max_theta[BinCount];
+            for (size_t b = 0; b < BinCount; ++b)
+            {
+                const float n = norm(bins[b].m_axis_sum);
+                bin_axes[b] = n > 0.0f ? bins[b].m_axis_sum / n : Vector3f(0.0f, 0.0f, 1.0f);
+                bin_min_cos[b] = n > 0.0f ? 1.0f : -1.0f;
+                bin_max_theta[b] = 0.0f;
+            }
+            for (size_t i = begin; i < end; ++i)
+            {
+                const OrientationCone& cone = m_cones[m_indices[i]];
+                const size_t b = m_bin_indices[i];
+                const float cos_theta = dot(cone.m_axis, bin_axes[b]);
+
+                if (cone.m_theta_o == 0.0f)
+                    bin_min_cos[b] = std::min(bin_min_cos[b], cos_theta);
+                else
+                {
+                    bin_max_theta[b] =
+                        std::max(
+                            bin_max_theta[b],
+                            std::acos(clamp(cos_theta, -1.0f, 1.0f)) + cone.m_theta_o);
+                }
+            }
+            for (size_t b = 0; b < BinCount; ++b)
+            {
+                if (bins[b].m_count > 0)
+                {
+                    bins[b].m_cone.m_axis = bin_axes[b];
+                    bins[b].m_cone.m_theta_o =
+                        std::min(
+                            std::max(std::acos(clamp(bin_min_cos[b], -1.0f, 1.0f)), bin_max_theta[b]),
+                            Pi<float>());
+                }
+            }
+
+            // Right-to-left sweep to accumulate the costs of the right partitions.
+            // Costs are only evaluated where the right partition changes.
+            float right_costs[BinCount];
+            size_t right_counts[BinCount];
+            Bin right;
+            float right_cost = 0.0f;
+            for (size_t b = BinCount - 1; b > 0; --b)
+            {
+                if (bins[b].m_count > 0)
+                {
+                    right.insert(bins[b]);
+                    right_cost = right.cost();
+                }
+                right_costs[b] = right_cost;
+                right_counts[b] = right.m_count;
+            }
+
+            // Left-to-right sweep to find the best partition.
+            float best_cost = std::numeric_limits<float>::max();
+            size_t best_bin = 0;
+            Bin left;
+            for (size_t b = 1; b < BinCount; ++b)
+            {
+                // Splitting after an empty bin yields the same partition as the previous split.
+                if (bins[b - 1].m_count == 0)
+                    continue;
+
+                left.insert(bins[b - 1]);
+
+                if (right_counts[b] == 0)
+                    break;
+
+                const float cost = left.cost() + right_costs[b];
+                if (best_cost > cost)
+                {
+                    best_cost = cost;
+                    best_bin = b;
+                }
+            }
+
+            size_t* middle =
+                std::partition(
+                    &m_indices[0] + begin,
+                    &m_indices[0] + end,
+                    [&](const size_t index)
+                    {
+                        return compute_bin(centroid_bbox, d, index) < best_bin;
+                    });
+
+            const size_t pivot = middle - &m_indices[0];
+            assert(pivot > begin);
+            assert(pivot < end);
+
+            return pivot;
+        }
+
+        const std::vector<size_t>& get_item_ordering() const
+        {
+            return m_indices;
+        }
+
+      private:
+        enum { BinCount = 16 };
+        enum { MaxMedianSplitSize = 32 };
+
+        struct Bin
+        {
+            AABB3f          m_bbox;
+            OrientationCone m_cone;
+            Vector3f        m_axis_sum;
+            float           m_importance;
+            size_t          m_count;
+
+            Bin()
+              : m_cone(OrientationCone::empty())
+              , m_axis_sum(0.0f)
+              , m_importance(0.0f)
+              , m_count(0)
+            {
+                m_bbox.invalidate();
+            }
+
+            void insert(const Bin& rhs)
+            {
+                if (rhs.m_count == 0)
+                    return;
+
+                m_bbox.insert(rhs.m_bbox);
+                m_cone.insert(rhs.m_cone);
+                m_importance += rhs.m_importance;
+                m_count += rhs.m_count;
+            }
+
+            float cost() const
+            {
+                // Give some weight to lights with zero importance so that they are still grouped spatially.
+                const float importance = std::max(m_importance, default_eps<float>());
+                return importance * half_surface_area(m_bbox) * m_cone.measure();
+            }
+        };
+
+        const std::vector<AABB3f>&              m_bboxes;
+        const std::vector<OrientationCone>&     m_cones;
+        const std::vector<float>&               m_importances;
+        std::vector<size_t>                     m_indices;
+        std::vector<std::uint8_t>               m_bin_indices;
+
+        size_t compute_bin(
+            const AABB3f&                       centroid_bbox,
+            const size_t                        dim,
+            const size_t                        index) const
+        {
+            const float c = m_bboxes[index].center(dim);
+            const float x = (c - centroid_bbox.min[dim]) / (centroid_bbox.max[dim] - centroid_bbox.min[dim]);
+            return std::min(truncate<size_t>(x * BinCount), static_cast<size_t>(BinCount - 1));
+        }
+    };
+
+    OrientationCone compute_orientation_cone(const EmittingShape& shape)
+    {
+        switch (shape.get_shape_type())
+        {
+          case EmittingShape::TriangleShape:
+          case EmittingShape::RectangleShape:
+          case EmittingShape::DiskShape:
+            return OrientationCone::direction(Vector3f(shape.get_geometric_normal()));
+
+          default:
+            return OrientationCone::sphere();
+        }
+    }
+}
+
+
 //
 // LightTree class implementation.
 //
@@ -73,49 +465,48 @@ LightTree::LightTree(
 
 std::vector<size_t> LightTree::build()
 {
-    AABBVector light_bboxes;
+    const size_t item_count = m_non_physical_lights.size() + m_emitting_shapes.size();
+
+    m_items.clear();
+    m_items.reserve(item_count);
+
+    std::vector<AABB3f> light_bboxes;
+    std::vector<OrientationCone> light_cones;
+    std::vector<float> light_importances;
+    light_bboxes.reserve(item_count);
+    light_cones.reserve(item_count);
+    light_importances.reserve(item_count);
 
     // Collect non-physical light sources.
     for (size_t i = 0, e = m_non_physical_lights.size(); i < e; ++i)
     {
-        const Light* light = m_non_physical_lights[i].m_light;
-
-        // Retrieve the exact position of the light.
-        const Vector3d position = light->get_transform()
-                                    .get_local_to_parent()
-                                    .extract_translation();
+        m_items.emplace_back(i, NonPhysicalLightType);
+        update_item(m_items.back());
 
-        // Non physical light has no real size - hence some arbitrary small
-        // value is assigned.
-        const double BboxSize = 0.001f;
-        const AABB3d bbox = AABB3d(Vector3d(position[0] - BboxSize,
-                                            position[1] - BboxSize,
-                                            position[2] - BboxSize),
-                                   Vector3d(position[0] + BboxSize,
-                                            position[1] + BboxSize,
-                                            position[2] + BboxSize));
-        light_bboxes.push_back(bbox);
-
-        m_items.emplace_back(bbox, i, NonPhysicalLightType);
+        // Non-physical lights are considered to emit in all directions.
+        light_cones.push_back(OrientationCone::sphere());
     }
 
     // Collect emitting shapes.
     for (size_t i = 0, e = m_emitting_shapes.size(); i < e; ++i)
     {
-        const EmittingShape& shape = m_emitting_shapes[i];
+        m_items.emplace_back(i, EmittingShapeType);
+        update_item(m_items.back());
 
-        const AABB3d& bbox = shape.get_bbox();
+        light_cones.push_back(compute_orientation_cone(m_emitting_shapes[i]));
+    }
 
-        light_bboxes.push_back(bbox);
-        m_items.emplace_back(bbox, i, EmittingShapeType);
+    for (const Item& item : m_items)
+    {
+        light_bboxes.push_back(item.m_bbox);
+        light_importances.push_back(item.m_importance);
     }
 
     // Create the partitioner.
-    typedef bvh::MiddlePartitioner<AABBVector> Partitioner;
-    Partitioner partitioner(light_bboxes);
+    LightTreePartitioner partitioner(light_bboxes, light_cones, light_importances);
 
     // Build the light tree.
-    typedef bvh::Builder<LightTree, Partitioner> Builder;
+    typedef bvh::Builder<LightTree, LightTreePartitioner> Builder;
     Builder builder;
     builder.build<DefaultWallclockTimer>(*this, partitioner, m_items.size(), 1);
 
@@ -135,14 +526,14 @@ std::vector<size_t> LightTree::build()
             &ordering[0],
             ordering.size());
 
-        // Set total node importance and level for each node of the LightTree.
-        IndexLUT tri_index_to_node_index;
-        tri_index_to_node_index.resize(m_emitting_shapes.size());
-        recursive_node_update(0, 0, 0, tri_index_to_node_index);
+        // Set parent, level, total importance and bounding boxes of each node of the LightTree.
+        const IndexLUT tri_index_to_node_index = link_nodes();
+        update_nodes();
 
         // Print light tree statistics.
         Statistics statistics;
         statistics.insert("nodes", m_nodes.size());
+        statistics.insert_size("nodes size", m_nodes.size() * sizeof(NodeType));
         statistics.insert("max tree depth", m_tree_depth);
         statistics.insert_time("total build time", builder.get_build_time());
         RENDERER_LOG_INFO("%s",
@@ -157,82 +548,175 @@ std::vector<size_t> LightTree::build()
     return IndexLUT();
 }
 
+void LightTree::refit()
+{
+    if (!m_is_built)
+        return;
+
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
+
+    for (Item& item : m_items)
+        update_item(item);
+
+    update_nodes();
+
+    stopwatch.measure();
+
+    RENDERER_LOG_DEBUG(
+        "refitted light tree in %s.",
+        pretty_time(stopwatch.get_seconds()).c_str());
+}
+
 bool LightTree::is_built() const
 {
     return m_is_built;
 }
 
-float LightTree::recursive_node_update(
-    const size_t    parent_index,
-    const size_t    node_index,
-    const size_t    node_level,
-    IndexLUT&       tri_index_to_node_index)
+AABB3f LightTree::get_bbox() const
+{
+    assert(is_built());
+
+    const NodeType& root = m_nodes[0];
+
+    if (root.is_leaf())
+        return m_items[root.get_item_index()].m_bbox;
+
+    AABB3f bbox = root.get_left_bbox();
+    bbox.insert(root.get_right_bbox());
+    return bbox;
+}
+
+float LightTree::get_importance() const
 {
-    float importance = 0.0f;
+    assert(is_built());
+
+    return m_nodes[0].get_importance();
+}
 
-    if (!m_nodes[node_index].is_leaf())
+void LightTree::update_item(Item& item) const
+{
+    if (item.m_light_type == NonPhysicalLightType)
     {
-        const auto& child1 = m_nodes[node_index].get_child_node_index();
-        const auto& child2 = m_nodes[node_index].get_child_node_index() + 1;
+        const Light* light = m_non_physical_lights[item.m_light_index].m_light;
 
-        const float importance1 = recursive_node_update(node_index, child1, node_level + 1, tri_index_to_node_index);
-        const float importance2 = recursive_node_update(node_index, child2, node_level + 1, tri_index_to_node_index);
+        // Retrieve the exact position of the light.
+        const Vector3f position(
+            light->get_transform()
+                .get_local_to_parent()
+                .extract_translation());
 
-        importance = importance1 + importance2;
+        // Non physical light has no real size - hence some arbitrary small
+        // value is assigned.
+        const float BboxSize = 0.001f;
+        item.m_bbox = AABB3f(position - Vector3f(BboxSize), position + Vector3f(BboxSize));
+
+        // Retrieve the non-physical light importance.
+        Spectrum spectrum;
+        light->get_inputs().find("intensity").source()->evaluate_uniform(spectrum);
+        item.m_importance = average_value(spectrum);
     }
     else
     {
-        // Retrieve the light source associated to this leaf.
-        const size_t item_index = m_nodes[node_index].get_item_index();
-        const size_t light_index = m_items[item_index].m_light_index;
+        assert(item.m_light_type == EmittingShapeType);
 
-        if (m_items[item_index].m_light_type == NonPhysicalLightType)
-        {
-            const Light* light = m_non_physical_lights[light_index].m_light;
+        const EmittingShape& shape = m_emitting_shapes[item.m_light_index];
 
-            // Retrieve the non-physical light importance.
-            Spectrum spectrum;
-            light->get_inputs().find("intensity").source()->evaluate_uniform(spectrum);
-            importance = average_value(spectrum);
-        }
-        else
-        {
-            assert(m_items[item_index].m_light_type == EmittingShapeType);
+        item.m_bbox = AABB3f(shape.get_bbox());
 
-            const EmittingShape& shape = m_emitting_shapes[light_index];
+        // Retrieve the emitting shape importance.
+        const EDF* edf = shape.get_material()->get_uncached_edf();
+        assert(edf != nullptr);
 
-            // Retrieve the emitting shape importance.
-            const EDF* edf = shape.get_material()->get_uncached_edf();
-            assert(edf != nullptr);
+        const float max_contribution = edf->get_uncached_max_contribution();
 
-            const float max_contribution = edf->get_uncached_max_contribution();
+        // max_contribution is reported as std::numeric_limits<float>::max() when
+        // we can't compute the max_contribution easily (ex: textured lights)
+        // In such cases, we can use a default importance value of 1.0 to avoid
+        // infinite importance values in the light tree nodes.
+        if (max_contribution == std::numeric_limits<float>::max())
+            item.m_importance = 1.0f;
+        else item.m_importance = max_contribution * edf->get_uncached_importance_multiplier();
+    }
+}
 
-            // max_contribution is reported as std::numeric_limits<float>::max() when
-            // we can't compute the max_contribution easily (ex: textured lights)
-            // In such cases, we can use a default importance value of 1.0 to avoid
-            // infinite importance values in the light tree nodes.
-            if (max_contribution == std::numeric_limits<float>::max())
-                importance = 1.0f;
-            else
-                importance = max_contribution * edf->get_uncached_importance_multiplier();
+LightTree::IndexLUT LightTree::link_nodes()
+{
+    IndexLUT tri_index_to_node_index(m_emitting_shapes.size());
 
-            // Save the index of the light tree node containing the EMT in the look up table.
-            tri_index_to_node_index[light_index] = node_index;
+    m_tree_depth = 0;
+
+    m_nodes[0].set_root();
+    m_nodes[0].set_level(0);
+
+    // Child nodes are always stored after their parent node.
+    for (size_t node_index = 0, e = m_nodes.size(); node_index < e; ++node_index)
+    {
+        NodeType& node = m_nodes[node_index];
+        const size_t node_level = node.get_level();
+
+        if (node.is_interior())
+        {
+            const size_t child_index = node.get_child_node_index();
+            assert(child_index > node_index);
+
+            for (size_t i = 0; i < 2; ++i)
+            {
+                NodeType& child = m_nodes[child_index + i];
+                child.set_parent(node_index);
+                child.set_level(node_level + 1);
+            }
         }
+        else
+        {
+            // Save the index of the light tree node containing the EMT in the look up table.
+            const Item& item = m_items[node.get_item_index()];
+            if (item.m_light_type == EmittingShapeType)
+                tri_index_to_node_index[item.m_light_index] = node_index;
 
-        // Keep track of the tree depth.
-        if (m_tree_depth < node_level)
-            m_tree_depth = node_level;
+            // Keep track of the tree depth.
+            if (m_tree_depth < node_level)
+                m_tree_depth = node_level;
+        }
     }
 
-    if (node_index == 0)
-        m_nodes[node_index].set_root();
-    else m_nodes[node_index].set_parent(parent_index);
+    return tri_index_to_node_index;
+}
 
-    m_nodes[node_index].set_importance(importance);
-    m_nodes[node_index].set_level(node_level);
+void LightTree::update_nodes()
+{
+    const size_t node_count = m_nodes.size();
+
+    std::vector<AABB3f> node_bboxes(node_count);
+
+    // Child nodes are always stored after their parent node, hence a reverse
+    // traversal of the node array visits every node after its children.
+    for (size_t i = node_count; i-- > 0; )
+    {
+        NodeType& node = m_nodes[i];
 
-    return importance;
+        if (node.is_interior())
+        {
+            const size_t child_index = node.get_child_node_index();
+            const AABB3f& left_bbox = node_bboxes[child_index];
+            const AABB3f& right_bbox = node_bboxes[child_index + 1];
+
+            node.set_left_bbox(left_bbox);
+            node.set_right_bbox(right_bbox);
+            node.set_importance(
+                m_nodes[child_index].get_importance() +
+                m_nodes[child_index + 1].get_importance());
+
+            node_bboxes[i] = left_bbox;
+            node_bboxes[i].insert(right_bbox);
+        }
+        else
+        {
+            const Item& item = m_items[node.get_item_index()];
+            node.set_importance(item.m_importance);
+            node_bboxes[i] = item.m_bbox;
+        }
+    }
 }
 
 void LightTree::sample(
@@ -278,23 +762,20 @@ float LightTree::evaluate_node_pdf(
     const ShadingPoint&     shading_point,
     size_t                  node_index) const
 {
-    size_t parent_index = m_nodes[node_index].get_parent();
     float pdf = 1.0f;
 
-    do
+    while (!m_nodes[node_index].is_root())
     {
-        const LightTreeNode<AABB3d>& node = m_nodes[parent_index];
+        const size_t parent_index = m_nodes[node_index].get_parent();
+        const NodeType& node = m_nodes[parent_index];
 
         float p1, p2;
         child_node_probabilites(node, shading_point, p1, p2);
 
         pdf *= node.get_child_node_index() == node_index ? p1 : p2;
 
-        // Save the child index to be sure which probability should be taken
-        // into consideration.
         node_index = parent_index;
-        parent_index = m_nodes[node_index].get_parent();
-    } while (!m_nodes[node_index].is_root());
+    }
 
     return pdf;
 }
@@ -350,24 +831,25 @@ namespace
 }
 
 float LightTree::compute_node_probability(
-    const LightTreeNode<AABB3d>&    node,
-    const AABB3d&                   bbox,
+    const NodeType&                 node,
+    const AABB3f&                   bbox,
     const ShadingPoint&             shading_point) const
 {
     // Calculate probability of a single node based on its contribution over solid angle.
-    const float r2 = static_cast<float>(bbox.square_radius());
+    const float r2 = bbox.square_radius();
     const float rcp_surface_area = 1.0f / r2;
 
     // Triangle centroid is a more precise position than the center of the bbox.
+    const Vector3d bbox_center(bbox.center());
     Vector3d position;
     if (node.is_leaf())
     {
         const Item& item = m_items[node.get_item_index()];
         if (item.m_light_type == EmittingShapeType)
             position = m_emitting_shapes[item.m_light_index].get_centroid();
-        else position = bbox.center();
+        else position = bbox_center;
     }
-    else position = bbox.center();
+    else position = bbox_center;
 
     const Vector3d& surface_point = shading_point.get_point();
 
@@ -386,7 +868,7 @@ float LightTree::compute_node_probability(
     //  [1] Area Light Sources for Real-Time Graphics
     //      https://www.microsoft.com/en-us/research/wp-content/uploads/1996/03/arealights.pdf
     //
-    const Vector3d outcoming_light_direction = normalize(bbox.center() - surface_point);
+    const Vector3d outcoming_light_direction = normalize(bbox_center - surface_point);
     const float sin_sigma2 = std::min(1.0f, (r2 / distance2));
     const float cos_sigma = std::sqrt(1.0f - sin_sigma2);
 
@@ -405,7 +887,7 @@ float LightTree::compute_node_probability(
 }
 
 void LightTree::child_node_probabilites(
-    const LightTreeNode<AABB3d>&    node,
+    const NodeType&                 node,
     const ShadingPoint&             shading_point,
     float&                          p1,
     float&                          p2) const
@@ -440,7 +922,7 @@ void LightTree::child_node_probabilites(
 
 void LightTree::draw_tree_structure(
     const std::string&       filename_base,
-    const AABB3d&            root_bbox,
+    const AABB3f&            root_bbox,
     const bool               separate_by_levels) const
 {
     // todo: add a possibility to shift each level of bboxes along the z-axis.
@@ -459,7 +941,7 @@ void LightTree::draw_tree_structure(
             file.draw_axes(Width);
 
             // Draw the initial bbox.
-            file.draw_aabb(root_bbox, color, Width);
+            file.draw_aabb(AABB3d(root_bbox), color, Width);
 
             // Find every node at the parent level and draw its child bboxes.
             for (size_t i = 0; i < m_nodes.size(); ++i)
@@ -469,8 +951,8 @@ void LightTree::draw_tree_structure(
 
                 if (m_nodes[i].get_level() == parent_level)
                 {
-                    const auto& bbox_left = m_nodes[i].get_left_bbox();
-                    const auto& bbox_right = m_nodes[i].get_right_bbox();
+                    const AABB3d bbox_left(m_nodes[i].get_left_bbox());
+                    const AABB3d bbox_right(m_nodes[i].get_right_bbox());
 
                     file.draw_aabb(bbox_left, color, Width);
                     file.draw_aabb(bbox_right, color, Width);
@@ -485,7 +967,7 @@ void LightTree::draw_tree_structure(
         file.draw_axes(Width);
 
         // Draw the initial bbox.
-        file.draw_aabb(root_bbox, "color.yellow", Width);
+        file.draw_aabb(AABB3d(root_bbox), "color.yellow", Width);
 
         // Find nodes on each level of the tree and draw their child bboxes.
         for (size_t i = 0; i < m_nodes.size(); ++i)
@@ -499,8 +981,8 @@ void LightTree::draw_tree_structure(
                     ? "color.red"
                     : "color.green";
 
-            const auto& bbox_left = m_nodes[i].get_left_bbox();
-            const auto& bbox_right = m_nodes[i].get_right_bbox();
+            const AABB3d bbox_left(m_nodes[i].get_left_bbox());
+            const AABB3d bbox_right(m_nodes[i].get_right_bbox());
 
             file.draw_aabb(bbox_left, color, Width);
             file.draw_aabb(bbox_right, color, Width);
@@ -40,6 +40,8 @@
 
 // Standard headers.
 #include <cstddef>
+#include <string>
+#include <vector>
 
 // Forward declarations.
 namespace renderer  { class ShadingPoint; }
@@ -54,7 +56,7 @@ namespace renderer
 class LightTree
   : public foundation::bvh::Tree<
                foundation::AlignedVector<
-                   LightTreeNode<foundation::AABB3d>
+                   LightTreeNode<foundation::AABB3f>
                >
             >
 {
@@ -65,10 +67,20 @@ class LightTree
         const std::vector<NonPhysicalLightInfo>&      non_physical_lights,
         const std::vector<EmittingShape>&             emitting_shapes);
 
+    // Build the tree. Return the index of the leaf node of each emitting shape.
     std::vector<size_t> build();
 
+    // Update the bounding boxes and importances of the nodes after the intensities
+    // or the transforms of the lights have changed, without rebuilding the tree.
+    // The set of lights and their order must be the same as when the tree was built.
+    void refit();
+
     bool is_built() const;
 
+    // Return the bounding box and the total importance of all the lights in the tree.
+    foundation::AABB3f get_bbox() const;
+    float get_importance() const;
+
     void sample(
         const ShadingPoint&             shading_point,
         const float                     s,
@@ -85,23 +97,22 @@ class LightTree
   private:
     struct Item
     {
-        foundation::AABB3d      m_bbox;
+        foundation::AABB3f      m_bbox;
         size_t                  m_light_index;
         LightType               m_light_type;
+        float                   m_importance;
 
         Item() {}
 
         // Item contains bbox and source index of each light source.
-        // source_index represents the light index in m_light_sources vector.
-        // external_source_index represents the light index in light_tree_lights
+        // light_index represents the light index in light_tree_lights
         // and emitting_shapes vectors within the BackwardLightSampler.
         Item(
-            const foundation::AABB3d&       bbox,
             const size_t                    light_index,
             const LightType                 light_type)
-            : m_bbox(bbox)
-            , m_light_index(light_index)
+            : m_light_index(light_index)
             , m_light_type(light_type)
+            , m_importance(0.0f)
         {
         }
     };
@@ -117,22 +128,24 @@ class LightTree
     size_t                                          m_tree_depth;
     bool                                            m_is_built;
 
-    // Calculate the tree depth.
-    // Assign total importance to each node of the tree, where total importance
-    // represents the sum of all its child nodes importances.
-    float recursive_node_update(
-        const size_t                                parent_index,
-        const size_t                                node_index,
-        const size_t                                node_level,
-        IndexLUT&                                   tri_index_to_node_index);
+    // Retrieve the current bounding box and importance of a light.
+    void update_item(Item& item) const;
+
+    // Set the parent and the level of each node, and compute the tree depth.
+    // Return the index of the leaf node of each emitting shape.
+    IndexLUT link_nodes();
+
+    // Assign bounding boxes and total importance to each node of the tree, where
+    // total importance represents the sum of all its child nodes importances.
+    void update_nodes();
 
     float compute_node_probability(
-        const LightTreeNode<foundation::AABB3d>&    node,
-        const foundation::AABB3d&                   bbox,
+        const NodeType&                             node,
+        const foundation::AABB3f&                   bbox,
         const ShadingPoint&                         shading_point) const;
 
     void child_node_probabilites(
-        const LightTreeNode<foundation::AABB3d>&    node,
+        const NodeType&                             node,
         const ShadingPoint&                         shading_point,
         float&                                      p1,
         float&                                      p2) const;
@@ -140,7 +153,7 @@ class LightTree
     // Dump the tree bounding boxes to a VPython file on disk.
     void draw_tree_structure(
         const std::string&                          filename_base,
-        const foundation::AABB3d&                   root_bbox,
+        const foundation::AABB3f&                   root_bbox,
         const bool                                  separate_by_levels = false) const;
 };
 
@@ -33,7 +33,9 @@
 #include "foundation/math/bvh.h"
 
 // Standard headers.
+#include <cassert>
 #include <cstddef>
+#include <cstdint>
 
 namespace renderer
 {
@@ -41,6 +43,10 @@ namespace renderer
 //
 // LightTreeNode class implementation.
 //
+// Light tree nodes are stored in a contiguous, 64-byte aligned array. Additional
+// fields are kept to 32 bits so that a node with single precision bounding boxes
+// fits in two cache lines.
+//
 
 template <typename AABB>
 class LightTreeNode
@@ -49,8 +55,8 @@ class LightTreeNode
   public:
     LightTreeNode()
       : m_importance(0.0f)
-      , m_root(false)
-      , m_parent(0)
+      , m_tree_level(0)
+      , m_parent(~std::uint32_t(0))
     {
     }
 
@@ -66,12 +72,13 @@ class LightTreeNode
 
     size_t get_parent() const
     {
+        assert(!is_root());
         return m_parent;
     }
 
     bool is_root() const
     {
-        return m_root;
+        return m_parent == ~std::uint32_t(0);
     }
 
     void set_importance(const float importance)
@@ -79,29 +86,26 @@ class LightTreeNode
         m_importance = importance;
     }
 
-    // todo: set this during the construction
     void set_level(const size_t node_level)
     {
-        m_tree_level = node_level;
+        m_tree_level = static_cast<std::uint32_t>(node_level);
     }
 
-    // todo: set this during the construction
     void set_parent(const size_t node_parent)
     {
-        m_parent = node_parent;
+        assert(node_parent < ~std::uint32_t(0));
+        m_parent = static_cast<std::uint32_t>(node_parent);
     }
 
-    // todo: set this during the construction
     void set_root()
     {
-        m_root = true;
+        m_parent = ~std::uint32_t(0);
     }
 
   private:
-    float   m_importance;
-    size_t  m_tree_level;
-    size_t  m_parent;
-    bool    m_root;
+    float           m_importance;
+    std::uint32_t   m_tree_level;
+    std::uint32_t   m_parent;
 };
 
 }   // namespace renderer
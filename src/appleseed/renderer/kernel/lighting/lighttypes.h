@@ -149,6 +149,9 @@ class EmittingShape
 
     const foundation::Vector3d& get_centroid() const;
 
+    // Return the world space geometric normal of planar shapes (all shapes but spheres).
+    const foundation::Vector3d& get_geometric_normal() const;
+
     void sample_uniform(
         const foundation::Vector2f& s,
         const float                 shape_prob,
@@ -300,6 +303,25 @@ inline const foundation::Vector3d& EmittingShape::get_centroid() const
     return m_centroid;
 }
 
+inline const foundation::Vector3d& EmittingShape::get_geometric_normal() const
+{
+    switch (get_shape_type())
+    {
+      case TriangleShape:
+        return m_geom.m_triangle.m_geometric_normal;
+
+      case RectangleShape:
+        return m_geom.m_rectangle.m_geometric_normal;
+
+      case DiskShape:
+        return m_geom.m_disk.m_geometric_normal;
+
+      default:
+        assert(!"Shape has no geometric normal.");
+        return m_geom.m_triangle.m_geometric_normal;
+    }
+}
+
 inline float EmittingShape::get_average_flux() const
 {
     return m_average_flux;
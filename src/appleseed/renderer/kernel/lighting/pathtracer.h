@@ -841,7 +841,8 @@ bool PathTracer<PathVisitor, VolumeVisitor, Adjoint>::march(
             // No more scattering events are allowed:
             // update the ray transmission and continue path tracing.
             Spectrum transmission;
-            volume->evaluate_transmission(
+            volume->estimate_transmission(
+                sampling_context,
                 vertex.m_volume_data,
                 volume_ray,
                 transmission);
@@ -849,49 +850,122 @@ bool PathTracer<PathVisitor, VolumeVisitor, Adjoint>::march(
             break;
         }
 
-        // Retrieve extinction spectrum.
-        const Spectrum& extinction_coef =
-            volume->extinction_coefficient(vertex.m_volume_data, volume_ray);
+        // Sample distance and compute the throughput weight of the scattering event.
+        float distance_sample;
+        Spectrum scattering_weight;
+        if (volume->is_homogeneous())
+        {
+            // Retrieve extinction spectrum.
+            const Spectrum& extinction_coef =
+                volume->extinction_coefficient(vertex.m_volume_data, volume_ray);
 
-        // Sample channel uniformly at random.
-        sampling_context.split_in_place(1, 1);
-        const float s = sampling_context.next2<float>();
-        const size_t channel = foundation::truncate<size_t>(s * Spectrum::size());
-        const bool extinction_is_null = extinction_coef[channel] < 1.0e-6f;
+            // Sample channel uniformly at random.
+            sampling_context.split_in_place(1, 1);
+            const float s = sampling_context.next2<float>();
+            const size_t channel = foundation::truncate<size_t>(s * Spectrum::size());
+            const bool extinction_is_null = extinction_coef[channel] < 1.0e-6f;
 
-        // Sample distance.
-        float distance_sample, distance_pdf;
-        if (extinction_is_null)
-        {
-            distance_sample = 0.0f;
-            distance_pdf = 0.0f;
+            // Sample distance.
+            float distance_pdf;
+            if (extinction_is_null)
+            {
+                distance_sample = 0.0f;
+                distance_pdf = 0.0f;
+            }
+            else
+            {
+                sampling_context.split_in_place(1, 1);
+                distance_sample =
+                    foundation::sample_exponential_distribution(
+                        sampling_context.next2<float>(),
+                        extinction_coef[channel]);
+                distance_pdf =
+                    foundation::exponential_distribution_pdf(
+                        distance_sample,
+                        extinction_coef[channel]);
+            }
+
+            // Continue path tracing if sampled distance exceeds total length of the ray,
+            // otherwise process the scattering event.
+            if (extinction_is_null || volume_ray.m_tmax < distance_sample)
+            {
+                Spectrum transmission;
+                volume->evaluate_transmission(
+                    vertex.m_volume_data,
+                    volume_ray,
+                    transmission);
+                vertex.m_throughput *= transmission;
+                vertex.m_throughput /=                       // equivalent to multiplying by MIS weight
+                    foundation::average_value(transmission); // and then dividing by transmission[channel]
+                break;
+            }
+
+            // Retrieve scattering spectrum.
+            const Spectrum& scattering_coef =
+                volume->scattering_coefficient(vertex.m_volume_data, volume_ray);
+
+            // Evaluate transmission between the origin and the sampled distance.
+            Spectrum transmission;
+            volume->evaluate_transmission(
+                vertex.m_volume_data,
+                volume_ray,
+                distance_sample,
+                transmission);
+
+            // Compute MIS weight.
+            // MIS terms are:
+            //  - scattering albedo,
+            //  - throughput of the entire path up to the sampled point.
+            // Reference: "Practical and Controllable Subsurface Scattering
+            // for Production Path Tracing", p. 1 [ACM 2016 Article].
+            float mis_weights_sum = 0.0f;
+            for (size_t i = 0, e = Spectrum::size(); i < e; ++i)
+            {
+                if (extinction_coef[i] > 1.0e-6f)
+                {
+                    const float probability =
+                        foundation::exponential_distribution_pdf(
+                            distance_sample,
+                            extinction_coef[i]);
+                    mis_weights_sum += foundation::square(probability);
+                }
+            }
+            if (mis_weights_sum < 1.0e-6f)
+                return false;  // no scattering
+            const float current_mis_weight =
+                Spectrum::size() *
+                foundation::square(distance_pdf) /
+                mis_weights_sum;
+
+            scattering_weight = scattering_coef;
+            scattering_weight *= transmission;
+            scattering_weight *= current_mis_weight / distance_pdf;
         }
         else
         {
-            sampling_context.split_in_place(1, 1);
-            distance_sample =
-                foundation::sample_exponential_distribution(
-                    sampling_context.next2<float>(),
-                    extinction_coef[channel]);
-            distance_pdf =
-                foundation::exponential_distribution_pdf(
+            // Heterogeneous media are sampled with delta tracking, which directly
+            // provides the ratio of transmission to the probability of the sample.
+            Spectrum tracking_weight;
+            const bool collided =
+                volume->sample_distance(
+                    sampling_context,
+                    vertex.m_volume_data,
+                    volume_ray,
                     distance_sample,
-                    extinction_coef[channel]);
-        }
+                    tracking_weight);
 
-        // Continue path tracing if sampled distance exceeds total length of the ray,
-        // otherwise process the scattering event.
-        if (extinction_is_null || volume_ray.m_tmax < distance_sample)
-        {
-            Spectrum transmission;
-            volume->evaluate_transmission(
+            if (!collided)
+            {
+                vertex.m_throughput *= tracking_weight;
+                break;
+            }
+
+            volume->scattering_coefficient(
                 vertex.m_volume_data,
                 volume_ray,
-                transmission);
-            vertex.m_throughput *= transmission;
-            vertex.m_throughput /=                       // equivalent to multiplying by MIS weight
-                foundation::average_value(transmission); // and then dividing by transmission[channel]
-            break;
+                distance_sample,
+                scattering_weight);
+            scattering_weight *= tracking_weight;
         }
 
         //
@@ -915,46 +989,7 @@ bool PathTracer<PathVisitor, VolumeVisitor, Adjoint>::march(
         if (vertex.m_scattering_modes == ScatteringMode::None)
             return false;
 
-        // Retrieve scattering spectrum.
-        const Spectrum& scattering_coef =
-            volume->scattering_coefficient(vertex.m_volume_data, volume_ray);
-
-        // Evaluate transmission between the origin and the sampled distance.
-        Spectrum transmission;
-        volume->evaluate_transmission(
-            vertex.m_volume_data,
-            volume_ray,
-            distance_sample,
-            transmission);
-        
-        // Compute MIS weight.
-        // MIS terms are:
-        //  - scattering albedo,
-        //  - throughput of the entire path up to the sampled point.
-        // Reference: "Practical and Controllable Subsurface Scattering
-        // for Production Path Tracing", p. 1 [ACM 2016 Article].
-        float mis_weights_sum = 0.0f;
-        for (size_t i = 0, e = Spectrum::size(); i < e; ++i)
-        {
-            if (extinction_coef[i] > 1.0e-6f)
-            {
-                const float probability =
-                    foundation::exponential_distribution_pdf(
-                        distance_sample,
-                        extinction_coef[i]);
-                mis_weights_sum += foundation::square(probability);
-            }
-        }
-        if (mis_weights_sum < 1.0e-6f)
-            return false;  // no scattering
-        const float current_mis_weight =
-            Spectrum::size() *
-            foundation::square(distance_pdf) /
-            mis_weights_sum;
-
-        vertex.m_throughput *= scattering_coef;
-        vertex.m_throughput *= transmission;
-        vertex.m_throughput *= current_mis_weight / distance_pdf;
+        vertex.m_throughput *= scattering_weight;
 
         // Sample phase function.
         foundation::Vector3f incoming;
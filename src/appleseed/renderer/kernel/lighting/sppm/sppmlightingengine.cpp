@@ -460,7 +460,6 @@ namespace
                 const float             rcp_max_square_dist,
                 Spectrum&               radiance)
             {
-                const SPPMPhotonMap& photon_map = m_pass_callback.get_photon_map();
                 const Vector3f normal(vertex.get_geometric_normal());
 
                 for (size_t i = 0; i < photon_count; ++i)
@@ -468,8 +467,7 @@ namespace
                     // Retrieve the i'th photon.
                     const knn::Answer<float>::Entry& entry = m_answer.get(i);
                     const SPPMMonoPhoton& photon =
-                        m_pass_callback.get_mono_photon(
-                            photon_map.remap(entry.m_index));
+                        m_pass_callback.get_mono_photon(entry.m_index);
 
                     // Reject photons from the opposite hemisphere as they won't contribute.
                     if (dot(normal, photon.m_incoming) <= 0.0f)
@@ -535,7 +533,6 @@ namespace
                 const float             rcp_max_square_dist,
                 Spectrum&               radiance)
             {
-                const SPPMPhotonMap& photon_map = m_pass_callback.get_photon_map();
                 const Vector3f normal(vertex.get_geometric_normal());
 
                 for (size_t i = 0; i < photon_count; ++i)
@@ -543,8 +540,7 @@ namespace
                     // Retrieve the i'th photon.
                     const knn::Answer<float>::Entry& entry = m_answer.get(i);
                     const SPPMPolyPhoton& photon =
-                        m_pass_callback.get_poly_photon(
-                            photon_map.remap(entry.m_index));
+                        m_pass_callback.get_poly_photon(entry.m_index);
 
                     // Reject photons from the opposite hemisphere as they won't contribute.
                     if (dot(normal, photon.m_incoming) <= 0.0f)
@@ -642,7 +638,7 @@ namespace
                 {
                     const knn::Answer<float>::Entry& photon = m_answer.get(i);
                     const SpectrumLine& flux =
-                        m_pass_callback.get_mono_photon(photon_map.remap(photon.m_index)).m_flux;
+                        m_pass_callback.get_mono_photon(photon.m_index).m_flux;
                     radiance[flux.m_wavelength] += flux.m_amplitude;
                 }
             }
@@ -651,7 +647,7 @@ namespace
                 for (size_t i = 0; i < photon_count; ++i)
                 {
                     const knn::Answer<float>::Entry& photon = m_answer.get(i);
-                    radiance += m_pass_callback.get_poly_photon(photon_map.remap(photon.m_index)).m_flux;
+                    radiance += m_pass_callback.get_poly_photon(photon.m_index).m_flux;
                 }
             }
 
@@ -92,7 +92,7 @@ class SPPMPassCallback
         foundation::JobQueue&           job_queue,
         foundation::IAbortSwitch&       abort_switch) override;
 
-    // Return the i'th photon.
+    // Return the i'th photon, where i is an internal index of the photon map.
     const SPPMMonoPhoton& get_mono_photon(const size_t i) const;
     const SPPMPolyPhoton& get_poly_photon(const size_t i) const;
 
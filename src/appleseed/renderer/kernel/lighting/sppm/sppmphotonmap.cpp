@@ -36,19 +36,24 @@
 
 // appleseed.foundation headers.
 #include "foundation/platform/defaulttimers.h"
+#include "foundation/utility/job/jobqueue.h"
 #include "foundation/utility/statistics.h"
+#include "foundation/utility/stopwatch.h"
 #include "foundation/utility/string.h"
 
 // Standard headers.
 #include <cstddef>
 #include <string>
+#include <vector>
 
 using namespace foundation;
 
 namespace renderer
 {
 
-SPPMPhotonMap::SPPMPhotonMap(SPPMPhotonVector& photons)
+SPPMPhotonMap::SPPMPhotonMap(
+    SPPMPhotonVector&   photons,
+    JobQueue&           job_queue)
 {
     const size_t photon_count = photons.size();
 
@@ -60,10 +65,20 @@ SPPMPhotonMap::SPPMPhotonMap(SPPMPhotonVector& photons)
             photon_count > 1 ? "photons" : "photon");
 
         knn::Builder3f builder(*this);
-        builder.build_move_points<DefaultWallclockTimer>(photons.m_positions);
+        builder.build_move_points<DefaultWallclockTimer>(photons.m_positions, job_queue);
+
+        Stopwatch<DefaultWallclockTimer> stopwatch;
+        stopwatch.start();
+
+        // Store the photons in the same order as the points of the map.
+        reorder_photons(photons.m_mono_photons);
+        reorder_photons(photons.m_poly_photons);
+
+        stopwatch.measure();
 
         Statistics statistics;
         statistics.insert_time("build time", builder.get_build_time());
+        statistics.insert_time("photon reordering time", stopwatch.get_seconds());
         statistics.insert_size("size", photons.get_memory_size());
         statistics.merge(knn::TreeStatistics<knn::Tree3f>(*this));
 
@@ -79,4 +94,20 @@ SPPMPhotonMap::SPPMPhotonMap(SPPMPhotonVector& photons)
     }
 }
 
+template <typename Photon>
+void SPPMPhotonMap::reorder_photons(std::vector<Photon>& photons) const
+{
+    const size_t photon_count = photons.size();
+
+    if (photon_count == 0)
+        return;
+
+    std::vector<Photon> reordered(photon_count);
+
+    for (size_t i = 0; i < photon_count; ++i)
+        reordered[i] = photons[remap(i)];
+
+    photons.swap(reordered);
+}
+
 }   // namespace renderer
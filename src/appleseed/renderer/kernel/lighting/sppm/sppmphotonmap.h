@@ -32,8 +32,12 @@
 // appleseed.foundation headers.
 #include "foundation/math/knn.h"
 
+// Standard headers.
+#include <vector>
+
 // Forward declarations.
-namespace renderer  { class SPPMPhotonVector; }
+namespace foundation    { class JobQueue; }
+namespace renderer      { class SPPMPhotonVector; }
 
 namespace renderer
 {
@@ -42,8 +46,17 @@ class SPPMPhotonMap
   : public foundation::knn::Tree3f
 {
   public:
-    // Constructor, *moves* the photon positions into the map.
-    explicit SPPMPhotonMap(SPPMPhotonVector& photons);
+    // Constructor, *moves* the photon positions into the map, then reorders the
+    // photons such that the i'th photon corresponds to the i'th point of the map.
+    // Photons found by a query are thus directly indexed by the query answer, and
+    // photons that are close in space are close in memory.
+    SPPMPhotonMap(
+        SPPMPhotonVector&       photons,
+        foundation::JobQueue&   job_queue);
+
+  private:
+    template <typename Photon>
+    void reorder_photons(std::vector<Photon>& photons) const;
 };
 
 }   // namespace renderer
@@ -63,8 +63,13 @@ Tracer::Tracer(
   , m_shadergroup_exec(shadergroup_exec)
   , m_assume_no_alpha_mapping(!scene.uses_alpha_mapping())
   , m_assume_no_participating_media(!scene.has_participating_media())
+  , m_use_any_hit_traversal(
+        !m_assume_no_alpha_mapping &&
+        m_assume_no_participating_media &&
+        intersector.supports_any_hit_traversal())
   , m_transmission_threshold(transparency_threshold)
   , m_max_iterations(max_iterations)
+  , m_alpha_filter(*this)
 {
     if (print_details)
     {
@@ -74,6 +79,12 @@ Tracer::Tracer(
                 "the scene does not rely on alpha mapping "
                 "and does not contain participating media; using probe tracing.");
         }
+        else if (m_use_any_hit_traversal)
+        {
+            RENDERER_LOG_INFO(
+                "the scene uses alpha mapping "
+                "but does not contain participating media; using any-hit probe tracing.");
+        }
         else
         {
             RENDERER_LOG_INFO(
@@ -348,4 +359,32 @@ void Tracer::evaluate_alpha(
     }
 }
 
+
+//
+// Tracer::AlphaFilter class implementation.
+//
+
+Tracer::AlphaFilter::AlphaFilter(const Tracer& tracer)
+  : m_tracer(tracer)
+{
+}
+
+float Tracer::AlphaFilter::evaluate_opacity(const ShadingPoint& shading_point)
+{
+    // Surfaces without material are fully opaque.
+    const Material* material = shading_point.get_material();
+    if (material == nullptr)
+        return 1.0f;
+
+    const Material::RenderData& render_data = material->get_render_data();
+    if (render_data.m_bsdf == nullptr &&
+        render_data.m_bssrdf == nullptr &&
+        render_data.m_volume != nullptr)
+        return 0.0f;
+
+    Alpha alpha;
+    m_tracer.evaluate_alpha(*material, shading_point, alpha);
+    return alpha[0];
+}
+
 }   // namespace renderer
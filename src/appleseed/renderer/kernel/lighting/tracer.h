@@ -58,6 +58,10 @@ namespace renderer
 // point-to-point visibility. It automatically takes into account alpha
 // transparency.
 //
+// In scenes without participating media, the *_simple() methods evaluate
+// alpha transparency during a single any-hit traversal of the scene instead
+// of tracing a new ray past every partial occluder.
+//
 
 class Tracer
   : public foundation::NonCopyable
@@ -163,12 +167,27 @@ class Tracer
         Spectrum&                       transmission);
 
   private:
+    // Opacity filter used during any-hit traversal of shadow rays.
+    class AlphaFilter
+      : public IAnyHitFilter
+    {
+      public:
+        explicit AlphaFilter(const Tracer& tracer);
+
+        float evaluate_opacity(const ShadingPoint& shading_point) override;
+
+      private:
+        const Tracer&                   m_tracer;
+    };
+
     const Intersector&                  m_intersector;
     OSLShaderGroupExec&                 m_shadergroup_exec;
     const bool                          m_assume_no_alpha_mapping;
     const bool                          m_assume_no_participating_media;
+    const bool                          m_use_any_hit_traversal;
     const float                         m_transmission_threshold;
     const size_t                        m_max_iterations;
+    AlphaFilter                         m_alpha_filter;
     ShadingPoint                        m_shading_points[2];
 
     const ShadingPoint& do_trace(
@@ -202,6 +221,8 @@ inline void Tracer::trace_simple(
 {
     if (m_assume_no_alpha_mapping && m_assume_no_participating_media)
         transmission.set(m_intersector.trace_probe(ray) ? 0.0f : 1.0f);
+    else if (m_use_any_hit_traversal)
+        transmission.set(m_intersector.trace_transmission(ray, m_alpha_filter, m_transmission_threshold));
     else
     {
         const ShadingPoint& shading_point =
@@ -223,6 +244,8 @@ inline void Tracer::trace_simple(
 {
     if (m_assume_no_alpha_mapping && m_assume_no_participating_media)
         transmission.set(m_intersector.trace_probe(ray, &origin) ? 0.0f : 1.0f);
+    else if (m_use_any_hit_traversal)
+        transmission.set(m_intersector.trace_transmission(ray, m_alpha_filter, m_transmission_threshold, &origin));
     else
     {
         const ShadingPoint& shading_point =
@@ -244,7 +267,7 @@ inline void Tracer::trace_between_simple(
     const VisibilityFlags::Type         ray_flags,
     Spectrum&                           transmission)
 {
-    if (m_assume_no_alpha_mapping && m_assume_no_participating_media)
+    if ((m_assume_no_alpha_mapping && m_assume_no_participating_media) || m_use_any_hit_traversal)
     {
         const foundation::Vector3d direction = target - origin.get_point();
         const double dist = foundation::norm(direction);
@@ -258,7 +281,10 @@ inline void Tracer::trace_between_simple(
             ray_flags,
             origin.get_ray().m_depth + 1);
 
-        transmission.set(m_intersector.trace_probe(ray, &origin) ? 0.0f : 1.0f);
+        transmission.set(
+            m_use_any_hit_traversal
+                ? m_intersector.trace_transmission(ray, m_alpha_filter, m_transmission_threshold, &origin)
+                : (m_intersector.trace_probe(ray, &origin) ? 0.0f : 1.0f));
     }
     else
     {
@@ -283,7 +309,7 @@ inline void Tracer::trace_between_simple(
     const VisibilityFlags::Type         ray_flags,
     Spectrum&                           transmission)
 {
-    if (m_assume_no_alpha_mapping && m_assume_no_participating_media)
+    if ((m_assume_no_alpha_mapping && m_assume_no_participating_media) || m_use_any_hit_traversal)
     {
         const foundation::Vector3d direction = target - origin.get_point();
         const double dist = foundation::norm(direction);
@@ -297,7 +323,10 @@ inline void Tracer::trace_between_simple(
             ray_flags,
             parent_ray.m_depth);
 
-        transmission.set(m_intersector.trace_probe(ray, &origin) ? 0.0f : 1.0f);
+        transmission.set(
+            m_use_any_hit_traversal
+                ? m_intersector.trace_transmission(ray, m_alpha_filter, m_transmission_threshold, &origin)
+                : (m_intersector.trace_probe(ray, &origin) ? 0.0f : 1.0f));
     }
     else
     {
@@ -323,7 +352,7 @@ inline void Tracer::trace_between_simple(
     const VisibilityFlags::Type         ray_flags,
     Spectrum&                           transmission)
 {
-    if (m_assume_no_alpha_mapping && m_assume_no_participating_media)
+    if ((m_assume_no_alpha_mapping && m_assume_no_participating_media) || m_use_any_hit_traversal)
     {
         const foundation::Vector3d direction = target - origin;
         const double dist = foundation::norm(direction);
@@ -337,7 +366,10 @@ inline void Tracer::trace_between_simple(
             ray_flags,
             parent_ray.m_depth);
 
-        transmission.set(m_intersector.trace_probe(ray) ? 0.0f : 1.0f);
+        transmission.set(
+            m_use_any_hit_traversal
+                ? m_intersector.trace_transmission(ray, m_alpha_filter, m_transmission_threshold)
+                : (m_intersector.trace_probe(ray) ? 0.0f : 1.0f));
     }
     else
     {
@@ -364,7 +396,7 @@ inline void Tracer::trace_between_simple(
     const ShadingRay::DepthType         ray_depth,
     Spectrum&                           transmission)
 {
-    if (m_assume_no_alpha_mapping && m_assume_no_participating_media)
+    if ((m_assume_no_alpha_mapping && m_assume_no_participating_media) || m_use_any_hit_traversal)
     {
         const foundation::Vector3d direction = target - origin;
         const double dist = foundation::norm(direction);
@@ -378,7 +410,10 @@ inline void Tracer::trace_between_simple(
             ray_flags,
             ray_depth);
 
-        transmission.set(m_intersector.trace_probe(ray) ? 0.0f : 1.0f);
+        transmission.set(
+            m_use_any_hit_traversal
+                ? m_intersector.trace_transmission(ray, m_alpha_filter, m_transmission_threshold)
+                : (m_intersector.trace_probe(ray) ? 0.0f : 1.0f));
     }
     else
     {
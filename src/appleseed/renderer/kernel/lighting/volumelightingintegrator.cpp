@@ -149,17 +149,26 @@ namespace
 // Call graph:
 //
 //   compute_radiance_combined_sampling
+//       compute_radiance_tracking
 //       add_single_distance_sample_contribution
 //
 //   compute_radiance_exponential_sampling
+//       compute_radiance_tracking
 //       add_single_distance_sample_contribution_exponential_only
 //
+//   compute_radiance_tracking
+//       add_single_distance_sample_contribution_tracking
+//
 //   add_single_distance_sample_contribution
 //       take_single_direction_sample
 //
 //   add_single_distance_sample_contribution_exponential_only
 //       take_single_direction_sample
 //
+//   add_single_distance_sample_contribution_tracking
+//       Volume::sample_distance
+//       take_single_direction_sample
+//
 //   take_single_direction_sample
 //       DirectLightingIntegrator::take_single_material_sample
 //       DirectLightingIntegrator::add_emitting_shape_sample_contribution
@@ -373,6 +382,92 @@ void VolumeLightingIntegrator::add_single_distance_sample_contribution_exponenti
     radiance += inscattered;
 }
 
+void VolumeLightingIntegrator::add_single_distance_sample_contribution_tracking(
+    const LightSample*          light_sample,
+    SamplingContext&            sampling_context,
+    const MISHeuristic          mis_heuristic,
+    DirectShadingComponents&    radiance,
+    const bool                  sample_phase_function) const
+{
+    float distance_sample;
+    Spectrum weight;
+    if (!m_volume.sample_distance(
+            sampling_context,
+            m_volume_data,
+            m_volume_ray,
+            distance_sample,
+            weight))
+        return;
+
+    DirectShadingComponents inscattered;
+    take_single_direction_sample(
+        sample_phase_function,
+        sampling_context,
+        light_sample,
+        distance_sample,
+        mis_heuristic,
+        inscattered);
+
+    inscattered *= weight;
+    inscattered *= m_rcp_distance_sample_count;
+    radiance += inscattered;
+}
+
+void VolumeLightingIntegrator::compute_radiance_tracking(
+    SamplingContext&            sampling_context,
+    const MISHeuristic          mis_heuristic,
+    DirectShadingComponents&    radiance) const
+{
+    if (m_distance_sample_count > 0)
+    {
+        const size_t light_count = m_light_sampler.get_non_physical_light_count();
+
+        // Add contributions from non-physical light sources that don't belong to the lightset.
+        for (size_t light_idx = 0; light_idx < light_count; ++light_idx)
+        {
+            LightSample light_sample;
+            m_light_sampler.sample_non_physical_light(m_time, light_idx, light_sample);
+
+            for (size_t i = 0; i < m_distance_sample_count; ++i)
+            {
+                add_single_distance_sample_contribution_tracking(
+                    &light_sample,
+                    sampling_context,
+                    mis_heuristic,
+                    radiance,
+                    false);
+            }
+        }
+    }
+
+    // Add contributions from the light set.
+    if (m_light_sampler.has_lightset())
+    {
+        for (size_t i = 0; i < m_distance_sample_count; ++i)
+        {
+            for (size_t j = 0; j < m_light_sample_count; ++j)
+            {
+                add_single_distance_sample_contribution_tracking(
+                    nullptr,
+                    sampling_context,
+                    mis_heuristic,
+                    radiance,
+                    false);
+            }
+
+            if (!ScatteringMode::has_volume(m_scattering_modes))
+            {
+                add_single_distance_sample_contribution_tracking(
+                    nullptr,
+                    sampling_context,
+                    mis_heuristic,
+                    radiance,
+                    true);
+            }
+        }
+    }
+}
+
 void VolumeLightingIntegrator::compute_radiance_combined_sampling(
     SamplingContext&            sampling_context,
     const MISHeuristic          mis_heuristic,
@@ -384,6 +479,12 @@ void VolumeLightingIntegrator::compute_radiance_combined_sampling(
     if (!m_light_sampler.has_lights())
         return;
 
+    if (!m_volume.is_homogeneous())
+    {
+        compute_radiance_tracking(sampling_context, mis_heuristic, radiance);
+        return;
+    }
+
     const Spectrum& extinction_coef = m_volume.extinction_coefficient(
         m_volume_data, m_volume_ray);
 
@@ -462,6 +563,12 @@ void VolumeLightingIntegrator::compute_radiance_exponential_sampling(
     if (!m_light_sampler.has_lights())
         return;
 
+    if (!m_volume.is_homogeneous())
+    {
+        compute_radiance_tracking(sampling_context, mis_heuristic, radiance);
+        return;
+    }
+
     const Spectrum& extinction_coef = m_volume.extinction_coefficient(
         m_volume_data, m_volume_ray);
 
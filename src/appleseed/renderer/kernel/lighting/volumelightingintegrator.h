@@ -84,6 +84,7 @@ class VolumeLightingIntegrator
 
     // Integrate in-scattered radiance over the given ray
     // using both equiangular and exponential sampling.
+    // Heterogeneous volumes fall back to their own distance sampling.
     void compute_radiance_combined_sampling(
         SamplingContext&                sampling_context,
         const foundation::MISHeuristic  mis_heuristic,
@@ -91,6 +92,7 @@ class VolumeLightingIntegrator
 
     // Integrate in-scattered radiance over the given ray
     // using only exponential sampling.
+    // Heterogeneous volumes fall back to their own distance sampling.
     void compute_radiance_exponential_sampling(
         SamplingContext&                sampling_context,
         const foundation::MISHeuristic  mis_heuristic,
@@ -130,6 +132,22 @@ class VolumeLightingIntegrator
         DirectShadingComponents&        radiance,
         const bool                      sample_phasefunction) const;
 
+    // Sample distance by tracking through a heterogeneous volume
+    // and integrate in-scattered lighting at this distance.
+    void add_single_distance_sample_contribution_tracking(
+        const LightSample*              light_sample,
+        SamplingContext&                sampling_context,
+        const foundation::MISHeuristic  mis_heuristic,
+        DirectShadingComponents&        radiance,
+        const bool                      sample_phase_function) const;
+
+    // Integrate in-scattered radiance over the given ray using the
+    // distance sampling procedure of a heterogeneous volume.
+    void compute_radiance_tracking(
+        SamplingContext&                sampling_context,
+        const foundation::MISHeuristic  mis_heuristic,
+        DirectShadingComponents&        radiance) const;
+
     float draw_exponential_sample(
         SamplingContext&                sampling_context,
         const ShadingRay&               volume_ray,
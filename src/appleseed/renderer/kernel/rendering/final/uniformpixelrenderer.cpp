@@ -59,8 +59,10 @@
 #include "foundation/utility/statistics.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <vector>
 
 using namespace foundation;
 
@@ -73,6 +75,9 @@ namespace
     // Uniform pixel renderer.
     //
 
+    // Maximum number of samples of a pixel handed to the sample renderer at once.
+    const size_t SampleBatchSize = 16;
+
     class UniformPixelRenderer
       : public PixelRendererBase
     {
@@ -86,6 +91,9 @@ namespace
           , m_sample_renderer(factory->create(thread_index))
           , m_sample_count(m_params.m_samples)
         {
+            m_sampling_contexts.reserve(SampleBatchSize);
+            m_pixel_contexts.reserve(SampleBatchSize);
+
             const size_t sample_aov_index = frame.aovs().get_index("pixel_sample_count");
 
             // If the sample count AOV is enabled, we need to reset its normalization
@@ -144,43 +152,59 @@ namespace
                 0,                          // number of samples -- unknown
                 instance);                  // initial instance number
 
-            for (size_t i = 0; i < m_sample_count; ++i)
+            for (size_t begin = 0; begin < m_sample_count; begin += SampleBatchSize)
             {
-                // Generate a uniform sample in [0,1)^2.
-                const Vector2f s =
-                    m_sample_count > 1 || m_params.m_force_aa
-                        ? sampling_context.next2<Vector2f>()
-                        : Vector2f(0.5f);
-
-                // Sample the pixel filter.
-                const auto& filter_table = frame.get_filter_sampling_table();
-                const Vector2d pf(
-                    static_cast<double>(filter_table.sample(s[0]) + 0.5f),
-                    static_cast<double>(filter_table.sample(s[1]) + 0.5f));
-
-                // Compute the sample position in NDC.
-                const Vector2d sample_position = frame.get_sample_position(pi.x + pf.x, pi.y + pf.y);
-
-                // Create a pixel context that identifies the pixel and sample currently being rendered.
-                const PixelContext pixel_context(pi, sample_position);
-
-                // Render the sample.
-                ShadingResult shading_result(aov_count);
-                SamplingContext child_sampling_context(sampling_context);
-                m_sample_renderer->render_sample(
-                    child_sampling_context,
-                    pixel_context,
-                    sample_position,
+                const size_t batch_size = std::min(m_sample_count - begin, SampleBatchSize);
+
+                m_sampling_contexts.clear();
+                m_pixel_contexts.clear();
+
+                Vector2d sample_positions[SampleBatchSize];
+
+                for (size_t i = 0; i < batch_size; ++i)
+                {
+                    // Generate a uniform sample in [0,1)^2.
+                    const Vector2f s =
+                        m_sample_count > 1 || m_params.m_force_aa
+                            ? sampling_context.next2<Vector2f>()
+                            : Vector2f(0.5f);
+
+                    // Sample the pixel filter.
+                    const auto& filter_table = frame.get_filter_sampling_table();
+                    const Vector2d pf(
+                        static_cast<double>(filter_table.sample(s[0]) + 0.5f),
+                        static_cast<double>(filter_table.sample(s[1]) + 0.5f));
+
+                    // Compute the sample position in NDC.
+                    sample_positions[i] = frame.get_sample_position(pi.x + pf.x, pi.y + pf.y);
+
+                    // Create a pixel context that identifies the pixel and sample currently being rendered.
+                    m_pixel_contexts.emplace_back(pi, sample_positions[i]);
+
+                    m_sampling_contexts.push_back(sampling_context);
+                    m_shading_results[i].clear(aov_count);
+                }
+
+                // Render the samples. Batching them lets the sample renderer trace
+                // their primary rays together.
+                m_sample_renderer->render_samples(
+                    batch_size,
+                    m_sampling_contexts.data(),
+                    m_pixel_contexts.data(),
+                    sample_positions,
                     aov_accumulators,
-                    shading_result);
-
-                // Update sampling statistics.
-                m_total_sampling_dim.insert(child_sampling_context.get_total_dimension());
-
-                // Merge the sample into the framebuffer.
-                if (shading_result.is_valid())
-                    framebuffer.add(Vector2u(pt), shading_result);
-                else signal_invalid_sample();
+                    m_shading_results);
+
+                for (size_t i = 0; i < batch_size; ++i)
+                {
+                    // Update sampling statistics.
+                    m_total_sampling_dim.insert(m_sampling_contexts[i].get_total_dimension());
+
+                    // Merge the sample into the framebuffer.
+                    if (m_shading_results[i].is_valid())
+                        framebuffer.add(Vector2u(pt), m_shading_results[i]);
+                    else signal_invalid_sample();
+                }
             }
 
             on_pixel_end(frame, pi, pt, tile_bbox, aov_accumulators);
@@ -222,6 +246,10 @@ namespace
         auto_release_ptr<ISampleRenderer>   m_sample_renderer;
         const size_t                        m_sample_count;
         Population<std::uint64_t>           m_total_sampling_dim;
+
+        std::vector<SamplingContext>        m_sampling_contexts;
+        std::vector<PixelContext>           m_pixel_contexts;
+        ShadingResult                       m_shading_results[SampleBatchSize];
     };
 }
 
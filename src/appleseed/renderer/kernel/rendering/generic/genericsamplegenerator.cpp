@@ -36,6 +36,7 @@
 #include "renderer/kernel/rendering/isamplerenderer.h"
 #include "renderer/kernel/rendering/localsampleaccumulationbuffer.h"
 #include "renderer/kernel/rendering/pixelcontext.h"
+#include "renderer/kernel/rendering/progressive/adaptivesamplescheduler.h"
 #include "renderer/kernel/rendering/sample.h"
 #include "renderer/kernel/rendering/samplegeneratorbase.h"
 #include "renderer/kernel/shading/shadingresult.h"
@@ -56,6 +57,7 @@
 // Standard headers.
 #include <cassert>
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 using namespace foundation;
@@ -87,6 +89,8 @@ namespace
           , m_window_width_next_pow2(next_power(static_cast<double>(m_window_width), 2.0))
           , m_window_height_next_pow3(next_power(static_cast<double>(m_window_height), 3.0))
           , m_filter_sampling_table(frame.get_filter_sampling_table())
+          , m_scheduler(nullptr)
+          , m_scheduler_version(0)
         {
         }
 
@@ -104,6 +108,14 @@ namespace
         {
             SampleGeneratorBase::reset();
             m_rng = SamplingContext::RNGType();
+            fetch_distribution();
+        }
+
+        void set_adaptive_sample_scheduler(
+            const AdaptiveSampleScheduler*  scheduler) override
+        {
+            m_scheduler = scheduler;
+            fetch_distribution();
         }
 
         StatisticsVector get_statistics() const override
@@ -144,10 +156,25 @@ namespace
 
         const FilterSamplingTable&          m_filter_sampling_table;
 
+        const AdaptiveSampleScheduler*      m_scheduler;
+        std::uint32_t                       m_scheduler_version;
+        std::shared_ptr<const AdaptiveSampleScheduler::Distribution> m_distribution;
+
         Population<std::uint64_t>           m_total_sampling_dim;
 
         AOVAccumulatorContainer             m_aov_accumulators;
 
+        void fetch_distribution()
+        {
+            if (m_scheduler != nullptr)
+            {
+                // Read the version first so that a concurrent update is picked up next time.
+                m_scheduler_version = m_scheduler->get_version();
+                m_distribution = m_scheduler->get_distribution();
+            }
+            else m_distribution.reset();
+        }
+
         size_t generate_samples(
             const size_t                    sequence_index,
             SampleVector&                   samples) override
@@ -156,14 +183,30 @@ namespace
             const size_t Bases[2] = { 2, 3 };
             const Vector2d s = halton_sequence<double, 2>(Bases, sequence_index);
 
-            // Compute the coordinates of the pixel in the padded crop window.
-            const Vector2d t(s[0] * m_window_width_next_pow2, s[1] * m_window_height_next_pow3);
-            const int x = truncate<int>(t[0]);
-            const int y = truncate<int>(t[1]);
+            // Pick up the latest distribution of the adaptive sample scheduler.
+            if (m_scheduler != nullptr && m_scheduler->get_version() != m_scheduler_version)
+                fetch_distribution();
 
-            // Reject samples that fall outside the actual frame.
-            if (x >= m_window_width || y >= m_window_height)
-                return 0;
+            int x, y;
+
+            if (m_distribution)
+            {
+                // Choose a pixel of the crop window according to the scheduler's distribution.
+                const Vector2u p = m_distribution->sample(s);
+                x = static_cast<int>(p.x) - m_window_origin_x;
+                y = static_cast<int>(p.y) - m_window_origin_y;
+            }
+            else
+            {
+                // Compute the coordinates of the pixel in the padded crop window.
+                const Vector2d t(s[0] * m_window_width_next_pow2, s[1] * m_window_height_next_pow3);
+                x = truncate<int>(t[0]);
+                y = truncate<int>(t[1]);
+
+                // Reject samples that fall outside the actual frame.
+                if (x >= m_window_width || y >= m_window_height)
+                    return 0;
+            }
 
             // Create a sampling context. We start with an initial dimension of 2,
             // corresponding to the Halton sequence used for the sample positions.
@@ -34,6 +34,7 @@
 #include "renderer/global/globallogger.h"
 #include "renderer/global/globaltypes.h"
 #include "renderer/kernel/aov/aovaccumulator.h"
+#include "renderer/kernel/intersection/intersectionsettings.h"
 #include "renderer/kernel/intersection/intersector.h"
 #include "renderer/kernel/intersection/tracecontext.h"
 #include "renderer/kernel/lighting/ilightingengine.h"
@@ -61,6 +62,7 @@
 #include "foundation/utility/string.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <limits>
@@ -168,23 +170,106 @@ namespace
             AOVAccumulatorContainer&    aov_accumulators,
             ShadingResult&              shading_result) override
         {
-#ifdef DEBUG_DISPLAY_TEXTURE_CACHE_PERFORMANCE
+            // Construct a primary ray.
+            ShadingRay primary_ray;
+            spawn_primary_ray(sampling_context, image_point, primary_ray);
 
-            const std::uint64_t last_texture_cache_hit_count = m_texture_cache.get_hit_count();
-            const std::uint64_t last_texture_cache_miss_count = m_texture_cache.get_miss_count();
+            // Trace the primary ray.
+            ShadingPoint primary_shading_point;
+            m_intersector.trace(primary_ray, primary_shading_point);
 
-#endif
+            shade_primary_ray(
+                sampling_context,
+                pixel_context,
+                primary_ray,
+                primary_shading_point,
+                aov_accumulators,
+                shading_result);
+        }
 
-            // Construct a primary ray.
-            ShadingRay primary_ray;
+        void render_samples(
+            const size_t                sample_count,
+            SamplingContext*            sampling_contexts,
+            const PixelContext*         pixel_contexts,
+            const Vector2d*             image_points,
+            AOVAccumulatorContainer&    aov_accumulators,
+            ShadingResult*              shading_results) override
+        {
+            for (size_t begin = 0; begin < sample_count; begin += RayPacketSize)
+            {
+                const size_t packet_size = std::min(sample_count - begin, RayPacketSize);
+
+                // Construct the primary rays. Camera sampling dimensions are
+                // consumed in sample order, exactly as render_sample() would.
+                ShadingRay primary_rays[RayPacketSize];
+                for (size_t i = 0; i < packet_size; ++i)
+                {
+                    spawn_primary_ray(
+                        sampling_contexts[begin + i],
+                        image_points[begin + i],
+                        primary_rays[i]);
+                }
+
+                // Trace the primary rays together.
+                for (size_t i = 0; i < packet_size; ++i)
+                    m_primary_shading_points[i].clear();
+                m_intersector.trace_packet(primary_rays, packet_size, m_primary_shading_points);
+
+                // Shade the samples one by one.
+                for (size_t i = 0; i < packet_size; ++i)
+                {
+                    shade_primary_ray(
+                        sampling_contexts[begin + i],
+                        pixel_contexts[begin + i],
+                        primary_rays[i],
+                        m_primary_shading_points[i],
+                        aov_accumulators,
+                        shading_results[begin + i]);
+                }
+            }
+        }
+
+        StatisticsVector get_statistics() const override
+        {
+            StatisticsVector stats;
+            stats.merge(m_texture_cache.get_statistics());
+            stats.merge(m_intersector.get_statistics());
+            stats.merge(m_lighting_engine->get_statistics());
+            return stats;
+        }
+
+      private:
+        void spawn_primary_ray(
+            SamplingContext&            sampling_context,
+            const Vector2d&             image_point,
+            ShadingRay&                 primary_ray) const
+        {
             m_scene.get_render_data().m_active_camera->spawn_ray(
                 sampling_context,
                 Dual2d(image_point, m_image_point_dx, m_image_point_dy),
                 primary_ray);
+        }
+
+        // Shade a primary ray whose first intersection is already known,
+        // then continue tracing it through transparent surfaces.
+        void shade_primary_ray(
+            SamplingContext&            sampling_context,
+            const PixelContext&         pixel_context,
+            ShadingRay&                 primary_ray,
+            const ShadingPoint&         primary_shading_point,
+            AOVAccumulatorContainer&    aov_accumulators,
+            ShadingResult&              shading_result)
+        {
+#ifdef DEBUG_DISPLAY_TEXTURE_CACHE_PERFORMANCE
+
+            const std::uint64_t last_texture_cache_hit_count = m_texture_cache.get_hit_count();
+            const std::uint64_t last_texture_cache_miss_count = m_texture_cache.get_miss_count();
+
+#endif
 
             ShadingPoint shading_points[2];
             size_t shading_point_index = 0;
-            const ShadingPoint* shading_point_ptr = nullptr;
+            const ShadingPoint* shading_point_ptr = &primary_shading_point;
             size_t iterations = 0;
 
             // Inform the AOV accumulators that we are about to render a sample.
@@ -203,17 +288,6 @@ namespace
 
                 m_arena.clear();
 
-                // Trace the ray.
-                shading_points[shading_point_index].clear();
-                m_intersector.trace(
-                    primary_ray,
-                    shading_points[shading_point_index],
-                    shading_point_ptr);
-
-                // Update the pointers to the shading points.
-                shading_point_ptr = &shading_points[shading_point_index];
-                shading_point_index = 1 - shading_point_index;
-
                 if (iterations == 1)
                 {
                     // Shade the first intersection point along the ray.
@@ -231,6 +305,17 @@ namespace
                 }
                 else
                 {
+                    // Trace the ray.
+                    shading_points[shading_point_index].clear();
+                    m_intersector.trace(
+                        primary_ray,
+                        shading_points[shading_point_index],
+                        shading_point_ptr);
+
+                    // Update the pointers to the shading points.
+                    shading_point_ptr = &shading_points[shading_point_index];
+                    shading_point_index = 1 - shading_point_index;
+
                     // Shade the next intersection point along the ray.
                     ShadingResult local_result(shading_result.m_aov_count);
                     const bool terminate_path =
@@ -294,16 +379,6 @@ namespace
 #endif
         }
 
-        StatisticsVector get_statistics() const override
-        {
-            StatisticsVector stats;
-            stats.merge(m_texture_cache.get_statistics());
-            stats.merge(m_intersector.get_statistics());
-            stats.merge(m_lighting_engine->get_statistics());
-            return stats;
-        }
-
-      private:
         struct Parameters
         {
             const float     m_transparency_threshold;
@@ -335,6 +410,8 @@ namespace
 
         Vector2d                    m_image_point_dx;
         Vector2d                    m_image_point_dy;
+
+        ShadingPoint                m_primary_shading_points[RayPacketSize];
     };
 }
 
@@ -40,20 +40,72 @@
 #include "foundation/image/image.h"
 #include "foundation/image/pixel.h"
 #include "foundation/image/tile.h"
+#include "foundation/platform/compiler.h"
+#include "foundation/platform/thread.h"
 #include "foundation/utility/job/iabortswitch.h"
 
 // Boost headers.
 #include "boost/chrono/duration.hpp"
 
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
 using namespace foundation;
 
 namespace renderer
 {
 
+namespace
+{
+    // Width and height in pixels of the blocks of a staging buffer.
+    const size_t BlockSize = 32;
+
+    // Maximum number of blocks a staging buffer may hold before it gets merged
+    // into the frame buffer (a block is 16 KB, so this is 16 MB per thread).
+    const size_t MaxStagingBlockCount = 1024;
+
+    // Index of the staging buffer last used by the calling thread.
+    APPLESEED_TLS size_t t_staging_buffer_hint = 0;
+}
+
+struct GlobalSampleAccumulationBuffer::StagingBuffer
+{
+    boost::mutex                                    m_mutex;
+    std::vector<std::unique_ptr<AccumulatorTile>>   m_blocks;       // indexed by block, lazily allocated
+    std::vector<size_t>                             m_used_blocks;  // indices of allocated blocks
+
+    explicit StagingBuffer(const size_t block_count)
+      : m_blocks(block_count)
+    {
+    }
+
+    void clear()
+    {
+        for (const size_t block_index : m_used_blocks)
+            m_blocks[block_index].reset();
+
+        m_used_blocks.clear();
+    }
+};
+
 GlobalSampleAccumulationBuffer::GlobalSampleAccumulationBuffer(
     const size_t    width,
-    const size_t    height)
+    const size_t    height,
+    const size_t    staging_buffer_count)
   : m_fb(width, height, 3)
+  , m_block_count_x((width + BlockSize - 1) / BlockSize)
+  , m_block_count_y((height + BlockSize - 1) / BlockSize)
+{
+    assert(staging_buffer_count > 0);
+
+    m_staging_buffers.reserve(staging_buffer_count);
+    for (size_t i = 0; i < staging_buffer_count; ++i)
+        m_staging_buffers.emplace_back(new StagingBuffer(m_block_count_x * m_block_count_y));
+}
+
+GlobalSampleAccumulationBuffer::~GlobalSampleAccumulationBuffer()
 {
 }
 
@@ -65,6 +117,13 @@ void GlobalSampleAccumulationBuffer::clear()
     m_sample_count = 0;
 
     m_fb.clear();
+
+    // Discard the samples that are still staged.
+    for (auto& staging : m_staging_buffers)
+    {
+        boost::mutex::scoped_lock staging_lock(staging->m_mutex);
+        staging->clear();
+    }
 }
 
 void GlobalSampleAccumulationBuffer::store_samples(
@@ -72,15 +131,15 @@ void GlobalSampleAccumulationBuffer::store_samples(
     const Sample    samples[],
     IAbortSwitch&   abort_switch)
 {
-    // Request non-exclusive access.
-    boost::shared_lock<boost::shared_mutex> lock(m_mutex, boost::defer_lock);
-    while (true)
-    {
-        if (abort_switch.is_aborted())
-            return;
-        if (lock.try_lock_for(boost::chrono::milliseconds(5)))
-            break;
-    }
+    StagingBuffer* staging_ptr = acquire_staging_buffer(abort_switch);
+    if (staging_ptr == nullptr)
+        return;
+
+    StagingBuffer& staging = *staging_ptr;
+    boost::mutex::scoped_lock staging_lock(staging.m_mutex, boost::adopt_lock);
+
+    const size_t fb_width = m_fb.get_width();
+    const size_t fb_height = m_fb.get_height();
 
     size_t counter = 0;
 
@@ -90,7 +149,36 @@ void GlobalSampleAccumulationBuffer::store_samples(
         if ((counter++ & 4096) == 0 && abort_switch.is_aborted())
             return;
 
-        m_fb.atomic_add(Vector2u(s->m_pixel_coords), &s->m_color[0]);
+        // Ignore samples outside the frame.
+        const Vector2u pi(s->m_pixel_coords);
+        if (pi.x >= fb_width || pi.y >= fb_height)
+            continue;
+
+        const size_t bx = pi.x / BlockSize;
+        const size_t by = pi.y / BlockSize;
+        const size_t block_index = by * m_block_count_x + bx;
+
+        std::unique_ptr<AccumulatorTile>& block = staging.m_blocks[block_index];
+        if (!block)
+        {
+            block.reset(new AccumulatorTile(BlockSize, BlockSize, 3));
+            block->clear();
+            staging.m_used_blocks.push_back(block_index);
+        }
+
+        block->add(
+            Vector2u(pi.x - bx * BlockSize, pi.y - by * BlockSize),
+            &s->m_color[0]);
+    }
+
+    // Bound the memory used by this staging buffer. If the frame buffer is busy being
+    // developed or cleared, don't wait: that will merge or discard this staging buffer.
+    if (staging.m_used_blocks.size() > MaxStagingBlockCount)
+    {
+        // Request non-exclusive access.
+        boost::shared_lock<boost::shared_mutex> lock(m_mutex, boost::try_to_lock);
+        if (lock.owns_lock())
+            merge_staging_buffer(staging, true);
     }
 }
 
@@ -108,6 +196,13 @@ void GlobalSampleAccumulationBuffer::develop_to_frame(
             break;
     }
 
+    // Merge all staged samples into the frame buffer.
+    for (auto& staging : m_staging_buffers)
+    {
+        boost::mutex::scoped_lock staging_lock(staging->m_mutex);
+        merge_staging_buffer(*staging, false);
+    }
+
     Image& image = frame.image();
     const CanvasProperties& frame_props = image.properties();
 
@@ -139,6 +234,82 @@ void GlobalSampleAccumulationBuffer::increment_sample_count(const std::uint64_t
     m_sample_count += delta_sample_count;
 }
 
+GlobalSampleAccumulationBuffer::StagingBuffer* GlobalSampleAccumulationBuffer::acquire_staging_buffer(
+    IAbortSwitch&   abort_switch)
+{
+    const size_t staging_buffer_count = m_staging_buffers.size();
+
+    while (true)
+    {
+        // Start with the staging buffer this thread used last.
+        const size_t start = t_staging_buffer_hint;
+
+        for (size_t i = 0; i < staging_buffer_count; ++i)
+        {
+            const size_t index = (start + i) % staging_buffer_count;
+            StagingBuffer& staging = *m_staging_buffers[index];
+
+            if (staging.m_mutex.try_lock())
+            {
+                t_staging_buffer_hint = index;
+                return &staging;
+            }
+        }
+
+        // All staging buffers are in use, which only happens while they are
+        // being merged or when there are more threads than staging buffers.
+        if (abort_switch.is_aborted())
+            return nullptr;
+
+        foundation::yield();
+    }
+}
+
+void GlobalSampleAccumulationBuffer::merge_staging_buffer(
+    StagingBuffer&  staging,
+    const bool      atomic)
+{
+    const size_t fb_width = m_fb.get_width();
+    const size_t fb_height = m_fb.get_height();
+
+    for (const size_t block_index : staging.m_used_blocks)
+    {
+        const AccumulatorTile& block = *staging.m_blocks[block_index];
+
+        const size_t origin_x = (block_index % m_block_count_x) * BlockSize;
+        const size_t origin_y = (block_index / m_block_count_x) * BlockSize;
+        const size_t width = std::min(BlockSize, fb_width - origin_x);
+        const size_t height = std::min(BlockSize, fb_height - origin_y);
+
+        for (size_t y = 0; y < height; ++y)
+        {
+            for (size_t x = 0; x < width; ++x)
+            {
+                const float* APPLESEED_RESTRICT src = block.pixel(x, y);
+
+                // Skip pixels that did not receive any sample.
+                if (src[0] == 0.0f)
+                    continue;
+
+                float* APPLESEED_RESTRICT dst = m_fb.pixel(origin_x + x, origin_y + y);
+
+                if (atomic)
+                {
+                    for (size_t i = 0; i < 4; ++i)
+                        foundation::atomic_add(dst + i, src[i]);
+                }
+                else
+                {
+                    for (size_t i = 0; i < 4; ++i)
+                        dst[i] += src[i];
+                }
+            }
+        }
+    }
+
+    staging.clear();
+}
+
 void GlobalSampleAccumulationBuffer::develop_to_tile(
     Tile&           tile,
     const size_t    origin_x,
@@ -40,6 +40,8 @@
 // Standard headers.
 #include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <vector>
 
 // Forward declarations.
 namespace foundation    { class IAbortSwitch; }
@@ -50,6 +52,15 @@ namespace renderer      { class Sample; }
 namespace renderer
 {
 
+//
+// A sample accumulation buffer covering the whole frame.
+//
+// Samples are first accumulated into a pool of sparse staging buffers, one per
+// rendering thread, then merged into the frame buffer when the buffer is developed,
+// or earlier when a staging buffer grows too large. A thread only locks the staging
+// buffer it uses; threads keep using the same staging buffer as long as it is free.
+//
+
 class GlobalSampleAccumulationBuffer
   : public SampleAccumulationBuffer
 {
@@ -57,7 +68,11 @@ class GlobalSampleAccumulationBuffer
     // Constructor.
     GlobalSampleAccumulationBuffer(
         const size_t                width,
-        const size_t                height);
+        const size_t                height,
+        const size_t                staging_buffer_count);
+
+    // Destructor.
+    ~GlobalSampleAccumulationBuffer() override;
 
     // Reset the buffer to its initial state. Thread-safe.
     void clear() override;
@@ -77,8 +92,27 @@ class GlobalSampleAccumulationBuffer
     void increment_sample_count(const std::uint64_t delta_sample_count);
 
   private:
+    struct StagingBuffer;
+
     boost::shared_mutex             m_mutex;
     foundation::AccumulatorTile     m_fb;
+    const size_t                    m_block_count_x;
+    const size_t                    m_block_count_y;
+
+    std::vector<std::unique_ptr<StagingBuffer>> m_staging_buffers;
+
+    // Lock and return a staging buffer that no other thread is using,
+    // or return nullptr if the abort switch was triggered.
+    StagingBuffer* acquire_staging_buffer(foundation::IAbortSwitch& abort_switch);
+
+    // Merge the content of a staging buffer into the frame buffer, and empty it.
+    // The caller must hold the staging buffer's lock, and either a shared lock
+    // on m_mutex (atomic == true) or an exclusive one (atomic == false).
+    // To avoid deadlocks, a thread holding a staging buffer's lock must never
+    // wait for m_mutex.
+    void merge_staging_buffer(
+        StagingBuffer&              staging,
+        const bool                  atomic);
 
     void develop_to_tile(
         foundation::Tile&           tile,
@@ -38,6 +38,7 @@
 // Forward declarations.
 namespace foundation    { class IAbortSwitch; }
 namespace foundation    { class StatisticsVector; }
+namespace renderer      { class AdaptiveSampleScheduler; }
 namespace renderer      { class SampleAccumulationBuffer; }
 
 namespace renderer
@@ -57,6 +58,11 @@ class ISampleGenerator
     // Reset the sample generator to its initial state.
     virtual void reset() = 0;
 
+    // Steer pixel selection according to an adaptive sample scheduler, or sample
+    // uniformly if the scheduler is null. Generators are free to ignore it.
+    virtual void set_adaptive_sample_scheduler(
+        const AdaptiveSampleScheduler*  scheduler) = 0;
+
     // Generate a given number of samples and accumulate them into a buffer.
     virtual void generate_samples(
         const size_t                sample_count,
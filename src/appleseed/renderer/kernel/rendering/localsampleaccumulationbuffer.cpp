@@ -40,6 +40,7 @@
 #include "foundation/image/accumulatortile.h"
 #include "foundation/image/canvasproperties.h"
 #include "foundation/image/color.h"
+#include "foundation/image/colorspace.h"
 #include "foundation/image/image.h"
 #include "foundation/image/pixel.h"
 #include "foundation/image/tile.h"
@@ -53,6 +54,8 @@
 // Standard headers.
 #include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <limits>
 
 using namespace boost;
 using namespace foundation;
@@ -143,6 +146,17 @@ void LocalSampleAccumulationBuffer::clear()
     }
 
     m_active_level = static_cast<std::uint32_t>(m_levels.size() - 1);
+
+    std::fill(m_squared_luminances.begin(), m_squared_luminances.end(), 0.0f);
+}
+
+void LocalSampleAccumulationBuffer::enable_noise_estimation()
+{
+    // Request exclusive access.
+    LockType::ScopedWriteLock lock(m_lock);
+
+    if (m_squared_luminances.empty())
+        m_squared_luminances.assign(m_levels[0]->get_pixel_count(), 0.0f);
 }
 
 void LocalSampleAccumulationBuffer::store_samples(
@@ -169,6 +183,21 @@ void LocalSampleAccumulationBuffer::store_samples(
         RENDERER_LOG_DEBUG("store_samples: acquiring lock: %f", sw.get_seconds() * 1000.0);
 #endif
 
+        // Accumulate squared luminances at the highest resolution level for noise estimation.
+        if (!m_squared_luminances.empty())
+        {
+            const size_t level_width = m_levels[0]->get_width();
+
+            const Sample* sample_end = samples + sample_count;
+            for (const Sample* s = samples; s < sample_end; ++s)
+            {
+                const size_t x = static_cast<size_t>(s->m_pixel_coords.x);
+                const size_t y = static_cast<size_t>(s->m_pixel_coords.y);
+                const float lum = luminance(s->m_color.rgb());
+                foundation::atomic_add(&m_squared_luminances[y * level_width + x], lum * lum);
+            }
+        }
+
         // Store samples at every level, starting with the highest resolution level up to the active level.
         size_t counter = 0;
         for (std::uint32_t i = 0, e = m_active_level; i <= e; ++i)
@@ -303,6 +332,68 @@ void LocalSampleAccumulationBuffer::develop_to_frame(
 #endif
 }
 
+void LocalSampleAccumulationBuffer::estimate_block_noise(
+    const std::vector<AABB2u>&  blocks,
+    std::vector<float>&         block_noise,
+    std::vector<float>&         block_spp)
+{
+    assert(!m_squared_luminances.empty());
+
+    block_noise.resize(blocks.size());
+    block_spp.resize(blocks.size());
+
+    // Request exclusive access.
+    LockType::ScopedWriteLock lock(m_lock);
+
+    const AccumulatorTile& level = *m_levels[0];
+    const size_t level_width = level.get_width();
+
+    for (size_t i = 0, e = blocks.size(); i < e; ++i)
+    {
+        const AABB2u& block = blocks[i];
+        assert(block.max.x < level_width);
+        assert(block.max.y < level.get_height());
+
+        float max_noise = 0.0f;
+        float weight_sum = 0.0f;
+
+        for (size_t y = block.min.y; y <= block.max.y; ++y)
+        {
+            for (size_t x = block.min.x; x <= block.max.x; ++x)
+            {
+                // Each pixel stores its weight (the number of samples) followed by the sum of its samples.
+                const float* ptr = level.pixel(x, y);
+                const float n = ptr[0];
+                weight_sum += n;
+
+                if (n < 2.0f)
+                {
+                    max_noise = std::numeric_limits<float>::infinity();
+                    continue;
+                }
+
+                // Unbiased variance of the luminance, then standard error of its mean.
+                const float rcp_n = 1.0f / n;
+                const float mean = luminance(Color3f(ptr[1], ptr[2], ptr[3])) * rcp_n;
+                const float mean_sq = m_squared_luminances[y * level_width + x] * rcp_n;
+                const float variance = std::max(mean_sq - mean * mean, 0.0f) * n / (n - 1.0f);
+                const float std_error = std::sqrt(variance * rcp_n);
+
+                // Normalize by the square root of the intensity, like the adaptive tile renderer,
+                // so that dark regions do not need to be as precise in absolute terms.
+                const float noise =
+                    mean > 0.0f ? std_error / std::sqrt(mean) :
+                    std_error > 0.0f ? std::numeric_limits<float>::infinity() : 0.0f;
+
+                max_noise = std::max(max_noise, noise);
+            }
+        }
+
+        block_noise[i] = max_noise;
+        block_spp[i] = weight_sum / block.volume();
+    }
+}
+
 void LocalSampleAccumulationBuffer::develop_to_tile(
     Tile&                   color_tile,
     const size_t            image_width,
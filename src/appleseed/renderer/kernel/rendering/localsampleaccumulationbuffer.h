@@ -79,6 +79,19 @@ class LocalSampleAccumulationBuffer
         Frame&                                  frame,
         foundation::IAbortSwitch&               abort_switch) override;
 
+    // Start accumulating the per-pixel moments needed by estimate_block_noise().
+    // Must be called before samples are stored. Thread-safe.
+    void enable_noise_estimation();
+
+    // Estimate the noise level and the average number of samples per pixel of a set of
+    // pixel blocks (in canvas coordinates). The noise level of a block is the largest
+    // relative standard error of the mean luminance of its pixels, or infinity if one
+    // of its pixels has too few samples. Requires noise estimation. Thread-safe.
+    void estimate_block_noise(
+        const std::vector<foundation::AABB2u>&  blocks,
+        std::vector<float>&                     block_noise,
+        std::vector<float>&                     block_spp);
+
     // Exposed for tests and benchmarks.
     static void develop_to_tile(
         foundation::Tile&                       color_tile,
@@ -99,6 +112,7 @@ class LocalSampleAccumulationBuffer
     std::vector<foundation::Vector2f>           m_level_scales;
     boost::atomic<std::int32_t>*                m_remaining_pixels;
     boost::atomic<std::uint32_t>                m_active_level;
+    std::vector<float>                          m_squared_luminances;
 };
 
 }   // namespace renderer
@@ -47,6 +47,7 @@
 #include "renderer/modeling/project/project.h"
 #include "renderer/modeling/project/renderingtimer.h"
 #include "renderer/modeling/scene/scene.h"
+#include "renderer/modeling/scene/sceneeditjournal.h"
 #include "renderer/utility/settingsparsing.h"
 
 // appleseed.foundation headers.
@@ -288,9 +289,17 @@ struct MasterRenderer::Impl
     // Render a frame until completed or aborted and handle reinitialization events.
     MasterRenderer::RenderingResult::Status do_render(IRendererController& renderer_controller)
     {
+        bool begin_rendering = true;
+
         while (true)
         {
-            renderer_controller.on_rendering_begin();
+            // Let the renderer controller prepare for rendering (and apply pending scene edits),
+            // unless it was already done while trying to apply scene edits in place.
+            if (begin_rendering)
+                renderer_controller.on_rendering_begin();
+
+            // All pending scene edits are taken into account by a full initialization.
+            m_project.get_scene_edit_journal().clear();
 
             // Construct an abort switch that will allow to abort initialization.
             RendererControllerAbortSwitch abort_switch(renderer_controller);
@@ -309,7 +318,8 @@ struct MasterRenderer::Impl
                 return RenderingResult::Aborted;
             }
 
-            const IRendererController::Status status = initialize_and_render_frame(renderer_controller);
+            const IRendererController::Status status =
+                initialize_and_render_frame(renderer_controller, begin_rendering);
 
             switch (status)
             {
@@ -338,8 +348,15 @@ struct MasterRenderer::Impl
     }
 
     // Initialize render device and render a frame.
-    IRendererController::Status initialize_and_render_frame(IRendererController& renderer_controller)
+    IRendererController::Status initialize_and_render_frame(
+        IRendererController&    renderer_controller,
+        bool&                   begin_rendering)
     {
+        begin_rendering = true;
+
+        // Scene preparation honors the number of rendering threads.
+        m_project.set_thread_count(get_rendering_thread_count(m_params));
+
         // Construct an abort switch that will allow to abort initialization or rendering.
         RendererControllerAbortSwitch abort_switch(renderer_controller);
 
@@ -414,8 +431,23 @@ struct MasterRenderer::Impl
             return renderer_controller.get_status();
         }
 
-        // Execute the main rendering loop.
-        const auto status = render_frame(renderer_controller, abort_switch);
+        // Execute the main rendering loop. Requests to reinitialize rendering are handled
+        // here as long as the scene edits that triggered them can be applied in place.
+        IRendererController::Status status;
+        while (true)
+        {
+            status = render_frame(renderer_controller, abort_switch);
+
+            if (status != IRendererController::ReinitializeRendering)
+                break;
+
+            // Let the renderer controller apply pending scene edits.
+            renderer_controller.on_rendering_begin();
+            begin_rendering = false;
+
+            if (!update_scene())
+                break;
+        }
 
         // Perform post-render actions.
         recorder.on_render_end(m_project);
@@ -429,6 +461,32 @@ struct MasterRenderer::Impl
         return status;
     }
 
+    // Apply in place the scene edits recorded in the project's scene edit journal.
+    // Return false if rendering must be fully reinitialized instead.
+    bool update_scene()
+    {
+        SceneEditJournal& journal = m_project.get_scene_edit_journal();
+
+        bool emitters_moved;
+        if (!apply_scene_edits_in_place(journal, *m_project.get_scene(), emitters_moved))
+            return false;
+
+        journal.clear();
+
+        // Only the child trees of modified assemblies are rebuilt.
+        if (!m_render_device->build_or_update_scene())
+            return false;
+
+        // Light samplers are refitted rather than rebuilt when possible.
+        if (emitters_moved && !m_render_device->update_light_samplers())
+        {
+            RENDERER_LOG_DEBUG("light emitters cannot be updated in place, reinitializing rendering...");
+            return false;
+        }
+
+        return true;
+    }
+
     // Render a frame until completed or aborted and handle restart events.
     IRendererController::Status render_frame(
         IRendererController&    renderer_controller,
@@ -0,0 +1,190 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "adaptivesamplescheduler.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/cdf.h"
+#include "foundation/math/scalar.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+//
+// AdaptiveSampleScheduler::Parameters class implementation.
+//
+
+AdaptiveSampleScheduler::Parameters::Parameters()
+  : m_block_size(16)
+  , m_min_samples(16)
+  , m_max_samples(256)
+  , m_noise_threshold(0.02f)
+{
+}
+
+
+//
+// AdaptiveSampleScheduler::Distribution class implementation.
+//
+
+Vector2u AdaptiveSampleScheduler::Distribution::sample(const Vector2d& s) const
+{
+    assert(!m_blocks.empty());
+
+    // Choose a block and remap the first coordinate to [0,1) within it.
+    const size_t i = sample_cdf(m_cdf.begin(), m_cdf.end(), s[0]);
+    const double cdf_begin = i > 0 ? m_cdf[i - 1] : 0.0;
+    const double u = (s[0] - cdf_begin) / (m_cdf[i] - cdf_begin);
+
+    // Choose a pixel in the block.
+    const AABB2u& block = m_blocks[i];
+    const Vector2u extent = block.extent();
+    return
+        Vector2u(
+            block.min.x + std::min(truncate<size_t>(u * extent[0]), extent[0] - 1),
+            block.min.y + std::min(truncate<size_t>(s[1] * extent[1]), extent[1] - 1));
+}
+
+
+//
+// AdaptiveSampleScheduler class implementation.
+//
+
+AdaptiveSampleScheduler::AdaptiveSampleScheduler(
+    const AABB2u&       crop_window,
+    const Parameters&   params)
+  : m_params(params)
+  , m_version(0)
+{
+    assert(crop_window.is_valid());
+    assert(m_params.m_block_size > 0);
+
+    const size_t block_size = m_params.m_block_size;
+
+    for (size_t y = crop_window.min.y; y <= crop_window.max.y; y += block_size)
+    {
+        for (size_t x = crop_window.min.x; x <= crop_window.max.x; x += block_size)
+        {
+            m_blocks.emplace_back(
+                Vector2u(x, y),
+                Vector2u(
+                    std::min(x + block_size - 1, crop_window.max.x),
+                    std::min(y + block_size - 1, crop_window.max.y)));
+        }
+    }
+
+    m_active_block_count = m_blocks.size();
+}
+
+void AdaptiveSampleScheduler::clear()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    m_distribution.reset();
+    m_active_block_count = m_blocks.size();
+    ++m_version;
+}
+
+bool AdaptiveSampleScheduler::update(
+    const std::vector<float>&   block_noise,
+    const std::vector<float>&   block_spp)
+{
+    assert(block_noise.size() == m_blocks.size());
+    assert(block_spp.size() == m_blocks.size());
+
+    // Blocks whose noise level is far above the threshold get proportionally
+    // more samples, up to this factor relative to blocks that are nearly done.
+    const float MaxBoost = 16.0f;
+
+    std::shared_ptr<Distribution> distribution(new Distribution());
+    double weight_sum = 0.0;
+
+    for (size_t i = 0, e = m_blocks.size(); i < e; ++i)
+    {
+        const float noise = block_noise[i];
+        const float spp = block_spp[i];
+
+        const bool converged =
+            (spp >= m_params.m_min_samples && noise <= m_params.m_noise_threshold) ||
+            (m_params.m_max_samples > 0 && spp >= m_params.m_max_samples);
+
+        if (converged)
+            continue;
+
+        const float boost =
+            std::isinf(noise)
+                ? MaxBoost
+                : clamp(noise / m_params.m_noise_threshold, 1.0f, MaxBoost);
+
+        weight_sum += static_cast<double>(m_blocks[i].volume()) * boost;
+
+        distribution->m_blocks.push_back(m_blocks[i]);
+        distribution->m_cdf.push_back(weight_sum);
+    }
+
+    const size_t active_block_count = distribution->m_blocks.size();
+
+    if (active_block_count > 0)
+    {
+        for (double& c : distribution->m_cdf)
+            c /= weight_sum;
+
+        // Fix numerical errors so that sample_cdf() never runs past the end.
+        distribution->m_cdf.back() = 1.0;
+    }
+    else distribution.reset();
+
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+
+        // Once everything has converged, keep sampling according to the previous distribution.
+        if (distribution)
+            m_distribution = distribution;
+
+        m_active_block_count = active_block_count;
+        ++m_version;
+    }
+
+    return active_block_count == 0;
+}
+
+std::shared_ptr<const AdaptiveSampleScheduler::Distribution> AdaptiveSampleScheduler::get_distribution() const
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_distribution;
+}
+
+}   // namespace renderer
@@ -0,0 +1,148 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/atomic.h"
+#include "foundation/platform/thread.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace renderer
+{
+
+//
+// Steers progressive sampling toward the noisy regions of the crop window.
+//
+// The crop window is split into square blocks. The noise level and the
+// average sample count of each block are periodically measured and passed
+// to update(), which builds a new pixel distribution favoring the blocks
+// that have not converged yet. Sample generators pick up that distribution
+// lock-free via get_version() and only take the lock when it has changed.
+//
+
+class AdaptiveSampleScheduler
+  : public foundation::NonCopyable
+{
+  public:
+    struct Parameters
+    {
+        size_t  m_block_size;               // size in pixels of the square blocks
+        size_t  m_min_samples;              // minimum number of samples per pixel before a block may converge
+        size_t  m_max_samples;              // maximum number of samples per pixel, 0 for unlimited
+        float   m_noise_threshold;          // a block has converged when its noise falls below this value
+
+        Parameters();
+    };
+
+    // An immutable distribution of pixels over the blocks that are still active.
+    class Distribution
+    {
+      public:
+        // Map a point of [0,1)^2 to a pixel of the crop window, in canvas coordinates.
+        foundation::Vector2u sample(const foundation::Vector2d& s) const;
+
+      private:
+        friend class AdaptiveSampleScheduler;
+
+        std::vector<foundation::AABB2u>     m_blocks;
+        std::vector<double>                 m_cdf;
+    };
+
+    // Constructor.
+    AdaptiveSampleScheduler(
+        const foundation::AABB2u&           crop_window,
+        const Parameters&                   params);
+
+    const Parameters& get_parameters() const;
+
+    // Return the blocks, in scanline order and in canvas coordinates.
+    const std::vector<foundation::AABB2u>& get_blocks() const;
+
+    // Revert to uniform sampling of the crop window. Thread-safe.
+    void clear();
+
+    // Rebuild the pixel distribution from per-block noise levels and average sample
+    // counts, both indexed like get_blocks(). A noise level of infinity means unknown.
+    // Return true if all blocks have converged. Thread-safe.
+    bool update(
+        const std::vector<float>&           block_noise,
+        const std::vector<float>&           block_spp);
+
+    // Return the number of blocks that had not converged at the last update.
+    size_t get_active_block_count() const;
+
+    // Return a value that changes every time the distribution changes. Thread-safe.
+    std::uint32_t get_version() const;
+
+    // Return the current distribution, or null for uniform sampling. Thread-safe.
+    std::shared_ptr<const Distribution> get_distribution() const;
+
+  private:
+    const Parameters                        m_params;
+    std::vector<foundation::AABB2u>         m_blocks;
+    mutable boost::mutex                    m_mutex;
+    std::shared_ptr<const Distribution>     m_distribution;
+    boost::atomic<std::uint32_t>            m_version;
+    boost::atomic<size_t>                   m_active_block_count;
+};
+
+
+//
+// AdaptiveSampleScheduler class implementation.
+//
+
+inline const AdaptiveSampleScheduler::Parameters& AdaptiveSampleScheduler::get_parameters() const
+{
+    return m_params;
+}
+
+inline const std::vector<foundation::AABB2u>& AdaptiveSampleScheduler::get_blocks() const
+{
+    return m_blocks;
+}
+
+inline size_t AdaptiveSampleScheduler::get_active_block_count() const
+{
+    return m_active_block_count;
+}
+
+inline std::uint32_t AdaptiveSampleScheduler::get_version() const
+{
+    return m_version;
+}
+
+}   // namespace renderer
@@ -35,6 +35,8 @@
 #include "renderer/kernel/rendering/iframerenderer.h"
 #include "renderer/kernel/rendering/isamplegenerator.h"
 #include "renderer/kernel/rendering/itilecallback.h"
+#include "renderer/kernel/rendering/localsampleaccumulationbuffer.h"
+#include "renderer/kernel/rendering/progressive/adaptivesamplescheduler.h"
 #include "renderer/kernel/rendering/progressive/samplecounter.h"
 #include "renderer/kernel/rendering/progressive/samplecounthistory.h"
 #include "renderer/kernel/rendering/progressive/samplegeneratorjob.h"
@@ -422,6 +424,77 @@ namespace
     };
 
 
+    //
+    // Adaptive sampling thread.
+    //
+
+    class AdaptiveSamplingFunc
+      : public NonCopyable
+    {
+      public:
+        AdaptiveSamplingFunc(
+            LocalSampleAccumulationBuffer&  buffer,
+            AdaptiveSampleScheduler&        scheduler,
+            SampleCounter&                  sample_counter,
+            IAbortSwitch&                   abort_switch)
+          : m_buffer(buffer)
+          , m_scheduler(scheduler)
+          , m_sample_counter(sample_counter)
+          , m_abort_switch(abort_switch)
+        {
+        }
+
+        void pause()
+        {
+            m_pause_flag.set();
+        }
+
+        void resume()
+        {
+            m_pause_flag.clear();
+        }
+
+        void operator()()
+        {
+            set_current_thread_name("adaptive");
+
+            std::vector<float> block_noise;
+            std::vector<float> block_spp;
+
+            while (!m_abort_switch.is_aborted())
+            {
+                if (m_pause_flag.is_clear())
+                {
+                    // Measure the noise of every block and steer sample generators toward noisy blocks.
+                    m_buffer.estimate_block_noise(m_scheduler.get_blocks(), block_noise, block_spp);
+
+                    if (m_scheduler.update(block_noise, block_spp))
+                    {
+                        // Let rendering jobs run out of samples.
+                        RENDERER_LOG_INFO("all pixels have converged, stopping rendering.");
+                        m_sample_counter.stop();
+                        break;
+                    }
+
+                    RENDERER_LOG_DEBUG(
+                        "adaptive sampling: %s out of %s blocks still active",
+                        pretty_uint(m_scheduler.get_active_block_count()).c_str(),
+                        pretty_uint(m_scheduler.get_blocks().size()).c_str());
+                }
+
+                sleep(500, m_abort_switch);
+            }
+        }
+
+      private:
+        LocalSampleAccumulationBuffer&  m_buffer;
+        AdaptiveSampleScheduler&        m_scheduler;
+        SampleCounter&                  m_sample_counter;
+        IAbortSwitch&                   m_abort_switch;
+        ThreadFlag                      m_pause_flag;
+    };
+
+
     //
     // Progressive frame renderer.
     //
@@ -468,6 +541,27 @@ namespace
                     generator_factory->create(i, m_params.m_thread_count));
             }
 
+            // Set up adaptive sampling. Noise estimation requires a local accumulation buffer.
+            if (m_params.m_adaptive_sampling)
+            {
+                LocalSampleAccumulationBuffer* local_buffer =
+                    dynamic_cast<LocalSampleAccumulationBuffer*>(m_buffer.get());
+
+                if (local_buffer != nullptr)
+                {
+                    local_buffer->enable_noise_estimation();
+
+                    m_adaptive_sample_scheduler.reset(
+                        new AdaptiveSampleScheduler(
+                            project.get_frame()->get_crop_window(),
+                            m_params.m_adaptive_sampling_params));
+
+                    for (auto sample_generator : m_sample_generators)
+                        sample_generator->set_adaptive_sample_scheduler(m_adaptive_sample_scheduler.get());
+                }
+                else RENDERER_LOG_WARNING("adaptive sampling is not supported by this sample generator, disabling it.");
+            }
+
             // Create rendering jobs, one per rendering thread.
             m_sample_generator_jobs.reserve(m_params.m_thread_count);
             for (size_t i = 0; i < m_params.m_thread_count; ++i)
@@ -505,6 +599,10 @@ namespace
             if (m_statistics_thread.get() && m_statistics_thread->joinable())
                 m_statistics_thread->join();
 
+            // Stop the adaptive sampling thread.
+            if (m_adaptive_sampling_thread.get() && m_adaptive_sampling_thread->joinable())
+                m_adaptive_sampling_thread->join();
+
             // Stop the display thread.
             m_display_thread_abort_switch.abort();
             if (m_display_thread.get() && m_display_thread->joinable())
@@ -537,6 +635,7 @@ namespace
                 "  max average samples per pixel %s\n"
                 "  time limit                    %s\n"
                 "  max fps                       %f\n"
+                "  adaptive sampling             %s\n"
                 "  collect performance stats     %s\n"
                 "  collect luminance stats       %s",
                 get_spectrum_mode_name(m_params.m_spectrum_mode).c_str(),
@@ -549,6 +648,16 @@ namespace
                     ? "unlimited"
                     : pretty_time(m_params.m_time_limit).c_str(),
                 m_params.m_max_fps,
+                m_adaptive_sample_scheduler.get() != nullptr
+                    ? format(
+                        "on (block size {0}, min samples {1}, max samples {2}, noise threshold {3})",
+                        m_params.m_adaptive_sampling_params.m_block_size,
+                        m_params.m_adaptive_sampling_params.m_min_samples,
+                        m_params.m_adaptive_sampling_params.m_max_samples == 0
+                            ? "unlimited"
+                            : pretty_uint(m_params.m_adaptive_sampling_params.m_max_samples),
+                        m_params.m_adaptive_sampling_params.m_noise_threshold).c_str()
+                    : "off",
                 m_params.m_perf_stats ? "on" : "off",
                 m_params.m_luminance_stats ? "on" : "off");
 
@@ -581,6 +690,9 @@ namespace
             m_buffer->clear();
             m_sample_counter.clear();
 
+            if (m_adaptive_sample_scheduler.get())
+                m_adaptive_sample_scheduler->clear();
+
             m_sample_count_history_spinlock.lock();
             m_sample_count_history.clear();
             m_sample_count_history_spinlock.unlock();
@@ -616,6 +728,20 @@ namespace
                 new boost::thread(
                     ThreadFunctionWrapper<StatisticsFunc>(m_statistics_func.get())));
 
+            // Create and start the adaptive sampling thread.
+            if (m_adaptive_sample_scheduler.get())
+            {
+                m_adaptive_sampling_func.reset(
+                    new AdaptiveSamplingFunc(
+                        static_cast<LocalSampleAccumulationBuffer&>(*m_buffer),
+                        *m_adaptive_sample_scheduler,
+                        m_sample_counter,
+                        m_abort_switch));
+                m_adaptive_sampling_thread.reset(
+                    new boost::thread(
+                        ThreadFunctionWrapper<AdaptiveSamplingFunc>(m_adaptive_sampling_func.get())));
+            }
+
             // Create and start the display thread.
             if (m_tile_callback.get() != nullptr && m_display_thread.get() == nullptr)
             {
@@ -642,7 +768,7 @@ namespace
             // First, delete scheduled jobs to prevent worker threads from picking them up.
             m_job_queue.clear_scheduled_jobs();
 
-            // Tell rendering jobs and the statistics thread to stop.
+            // Tell rendering jobs, the statistics thread and the adaptive sampling thread to stop.
             m_abort_switch.abort();
 
             // Wait until rendering jobs have effectively stopped.
@@ -650,6 +776,10 @@ namespace
 
             // Wait until the statistics thread has stopped.
             m_statistics_thread->join();
+
+            // Wait until the adaptive sampling thread has stopped.
+            if (m_adaptive_sampling_thread.get())
+                m_adaptive_sampling_thread->join();
         }
 
         void pause_rendering() override
@@ -660,10 +790,16 @@ namespace
                 m_display_func->pause();
 
             m_statistics_func->pause();
+
+            if (m_adaptive_sampling_func.get())
+                m_adaptive_sampling_func->pause();
         }
 
         void resume_rendering() override
         {
+            if (m_adaptive_sampling_func.get())
+                m_adaptive_sampling_func->resume();
+
             m_statistics_func->resume();
 
             if (m_display_func.get())
@@ -682,6 +818,10 @@ namespace
             m_statistics_thread.reset();
             m_statistics_func.reset();
 
+            // So has the adaptive sampling thread.
+            m_adaptive_sampling_thread.reset();
+            m_adaptive_sampling_func.reset();
+
             // Join and delete the display thread.
             if (m_display_thread.get())
             {
@@ -721,7 +861,9 @@ namespace
             const double                            m_max_fps;            // maximum display frequency in frames/second
             const bool                              m_perf_stats;         // collect and print performance statistics?
             const bool                              m_luminance_stats;    // collect and print luminance statistics?
+            const bool                              m_adaptive_sampling;  // steer samples toward noisy regions?
             SampleGeneratorJob::SamplingProfile     m_sampling_profile;
+            AdaptiveSampleScheduler::Parameters     m_adaptive_sampling_params;
 
             explicit Parameters(const ParamArray& params)
               : m_spectrum_mode(get_spectrum_mode(params))
@@ -732,6 +874,7 @@ namespace
               , m_max_fps(params.get_optional<double>("max_fps", 30.0))
               , m_perf_stats(params.get_optional<bool>("performance_statistics", false))
               , m_luminance_stats(params.get_optional<bool>("luminance_statistics", false))
+              , m_adaptive_sampling(params.get_optional<bool>("adaptive_sampling", false))
             {
                 const SampleGeneratorJob::SamplingProfile default_sampling_profile;
                 m_sampling_profile.m_samples_in_uninterruptible_phase =
@@ -744,6 +887,16 @@ namespace
                     params.get_optional<std::uint64_t>("max_samples_per_job_in_exponential_phase", default_sampling_profile.m_max_samples_per_job_in_exponential_phase);
                 m_sampling_profile.m_curve_exponent_in_exponential_phase =
                     params.get_optional<double>("curve_exponent_in_exponential_phase", default_sampling_profile.m_curve_exponent_in_exponential_phase);
+
+                const AdaptiveSampleScheduler::Parameters default_adaptive_sampling_params;
+                m_adaptive_sampling_params.m_block_size =
+                    std::max<size_t>(params.get_optional<size_t>("block_size", default_adaptive_sampling_params.m_block_size), 1);
+                m_adaptive_sampling_params.m_min_samples =
+                    params.get_optional<size_t>("min_samples", default_adaptive_sampling_params.m_min_samples);
+                m_adaptive_sampling_params.m_max_samples =
+                    params.get_optional<size_t>("max_samples", default_adaptive_sampling_params.m_max_samples);
+                m_adaptive_sampling_params.m_noise_threshold =
+                    params.get_optional<float>("noise_threshold", default_adaptive_sampling_params.m_noise_threshold);
             }
         };
 
@@ -775,6 +928,10 @@ namespace
         std::unique_ptr<StatisticsFunc>             m_statistics_func;
         std::unique_ptr<boost::thread>              m_statistics_thread;
 
+        std::unique_ptr<AdaptiveSampleScheduler>    m_adaptive_sample_scheduler;
+        std::unique_ptr<AdaptiveSamplingFunc>       m_adaptive_sampling_func;
+        std::unique_ptr<boost::thread>              m_adaptive_sampling_thread;
+
         TimedRendererController                     m_renderer_controller;
 
         void print_sample_generators_stats() const
@@ -826,6 +983,54 @@ Dictionary ProgressiveFrameRendererFactory::get_params_metadata()
             .insert("label", "Time Limit:")
             .insert("help", "Maximum rendering time"));
 
+    metadata.dictionaries().insert(
+        "adaptive_sampling",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Adaptive Sampling")
+            .insert("help", "Concentrate samples in noisy regions and stop once the whole image has converged"));
+
+    metadata.dictionaries().insert(
+        "block_size",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "16")
+            .insert("min", "1")
+            .insert("max", "1024")
+            .insert("label", "Block Size")
+            .insert("help", "Size in pixels of the blocks whose noise is estimated"));
+
+    metadata.dictionaries().insert(
+        "min_samples",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "16")
+            .insert("min", "0")
+            .insert("max", "1000000")
+            .insert("label", "Min Samples")
+            .insert("help", "Minimum number of samples per pixel before a block may be considered converged"));
+
+    metadata.dictionaries().insert(
+        "max_samples",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "256")
+            .insert("min", "0")
+            .insert("max", "1000000")
+            .insert("label", "Max Samples")
+            .insert("help", "Number of samples per pixel after which a block is considered converged (0 for unlimited)"));
+
+    metadata.dictionaries().insert(
+        "noise_threshold",
+        Dictionary()
+            .insert("type", "float")
+            .insert("default", "0.02")
+            .insert("min", "0.0001")
+            .insert("max", "10000.0")
+            .insert("label", "Noise Threshold")
+            .insert("help", "Maximum amount of noise allowed in the image"));
+
     return metadata;
 }
 
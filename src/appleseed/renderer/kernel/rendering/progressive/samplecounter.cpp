@@ -42,12 +42,14 @@ namespace renderer
 SampleCounter::SampleCounter(const std::uint64_t max_sample_count)
   : m_max_sample_count(max_sample_count)
   , m_sample_count(0)
+  , m_stopped(false)
 {
 }
 
 void SampleCounter::clear()
 {
     m_sample_count = 0;
+    m_stopped = false;
 }
 
 std::uint64_t SampleCounter::read() const
@@ -57,6 +59,9 @@ std::uint64_t SampleCounter::read() const
 
 std::uint64_t SampleCounter::reserve(const std::uint64_t n)
 {
+    if (m_stopped)
+        return 0;
+
     while (true)
     {
         std::uint64_t current = m_sample_count;
@@ -68,4 +73,9 @@ std::uint64_t SampleCounter::reserve(const std::uint64_t n)
     }
 }
 
+void SampleCounter::stop()
+{
+    m_stopped = true;
+}
+
 }   // namespace renderer
@@ -55,9 +55,13 @@ class SampleCounter
 
     std::uint64_t reserve(const std::uint64_t n);
 
+    // Make all subsequent reservations fail until the next call to clear().
+    void stop();
+
   private:
     const std::uint64_t             m_max_sample_count;
     boost::atomic<std::uint64_t>    m_sample_count;
+    boost::atomic<bool>             m_stopped;
 };
 
 }   // namespace renderer
@@ -154,9 +154,9 @@ void SampleGeneratorJob::execute(const size_t thread_index)
         pretty_time(t2 - t1).c_str());
 #endif
 
-    // Reschedule this job.
+    // Reschedule this job, preferably on the same worker thread.
     if (!abortable || !m_abort_switch.is_aborted())
-        m_job_queue.schedule(this, false);
+        m_job_queue.schedule(this, false, thread_index);
 }
 
 }   // namespace renderer
@@ -172,6 +172,17 @@ bool RendererComponents::on_frame_begin(
     return true;
 }
 
+bool RendererComponents::update_light_samplers()
+{
+    // The forward light sampler is only built when rendering is initialized.
+    if (m_forward_light_sampler.get() != nullptr)
+        return false;
+
+    return
+        m_backward_light_sampler.get() != nullptr &&
+        m_backward_light_sampler->update(m_scene);
+}
+
 bool RendererComponents::create_lighting_engine_factory()
 {
     const std::string name = m_params.get_required<std::string>("lighting_engine", "pt");
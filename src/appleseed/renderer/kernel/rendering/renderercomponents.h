@@ -98,6 +98,10 @@ class RendererComponents
         OnFrameBeginRecorder&       recorder,
         foundation::IAbortSwitch*   abort_switch = nullptr);
 
+    // Update light samplers after light emitters have moved.
+    // Return false if they cannot be updated in place.
+    bool update_light_samplers();
+
     // Retrieve individual components.
     const TraceContext& get_trace_context() const;
     BackwardLightSampler* get_backward_light_sampler() const;
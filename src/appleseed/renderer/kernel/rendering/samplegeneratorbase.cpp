@@ -70,6 +70,11 @@ void SampleGeneratorBase::reset()
     m_invalid_sample_count = 0;
 }
 
+void SampleGeneratorBase::set_adaptive_sample_scheduler(
+    const AdaptiveSampleScheduler*  scheduler)
+{
+}
+
 void SampleGeneratorBase::generate_samples(
     const size_t                sample_count,
     SampleAccumulationBuffer&   buffer,
@@ -60,6 +60,10 @@ class SampleGeneratorBase
     // Reset the sample generator to its initial state.
     void reset() override;
 
+    // Ignore the adaptive sample scheduler and keep sampling uniformly.
+    void set_adaptive_sample_scheduler(
+        const AdaptiveSampleScheduler*  scheduler) override;
+
     // Generate a given number of samples and accumulate them into a buffer.
     void generate_samples(
         const size_t                sample_count,
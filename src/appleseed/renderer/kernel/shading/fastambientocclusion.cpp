@@ -209,11 +209,11 @@ void AOVoxelTree::build(
             const StaticTriangleTess& tess = mesh.get_static_triangle_tess();
 
             // Push all triangles of the mesh into the tree.
-            const size_t triangle_count = tess.m_primitives.size();
+            const size_t triangle_count = tess.get_primitive_count();
             for (size_t triangle_index = 0; triangle_index < triangle_count; ++triangle_index)
             {
                 // Fetch the triangle.
-                const Triangle& triangle = tess.m_primitives[triangle_index];
+                const Triangle triangle = tess.get_primitive(triangle_index);
 
                 // Retrieve object instance space vertices of the triangle.
                 const GVector3& v0_os = tess.m_vertices[triangle.m_v0];
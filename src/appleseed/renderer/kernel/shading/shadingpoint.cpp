@@ -196,8 +196,8 @@ void ShadingPoint::fetch_triangle_source_geometry() const
     const GScalar frac = static_cast<GScalar>(base_time - base_index);
     const GScalar one_minus_frac = GScalar(1.0) - frac;
 
-    // Retrieve the triangle.
-    const Triangle& triangle = tess.m_primitives[m_primitive_index];
+    // Retrieve the triangle, decoding it if the tessellation uses compact storage.
+    const Triangle triangle = tess.get_primitive(m_primitive_index);
     assert(triangle.m_v0 != Triangle::None);
     assert(triangle.m_v1 != Triangle::None);
     assert(triangle.m_v2 != Triangle::None);
@@ -265,9 +265,9 @@ void ShadingPoint::fetch_triangle_source_geometry() const
             // Fetch vertex normals from previous pose.
             if (base_index == 0)
             {
-                m_n0 = tess.m_vertex_normals[triangle.m_n0];
-                m_n1 = tess.m_vertex_normals[triangle.m_n1];
-                m_n2 = tess.m_vertex_normals[triangle.m_n2];
+                m_n0 = tess.get_vertex_normal(triangle.m_n0);
+                m_n1 = tess.get_vertex_normal(triangle.m_n1);
+                m_n2 = tess.get_vertex_normal(triangle.m_n2);
             }
             else
             {
@@ -292,9 +292,9 @@ void ShadingPoint::fetch_triangle_source_geometry() const
         }
         else
         {
-            m_n0 = tess.m_vertex_normals[triangle.m_n0];
-            m_n1 = tess.m_vertex_normals[triangle.m_n1];
-            m_n2 = tess.m_vertex_normals[triangle.m_n2];
+            m_n0 = tess.get_vertex_normal(triangle.m_n0);
+            m_n1 = tess.get_vertex_normal(triangle.m_n1);
+            m_n2 = tess.get_vertex_normal(triangle.m_n2);
         }
 
         assert(is_normalized(m_n0));
@@ -561,11 +561,13 @@ void ShadingPoint::compute_world_space_partial_derivatives() const
 
             const GScalar v = m_bary[1];
 
+            // Evaluate the tangent on the curve as it was at the time of the ray.
             const CurveObject* curves = static_cast<const CurveObject*>(m_object);
+            const double time = m_ray.m_time.m_normalized;
             const GVector3 tangent =
                 m_primitive_type == PrimitiveCurve1
-                    ? curves->get_curve1(m_primitive_index).evaluate_tangent(v)
-                    : curves->get_curve3(m_primitive_index).evaluate_tangent(v);
+                    ? curves->interpolate_curve1(m_primitive_index, time).evaluate_tangent(v)
+                    : curves->interpolate_curve3(m_primitive_index, time).evaluate_tangent(v);
 
             const Vector3d& sn = get_original_shading_normal();
 
@@ -884,7 +886,7 @@ void ShadingPoint::compute_world_space_point_velocity() const
         const StaticTriangleTess& tess = mesh.get_static_triangle_tess();
 
         // Retrieve the triangle.
-        const Triangle& triangle = tess.m_primitives[m_primitive_index];
+        const Triangle triangle = tess.get_primitive(m_primitive_index);
         assert(triangle.m_v0 != Triangle::None);
         assert(triangle.m_v1 != Triangle::None);
         assert(triangle.m_v2 != Triangle::None);
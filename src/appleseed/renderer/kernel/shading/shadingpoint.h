@@ -270,15 +270,19 @@ class ShadingPoint
     };
 
   private:
+    friend class AnyHitContext;
+    friend class AssemblyLeafPacketVisitor;
     friend class AssemblyLeafProbeVisitor;
     friend class AssemblyLeafVisitor;
     friend class CurveLeafVisitor;
+    friend class CurveObjectLeafVisitor;
     friend class EmbreeScene;
     friend class Intersector;
     friend class NPRSurfaceShaderHelper;
     friend class OSLShaderGroupExec;
     friend class RendererServices;
     friend class ShadingPointBuilder;
+    friend class TriangleLeafPacketVisitor;
     friend class TriangleLeafVisitor;
     friend class foundation::PoisonImpl<ShadingPoint>;
 
@@ -35,6 +35,8 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/compressedunitvector.h"
+#include "foundation/math/half.h"
 #include "foundation/utility/attributeset.h"
 #include "foundation/utility/lazy.h"
 #include "foundation/utility/numerictype.h"
@@ -58,19 +60,26 @@ class StaticTessellation
   : public foundation::NonCopyable
 {
   public:
-    // Primitive type.
+    // Primitive types.
     typedef Primitive PrimitiveType;
+    typedef typename Primitive::CompactType CompactPrimitiveType;
 
     // Vertex and primitive array types.
     // todo: use paged arrays?
     typedef std::vector<GVector3> VectorArray;
+    typedef std::vector<foundation::CompressedUnitVector> CompressedVectorArray;
     typedef std::vector<PrimitiveType> PrimitiveArray;
+    typedef std::vector<CompactPrimitiveType> CompactPrimitiveArray;
 
     // Primary features.
     VectorArray                 m_vertices;
     VectorArray                 m_vertex_normals;
     PrimitiveArray              m_primitives;
 
+    // Compact primary features, only populated by compact().
+    CompressedVectorArray       m_compressed_vertex_normals;
+    CompactPrimitiveArray       m_compact_primitives;
+
     // Additional attributes.
     // todo: we could live with a single attribute set with multiple channels.
     foundation::AttributeSet    m_tessellation_attributes;
@@ -83,11 +92,30 @@ class StaticTessellation
     // Constructor.
     StaticTessellation();
 
+    // Switch to compact storage: vertex normals and tangents are octahedral-encoded
+    // on 32 bits, texture coordinates are stored as half-precision floats and, if all
+    // primitives allow it, primitives only keep their vertex indices. Poses are left
+    // untouched. No feature can be inserted or modified after this call.
+    void compact();
+    bool is_compact() const;
+
+    // Switch back to regular storage, decoding all compact features. Decoded normals,
+    // tangents and texture coordinates keep the precision loss of their compact encoding.
+    void expand();
+
+    // Access primitives and vertex normals regardless of the storage mode.
+    size_t get_primitive_count() const;
+    PrimitiveType get_primitive(const size_t index) const;
+    size_t get_vertex_normal_count() const;
+    GVector3 get_vertex_normal(const size_t index) const;
+
     // Insert and access texture coordinates.
     void reserve_tex_coords(const size_t count);
     size_t push_tex_coords(const GVector2& uv);
+    size_t push_tex_coords_array(const GVector2 uvs[], const size_t count);
     size_t get_tex_coords_count() const;
     GVector2 get_tex_coords(const size_t index) const;
+    void clear_tex_coords();
 
     // Insert and access vertex tangents.
     void reserve_vertex_tangents(const size_t count);
@@ -152,6 +180,11 @@ class StaticTessellation
     foundation::AttributeSet::ChannelID m_vnp_cid;          // vertex normal poses
     foundation::AttributeSet::ChannelID m_vtp_cid;          // vertex tangent poses
 
+    // Compact secondary features, only populated by compact().
+    CompressedVectorArray       m_compressed_vertex_tangents;
+    std::vector<foundation::Half> m_half_tex_coords;       // two halves per texture coordinates
+    bool                        m_compact;
+
     void create_uv_0_attribute();
     void create_tangents_attribute();
 };
@@ -184,12 +217,163 @@ inline StaticTessellation<Primitive>::StaticTessellation()
   , m_vp_cid(foundation::AttributeSet::InvalidChannelID)
   , m_vnp_cid(foundation::AttributeSet::InvalidChannelID)
   , m_vtp_cid(foundation::AttributeSet::InvalidChannelID)
+  , m_compact(false)
+{
+}
+
+template <typename Primitive>
+void StaticTessellation<Primitive>::compact()
+{
+    if (m_compact)
+        return;
+
+    m_compact = true;
+
+    // Vertex normals.
+    m_compressed_vertex_normals.reserve(m_vertex_normals.size());
+    for (const GVector3& n : m_vertex_normals)
+        m_compressed_vertex_normals.emplace_back(foundation::Vector3f(n));
+    VectorArray().swap(m_vertex_normals);
+
+    // Vertex tangents.
+    if (m_tangents_cid != foundation::AttributeSet::InvalidChannelID)
+    {
+        const size_t tangent_count = m_vertex_attributes.get_attribute_count(m_tangents_cid);
+        m_compressed_vertex_tangents.reserve(tangent_count);
+
+        for (size_t i = 0; i < tangent_count; ++i)
+        {
+            GVector3 tangent;
+            m_vertex_attributes.get_attribute(m_tangents_cid, i, &tangent);
+            m_compressed_vertex_tangents.emplace_back(foundation::Vector3f(tangent));
+        }
+
+        m_vertex_attributes.delete_channel(m_tangents_cid);
+        m_tangents_cid = foundation::AttributeSet::InvalidChannelID;
+    }
+
+    // Texture coordinates.
+    if (m_uv_0_cid != foundation::AttributeSet::InvalidChannelID)
+    {
+        const size_t uv_count = m_vertex_attributes.get_attribute_count(m_uv_0_cid);
+        m_half_tex_coords.reserve(2 * uv_count);
+
+        for (size_t i = 0; i < uv_count; ++i)
+        {
+            GVector2 uv;
+            m_vertex_attributes.get_attribute(m_uv_0_cid, i, &uv);
+            m_half_tex_coords.push_back(foundation::Half(uv[0]));
+            m_half_tex_coords.push_back(foundation::Half(uv[1]));
+        }
+
+        m_vertex_attributes.delete_channel(m_uv_0_cid);
+        m_uv_0_cid = foundation::AttributeSet::InvalidChannelID;
+    }
+
+    // Primitives. Either all of them are compacted or none of them is.
+    for (const PrimitiveType& primitive : m_primitives)
+    {
+        if (!CompactPrimitiveType::can_represent(primitive))
+            return;
+    }
+
+    m_compact_primitives.reserve(m_primitives.size());
+    for (const PrimitiveType& primitive : m_primitives)
+        m_compact_primitives.emplace_back(primitive);
+    PrimitiveArray().swap(m_primitives);
+}
+
+template <typename Primitive>
+void StaticTessellation<Primitive>::expand()
 {
+    if (!m_compact)
+        return;
+
+    m_compact = false;
+
+    // Vertex normals.
+    m_vertex_normals.reserve(m_compressed_vertex_normals.size());
+    for (const foundation::CompressedUnitVector& n : m_compressed_vertex_normals)
+        m_vertex_normals.emplace_back(foundation::Vector3f(n));
+    CompressedVectorArray().swap(m_compressed_vertex_normals);
+
+    // Vertex tangents.
+    if (!m_compressed_vertex_tangents.empty())
+    {
+        create_tangents_attribute();
+        m_vertex_attributes.reserve_attributes(m_tangents_cid, m_compressed_vertex_tangents.size());
+
+        for (const foundation::CompressedUnitVector& t : m_compressed_vertex_tangents)
+            m_vertex_attributes.push_attribute(m_tangents_cid, GVector3(foundation::Vector3f(t)));
+
+        CompressedVectorArray().swap(m_compressed_vertex_tangents);
+    }
+
+    // Texture coordinates.
+    if (!m_half_tex_coords.empty())
+    {
+        const size_t uv_count = m_half_tex_coords.size() / 2;
+
+        create_uv_0_attribute();
+        m_vertex_attributes.reserve_attributes(m_uv_0_cid, uv_count);
+
+        for (size_t i = 0; i < uv_count; ++i)
+        {
+            const GVector2 uv(m_half_tex_coords[2 * i + 0], m_half_tex_coords[2 * i + 1]);
+            m_vertex_attributes.push_attribute(m_uv_0_cid, uv);
+        }
+
+        std::vector<foundation::Half>().swap(m_half_tex_coords);
+    }
+
+    // Primitives.
+    m_primitives.reserve(m_compact_primitives.size());
+    for (const CompactPrimitiveType& primitive : m_compact_primitives)
+        m_primitives.push_back(primitive.expand());
+    CompactPrimitiveArray().swap(m_compact_primitives);
+}
+
+template <typename Primitive>
+inline bool StaticTessellation<Primitive>::is_compact() const
+{
+    return m_compact;
+}
+
+template <typename Primitive>
+inline size_t StaticTessellation<Primitive>::get_primitive_count() const
+{
+    return m_compact_primitives.empty() ? m_primitives.size() : m_compact_primitives.size();
+}
+
+template <typename Primitive>
+inline Primitive StaticTessellation<Primitive>::get_primitive(const size_t index) const
+{
+    return
+        m_compact_primitives.empty()
+            ? m_primitives[index]
+            : m_compact_primitives[index].expand();
+}
+
+template <typename Primitive>
+inline size_t StaticTessellation<Primitive>::get_vertex_normal_count() const
+{
+    return m_compact ? m_compressed_vertex_normals.size() : m_vertex_normals.size();
+}
+
+template <typename Primitive>
+inline GVector3 StaticTessellation<Primitive>::get_vertex_normal(const size_t index) const
+{
+    return
+        m_compact
+            ? GVector3(foundation::Vector3f(m_compressed_vertex_normals[index]))
+            : m_vertex_normals[index];
 }
 
 template <typename Primitive>
 inline void StaticTessellation<Primitive>::reserve_tex_coords(const size_t count)
 {
+    assert(!m_compact);
+
     if (m_uv_0_cid == foundation::AttributeSet::InvalidChannelID)
         create_uv_0_attribute();
 
@@ -199,15 +383,31 @@ inline void StaticTessellation<Primitive>::reserve_tex_coords(const size_t count
 template <typename Primitive>
 inline size_t StaticTessellation<Primitive>::push_tex_coords(const GVector2& uv)
 {
+    assert(!m_compact);
+
     if (m_uv_0_cid == foundation::AttributeSet::InvalidChannelID)
         create_uv_0_attribute();
 
     return m_vertex_attributes.push_attribute(m_uv_0_cid, uv);
 }
 
+template <typename Primitive>
+inline size_t StaticTessellation<Primitive>::push_tex_coords_array(const GVector2 uvs[], const size_t count)
+{
+    assert(!m_compact);
+
+    if (m_uv_0_cid == foundation::AttributeSet::InvalidChannelID)
+        create_uv_0_attribute();
+
+    return m_vertex_attributes.push_attributes(m_uv_0_cid, uvs, count);
+}
+
 template <typename Primitive>
 inline size_t StaticTessellation<Primitive>::get_tex_coords_count() const
 {
+    if (m_compact)
+        return m_half_tex_coords.size() / 2;
+
     if (m_uv_0_cid == foundation::AttributeSet::InvalidChannelID)
         return 0;
 
@@ -217,6 +417,14 @@ inline size_t StaticTessellation<Primitive>::get_tex_coords_count() const
 template <typename Primitive>
 inline GVector2 StaticTessellation<Primitive>::get_tex_coords(const size_t index) const
 {
+    if (m_compact)
+    {
+        return
+            GVector2(
+                m_half_tex_coords[2 * index + 0],
+                m_half_tex_coords[2 * index + 1]);
+    }
+
     assert(m_uv_0_cid != foundation::AttributeSet::InvalidChannelID);
 
     GVector2 uv;
@@ -225,9 +433,23 @@ inline GVector2 StaticTessellation<Primitive>::get_tex_coords(const size_t index
     return uv;
 }
 
+template <typename Primitive>
+void StaticTessellation<Primitive>::clear_tex_coords()
+{
+    m_half_tex_coords.clear();
+
+    if (m_uv_0_cid != foundation::AttributeSet::InvalidChannelID)
+    {
+        m_vertex_attributes.delete_channel(m_uv_0_cid);
+        m_uv_0_cid = foundation::AttributeSet::InvalidChannelID;
+    }
+}
+
 template <typename Primitive>
 inline void StaticTessellation<Primitive>::reserve_vertex_tangents(const size_t count)
 {
+    assert(!m_compact);
+
     if (m_tangents_cid == foundation::AttributeSet::InvalidChannelID)
         create_tangents_attribute();
 
@@ -237,6 +459,8 @@ inline void StaticTessellation<Primitive>::reserve_vertex_tangents(const size_t
 template <typename Primitive>
 inline size_t StaticTessellation<Primitive>::push_vertex_tangent(const GVector3& tangent)
 {
+    assert(!m_compact);
+
     if (m_tangents_cid == foundation::AttributeSet::InvalidChannelID)
         create_tangents_attribute();
 
@@ -246,6 +470,9 @@ inline size_t StaticTessellation<Primitive>::push_vertex_tangent(const GVector3&
 template <typename Primitive>
 inline size_t StaticTessellation<Primitive>::get_vertex_tangent_count() const
 {
+    if (m_compact)
+        return m_compressed_vertex_tangents.size();
+
     if (m_tangents_cid == foundation::AttributeSet::InvalidChannelID)
         return 0;
 
@@ -255,6 +482,9 @@ inline size_t StaticTessellation<Primitive>::get_vertex_tangent_count() const
 template <typename Primitive>
 inline GVector3 StaticTessellation<Primitive>::get_vertex_tangent(const size_t index) const
 {
+    if (m_compact)
+        return GVector3(foundation::Vector3f(m_compressed_vertex_tangents[index]));
+
     assert(m_tangents_cid != foundation::AttributeSet::InvalidChannelID);
 
     GVector3 tangent;
@@ -352,7 +582,7 @@ inline void StaticTessellation<Primitive>::set_vertex_normal_pose(
     const size_t    motion_segment_index,
     const GVector3& normal)
 {
-    assert(normal_index < m_vertex_normals.size());
+    assert(normal_index < get_vertex_normal_count());
 
     const size_t motion_segment_count = get_motion_segment_count();
     assert(motion_segment_index < motion_segment_count);
@@ -378,7 +608,7 @@ inline GVector3 StaticTessellation<Primitive>::get_vertex_normal_pose(
     const size_t    motion_segment_index) const
 {
     assert(m_vnp_cid != foundation::AttributeSet::InvalidChannelID);
-    assert(normal_index < m_vertex_normals.size());
+    assert(normal_index < get_vertex_normal_count());
 
     const size_t motion_segment_count = get_motion_segment_count();
     assert(motion_segment_index < motion_segment_count);
@@ -434,7 +664,7 @@ inline GVector3 StaticTessellation<Primitive>::get_vertex_tangent_pose(
     const size_t    motion_segment_index) const
 {
     assert(m_vtp_cid != foundation::AttributeSet::InvalidChannelID);
-    assert(tangent_index < m_vertex_normals.size());
+    assert(tangent_index < get_vertex_tangent_count());
 
     const size_t motion_segment_count = get_motion_segment_count();
     assert(motion_segment_index < motion_segment_count);
@@ -38,9 +38,12 @@
 #include "renderer/utility/paramarray.h"
 
 // appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
 #include "foundation/image/color.h"
 #include "foundation/image/colorspace.h"
+#include "foundation/image/pixel.h"
 #include "foundation/image/tile.h"
+#include "foundation/math/population.h"
 #include "foundation/platform/types.h"
 #include "foundation/utility/api/apistring.h"
 #include "foundation/utility/containers/dictionary.h"
@@ -80,22 +83,235 @@ size_t TextureStore::get_default_size()
     return 1024 * 1024 * 1024;
 }
 
+size_t TextureStore::get_level_count(const CanvasProperties& props)
+{
+    size_t level_count = 1;
+
+    while (get_level_size(props.m_canvas_width, level_count - 1) > 1 ||
+           get_level_size(props.m_canvas_height, level_count - 1) > 1)
+        ++level_count;
+
+    return level_count;
+}
+
 TextureStore::TextureStore(
     const Scene&        scene,
     const ParamArray&   params)
-  : m_tile_swapper(scene, params)
-  , m_tile_cache(m_tile_key_hasher, m_tile_swapper)
+  : m_scene(scene)
 {
+    gather_assemblies(scene.assemblies());
+
+    m_shards.reserve(ShardCount);
+
+    for (size_t i = 0; i < ShardCount; ++i)
+    {
+        m_shards.push_back(
+            std::unique_ptr<Shard>(
+                new Shard(*this, params, m_memory_tracker, m_tile_key_hasher)));
+    }
+
+    m_shards[0]->m_tile_swapper.print_settings();
 }
 
 StatisticsVector TextureStore::get_statistics() const
 {
-    Statistics stats = make_single_stage_cache_stats(m_tile_cache);
-    stats.insert_size("peak size", m_tile_swapper.get_peak_memory_size());
+    std::uint64_t hit_count = 0;
+    std::uint64_t miss_count = 0;
+    std::uint64_t contention_count = 0;
+    Population<std::uint64_t> shard_acquisitions;
+    Population<std::uint64_t> shard_contentions;
+
+    for (const auto& shard : m_shards)
+    {
+        // Shard counters are updated under the shard lock, possibly while rendering.
+        std::uint64_t shard_hit_count, shard_miss_count, shard_contention_count;
+        {
+            boost::mutex::scoped_lock lock(shard->m_mutex);
+            shard_hit_count = shard->m_tile_cache.get_hit_count();
+            shard_miss_count = shard->m_tile_cache.get_miss_count();
+            shard_contention_count = shard->m_contention_count;
+        }
+
+        hit_count += shard_hit_count;
+        miss_count += shard_miss_count;
+        contention_count += shard_contention_count;
+
+        shard_acquisitions.insert(shard_hit_count + shard_miss_count);
+        shard_contentions.insert(shard_contention_count);
+    }
+
+    Statistics stats;
+    stats.insert(
+        std::unique_ptr<cache_impl::CacheStatisticsEntry>(
+            new cache_impl::CacheStatisticsEntry(
+                "performance",
+                hit_count,
+                miss_count)));
+    stats.insert_size("peak size", m_memory_tracker.get_peak_size());
+    stats.insert("shards", m_shards.size());
+    stats.insert_percent("contended acquisitions", contention_count, hit_count + miss_count);
+    stats.insert("acquisitions per shard", shard_acquisitions);
+    stats.insert("contentions per shard", shard_contentions);
+
     return StatisticsVector::make("texture store statistics", stats);
 }
 
 
+void TextureStore::gather_assemblies(const AssemblyContainer& assemblies)
+{
+    for (const Assembly& assembly : assemblies)
+    {
+        m_assemblies[assembly.get_uid()] = &assembly;
+        gather_assemblies(assembly.assemblies());
+    }
+}
+
+Texture* TextureStore::get_texture(const TileKey& key) const
+{
+    // Fetch the texture container.
+    const TextureContainer* textures;
+    if (key.m_assembly_uid == ~UniqueID(0))
+        textures = &m_scene.textures();
+    else
+    {
+        const AssemblyMap::const_iterator i = m_assemblies.find(key.m_assembly_uid);
+        assert(i != m_assemblies.end());
+        textures = &i->second->textures();
+    }
+
+    // Fetch the texture.
+    return textures->get_by_uid(key.m_texture_uid);
+}
+
+TextureStore::TileRecord& TextureStore::acquire_mip_tile(const TileKey& key)
+{
+    assert(key.m_level > 0);
+
+    Shard& shard = get_shard(key);
+
+    // Look for the tile in the store.
+    {
+        boost::mutex::scoped_lock lock(shard.m_mutex, boost::try_to_lock);
+        if (!lock.owns_lock())
+        {
+            lock.lock();
+            ++shard.m_contention_count;
+        }
+
+        TileRecord* record = shard.m_tile_cache.find(key);
+        if (record)
+        {
+            record->m_owners.fetch_add(1, boost::memory_order_relaxed);
+            return *record;
+        }
+    }
+
+    // Acquire the (up to) four tiles of the finer level covered by this tile.
+    // No lock is held at this point, such that a thread never holds the locks
+    // of two shards at the same time.
+    Texture* texture = get_texture(key);
+    assert(texture != nullptr);
+    const CanvasProperties& props = texture->properties();
+    const size_t source_level = key.m_level - 1;
+    const size_t source_tile_count_x =
+        (get_level_size(props.m_canvas_width, source_level) + props.m_tile_width - 1) / props.m_tile_width;
+    const size_t source_tile_count_y =
+        (get_level_size(props.m_canvas_height, source_level) + props.m_tile_height - 1) / props.m_tile_height;
+
+    const TileRecord* source_records[4];
+
+    for (size_t y = 0; y < 2; ++y)
+    {
+        for (size_t x = 0; x < 2; ++x)
+        {
+            const size_t source_tile_x = key.get_tile_x() * 2 + x;
+            const size_t source_tile_y = key.get_tile_y() * 2 + y;
+
+            source_records[y * 2 + x] =
+                source_tile_x < source_tile_count_x && source_tile_y < source_tile_count_y
+                    ? &acquire(
+                          TileKey(
+                              key.m_assembly_uid,
+                              key.m_texture_uid,
+                              source_tile_x,
+                              source_tile_y,
+                              source_level))
+                    : nullptr;
+        }
+    }
+
+    // Build the tile, unless another thread did it in the meantime.
+    TileRecord* record;
+    {
+        boost::mutex::scoped_lock lock(shard.m_mutex);
+
+        shard.m_tile_swapper.set_source_tiles(source_records, 4);
+        record = &shard.m_tile_cache.get(key);
+        record->m_owners.fetch_add(1, boost::memory_order_relaxed);
+        shard.m_tile_swapper.set_source_tiles(nullptr, 0);
+    }
+
+    // Release the tiles of the finer level.
+    for (size_t i = 0; i < 4; ++i)
+    {
+        if (source_records[i] != nullptr)
+            release(*const_cast<TileRecord*>(source_records[i]));
+    }
+
+    return *record;
+}
+
+
+//
+// TextureStore::MemoryTracker class implementation.
+//
+
+TextureStore::MemoryTracker::MemoryTracker()
+  : m_size(0)
+  , m_peak_size(0)
+{
+}
+
+size_t TextureStore::MemoryTracker::add(const size_t size)
+{
+    const size_t new_size = m_size.fetch_add(size) + size;
+
+    size_t peak_size = m_peak_size.load(boost::memory_order_relaxed);
+    while (peak_size < new_size &&
+           !m_peak_size.compare_exchange_weak(peak_size, new_size, boost::memory_order_relaxed))
+        ;
+
+    return new_size;
+}
+
+size_t TextureStore::MemoryTracker::remove(const size_t size)
+{
+    assert(m_size.load() >= size);
+    return m_size.fetch_sub(size) - size;
+}
+
+size_t TextureStore::MemoryTracker::get_peak_size() const
+{
+    return m_peak_size.load();
+}
+
+
+//
+// TextureStore::Shard class implementation.
+//
+
+TextureStore::Shard::Shard(
+    const TextureStore& store,
+    const ParamArray&   params,
+    MemoryTracker&      memory_tracker,
+    TileKeyHasher&      tile_key_hasher)
+  : m_tile_swapper(store, params, memory_tracker)
+  , m_tile_cache(tile_key_hasher, m_tile_swapper)
+  , m_contention_count(0)
+{
+}
+
+
 //
 // TextureStore::TileSwapper class implementation.
 //
@@ -162,15 +378,17 @@ namespace
 }
 
 TextureStore::TileSwapper::TileSwapper(
-    const Scene&        scene,
-    const ParamArray&   params)
-  : m_scene(scene)
+    const TextureStore& store,
+    const ParamArray&   params,
+    MemoryTracker&      memory_tracker)
+  : m_store(store)
   , m_params(params)
+  , m_memory_limit(std::max<size_t>(m_params.m_memory_limit / ShardCount, 1))
   , m_memory_size(0)
-  , m_peak_memory_size(0)
+  , m_memory_tracker(memory_tracker)
+  , m_source_tiles(nullptr)
+  , m_source_tile_count(0)
 {
-    gather_assemblies(scene.assemblies());
-    print_settings();
 }
 
 void TextureStore::TileSwapper::print_settings() const
@@ -178,79 +396,94 @@ void TextureStore::TileSwapper::print_settings() const
     RENDERER_LOG_INFO(
         "texture store settings:\n"
         "  max store size                %s\n"
+        "  shards                        %s\n"
         "  track store size              %s\n"
         "  track tile loading            %s\n"
         "  track tile unloading          %s",
         pretty_size(m_params.m_memory_limit).c_str(),
+        pretty_uint(ShardCount).c_str(),
         m_params.m_track_store_size ? "on" : "off",
         m_params.m_track_tile_loading ? "on" : "off",
         m_params.m_track_tile_unloading ? "on" : "off");
 }
 
-void TextureStore::TileSwapper::load(const TileKey& key, TileRecord& record)
+void TextureStore::TileSwapper::set_source_tiles(
+    const TileRecord**  records,
+    const size_t        record_count)
 {
-    // Fetch the texture container.
-    const TextureContainer& textures =
-        key.m_assembly_uid == ~UniqueID(0)
-            ? m_scene.textures()
-            : m_assemblies[key.m_assembly_uid]->textures();
+    m_source_tiles = records;
+    m_source_tile_count = record_count;
+}
 
+void TextureStore::TileSwapper::load(const TileKey& key, TileRecord& record)
+{
     // Fetch the texture.
-    Texture* texture = textures.get_by_uid(key.m_texture_uid);
+    Texture* texture = m_store.get_texture(key);
     assert(texture != nullptr);
 
     if (m_params.m_track_tile_loading)
     {
         RENDERER_LOG_DEBUG(
-            "loading tile (" FMT_SIZE_T ", " FMT_SIZE_T ") "
+            "loading tile (" FMT_SIZE_T ", " FMT_SIZE_T ", level " FMT_SIZE_T ") "
             "from texture \"%s\"...",
             key.get_tile_x(),
             key.get_tile_y(),
+            static_cast<size_t>(key.m_level),
             texture->get_path().c_str());
     }
 
-    // Load the tile.
-    record.m_tile_ptr = texture->load_tile(key.get_tile_x(), key.get_tile_y());
-    record.m_owners = 0;
+    record.m_owners.store(0, boost::memory_order_relaxed);
 
-    // Convert the tile to the linear RGB color space.
-    switch (texture->get_color_space())
+    if (key.m_level > 0)
+    {
+        // Build the tile from the tiles of the finer level, which are already in the linear RGB color space.
+        record.m_tile_ptr = TilePtr::make_owning(build_mip_tile(key, *texture));
+    }
+    else
     {
-      case ColorSpaceLinearRGB:
-        break;
+        // Load the tile.
+        record.m_tile_ptr = texture->load_tile(key.get_tile_x(), key.get_tile_y());
 
-      case ColorSpaceSRGB:
-        convert_tile_srgb_to_linear_rgb(*record.m_tile_ptr.get_tile());
-        break;
+        // Convert the tile to the linear RGB color space.
+        switch (texture->get_color_space())
+        {
+          case ColorSpaceLinearRGB:
+            break;
+
+          case ColorSpaceSRGB:
+            convert_tile_srgb_to_linear_rgb(*record.m_tile_ptr.get_tile());
+            break;
 
-      case ColorSpaceCIEXYZ:
-        convert_tile_ciexyz_to_linear_rgb(*record.m_tile_ptr.get_tile());
-        break;
+          case ColorSpaceCIEXYZ:
+            convert_tile_ciexyz_to_linear_rgb(*record.m_tile_ptr.get_tile());
+            break;
 
-      assert_otherwise;
+          assert_otherwise;
+        }
     }
 
     // Track the amount of memory used by the tile cache.
-    m_memory_size += record.m_tile_ptr.get_tile()->get_memory_size();
-    m_peak_memory_size = std::max(m_peak_memory_size, m_memory_size);
+    const size_t tile_memory_size = record.m_tile_ptr.get_tile()->get_memory_size();
+    m_memory_size += tile_memory_size;
+    const size_t store_memory_size = m_memory_tracker.add(tile_memory_size);
 
     if (m_params.m_track_store_size)
     {
-        if (m_memory_size > m_params.m_memory_limit)
+        if (store_memory_size > m_params.m_memory_limit)
         {
             RENDERER_LOG_DEBUG(
                 "texture store size is %s, exceeding capacity %s by %s.",
-                pretty_size(m_memory_size).c_str(),
+                pretty_size(store_memory_size).c_str(),
                 pretty_size(m_params.m_memory_limit).c_str(),
-                pretty_size(m_memory_size - m_params.m_memory_limit).c_str());
+                pretty_size(store_memory_size - m_params.m_memory_limit).c_str());
         }
         else
         {
             RENDERER_LOG_DEBUG(
                 "texture store size is %s, below capacity %s by %s.",
-                pretty_size(m_memory_size).c_str(),
+                pretty_size(store_memory_size).c_str(),
                 pretty_size(m_params.m_memory_limit).c_str(),
-                pretty_size(m_params.m_memory_limit - m_memory_size).c_str());
+                pretty_size(m_params.m_memory_limit - store_memory_size).c_str());
         }
     }
 }
@@ -258,24 +491,20 @@ void TextureStore::TileSwapper::load(const TileKey& key, TileRecord& record)
 bool TextureStore::TileSwapper::unload(const TileKey& key, TileRecord& record)
 {
     // Cannot unload tiles that are still in use.
-    if (atomic_read(&record.m_owners) > 0)
+    // Pairs with the release decrement in TextureStore::release().
+    if (record.m_owners.load(boost::memory_order_acquire) > 0)
         return false;
 
     // Track the amount of memory used by the tile cache.
     const size_t tile_memory_size = record.m_tile_ptr.get_tile()->get_memory_size();
     assert(m_memory_size >= tile_memory_size);
     m_memory_size -= tile_memory_size;
+    m_memory_tracker.remove(tile_memory_size);
 
     if (m_params.m_track_tile_unloading)
     {
-        // Fetch the texture container.
-        const TextureContainer& textures =
-            key.m_assembly_uid == ~UniqueID(0)
-            ? m_scene.textures()
-            : m_assemblies[key.m_assembly_uid]->textures();
-
         // Fetch the texture.
-        Texture* texture = textures.get_by_uid(key.m_texture_uid);
+        Texture* texture = m_store.get_texture(key);
 
         if (texture != nullptr)
         {
@@ -304,13 +533,85 @@ bool TextureStore::TileSwapper::unload(const TileKey& key, TileRecord& record)
     return true;
 }
 
-void TextureStore::TileSwapper::gather_assemblies(const AssemblyContainer& assemblies)
+Tile* TextureStore::TileSwapper::build_mip_tile(
+    const TileKey&      key,
+    Texture&            texture) const
 {
-    for (const Assembly& assembly : assemblies)
+    assert(m_source_tile_count == 4);
+    assert(m_source_tiles[0] != nullptr);
+
+    const CanvasProperties& props = texture.properties();
+    const size_t level = key.m_level;
+
+    // Dimensions of this level and of the finer one.
+    const size_t level_width = get_level_size(props.m_canvas_width, level);
+    const size_t level_height = get_level_size(props.m_canvas_height, level);
+    const size_t source_level_width = get_level_size(props.m_canvas_width, level - 1);
+    const size_t source_level_height = get_level_size(props.m_canvas_height, level - 1);
+
+    // Border tiles are smaller than the others.
+    const size_t origin_x = key.get_tile_x() * props.m_tile_width;
+    const size_t origin_y = key.get_tile_y() * props.m_tile_height;
+    assert(origin_x < level_width);
+    assert(origin_y < level_height);
+    const size_t tile_width = std::min(props.m_tile_width, level_width - origin_x);
+    const size_t tile_height = std::min(props.m_tile_height, level_height - origin_y);
+
+    const size_t channel_count = m_source_tiles[0]->m_tile_ptr.get_tile()->get_channel_count();
+    Tile* tile = new Tile(tile_width, tile_height, channel_count, PixelFormatFloat);
+
+    for (size_t y = 0; y < tile_height; ++y)
     {
-        m_assemblies[assembly.get_uid()] = &assembly;
-        gather_assemblies(assembly.assemblies());
+        for (size_t x = 0; x < tile_width; ++x)
+        {
+            // Box-filter the 2x2 texels of the finer level covered by this texel.
+            const size_t sx0 = 2 * (origin_x + x);
+            const size_t sy0 = 2 * (origin_y + y);
+            const size_t sx1 = std::min(sx0 + 1, source_level_width - 1);
+            const size_t sy1 = std::min(sy0 + 1, source_level_height - 1);
+            const size_t sx[2] = { sx0, sx1 };
+            const size_t sy[2] = { sy0, sy1 };
+
+            Color4f sum(0.0f);
+
+            for (size_t j = 0; j < 2; ++j)
+            {
+                for (size_t i = 0; i < 2; ++i)
+                {
+                    const size_t source_tile_x = sx[i] / props.m_tile_width;
+                    const size_t source_tile_y = sy[j] / props.m_tile_height;
+                    const size_t source_index =
+                        (source_tile_y - 2 * key.get_tile_y()) * 2 +
+                        (source_tile_x - 2 * key.get_tile_x());
+                    assert(source_index < 4);
+                    assert(m_source_tiles[source_index] != nullptr);
+
+                    const Tile& source_tile = *m_source_tiles[source_index]->m_tile_ptr.get_tile();
+                    const size_t px = sx[i] - source_tile_x * props.m_tile_width;
+                    const size_t py = sy[j] - source_tile_y * props.m_tile_height;
+
+                    Color4f texel;
+                    if (channel_count == 3)
+                    {
+                        Color3f rgb;
+                        source_tile.get_pixel(px, py, rgb);
+                        texel = Color4f(rgb, 1.0f);
+                    }
+                    else source_tile.get_pixel(px, py, texel);
+
+                    sum += texel;
+                }
+            }
+
+            sum *= 0.25f;
+
+            if (channel_count == 3)
+                tile->set_pixel(x, y, sum.rgb());
+            else tile->set_pixel(x, y, sum);
+        }
     }
+
+    return tile;
 }
 
 
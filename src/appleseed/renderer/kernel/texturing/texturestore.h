@@ -41,17 +41,24 @@
 #include "foundation/utility/cache.h"
 #include "foundation/utility/uid.h"
 
+// Boost headers.
+#include "boost/atomic/atomic.hpp"
+
 // Standard headers.
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <map>
+#include <memory>
+#include <vector>
 
 // Forward declarations.
+namespace foundation    { class CanvasProperties; }
 namespace foundation    { class Dictionary; }
 namespace foundation    { class StatisticsVector; }
 namespace renderer      { class ParamArray; }
 namespace renderer      { class Scene; }
+namespace renderer      { class Texture; }
 
 namespace renderer
 {
@@ -59,17 +66,24 @@ namespace renderer
 //
 // A shared store for texture tiles (the backend of the thread-local texture cache).
 //
+// Tiles are distributed over a number of shards according to the hash of their key.
+// Each shard has its own lock and evicts its own tiles, such that tile misses from
+// different threads rarely serialize.
+//
 
 class TextureStore
   : public foundation::NonCopyable
 {
   public:
     // This structure uniquely identifies a texture tile in a scene.
+    // Tiles of level 0 are tiles of the texture itself; tiles of level n > 0 belong to
+    // the n-th level of the MIP pyramid of the texture and are built on demand.
     struct TileKey
     {
         foundation::UniqueID    m_assembly_uid;
         foundation::UniqueID    m_texture_uid;
         std::uint32_t           m_tile_xy;
+        std::uint32_t           m_level;
 
         TileKey();
 
@@ -77,12 +91,8 @@ class TextureStore
             const foundation::UniqueID  assembly_uid,
             const foundation::UniqueID  texture_uid,
             const size_t                tile_x,
-            const size_t                tile_y);
-
-        TileKey(
-            const foundation::UniqueID  assembly_uid,
-            const foundation::UniqueID  texture_uid,
-            const std::uint32_t         tile_xy);
+            const size_t                tile_y,
+            const size_t                level = 0);
 
         TileKey(const TileKey& rhs);
 
@@ -105,8 +115,11 @@ class TextureStore
 
     struct TileRecord
     {
-        TilePtr                 m_tile_ptr;
-        volatile std::uint32_t  m_owners;
+        TilePtr                         m_tile_ptr;
+        boost::atomic<std::uint32_t>    m_owners;
+
+        TileRecord();
+        TileRecord(const TileRecord& rhs);
     };
 
     // Return parameters metadata.
@@ -123,25 +136,60 @@ class TextureStore
     // Acquire an element from the store. Thread-safe.
     TileRecord& acquire(const TileKey& key);
 
-    // Release a previously-acquired element. Thread-safe.
+    // Release a previously-acquired element. Thread-safe and lock-free.
     void release(TileRecord& record) const;
 
     // Retrieve performance statistics.
     foundation::StatisticsVector get_statistics() const;
 
+    // Return the dimensions in pixels of a given level of the MIP pyramid of a texture.
+    static size_t get_level_size(const size_t size, const size_t level);
+
+    // Return the number of levels of the MIP pyramid of a texture.
+    static size_t get_level_count(const foundation::CanvasProperties& props);
+
   private:
+    // Number of shards (must be a power of two).
+    enum { ShardCount = 32 };
+
+    // Memory usage of the whole store.
+    class MemoryTracker
+      : public foundation::NonCopyable
+    {
+      public:
+        // Constructor.
+        MemoryTracker();
+
+        // Track the loading or the unloading of a tile. Thread-safe.
+        size_t add(const size_t size);
+        size_t remove(const size_t size);
+
+        // Return the peak memory size in bytes of the store.
+        size_t get_peak_size() const;
+
+      private:
+        boost::atomic<size_t>   m_size;
+        boost::atomic<size_t>   m_peak_size;
+    };
+
     class TileSwapper
       : public foundation::NonCopyable
     {
       public:
         // Constructor.
         TileSwapper(
-            const Scene&        scene,
-            const ParamArray&   params);
+            const TextureStore& store,
+            const ParamArray&   params,
+            MemoryTracker&      memory_tracker);
 
         // Print tile swapper's settings.
         void print_settings() const;
 
+        // Set the tiles of the finer level from which the next MIP tile will be built.
+        void set_source_tiles(
+            const TileRecord**  records,
+            const size_t        record_count);
+
         // Load a cache line.
         void load(const TileKey& key, TileRecord& record);
 
@@ -151,9 +199,6 @@ class TextureStore
         // Return true if the cache is full, false otherwise.
         bool is_full(const size_t element_count) const;
 
-        // Return the peak memory size in bytes of the tile cache.
-        size_t get_peak_memory_size() const;
-
       private:
         struct Parameters
         {
@@ -165,15 +210,17 @@ class TextureStore
             explicit Parameters(const ParamArray& params);
         };
 
-        typedef std::map<foundation::UniqueID, const Assembly*> AssemblyMap;
-
-        const Scene&        m_scene;
+        const TextureStore& m_store;
         const Parameters    m_params;
-        size_t              m_memory_size;
-        size_t              m_peak_memory_size;
-        AssemblyMap         m_assemblies;
-
-        void gather_assemblies(const AssemblyContainer& assemblies);
+        const size_t        m_memory_limit;     // memory limit of this shard
+        size_t              m_memory_size;      // memory size of this shard
+        MemoryTracker&      m_memory_tracker;
+        const TileRecord**  m_source_tiles;
+        size_t              m_source_tile_count;
+
+        foundation::Tile* build_mip_tile(
+            const TileKey&      key,
+            Texture&            texture) const;
     };
 
     typedef foundation::LRUCache<
@@ -183,10 +230,37 @@ class TextureStore
         TileSwapper
     > TileCache;
 
-    boost::mutex            m_mutex;
-    TileKeyHasher           m_tile_key_hasher;
-    TileSwapper             m_tile_swapper;
-    TileCache               m_tile_cache;
+    struct Shard
+    {
+        boost::mutex        m_mutex;
+        TileSwapper         m_tile_swapper;
+        TileCache           m_tile_cache;
+        std::uint64_t       m_contention_count;     // number of acquisitions that had to wait for the lock, protected by m_mutex
+
+        Shard(
+            const TextureStore& store,
+            const ParamArray&   params,
+            MemoryTracker&      memory_tracker,
+            TileKeyHasher&      tile_key_hasher);
+    };
+
+    typedef std::map<foundation::UniqueID, const Assembly*> AssemblyMap;
+
+    const Scene&                        m_scene;
+    AssemblyMap                         m_assemblies;
+    TileKeyHasher                       m_tile_key_hasher;
+    MemoryTracker                       m_memory_tracker;
+    std::vector<std::unique_ptr<Shard>> m_shards;
+
+    void gather_assemblies(const AssemblyContainer& assemblies);
+
+    // Return the texture a tile belongs to.
+    Texture* get_texture(const TileKey& key) const;
+
+    Shard& get_shard(const TileKey& key);
+
+    // Acquire a tile of the MIP pyramid of a texture, building it if necessary.
+    TileRecord& acquire_mip_tile(const TileKey& key);
 };
 
 
@@ -196,18 +270,58 @@ class TextureStore
 
 inline TextureStore::TileRecord& TextureStore::acquire(const TileKey& key)
 {
-    boost::mutex::scoped_lock lock(m_mutex);
+    if (key.m_level > 0)
+        return acquire_mip_tile(key);
 
-    TileRecord& record = m_tile_cache.get(key);
-    foundation::atomic_inc(&record.m_owners);
+    Shard& shard = get_shard(key);
+
+    boost::mutex::scoped_lock lock(shard.m_mutex, boost::try_to_lock);
+    if (!lock.owns_lock())
+    {
+        lock.lock();
+        ++shard.m_contention_count;
+    }
+
+    // Tiles are only evicted while holding the lock of their shard, so a relaxed increment is enough.
+    TileRecord& record = shard.m_tile_cache.get(key);
+    record.m_owners.fetch_add(1, boost::memory_order_relaxed);
 
     return record;
 }
 
 inline void TextureStore::release(TileRecord& record) const
 {
-    assert(foundation::atomic_read(&record.m_owners) > 0);
-    foundation::atomic_dec(&record.m_owners);
+    assert(record.m_owners.load(boost::memory_order_relaxed) > 0);
+    record.m_owners.fetch_sub(1, boost::memory_order_release);
+}
+
+inline TextureStore::Shard& TextureStore::get_shard(const TileKey& key)
+{
+    // Use the most significant bits of the hash since the tile cache of the shard uses the least significant ones.
+    const std::uint32_t hash = static_cast<std::uint32_t>(m_tile_key_hasher(key));
+    return *m_shards[(hash >> 24) & (ShardCount - 1)];
+}
+
+inline size_t TextureStore::get_level_size(const size_t size, const size_t level)
+{
+    const size_t level_size = size >> level;
+    return level_size > 0 ? level_size : 1;
+}
+
+
+//
+// TextureStore::TileRecord class implementation.
+//
+
+inline TextureStore::TileRecord::TileRecord()
+  : m_owners(0)
+{
+}
+
+inline TextureStore::TileRecord::TileRecord(const TileRecord& rhs)
+  : m_tile_ptr(rhs.m_tile_ptr)
+  , m_owners(rhs.m_owners.load(boost::memory_order_relaxed))
+{
 }
 
 
@@ -223,29 +337,22 @@ inline TextureStore::TileKey::TileKey(
     const foundation::UniqueID  assembly_uid,
     const foundation::UniqueID  texture_uid,
     const size_t                tile_x,
-    const size_t                tile_y)
+    const size_t                tile_y,
+    const size_t                level)
   : m_assembly_uid(assembly_uid)
   , m_texture_uid(texture_uid)
   , m_tile_xy(static_cast<std::uint32_t>((tile_y << 16) | tile_x))
+  , m_level(static_cast<std::uint32_t>(level))
 {
     assert(tile_x < (1UL << 16));
     assert(tile_y < (1UL << 16));
 }
 
-inline TextureStore::TileKey::TileKey(
-    const foundation::UniqueID  assembly_uid,
-    const foundation::UniqueID  texture_uid,
-    const std::uint32_t         tile_xy)
-  : m_assembly_uid(assembly_uid)
-  , m_texture_uid(texture_uid)
-  , m_tile_xy(tile_xy)
-{
-}
-
 inline TextureStore::TileKey::TileKey(const TileKey& rhs)
   : m_assembly_uid(rhs.m_assembly_uid)
   , m_texture_uid(rhs.m_texture_uid)
   , m_tile_xy(rhs.m_tile_xy)
+  , m_level(rhs.m_level)
 {
 }
 
@@ -261,17 +368,19 @@ inline size_t TextureStore::TileKey::get_tile_y() const
 
 inline TextureStore::TileKey TextureStore::TileKey::invalid()
 {
-    return
-        TileKey(
-            ~foundation::UniqueID(0),   // assembly unique ID
-            ~foundation::UniqueID(0),   // texture unique ID
-            ~std::uint32_t(0));         // tile X and Y coordinates
+    TileKey key;
+    key.m_assembly_uid = ~foundation::UniqueID(0);
+    key.m_texture_uid = ~foundation::UniqueID(0);
+    key.m_tile_xy = ~std::uint32_t(0);
+    key.m_level = ~std::uint32_t(0);
+    return key;
 }
 
 inline bool TextureStore::TileKey::operator==(const TileKey& rhs) const
 {
     return
         m_tile_xy == rhs.m_tile_xy &&
+        m_level == rhs.m_level &&
         m_texture_uid == rhs.m_texture_uid &&
         m_assembly_uid == rhs.m_assembly_uid;
 }
@@ -286,7 +395,9 @@ inline bool TextureStore::TileKey::operator<(const TileKey& rhs) const
     return
         m_assembly_uid == rhs.m_assembly_uid ?
             m_texture_uid == rhs.m_texture_uid ?
-                m_tile_xy < rhs.m_tile_xy :
+                m_level == rhs.m_level ?
+                    m_tile_xy < rhs.m_tile_xy :
+                m_level < rhs.m_level :
             m_texture_uid < rhs.m_texture_uid :
         m_assembly_uid < rhs.m_assembly_uid;
 }
@@ -302,7 +413,8 @@ inline size_t TextureStore::TileKeyHasher::operator()(const TileKey& key) const
         foundation::mix_uint32(
             static_cast<std::uint32_t>(key.m_assembly_uid),
             static_cast<std::uint32_t>(key.m_texture_uid),
-            static_cast<std::uint32_t>(key.m_tile_xy));
+            key.m_tile_xy,
+            key.m_level);
 }
 
 
@@ -312,12 +424,7 @@ inline size_t TextureStore::TileKeyHasher::operator()(const TileKey& key) const
 
 inline bool TextureStore::TileSwapper::is_full(const size_t element_count) const
 {
-    return m_memory_size >= m_params.m_memory_limit;
-}
-
-inline size_t TextureStore::TileSwapper::get_peak_memory_size() const
-{
-    return m_peak_memory_size;
+    return m_memory_size >= m_memory_limit;
 }
 
 }   // namespace renderer
@@ -0,0 +1,112 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+// Interface header.
+#include "majorantgrid.h"
+
+// Standard headers.
+#include <algorithm>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+//
+// MajorantGrid class implementation.
+//
+
+MajorantGrid::MajorantGrid(
+    const SparseVoxelGrid&  voxel_grid,
+    const size_t            channel_index)
+  : m_max_majorant(0.0f)
+{
+    const size_t BrickSize = SparseVoxelGrid::BrickSize;
+
+    const size_t voxel_res[3] =
+    {
+        voxel_grid.get_xres(),
+        voxel_grid.get_yres(),
+        voxel_grid.get_zres()
+    };
+
+    m_res[0] = voxel_grid.get_brick_xres();
+    m_res[1] = voxel_grid.get_brick_yres();
+    m_res[2] = voxel_grid.get_brick_zres();
+
+    // Trilinear lookups map the unit cube to [0, res - 1] in voxel coordinates.
+    for (size_t i = 0; i < 3; ++i)
+        m_scale[i] = static_cast<double>(voxel_res[i] - 1) / BrickSize;
+
+    m_majorants.resize(m_res[0] * m_res[1] * m_res[2], 0.0f);
+
+    for (size_t bz = 0; bz < m_res[2]; ++bz)
+    {
+        for (size_t by = 0; by < m_res[1]; ++by)
+        {
+            for (size_t bx = 0; bx < m_res[0]; ++bx)
+            {
+                // A cell interpolates the voxels of its brick and the first voxels of the next bricks.
+                bool occupied = false;
+                for (size_t dz = 0; dz < 2 && bz + dz < m_res[2]; ++dz)
+                {
+                    for (size_t dy = 0; dy < 2 && by + dy < m_res[1]; ++dy)
+                    {
+                        for (size_t dx = 0; dx < 2 && bx + dx < m_res[0]; ++dx)
+                            occupied = occupied || voxel_grid.has_brick(bx + dx, by + dy, bz + dz);
+                    }
+                }
+
+                // Empty space.
+                if (!occupied)
+                    continue;
+
+                const size_t x_end = std::min(bx * BrickSize + BrickSize + 1, voxel_res[0]);
+                const size_t y_end = std::min(by * BrickSize + BrickSize + 1, voxel_res[1]);
+                const size_t z_end = std::min(bz * BrickSize + BrickSize + 1, voxel_res[2]);
+
+                float majorant = 0.0f;
+                for (size_t z = bz * BrickSize; z < z_end; ++z)
+                {
+                    for (size_t y = by * BrickSize; y < y_end; ++y)
+                    {
+                        for (size_t x = bx * BrickSize; x < x_end; ++x)
+                            majorant = std::max(majorant, voxel_grid.voxel(x, y, z)[channel_index]);
+                    }
+                }
+
+                m_majorants[(bz * m_res[1] + by) * m_res[0] + bx] = majorant;
+                m_max_majorant = std::max(m_max_majorant, majorant);
+            }
+        }
+    }
+}
+
+}   // namespace renderer
@@ -0,0 +1,239 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#pragma once
+
+// appleseed.renderer headers.
+#include "renderer/kernel/volume/volume.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+
+// Standard headers.
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace renderer
+{
+
+//
+// A coarse grid of extinction majorants over a sparse voxel grid.
+//
+// There is one cell per brick of the voxel grid. The majorant of a cell bounds
+// the trilinearly interpolated values of the voxel grid inside that cell. Cells
+// that only cover unallocated bricks have a null majorant: tracking algorithms
+// can skip them entirely.
+//
+
+class MajorantGrid
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor, computes the majorants of a given channel of a voxel grid.
+    MajorantGrid(
+        const SparseVoxelGrid&      voxel_grid,
+        const size_t                channel_index);
+
+    // Get the grid properties.
+    size_t get_xres() const;
+    size_t get_yres() const;
+    size_t get_zres() const;
+
+    // Return the majorant of a given cell.
+    float get_majorant(
+        const size_t                x,
+        const size_t                y,
+        const size_t                z) const;
+
+    // Return the largest majorant of the grid.
+    float get_max_majorant() const;
+
+    // Walk the cells pierced by the segment [tmin, tmax) of a ray, front to back.
+    // The ray is expressed in the unit cube [0,1]^3 of the voxel grid. The visitor
+    // is called as visitor(t0, t1, majorant) for each cell and may return false
+    // to stop the traversal.
+    template <typename Visitor>
+    void traverse(
+        const foundation::Vector3d& org,
+        const foundation::Vector3d& dir,
+        const double                tmin,
+        const double                tmax,
+        Visitor&                    visitor) const;
+
+  private:
+    size_t                          m_res[3];
+    foundation::Vector3d            m_scale;        // from the unit cube to cell coordinates
+    std::vector<float>              m_majorants;
+    float                           m_max_majorant;
+};
+
+
+//
+// MajorantGrid class implementation.
+//
+
+inline size_t MajorantGrid::get_xres() const
+{
+    return m_res[0];
+}
+
+inline size_t MajorantGrid::get_yres() const
+{
+    return m_res[1];
+}
+
+inline size_t MajorantGrid::get_zres() const
+{
+    return m_res[2];
+}
+
+inline float MajorantGrid::get_majorant(
+    const size_t                    x,
+    const size_t                    y,
+    const size_t                    z) const
+{
+    assert(x < m_res[0]);
+    assert(y < m_res[1]);
+    assert(z < m_res[2]);
+    return m_majorants[(z * m_res[1] + y) * m_res[0] + x];
+}
+
+inline float MajorantGrid::get_max_majorant() const
+{
+    return m_max_majorant;
+}
+
+template <typename Visitor>
+void MajorantGrid::traverse(
+    const foundation::Vector3d&     org,
+    const foundation::Vector3d&     dir,
+    const double                    tmin,
+    const double                    tmax,
+    Visitor&                        visitor) const
+{
+    // Express the ray in cell coordinates and clip it against the unit cube.
+    const foundation::Vector3d o = org * m_scale;
+    const foundation::Vector3d d = dir * m_scale;
+    double t0 = tmin;
+    double t1 = tmax;
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        const double end = m_scale[i];
+
+        if (d[i] == 0.0)
+        {
+            if (o[i] < 0.0 || o[i] > end)
+                return;
+        }
+        else
+        {
+            const double rcp_d = 1.0 / d[i];
+            double enter = -o[i] * rcp_d;
+            double leave = (end - o[i]) * rcp_d;
+            if (enter > leave)
+                std::swap(enter, leave);
+            t0 = std::max(t0, enter);
+            t1 = std::min(t1, leave);
+        }
+    }
+
+    if (t0 >= t1)
+        return;
+
+    // Initialize the 3D-DDA.
+    std::ptrdiff_t cell[3], step[3];
+    double next[3], delta[3];
+    for (size_t i = 0; i < 3; ++i)
+    {
+        const double p = o[i] + t0 * d[i];
+        cell[i] =
+            foundation::clamp<std::ptrdiff_t>(
+                static_cast<std::ptrdiff_t>(std::floor(p)),
+                0,
+                static_cast<std::ptrdiff_t>(m_res[i]) - 1);
+
+        if (d[i] > 0.0)
+        {
+            step[i] = 1;
+            delta[i] = 1.0 / d[i];
+            next[i] = (cell[i] + 1 - o[i]) / d[i];
+        }
+        else if (d[i] < 0.0)
+        {
+            step[i] = -1;
+            delta[i] = -1.0 / d[i];
+            next[i] = (cell[i] - o[i]) / d[i];
+        }
+        else
+        {
+            step[i] = 0;
+            delta[i] = std::numeric_limits<double>::max();
+            next[i] = std::numeric_limits<double>::max();
+        }
+    }
+
+    // Walk the cells.
+    double t = t0;
+    while (true)
+    {
+        const size_t axis =
+            next[0] < next[1]
+                ? (next[0] < next[2] ? 0 : 2)
+                : (next[1] < next[2] ? 1 : 2);
+        const double t_exit = std::min(next[axis], t1);
+
+        const float majorant =
+            get_majorant(
+                static_cast<size_t>(cell[0]),
+                static_cast<size_t>(cell[1]),
+                static_cast<size_t>(cell[2]));
+
+        if (t_exit > t && !visitor(t, t_exit, majorant))
+            return;
+
+        if (t_exit >= t1 || step[axis] == 0)
+            return;
+
+        t = t_exit;
+        cell[axis] += step[axis];
+        next[axis] += delta[axis];
+
+        if (cell[axis] < 0 || cell[axis] >= static_cast<std::ptrdiff_t>(m_res[axis]))
+            return;
+    }
+}
+
+}   // namespace renderer
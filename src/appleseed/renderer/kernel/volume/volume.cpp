@@ -38,6 +38,7 @@
 #include <cassert>
 #include <cstdio>
 #include <utility>
+#include <vector>
 
 using namespace foundation;
 
@@ -280,6 +281,73 @@ std::unique_ptr<VoxelGrid> read_fluid_file(
     return read == needed ? move(grid) : std::unique_ptr<VoxelGrid>(nullptr);
 }
 
+std::unique_ptr<SparseVoxelGrid> read_fluid_file_density(
+    const char*         filename)
+{
+    assert(filename);
+
+    FILE* file = fopen(filename, "rb");
+
+    if (file == nullptr)
+        return std::unique_ptr<SparseVoxelGrid>(nullptr);
+
+    // Read the file header.
+    FluidFileHeader header;
+    if (fread(&header, sizeof(FluidFileHeader), 1, file) < 1)
+    {
+        fclose(file);
+        return std::unique_ptr<SparseVoxelGrid>(nullptr);
+    }
+
+    // Check the validity of the file header.
+    if (header.m_id != CC32('F', 'L', 'D', '3') || !header.m_has_density)
+    {
+        fclose(file);
+        return std::unique_ptr<SparseVoxelGrid>(nullptr);
+    }
+
+    const size_t voxel_count = header.m_xres * header.m_yres * header.m_zres;
+
+    // Skip fluid color which precedes densities.
+    if (header.m_has_color &&
+        fseek(file, static_cast<long>(voxel_count * 3 * sizeof(float)), SEEK_CUR) != 0)
+    {
+        fclose(file);
+        return std::unique_ptr<SparseVoxelGrid>(nullptr);
+    }
+
+    std::unique_ptr<SparseVoxelGrid> grid(
+        new SparseVoxelGrid(
+            header.m_xres,
+            header.m_yres,
+            header.m_zres,
+            1));
+
+    // Read fluid density one row at a time, only storing non-empty voxels.
+    std::vector<float> row(header.m_xres);
+    for (size_t z = 0; z < grid->get_zres(); ++z)
+    {
+        for (size_t y = 0; y < grid->get_yres(); ++y)
+        {
+            if (fread(&row[0], sizeof(float), row.size(), file) < row.size())
+            {
+                fclose(file);
+                return std::unique_ptr<SparseVoxelGrid>(nullptr);
+            }
+
+            for (size_t x = 0; x < grid->get_xres(); ++x)
+            {
+                if (row[x] > 0.0f)
+                    grid->voxel(x, y, z)[0] = row[x];
+            }
+        }
+    }
+
+    fclose(file);
+
+    return grid;
+}
+
 void write_voxel_grid(
     const char*         filename,
     const VoxelGrid&    grid)
@@ -30,6 +30,7 @@
 #pragma once
 
 // appleseed.foundation headers.
+#include "foundation/math/sparsevoxelgrid.h"
 #include "foundation/math/voxelgrid.h"
 
 // Standard headers.
@@ -44,6 +45,7 @@ namespace renderer
 //
 
 typedef foundation::VoxelGrid3<float, double> VoxelGrid;
+typedef foundation::SparseVoxelGrid3<float, double> SparseVoxelGrid;
 
 
 //
@@ -77,6 +79,12 @@ std::unique_ptr<VoxelGrid> read_fluid_file(
     const char*         filename,
     FluidChannels&      channels);
 
+// Read the density channel of a fluid file into a single-channel sparse voxel grid.
+// Voxels of null density are not stored. Return nullptr if the file could not be
+// read or doesn't contain densities.
+std::unique_ptr<SparseVoxelGrid> read_fluid_file_density(
+    const char*         filename);
+
 // Write a voxel grid to disk in a human-readable format.
 void write_voxel_grid(
     const char*         filename,
@@ -0,0 +1,181 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/rendering/progressive/adaptivesamplescheduler.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+#include "foundation/math/qmc.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/iostreamop.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Rendering_Progressive_AdaptiveSampleScheduler)
+{
+    AdaptiveSampleScheduler::Parameters make_params()
+    {
+        AdaptiveSampleScheduler::Parameters params;
+        params.m_block_size = 16;
+        params.m_min_samples = 4;
+        params.m_max_samples = 64;
+        params.m_noise_threshold = 0.1f;
+        return params;
+    }
+
+    TEST_CASE(Constructor_GivenCropWindowNotMultipleOfBlockSize_CreatesPartialEdgeBlocks)
+    {
+        const AABB2u crop_window(Vector2u(8, 4), Vector2u(47, 23));
+        const AdaptiveSampleScheduler scheduler(crop_window, make_params());
+
+        const std::vector<AABB2u>& blocks = scheduler.get_blocks();
+
+        ASSERT_EQ(6, blocks.size());
+        EXPECT_EQ(Vector2u(8, 4), blocks[0].min);
+        EXPECT_EQ(Vector2u(23, 19), blocks[0].max);
+        EXPECT_EQ(Vector2u(40, 20), blocks[5].min);
+        EXPECT_EQ(Vector2u(47, 23), blocks[5].max);
+    }
+
+    TEST_CASE(GetDistribution_BeforeAnyUpdate_ReturnsNull)
+    {
+        const AdaptiveSampleScheduler scheduler(AABB2u(Vector2u(0, 0), Vector2u(31, 31)), make_params());
+
+        EXPECT_EQ(4, scheduler.get_active_block_count());
+        EXPECT_TRUE(scheduler.get_distribution() == nullptr);
+    }
+
+    TEST_CASE(Update_GivenAllBlocksBelowNoiseThreshold_ReturnsTrue)
+    {
+        AdaptiveSampleScheduler scheduler(AABB2u(Vector2u(0, 0), Vector2u(31, 31)), make_params());
+
+        const std::vector<float> noise(4, 0.05f);
+        const std::vector<float> spp(4, 8.0f);
+
+        EXPECT_TRUE(scheduler.update(noise, spp));
+        EXPECT_EQ(0, scheduler.get_active_block_count());
+    }
+
+    TEST_CASE(Update_GivenNoiseBelowThresholdButTooFewSamples_ReturnsFalse)
+    {
+        AdaptiveSampleScheduler scheduler(AABB2u(Vector2u(0, 0), Vector2u(31, 31)), make_params());
+
+        const std::vector<float> noise(4, 0.05f);
+        const std::vector<float> spp(4, 2.0f);
+
+        EXPECT_FALSE(scheduler.update(noise, spp));
+        EXPECT_EQ(4, scheduler.get_active_block_count());
+    }
+
+    TEST_CASE(Update_GivenNoisyBlocksThatReachedMaxSamples_ReturnsTrue)
+    {
+        AdaptiveSampleScheduler scheduler(AABB2u(Vector2u(0, 0), Vector2u(31, 31)), make_params());
+
+        const std::vector<float> noise(4, std::numeric_limits<float>::infinity());
+        const std::vector<float> spp(4, 64.0f);
+
+        EXPECT_TRUE(scheduler.update(noise, spp));
+    }
+
+    TEST_CASE(Update_GivenSingleNoisyBlock_SamplesOnlyLandInThatBlock)
+    {
+        AdaptiveSampleScheduler scheduler(AABB2u(Vector2u(0, 0), Vector2u(39, 39)), make_params());
+
+        std::vector<float> noise(9, 0.05f);
+        const std::vector<float> spp(9, 8.0f);
+        noise[5] = 0.5f;
+
+        EXPECT_FALSE(scheduler.update(noise, spp));
+        EXPECT_EQ(1, scheduler.get_active_block_count());
+
+        const std::shared_ptr<const AdaptiveSampleScheduler::Distribution> distribution =
+            scheduler.get_distribution();
+        ASSERT_TRUE(distribution != nullptr);
+
+        const AABB2u& noisy_block = scheduler.get_blocks()[5];
+        bool all_inside = true;
+
+        const size_t Bases[2] = { 2, 3 };
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            const Vector2d s = halton_sequence<double, 2>(Bases, i);
+            all_inside = all_inside && noisy_block.contains(distribution->sample(s));
+        }
+
+        EXPECT_TRUE(all_inside);
+    }
+
+    TEST_CASE(Update_GivenTwoNoisyBlocks_FavorsNoisierBlock)
+    {
+        AdaptiveSampleScheduler scheduler(AABB2u(Vector2u(0, 0), Vector2u(31, 15)), make_params());
+
+        std::vector<float> noise(2);
+        noise[0] = 0.2f;
+        noise[1] = 0.8f;
+        const std::vector<float> spp(2, 8.0f);
+
+        scheduler.update(noise, spp);
+
+        const std::shared_ptr<const AdaptiveSampleScheduler::Distribution> distribution =
+            scheduler.get_distribution();
+
+        const size_t Bases[2] = { 2, 3 };
+        size_t hits[2] = { 0, 0 };
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            const Vector2d s = halton_sequence<double, 2>(Bases, i);
+            ++hits[scheduler.get_blocks()[0].contains(distribution->sample(s)) ? 0 : 1];
+        }
+
+        // The second block is four times noisier and should get about four times more samples.
+        EXPECT_GT(3 * hits[0], hits[1]);
+        EXPECT_LT(5 * hits[0], hits[1]);
+    }
+
+    TEST_CASE(Clear_AfterUpdate_RevertsToUniformSampling)
+    {
+        AdaptiveSampleScheduler scheduler(AABB2u(Vector2u(0, 0), Vector2u(31, 31)), make_params());
+        scheduler.update(std::vector<float>(4, 0.5f), std::vector<float>(4, 8.0f));
+        const std::uint32_t version = scheduler.get_version();
+
+        scheduler.clear();
+
+        EXPECT_TRUE(scheduler.get_distribution() == nullptr);
+        EXPECT_NEQ(version, scheduler.get_version());
+    }
+}
@@ -0,0 +1,194 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/intersection/intersector.h"
+#include "renderer/kernel/intersection/tracecontext.h"
+#include "renderer/kernel/shading/shadingpoint.h"
+#include "renderer/kernel/shading/shadingray.h"
+#include "renderer/kernel/texturing/texturecache.h"
+#include "renderer/kernel/texturing/texturestore.h"
+#include "renderer/modeling/object/curveobject.h"
+#include "renderer/modeling/object/object.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/assemblyinstance.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/objectinstance.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/modeling/scene/visibilityflags.h"
+#include "renderer/utility/paramarray.h"
+#include "renderer/utility/testutils.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/color.h"
+#include "foundation/math/beziercurve.h"
+#include "foundation/math/matrix.h"
+#include "foundation/math/transform.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/containers/dictionary.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Intersection_CurveTree)
+{
+    // A single diagonal curve going from (-1, -1, 0) to (1, 1, 0) in object space,
+    // instanced with a translation of (2, 0, 0).
+    template <bool UseSpatialSplits>
+    struct TestScene
+      : public TestSceneBase
+    {
+        TestScene()
+        {
+            auto_release_ptr<Assembly> assembly(
+                AssemblyFactory().create(
+                    "assembly",
+                    ParamArray().insert_path("acceleration_structure.algorithm", UseSpatialSplits ? "sbvh" : "bvh")));
+
+            auto_release_ptr<CurveObject> curve_object(
+                CurveObjectFactory().create("curve_object", ParamArray()));
+
+            static const GVector3 ControlPoints[] = { GVector3(-1.0, -1.0, 0.0), GVector3(1.0, 1.0, 0.0) };
+            curve_object->push_basis(CurveBasis::Linear);
+            curve_object->push_curve1(Curve1Type(ControlPoints, GScalar(0.1), GScalar(1.0), Color3f(1.0f)));
+
+            assembly->objects().insert(auto_release_ptr<Object>(curve_object));
+
+            assembly->object_instances().insert(
+                ObjectInstanceFactory::create(
+                    "curve_object_instance",
+                    ParamArray(),
+                    "curve_object",
+                    Transformd::from_local_to_parent(
+                        Matrix4d::make_translation(Vector3d(2.0, 0.0, 0.0))),
+                    StringDictionary()));
+
+            m_scene.assembly_instances().insert(
+                auto_release_ptr<AssemblyInstance>(
+                    AssemblyInstanceFactory::create(
+                        "assembly_instance",
+                        ParamArray(),
+                        "assembly")));
+
+            m_scene.assemblies().insert(assembly);
+        }
+    };
+
+    template <bool UseSpatialSplits>
+    struct SceneTracer
+      : public StaticTestSceneContext<TestScene<UseSpatialSplits>>
+    {
+        TraceContext    m_trace_context;
+        TextureStore    m_texture_store;
+        TextureCache    m_texture_cache;
+        Intersector     m_intersector;
+
+        SceneTracer()
+          : m_trace_context(this->m_scene)
+          , m_texture_store(this->m_scene)
+          , m_texture_cache(m_texture_store)
+          , m_intersector(m_trace_context, m_texture_cache)
+        {
+            m_trace_context.update();
+        }
+
+        // Trace a ray parallel to the Z axis toward the XY plane, return the hit distance or -1.0 on a miss.
+        double trace(const double x, const double y)
+        {
+            const ShadingRay ray(
+                Vector3d(x, y, 5.0),
+                Vector3d(0.0, 0.0, -1.0),
+                0.0,                                // tmin
+                10.0,                               // tmax
+                ShadingRay::Time(),
+                VisibilityFlags::CameraRay,
+                0);                                 // depth
+
+            ShadingPoint shading_point;
+            return m_intersector.trace(ray, shading_point) ? shading_point.get_distance() : -1.0;
+        }
+    };
+
+    TEST_CASE_F(Trace_GivenInstancedCurve_HitsCurveAtTransformedLocation, SceneTracer<false>)
+    {
+        EXPECT_FEQ_EPS(5.0, trace(2.0, 0.0), 1.0e-4);
+        EXPECT_FEQ_EPS(5.0, trace(1.5, -0.5), 1.0e-4);
+        EXPECT_FEQ_EPS(5.0, trace(2.75, 0.75), 1.0e-4);
+    }
+
+    TEST_CASE_F(Trace_GivenInstancedCurve_MissesCurveAtObjectSpaceLocation, SceneTracer<false>)
+    {
+        EXPECT_EQ(-1.0, trace(0.0, 0.0));
+        EXPECT_EQ(-1.0, trace(-0.5, -0.5));
+        EXPECT_EQ(-1.0, trace(0.75, 0.75));
+    }
+
+    TEST_CASE_F(Trace_GivenInstancedCurveAndSpatialSplits_HitsCurveAtTransformedLocation, SceneTracer<true>)
+    {
+        EXPECT_FEQ_EPS(5.0, trace(2.0, 0.0), 1.0e-4);
+        EXPECT_FEQ_EPS(5.0, trace(1.5, -0.5), 1.0e-4);
+        EXPECT_FEQ_EPS(5.0, trace(2.75, 0.75), 1.0e-4);
+        EXPECT_EQ(-1.0, trace(0.0, 0.0));
+    }
+
+    TEST_CASE(Trace_GivenDiagonalCurve_SpatialSplitsAndRegularBVHReturnSameHits)
+    {
+        SceneTracer<false> bvh_tracer;
+        SceneTracer<true> sbvh_tracer;
+
+        const size_t GridSize = 41;
+        size_t hit_count = 0;
+
+        for (size_t j = 0; j < GridSize; ++j)
+        {
+            for (size_t i = 0; i < GridSize; ++i)
+            {
+                // Cover the bounding box of the instance with a regular grid of rays.
+                const double x = 0.9 + 2.2 * i / (GridSize - 1);
+                const double y = -1.1 + 2.2 * j / (GridSize - 1);
+
+                const double bvh_distance = bvh_tracer.trace(x, y);
+                const double sbvh_distance = sbvh_tracer.trace(x, y);
+
+                EXPECT_FEQ_EPS(bvh_distance, sbvh_distance, 1.0e-6);
+
+                if (bvh_distance >= 0.0)
+                    ++hit_count;
+            }
+        }
+
+        // Most of the grid diagonal lies on the curve.
+        EXPECT_GT(GridSize / 2, hit_count);
+    }
+}
@@ -0,0 +1,198 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/modeling/environmentedf/importancemapcache.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/color.h"
+#include "foundation/platform/memorymappedfile.h"
+#include "foundation/utility/iostreamop.h"
+#include "foundation/utility/test.h"
+
+// Boost headers.
+#include "boost/filesystem.hpp"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+using namespace foundation;
+using namespace renderer;
+namespace bf = boost::filesystem;
+
+TEST_SUITE(Renderer_Modeling_EnvironmentEDF_ImportanceMapCache)
+{
+    const size_t Width = 8;
+    const size_t Height = 4;
+    const std::uint64_t Key = 0x0123456789ABCDEFULL;
+
+    struct GradientSampler
+    {
+        void sample(const size_t x, const size_t y, Color3f& payload, float& importance) const
+        {
+            payload = Color3f(static_cast<float>(x), static_cast<float>(y), 1.0f);
+            importance = 1.0f + x + y;
+        }
+    };
+
+    struct Fixture
+    {
+        const bf::path              m_output_directory;
+        const std::string           m_cache_filepath;
+        ImportanceMapSamplerType    m_importance_sampler;
+
+        Fixture()
+          : m_output_directory(bf::absolute("unit tests/outputs/test_importancemapcache/"))
+          , m_cache_filepath((m_output_directory / get_importance_map_cache_filename(Key)).string())
+          , m_importance_sampler(Width, Height)
+        {
+            bf::remove_all(m_output_directory);
+
+            GradientSampler sampler;
+            m_importance_sampler.rebuild(sampler);
+        }
+
+        size_t count_directory_entries() const
+        {
+            size_t count = 0;
+
+            for (bf::directory_iterator i(m_output_directory), e; i != e; ++i)
+                ++count;
+
+            return count;
+        }
+
+        // Overwrite the byte at a given offset from the end of the cache file.
+        void corrupt_cache_file(const std::streamoff offset_from_end) const
+        {
+            std::fstream file(m_cache_filepath.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(-offset_from_end, std::ios::end);
+            file.put('\x7f');
+        }
+    };
+
+    TEST_CASE_F(SaveImportanceMapFile_WritesOnlyTheCacheFile, Fixture)
+    {
+        ASSERT_TRUE(save_importance_map_file(m_cache_filepath, Key, m_importance_sampler, Width, Height));
+
+        EXPECT_TRUE(bf::exists(m_cache_filepath));
+        EXPECT_EQ(1, count_directory_entries());
+    }
+
+    TEST_CASE_F(IsValidImportanceMapFile_GivenSavedFile_ReturnsTrueAndPayloadsRoundTrip, Fixture)
+    {
+        ASSERT_TRUE(save_importance_map_file(m_cache_filepath, Key, m_importance_sampler, Width, Height));
+
+        const MemoryMappedFile file(m_cache_filepath.c_str());
+        ASSERT_TRUE(is_valid_importance_map_file(file, Key, Width, Height));
+
+        const Color3f* payloads = get_importance_map_file_payloads(file);
+
+        for (size_t y = 0; y < Height; ++y)
+        {
+            for (size_t x = 0; x < Width; ++x)
+                EXPECT_EQ(m_importance_sampler.get_payload(x, y), payloads[y * Width + x]);
+        }
+    }
+
+    TEST_CASE_F(IsValidImportanceMapFile_GivenDifferentKeyOrResolution_ReturnsFalse, Fixture)
+    {
+        ASSERT_TRUE(save_importance_map_file(m_cache_filepath, Key, m_importance_sampler, Width, Height));
+
+        const MemoryMappedFile file(m_cache_filepath.c_str());
+        EXPECT_FALSE(is_valid_importance_map_file(file, Key + 1, Width, Height));
+        EXPECT_FALSE(is_valid_importance_map_file(file, Key, Width / 2, Height * 2));
+    }
+
+    TEST_CASE_F(IsValidImportanceMapFile_GivenCorruptedPayload_ReturnsFalse, Fixture)
+    {
+        ASSERT_TRUE(save_importance_map_file(m_cache_filepath, Key, m_importance_sampler, Width, Height));
+
+        corrupt_cache_file(1);
+
+        const MemoryMappedFile file(m_cache_filepath.c_str());
+        EXPECT_FALSE(is_valid_importance_map_file(file, Key, Width, Height));
+    }
+
+    TEST_CASE_F(IsValidImportanceMapFile_GivenTruncatedFile_ReturnsFalse, Fixture)
+    {
+        ASSERT_TRUE(save_importance_map_file(m_cache_filepath, Key, m_importance_sampler, Width, Height));
+
+        bf::resize_file(m_cache_filepath, bf::file_size(m_cache_filepath) - sizeof(Color3f));
+
+        const MemoryMappedFile file(m_cache_filepath.c_str());
+        EXPECT_FALSE(is_valid_importance_map_file(file, Key, Width, Height));
+    }
+
+    TEST_CASE_F(SaveImportanceMapFile_GivenInvalidFile_ReplacesIt, Fixture)
+    {
+        ASSERT_TRUE(save_importance_map_file(m_cache_filepath, Key, m_importance_sampler, Width, Height));
+        corrupt_cache_file(1);
+
+        ASSERT_TRUE(save_importance_map_file(m_cache_filepath, Key, m_importance_sampler, Width, Height));
+
+        const MemoryMappedFile file(m_cache_filepath.c_str());
+        EXPECT_TRUE(is_valid_importance_map_file(file, Key, Width, Height));
+    }
+
+    TEST_CASE_F(HashImportanceMapSourceFile_GivenModifiedFile_ReturnsDifferentHash, Fixture)
+    {
+        bf::create_directories(m_output_directory);
+        const bf::path source_path = m_output_directory / "source.bin";
+        std::ofstream(source_path.string().c_str(), std::ios::binary) << "radiance";
+
+        std::uint64_t initial_hash;
+        ASSERT_TRUE(hash_importance_map_source_file(source_path.string(), initial_hash));
+
+        std::uint64_t same_hash;
+        ASSERT_TRUE(hash_importance_map_source_file(source_path.string(), same_hash));
+        EXPECT_EQ(initial_hash, same_hash);
+
+        // Touching the file invalidates cached maps even if its size doesn't change.
+        bf::last_write_time(source_path, bf::last_write_time(source_path) + 10);
+        std::uint64_t touched_hash;
+        ASSERT_TRUE(hash_importance_map_source_file(source_path.string(), touched_hash));
+        EXPECT_NEQ(initial_hash, touched_hash);
+
+        // So does changing its size.
+        std::ofstream(source_path.string().c_str(), std::ios::binary | std::ios::app) << "!";
+        bf::last_write_time(source_path, bf::last_write_time(source_path) - 10);
+        std::uint64_t resized_hash;
+        ASSERT_TRUE(hash_importance_map_source_file(source_path.string(), resized_hash));
+        EXPECT_NEQ(touched_hash, resized_hash);
+    }
+
+    TEST_CASE(HashImportanceMapSourceFile_GivenMissingFile_ReturnsFalse)
+    {
+        std::uint64_t hash;
+        EXPECT_FALSE(hash_importance_map_source_file("unit tests/inputs/test_importancemapcache_missing.exr", hash));
+    }
+}
@@ -0,0 +1,125 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/lighting/lighttree.h"
+#include "renderer/kernel/lighting/lighttypes.h"
+#include "renderer/modeling/input/scalarsource.h"
+#include "renderer/modeling/light/light.h"
+#include "renderer/modeling/light/pointlight.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+#include "foundation/math/matrix.h"
+#include "foundation/math/transform.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/iostreamop.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Lighting_LightTree)
+{
+    struct Fixture
+    {
+        LightContainer                          m_lights;
+        std::vector<NonPhysicalLightInfo>       m_light_infos;
+        std::vector<EmittingShape>              m_emitting_shapes;
+
+        Fixture()
+        {
+            const Vector3d positions[] =
+            {
+                Vector3d(0.0, 0.0, 0.0),
+                Vector3d(1.0, 0.0, 0.0),
+                Vector3d(5.0, 2.0, 0.0),
+                Vector3d(6.0, 2.0, 1.0)
+            };
+
+            for (size_t i = 0; i < 4; ++i)
+            {
+                auto_release_ptr<Light> light(PointLightFactory().create("light", ParamArray()));
+                light->get_inputs().find("intensity").bind(new ScalarSource(static_cast<float>(i + 1)));
+                m_lights.insert(light);
+                move_light(i, positions[i]);
+
+                NonPhysicalLightInfo light_info;
+                light_info.m_light = m_lights.get_by_index(i);
+                m_light_infos.push_back(light_info);
+            }
+        }
+
+        void move_light(const size_t light_index, const Vector3d& position)
+        {
+            m_lights.get_by_index(light_index)->set_transform(
+                Transformd::from_local_to_parent(
+                    Matrix4d::make_translation(position)));
+        }
+    };
+
+    TEST_CASE_F(Refit_GivenMovedLights_MatchesRebuiltTree, Fixture)
+    {
+        LightTree refitted_tree(m_light_infos, m_emitting_shapes);
+        refitted_tree.build();
+
+        move_light(0, Vector3d(-3.0, 1.0, 2.0));
+        move_light(3, Vector3d(8.0, -1.0, 4.0));
+        refitted_tree.refit();
+
+        LightTree rebuilt_tree(m_light_infos, m_emitting_shapes);
+        rebuilt_tree.build();
+
+        const AABB3f refitted_bbox = refitted_tree.get_bbox();
+        const AABB3f rebuilt_bbox = rebuilt_tree.get_bbox();
+        EXPECT_FEQ(rebuilt_bbox.min, refitted_bbox.min);
+        EXPECT_FEQ(rebuilt_bbox.max, refitted_bbox.max);
+        EXPECT_FEQ(rebuilt_tree.get_importance(), refitted_tree.get_importance());
+    }
+
+    TEST_CASE_F(Refit_GivenChangedIntensity_MatchesRebuiltTree, Fixture)
+    {
+        LightTree refitted_tree(m_light_infos, m_emitting_shapes);
+        refitted_tree.build();
+
+        m_lights.get_by_index(2)->get_inputs().find("intensity").bind(new ScalarSource(10.0f));
+        refitted_tree.refit();
+
+        LightTree rebuilt_tree(m_light_infos, m_emitting_shapes);
+        rebuilt_tree.build();
+
+        EXPECT_FEQ(rebuilt_tree.get_importance(), refitted_tree.get_importance());
+    }
+}
@@ -0,0 +1,169 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+// appleseed.renderer headers.
+#include "renderer/kernel/volume/majorantgrid.h"
+#include "renderer/kernel/volume/volume.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Volume_MajorantGrid)
+{
+    struct Segment
+    {
+        double  m_t0;
+        double  m_t1;
+        float   m_majorant;
+    };
+
+    struct SegmentCollector
+    {
+        std::vector<Segment> m_segments;
+
+        bool operator()(const double t0, const double t1, const float majorant)
+        {
+            const Segment segment = { t0, t1, majorant };
+            m_segments.push_back(segment);
+            return true;
+        }
+    };
+
+    TEST_CASE(Constructor_GivenEmptyVoxelGrid_MajorantsAreNull)
+    {
+        const SparseVoxelGrid voxel_grid(17, 17, 17, 1);
+        const MajorantGrid majorant_grid(voxel_grid, 0);
+
+        EXPECT_EQ(3, majorant_grid.get_xres());
+        EXPECT_EQ(0.0f, majorant_grid.get_max_majorant());
+    }
+
+    TEST_CASE(Constructor_GivenVoxelOnBrickBoundary_BoundsBothCells)
+    {
+        SparseVoxelGrid voxel_grid(17, 17, 17, 1);
+        voxel_grid.voxel(8, 0, 0)[0] = 2.0f;
+
+        const MajorantGrid majorant_grid(voxel_grid, 0);
+
+        EXPECT_EQ(2.0f, majorant_grid.get_majorant(0, 0, 0));
+        EXPECT_EQ(2.0f, majorant_grid.get_majorant(1, 0, 0));
+        EXPECT_EQ(0.0f, majorant_grid.get_majorant(2, 0, 0));
+        EXPECT_EQ(0.0f, majorant_grid.get_majorant(0, 1, 0));
+    }
+
+    TEST_CASE(Majorants_BoundLinearLookups)
+    {
+        const size_t Resolution = 21;
+        SparseVoxelGrid voxel_grid(Resolution, Resolution, Resolution, 1);
+
+        MersenneTwister rng;
+        for (size_t i = 0; i < 200; ++i)
+        {
+            const size_t x = rand_int1(rng, 0, static_cast<std::int32_t>(Resolution) - 1);
+            const size_t y = rand_int1(rng, 0, static_cast<std::int32_t>(Resolution) - 1);
+            const size_t z = rand_int1(rng, 0, static_cast<std::int32_t>(Resolution) - 1);
+            voxel_grid.voxel(x, y, z)[0] = rand_float1(rng);
+        }
+
+        const MajorantGrid majorant_grid(voxel_grid, 0);
+        const double scale = static_cast<double>(Resolution - 1) / SparseVoxelGrid::BrickSize;
+
+        for (size_t i = 0; i < 10000; ++i)
+        {
+            const Vector3d point(rand_double1(rng), rand_double1(rng), rand_double1(rng));
+
+            float value;
+            voxel_grid.linear_lookup(point, &value);
+
+            const float majorant =
+                majorant_grid.get_majorant(
+                    std::min(truncate<size_t>(point.x * scale), majorant_grid.get_xres() - 1),
+                    std::min(truncate<size_t>(point.y * scale), majorant_grid.get_yres() - 1),
+                    std::min(truncate<size_t>(point.z * scale), majorant_grid.get_zres() - 1));
+
+            EXPECT_TRUE(value <= majorant);
+        }
+    }
+
+    TEST_CASE(Traverse_GivenRayAlongX_VisitsContiguousCellsFrontToBack)
+    {
+        SparseVoxelGrid voxel_grid(33, 9, 9, 1);
+        voxel_grid.voxel(20, 4, 4)[0] = 1.0f;
+
+        const MajorantGrid majorant_grid(voxel_grid, 0);
+
+        SegmentCollector collector;
+        majorant_grid.traverse(
+            Vector3d(-1.0, 0.5, 0.5),
+            Vector3d(1.0, 0.0, 0.0),
+            0.0,
+            10.0,
+            collector);
+
+        ASSERT_EQ(4, collector.m_segments.size());
+        EXPECT_FEQ(1.0, collector.m_segments[0].m_t0);
+        EXPECT_FEQ(2.0, collector.m_segments[3].m_t1);
+
+        for (size_t i = 1; i < collector.m_segments.size(); ++i)
+            EXPECT_FEQ(collector.m_segments[i - 1].m_t1, collector.m_segments[i].m_t0);
+
+        EXPECT_EQ(0.0f, collector.m_segments[0].m_majorant);
+        EXPECT_EQ(1.0f, collector.m_segments[2].m_majorant);
+    }
+
+    TEST_CASE(Traverse_GivenRayMissingGrid_VisitsNoCell)
+    {
+        SparseVoxelGrid voxel_grid(17, 17, 17, 1);
+        const MajorantGrid majorant_grid(voxel_grid, 0);
+
+        SegmentCollector collector;
+        majorant_grid.traverse(
+            Vector3d(-1.0, 2.0, 0.5),
+            Vector3d(1.0, 0.0, 0.0),
+            0.0,
+            10.0,
+            collector);
+
+        EXPECT_TRUE(collector.m_segments.empty());
+    }
+}
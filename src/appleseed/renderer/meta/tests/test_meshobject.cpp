@@ -0,0 +1,189 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/modeling/object/meshobject.h"
+#include "renderer/modeling/object/triangle.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/xoroshiro128plus.h"
+#include "foundation/math/sampling/mappings.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Modeling_Object_MeshObject)
+{
+    bool are_equal(const Triangle& lhs, const Triangle& rhs)
+    {
+        return
+            lhs.m_v0 == rhs.m_v0 && lhs.m_v1 == rhs.m_v1 && lhs.m_v2 == rhs.m_v2 &&
+            lhs.m_n0 == rhs.m_n0 && lhs.m_n1 == rhs.m_n1 && lhs.m_n2 == rhs.m_n2 &&
+            lhs.m_a0 == rhs.m_a0 && lhs.m_a1 == rhs.m_a1 && lhs.m_a2 == rhs.m_a2 &&
+            lhs.m_pa == rhs.m_pa;
+    }
+
+    TEST_CASE(CompactTriangle_GivenTriangleWithVertexFeatures_RoundTrips)
+    {
+        const Triangle triangle(3, 5, 7, 3, 5, 7, 3, 5, 7, 12);
+
+        ASSERT_TRUE(CompactTriangle::can_represent(triangle));
+        EXPECT_TRUE(are_equal(triangle, CompactTriangle(triangle).expand()));
+    }
+
+    TEST_CASE(CompactTriangle_GivenTriangleWithoutVertexFeatures_RoundTrips)
+    {
+        const Triangle triangle(3, 5, 7, 12);
+
+        ASSERT_TRUE(CompactTriangle::can_represent(triangle));
+        EXPECT_TRUE(are_equal(triangle, CompactTriangle(triangle).expand()));
+    }
+
+    TEST_CASE(CompactTriangle_GivenTriangleWithVertexNormalsOnly_RoundTrips)
+    {
+        const Triangle triangle(3, 5, 7, 3, 5, 7, 12);
+
+        ASSERT_TRUE(CompactTriangle::can_represent(triangle));
+        EXPECT_TRUE(are_equal(triangle, CompactTriangle(triangle).expand()));
+    }
+
+    TEST_CASE(CompactTriangle_GivenTriangleWithSharedVertexNormal_CannotRepresentIt)
+    {
+        EXPECT_FALSE(CompactTriangle::can_represent(Triangle(3, 5, 7, 0, 0, 0, 12)));
+    }
+
+    // Build a mesh whose triangles can all be compacted, with random unit normals
+    // and tangents and random texture coordinates in [0, 1)^2.
+    auto_release_ptr<MeshObject> create_compactable_mesh()
+    {
+        auto_release_ptr<MeshObject> mesh(MeshObjectFactory().create("mesh", ParamArray()));
+
+        const size_t VertexCount = 256;
+        Xoroshiro128plus rng(349, 684658);
+
+        for (size_t i = 0; i < VertexCount; ++i)
+        {
+            mesh->push_vertex(GVector3(static_cast<GScalar>(i), 0.0f, 0.0f));
+
+            const Vector3f n = sample_sphere_uniform(Vector2f(rand_float1(rng), rand_float1(rng)));
+            mesh->push_vertex_normal(GVector3(n));
+
+            const Vector3f t = sample_sphere_uniform(Vector2f(rand_float1(rng), rand_float1(rng)));
+            mesh->push_vertex_tangent(GVector3(t));
+
+            mesh->push_tex_coords(GVector2(rand_float1(rng), rand_float1(rng)));
+        }
+
+        for (size_t i = 0; i + 2 < VertexCount; ++i)
+            mesh->push_triangle(Triangle(i, i + 1, i + 2, i, i + 1, i + 2, i, i + 1, i + 2, i % 4));
+
+        return mesh;
+    }
+
+    TEST_CASE(Compact_PreservesTrianglesAndDecodesFeaturesWithinErrorBounds)
+    {
+        auto_release_ptr<MeshObject> reference = create_compactable_mesh();
+        auto_release_ptr<MeshObject> mesh = create_compactable_mesh();
+
+        mesh->compact();
+
+        ASSERT_TRUE(mesh->is_compact());
+
+        ASSERT_EQ(reference->get_triangle_count(), mesh->get_triangle_count());
+        for (size_t i = 0; i < mesh->get_triangle_count(); ++i)
+        {
+            const MeshObject& const_reference = reference.ref();
+            const MeshObject& const_mesh = mesh.ref();
+            EXPECT_TRUE(are_equal(const_reference.get_triangle(i), const_mesh.get_triangle(i)));
+        }
+
+        // Octahedral encoding on 32 bits keeps unit vectors within a fraction of a degree.
+        ASSERT_EQ(reference->get_vertex_normal_count(), mesh->get_vertex_normal_count());
+        for (size_t i = 0; i < mesh->get_vertex_normal_count(); ++i)
+            EXPECT_FEQ_EPS(1.0f, static_cast<float>(dot(reference->get_vertex_normal(i), mesh->get_vertex_normal(i))), 1.0e-6f);
+
+        ASSERT_EQ(reference->get_vertex_tangent_count(), mesh->get_vertex_tangent_count());
+        for (size_t i = 0; i < mesh->get_vertex_tangent_count(); ++i)
+            EXPECT_FEQ_EPS(1.0f, static_cast<float>(dot(reference->get_vertex_tangent(i), mesh->get_vertex_tangent(i))), 1.0e-6f);
+
+        // Half floats have an 11-bit significand: in [0, 1), the rounding error is at most 2^-12.
+        const float MaxUVError = 2.5e-4f;
+        ASSERT_EQ(reference->get_tex_coords_count(), mesh->get_tex_coords_count());
+        for (size_t i = 0; i < mesh->get_tex_coords_count(); ++i)
+        {
+            const GVector2 expected_uv = reference->get_tex_coords(i);
+            const GVector2 uv = mesh->get_tex_coords(i);
+            EXPECT_LT(MaxUVError, static_cast<float>(std::abs(expected_uv[0] - uv[0])));
+            EXPECT_LT(MaxUVError, static_cast<float>(std::abs(expected_uv[1] - uv[1])));
+        }
+    }
+
+    TEST_CASE(GetTriangle_GivenCompactMesh_SwitchesToRegularStorage)
+    {
+        auto_release_ptr<MeshObject> mesh = create_compactable_mesh();
+        mesh->compact();
+
+        Triangle& triangle = mesh->get_triangle(1);
+        triangle.m_pa = 3;
+
+        EXPECT_FALSE(mesh->is_compact());
+        EXPECT_EQ(254, mesh->get_triangle_count());
+        EXPECT_EQ(3, static_cast<const MeshObject&>(mesh.ref()).get_triangle(1).m_pa);
+        EXPECT_EQ(2, static_cast<const MeshObject&>(mesh.ref()).get_triangle(2).m_v0);
+        EXPECT_EQ(256, mesh->get_vertex_normal_count());
+        EXPECT_EQ(256, mesh->get_tex_coords_count());
+        EXPECT_EQ(256, mesh->get_vertex_tangent_count());
+    }
+
+    TEST_CASE(ClearTriangles_GivenCompactMesh_AllowsInsertingTriangles)
+    {
+        auto_release_ptr<MeshObject> mesh = create_compactable_mesh();
+        mesh->compact();
+
+        mesh->clear_triangles();
+
+        EXPECT_FALSE(mesh->is_compact());
+        EXPECT_EQ(0, mesh->get_triangle_count());
+
+        mesh->push_triangle(Triangle(0, 1, 2, 7));
+
+        ASSERT_EQ(1, mesh->get_triangle_count());
+        EXPECT_EQ(7, static_cast<const MeshObject&>(mesh.ref()).get_triangle(0).m_pa);
+    }
+}
@@ -28,12 +28,18 @@
 //
 
 // appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/modeling/object/object.h"
 #include "renderer/modeling/project/project.h"
 #include "renderer/modeling/project/projectfilereader.h"
 #include "renderer/modeling/project/projectfilewriter.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/scene.h"
 
 // appleseed.foundation headers.
 #include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/log.h"
 #include "foundation/utility/test.h"
 #include "foundation/utility/testutils.h"
 
@@ -41,7 +47,10 @@
 #include "boost/filesystem.hpp"
 
 // Standard headers.
+#include <cstddef>
 #include <exception>
+#include <string>
+#include <vector>
 
 using namespace foundation;
 using namespace renderer;
@@ -100,6 +109,90 @@ TEST_SUITE(Renderer_Modeling_Project_ProjectFileReader)
         }
     }
 
+    // Return the names of the objects of an assembly, in container order.
+    std::vector<std::string> get_object_names(const Assembly& assembly)
+    {
+        std::vector<std::string> names;
+
+        for (const Object& object : assembly.objects())
+            names.emplace_back(object.get_name());
+
+        return names;
+    }
+
+    void read_nested_assemblies_project(
+        const size_t                thread_count,
+        std::vector<std::string>&   outer_object_names,
+        std::vector<std::string>&   inner_object_names)
+    {
+        ProjectFileReader reader;
+        reader.set_thread_count(thread_count);
+
+        auto_release_ptr<Project> project =
+            reader.read(
+                "unit tests/inputs/test_projectfilereader_nestedassemblies.appleseed",
+                "../../../schemas/project.xsd");            // path relative to input file
+
+        if (project.get() == nullptr)
+            return;
+
+        const Assembly* outer = project->get_scene()->assemblies().get_by_name("outer");
+        if (outer == nullptr)
+            return;
+
+        outer_object_names = get_object_names(*outer);
+
+        const Assembly* inner = outer->assemblies().get_by_name("inner");
+        if (inner == nullptr)
+            return;
+
+        inner_object_names = get_object_names(*inner);
+    }
+
+    const char* ExpectedOuterObjectNames[] = { "first.quad", "sphere", "second.quad" };
+    const char* ExpectedInnerObjectNames[] = { "nested.quad" };
+
+    TEST_CASE(Read_GivenNestedAssemblies_InsertsObjectsIntoTheirAssemblyInDocumentOrder)
+    {
+        std::vector<std::string> outer_object_names, inner_object_names;
+        read_nested_assemblies_project(4, outer_object_names, inner_object_names);
+
+        // Objects are inserted in document order, whether or not they were created in parallel.
+        ASSERT_EQ(3, outer_object_names.size());
+        EXPECT_SEQUENCE_EQ(3, ExpectedOuterObjectNames, &outer_object_names[0]);
+
+        // Objects declared in a nested assembly are inserted into that assembly only.
+        ASSERT_EQ(1, inner_object_names.size());
+        EXPECT_SEQUENCE_EQ(1, ExpectedInnerObjectNames, &inner_object_names[0]);
+    }
+
+    TEST_CASE(Read_GivenNestedAssembliesAndSingleThread_InsertsObjectsIntoTheirAssemblyInDocumentOrder)
+    {
+        std::vector<std::string> outer_object_names, inner_object_names;
+        read_nested_assemblies_project(1, outer_object_names, inner_object_names);
+
+        ASSERT_EQ(3, outer_object_names.size());
+        EXPECT_SEQUENCE_EQ(3, ExpectedOuterObjectNames, &outer_object_names[0]);
+        ASSERT_EQ(1, inner_object_names.size());
+        EXPECT_SEQUENCE_EQ(1, ExpectedInnerObjectNames, &inner_object_names[0]);
+    }
+
+    TEST_CASE(Read_GivenDuplicateAssembly_DropsItAndReturnsNull)
+    {
+        // Mute the expected error about the duplicate assembly. The objects declared in
+        // the dropped assembly (whose mesh file does not exist) must simply be skipped.
+        SaveLogFormatterConfig save_global_logger_config(global_logger());
+        global_logger().set_format(LogMessage::Error, std::string());
+
+        ProjectFileReader reader;
+        auto_release_ptr<Project> project =
+            reader.read(
+                "unit tests/inputs/test_projectfilereader_duplicateassemblies.appleseed",
+                "../../../schemas/project.xsd");            // path relative to input file
+
+        EXPECT_EQ(0, project.get());
+    }
+
 #if 0
 
     // This test waits for a brilliant solution on how to invoke it without emitting an error message.
@@ -82,4 +82,21 @@ TEST_SUITE(Renderer_Kernel_Rendering_Progressive_SampleCounter)
 
         EXPECT_EQ(0, sample_counter.reserve(3));
     }
+
+    TEST_CASE(Reserve_ReserveOneAfterStopGivenMaxSampleCountIsThree_ReturnsZero)
+    {
+        SampleCounter sample_counter(3);
+        sample_counter.stop();
+
+        EXPECT_EQ(0, sample_counter.reserve(1));
+    }
+
+    TEST_CASE(Reserve_ReserveOneAfterStopThenClear_ReturnsOne)
+    {
+        SampleCounter sample_counter(3);
+        sample_counter.stop();
+        sample_counter.clear();
+
+        EXPECT_EQ(1, sample_counter.reserve(1));
+    }
 }
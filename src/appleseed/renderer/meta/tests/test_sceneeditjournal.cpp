@@ -0,0 +1,319 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/modeling/edf/diffuseedf.h"
+#include "renderer/modeling/edf/edf.h"
+#include "renderer/modeling/entity/entity.h"
+#include "renderer/modeling/material/genericmaterial.h"
+#include "renderer/modeling/material/material.h"
+#include "renderer/modeling/object/object.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/assemblyinstance.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/objectinstance.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/modeling/scene/sceneeditjournal.h"
+#include "renderer/utility/paramarray.h"
+#include "renderer/utility/testutils.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/color.h"
+#include "foundation/math/matrix.h"
+#include "foundation/math/transform.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/containers/dictionary.h"
+#include "foundation/utility/test.h"
+#include "foundation/utility/version.h"
+
+// Standard headers.
+#include <string>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Modeling_Scene_SceneEditJournal)
+{
+    TEST_CASE(Empty_GivenNewJournal_ReturnsTrue)
+    {
+        SceneEditJournal journal;
+
+        EXPECT_TRUE(journal.empty());
+        EXPECT_FALSE(journal.has_structure_edits());
+        EXPECT_EQ(0, journal.size());
+    }
+
+    TEST_CASE(Record_GivenEntityEdit_RecordsEntityAndEditType)
+    {
+        auto_release_ptr<Assembly> assembly(AssemblyFactory().create("assembly", ParamArray()));
+        SceneEditJournal journal;
+
+        journal.record(assembly.ref(), SceneEditJournal::GeometryEdit);
+
+        ASSERT_EQ(1, journal.size());
+        EXPECT_FALSE(journal.empty());
+        EXPECT_FALSE(journal.has_structure_edits());
+
+        Entity* entity;
+        SceneEditJournal::EditType type;
+        journal.get_edit(0, entity, type);
+
+        EXPECT_EQ(assembly.get(), entity);
+        EXPECT_EQ(SceneEditJournal::GeometryEdit, type);
+    }
+
+    TEST_CASE(RecordStructureEdit_MakesJournalNonEmpty)
+    {
+        SceneEditJournal journal;
+
+        journal.record_structure_edit();
+
+        EXPECT_FALSE(journal.empty());
+        EXPECT_TRUE(journal.has_structure_edits());
+        EXPECT_EQ(0, journal.size());
+    }
+
+    TEST_CASE(Clear_DiscardsAllEdits)
+    {
+        auto_release_ptr<Assembly> assembly(AssemblyFactory().create("assembly", ParamArray()));
+        SceneEditJournal journal;
+        journal.record(assembly.ref(), SceneEditJournal::TransformEdit);
+        journal.record_structure_edit();
+
+        journal.clear();
+
+        EXPECT_TRUE(journal.empty());
+        EXPECT_FALSE(journal.has_structure_edits());
+        EXPECT_EQ(0, journal.size());
+    }
+
+    //
+    // Scene with two assemblies:
+    //   - assembly1 contains a large object defining the scene's bounding box, a small
+    //     object instance and a light-emitting object instance;
+    //   - assembly2 contains a small object instance.
+    //
+
+    struct TestScene
+      : public TestSceneBase
+    {
+        Assembly*   m_assembly1;
+        Assembly*   m_assembly2;
+
+        TestScene()
+        {
+            create_color_entity("light_radiance", Color3f(1.0f));
+
+            m_assembly1 = create_assembly("assembly1");
+            m_assembly2 = create_assembly("assembly2");
+
+            ParamArray edf_params;
+            edf_params.insert("radiance", "light_radiance");
+            m_assembly1->edfs().insert(DiffuseEDFFactory().create("light_edf", edf_params));
+
+            ParamArray material_params;
+            material_params.insert("edf", "light_edf");
+            m_assembly1->materials().insert(GenericMaterialFactory().create("light_material", material_params));
+
+            m_assembly1->objects().insert(
+                auto_release_ptr<Object>(
+                    new BoundingBoxObject("bounds", GAABB3(GVector3(-10.0), GVector3(10.0)))));
+
+            create_object_instance(*m_assembly1, "bounds_inst", "bounds", StringDictionary());
+            create_object_instance(*m_assembly1, "box_inst", "box", StringDictionary());
+            create_object_instance(
+                *m_assembly1,
+                "light_inst",
+                "box",
+                StringDictionary().insert("default", "light_material"));
+            create_object_instance(*m_assembly2, "box_inst", "box", StringDictionary());
+        }
+
+        Assembly* create_assembly(const char* name)
+        {
+            auto_release_ptr<Assembly> assembly(AssemblyFactory().create(name, ParamArray()));
+
+            assembly->objects().insert(
+                auto_release_ptr<Object>(
+                    new BoundingBoxObject("box", GAABB3(GVector3(-1.0), GVector3(1.0)))));
+
+            const std::string instance_name = std::string(name) + "_inst";
+            m_scene.assembly_instances().insert(
+                AssemblyInstanceFactory::create(instance_name.c_str(), ParamArray(), name));
+
+            Assembly* assembly_ptr = assembly.get();
+            m_scene.assemblies().insert(assembly);
+            return assembly_ptr;
+        }
+
+        static void create_object_instance(
+            Assembly&                   assembly,
+            const char*                 name,
+            const char*                 object_name,
+            const StringDictionary&     front_material_mappings)
+        {
+            assembly.object_instances().insert(
+                ObjectInstanceFactory::create(
+                    name,
+                    ParamArray(),
+                    object_name,
+                    Transformd::identity(),
+                    front_material_mappings));
+        }
+
+        static ObjectInstance& get_object_instance(const Assembly& assembly, const char* name)
+        {
+            return *assembly.object_instances().get_by_name(name);
+        }
+
+        static void translate(ObjectInstance& object_instance, const double x)
+        {
+            object_instance.set_transform(
+                Transformd::from_local_to_parent(
+                    Matrix4d::make_translation(Vector3d(x, 0.0, 0.0))));
+        }
+    };
+
+    TEST_CASE(ApplySceneEditsInPlace_GivenEmptyJournal_ReturnsFalse)
+    {
+        TestScene scene;
+        TestSceneContext context(scene);
+        SceneEditJournal journal;
+
+        bool emitters_moved;
+        const bool applied = apply_scene_edits_in_place(journal, scene.m_scene, emitters_moved);
+
+        EXPECT_FALSE(applied);
+    }
+
+    TEST_CASE(ApplySceneEditsInPlace_GivenStructureEdit_ReturnsFalse)
+    {
+        TestScene scene;
+        TestSceneContext context(scene);
+        SceneEditJournal journal;
+        journal.record(TestScene::get_object_instance(*scene.m_assembly1, "box_inst"), SceneEditJournal::TransformEdit);
+        journal.record_structure_edit();
+
+        bool emitters_moved;
+        const bool applied = apply_scene_edits_in_place(journal, scene.m_scene, emitters_moved);
+
+        EXPECT_FALSE(applied);
+    }
+
+    TEST_CASE(ApplySceneEditsInPlace_GivenObjectInstanceTransformEdit_BumpsVersionOfItsAssemblyOnly)
+    {
+        TestScene scene;
+        TestSceneContext context(scene);
+        const VersionID assembly1_version = scene.m_assembly1->get_version_id();
+        const VersionID assembly2_version = scene.m_assembly2->get_version_id();
+
+        ObjectInstance& object_instance = TestScene::get_object_instance(*scene.m_assembly1, "box_inst");
+        TestScene::translate(object_instance, 2.0);
+
+        SceneEditJournal journal;
+        journal.record(object_instance, SceneEditJournal::TransformEdit);
+
+        bool emitters_moved;
+        const bool applied = apply_scene_edits_in_place(journal, scene.m_scene, emitters_moved);
+
+        ASSERT_TRUE(applied);
+        EXPECT_FALSE(emitters_moved);
+        EXPECT_NEQ(assembly1_version, scene.m_assembly1->get_version_id());
+        EXPECT_EQ(assembly2_version, scene.m_assembly2->get_version_id());
+        EXPECT_EQ(1, journal.size());
+    }
+
+    TEST_CASE(ApplySceneEditsInPlace_GivenEmittingObjectInstanceTransformEdit_ReportsMovedEmitters)
+    {
+        TestScene scene;
+        TestSceneContext context(scene);
+
+        ObjectInstance& object_instance = TestScene::get_object_instance(*scene.m_assembly1, "light_inst");
+        TestScene::translate(object_instance, 2.0);
+
+        SceneEditJournal journal;
+        journal.record(object_instance, SceneEditJournal::TransformEdit);
+
+        bool emitters_moved;
+        const bool applied = apply_scene_edits_in_place(journal, scene.m_scene, emitters_moved);
+
+        ASSERT_TRUE(applied);
+        EXPECT_TRUE(emitters_moved);
+    }
+
+    TEST_CASE(ApplySceneEditsInPlace_GivenTransformEditChangingSceneBoundingBox_ReturnsFalse)
+    {
+        TestScene scene;
+        TestSceneContext context(scene);
+        const VersionID assembly2_version = scene.m_assembly2->get_version_id();
+
+        ObjectInstance& object_instance = TestScene::get_object_instance(*scene.m_assembly2, "box_inst");
+        TestScene::translate(object_instance, 100.0);
+
+        SceneEditJournal journal;
+        journal.record(object_instance, SceneEditJournal::TransformEdit);
+
+        bool emitters_moved;
+        const bool applied = apply_scene_edits_in_place(journal, scene.m_scene, emitters_moved);
+
+        EXPECT_FALSE(applied);
+        EXPECT_EQ(assembly2_version, scene.m_assembly2->get_version_id());
+    }
+
+    TEST_CASE(ApplySceneEditsInPlace_GivenMaterialBindingEditOnEmittingObjectInstance_ReturnsFalse)
+    {
+        TestScene scene;
+        TestSceneContext context(scene);
+
+        SceneEditJournal journal;
+        journal.record(
+            TestScene::get_object_instance(*scene.m_assembly1, "light_inst"),
+            SceneEditJournal::MaterialBindingEdit);
+
+        bool emitters_moved;
+        const bool applied = apply_scene_edits_in_place(journal, scene.m_scene, emitters_moved);
+
+        EXPECT_FALSE(applied);
+    }
+
+    TEST_CASE(ApplySceneEditsInPlace_GivenGeometryEditOfEmittingObject_ReturnsFalse)
+    {
+        TestScene scene;
+        TestSceneContext context(scene);
+
+        SceneEditJournal journal;
+        journal.record(*scene.m_assembly1->objects().get_by_name("box"), SceneEditJournal::GeometryEdit);
+
+        bool emitters_moved;
+        const bool applied = apply_scene_edits_in_place(journal, scene.m_scene, emitters_moved);
+
+        EXPECT_FALSE(applied);
+    }
+}
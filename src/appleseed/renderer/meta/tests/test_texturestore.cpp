@@ -45,5 +45,27 @@ TEST_SUITE(Renderer_Kernel_Texturing_TextureStore_TileKey)
         EXPECT_EQ(12345, key.m_texture_uid);
         EXPECT_EQ(32323, key.get_tile_x());
         EXPECT_EQ(56565, key.get_tile_y());
+        EXPECT_EQ(0, key.m_level);
+    }
+
+    TEST_CASE(KeysOfDifferentLevelsAreDifferent)
+    {
+        const TextureStore::TileKey key0(123, 12345, 3, 5, 0);
+        const TextureStore::TileKey key1(123, 12345, 3, 5, 1);
+
+        EXPECT_TRUE(key0 != key1);
+        EXPECT_TRUE(key0 < key1);
+    }
+}
+
+TEST_SUITE(Renderer_Kernel_Texturing_TextureStore)
+{
+    TEST_CASE(GetLevelSize)
+    {
+        EXPECT_EQ(1024, TextureStore::get_level_size(1024, 0));
+        EXPECT_EQ(512, TextureStore::get_level_size(1024, 1));
+        EXPECT_EQ(2, TextureStore::get_level_size(5, 1));
+        EXPECT_EQ(1, TextureStore::get_level_size(5, 3));
+        EXPECT_EQ(1, TextureStore::get_level_size(5, 10));
     }
 }
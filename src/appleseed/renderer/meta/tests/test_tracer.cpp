@@ -939,6 +939,65 @@ TEST_SUITE(Renderer_Kernel_Lighting_Tracer)
 
 #endif
 
+    struct SceneWithTwoTransparentOccluders
+      : public SceneBase
+    {
+        SceneWithTwoTransparentOccluders()
+        {
+            create_plane_object_instance("plane_inst1", Vector3d(2.0, 0.0, 0.0), "transparent_material");
+            create_plane_object_instance("plane_inst2", Vector3d(4.0, 0.0, 0.0), "transparent_material");
+        }
+    };
+
+    typedef FixtureParams<SceneWithTwoTransparentOccluders, false> SceneWithTwoTransparentOccludersParams;
+
+    TEST_CASE_F(TraceSimple_GivenTwoTransparentOccluders, Fixture<SceneWithTwoTransparentOccludersParams>)
+    {
+        Spectrum transmission;
+        ShadingRay ray(
+            Vector3d(0.0, 0.0, 0.0),
+            Vector3d(1.0, 0.0, 0.0),
+            ShadingRay::Time(),
+            VisibilityFlags::ShadowRay,
+            0);
+        m_tracer.trace_simple(
+            m_shading_context,
+            ray,
+            transmission);
+
+        EXPECT_FEQ(Spectrum(0.25f), transmission);
+    }
+
+    TEST_CASE_F(TraceBetweenSimple_GivenTwoTransparentOccluders_GivenTargetBetweenOccluders, Fixture<SceneWithTwoTransparentOccludersParams>)
+    {
+        Spectrum transmission;
+        m_tracer.trace_between_simple(
+            m_shading_context,
+            Vector3d(0.0, 0.0, 0.0),
+            Vector3d(3.0, 0.0, 0.0),
+            ShadingRay::Time(),
+            VisibilityFlags::ShadowRay,
+            0,
+            transmission);
+
+        EXPECT_FEQ(Spectrum(0.5f), transmission);
+    }
+
+    TEST_CASE_F(TraceBetweenSimple_GivenTwoTransparentOccluders_GivenTargetPastOccluders, Fixture<SceneWithTwoTransparentOccludersParams>)
+    {
+        Spectrum transmission;
+        m_tracer.trace_between_simple(
+            m_shading_context,
+            Vector3d(0.0, 0.0, 0.0),
+            Vector3d(5.0, 0.0, 0.0),
+            ShadingRay::Time(),
+            VisibilityFlags::ShadowRay,
+            0,
+            transmission);
+
+        EXPECT_FEQ(Spectrum(0.25f), transmission);
+    }
+
     struct SceneWithTwoOpaqueOccluders
       : public SceneBase
     {
@@ -0,0 +1,291 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/intersection/intersector.h"
+#include "renderer/kernel/intersection/tracecontext.h"
+#include "renderer/kernel/intersection/triangletree.h"
+#include "renderer/kernel/shading/shadingpoint.h"
+#include "renderer/kernel/shading/shadingray.h"
+#include "renderer/kernel/texturing/texturecache.h"
+#include "renderer/kernel/texturing/texturestore.h"
+#include "renderer/modeling/object/meshobject.h"
+#include "renderer/modeling/object/object.h"
+#include "renderer/modeling/object/triangle.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/assemblyinstance.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/objectinstance.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/modeling/scene/visibilityflags.h"
+#include "renderer/utility/bbox.h"
+#include "renderer/utility/paramarray.h"
+#include "renderer/utility/testutils.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/matrix.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/transform.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/containers/dictionary.h"
+#include "foundation/utility/job.h"
+#include "foundation/utility/test.h"
+#include "foundation/utility/uid.h"
+
+// Standard headers.
+#include <cmath>
+#include <cstddef>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Intersection_TriangleTree)
+{
+    const size_t GridSize = 8;
+
+    // Set the vertices of a grid of GridSize x GridSize quads covering [-1, 1] x [-1, 1],
+    // displaced along the Z axis by a wave of a given amplitude.
+    void set_grid_vertices(MeshObject& mesh, const double amplitude)
+    {
+        mesh.clear_vertices();
+
+        for (size_t j = 0; j <= GridSize; ++j)
+        {
+            for (size_t i = 0; i <= GridSize; ++i)
+            {
+                const double x = -1.0 + 2.0 * i / GridSize;
+                const double y = -1.0 + 2.0 * j / GridSize;
+                const double z = amplitude * std::sin(3.0 * x) * std::cos(2.0 * y);
+
+                mesh.push_vertex(GVector3(x + 0.1 * amplitude * y, y, z));
+            }
+        }
+    }
+
+    // A single wavy grid, instanced without transform.
+    template <bool UseSpatialSplits>
+    struct TestScene
+      : public TestSceneBase
+    {
+        Assembly*   m_assembly;
+        MeshObject* m_mesh;
+
+        explicit TestScene(const double amplitude)
+        {
+            // Never rebuild refit trees because of their SAH cost.
+            ParamArray assembly_params;
+            assembly_params.insert_path("acceleration_structure.algorithm", UseSpatialSplits ? "sbvh" : "bvh");
+            assembly_params.insert_path("acceleration_structure.max_refit_sah_cost_growth", 1000.0);
+
+            auto_release_ptr<Assembly> assembly(AssemblyFactory().create("assembly", assembly_params));
+
+            auto_release_ptr<MeshObject> mesh(MeshObjectFactory().create("mesh", ParamArray()));
+            set_grid_vertices(mesh.ref(), amplitude);
+
+            for (size_t j = 0; j < GridSize; ++j)
+            {
+                for (size_t i = 0; i < GridSize; ++i)
+                {
+                    const size_t v0 = j * (GridSize + 1) + i;
+                    const size_t v1 = v0 + 1;
+                    const size_t v2 = v0 + GridSize + 1;
+                    const size_t v3 = v2 + 1;
+
+                    mesh->push_triangle(Triangle(v0, v1, v3, 0));
+                    mesh->push_triangle(Triangle(v0, v3, v2, 0));
+                }
+            }
+
+            m_mesh = mesh.get();
+            assembly->objects().insert(auto_release_ptr<Object>(mesh));
+
+            assembly->object_instances().insert(
+                ObjectInstanceFactory::create(
+                    "mesh_instance",
+                    ParamArray(),
+                    "mesh",
+                    Transformd::identity(),
+                    StringDictionary()));
+
+            m_scene.assembly_instances().insert(
+                auto_release_ptr<AssemblyInstance>(
+                    AssemblyInstanceFactory::create(
+                        "assembly_instance",
+                        ParamArray(),
+                        "assembly")));
+
+            m_assembly = assembly.get();
+            m_scene.assemblies().insert(assembly);
+        }
+
+        GAABB3 compute_assembly_bbox() const
+        {
+            return
+                compute_parent_bbox<GAABB3>(
+                    m_assembly->object_instances().begin(),
+                    m_assembly->object_instances().end());
+        }
+    };
+
+    struct SceneTracer
+    {
+        TraceContext    m_trace_context;
+        TextureStore    m_texture_store;
+        TextureCache    m_texture_cache;
+        Intersector     m_intersector;
+
+        explicit SceneTracer(const Scene& scene)
+          : m_trace_context(scene)
+          , m_texture_store(scene)
+          , m_texture_cache(m_texture_store)
+          , m_intersector(m_trace_context, m_texture_cache)
+        {
+            m_trace_context.update();
+        }
+
+        // Trace a ray parallel to the Z axis toward the XY plane, return the hit distance or -1.0 on a miss.
+        double trace(const double x, const double y)
+        {
+            const ShadingRay ray(
+                Vector3d(x, y, 5.0),
+                Vector3d(0.0, 0.0, -1.0),
+                0.0,                                // tmin
+                10.0,                               // tmax
+                ShadingRay::Time(),
+                VisibilityFlags::CameraRay,
+                0);                                 // depth
+
+            ShadingPoint shading_point;
+            return m_intersector.trace(ray, shading_point) ? shading_point.get_distance() : -1.0;
+        }
+    };
+
+    // Move the vertices of a scene whose trees were built, let the trace context refit them,
+    // then compare intersections with the ones of a scene whose trees are built from the moved
+    // vertices. Return the number of rays whose intersections differ.
+    template <bool UseSpatialSplits>
+    size_t count_refit_and_rebuilt_tree_mismatches(size_t& hit_count)
+    {
+        TestScene<UseSpatialSplits> refit_scene(0.1);
+        TestSceneContext refit_scene_context(refit_scene);
+        SceneTracer refit_tracer(refit_scene.m_scene);
+
+        set_grid_vertices(*refit_scene.m_mesh, 0.3);
+        refit_scene.m_assembly->bump_version_id();
+        refit_tracer.m_trace_context.update();
+
+        TestScene<UseSpatialSplits> rebuilt_scene(0.3);
+        TestSceneContext rebuilt_scene_context(rebuilt_scene);
+        SceneTracer rebuilt_tracer(rebuilt_scene.m_scene);
+
+        const size_t RayGridSize = 49;
+        size_t mismatch_count = 0;
+        hit_count = 0;
+
+        for (size_t j = 0; j < RayGridSize; ++j)
+        {
+            for (size_t i = 0; i < RayGridSize; ++i)
+            {
+                // Cover the bounding box of the grid with a regular grid of rays.
+                const double x = -1.2 + 2.4 * i / (RayGridSize - 1);
+                const double y = -1.2 + 2.4 * j / (RayGridSize - 1);
+
+                const double refit_distance = refit_tracer.trace(x, y);
+                const double rebuilt_distance = rebuilt_tracer.trace(x, y);
+
+                if (!feq(refit_distance, rebuilt_distance, 1.0e-6))
+                    ++mismatch_count;
+
+                if (rebuilt_distance >= 0.0)
+                    ++hit_count;
+            }
+        }
+
+        return mismatch_count;
+    }
+
+    TEST_CASE(Refit_GivenMovedVertices_ReturnsTrue)
+    {
+        TestScene<false> scene(0.1);
+        TestSceneContext context(scene);
+        JobQueue job_queue;
+
+        TriangleTree tree(
+            TriangleTree::Arguments(
+                scene.m_scene,
+                new_guid(),
+                scene.compute_assembly_bbox(),
+                *scene.m_assembly,
+                job_queue));
+
+        set_grid_vertices(*scene.m_mesh, 0.3);
+
+        EXPECT_TRUE(tree.refit(scene.compute_assembly_bbox()));
+        EXPECT_EQ(2 * GridSize * GridSize, tree.get_static_triangle_count());
+    }
+
+    TEST_CASE(Refit_GivenRemovedTriangles_ReturnsFalse)
+    {
+        TestScene<false> scene(0.1);
+        TestSceneContext context(scene);
+        JobQueue job_queue;
+
+        TriangleTree tree(
+            TriangleTree::Arguments(
+                scene.m_scene,
+                new_guid(),
+                scene.compute_assembly_bbox(),
+                *scene.m_assembly,
+                job_queue));
+
+        scene.m_mesh->clear_triangles();
+        scene.m_mesh->push_triangle(Triangle(0, 1, GridSize + 2, 0));
+
+        EXPECT_FALSE(tree.refit(scene.compute_assembly_bbox()));
+    }
+
+    TEST_CASE(Trace_GivenMovedVertices_RefitTreeAndRebuiltTreeReturnSameHits)
+    {
+        size_t hit_count;
+        const size_t mismatch_count = count_refit_and_rebuilt_tree_mismatches<false>(hit_count);
+
+        EXPECT_EQ(0, mismatch_count);
+        EXPECT_GT(0, hit_count);
+    }
+
+    TEST_CASE(Trace_GivenMovedVerticesAndSpatialSplits_RefitTreeAndRebuiltTreeReturnSameHits)
+    {
+        size_t hit_count;
+        const size_t mismatch_count = count_refit_and_rebuilt_tree_mismatches<true>(hit_count);
+
+        EXPECT_EQ(0, mismatch_count);
+        EXPECT_GT(0, hit_count);
+    }
+}
@@ -0,0 +1,216 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "importancemapcache.h"
+
+// appleseed.foundation headers.
+#include "foundation/platform/memorymappedfile.h"
+#include "foundation/utility/bufferedfile.h"
+#include "foundation/utility/siphash.h"
+
+// Boost headers.
+#include "boost/filesystem.hpp"
+#include "boost/system/error_code.hpp"
+
+// Standard headers.
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+using namespace foundation;
+namespace bf = boost::filesystem;
+
+namespace renderer
+{
+
+namespace
+{
+    // Bump this number whenever the layout of cache files or the importance function changes.
+    const std::uint32_t ImportanceMapFormatVersion = 2;
+
+    const char ImportanceMapMagic[8] = { 'A', 'S', 'I', 'M', 'P', 'M', 'A', 'P' };
+
+    struct ImportanceMapHeader
+    {
+        char            m_magic[8];
+        std::uint32_t   m_version;
+        std::uint32_t   m_texel_size;
+        std::uint64_t   m_key;
+        std::uint64_t   m_width;
+        std::uint64_t   m_height;
+        std::uint64_t   m_checksum;     // checksum of the payloads
+    };
+
+    // Accumulate a row of payloads into a checksum.
+    std::uint64_t update_checksum(
+        const std::uint64_t     checksum,
+        const Color3f*          row,
+        const size_t            width)
+    {
+        return siphash24(checksum, siphash24(row, width * sizeof(Color3f)));
+    }
+}
+
+bool hash_importance_map_source_file(
+    const std::string&                  filepath,
+    std::uint64_t&                      hash)
+{
+    boost::system::error_code ec;
+
+    const bf::path path = bf::canonical(filepath, ec);
+    if (ec)
+        return false;
+
+    const std::uintmax_t size = bf::file_size(path, ec);
+    if (ec)
+        return false;
+
+    const std::time_t modification_time = bf::last_write_time(path, ec);
+    if (ec)
+        return false;
+
+    const std::string path_string = path.string();
+    hash = siphash24(path_string.c_str(), path_string.size());
+    hash = siphash24(hash, static_cast<std::uint64_t>(size));
+    hash = siphash24(hash, static_cast<std::uint64_t>(modification_time));
+
+    return true;
+}
+
+std::string get_importance_map_cache_filename(const std::uint64_t key)
+{
+    std::stringstream sstr;
+    sstr << std::hex << std::setw(16) << std::setfill('0') << key << ".impmap";
+    return sstr.str();
+}
+
+bool is_valid_importance_map_file(
+    const MemoryMappedFile&             file,
+    const std::uint64_t                 key,
+    const size_t                        width,
+    const size_t                        height)
+{
+    if (!file.is_open() || file.get_size() < sizeof(ImportanceMapHeader))
+        return false;
+
+    ImportanceMapHeader header;
+    std::memcpy(&header, file.get_data(), sizeof(ImportanceMapHeader));
+
+    if (std::memcmp(header.m_magic, ImportanceMapMagic, sizeof(ImportanceMapMagic)) != 0 ||
+        header.m_version != ImportanceMapFormatVersion ||
+        header.m_texel_size != sizeof(Color3f) ||
+        header.m_key != key ||
+        header.m_width != width ||
+        header.m_height != height ||
+        file.get_size() != sizeof(ImportanceMapHeader) + width * height * sizeof(Color3f))
+        return false;
+
+    const Color3f* payloads = get_importance_map_file_payloads(file);
+    std::uint64_t checksum = 0;
+
+    for (size_t y = 0; y < height; ++y)
+        checksum = update_checksum(checksum, payloads + y * width, width);
+
+    return checksum == header.m_checksum;
+}
+
+const Color3f* get_importance_map_file_payloads(const MemoryMappedFile& file)
+{
+    return reinterpret_cast<const Color3f*>(file.get_data() + sizeof(ImportanceMapHeader));
+}
+
+bool save_importance_map_file(
+    const std::string&                  filepath,
+    const std::uint64_t                 key,
+    const ImportanceMapSamplerType&     importance_sampler,
+    const size_t                        width,
+    const size_t                        height)
+{
+    // Make sure the cache directory exists.
+    const bf::path final_path(filepath);
+    boost::system::error_code ec;
+    bf::create_directories(final_path.parent_path(), ec);
+
+    // Write the map to a temporary file, then move it in place. The name of the temporary
+    // file is unique across processes, since several renders may share a cache directory.
+    const bf::path temp_path = bf::unique_path(final_path.string() + ".%%%%-%%%%-%%%%-%%%%.tmp", ec);
+    if (ec)
+        return false;
+
+    ImportanceMapHeader header;
+    std::memcpy(header.m_magic, ImportanceMapMagic, sizeof(ImportanceMapMagic));
+    header.m_version = ImportanceMapFormatVersion;
+    header.m_texel_size = static_cast<std::uint32_t>(sizeof(Color3f));
+    header.m_key = key;
+    header.m_width = width;
+    header.m_height = height;
+    header.m_checksum = 0;
+
+    // Compute the checksum of the payloads, stored in the header.
+    std::vector<Color3f> row(width);
+
+    for (size_t y = 0; y < height; ++y)
+    {
+        for (size_t x = 0; x < width; ++x)
+            row[x] = importance_sampler.get_payload(x, y);
+
+        header.m_checksum = update_checksum(header.m_checksum, &row[0], width);
+    }
+
+    BufferedFile file;
+    bool success =
+        file.open(temp_path.string().c_str(), BufferedFile::BinaryType, BufferedFile::WriteMode) &&
+        file.write(header) == sizeof(ImportanceMapHeader);
+
+    for (size_t y = 0; success && y < height; ++y)
+    {
+        for (size_t x = 0; x < width; ++x)
+            row[x] = importance_sampler.get_payload(x, y);
+
+        success = file.write(&row[0], width * sizeof(Color3f)) == width * sizeof(Color3f);
+    }
+
+    if (file.is_open() && !file.close())
+        success = false;
+
+    if (success)
+    {
+        bf::rename(temp_path, final_path, ec);
+        success = !ec;
+    }
+
+    if (!success)
+        bf::remove(temp_path, ec);
+
+    return success;
+}
+
+}   // namespace renderer
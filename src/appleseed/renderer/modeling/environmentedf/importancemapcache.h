@@ -0,0 +1,87 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/image/color.h"
+#include "foundation/math/sampling/imageimportancesampler.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Forward declarations.
+namespace foundation    { class MemoryMappedFile; }
+
+namespace renderer
+{
+
+//
+// On-disk cache of environment importance maps.
+//
+// Each map is stored in its own file, named after a key identifying the inputs the map
+// was built from. Files carry a checksum of their payloads: payloads are used directly
+// as radiance values, so truncated or corrupted files must be rejected.
+//
+
+typedef foundation::ImageImportanceSampler<foundation::Color3f, float> ImportanceMapSamplerType;
+
+// Hash the identity of a file, that is its absolute path, its size and its last
+// modification time, without reading its content. Return false if the file cannot
+// be accessed.
+bool hash_importance_map_source_file(
+    const std::string&                  filepath,
+    std::uint64_t&                      hash);
+
+// Return the name of the cache file of a given key.
+std::string get_importance_map_cache_filename(const std::uint64_t key);
+
+// Return true if a file holds a valid importance map of a given key and resolution.
+bool is_valid_importance_map_file(
+    const foundation::MemoryMappedFile& file,
+    const std::uint64_t                 key,
+    const size_t                        width,
+    const size_t                        height);
+
+// Return the payloads of a valid importance map file, in row-major order.
+const foundation::Color3f* get_importance_map_file_payloads(
+    const foundation::MemoryMappedFile& file);
+
+// Write the payloads of an importance map to a given file. The file is replaced
+// atomically, such that concurrent readers never see a partially written file.
+// Return false on failure.
+bool save_importance_map_file(
+    const std::string&                  filepath,
+    const std::uint64_t                 key,
+    const ImportanceMapSamplerType&     importance_sampler,
+    const size_t                        width,
+    const size_t                        height);
+
+}   // namespace renderer
@@ -38,12 +38,17 @@
 #include "renderer/kernel/texturing/texturestore.h"
 #include "renderer/modeling/color/colorspace.h"
 #include "renderer/modeling/environmentedf/environmentedf.h"
+#include "renderer/modeling/environmentedf/importancemapcache.h"
 #include "renderer/modeling/environmentedf/sphericalcoordinates.h"
 #include "renderer/modeling/input/inputarray.h"
 #include "renderer/modeling/input/source.h"
 #include "renderer/modeling/input/sourceinputs.h"
+#include "renderer/modeling/input/texturesource.h"
 #include "renderer/modeling/project/project.h"
 #include "renderer/modeling/scene/scene.h"
+#include "renderer/modeling/scene/textureinstance.h"
+#include "renderer/modeling/texture/disktexture2d.h"
+#include "renderer/modeling/texture/texture.h"
 #include "renderer/utility/paramarray.h"
 #include "renderer/utility/transformsequence.h"
 
@@ -56,25 +61,39 @@
 #include "foundation/math/transform.h"
 #include "foundation/math/vector.h"
 #include "foundation/platform/defaulttimers.h"
+#include "foundation/platform/memorymappedfile.h"
 #include "foundation/platform/types.h"
 #include "foundation/utility/api/apistring.h"
 #include "foundation/utility/api/specializedapiarrays.h"
 #include "foundation/utility/containers/dictionary.h"
+#include "foundation/utility/foreach.h"
+#include "foundation/utility/job.h"
 #include "foundation/utility/job/abortswitch.h"
+#include "foundation/utility/searchpaths.h"
+#include "foundation/utility/siphash.h"
 #include "foundation/utility/stopwatch.h"
 #include "foundation/utility/string.h"
 
+// Boost headers.
+#include "boost/filesystem.hpp"
+
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <memory>
+#include <string>
+#include <vector>
 
 // Forward declarations.
 namespace renderer  { class OnFrameBeginRecorder; }
 namespace renderer  { class OnRenderBeginRecorder; }
 
 using namespace foundation;
+namespace bf = boost::filesystem;
 
 namespace renderer
 {
@@ -154,6 +173,172 @@ namespace
         const float     m_rcp_height;
     };
 
+    // Image sampler reading back texels of a cached importance map.
+    class CachedImageSampler
+    {
+      public:
+        CachedImageSampler(
+            const Color3f*  texels,
+            const size_t    width)
+          : m_texels(texels)
+          , m_width(width)
+        {
+        }
+
+        void sample(const size_t x, const size_t y, Color3f& payload, float& importance) const
+        {
+            // Cached texels are finite, so this matches ImageSampler::sample().
+            payload = m_texels[y * m_width + x];
+            importance = luminance(payload);
+        }
+
+      private:
+        const Color3f*  m_texels;
+        const size_t    m_width;
+    };
+
+
+    //
+    // Parallel construction of importance maps.
+    //
+
+    template <typename Sampler>
+    class RebuildImportanceMapRowsJob
+      : public IJob
+    {
+      public:
+        RebuildImportanceMapRowsJob(
+            ImageImportanceSamplerType&     importance_sampler,
+            const std::vector<Sampler*>&    samplers,
+            const size_t                    begin_row,
+            const size_t                    end_row,
+            IAbortSwitch*                   abort_switch)
+          : m_importance_sampler(importance_sampler)
+          , m_samplers(samplers)
+          , m_begin_row(begin_row)
+          , m_end_row(end_row)
+          , m_abort_switch(abort_switch)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            m_importance_sampler.rebuild_rows(
+                *m_samplers[thread_index],
+                m_begin_row,
+                m_end_row,
+                m_abort_switch);
+        }
+
+      private:
+        ImageImportanceSamplerType&         m_importance_sampler;
+        const std::vector<Sampler*>&        m_samplers;
+        const size_t                        m_begin_row;
+        const size_t                        m_end_row;
+        IAbortSwitch*                       m_abort_switch;
+    };
+
+    // Rebuild an importance map using one image sampler per thread.
+    template <typename Sampler>
+    void rebuild_importance_map(
+        ImageImportanceSamplerType&         importance_sampler,
+        const std::vector<Sampler*>&        samplers,
+        const size_t                        height,
+        IAbortSwitch*                       abort_switch)
+    {
+        // Use enough jobs per thread to balance rows of uneven cost.
+        const size_t thread_count = samplers.size();
+        const size_t rows_per_job = std::max<size_t>(height / (thread_count * 16), 1);
+
+        JobQueue job_queue;
+
+        for (size_t begin_row = 0; begin_row < height; begin_row += rows_per_job)
+        {
+            job_queue.schedule(
+                new RebuildImportanceMapRowsJob<Sampler>(
+                    importance_sampler,
+                    samplers,
+                    begin_row,
+                    std::min(begin_row + rows_per_job, height),
+                    abort_switch));
+        }
+
+        JobManager job_manager(
+            global_logger(),
+            job_queue,
+            thread_count,
+            JobManager::KeepRunningOnEmptyQueue);
+        job_manager.start();
+
+        job_queue.wait_until_completion();
+
+        if (!is_aborted(abort_switch))
+            importance_sampler.rebuild_rows_cdf();
+    }
+
+
+    //
+    // On-disk cache of importance maps.
+    //
+    // Importance maps are stored in the directory given by the "importance_map_cache_directory"
+    // parameter of the environment EDF (see importancemapcache.h). Only maps of disk textures
+    // with a uniform radiance multiplier are cached.
+    //
+
+    std::uint64_t hash_params(std::uint64_t hash, const ParamArray& params)
+    {
+        for (const_each<StringDictionary> i = params.strings(); i; ++i)
+        {
+            hash = siphash24(hash, siphash24(i.it().key(), std::strlen(i.it().key())));
+            hash = siphash24(hash, siphash24(i.it().value(), std::strlen(i.it().value())));
+        }
+
+        return hash;
+    }
+
+    // Compute the cache key of an importance map. The environment texture file is identified
+    // by its path, size and modification time, not by its content, since hashing the whole
+    // file would cost about as much as reading it. Return false if the map cannot be cached.
+    bool compute_importance_map_hash(
+        const SearchPaths&                  search_paths,
+        const Source*                       radiance_source,
+        const Source*                       multiplier_source,
+        const float                         exposure_multiplier,
+        const size_t                        width,
+        const size_t                        height,
+        std::uint64_t&                      hash)
+    {
+        const TextureSource* texture_source = dynamic_cast<const TextureSource*>(radiance_source);
+        if (texture_source == nullptr || !multiplier_source->is_uniform())
+            return false;
+
+        const TextureInstance& texture_instance = texture_source->get_texture_instance();
+        const Texture& texture = texture_instance.get_texture();
+        if (std::strcmp(texture.get_model(), DiskTexture2dFactory().get_model()) != 0)
+            return false;
+
+        const std::string filepath =
+            to_string(search_paths.qualify(texture.get_parameters().get_optional<std::string>("filename", "")));
+
+        std::uint64_t file_hash;
+        if (!hash_importance_map_source_file(filepath, file_hash))
+            return false;
+
+        float multiplier;
+        multiplier_source->evaluate_uniform(multiplier);
+
+        hash = siphash24(file_hash, width);
+        hash = siphash24(hash, height);
+        hash = siphash24(hash, siphash24(&exposure_multiplier, sizeof(float)));
+        hash = siphash24(hash, siphash24(&multiplier, sizeof(float)));
+        const Matrix4f& transform = texture_instance.get_transform().get_local_to_parent();
+        hash = siphash24(hash, siphash24(&transform[0], sizeof(Matrix4f)));
+        hash = hash_params(hash, texture.get_parameters());
+        hash = hash_params(hash, texture_instance.get_parameters());
+
+        return true;
+    }
+
     const char* Model = "latlong_map_environment_edf";
 
     class LatLongMapEnvironmentEDF
@@ -167,6 +352,7 @@ namespace
           , m_importance_map_width(0)
           , m_importance_map_height(0)
           , m_probability_scale(0.0f)
+          , m_importance_map_signature(0)
         {
             m_inputs.declare("radiance", InputFormatSpectralIlluminance);
             m_inputs.declare("radiance_multiplier", InputFormatFloat, "1.0");
@@ -203,7 +389,7 @@ namespace
 
             // Build importance map only if this environment EDF is the active one.
             if (project.get_scene()->get_environment()->get_uncached_environment_edf() == this)
-                build_importance_map(*project.get_scene(), abort_switch);
+                build_importance_map(project, abort_switch);
 
             return true;
         }
@@ -382,8 +568,9 @@ namespace
         float   m_probability_scale;
 
         std::unique_ptr<ImageImportanceSamplerType> m_importance_sampler;
+        std::uint64_t                               m_importance_map_signature;
 
-        void build_importance_map(const Scene& scene, IAbortSwitch* abort_switch)
+        void build_importance_map(const Project& project, IAbortSwitch* abort_switch)
         {
             Stopwatch<DefaultWallclockTimer> stopwatch;
             stopwatch.start();
@@ -391,9 +578,29 @@ namespace
             const Source* radiance_source = m_inputs.source("radiance");
             assert(radiance_source);
 
+            const Source* multiplier_source = m_inputs.source("radiance_multiplier");
+            assert(multiplier_source);
+
             const Source::Hints radiance_source_hints = radiance_source->get_hints();
-            m_importance_map_width = radiance_source_hints.m_width;
-            m_importance_map_height = radiance_source_hints.m_height;
+            const size_t width = radiance_source_hints.m_width;
+            const size_t height = radiance_source_hints.m_height;
+
+            // Reuse the importance map of the previous render if its inputs didn't change.
+            std::uint64_t signature = siphash24(radiance_source->compute_signature(), multiplier_source->compute_signature());
+            signature = siphash24(signature, siphash24(&m_exposure_multiplier, sizeof(float)));
+            if (m_importance_sampler &&
+                m_importance_map_signature == signature &&
+                m_importance_map_width == width &&
+                m_importance_map_height == height)
+            {
+                RENDERER_LOG_DEBUG(
+                    "reusing importance map for environment edf \"%s\".",
+                    get_path().c_str());
+                return;
+            }
+
+            m_importance_map_width = width;
+            m_importance_map_height = height;
 
             m_rcp_importance_map_width = 1.0f / m_importance_map_width;
             m_rcp_importance_map_height = 1.0f / m_importance_map_height;
@@ -401,41 +608,118 @@ namespace
             const size_t texel_count = m_importance_map_width * m_importance_map_height;
             m_probability_scale = texel_count / (2.0f * PiSquare<float>());
 
-            TextureStore texture_store(scene);
-            TextureCache texture_cache(texture_store);
-            ImageSampler sampler(
-                texture_cache,
-                radiance_source,
-                m_inputs.source("radiance_multiplier"),
-                m_exposure_multiplier,
-                m_importance_map_width,
-                m_importance_map_height);
-
             m_importance_sampler.reset(
                 new ImageImportanceSamplerType(
                     m_importance_map_width,
                     m_importance_map_height));
 
-            RENDERER_LOG_INFO(
-                "building " FMT_SIZE_T "x" FMT_SIZE_T " importance map "
-                "for environment edf \"%s\"...",
-                m_importance_map_width,
-                m_importance_map_height,
-                get_path().c_str());
+            // Look for the importance map in the cache.
+            const std::string cache_directory =
+                m_params.get_optional<std::string>("importance_map_cache_directory", "");
+            std::uint64_t hash = 0;
+            std::string cache_path;
+            if (!cache_directory.empty() &&
+                compute_importance_map_hash(
+                    project.search_paths(),
+                    radiance_source,
+                    multiplier_source,
+                    m_exposure_multiplier,
+                    width,
+                    height,
+                    hash))
+                cache_path = (bf::path(cache_directory) / get_importance_map_cache_filename(hash)).string();
+
+            const size_t thread_count = project.get_thread_count();
+            bool loaded_from_cache = false;
+
+            if (!cache_path.empty())
+            {
+                const MemoryMappedFile file(cache_path.c_str());
+                if (is_valid_importance_map_file(file, hash, width, height))
+                {
+                    RENDERER_LOG_INFO(
+                        "loading " FMT_SIZE_T "x" FMT_SIZE_T " importance map "
+                        "for environment edf \"%s\" from %s...",
+                        width,
+                        height,
+                        get_path().c_str(),
+                        cache_path.c_str());
+
+                    CachedImageSampler sampler(get_importance_map_file_payloads(file), width);
+
+                    rebuild_importance_map(
+                        *m_importance_sampler,
+                        std::vector<CachedImageSampler*>(thread_count, &sampler),
+                        height,
+                        abort_switch);
+
+                    loaded_from_cache = true;
+                }
+            }
 
-            m_importance_sampler->rebuild(sampler, abort_switch);
+            if (!loaded_from_cache)
+            {
+                RENDERER_LOG_INFO(
+                    "building " FMT_SIZE_T "x" FMT_SIZE_T " importance map "
+                    "for environment edf \"%s\" using %s %s...",
+                    width,
+                    height,
+                    get_path().c_str(),
+                    pretty_uint(thread_count).c_str(),
+                    plural(thread_count, "thread").c_str());
+
+                // Texture caches are not thread-safe: use one image sampler per thread.
+                TextureStore texture_store(*project.get_scene());
+                std::vector<std::unique_ptr<TextureCache>> texture_caches;
+                std::vector<std::unique_ptr<ImageSampler>> samplers;
+                std::vector<ImageSampler*> sampler_ptrs;
+
+                for (size_t i = 0; i < thread_count; ++i)
+                {
+                    texture_caches.emplace_back(new TextureCache(texture_store));
+                    samplers.emplace_back(
+                        new ImageSampler(
+                            *texture_caches.back(),
+                            radiance_source,
+                            multiplier_source,
+                            m_exposure_multiplier,
+                            width,
+                            height));
+                    sampler_ptrs.push_back(samplers.back().get());
+                }
+
+                rebuild_importance_map(
+                    *m_importance_sampler,
+                    sampler_ptrs,
+                    height,
+                    abort_switch);
+            }
 
             if (is_aborted(abort_switch))
-                m_importance_sampler.reset();
-            else
             {
-                stopwatch.measure();
+                m_importance_sampler.reset();
+                return;
+            }
 
-                RENDERER_LOG_INFO(
-                    "built importance map for environment edf \"%s\" in %s.",
-                    get_path().c_str(),
-                    pretty_time(stopwatch.get_seconds()).c_str());
+            m_importance_map_signature = signature;
+
+            if (!cache_path.empty() && !loaded_from_cache)
+            {
+                if (!save_importance_map_file(cache_path, hash, *m_importance_sampler, width, height))
+                {
+                    RENDERER_LOG_WARNING(
+                        "failed to write importance map cache file \"%s\".",
+                        cache_path.c_str());
+                }
             }
+
+            stopwatch.measure();
+
+            RENDERER_LOG_INFO(
+                "%s importance map for environment edf \"%s\" in %s.",
+                loaded_from_cache ? "loaded" : "built",
+                get_path().c_str(),
+                pretty_time(stopwatch.get_seconds()).c_str());
         }
 
         void lookup_environment_map(
@@ -584,6 +868,15 @@ DictionaryArray LatLongMapEnvironmentEDFFactory::get_input_metadata() const
             .insert("use", "optional")
             .insert("help", "Environment texture vertical shift in degrees"));
 
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "importance_map_cache_directory")
+            .insert("label", "Importance Map Cache Directory")
+            .insert("type", "text")
+            .insert("default", "")
+            .insert("use", "optional")
+            .insert("help", "Directory where importance maps of disk textures are cached; leave empty to disable caching"));
+
     add_common_input_metadata(metadata);
     
     return metadata;
@@ -34,6 +34,9 @@
 // appleseed.main headers.
 #include "main/dllsymbol.h"
 
+// Forward declarations.
+namespace renderer  { class ShadingPoint; }
+
 namespace renderer
 {
 
@@ -49,8 +52,15 @@ class APPLESEED_DLLSYMBOL SourceInputs
     double  m_point_y;
     double  m_point_z;
 
-    // Constructor.
+    // Shading point being shaded, if any. Sources query the screen space partial
+    // derivatives of the texture coordinates from it, only when they need them.
+    const ShadingPoint* m_shading_point;
+
+    // Constructors.
     explicit SourceInputs(const foundation::Vector2f& uv);
+    SourceInputs(
+        const foundation::Vector2f& uv,
+        const ShadingPoint&         shading_point);
 };
 
 
@@ -64,6 +74,19 @@ inline SourceInputs::SourceInputs(const foundation::Vector2f& uv)
   , m_point_x(0.0)
   , m_point_y(0.0)
   , m_point_z(0.0)
+  , m_shading_point(nullptr)
+{
+}
+
+inline SourceInputs::SourceInputs(
+    const foundation::Vector2f& uv,
+    const ShadingPoint&         shading_point)
+  : m_uv_x(uv.x)
+  , m_uv_y(uv.y)
+  , m_point_x(0.0)
+  , m_point_y(0.0)
+  , m_point_z(0.0)
+  , m_shading_point(&shading_point)
 {
 }
 
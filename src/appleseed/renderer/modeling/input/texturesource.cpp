@@ -31,7 +31,9 @@
 #include "texturesource.h"
 
 // appleseed.renderer headers.
+#include "renderer/kernel/shading/shadingpoint.h"
 #include "renderer/kernel/texturing/texturecache.h"
+#include "renderer/kernel/texturing/texturestore.h"
 #include "renderer/modeling/entity/entity.h"
 #include "renderer/modeling/texture/texture.h"
 
@@ -41,7 +43,9 @@
 #include "foundation/math/scalar.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 
 using namespace foundation;
 
@@ -123,6 +127,7 @@ namespace
         const UniqueID              texture_uid,
         const size_t                tile_x,
         const size_t                tile_y,
+        const size_t                level,
         const size_t                pixel_x,
         const size_t                pixel_y,
         Color4f&                    sample)
@@ -133,7 +138,8 @@ namespace
                 assembly_uid,
                 texture_uid,
                 tile_x,
-                tile_y);
+                tile_y,
+                level);
 
         // Sample the tile.
         if (tile.get_channel_count() == 3)
@@ -162,6 +168,7 @@ TextureSource::TextureSource(
   , m_scalar_canvas_height(static_cast<float>(m_texture_props.m_canvas_height))
   , m_max_x(static_cast<float>(m_texture_props.m_canvas_width - 1))
   , m_max_y(static_cast<float>(m_texture_props.m_canvas_height - 1))
+  , m_max_level(TextureStore::get_level_count(m_texture_props) - 1)
 {
 }
 
@@ -232,6 +239,7 @@ Color4f TextureSource::get_texel(
         m_texture_uid,
         tile_x,
         tile_y,
+        0,
         pixel_x,
         pixel_y,
         sample);
@@ -241,6 +249,7 @@ Color4f TextureSource::get_texel(
 
 void TextureSource::get_texels_2x2(
     TextureCache&               texture_cache,
+    const size_t                level,
     const int                   ix,
     const int                   iy,
     Color4f&                    t00,
@@ -248,19 +257,22 @@ void TextureSource::get_texels_2x2(
     Color4f&                    t01,
     Color4f&                    t11) const
 {
+    const size_t canvas_width = TextureStore::get_level_size(m_texture_props.m_canvas_width, level);
+    const size_t canvas_height = TextureStore::get_level_size(m_texture_props.m_canvas_height, level);
+
     const Vector<size_t, 2> p00 =
         constrain_to_canvas(
             m_texture_instance.get_addressing_mode(),
-            m_texture_props.m_canvas_width,
-            m_texture_props.m_canvas_height,
+            canvas_width,
+            canvas_height,
             ix + 0,
             iy + 0);
 
     const Vector<size_t, 2> p11 =
         constrain_to_canvas(
             m_texture_instance.get_addressing_mode(),
-            m_texture_props.m_canvas_width,
-            m_texture_props.m_canvas_height,
+            canvas_width,
+            canvas_height,
             ix + 1,
             iy + 1);
 
@@ -288,10 +300,10 @@ void TextureSource::get_texels_2x2(
         const size_t pixel_y_11 = p11.y - tile_y_11 * m_texture_props.m_tile_height;
 
         // Sample the tile.
-        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, tile_x_00, tile_y_00, pixel_x_00, pixel_y_00, t00);
-        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, tile_x_11, tile_y_00, pixel_x_11, pixel_y_00, t10);
-        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, tile_x_00, tile_y_11, pixel_x_00, pixel_y_11, t01);
-        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, tile_x_11, tile_y_11, pixel_x_11, pixel_y_11, t11);
+        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, tile_x_00, tile_y_00, level, pixel_x_00, pixel_y_00, t00);
+        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, tile_x_11, tile_y_00, level, pixel_x_11, pixel_y_00, t10);
+        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, tile_x_00, tile_y_11, level, pixel_x_00, pixel_y_11, t01);
+        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, tile_x_11, tile_y_11, level, pixel_x_11, pixel_y_11, t11);
     }
     else
     {
@@ -311,7 +323,8 @@ void TextureSource::get_texels_2x2(
                 m_assembly_uid,
                 m_texture_uid,
                 tile_x_00,
-                tile_y_00);
+                tile_y_00,
+                level);
 
         // Sample the tile.
         if (tile.get_channel_count() == 3)
@@ -352,12 +365,51 @@ void TextureSource::get_texels_2x2(
     }
 }
 
+Color4f TextureSource::sample_bilinear(
+    TextureCache&               texture_cache,
+    const size_t                level,
+    Vector2f                    p) const
+{
+    p.x *= static_cast<float>(TextureStore::get_level_size(m_texture_props.m_canvas_width, level) - 1);
+    p.y *= static_cast<float>(TextureStore::get_level_size(m_texture_props.m_canvas_height, level) - 1);
+
+    const int ix = truncate<int>(p.x);
+    const int iy = truncate<int>(p.y);
+
+    // Retrieve the four surrounding texels.
+    Color4f t00, t10, t01, t11;
+    get_texels_2x2(
+        texture_cache,
+        level,
+        ix, iy,
+        t00, t10, t01, t11);
+
+    // Compute weights.
+    const float wx1 = p.x - ix;
+    const float wy1 = p.y - iy;
+    const float wx0 = 1.0f - wx1;
+    const float wy0 = 1.0f - wy1;
+
+    // Apply weights.
+    t00 *= wx0 * wy0;
+    t10 *= wx1 * wy0;
+    t01 *= wx0 * wy1;
+    t11 *= wx1 * wy1;
+
+    // Accumulate.
+    t00 += t10;
+    t00 += t01;
+    t00 += t11;
+
+    return t00;
+}
+
 Color4f TextureSource::sample_texture(
     TextureCache&               texture_cache,
-    const Vector2f&             uv) const
+    const SourceInputs&         source_inputs) const
 {
     // Start with the transformed input texture coordinates.
-    Vector2f p = apply_transform(uv);
+    Vector2f p = apply_transform(Vector2f(source_inputs.m_uv_x, source_inputs.m_uv_y));
     p.y = 1.0f - p.y;
 
     // Apply the texture addressing mode.
@@ -377,38 +429,38 @@ Color4f TextureSource::sample_texture(
         }
 
       case TextureFilteringBilinear:
+        return sample_bilinear(texture_cache, 0, p);
+
+      case TextureFilteringTrilinear:
         {
-            p.x *= m_max_x;
-            p.y *= m_max_y;
-
-            const int ix = truncate<int>(p.x);
-            const int iy = truncate<int>(p.y);
-
-            // Retrieve the four surrounding texels.
-            Color4f t00, t10, t01, t11;
-            get_texels_2x2(
-                texture_cache,
-                ix, iy,
-                t00, t10, t01, t11);
-
-            // Compute weights.
-            const float wx1 = p.x - ix;
-            const float wy1 = p.y - iy;
-            const float wx0 = 1.0f - wx1;
-            const float wy0 = 1.0f - wy1;
-
-            // Apply weights.
-            t00 *= wx0 * wy0;
-            t10 *= wx1 * wy0;
-            t01 *= wx0 * wy1;
-            t11 *= wx1 * wy1;
-
-            // Accumulate.
-            t00 += t10;
-            t00 += t01;
-            t00 += t11;
-
-            return t00;
+            // Without a shading point, there are no ray differentials.
+            if (source_inputs.m_shading_point == nullptr || m_max_level == 0)
+                return sample_bilinear(texture_cache, 0, p);
+
+            // Compute the footprint of the pixel in texel units, along its longest axis.
+            const Vector2f& uv_dx = source_inputs.m_shading_point->get_duvdx(0);
+            const Vector2f& uv_dy = source_inputs.m_shading_point->get_duvdy(0);
+            const Vector3f duvdx = m_texture_transform.vector_to_local(Vector3f(uv_dx.x, uv_dx.y, 0.0f));
+            const Vector3f duvdy = m_texture_transform.vector_to_local(Vector3f(uv_dy.x, uv_dy.y, 0.0f));
+            const float footprint_x = norm(Vector2f(duvdx.x * m_scalar_canvas_width, duvdx.y * m_scalar_canvas_height));
+            const float footprint_y = norm(Vector2f(duvdy.x * m_scalar_canvas_width, duvdy.y * m_scalar_canvas_height));
+            const float footprint = std::max(footprint_x, footprint_y);
+
+            // Magnification, or no ray differentials.
+            if (footprint <= 1.0f)
+                return sample_bilinear(texture_cache, 0, p);
+
+            // Select the two MIP levels surrounding the footprint.
+            const float lod = std::min(std::log2(footprint), static_cast<float>(m_max_level));
+            const size_t level = std::min(truncate<size_t>(lod), m_max_level);
+            const float t = lod - static_cast<float>(level);
+
+            const Color4f c0 = sample_bilinear(texture_cache, level, p);
+            if (t <= 0.0f || level == m_max_level)
+                return c0;
+
+            const Color4f c1 = sample_bilinear(texture_cache, level + 1, p);
+            return lerp(c0, c1, t);
         }
 
       default:
@@ -33,12 +33,14 @@
 #include "renderer/modeling/object/curveobjectreader.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/scalar.h"
 #include "foundation/utility/api/specializedapiarrays.h"
 #include "foundation/utility/containers/dictionary.h"
 #include "foundation/utility/otherwise.h"
 #include "foundation/utility/string.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <string>
 #include <vector>
@@ -63,12 +65,69 @@ struct CurveObject::Impl
     size_t                   m_curve_count;
     std::vector<Curve1Type>  m_curves1;
     std::vector<Curve3Type>  m_curves3;
+    size_t                   m_motion_segment_count;
+    std::vector<GVector3>    m_curve1_poses;        // 2 control points per curve per motion segment
+    std::vector<GVector3>    m_curve3_poses;        // 4 control points per curve per motion segment
     std::vector<std::string> m_material_slots;
 
     Impl()
+      : m_motion_segment_count(0)
     {
     }
 
+    void convert_to_bezier_basis(Curve3Type& curve) const
+    {
+        switch (m_basis)
+        {
+          case CurveBasis::Bezier:
+            // Do nothing.
+            break;
+
+          case CurveBasis::BSpline:
+            curve.transform_basis(
+                CurveMatrixType::from_array(BezierInverseBasisArray) * CurveMatrixType::from_array(BSplineBasisArray));
+            break;
+
+          case CurveBasis::CatmullRom:
+            curve.transform_basis(
+                CurveMatrixType::from_array(BezierInverseBasisArray) * CurveMatrixType::from_array(CatmullRomBasisArray));
+            break;
+
+          assert_otherwise;
+        }
+    }
+
+    template <size_t N>
+    void set_pose(
+        std::vector<GVector3>&  poses,
+        const size_t            curve_index,
+        const size_t            motion_segment_index,
+        const GVector3          ctrl_pts[N])
+    {
+        assert(motion_segment_index < m_motion_segment_count);
+
+        const size_t base = (curve_index * m_motion_segment_count + motion_segment_index) * N;
+        if (poses.size() < base + N)
+            poses.resize((curve_index + 1) * m_motion_segment_count * N);
+
+        for (size_t i = 0; i < N; ++i)
+            poses[base + i] = ctrl_pts[i];
+    }
+
+    template <size_t N>
+    const GVector3* get_pose(
+        const std::vector<GVector3>&    poses,
+        const size_t                    curve_index,
+        const size_t                    motion_segment_index) const
+    {
+        assert(motion_segment_index < m_motion_segment_count);
+
+        const size_t base = (curve_index * m_motion_segment_count + motion_segment_index) * N;
+        assert(base + N <= poses.size());
+
+        return &poses[base];
+    }
+
     GAABB3 compute_bounds() const
     {
         GAABB3 bbox;
@@ -83,6 +142,12 @@ struct CurveObject::Impl
         for (size_t i = 0; i < curve3_count; ++i)
             bbox.insert(m_curves3[i].compute_bbox());
 
+        for (size_t i = 0; i < m_curve1_poses.size(); ++i)
+            bbox.insert(m_curve1_poses[i]);
+
+        for (size_t i = 0; i < m_curve3_poses.size(); ++i)
+            bbox.insert(m_curve3_poses[i]);
+
         return bbox;
     }
 };
@@ -168,27 +233,9 @@ size_t CurveObject::push_curve1(const Curve1Type& curve)
 size_t CurveObject::push_curve3(const Curve3Type& curve)
 {
     const size_t index = impl->m_curves3.size();
-    Curve3Type t_curve = curve;
-
-    switch (get_basis())
-    {
-      case CurveBasis::Bezier:
-        // Do nothing.
-        break;
-
-      case CurveBasis::BSpline:
-        t_curve.transform_basis(
-            CurveMatrixType::from_array(BezierInverseBasisArray) * CurveMatrixType::from_array(BSplineBasisArray));
-        break;
-
-      case CurveBasis::CatmullRom:
-        t_curve.transform_basis(
-            CurveMatrixType::from_array(BezierInverseBasisArray) * CurveMatrixType::from_array(CatmullRomBasisArray));
-        break;
-
-      assert_otherwise;
-    }
 
+    Curve3Type t_curve = curve;
+    impl->convert_to_bezier_basis(t_curve);
     impl->m_curves3.push_back(t_curve);
 
     return index;
@@ -216,6 +263,101 @@ const Curve3Type& CurveObject::get_curve3(const size_t index) const
     return impl->m_curves3[index];
 }
 
+void CurveObject::set_motion_segment_count(const size_t count)
+{
+    impl->m_motion_segment_count = count;
+    impl->m_curve1_poses.clear();
+    impl->m_curve3_poses.clear();
+}
+
+size_t CurveObject::get_motion_segment_count() const
+{
+    return impl->m_motion_segment_count;
+}
+
+void CurveObject::set_curve1_pose(
+    const size_t            curve_index,
+    const size_t            motion_segment_index,
+    const Curve1Type&       curve)
+{
+    assert(curve_index < impl->m_curves1.size());
+
+    const GVector3 ctrl_pts[2] = { curve.get_control_point(0), curve.get_control_point(1) };
+    impl->set_pose<2>(impl->m_curve1_poses, curve_index, motion_segment_index, ctrl_pts);
+}
+
+void CurveObject::set_curve3_pose(
+    const size_t            curve_index,
+    const size_t            motion_segment_index,
+    const Curve3Type&       curve)
+{
+    assert(curve_index < impl->m_curves3.size());
+
+    // Poses go through the same change of basis as the curves themselves.
+    Curve3Type t_curve = curve;
+    impl->convert_to_bezier_basis(t_curve);
+
+    GVector3 ctrl_pts[4];
+    for (size_t i = 0; i < 4; ++i)
+        ctrl_pts[i] = t_curve.get_control_point(i);
+
+    impl->set_pose<4>(impl->m_curve3_poses, curve_index, motion_segment_index, ctrl_pts);
+}
+
+Curve1Type CurveObject::get_curve1_pose(
+    const size_t            curve_index,
+    const size_t            motion_segment_index) const
+{
+    return
+        Curve1Type(
+            get_curve1(curve_index),
+            impl->get_pose<2>(impl->m_curve1_poses, curve_index, motion_segment_index));
+}
+
+Curve3Type CurveObject::get_curve3_pose(
+    const size_t            curve_index,
+    const size_t            motion_segment_index) const
+{
+    return
+        Curve3Type(
+            get_curve3(curve_index),
+            impl->get_pose<4>(impl->m_curve3_poses, curve_index, motion_segment_index));
+}
+
+Curve1Type CurveObject::interpolate_curve1(const size_t index, const double time) const
+{
+    const size_t motion_segment_count = impl->m_motion_segment_count;
+    if (motion_segment_count == 0)
+        return get_curve1(index);
+
+    const double base_time = time * motion_segment_count;
+    const size_t prev_index = std::min(truncate<size_t>(base_time), motion_segment_count - 1);
+    const GScalar frac = static_cast<GScalar>(base_time - prev_index);
+
+    return
+        Curve1Type(
+            prev_index == 0 ? get_curve1(index) : get_curve1_pose(index, prev_index - 1),
+            get_curve1_pose(index, prev_index),
+            frac);
+}
+
+Curve3Type CurveObject::interpolate_curve3(const size_t index, const double time) const
+{
+    const size_t motion_segment_count = impl->m_motion_segment_count;
+    if (motion_segment_count == 0)
+        return get_curve3(index);
+
+    const double base_time = time * motion_segment_count;
+    const size_t prev_index = std::min(truncate<size_t>(base_time), motion_segment_count - 1);
+    const GScalar frac = static_cast<GScalar>(base_time - prev_index);
+
+    return
+        Curve3Type(
+            prev_index == 0 ? get_curve3(index) : get_curve3_pose(index, prev_index - 1),
+            get_curve3_pose(index, prev_index),
+            frac);
+}
+
 size_t CurveObject::get_material_slot_count() const
 {
     return impl->m_material_slots.size();
@@ -91,6 +91,20 @@ class APPLESEED_DLLSYMBOL CurveObject
     const Curve1Type& get_curve1(const size_t index) const;
     const Curve3Type& get_curve3(const size_t index) const;
 
+    // Insert and access curve poses for deformation motion blur. The curves pushed
+    // above define the first pose; pose #i defines the curves at time (i + 1) / count.
+    // Poses only carry control points, all other vertex attributes are not animated.
+    void set_motion_segment_count(const size_t count);
+    size_t get_motion_segment_count() const;
+    void set_curve1_pose(const size_t curve_index, const size_t motion_segment_index, const Curve1Type& curve);
+    void set_curve3_pose(const size_t curve_index, const size_t motion_segment_index, const Curve3Type& curve);
+    Curve1Type get_curve1_pose(const size_t curve_index, const size_t motion_segment_index) const;
+    Curve3Type get_curve3_pose(const size_t curve_index, const size_t motion_segment_index) const;
+
+    // Return a curve at a given time in [0, 1] within the shutter interval.
+    Curve1Type interpolate_curve1(const size_t index, const double time) const;
+    Curve3Type interpolate_curve3(const size_t index, const double time) const;
+
     // Insert and access material slots.
     size_t get_material_slot_count() const override;
     const char* get_material_slot(const size_t index) const override;
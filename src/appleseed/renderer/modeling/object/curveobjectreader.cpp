@@ -64,6 +64,7 @@
 #include <cstddef>
 #include <exception>
 #include <string>
+#include <vector>
 
 using namespace foundation;
 namespace bf = boost::filesystem;
@@ -87,6 +88,7 @@ namespace
           : m_params(params)
           , m_name(name)
           , m_split_count(0)
+          , m_motion_segment_count(0)
           , m_total_vertex_count(0)
         {
         }
@@ -109,6 +111,8 @@ namespace
                     CurveObjectFactory().create(m_name.c_str(), m_params).release());
 
             m_split_count = m_params.get_optional<size_t>("presplits", 3);
+            m_motion_segment_count = 0;
+            m_vertex_poses.clear();
 
             m_object->push_basis(basis);
             m_object->push_curve_count(count);
@@ -184,6 +188,19 @@ namespace
             return m_colors.push_back(c);
         }
 
+        void set_motion_segment_count(const size_t count) override
+        {
+            m_motion_segment_count = count;
+            m_vertex_poses.resize(count);
+            m_object->set_motion_segment_count(count);
+        }
+
+        void push_vertex_pose(const size_t motion_segment_index, const Vector3f& v) override
+        {
+            assert(motion_segment_index < m_motion_segment_count);
+            return m_vertex_poses[motion_segment_index].push_back(GVector3(v));
+        }
+
         auto_release_ptr<CurveObject> create_hair_ball()
         {
             const size_t ControlPointCount = 4;
@@ -278,9 +295,11 @@ namespace
         const std::string        m_name;
         CurveObject*             m_object;
         size_t                   m_split_count;
+        size_t                   m_motion_segment_count;
 
         // Curve attributes and statistics.
         std::vector<GVector3>    m_vertices;
+        std::vector<std::vector<GVector3>> m_vertex_poses;
         std::vector<GScalar>     m_widths;
         std::vector<GScalar>     m_opacities;
         std::vector<Color3f>     m_colors;
@@ -291,21 +310,36 @@ namespace
         void reset_curve_variables()
         {
             m_vertices.clear();
+            for (size_t i = 0; i < m_vertex_poses.size(); ++i)
+                m_vertex_poses[i].clear();
             m_widths.clear();
             m_opacities.clear();
             m_colors.clear();
         }
 
-        void split_and_store(const Curve3Type& curve, const size_t split_count)
+        // Return the vertices of a given pose, pose #0 being the curve itself.
+        const std::vector<GVector3>& get_pose_vertices(const size_t pose_index) const
+        {
+            return pose_index == 0 ? m_vertices : m_vertex_poses[pose_index - 1];
+        }
+
+        // Split all the poses of a curve the same way, then store them.
+        void split_and_store(const std::vector<Curve3Type>& poses, const size_t split_count)
         {
             if (split_count > 0)
             {
-                Curve3Type child1, child2;
-                curve.split(child1, child2);
-                split_and_store(child1, split_count - 1);
-                split_and_store(child2, split_count - 1);
+                std::vector<Curve3Type> children1(poses.size()), children2(poses.size());
+                for (size_t p = 0; p < poses.size(); ++p)
+                    poses[p].split(children1[p], children2[p]);
+                split_and_store(children1, split_count - 1);
+                split_and_store(children2, split_count - 1);
+            }
+            else
+            {
+                const size_t curve_index = m_object->push_curve3(poses[0]);
+                for (size_t p = 1; p < poses.size(); ++p)
+                    m_object->set_curve3_pose(curve_index, p - 1, poses[p]);
             }
-            else m_object->push_curve3(curve);
         }
 
         void push_curve1()
@@ -314,12 +348,23 @@ namespace
 
             for (size_t i = 0; i < m_vertices.size() - 1; ++i)
             {
-                const GVector3 points[2] = { m_vertices[i], m_vertices[i + 1] };
                 const GScalar widths[2] = { m_widths[i], m_widths[i + 1] };
                 const GScalar opacities[2] = { m_opacities[i], m_opacities[i + 1] };
                 const Color3f colors[2] = { m_colors[i], m_colors[i + 1] };
 
-                m_object->push_curve1(Curve1Type(points, widths, opacities, colors));
+                size_t curve_index = 0;
+                for (size_t p = 0; p <= m_motion_segment_count; ++p)
+                {
+                    const std::vector<GVector3>& vertices = get_pose_vertices(p);
+                    assert(vertices.size() == m_vertices.size());
+
+                    const GVector3 points[2] = { vertices[i], vertices[i + 1] };
+                    const Curve1Type curve(points, widths, opacities, colors);
+
+                    if (p == 0)
+                        curve_index = m_object->push_curve1(curve);
+                    else m_object->set_curve1_pose(curve_index, p - 1, curve);
+                }
             }
         }
 
@@ -327,14 +372,26 @@ namespace
         {
             assert(m_vertices.size() >= 4);
 
+            std::vector<Curve3Type> poses;
+            poses.reserve(m_motion_segment_count + 1);
+
             for (size_t i = 0; i < m_vertices.size() - 3; i += stride)
             {
-                const GVector3 points[4] = { m_vertices[i], m_vertices[i + 1], m_vertices[i + 2], m_vertices[i + 3] };
                 const GScalar widths[4] = { m_widths[i], m_widths[i + 1], m_widths[i + 2], m_widths[i + 3] };
                 const GScalar opacities[4] = { m_opacities[i], m_opacities[i + 1], m_opacities[i + 2], m_opacities[i + 3] };
                 const Color3f colors[4] = { m_colors[i], m_colors[i + 1], m_colors[i + 2], m_colors[i + 3] };
 
-                split_and_store(Curve3Type(points, widths, opacities, colors), m_split_count);
+                poses.clear();
+                for (size_t p = 0; p <= m_motion_segment_count; ++p)
+                {
+                    const std::vector<GVector3>& vertices = get_pose_vertices(p);
+                    assert(vertices.size() == m_vertices.size());
+
+                    const GVector3 points[4] = { vertices[i], vertices[i + 1], vertices[i + 2], vertices[i + 3] };
+                    poses.emplace_back(points, widths, opacities, colors);
+                }
+
+                split_and_store(poses, m_split_count);
             }
         }
     };
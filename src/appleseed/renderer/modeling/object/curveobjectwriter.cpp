@@ -109,6 +109,16 @@ namespace
             return m_colors[i];
         }
 
+        size_t get_motion_segment_count() const override
+        {
+            return m_object.get_motion_segment_count();
+        }
+
+        Vector3f get_vertex_pose(const size_t i, const size_t motion_segment_index) const override
+        {
+            return m_vertex_poses[motion_segment_index][i];
+        }
+
         size_t get_total_vertex_count() const
         {
             return m_total_vertex_count;
@@ -121,6 +131,7 @@ namespace
         size_t                   m_curve_count;
         std::vector<size_t>      m_vertex_counts;
         std::vector<GVector3>    m_vertices;
+        std::vector<std::vector<GVector3>> m_vertex_poses;
         std::vector<GScalar>     m_widths;
         std::vector<GScalar>     m_opacities;
         std::vector<Color3f>     m_colors;
@@ -138,6 +149,8 @@ namespace
                 if (m_vertices.empty() || !feq(m_vertices.back(), m_object.get_curve1(i).get_control_point(0)))
                 {
                     m_vertices.push_back(m_object.get_curve1(i).get_control_point(0));
+                    for (size_t m = 0; m < m_vertex_poses.size(); ++m)
+                        m_vertex_poses[m].push_back(m_object.get_curve1_pose(i, m).get_control_point(0));
                     m_widths.push_back(m_object.get_curve1(i).get_width(0));
                     m_opacities.push_back(m_object.get_curve1(i).get_opacity(0));
                     m_colors.push_back(m_object.get_curve1(i).get_color(0));
@@ -150,6 +163,8 @@ namespace
                 }
 
                 m_vertices.push_back(m_object.get_curve1(i).get_control_point(1));
+                for (size_t m = 0; m < m_vertex_poses.size(); ++m)
+                    m_vertex_poses[m].push_back(m_object.get_curve1_pose(i, m).get_control_point(1));
                 m_widths.push_back(m_object.get_curve1(i).get_width(1));
                 m_opacities.push_back(m_object.get_curve1(i).get_opacity(1));
                 m_colors.push_back(m_object.get_curve1(i).get_color(1));
@@ -171,6 +186,8 @@ namespace
                 if (m_vertices.empty() || !feq(m_vertices.back(), m_object.get_curve3(i).get_control_point(0)))
                 {
                     m_vertices.push_back(m_object.get_curve3(i).get_control_point(0));
+                    for (size_t m = 0; m < m_vertex_poses.size(); ++m)
+                        m_vertex_poses[m].push_back(m_object.get_curve3_pose(i, m).get_control_point(0));
                     m_widths.push_back(m_object.get_curve3(i).get_width(0));
                     m_opacities.push_back(m_object.get_curve3(i).get_opacity(0));
                     m_colors.push_back(m_object.get_curve3(i).get_color(0));
@@ -185,6 +202,8 @@ namespace
                 for (size_t k = 1; k < 4; ++k)
                 {
                     m_vertices.push_back(m_object.get_curve3(i).get_control_point(k));
+                    for (size_t m = 0; m < m_vertex_poses.size(); ++m)
+                        m_vertex_poses[m].push_back(m_object.get_curve3_pose(i, m).get_control_point(k));
                     m_widths.push_back(m_object.get_curve3(i).get_width(k));
                     m_opacities.push_back(m_object.get_curve3(i).get_opacity(k));
                     m_colors.push_back(m_object.get_curve3(i).get_color(k));
@@ -199,6 +218,8 @@ namespace
 
         void create_parameters()
         {
+            m_vertex_poses.resize(m_object.get_motion_segment_count());
+
             switch (m_object.get_basis())
             {
               case CurveBasis::Linear:
@@ -108,18 +108,23 @@ const StaticTriangleTess& MeshObject::get_static_triangle_tess() const
 
 void MeshObject::rasterize(ObjectRasterizer& rasterizer) const
 {
-    rasterizer.begin_object(impl->m_tess.m_primitives.size());
+    const StaticTriangleTess& tess = impl->m_tess;
+    const size_t triangle_count = tess.get_primitive_count();
 
-    for (const auto& prim : impl->m_tess.m_primitives)
+    rasterizer.begin_object(triangle_count);
+
+    for (size_t i = 0; i < triangle_count; ++i)
     {
-        const auto& v0 = impl->m_tess.m_vertices[prim.m_v0];
-        const auto& v1 = impl->m_tess.m_vertices[prim.m_v1];
-        const auto& v2 = impl->m_tess.m_vertices[prim.m_v2];
+        const Triangle prim = tess.get_primitive(i);
+
+        const auto& v0 = tess.m_vertices[prim.m_v0];
+        const auto& v1 = tess.m_vertices[prim.m_v1];
+        const auto& v2 = tess.m_vertices[prim.m_v2];
 
         // todo: check that vertex normals are available.
-        const auto& n0 = impl->m_tess.m_vertex_normals[prim.m_n0];
-        const auto& n1 = impl->m_tess.m_vertex_normals[prim.m_n1];
-        const auto& n2 = impl->m_tess.m_vertex_normals[prim.m_n2];
+        const GVector3 n0 = tess.get_vertex_normal(prim.m_n0);
+        const GVector3 n1 = tess.get_vertex_normal(prim.m_n1);
+        const GVector3 n2 = tess.get_vertex_normal(prim.m_n2);
 
         ObjectRasterizer::Triangle triangle;
 
@@ -165,6 +170,13 @@ size_t MeshObject::push_vertex(const GVector3& vertex)
     return index;
 }
 
+size_t MeshObject::push_vertex_array(const GVector3 vertices[], const size_t count)
+{
+    const size_t index = impl->m_tess.m_vertices.size();
+    impl->m_tess.m_vertices.insert(impl->m_tess.m_vertices.end(), vertices, vertices + count);
+    return index;
+}
+
 size_t MeshObject::get_vertex_count() const
 {
     return impl->m_tess.m_vertices.size();
@@ -175,13 +187,20 @@ const GVector3& MeshObject::get_vertex(const size_t index) const
     return impl->m_tess.m_vertices[index];
 }
 
+void MeshObject::clear_vertices()
+{
+    impl->m_tess.m_vertices.clear();
+}
+
 void MeshObject::reserve_vertex_normals(const size_t count)
 {
+    assert(!impl->m_tess.is_compact());
     impl->m_tess.m_vertex_normals.reserve(count);
 }
 
 size_t MeshObject::push_vertex_normal(const GVector3& normal)
 {
+    assert(!impl->m_tess.is_compact());
     assert(is_normalized(normal));
 
     const size_t index = impl->m_tess.m_vertex_normals.size();
@@ -189,19 +208,34 @@ size_t MeshObject::push_vertex_normal(const GVector3& normal)
     return index;
 }
 
+size_t MeshObject::push_vertex_normal_array(const GVector3 normals[], const size_t count)
+{
+    assert(!impl->m_tess.is_compact());
+
+#ifndef NDEBUG
+    for (size_t i = 0; i < count; ++i)
+        assert(is_normalized(normals[i]));
+#endif
+
+    const size_t index = impl->m_tess.m_vertex_normals.size();
+    impl->m_tess.m_vertex_normals.insert(impl->m_tess.m_vertex_normals.end(), normals, normals + count);
+    return index;
+}
+
 size_t MeshObject::get_vertex_normal_count() const
 {
-    return impl->m_tess.m_vertex_normals.size();
+    return impl->m_tess.get_vertex_normal_count();
 }
 
-const GVector3& MeshObject::get_vertex_normal(const size_t index) const
+GVector3 MeshObject::get_vertex_normal(const size_t index) const
 {
-    return impl->m_tess.m_vertex_normals[index];
+    return impl->m_tess.get_vertex_normal(index);
 }
 
 void MeshObject::clear_vertex_normals()
 {
     impl->m_tess.m_vertex_normals.clear();
+    impl->m_tess.m_compressed_vertex_normals.clear();
 }
 
 void MeshObject::reserve_vertex_tangents(const size_t count)
@@ -234,6 +268,11 @@ size_t MeshObject::push_tex_coords(const GVector2& tex_coords)
     return impl->m_tess.push_tex_coords(tex_coords);
 }
 
+size_t MeshObject::push_tex_coords_array(const GVector2 tex_coords[], const size_t count)
+{
+    return impl->m_tess.push_tex_coords_array(tex_coords, count);
+}
+
 size_t MeshObject::get_tex_coords_count() const
 {
     return impl->m_tess.get_tex_coords_count();
@@ -244,36 +283,69 @@ GVector2 MeshObject::get_tex_coords(const size_t index) const
     return impl->m_tess.get_tex_coords(index);
 }
 
+void MeshObject::clear_tex_coords()
+{
+    impl->m_tess.clear_tex_coords();
+}
+
 void MeshObject::reserve_triangles(const size_t count)
 {
+    assert(!impl->m_tess.is_compact());
     impl->m_tess.m_primitives.reserve(count);
 }
 
 size_t MeshObject::push_triangle(const Triangle& triangle)
 {
+    assert(!impl->m_tess.is_compact());
+
     const size_t index = impl->m_tess.m_primitives.size();
     impl->m_tess.m_primitives.push_back(triangle);
     return index;
 }
 
+size_t MeshObject::push_triangle_array(const Triangle triangles[], const size_t count)
+{
+    assert(!impl->m_tess.is_compact());
+
+    const size_t index = impl->m_tess.m_primitives.size();
+    impl->m_tess.m_primitives.insert(impl->m_tess.m_primitives.end(), triangles, triangles + count);
+    return index;
+}
+
 size_t MeshObject::get_triangle_count() const
 {
-    return impl->m_tess.m_primitives.size();
+    return impl->m_tess.get_primitive_count();
 }
 
-const Triangle& MeshObject::get_triangle(const size_t index) const
+Triangle MeshObject::get_triangle(const size_t index) const
 {
-    return impl->m_tess.m_primitives[index];
+    return impl->m_tess.get_primitive(index);
 }
 
 Triangle& MeshObject::get_triangle(const size_t index)
 {
+    // Triangles can only be modified in regular storage.
+    impl->m_tess.expand();
     return impl->m_tess.m_primitives[index];
 }
 
 void MeshObject::clear_triangles()
 {
     impl->m_tess.m_primitives.clear();
+    impl->m_tess.m_compact_primitives.clear();
+
+    // Allow inserting triangles again.
+    impl->m_tess.expand();
+}
+
+void MeshObject::compact()
+{
+    impl->m_tess.compact();
+}
+
+bool MeshObject::is_compact() const
+{
+    return impl->m_tess.is_compact();
 }
 
 void MeshObject::set_motion_segment_count(const size_t count)
@@ -90,14 +90,17 @@ class APPLESEED_DLLSYMBOL MeshObject
     // Insert and access vertices.
     void reserve_vertices(const size_t count);
     size_t push_vertex(const GVector3& vertex);
+    size_t push_vertex_array(const GVector3 vertices[], const size_t count);
     size_t get_vertex_count() const;
     const GVector3& get_vertex(const size_t index) const;
+    void clear_vertices();
 
     // Insert and access vertex normals.
     void reserve_vertex_normals(const size_t count);
     size_t push_vertex_normal(const GVector3& normal);      // the normal must be unit-length
+    size_t push_vertex_normal_array(const GVector3 normals[], const size_t count);
     size_t get_vertex_normal_count() const;
-    const GVector3& get_vertex_normal(const size_t index) const;
+    GVector3 get_vertex_normal(const size_t index) const;
     void clear_vertex_normals();
 
     // Insert and access vertex tangents.
@@ -109,16 +112,24 @@ class APPLESEED_DLLSYMBOL MeshObject
     // Insert and access texture coordinates.
     void reserve_tex_coords(const size_t count);
     size_t push_tex_coords(const GVector2& tex_coords);
+    size_t push_tex_coords_array(const GVector2 tex_coords[], const size_t count);
     size_t get_tex_coords_count() const;
     GVector2 get_tex_coords(const size_t index) const;
+    void clear_tex_coords();
 
     // Insert and access triangles.
     void reserve_triangles(const size_t count);
     size_t push_triangle(const Triangle& triangle);
+    size_t push_triangle_array(const Triangle triangles[], const size_t count);
     size_t get_triangle_count() const;
-    const Triangle& get_triangle(const size_t index) const;
-    Triangle& get_triangle(const size_t index);
-    void clear_triangles();
+    Triangle get_triangle(const size_t index) const;
+    Triangle& get_triangle(const size_t index);     // switches a compact object back to regular storage
+    void clear_triangles();                         // switches a compact object back to regular storage
+
+    // Switch the object to compact storage (see StaticTessellation::compact()).
+    // Must be called once all features have been inserted; motion poses can still be set.
+    void compact();
+    bool is_compact() const;
 
     // Set/get the number of motion segments (the number of motion vectors per vertex).
     void set_motion_segment_count(const size_t count);
@@ -49,6 +49,7 @@
 #include "foundation/mesh/objmeshfilereader.h"
 #include "foundation/platform/compiler.h"
 #include "foundation/platform/defaulttimers.h"
+#include "foundation/platform/system.h"
 #include "foundation/platform/types.h"
 #include "foundation/utility/api/apistring.h"
 #include "foundation/utility/autoreleaseptr.h"
@@ -291,6 +292,71 @@ namespace
             m_face_material = static_cast<std::uint32_t>(material);
         }
 
+        void push_vertex_array(const Vector3f vertices[], const size_t count) override
+        {
+            m_objects.back()->push_vertex_array(vertices, count);
+        }
+
+        void push_vertex_normal_array(const Vector3f vertex_normals[], const size_t count) override
+        {
+            m_normals.resize(count);
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                GVector3 n(vertex_normals[i]);
+
+                const GScalar norm_n = norm(n);
+
+                if (norm_n > GScalar(0.0))
+                    n /= norm_n;
+                else
+                {
+                    ++m_null_normal_vector_count;
+                    n = GVector3(GScalar(1.0), GScalar(0.0), GScalar(0.0));
+                }
+
+                m_normals[i] = n;
+            }
+
+            m_normal_count += count;
+
+            m_objects.back()->push_vertex_normal_array(m_normals.data(), count);
+
+            clear_release_memory(m_normals);
+        }
+
+        void push_tex_coords_array(const Vector2f tex_coords[], const size_t count) override
+        {
+            m_objects.back()->push_tex_coords_array(tex_coords, count);
+        }
+
+        void push_triangle_array(const std::uint32_t triangles[], const size_t count) override
+        {
+            static_assert(
+                sizeof(Triangle) == 10 * sizeof(std::uint32_t),
+                "renderer::Triangle must match the layout of triangle arrays");
+
+            MeshObject* object = m_objects.back();
+
+            if (m_ignore_vertex_normals)
+            {
+                const size_t first = object->get_triangle_count();
+
+                object->push_triangle_array(reinterpret_cast<const Triangle*>(triangles), count);
+
+                for (size_t i = 0; i < count; ++i)
+                {
+                    Triangle& triangle = object->get_triangle(first + i);
+                    triangle.m_n0 = Triangle::None;
+                    triangle.m_n1 = Triangle::None;
+                    triangle.m_n2 = Triangle::None;
+                }
+            }
+            else object->push_triangle_array(reinterpret_cast<const Triangle*>(triangles), count);
+
+            m_face_count += count;
+        }
+
       private:
         const ParamArray                  m_params;
         const bool                        m_ignore_vertex_normals;
@@ -314,6 +380,9 @@ namespace
         std::vector<Vector3d>             m_polygon;
         std::vector<size_t>               m_triangles;
 
+        // Support data for bulk insertion of vertex normals.
+        std::vector<GVector3>             m_normals;
+
         // Mesh statistics.
         size_t                            m_normal_count;
         size_t                            m_face_count;
@@ -398,16 +467,20 @@ namespace
         const char*             filename,
         const char*             base_object_name,
         const ParamArray&       params,
+        const size_t            obj_thread_count,
         MeshObjectArray&        objects)
     {
         GenericMeshFileReader reader(filename);
+        reader.set_obj_thread_count(obj_thread_count);
 
         const std::string obj_parsing_mode = params.get_optional<std::string>("obj_parsing_mode", "fast");
 
         if (obj_parsing_mode == "fast")
         {
             reader.set_obj_options(
-                reader.get_obj_options() | OBJMeshFileReader::FavorSpeedOverPrecision);
+                reader.get_obj_options() |
+                OBJMeshFileReader::FavorSpeedOverPrecision |
+                OBJMeshFileReader::ParallelParsing);
         }
         else if (obj_parsing_mode == "precise")
         {
@@ -424,7 +497,9 @@ namespace
                 obj_parsing_mode.c_str());
 
             reader.set_obj_options(
-                reader.get_obj_options() | OBJMeshFileReader::FavorSpeedOverPrecision);
+                reader.get_obj_options() |
+                OBJMeshFileReader::FavorSpeedOverPrecision |
+                OBJMeshFileReader::ParallelParsing);
         }
 
         MeshObjectBuilder builder(params, base_object_name);
@@ -701,6 +776,7 @@ namespace
         const StringDictionary& filenames,
         const char*             base_object_name,
         const ParamArray&       params,
+        const size_t            obj_thread_count,
         MeshObjectArray&        objects)
     {
         assert(filenames.size() >= 2);
@@ -721,6 +797,7 @@ namespace
                 search_paths.qualify(key_frames[0].m_filename).c_str(),
                 base_object_name,
                 params,
+                obj_thread_count,
                 objects))
             return false;
 
@@ -743,6 +820,7 @@ namespace
                     search_paths.qualify(filename).c_str(),
                     base_object_name,
                     params,
+                    obj_thread_count,
                     poses))
                 return false;
 
@@ -818,6 +896,12 @@ bool MeshObjectReader::read(
     ParamArray completed_params(params);
     completed_params.insert("__base_object_name", base_object_name);
 
+    // Number of threads used to parse OBJ files in parallel. Callers that already read
+    // several mesh files concurrently can lower it to avoid oversubscribing the machine.
+    const size_t obj_thread_count =
+        params.get_optional<size_t>("__obj_parsing_threads", System::get_logical_cpu_core_count());
+    completed_params.strings().remove("__obj_parsing_threads");
+
     // Read object(s) from disk.
     if (params.strings().exist("filename"))
     {
@@ -835,6 +919,7 @@ bool MeshObjectReader::read(
                 search_paths.qualify(params.strings().get<std::string>("filename")).c_str(),
                 base_object_name,
                 completed_params,
+                obj_thread_count,
                 objects))
             return false;
     }
@@ -860,6 +945,7 @@ bool MeshObjectReader::read(
                         search_paths.qualify(filenames.begin().value()).c_str(),
                         base_object_name,
                         completed_params,
+                        obj_thread_count,
                         objects))
                     return false;
             }
@@ -883,6 +969,7 @@ bool MeshObjectReader::read(
                         filenames,
                         base_object_name,
                         completed_params,
+                        obj_thread_count,
                         objects))
                     return false;
             }
@@ -914,6 +1001,18 @@ bool MeshObjectReader::read(
         }
     }
 
+    // Switch to compact storage. This must come last since compact objects can no longer be modified.
+    if (params.strings().exist("compact_storage"))
+    {
+        const RegExFilter filter(params.get("compact_storage"));
+        for (size_t i = 0, e = objects.size(); i < e; ++i)
+        {
+            MeshObject& object = *objects[i];
+            if (filter.accepts(object.get_name()))
+                object.compact();
+        }
+    }
+
     return true;
 }
 
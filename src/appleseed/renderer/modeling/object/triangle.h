@@ -30,9 +30,13 @@
 #pragma once
 
 // Standard headers.
+#include <cassert>
 #include <cstddef>
 #include <cstdint>
 
+// Forward declarations.
+namespace renderer  { class CompactTriangle; }
+
 namespace renderer
 {
 
@@ -52,6 +56,9 @@ class Triangle
     // Special index value used to indicate that a feature is not present.
     static const std::uint32_t None = ~std::uint32_t(0);
 
+    // Compact representation of triangles.
+    typedef CompactTriangle CompactType;
+
     // Public members.
     std::uint32_t  m_v0, m_v1, m_v2;    // vertex indices
     std::uint32_t  m_n0, m_n1, m_n2;    // vertex normal indices
@@ -94,6 +101,37 @@ class Triangle
 };
 
 
+//
+// A compact triangle only stores vertex indices and a primitive attribute index
+// (16 bytes instead of 40). It represents triangles whose vertex normal indices
+// and vertex attribute indices are either all absent or equal to their vertex
+// indices, which is the case of most meshes with per-vertex features.
+//
+
+class CompactTriangle
+{
+  public:
+    // Public members.
+    std::uint32_t  m_v0, m_v1, m_v2;    // vertex indices
+    std::uint32_t  m_pa;                // primitive attribute index and flags
+
+    // Return true if a given triangle can be represented by a compact triangle.
+    static bool can_represent(const Triangle& triangle);
+
+    // Constructors.
+    CompactTriangle();                  // leave all fields uninitialized
+    explicit CompactTriangle(const Triangle& triangle);
+
+    // Return the full triangle.
+    Triangle expand() const;
+
+  private:
+    static const std::uint32_t HasVertexNormals = 1UL << 31;
+    static const std::uint32_t HasVertexAttributes = 1UL << 30;
+    static const std::uint32_t PrimitiveAttributeMask = HasVertexAttributes - 1;
+};
+
+
 //
 // Triangle class implementation.
 //
@@ -187,4 +225,76 @@ inline bool Triangle::has_vertex_attributes() const
     return m_a0 != None && m_a1 != None && m_a2 != None;
 }
 
+
+//
+// CompactTriangle class implementation.
+//
+
+inline bool CompactTriangle::can_represent(const Triangle& triangle)
+{
+    const bool shared_vertex_normals =
+        (triangle.m_n0 == triangle.m_v0 && triangle.m_n1 == triangle.m_v1 && triangle.m_n2 == triangle.m_v2) ||
+        (triangle.m_n0 == Triangle::None && triangle.m_n1 == Triangle::None && triangle.m_n2 == Triangle::None);
+
+    const bool shared_vertex_attributes =
+        (triangle.m_a0 == triangle.m_v0 && triangle.m_a1 == triangle.m_v1 && triangle.m_a2 == triangle.m_v2) ||
+        (triangle.m_a0 == Triangle::None && triangle.m_a1 == Triangle::None && triangle.m_a2 == Triangle::None);
+
+    // The largest representable primitive attribute index stands for Triangle::None.
+    const bool representable_pa =
+        triangle.m_pa < PrimitiveAttributeMask || triangle.m_pa == Triangle::None;
+
+    return shared_vertex_normals && shared_vertex_attributes && representable_pa;
+}
+
+inline CompactTriangle::CompactTriangle()
+{
+}
+
+inline CompactTriangle::CompactTriangle(const Triangle& triangle)
+  : m_v0(triangle.m_v0)
+  , m_v1(triangle.m_v1)
+  , m_v2(triangle.m_v2)
+  , m_pa(triangle.m_pa & PrimitiveAttributeMask)
+{
+    assert(can_represent(triangle));
+
+    if (triangle.m_n0 != Triangle::None)
+        m_pa |= HasVertexNormals;
+
+    if (triangle.m_a0 != Triangle::None)
+        m_pa |= HasVertexAttributes;
+}
+
+inline Triangle CompactTriangle::expand() const
+{
+    const std::uint32_t pa = m_pa & PrimitiveAttributeMask;
+
+    Triangle triangle;
+
+    triangle.m_v0 = m_v0;
+    triangle.m_v1 = m_v1;
+    triangle.m_v2 = m_v2;
+
+    if (m_pa & HasVertexNormals)
+    {
+        triangle.m_n0 = m_v0;
+        triangle.m_n1 = m_v1;
+        triangle.m_n2 = m_v2;
+    }
+    else triangle.m_n0 = triangle.m_n1 = triangle.m_n2 = Triangle::None;
+
+    if (m_pa & HasVertexAttributes)
+    {
+        triangle.m_a0 = m_v0;
+        triangle.m_a1 = m_v1;
+        triangle.m_a2 = m_v2;
+    }
+    else triangle.m_a0 = triangle.m_a1 = triangle.m_a2 = Triangle::None;
+
+    triangle.m_pa = pa == PrimitiveAttributeMask ? Triangle::None : pa;
+
+    return triangle;
+}
+
 }   // namespace renderer
@@ -53,12 +53,14 @@
 #include "renderer/modeling/scene/assemblyfactoryregistrar.h"
 #include "renderer/modeling/scene/containers.h"
 #include "renderer/modeling/scene/scene.h"
+#include "renderer/modeling/scene/sceneeditjournal.h"
 #include "renderer/modeling/surfaceshader/surfaceshaderfactoryregistrar.h"
 #include "renderer/modeling/texture/texturefactoryregistrar.h"
 #include "renderer/modeling/volume/volumefactoryregistrar.h"
 #include "renderer/utility/pluginstore.h"
 
 // appleseed.foundation headers.
+#include "foundation/platform/system.h"
 #include "foundation/utility/searchpaths.h"
 
 // Standard headers.
@@ -124,13 +126,16 @@ struct Project::Impl
 
     // Project-specific components.
     LightPathRecorder                   m_light_path_recorder;
+    SceneEditJournal                    m_scene_edit_journal;
     std::unique_ptr<TraceContext>       m_trace_context;
     RenderingTimer                      m_rendering_timer;
+    size_t                              m_thread_count;
 
     explicit Impl(const Project& project)
       : m_format_revision(ProjectFormatRevision)
       , m_search_paths("APPLESEED_SEARCHPATH", SearchPaths::environment_path_separator())
       , m_light_path_recorder(project)
+      , m_thread_count(System::get_logical_cpu_core_count())
     {
     }
 };
@@ -283,6 +288,7 @@ const EntityTraits<Volume>::FactoryRegistrarType& Project::get_factory_registrar
 void Project::set_scene(auto_release_ptr<Scene> scene)
 {
     impl->m_scene = scene;
+    impl->m_scene_edit_journal.record_structure_edit();
 }
 
 Scene* Project::get_scene() const
@@ -340,6 +346,11 @@ LightPathRecorder& Project::get_light_path_recorder() const
     return impl->m_light_path_recorder;
 }
 
+SceneEditJournal& Project::get_scene_edit_journal() const
+{
+    return impl->m_scene_edit_journal;
+}
+
 #ifdef APPLESEED_WITH_EMBREE
 
 void Project::set_use_embree(const bool value)
@@ -350,6 +361,21 @@ void Project::set_use_embree(const bool value)
 
 #endif
 
+void Project::set_thread_count(const size_t thread_count)
+{
+    assert(thread_count > 0);
+
+    impl->m_thread_count = thread_count;
+
+    if (impl->m_trace_context)
+        impl->m_trace_context->set_thread_count(thread_count);
+}
+
+size_t Project::get_thread_count() const
+{
+    return impl->m_thread_count;
+}
+
 bool Project::has_trace_context() const
 {
     return impl->m_trace_context.get() != nullptr;
@@ -361,6 +387,7 @@ const TraceContext& Project::get_trace_context() const
     {
         assert(impl->m_scene.get());
         impl->m_trace_context.reset(new TraceContext(*impl->m_scene));
+        impl->m_trace_context->set_thread_count(impl->m_thread_count);
     }
 
     return *impl->m_trace_context;
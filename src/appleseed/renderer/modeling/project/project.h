@@ -83,6 +83,7 @@ namespace renderer      { class OnFrameBeginRecorder; }
 namespace renderer      { class PluginStore; }
 namespace renderer      { class PostProcessingStage; }
 namespace renderer      { class Scene; }
+namespace renderer      { class SceneEditJournal; }
 namespace renderer      { class SurfaceShader; }
 namespace renderer      { class Texture; }
 namespace renderer      { class TraceContext; }
@@ -160,11 +161,20 @@ class APPLESEED_DLLSYMBOL Project
     // Access the light path recorder.
     LightPathRecorder& get_light_path_recorder() const;
 
+    // Access the journal of edits made to the scene during rendering.
+    SceneEditJournal& get_scene_edit_journal() const;
+
 #ifdef APPLESEED_WITH_EMBREE
     // Set use Embree flag for trace context
     void set_use_embree(const bool value);
 #endif
 
+    // Set or get the number of threads used to prepare the scene for rendering,
+    // for instance to build acceleration structures. Defaults to the number of
+    // logical CPU cores.
+    void set_thread_count(const size_t thread_count);
+    size_t get_thread_count() const;
+
     // Return true if the trace context has already been built.
     bool has_trace_context() const;
 
@@ -64,7 +64,9 @@
 #include "renderer/modeling/material/imaterialfactory.h"
 #include "renderer/modeling/material/material.h"
 #include "renderer/modeling/material/materialfactoryregistrar.h"
+#include "renderer/modeling/object/curveobject.h"
 #include "renderer/modeling/object/iobjectfactory.h"
+#include "renderer/modeling/object/meshobject.h"
 #include "renderer/modeling/object/object.h"
 #include "renderer/modeling/object/objectfactoryregistrar.h"
 #include "renderer/modeling/postprocessingstage/ipostprocessingstagefactory.h"
@@ -109,12 +111,14 @@
 #include "foundation/math/vector.h"
 #include "foundation/platform/compiler.h"
 #include "foundation/platform/defaulttimers.h"
+#include "foundation/platform/system.h"
 #include "foundation/platform/types.h"
 #include "foundation/utility/api/apiarray.h"
 #include "foundation/utility/api/apistring.h"
 #include "foundation/utility/containers/dictionary.h"
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/iterators.h"
+#include "foundation/utility/job.h"
 #include "foundation/utility/log.h"
 #include "foundation/utility/memory.h"
 #include "foundation/utility/otherwise.h"
@@ -136,6 +140,7 @@
 #include "boost/filesystem/operations.hpp"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstring>
@@ -206,6 +211,30 @@ namespace
     };
 
 
+    //
+    // An object whose creation is deferred until the whole project file has been parsed.
+    //
+    // Objects are not created while parsing: they are collected in document order, then
+    // created once parsing is complete so that objects backed by external geometry files
+    // (mesh and curve files) can be read concurrently.
+    //
+
+    struct PendingObject
+    {
+        const IObjectFactory*    m_factory;
+        std::string              m_name;
+        std::string              m_model;
+        ParamArray               m_params;
+        bool                     m_parallel;         // can this object be created on a worker thread?
+        std::vector<std::string> m_assembly_path;    // names of the enclosing assemblies, outermost first
+        bool                     m_discarded;        // was one of the enclosing assemblies dropped?
+        Assembly*                m_assembly;         // assembly the objects will be inserted into, resolved after parsing
+        ObjectArray              m_objects;
+        bool                     m_success;
+        double                   m_creation_time;    // in seconds
+    };
+
+
     //
     // A set of objects that is passed to all element handlers.
     //
@@ -216,9 +245,11 @@ namespace
         ParseContext(
             Project&        project,
             const int       options,
+            const size_t    thread_count,
             EventCounters&  event_counters)
           : m_project(project)
           , m_options(options)
+          , m_thread_count(thread_count)
           , m_event_counters(event_counters)
         {
         }
@@ -233,15 +264,54 @@ namespace
             return m_options;
         }
 
+        size_t get_thread_count() const
+        {
+            return m_thread_count;
+        }
+
         EventCounters& get_event_counters()
         {
             return m_event_counters;
         }
 
+        void push_pending_object(std::unique_ptr<PendingObject> object)
+        {
+            m_pending_objects.push_back(std::move(object));
+        }
+
+        size_t get_pending_object_count() const
+        {
+            return m_pending_objects.size();
+        }
+
+        // Record that all pending objects declared after a given index are enclosed in a given assembly.
+        void enclose_pending_objects(const size_t begin, const std::string& assembly_name)
+        {
+            for (size_t i = begin, e = m_pending_objects.size(); i < e; ++i)
+            {
+                std::vector<std::string>& path = m_pending_objects[i]->m_assembly_path;
+                path.insert(path.begin(), assembly_name);
+            }
+        }
+
+        // Discard all pending objects declared after a given index, because their assembly was dropped.
+        void discard_pending_objects(const size_t begin)
+        {
+            for (size_t i = begin, e = m_pending_objects.size(); i < e; ++i)
+                m_pending_objects[i]->m_discarded = true;
+        }
+
+        std::vector<std::unique_ptr<PendingObject>>& get_pending_objects()
+        {
+            return m_pending_objects;
+        }
+
       private:
-        Project&            m_project;
-        const int           m_options;
-        EventCounters&      m_event_counters;
+        Project&                                        m_project;
+        const int                                       m_options;
+        const size_t                                    m_thread_count;
+        EventCounters&                                  m_event_counters;
+        std::vector<std::unique_ptr<PendingObject>>     m_pending_objects;
     };
 
 
@@ -1526,8 +1596,6 @@ namespace
       : public ParametrizedElementHandler
     {
       public:
-        typedef std::vector<Object*> ObjectVector;
-
         explicit ObjectElementHandler(ParseContext& context)
           : m_context(context)
         {
@@ -1537,8 +1605,6 @@ namespace
         {
             ParametrizedElementHandler::start_element(attrs);
 
-            clear_keep_memory(m_objects);
-
             m_name = get_value(attrs, "name");
             m_model = get_value(attrs, "model");
         }
@@ -1547,67 +1613,39 @@ namespace
         {
             ParametrizedElementHandler::end_element();
 
-            try
-            {
-                const IObjectFactory* factory =
-                    m_context.get_project().get_factory_registrar<Object>().lookup(m_model.c_str());
-
-                if (factory)
-                {
-                    ObjectArray objects;
-                    if (!factory->create(
-                            m_name.c_str(),
-                            m_params,
-                            m_context.get_project().search_paths(),
-                            m_context.get_options() & ProjectFileReader::OmitReadingMeshFiles,
-                            objects))
-                        m_context.get_event_counters().signal_error();
+            const IObjectFactory* factory =
+                m_context.get_project().get_factory_registrar<Object>().lookup(m_model.c_str());
 
-                    m_objects = array_vector<ObjectVector>(objects);
-                }
-                else
-                {
-                    RENDERER_LOG_ERROR(
-                        "while defining object \"%s\": invalid model \"%s\".",
-                        m_name.c_str(),
-                        m_model.c_str());
-                    m_context.get_event_counters().signal_error();
-                }
-            }
-            catch (const ExceptionDictionaryKeyNotFound& e)
-            {
-                RENDERER_LOG_ERROR(
-                    "while defining object \"%s\": required parameter \"%s\" missing.",
-                    m_name.c_str(),
-                    e.string());
-                m_context.get_event_counters().signal_error();
-            }
-            catch (const ExceptionUnknownEntity& e)
+            if (factory == nullptr)
             {
                 RENDERER_LOG_ERROR(
-                    "while defining object \"%s\": unknown entity \"%s\".",
+                    "while defining object \"%s\": invalid model \"%s\".",
                     m_name.c_str(),
-                    e.string());
-                m_context.get_event_counters().signal_error();
-            }
-            catch (const Exception& e)
-            {
-                RENDERER_LOG_ERROR(
-                    "while defining object \"%s\": %s",
-                    m_name.c_str(),
-                    e.what());
+                    m_model.c_str());
                 m_context.get_event_counters().signal_error();
+                return;
             }
-        }
 
-        const ObjectVector& get_objects() const
-        {
-            return m_objects;
+            // Only mesh and curve objects, whose creation is dominated by file I/O, are created in parallel.
+            const bool parallel =
+                (m_context.get_options() & ProjectFileReader::OmitReadingMeshFiles) == 0 &&
+                (m_model == MeshObjectFactory().get_model() || m_model == CurveObjectFactory().get_model());
+
+            std::unique_ptr<PendingObject> object(new PendingObject());
+            object->m_factory = factory;
+            object->m_name = m_name;
+            object->m_model = m_model;
+            object->m_params = m_params;
+            object->m_parallel = parallel;
+            object->m_discarded = false;
+            object->m_assembly = nullptr;
+            object->m_success = false;
+            object->m_creation_time = 0.0;
+            m_context.push_pending_object(std::move(object));
         }
 
       private:
         ParseContext&   m_context;
-        ObjectVector    m_objects;
         std::string     m_name;
         std::string     m_model;
     };
@@ -2041,11 +2079,12 @@ namespace
       protected:
         ParseContext& m_context;
 
+        // Insert an entity into a container. Return false if the entity was dropped.
         template <typename Container, typename Entity>
-        void insert(Container& container, auto_release_ptr<Entity> entity)
+        bool insert(Container& container, auto_release_ptr<Entity> entity)
         {
             if (entity.get() == nullptr)
-                return;
+                return false;
 
             if (container.get_by_name(entity->get_name()) != nullptr)
             {
@@ -2053,11 +2092,13 @@ namespace
                     "an entity with the path \"%s\" already exists.",
                     entity->get_path().c_str());
                 m_context.get_event_counters().signal_error();
-                return;
+                return false;
             }
 
             container.insert(entity);
+            return true;
         }
+
     };
 
 
@@ -2088,7 +2129,6 @@ namespace
             m_edfs.clear();
             m_lights.clear();
             m_materials.clear();
-            m_objects.clear();
             m_object_instances.clear();
             m_volumes.clear();
             m_shader_groups.clear();
@@ -2098,6 +2138,8 @@ namespace
 
             m_name = get_value(attrs, "name");
             m_model = get_value(attrs, "model", AssemblyFactory().get_model());
+
+            m_first_pending_object = m_context.get_pending_object_count();
         }
 
         void end_element() override
@@ -2119,7 +2161,6 @@ namespace
                 m_assembly->edfs().swap(m_edfs);
                 m_assembly->lights().swap(m_lights);
                 m_assembly->materials().swap(m_materials);
-                m_assembly->objects().swap(m_objects);
                 m_assembly->object_instances().swap(m_object_instances);
                 m_assembly->volumes().swap(m_volumes);
                 m_assembly->shader_groups().swap(m_shader_groups);
@@ -2135,6 +2176,10 @@ namespace
                     m_model.c_str());
                 m_context.get_event_counters().signal_error();
             }
+
+            // Objects declared in this assembly will be inserted into it once they are created.
+            // They are discarded by the parent element if this assembly ends up being dropped.
+            m_context.enclose_pending_objects(m_first_pending_object, m_name);
         }
 
         void end_child_element(
@@ -2144,9 +2189,13 @@ namespace
             switch (element)
             {
               case ElementAssembly:
-                insert(
-                    m_assemblies,
-                    static_cast<AssemblyElementHandler*>(handler)->get_assembly());
+                {
+                    AssemblyElementHandler* assembly_handler = static_cast<AssemblyElementHandler*>(handler);
+
+                    // Objects declared in a dropped assembly must not be created.
+                    if (!insert(m_assemblies, assembly_handler->get_assembly()))
+                        m_context.discard_pending_objects(assembly_handler->get_first_pending_object());
+                }
                 break;
 
               case ElementAssemblyInstance:
@@ -2192,8 +2241,7 @@ namespace
                 break;
 
               case ElementObject:
-                for (Object* object : static_cast<ObjectElementHandler*>(handler)->get_objects())
-                    insert(m_objects, auto_release_ptr<Object>(object));
+                // Objects are created and inserted once the whole file is parsed (see create_pending_objects()).
                 break;
 
               case ElementObjectInstance:
@@ -2243,10 +2291,16 @@ namespace
             return m_assembly;
         }
 
+        size_t get_first_pending_object() const
+        {
+            return m_first_pending_object;
+        }
+
       private:
         auto_release_ptr<Assembly>  m_assembly;
         std::string                 m_name;
         std::string                 m_model;
+        size_t                      m_first_pending_object;
         AssemblyContainer           m_assemblies;
         AssemblyInstanceContainer   m_assembly_instances;
         BSDFContainer               m_bsdfs;
@@ -2255,7 +2309,6 @@ namespace
         EDFContainer                m_edfs;
         LightContainer              m_lights;
         MaterialContainer           m_materials;
-        ObjectContainer             m_objects;
         ObjectInstanceContainer     m_object_instances;
         VolumeContainer             m_volumes;
         ShaderGroupContainer        m_shader_groups;
@@ -2315,9 +2368,13 @@ namespace
             switch (element)
             {
               case ElementAssembly:
-                insert(
-                    m_scene->assemblies(),
-                    static_cast<AssemblyElementHandler*>(handler)->get_assembly());
+                {
+                    AssemblyElementHandler* assembly_handler = static_cast<AssemblyElementHandler*>(handler);
+
+                    // Objects declared in a dropped assembly must not be created.
+                    if (!insert(m_scene->assemblies(), assembly_handler->get_assembly()))
+                        m_context.discard_pending_objects(assembly_handler->get_first_pending_object());
+                }
                 break;
 
               case ElementAssemblyInstance:
@@ -3126,6 +3183,246 @@ namespace
     };
 }
 
+namespace
+{
+    //
+    // Creation of pending objects.
+    //
+
+    void create_pending_object(
+        PendingObject&          object,
+        const SearchPaths&      search_paths,
+        const bool              omit_loading_assets)
+    {
+        Stopwatch<DefaultWallclockTimer> stopwatch;
+        stopwatch.start();
+
+        try
+        {
+            object.m_success =
+                object.m_factory->create(
+                    object.m_name.c_str(),
+                    object.m_params,
+                    search_paths,
+                    omit_loading_assets,
+                    object.m_objects);
+        }
+        catch (const ExceptionDictionaryKeyNotFound& e)
+        {
+            RENDERER_LOG_ERROR(
+                "while defining object \"%s\": required parameter \"%s\" missing.",
+                object.m_name.c_str(),
+                e.string());
+            object.m_success = false;
+        }
+        catch (const ExceptionUnknownEntity& e)
+        {
+            RENDERER_LOG_ERROR(
+                "while defining object \"%s\": unknown entity \"%s\".",
+                object.m_name.c_str(),
+                e.string());
+            object.m_success = false;
+        }
+        catch (const Exception& e)
+        {
+            RENDERER_LOG_ERROR(
+                "while defining object \"%s\": %s",
+                object.m_name.c_str(),
+                e.what());
+            object.m_success = false;
+        }
+
+        stopwatch.measure();
+        object.m_creation_time = stopwatch.get_seconds();
+    }
+
+    class CreatePendingObjectJob
+      : public IJob
+    {
+      public:
+        CreatePendingObjectJob(
+            PendingObject&      object,
+            const SearchPaths&  search_paths)
+          : m_object(object)
+          , m_search_paths(search_paths)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            create_pending_object(m_object, m_search_paths, false);
+        }
+
+      private:
+        PendingObject&          m_object;
+        const SearchPaths&      m_search_paths;
+    };
+
+    void print_object_creation_statistics(
+        const std::vector<std::unique_ptr<PendingObject>>&  objects,
+        const size_t                                        thread_count,
+        const double                                        creation_time)
+    {
+        // Per-model object count and cumulative creation time.
+        std::map<std::string, std::pair<size_t, double>> stats;
+        for (const auto& object : objects)
+        {
+            std::pair<size_t, double>& model_stats = stats[object->m_model];
+            model_stats.first += object->m_objects.size();
+            model_stats.second += object->m_creation_time;
+        }
+
+        for (const auto& model_stats : stats)
+        {
+            RENDERER_LOG_INFO(
+                "created %s %s of model \"%s\" (%s cumulative).",
+                pretty_uint(model_stats.second.first).c_str(),
+                plural(model_stats.second.first, "object").c_str(),
+                model_stats.first.c_str(),
+                pretty_time(model_stats.second.second).c_str());
+        }
+
+        RENDERER_LOG_INFO(
+            "created all objects in %s using %s %s.",
+            pretty_time(creation_time).c_str(),
+            pretty_uint(thread_count).c_str(),
+            plural(thread_count, "thread").c_str());
+    }
+
+    // Find the assembly a pending object will be inserted into, or return nullptr if there is none.
+    Assembly* resolve_pending_object_assembly(Scene* scene, const PendingObject& object)
+    {
+        if (scene == nullptr || object.m_discarded || object.m_assembly_path.empty())
+            return nullptr;
+
+        AssemblyContainer* assemblies = &scene->assemblies();
+        Assembly* assembly = nullptr;
+
+        for (const std::string& assembly_name : object.m_assembly_path)
+        {
+            assembly = assemblies->get_by_name(assembly_name.c_str());
+            if (assembly == nullptr)
+                return nullptr;
+            assemblies = &assembly->assemblies();
+        }
+
+        return assembly;
+    }
+
+    // Create all objects declared in a project file and insert them into their assemblies.
+    void create_pending_objects(ParseContext& context)
+    {
+        std::vector<std::unique_ptr<PendingObject>>& objects = context.get_pending_objects();
+
+        if (objects.empty())
+            return;
+
+        Stopwatch<DefaultWallclockTimer> stopwatch;
+        stopwatch.start();
+
+        Project& project = context.get_project();
+        const SearchPaths& search_paths = project.search_paths();
+        const bool omit_loading_assets =
+            (context.get_options() & ProjectFileReader::OmitReadingMeshFiles) != 0;
+
+        // Assemblies are only looked up now that they are all owned by the scene.
+        size_t parallel_object_count = 0;
+        for (const auto& object : objects)
+        {
+            object->m_assembly = resolve_pending_object_assembly(project.get_scene(), *object);
+
+            if (object->m_parallel && object->m_assembly != nullptr)
+                ++parallel_object_count;
+        }
+
+        // Read objects backed by external files concurrently. The number of files being
+        // read (and decoded) at any given time is bounded by the number of worker threads.
+        const size_t thread_budget = std::max<size_t>(context.get_thread_count(), 1);
+        const size_t thread_count =
+            std::max<size_t>(
+                std::min(thread_budget, parallel_object_count),
+                1);
+
+        // Mesh files may themselves be parsed on multiple threads: share the thread
+        // budget between the files being read concurrently.
+        const size_t obj_thread_count = std::max<size_t>(thread_budget / thread_count, 1);
+
+        JobQueue job_queue;
+
+        for (const auto& object : objects)
+        {
+            if (object->m_parallel && object->m_assembly != nullptr)
+            {
+                if (object->m_model == MeshObjectFactory().get_model() &&
+                    !object->m_params.strings().exist("primitive"))
+                    object->m_params.insert("__obj_parsing_threads", obj_thread_count);
+
+                job_queue.schedule(new CreatePendingObjectJob(*object, search_paths));
+            }
+        }
+
+        if (parallel_object_count > 0)
+        {
+            JobManager job_manager(
+                global_logger(),
+                job_queue,
+                thread_count,
+                JobManager::KeepRunningOnEmptyQueue);
+            job_manager.start();
+
+            // Meanwhile, create the remaining objects on this thread, since their
+            // factories are not guaranteed to be thread-safe.
+            for (const auto& object : objects)
+            {
+                if (!object->m_parallel && object->m_assembly != nullptr)
+                    create_pending_object(*object, search_paths, omit_loading_assets);
+            }
+
+            job_queue.wait_until_completion();
+        }
+        else
+        {
+            for (const auto& object : objects)
+            {
+                if (object->m_assembly != nullptr)
+                    create_pending_object(*object, search_paths, omit_loading_assets);
+            }
+        }
+
+        // Insert objects into their assemblies in document order.
+        for (const auto& pending_object : objects)
+        {
+            if (pending_object->m_assembly == nullptr)
+                continue;
+
+            if (!pending_object->m_success)
+                context.get_event_counters().signal_error();
+
+            ObjectContainer& container = pending_object->m_assembly->objects();
+
+            for (size_t i = 0, e = pending_object->m_objects.size(); i < e; ++i)
+            {
+                auto_release_ptr<Object> object(pending_object->m_objects[i]);
+
+                if (container.get_by_name(object->get_name()) != nullptr)
+                {
+                    RENDERER_LOG_ERROR(
+                        "an entity with the path \"%s\" already exists.",
+                        object->get_path().c_str());
+                    context.get_event_counters().signal_error();
+                    continue;
+                }
+
+                container.insert(object);
+            }
+        }
+
+        stopwatch.measure();
+
+        print_object_creation_statistics(objects, thread_count, stopwatch.get_seconds());
+    }
+}
+
 namespace
 {
     bool is_builtin_project(const std::string& project_filepath, std::string& project_name)
@@ -3166,6 +3463,21 @@ namespace
     }
 }
 
+ProjectFileReader::ProjectFileReader()
+  : m_thread_count(System::get_logical_cpu_core_count())
+{
+}
+
+void ProjectFileReader::set_thread_count(const size_t thread_count)
+{
+    m_thread_count = thread_count;
+}
+
+size_t ProjectFileReader::get_thread_count() const
+{
+    return m_thread_count;
+}
+
 auto_release_ptr<Project> ProjectFileReader::read(
     const char*             project_filepath,
     const char*             schema_filepath,
@@ -3386,7 +3698,7 @@ auto_release_ptr<Project> ProjectFileReader::load_project_file(
             event_counters));
 
     // Create the content handler.
-    ParseContext context(project.ref(), options, event_counters);
+    ParseContext context(project.ref(), options, m_thread_count, event_counters);
     std::unique_ptr<ContentHandler> content_handler(
         new ContentHandler(
             project.get(),
@@ -3437,6 +3749,9 @@ auto_release_ptr<Project> ProjectFileReader::load_project_file(
         error_handler->get_fatal_error_count() > 0)
         return auto_release_ptr<Project>(nullptr);
 
+    // Create the objects declared in the project file.
+    create_pending_objects(context);
+
     return project;
 }
 
@@ -36,6 +36,9 @@
 // appleseed.main headers.
 #include "main/dllsymbol.h"
 
+// Standard headers.
+#include <cstddef>
+
 // Forward declarations.
 namespace renderer  { class Assembly; }
 namespace renderer  { class EventCounters; }
@@ -60,6 +63,15 @@ class APPLESEED_DLLSYMBOL ProjectFileReader
         OmitProjectSchemaValidation = 1UL << 3      // do not validate project against schema
     };
 
+    // Constructor.
+    ProjectFileReader();
+
+    // Set/get the maximum number of threads used to create objects backed by external files.
+    // Defaults to the number of logical CPU cores. The configurations of a project are only
+    // known once it is read, so their rendering_threads parameter does not apply here.
+    void set_thread_count(const size_t thread_count);
+    size_t get_thread_count() const;
+
     // Read a project from disk (or load a built-in project).
     // Return 0 if reading or parsing the file failed.
     foundation::auto_release_ptr<Project> read(
@@ -81,6 +93,8 @@ class APPLESEED_DLLSYMBOL ProjectFileReader
         const int                       options = Defaults);
 
   private:
+    size_t m_thread_count;
+
     foundation::auto_release_ptr<Project> load_project_file(
         const char*                     project_filepath,
         const char*                     schema_filepath,
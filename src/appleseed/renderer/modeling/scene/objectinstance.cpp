@@ -225,6 +225,12 @@ bool ObjectInstance::is_in_same_sss_set(const ObjectInstance& other) const
     return impl->m_sss_set_identifier == other.impl->m_sss_set_identifier;
 }
 
+void ObjectInstance::set_transform(const Transformd& transform)
+{
+    impl->m_transform = transform;
+    bump_version_id();
+}
+
 const Transformd& ObjectInstance::get_transform() const
 {
     return impl->m_transform;
@@ -96,7 +96,9 @@ class APPLESEED_DLLSYMBOL ObjectInstance
     // Return the name of the instantiated object.
     const char* get_object_name() const;
 
-    // Return the transform of this instance.
+    // Set or return the transform of this instance. Changing the transform of an instance
+    // being rendered must be recorded in the scene edit journal of the project.
+    void set_transform(const foundation::Transformd& transform);
     const foundation::Transformd& get_transform() const;
 
     // Return true if the normals of this instance must be flipped.
@@ -0,0 +1,373 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "sceneeditjournal.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/modeling/camera/camera.h"
+#include "renderer/modeling/object/object.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/assemblyinstance.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/objectinstance.h"
+#include "renderer/modeling/scene/scene.h"
+
+// appleseed.foundation headers.
+#include "foundation/platform/thread.h"
+#include "foundation/utility/api/apistring.h"
+#include "foundation/utility/string.h"
+
+// Standard headers.
+#include <cassert>
+#include <set>
+#include <vector>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+//
+// SceneEditJournal class implementation.
+//
+
+struct SceneEditJournal::Impl
+{
+    struct Edit
+    {
+        Entity*             m_entity;
+        EditType            m_type;
+    };
+
+    mutable boost::mutex    m_mutex;
+    std::vector<Edit>       m_edits;
+    bool                    m_has_structure_edits;
+
+    Impl()
+      : m_has_structure_edits(false)
+    {
+    }
+};
+
+SceneEditJournal::SceneEditJournal()
+  : impl(new Impl())
+{
+}
+
+SceneEditJournal::~SceneEditJournal()
+{
+    delete impl;
+}
+
+void SceneEditJournal::record(Entity& entity, const EditType type)
+{
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+
+    Impl::Edit edit;
+    edit.m_entity = &entity;
+    edit.m_type = type;
+    impl->m_edits.push_back(edit);
+
+    if (type == StructureEdit)
+        impl->m_has_structure_edits = true;
+}
+
+void SceneEditJournal::record_structure_edit()
+{
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+
+    impl->m_has_structure_edits = true;
+}
+
+bool SceneEditJournal::empty() const
+{
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+
+    return impl->m_edits.empty() && !impl->m_has_structure_edits;
+}
+
+bool SceneEditJournal::has_structure_edits() const
+{
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+
+    return impl->m_has_structure_edits;
+}
+
+size_t SceneEditJournal::size() const
+{
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+
+    return impl->m_edits.size();
+}
+
+void SceneEditJournal::get_edit(const size_t index, Entity*& entity, EditType& type) const
+{
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+
+    assert(index < impl->m_edits.size());
+
+    entity = impl->m_edits[index].m_entity;
+    type = impl->m_edits[index].m_type;
+}
+
+void SceneEditJournal::clear()
+{
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+
+    impl->m_edits.clear();
+    impl->m_has_structure_edits = false;
+}
+
+
+//
+// apply_scene_edits_in_place() function implementation.
+//
+
+namespace
+{
+    typedef std::set<Assembly*> AssemblySet;
+
+    bool is_emitting(const ObjectInstance& object_instance)
+    {
+        return
+            has_emitting_materials(object_instance.get_front_materials()) ||
+            has_emitting_materials(object_instance.get_back_materials());
+    }
+
+    // Return true if an assembly or any of its child assembly instances contains light emitters.
+    bool has_emitters(const Assembly& assembly)
+    {
+        if (!assembly.lights().empty())
+            return true;
+
+        for (const ObjectInstance& object_instance : assembly.object_instances())
+        {
+            if (is_emitting(object_instance))
+                return true;
+        }
+
+        for (const AssemblyInstance& assembly_instance : assembly.assembly_instances())
+        {
+            if (has_emitters(assembly_instance.get_assembly()))
+                return true;
+        }
+
+        return false;
+    }
+
+    // Collect the assemblies that contain instances of a given object.
+    // Return true if any of these instances emits light.
+    bool collect_object_users(
+        Assembly&                   assembly,
+        const Object&               object,
+        AssemblySet&                assemblies)
+    {
+        bool emitting = false;
+
+        for (const ObjectInstance& object_instance : assembly.object_instances())
+        {
+            if (&object_instance.get_object() == &object)
+            {
+                assemblies.insert(&assembly);
+                emitting = emitting || is_emitting(object_instance);
+            }
+        }
+
+        // Objects are visible from child assemblies.
+        for (Assembly& child_assembly : assembly.assemblies())
+        {
+            if (collect_object_users(child_assembly, object, assemblies))
+                emitting = true;
+        }
+
+        return emitting;
+    }
+
+    // Bind the materials of an object instance again, the same way InputBinder does.
+    void rebind_materials(ObjectInstance& object_instance)
+    {
+        object_instance.unbind_materials();
+
+        for (Entity* parent = object_instance.get_parent(); parent != nullptr; parent = parent->get_parent())
+        {
+            if (Assembly* assembly = dynamic_cast<Assembly*>(parent))
+                object_instance.bind_materials(assembly->materials());
+        }
+
+        object_instance.check_materials();
+    }
+
+    // Apply a scene edit in place, or return false if that's not possible. Light samplers
+    // store emitters in world space: moving emitters sets emitters_moved so that light
+    // samplers get updated, other edits involving light emitters are never applied in place.
+    bool apply_scene_edit(
+        Entity&                     entity,
+        const SceneEditJournal::EditType type,
+        AssemblySet&                modified_assemblies,
+        bool&                       emitters_moved)
+    {
+        switch (type)
+        {
+          case SceneEditJournal::TransformEdit:
+            // Cameras are prepared at the beginning of each frame.
+            if (dynamic_cast<Camera*>(&entity) != nullptr)
+                return true;
+
+            // The assembly tree is rebuilt each time the trace context is updated.
+            if (AssemblyInstance* assembly_instance = dynamic_cast<AssemblyInstance*>(&entity))
+            {
+                if (has_emitters(assembly_instance->get_assembly()))
+                    emitters_moved = true;
+
+                return true;
+            }
+
+            // Object instance transforms are baked into the child trees of their assembly.
+            if (ObjectInstance* object_instance = dynamic_cast<ObjectInstance*>(&entity))
+            {
+                Assembly* assembly = dynamic_cast<Assembly*>(object_instance->get_parent());
+                if (assembly == nullptr)
+                    return false;
+
+                // The render data of the object instance still hold the handedness of its
+                // previous transform; don't apply edits that flip it in place.
+                if (object_instance->get_transform().swaps_handedness() !=
+                    object_instance->get_render_data().m_transform_swaps_handedness)
+                    return false;
+
+                if (is_emitting(*object_instance))
+                    emitters_moved = true;
+
+                modified_assemblies.insert(assembly);
+                return true;
+            }
+
+            return false;
+
+          case SceneEditJournal::MaterialBindingEdit:
+            if (ObjectInstance* object_instance = dynamic_cast<ObjectInstance*>(&entity))
+            {
+                if (is_emitting(*object_instance))
+                    return false;
+
+                try
+                {
+                    rebind_materials(*object_instance);
+                }
+                catch (const ExceptionUnknownEntity&)
+                {
+                    // Let the input binder report the error.
+                    return false;
+                }
+
+                // Intersection filters are updated each time the trace context is updated.
+                return !is_emitting(*object_instance);
+            }
+
+            return false;
+
+          case SceneEditJournal::GeometryEdit:
+            if (Object* object = dynamic_cast<Object*>(&entity))
+            {
+                Assembly* assembly = dynamic_cast<Assembly*>(object->get_parent());
+                return
+                    assembly != nullptr &&
+                    !collect_object_users(*assembly, *object, modified_assemblies);
+            }
+
+            return false;
+
+          default:
+            return false;
+        }
+    }
+}
+
+bool apply_scene_edits_in_place(
+    const SceneEditJournal&     journal,
+    const Scene&                scene,
+    bool&                       emitters_moved)
+{
+    emitters_moved = false;
+
+    // Requests to reinitialize rendering without any recorded edit are assumed
+    // to follow edits that cannot be applied in place.
+    if (journal.empty() || journal.has_structure_edits())
+        return false;
+
+    // Tracers decide how to trace rays based on these when rendering is initialized.
+    const bool used_alpha_mapping = scene.uses_alpha_mapping();
+    const bool had_participating_media = scene.has_participating_media();
+
+    const size_t edit_count = journal.size();
+    AssemblySet modified_assemblies;
+
+    for (size_t i = 0; i < edit_count; ++i)
+    {
+        Entity* entity;
+        SceneEditJournal::EditType type;
+        journal.get_edit(i, entity, type);
+
+        if (!apply_scene_edit(*entity, type, modified_assemblies, emitters_moved))
+        {
+            RENDERER_LOG_DEBUG(
+                "edit of \"%s\" cannot be applied in place, reinitializing rendering...",
+                entity->get_path().c_str());
+            return false;
+        }
+    }
+
+    if (scene.uses_alpha_mapping() != used_alpha_mapping ||
+        scene.has_participating_media() != had_participating_media)
+    {
+        RENDERER_LOG_DEBUG("alpha mapping or participating media usage changed, reinitializing rendering...");
+        return false;
+    }
+
+    // The scene's render data are used by many entities when rendering begins.
+    if (scene.compute_bbox() != scene.get_render_data().m_bbox)
+    {
+        RENDERER_LOG_DEBUG("scene bounding box changed, reinitializing rendering...");
+        return false;
+    }
+
+    RENDERER_LOG_INFO(
+        "applying %s scene %s in place...",
+        pretty_uint(edit_count).c_str(),
+        plural(edit_count, "edit").c_str());
+
+    // Only the child trees of modified assemblies need to be rebuilt.
+    for (Assembly* assembly : modified_assemblies)
+        assembly->bump_version_id();
+
+    return true;
+}
+
+}   // namespace renderer
@@ -0,0 +1,120 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <cstddef>
+
+// Forward declarations.
+namespace renderer  { class Entity; }
+namespace renderer  { class Scene; }
+
+namespace renderer
+{
+
+//
+// A journal of the edits made to a scene while it is being rendered.
+//
+// Client applications record their edits into the journal of the project before
+// asking the renderer to reinitialize rendering (IRendererController::ReinitializeRendering).
+// If all the recorded edits can be applied in place, the master renderer only refreshes
+// the affected parts of the scene instead of fully reinitializing rendering. Requests to
+// reinitialize rendering with an empty journal always lead to a full reinitialization.
+//
+// Entities referenced by the journal must remain alive until rendering is reinitialized.
+// Removing or replacing an entity must be recorded as a structure edit.
+//
+// All methods are thread-safe.
+//
+
+class APPLESEED_DLLSYMBOL SceneEditJournal
+  : public foundation::NonCopyable
+{
+  public:
+    enum EditType
+    {
+        TransformEdit,          // the transform of a camera, assembly instance or object instance changed
+        MaterialBindingEdit,    // the material assignments of an object instance changed
+        GeometryEdit,           // the geometry of an object changed, but not its material slots
+        StructureEdit           // any other edit: entities were created, removed, replaced, etc.
+    };
+
+    // Constructor.
+    SceneEditJournal();
+
+    // Destructor.
+    ~SceneEditJournal();
+
+    // Record an edit of a given entity.
+    void record(Entity& entity, const EditType type);
+
+    // Record an edit that cannot be applied in place.
+    void record_structure_edit();
+
+    // Return true if no edit was recorded since the journal was last cleared.
+    bool empty() const;
+
+    // Return true if a structure edit was recorded since the journal was last cleared.
+    bool has_structure_edits() const;
+
+    // Return the number of edits recorded since the journal was last cleared.
+    size_t size() const;
+
+    // Retrieve a given recorded edit.
+    void get_edit(const size_t index, Entity*& entity, EditType& type) const;
+
+    // Discard all recorded edits.
+    void clear();
+
+  private:
+    struct Impl;
+    Impl* impl;
+};
+
+
+//
+// Apply in place the edits recorded in a scene edit journal to a scene whose render data
+// are up-to-date, and bump the version of the assemblies whose child trees must be rebuilt.
+// emitters_moved is set to true if light samplers must be updated. Return false if rendering
+// must be fully reinitialized instead, in which case no assembly version is bumped.
+// The journal is left untouched.
+//
+
+bool apply_scene_edits_in_place(
+    const SceneEditJournal&     journal,
+    const Scene&                scene,
+    bool&                       emitters_moved);
+
+}   // namespace renderer
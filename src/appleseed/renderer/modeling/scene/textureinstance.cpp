@@ -103,10 +103,12 @@ TextureInstance::TextureInstance(
 
     // Retrieve the texture filtering mode.
     const std::string filtering_mode =
-        m_params.get_optional<std::string>("filtering_mode", "bilinear", make_vector("nearest", "bilinear"), context);
+        m_params.get_optional<std::string>("filtering_mode", "bilinear", make_vector("nearest", "bilinear", "trilinear"), context);
     if (filtering_mode == "nearest")
         m_filtering_mode = TextureFilteringNearest;
-    else m_filtering_mode = TextureFilteringBilinear;
+    else if (filtering_mode == "bilinear")
+        m_filtering_mode = TextureFilteringBilinear;
+    else m_filtering_mode = TextureFilteringTrilinear;
 
     // Retrieve the texture alpha mode.
     const std::string alpha_mode =
@@ -270,7 +272,8 @@ DictionaryArray TextureInstanceFactory::get_input_metadata()
             .insert("items",
                 Dictionary()
                     .insert("Nearest", "nearest")
-                    .insert("Bilinear", "bilinear"))
+                    .insert("Bilinear", "bilinear")
+                    .insert("Trilinear (Mipmapped)", "trilinear"))
             .insert("use", "optional")
             .insert("default", "bilinear"));
 
@@ -116,7 +116,9 @@ namespace
             InputValues values;
             m_inputs.evaluate(
                 shading_context.get_texture_cache(),
-                SourceInputs(shading_point.get_uv(0)),
+                SourceInputs(
+                    shading_point.get_uv(0),
+                    shading_point),
                 &values);
 
             // Initialize the shading result.
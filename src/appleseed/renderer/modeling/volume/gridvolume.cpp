@@ -0,0 +1,741 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2019 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+// Interface header.
+#include "gridvolume.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/shading/shadingray.h"
+#include "renderer/kernel/volume/majorantgrid.h"
+#include "renderer/kernel/volume/volume.h"
+#include "renderer/modeling/input/inputarray.h"
+#include "renderer/modeling/project/project.h"
+#include "renderer/modeling/volume/volume.h"
+#include "renderer/utility/messagecontext.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+#include "foundation/math/fp.h"
+#include "foundation/math/phasefunction.h"
+#include "foundation/math/sampling/mappings.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/api/specializedapiarrays.h"
+#include "foundation/utility/containers/dictionary.h"
+#include "foundation/utility/iostreamop.h"
+#include "foundation/utility/makevector.h"
+#include "foundation/utility/searchpaths.h"
+#include "foundation/utility/string.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <string>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+namespace
+{
+    const char* Model = "grid_volume";
+}
+
+//
+// Grid volume.
+//
+// Collisions are sampled with delta tracking and transmission is estimated with
+// ratio tracking, both against the per-brick majorants of the density grid so
+// that empty space is skipped. Probabilities are derived from average spectral
+// coefficients and corrected with spectral weights, so chromatic media remain
+// unbiased.
+//
+// Reference:
+//
+//   Spectral and Decomposition Tracking for Rendering Heterogeneous Volumes
+//   Peter Kutz, Ralf Habel, Yining Karl Li, Jan Novak
+//   ACM Transactions on Graphics, Vol. 36, No. 4, 2017.
+//
+
+class GridVolume
+  : public Volume
+{
+  public:
+    GridVolume(
+        const char*         name,
+        const ParamArray&   params)
+      : Volume(name, params)
+      , m_density_multiplier(1.0f)
+    {
+        m_inputs.declare("absorption", InputFormatSpectralReflectance);
+        m_inputs.declare("absorption_multiplier", InputFormatFloat, "1.0");
+        m_inputs.declare("scattering", InputFormatSpectralReflectance);
+        m_inputs.declare("scattering_multiplier", InputFormatFloat, "1.0");
+        m_inputs.declare("average_cosine", InputFormatFloat, "0.0");
+    }
+
+    void release() override
+    {
+        delete this;
+    }
+
+    const char* get_model() const override
+    {
+        return Model;
+    }
+
+    bool on_frame_begin(
+        const Project&          project,
+        const BaseGroup*        parent,
+        OnFrameBeginRecorder&   recorder,
+        IAbortSwitch*           abort_switch) override
+    {
+        if (!Volume::on_frame_begin(project, parent, recorder, abort_switch))
+            return false;
+
+        const OnFrameBeginMessageContext context("volume", this);
+
+        const std::string phase_function =
+            m_params.get_required<std::string>(
+                "phase_function_model",
+                "isotropic",
+                make_vector("isotropic", "henyey"),
+                context);
+
+        if (phase_function == "isotropic")
+            m_phase_function.reset(new IsotropicPhaseFunction());
+        else if (phase_function == "henyey")
+        {
+            const float g =
+                clamp(
+                    m_params.get_optional<float>("average_cosine", 0.0f),
+                    -0.99f, +0.99f);
+            m_phase_function.reset(new HenyeyPhaseFunction(g));
+        }
+        else return false;
+
+        // Load the density grid, unless it was already loaded by a previous frame.
+        const std::string filepath =
+            to_string(
+                project.search_paths().qualify(
+                    m_params.get_required<std::string>("filename", "", context)));
+        if (m_grid == nullptr || filepath != m_grid_filepath)
+        {
+            m_grid = read_fluid_file_density(filepath.c_str());
+            if (m_grid == nullptr)
+            {
+                RENDERER_LOG_ERROR(
+                    "%sfailed to read densities from fluid file \"%s\".",
+                    context.get(),
+                    filepath.c_str());
+                m_majorants.reset();
+                return false;
+            }
+
+            m_majorants.reset(new MajorantGrid(*m_grid, 0));
+            m_grid_filepath = filepath;
+
+            RENDERER_LOG_INFO(
+                "%sloaded " FMT_SIZE_T "x" FMT_SIZE_T "x" FMT_SIZE_T " density grid from \"%s\" "
+                "(%s bricks allocated out of %s, %s).",
+                context.get(),
+                m_grid->get_xres(),
+                m_grid->get_yres(),
+                m_grid->get_zres(),
+                filepath.c_str(),
+                pretty_uint(m_grid->get_allocated_brick_count()).c_str(),
+                pretty_uint(
+                    m_grid->get_brick_xres() *
+                    m_grid->get_brick_yres() *
+                    m_grid->get_brick_zres()).c_str(),
+                pretty_size(m_grid->get_memory_size()).c_str());
+        }
+
+        m_density_multiplier = m_params.get_optional<float>("density_multiplier", 1.0f, context);
+
+        // Compute the mapping from world space to the unit cube of the grid.
+        m_bbox.min = m_params.get_optional<Vector3d>("bbox_min", Vector3d(-1.0), context);
+        m_bbox.max = m_params.get_optional<Vector3d>("bbox_max", Vector3d(+1.0), context);
+        if (m_bbox.rank() < 3)
+        {
+            RENDERER_LOG_ERROR("%sthe bounding box of the density grid is empty.", context.get());
+            return false;
+        }
+        m_rcp_extent = Vector3d(1.0) / m_bbox.extent();
+        m_voxel_res =
+            Vector3d(
+                static_cast<double>(m_grid->get_xres() - 1),
+                static_cast<double>(m_grid->get_yres() - 1),
+                static_cast<double>(m_grid->get_zres() - 1));
+
+        return true;
+    }
+
+    bool is_homogeneous() const override
+    {
+        return false;
+    }
+
+    size_t compute_input_data_size() const override
+    {
+        return sizeof(InputValues);
+    }
+
+    void prepare_inputs(
+        Arena&              arena,
+        const ShadingRay&   volume_ray,
+        void*               data) const override
+    {
+        InputValues* values = static_cast<InputValues*>(data);
+
+        values->m_absorption *= values->m_absorption_multiplier;
+        values->m_scattering *= values->m_scattering_multiplier;
+
+        // Precompute extinction and its majorant.
+        values->m_precomputed.m_extinction = values->m_absorption + values->m_scattering;
+        values->m_precomputed.m_majorant_scale =
+            m_density_multiplier * max_value(values->m_precomputed.m_extinction);
+
+        // Precompute coefficients at the ray origin.
+        const float density = lookup_density(volume_ray.m_org);
+        values->m_precomputed.m_origin_absorption = values->m_absorption;
+        values->m_precomputed.m_origin_absorption *= density;
+        values->m_precomputed.m_origin_scattering = values->m_scattering;
+        values->m_precomputed.m_origin_scattering *= density;
+        values->m_precomputed.m_origin_extinction = values->m_precomputed.m_extinction;
+        values->m_precomputed.m_origin_extinction *= density;
+    }
+
+    float sample(
+        SamplingContext&    sampling_context,
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        const float         distance,
+        Vector3f&           incoming) const override
+    {
+        sampling_context.split_in_place(2, 1);
+        const Vector2f s = sampling_context.next2<Vector2f>();
+
+        const Vector3f outgoing(normalize(volume_ray.m_dir));
+        return m_phase_function->sample(outgoing, s, incoming);
+    }
+
+    float evaluate(
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        const float         distance,
+        const Vector3f&     incoming) const override
+    {
+        const Vector3f outgoing = Vector3f(normalize(volume_ray.m_dir));
+        return m_phase_function->evaluate(outgoing, incoming);
+    }
+
+    void evaluate_transmission(
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        const float         distance,
+        Spectrum&           spectrum) const override
+    {
+        const InputValues* values = static_cast<const InputValues*>(data);
+
+        // Integrate density along the ray, skipping empty cells.
+        OpticalDepthIntegrator integrator(*this, volume_ray);
+        traverse(volume_ray, static_cast<double>(distance), integrator);
+
+        for (size_t i = 0, e = Spectrum::size(); i < e; ++i)
+        {
+            const float x = -integrator.m_optical_depth * values->m_precomputed.m_extinction[i];
+            assert(FP<float>::is_finite(x));
+            spectrum[i] = std::exp(x);
+        }
+    }
+
+    void evaluate_transmission(
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        Spectrum&           spectrum) const override
+    {
+        evaluate_transmission(data, volume_ray, static_cast<float>(volume_ray.m_tmax), spectrum);
+    }
+
+    bool sample_distance(
+        SamplingContext&    sampling_context,
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        float&              distance,
+        Spectrum&           weight) const override
+    {
+        const InputValues* values = static_cast<const InputValues*>(data);
+
+        DeltaTracker tracker(*this, *values, sampling_context, volume_ray);
+        traverse(volume_ray, volume_ray.m_tmax, tracker);
+
+        distance = static_cast<float>(tracker.m_distance);
+        weight = tracker.m_weight;
+
+        return tracker.m_collided;
+    }
+
+    void estimate_transmission(
+        SamplingContext&    sampling_context,
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        Spectrum&           spectrum) const override
+    {
+        const InputValues* values = static_cast<const InputValues*>(data);
+
+        RatioTracker tracker(*this, *values, sampling_context, volume_ray);
+        traverse(volume_ray, volume_ray.m_tmax, tracker);
+
+        spectrum = tracker.m_transmission;
+    }
+
+    void scattering_coefficient(
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        const float         distance,
+        Spectrum&           spectrum) const override
+    {
+        const InputValues* values = static_cast<const InputValues*>(data);
+        spectrum = values->m_scattering;
+        spectrum *= lookup_density(volume_ray.point_at(distance));
+    }
+
+    const Spectrum& scattering_coefficient(
+        const void*         data,
+        const ShadingRay&   volume_ray) const override
+    {
+        const InputValues* values = static_cast<const InputValues*>(data);
+        return values->m_precomputed.m_origin_scattering;
+    }
+
+    void absorption_coefficient(
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        const float         distance,
+        Spectrum&           spectrum) const override
+    {
+        const InputValues* values = static_cast<const InputValues*>(data);
+        spectrum = values->m_absorption;
+        spectrum *= lookup_density(volume_ray.point_at(distance));
+    }
+
+    const Spectrum& absorption_coefficient(
+        const void*         data,
+        const ShadingRay&   volume_ray) const override
+    {
+        const InputValues* values = static_cast<const InputValues*>(data);
+        return values->m_precomputed.m_origin_absorption;
+    }
+
+    void extinction_coefficient(
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        const float         distance,
+        Spectrum&           spectrum) const override
+    {
+        const InputValues* values = static_cast<const InputValues*>(data);
+        spectrum = values->m_precomputed.m_extinction;
+        spectrum *= lookup_density(volume_ray.point_at(distance));
+    }
+
+    const Spectrum& extinction_coefficient(
+        const void*         data,
+        const ShadingRay&   volume_ray) const override
+    {
+        const InputValues* values = static_cast<const InputValues*>(data);
+        return values->m_precomputed.m_origin_extinction;
+    }
+
+  private:
+    typedef GridVolumeInputValues InputValues;
+
+    std::unique_ptr<PhaseFunction>      m_phase_function;
+    std::unique_ptr<SparseVoxelGrid>    m_grid;
+    std::unique_ptr<MajorantGrid>       m_majorants;
+    std::string                         m_grid_filepath;
+    float                               m_density_multiplier;
+    AABB3d                              m_bbox;
+    Vector3d                            m_rcp_extent;
+    Vector3d                            m_voxel_res;
+
+    // Return the density at a given point in world space.
+    float lookup_density(const Vector3d& point) const
+    {
+        const Vector3d p = (point - m_bbox.min) * m_rcp_extent;
+
+        if (p.x < 0.0 || p.y < 0.0 || p.z < 0.0 ||
+            p.x > 1.0 || p.y > 1.0 || p.z > 1.0)
+            return 0.0f;
+
+        float density;
+        m_grid->linear_lookup(p, &density);
+
+        return density * m_density_multiplier;
+    }
+
+    // Walk the cells of the majorant grid pierced by a ray, up to a given distance.
+    template <typename Visitor>
+    void traverse(
+        const ShadingRay&   volume_ray,
+        const double        tmax,
+        Visitor&            visitor) const
+    {
+        m_majorants->traverse(
+            (volume_ray.m_org - m_bbox.min) * m_rcp_extent,
+            volume_ray.m_dir * m_rcp_extent,
+            volume_ray.m_tmin,
+            tmax,
+            visitor);
+    }
+
+    // Integrate density along a ray with the midpoint rule, at half the voxel resolution.
+    struct OpticalDepthIntegrator
+    {
+        const GridVolume&   m_volume;
+        const ShadingRay&   m_ray;
+        double              m_step;
+        float               m_optical_depth;
+
+        OpticalDepthIntegrator(
+            const GridVolume&   volume,
+            const ShadingRay&   ray)
+          : m_volume(volume)
+          , m_ray(ray)
+          , m_optical_depth(0.0f)
+        {
+            const Vector3d voxel_speed = ray.m_dir * volume.m_rcp_extent * volume.m_voxel_res;
+            const double max_voxel_speed = std::abs(voxel_speed[max_abs_index(voxel_speed)]);
+            m_step = max_voxel_speed > 0.0 ? 0.5 / max_voxel_speed : std::numeric_limits<double>::max();
+        }
+
+        bool operator()(const double t0, const double t1, const float majorant)
+        {
+            if (majorant > 0.0f)
+            {
+                const size_t step_count =
+                    std::max<size_t>(truncate<size_t>(std::ceil((t1 - t0) / m_step)), 1);
+                const double dt = (t1 - t0) / step_count;
+
+                float density_sum = 0.0f;
+                for (size_t i = 0; i < step_count; ++i)
+                    density_sum += m_volume.lookup_density(m_ray.point_at(t0 + (i + 0.5) * dt));
+
+                m_optical_depth += density_sum * static_cast<float>(dt);
+            }
+
+            return true;
+        }
+    };
+
+    // Sample the first collision along a ray with spectral delta tracking.
+    struct DeltaTracker
+    {
+        const GridVolume&   m_volume;
+        const InputValues&  m_values;
+        SamplingContext&    m_sampling_context;
+        const ShadingRay&   m_ray;
+        Spectrum            m_weight;
+        double              m_distance;
+        bool                m_collided;
+
+        DeltaTracker(
+            const GridVolume&   volume,
+            const InputValues&  values,
+            SamplingContext&    sampling_context,
+            const ShadingRay&   ray)
+          : m_volume(volume)
+          , m_values(values)
+          , m_sampling_context(sampling_context)
+          , m_ray(ray)
+          , m_weight(1.0f)
+          , m_distance(0.0)
+          , m_collided(false)
+        {
+        }
+
+        bool operator()(const double t0, const double t1, const float majorant)
+        {
+            const float extinction_majorant = majorant * m_values.m_precomputed.m_majorant_scale;
+            if (extinction_majorant <= 0.0f)
+                return true;
+
+            double t = t0;
+            while (true)
+            {
+                m_sampling_context.split_in_place(2, 1);
+                const Vector2f s = m_sampling_context.next2<Vector2f>();
+
+                // Sample a tentative collision.
+                t += sample_exponential_distribution(s[0], extinction_majorant);
+                if (t >= t1)
+                    return true;
+
+                Spectrum extinction = m_values.m_precomputed.m_extinction;
+                extinction *= m_volume.lookup_density(m_ray.point_at(t));
+                const float average_extinction = average_value(extinction);
+
+                // Real collision.
+                if (s[1] * extinction_majorant < average_extinction)
+                {
+                    m_weight /= average_extinction;
+                    m_distance = t;
+                    m_collided = true;
+                    return false;
+                }
+
+                // Null collision.
+                Spectrum null_extinction(extinction_majorant);
+                null_extinction -= extinction;
+                m_weight *= null_extinction;
+                m_weight /= extinction_majorant - average_extinction;
+            }
+        }
+    };
+
+    // Estimate the transmission along a ray with ratio tracking.
+    struct RatioTracker
+    {
+        const GridVolume&   m_volume;
+        const InputValues&  m_values;
+        SamplingContext&    m_sampling_context;
+        const ShadingRay&   m_ray;
+        Spectrum            m_transmission;
+
+        RatioTracker(
+            const GridVolume&   volume,
+            const InputValues&  values,
+            SamplingContext&    sampling_context,
+            const ShadingRay&   ray)
+          : m_volume(volume)
+          , m_values(values)
+          , m_sampling_context(sampling_context)
+          , m_ray(ray)
+          , m_transmission(1.0f)
+        {
+        }
+
+        bool operator()(const double t0, const double t1, const float majorant)
+        {
+            const float extinction_majorant = majorant * m_values.m_precomputed.m_majorant_scale;
+            if (extinction_majorant <= 0.0f)
+                return true;
+
+            double t = t0;
+            while (true)
+            {
+                m_sampling_context.split_in_place(1, 1);
+                t += sample_exponential_distribution(m_sampling_context.next2<float>(), extinction_majorant);
+                if (t >= t1)
+                    return true;
+
+                Spectrum null_extinction = m_values.m_precomputed.m_extinction;
+                null_extinction *= -m_volume.lookup_density(m_ray.point_at(t));
+                null_extinction += Spectrum(extinction_majorant);
+                null_extinction /= extinction_majorant;
+                m_transmission *= null_extinction;
+
+                // Stop as soon as the ray is fully occluded.
+                if (is_zero(m_transmission))
+                    return false;
+            }
+        }
+    };
+};
+
+
+//
+// GridVolumeFactory class implementation.
+//
+
+void GridVolumeFactory::release()
+{
+    delete this;
+}
+
+const char* GridVolumeFactory::get_model() const
+{
+    return Model;
+}
+
+Dictionary GridVolumeFactory::get_model_metadata() const
+{
+    return
+        Dictionary()
+            .insert("name", Model)
+            .insert("label", "Grid Volume");
+}
+
+DictionaryArray GridVolumeFactory::get_input_metadata() const
+{
+    DictionaryArray metadata;
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "filename")
+            .insert("label", "Fluid File")
+            .insert("type", "file")
+            .insert("file_picker_mode", "open")
+            .insert("file_picker_type", "fluid")
+            .insert("use", "required"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "bbox_min")
+            .insert("label", "Bounding Box Minimum")
+            .insert("type", "text")
+            .insert("use", "optional")
+            .insert("default", "-1.0 -1.0 -1.0"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "bbox_max")
+            .insert("label", "Bounding Box Maximum")
+            .insert("type", "text")
+            .insert("use", "optional")
+            .insert("default", "1.0 1.0 1.0"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "density_multiplier")
+            .insert("label", "Density Multiplier")
+            .insert("type", "numeric")
+            .insert("min",
+                Dictionary()
+                    .insert("value", "0.0")
+                    .insert("type", "hard"))
+            .insert("max",
+                Dictionary()
+                    .insert("value", "10.0")
+                    .insert("type", "soft"))
+            .insert("use", "optional")
+            .insert("default", "1.0"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "absorption")
+            .insert("label", "Absorption Coefficient")
+            .insert("type", "colormap")
+            .insert("entity_types",
+                Dictionary().insert("color", "Colors"))
+            .insert("use", "required")
+            .insert("default", "0.5"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "absorption_multiplier")
+            .insert("label", "Absorption Coefficient Multiplier")
+            .insert("type", "numeric")
+            .insert("min",
+                Dictionary()
+                    .insert("value", "0.0")
+                    .insert("type", "hard"))
+            .insert("max",
+                Dictionary()
+                    .insert("value", "200.0")
+                    .insert("type", "soft"))
+            .insert("use", "optional")
+            .insert("default", "1.0"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "scattering")
+            .insert("label", "Scattering Coefficient")
+            .insert("type", "colormap")
+            .insert("entity_types",
+                Dictionary().insert("color", "Colors"))
+            .insert("use", "required")
+            .insert("default", "0.5"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "scattering_multiplier")
+            .insert("label", "Scattering Coefficient Multiplier")
+            .insert("type", "numeric")
+            .insert("min",
+                Dictionary()
+                    .insert("value", "0.0")
+                    .insert("type", "hard"))
+            .insert("max",
+                Dictionary()
+                    .insert("value", "200.0")
+                    .insert("type", "soft"))
+            .insert("use", "optional")
+            .insert("default", "1.0"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "phase_function_model")
+            .insert("label", "Phase Function Model")
+            .insert("type", "enumeration")
+            .insert("items",
+                Dictionary()
+                    .insert("Isotropic", "isotropic")
+                    .insert("Henyey-Greenstein", "henyey"))
+            .insert("use", "required")
+            .insert("default", "isotropic")
+            .insert("on_change", "rebuild_form"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "average_cosine")
+            .insert("label", "Average Cosine (g)")
+            .insert("type", "numeric")
+            .insert("min",
+                Dictionary()
+                    .insert("value", "-1.0")
+                    .insert("type", "soft"))
+            .insert("max",
+                Dictionary()
+                    .insert("value", "1.0")
+                    .insert("type", "soft"))
+            .insert("use", "optional")
+            .insert("default", "0.0")
+            .insert("visible_if",
+                Dictionary().insert("phase_function_model", "henyey")));
+
+    return metadata;
+}
+
+auto_release_ptr<Volume> GridVolumeFactory::create(
+    const char*         name,
+    const ParamArray&   params) const
+{
+    return auto_release_ptr<Volume>(new GridVolume(name, params));
+}
+
+}   // namespace renderer
@@ -35,8 +35,13 @@
 #include "renderer/modeling/input/inputarray.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/sampling/mappings.h"
+#include "foundation/math/scalar.h"
 #include "foundation/utility/arena.h"
 
+// Standard headers.
+#include <cmath>
+
 using namespace foundation;
 
 namespace renderer
@@ -87,4 +92,44 @@ void Volume::prepare_inputs(
 {
 }
 
+bool Volume::sample_distance(
+    SamplingContext&        sampling_context,
+    const void*             data,
+    const ShadingRay&       volume_ray,
+    float&                  distance,
+    Spectrum&               weight) const
+{
+    // Sample the exponential distribution of the average extinction.
+    const float extinction = average_value(extinction_coefficient(data, volume_ray));
+    if (extinction <= 0.0f)
+    {
+        evaluate_transmission(data, volume_ray, weight);
+        return false;
+    }
+
+    sampling_context.split_in_place(1, 1);
+    distance = sample_exponential_distribution(sampling_context.next2<float>(), extinction);
+
+    if (volume_ray.is_finite() && distance >= volume_ray.m_tmax)
+    {
+        const float ray_length = static_cast<float>(volume_ray.m_tmax);
+        evaluate_transmission(data, volume_ray, weight);
+        weight /= std::exp(-extinction * ray_length);
+        return false;
+    }
+
+    evaluate_transmission(data, volume_ray, distance, weight);
+    weight /= exponential_distribution_pdf(distance, extinction);
+    return true;
+}
+
+void Volume::estimate_transmission(
+    SamplingContext&        sampling_context,
+    const void*             data,
+    const ShadingRay&       volume_ray,
+    Spectrum&               spectrum) const
+{
+    evaluate_transmission(data, volume_ray, spectrum);
+}
+
 }   // namespace renderer
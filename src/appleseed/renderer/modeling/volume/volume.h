@@ -117,6 +117,27 @@ class APPLESEED_DLLSYMBOL Volume
         const ShadingRay&           volume_ray,                 // ray used for marching inside the volume
         Spectrum&                   spectrum) const = 0;        // resulting spectrum
 
+    // Sample the distance to the next collision along the ray, proportionally to
+    // the product of transmission and extinction, using delta tracking. Return true
+    // if a collision occurs within the ray, in which case 'weight' is the transmission
+    // to the collision divided by the probability density of the sample. Otherwise,
+    // 'weight' is the transmission of the entire ray divided by the probability of
+    // not colliding. The default implementation samples a homogeneous medium.
+    virtual bool sample_distance(
+        SamplingContext&            sampling_context,
+        const void*                 data,                       // input values
+        const ShadingRay&           volume_ray,                 // ray used for marching inside the volume
+        float&                      distance,                   // distance to the collision
+        Spectrum&                   weight) const;              // throughput weight of the sample
+
+    // Compute an unbiased estimate of the transmission (spectrum) of the entire ray.
+    // The default implementation returns the exact transmission.
+    virtual void estimate_transmission(
+        SamplingContext&            sampling_context,
+        const void*                 data,                       // input values
+        const ShadingRay&           volume_ray,                 // ray used for marching inside the volume
+        Spectrum&                   spectrum) const;            // resulting spectrum
+
     // Get the scattering coefficient (spectrum) at a given point.
     virtual void scattering_coefficient(
         const void*                 data,                       // input values